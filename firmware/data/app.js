@@ -8,12 +8,31 @@
   // Constants
   // ---------------------------------------------------------------------------
   var WS_MAX_BACKOFF = 30000;
+  var HIDDEN_DATA_INTERVAL = 10000; // Data cadence to ask for while the tab is hidden
   var DEBOUNCE_MS = 300;
   var CHART_WINDOW_SEC = 2 * 60 * 60; // 2 hours visible window
+  var CHART_KEEP_SEC = 4 * 60 * 60;   // Points kept (extra buffer beyond the visible window)
+  var CHART_TRIM_SLACK_SEC = 10 * 60; // Old points are dropped in batches this big
+  var CHART_STORE_MIN = 2048;         // Initial store capacity; doubles when full
+  var CHART_COLS = 9; // [timestamps, pit, meat1, meat2, fan, damper, setpoint, meat1Target, meat2Target]
   var PREDICTION_WINDOW_SEC = 30 * 60; // 30 min of history for regression
   var MIN_PREDICTION_POINTS = 10; // ~5 min at 30s interval
   var GITHUB_REPO = 'MrMatt57/pitclaw';
   var OTA_CHUNK_SIZE = 4096;
+  var OTA_RETRY_MS = 2000;        // Wait after a failed chunk before resuming at the unit's offset
+  var OTA_MAX_RETRIES = 20;       // Consecutive failures before the upload is given up
+  var OTA_POLL_MS = 500;          // Status poll while the unit finishes writing
+  var CAL_POLL_MS = 2000;         // Calibration status poll while a run is open
+  var HUB_POLL_MS = 5000;         // Merged unit state (hub mode)
+  var HUB_HISTORY_MS = 60000;     // Peer trends; the hub keeps a point a minute
+  var HUB_HISTORY_POINTS = 180;
+  var HISTORY_DB = 'pitclaw';     // IndexedDB copy of the chart, for resuming after a reload
+  var HISTORY_CACHE_MS = 60000;   // How often live points are written to it
+  var LATENCY_PING_MS = 10000;    // Clock sync with the device, carrying latency reports
+  var LATENCY_SYNC_KEEP = 6;      // Pings the fastest round trip is picked from
+  var LATENCY_REPORT_MAX = 16;    // Latencies per ping (PING_LATENCY_MAX on the device)
+  var LATENCY_WINDOW = 60;        // Latencies behind the Settings readout
+  var LATENCY_HELD_MS = 1000;     // A frame held back longer than this (hidden tab) isn't measured
 
   // ---------------------------------------------------------------------------
   // State
@@ -22,9 +41,24 @@
   var wsBackoff = 1000;
   var reconnectTimer = null;
   var connected = false;
+  var decoder = null;       // main-thread PitClawDecoder (decoder.js), if the worker is unavailable
+  var decoderWorker = null; // the same decoder in a Web Worker
 
   var chart = null;
-  var chartData = [[], [], [], [], [], [], [], [], []]; // [timestamps, pit, meat1, meat2, fan, damper, setpoint, meat1Target, meat2Target]
+  var store = storeCreate(CHART_STORE_MIN); // chart history
+  var chartView = [[], [], [], [], [], [], [], [], []]; // what uPlot draws: store decimated to the chart width
+  var viewStart = 0;     // store.base when chartView was last rebuilt
+  var viewEnd = 0;       // store.base + store.len already in chartView
+  var viewStale = true;  // chartView must be rebuilt from the whole store
+  var drawPending = false;
+
+  var historySession = null; // session (device start time) the chart holds
+  var historySeq = null;     // device point count the chart is complete up to
+  var resumeFrom = null;     // newest chart ts when the hello asked for a tail
+  var historyLoading = false;  // between chunk 0 and the final chunk
+  var historyResuming = false; // ...of a tail, which live frames wait for
+  var historyDb = null;
+  var historySavedMs = 0;
   var predictionData = { meat1: null, meat2: null }; // { times: [], temps: [] } for each
 
   var pitSetpoint = 225;   // always stored in °F
@@ -34,6 +68,7 @@
   var currentUnits = 'F';        // 'F' or 'C' — display only
   var currentTimeFormat = '12h'; // '12h' or '24h'
   var currentFanMode = 'fan_and_damper'; // 'fan_only', 'fan_and_damper', 'damper_primary'
+  var autoTuning = false;                 // Device is running a PID auto-tune
   var currentTheme = 'dark'; // 'dark' or 'light' — synced from firmware
 
   var cookTimerStart = null;  // server timestamp (seconds) when cook started
@@ -48,6 +83,14 @@
   var notifyMeat2Fired = false;  // true once meat2 target notification sent
   var audioCtx = null;           // Web Audio API context (created on user gesture)
 
+  var hubHistory = {};           // Peer id -> [[ts, pit, meat1, meat2, fan], ...]
+  var hubHistoryMs = 0;
+
+  var clockSyncs = [];           // Recent pings: { rtt, offset } (offset: device µs minus ours, mod 2^32)
+  var clockOffsetUs = null;      // From the fastest of them; null until the first pong
+  var latencyPending = [];       // Sample-to-paint ms not yet reported
+  var latencyRecent = [];        // The last LATENCY_WINDOW of them, for the readout
+
   var firmwareVersion = null;    // current firmware version string
   var latestRelease = null;      // cached GitHub release JSON
 
@@ -72,6 +115,7 @@
     dom.meat2Target = document.getElementById('meat2Target');
     dom.meat1Prediction = document.getElementById('meat1Prediction');
     dom.meat2Prediction = document.getElementById('meat2Prediction');
+    dom.tempCards = document.getElementById('tempCards');
     dom.fanBar = document.getElementById('fanBar');
     dom.damperBar = document.getElementById('damperBar');
     dom.fanBarRow = document.getElementById('fanBarRow');
@@ -96,6 +140,13 @@
     dom.meat2TargetUp = document.getElementById('meat2TargetUp');
     dom.btnNewSession = document.getElementById('btnNewSession');
     dom.btnDownloadCSV = document.getElementById('btnDownloadCSV');
+    dom.btnAutoTune = document.getElementById('btnAutoTune');
+    dom.calProbeButtons = document.querySelectorAll('#calProbeButtons .btn');
+    dom.calRefInput = document.getElementById('calRefInput');
+    dom.btnCalStart = document.getElementById('btnCalStart');
+    dom.btnCalCapture = document.getElementById('btnCalCapture');
+    dom.btnCalApply = document.getElementById('btnCalApply');
+    dom.calStatus = document.getElementById('calStatus');
     dom.btnToggleUnits = document.getElementById('btnToggleUnits');
     dom.btnToggleTime = document.getElementById('btnToggleTime');
     dom.btnToggleTheme = document.getElementById('btnToggleTheme');
@@ -112,6 +163,7 @@
     dom.meat2Card = document.querySelector('.meat2-card');
     dom.fwVersion = document.getElementById('fwVersion');
     dom.settingsVersion = document.getElementById('settingsVersion');
+    dom.settingsLatency = document.getElementById('settingsLatency');
     dom.updateBanner = document.getElementById('updateBanner');
     dom.updateMessage = document.getElementById('updateMessage');
     dom.btnUpdate = document.getElementById('btnUpdate');
@@ -120,6 +172,7 @@
     dom.updateProgress = document.getElementById('updateProgress');
     dom.updateStatus = document.getElementById('updateStatus');
     dom.btnCheckUpdate = document.getElementById('btnCheckUpdate');
+    dom.hubUnits = document.getElementById('hubUnits');
   }
 
   // ---------------------------------------------------------------------------
@@ -253,6 +306,7 @@
 
     try {
       ws = new WebSocket(url);
+      ws.binaryType = 'arraybuffer';
     } catch (e) {
       console.error('WebSocket creation failed:', e);
       scheduleReconnect();
@@ -264,12 +318,36 @@
       connected = true;
       wsBackoff = 1000;
       updateConnectionStatus(true);
+      resetDecoder();
+      // Opt in to compact binary data frames; servers that don't support
+      // them simply keep sending JSON. `points` is the chart width, so the
+      // device can replay long cooks at a matching level of detail.
+      var hello = { type: 'hello', binary: true };
+      var chartWidth = dom.chartContainer ? dom.chartContainer.clientWidth : 0;
+      if (chartWidth > 0) hello.points = chartWidth;
+      // Holding this session already: only the points since are needed
+      resumeFrom = null;
+      if (historySession !== null && historySeq !== null && store.len) {
+        hello.session = historySession;
+        hello.since = historySeq;
+        resumeFrom = storeLast(0);
+      }
+      wsSend(hello);
+      if (document.hidden) sendDataRate();
+      // A reconnect may be to a rebooted device with a new clock
+      clockSyncs = [];
+      clockOffsetUs = null;
+      sendPing();
     };
 
     ws.onmessage = function (evt) {
+      if (decoderWorker) {
+        decoderWorker.postMessage(evt.data, evt.data instanceof ArrayBuffer ? [evt.data] : []);
+        return;
+      }
       try {
-        var msg = JSON.parse(evt.data);
-        handleMessage(msg);
+        var msg = decoder.decode(evt.data);
+        if (msg) handleMessage(msg);
       } catch (e) {
         console.warn('Failed to parse WS message:', e);
       }
@@ -288,6 +366,34 @@
     };
   }
 
+  // Every WebSocket message goes through decoder.js, in a worker when the
+  // browser has them, so a long history replay or a burst of binary frames
+  // doesn't stall the UI thread. The worker is loaded from the same
+  // (versioned) URL as the page's script tag, so it comes from cache.
+  function initDecoder() {
+    decoder = PitClawDecoder.create();
+    var script = document.querySelector('script[src^="/decoder.js"]');
+    if (typeof Worker === 'undefined' || !script) return;
+    try {
+      decoderWorker = new Worker(script.src);
+    } catch (e) {
+      console.warn('Decoder worker unavailable:', e);
+      return;
+    }
+    decoderWorker.onmessage = function (evt) { handleMessage(evt.data); };
+    decoderWorker.onerror = function (err) {
+      console.warn('Decoder worker failed, decoding on the main thread:', err);
+      decoderWorker.terminate();
+      decoderWorker = null;
+      decoder.reset();
+    };
+  }
+
+  function resetDecoder() {
+    if (decoderWorker) decoderWorker.postMessage('reset');
+    decoder.reset();
+  }
+
   function scheduleReconnect() {
     if (reconnectTimer) return;
     console.log('Reconnecting in ' + wsBackoff + 'ms...');
@@ -304,6 +410,11 @@
     }
   }
 
+  // Background tabs don't need 1.5 s updates; 0 restores the device default
+  function sendDataRate() {
+    wsSend({ type: 'rate', interval: document.hidden ? HIDDEN_DATA_INTERVAL : 0 });
+  }
+
   function updateConnectionStatus(isConnected) {
     if (isConnected) {
       dom.wifiIcon.classList.add('connected');
@@ -317,6 +428,12 @@
   // ---------------------------------------------------------------------------
   // Fan Mode
   // ---------------------------------------------------------------------------
+  function applyAutoTune(tuning) {
+    autoTuning = tuning;
+    dom.btnAutoTune.textContent = tuning ? 'Cancel Auto-Tune' : 'Auto-Tune PID';
+    dom.btnAutoTune.classList.toggle('active', tuning);
+  }
+
   function applyFanMode(mode) {
     currentFanMode = mode;
 
@@ -361,12 +478,19 @@
       if (msg.fanMode && msg.fanMode !== currentFanMode) {
         applyFanMode(msg.fanMode);
       }
+      if (!!msg.tuning !== autoTuning) {
+        applyAutoTune(!!msg.tuning);
+      }
+      if (msg.seq !== undefined && !historyLoading) historySeq = msg.seq;
       updateTemperatures(msg);
       updateOutputs(msg);
-      appendChartData(msg);
+      if (!historyResuming) appendChartData(msg);
       updateCookTimer(msg);
       updatePredictions();
       checkTargetNotifications(msg);
+      if (msg.sampleUs) traceLatency(msg.sampleUs);
+    } else if (msg.type === 'pong') {
+      handlePong(msg);
     } else if (msg.type === 'history') {
       loadHistory(msg);
     } else if (msg.type === 'session' && msg.action === 'reset') {
@@ -376,6 +500,64 @@
     }
   }
 
+  // ---------------------------------------------------------------------------
+  // Latency Tracing
+  // ---------------------------------------------------------------------------
+  // Data frames carry sampleUs, the device clock when the pit reading was
+  // taken at the ADC. A ping every LATENCY_PING_MS maps that clock onto
+  // ours: the reply is taken as sent half way through the round trip, and
+  // the fastest recent round trip wins, so the estimate is good to half of
+  // it. A frame's latency is its reading's age at the animation frame that
+  // draws it. Each ping reports the latencies since the last one, for the
+  // device's pitclaw_sample_to_paint_seconds histogram (/metrics).
+  function u32(x) {
+    x %= 4294967296;
+    return x < 0 ? x + 4294967296 : x;
+  }
+
+  function sendPing() {
+    var msg = { type: 'ping', t: Math.round(performance.now()) };
+    if (latencyPending.length) msg.lat = latencyPending.splice(0, LATENCY_REPORT_MAX);
+    wsSend(msg);
+  }
+
+  function handlePong(msg) {
+    var rtt = performance.now() - msg.t;
+    if (!(rtt >= 0) || typeof msg.us !== 'number') return;
+    clockSyncs.push({ rtt: rtt, offset: u32(msg.us - Math.round((msg.t + rtt / 2) * 1000)) });
+    if (clockSyncs.length > LATENCY_SYNC_KEEP) clockSyncs.shift();
+    var best = clockSyncs[0];
+    for (var i = 1; i < clockSyncs.length; i++) {
+      if (clockSyncs[i].rtt < best.rtt) best = clockSyncs[i];
+    }
+    clockOffsetUs = best.offset;
+  }
+
+  function traceLatency(sampleUs) {
+    if (clockOffsetUs === null || document.hidden) return;
+    var queued = performance.now();
+    requestAnimationFrame(function (paintMs) {
+      if (clockOffsetUs === null || paintMs - queued > LATENCY_HELD_MS) return;
+      var ageUs = u32(Math.round(paintMs * 1000) + clockOffsetUs - sampleUs);
+      if (ageUs >= 2147483648) return; // Negative: within the clock estimate's error
+      var ms = Math.round(ageUs / 100) / 10;
+      latencyPending.push(ms);
+      if (latencyPending.length > LATENCY_REPORT_MAX) latencyPending.shift();
+      latencyRecent.push(ms);
+      if (latencyRecent.length > LATENCY_WINDOW) latencyRecent.shift();
+      updateLatencyReadout();
+    });
+  }
+
+  // Settings -> Firmware: median and 95th percentile of the recent latencies
+  function updateLatencyReadout() {
+    if (!dom.settingsLatency) return;
+    var sorted = latencyRecent.slice().sort(function (a, b) { return a - b; });
+    var p50 = sorted[Math.floor((sorted.length - 1) * 0.5)];
+    var p95 = sorted[Math.floor((sorted.length - 1) * 0.95)];
+    dom.settingsLatency.textContent = 'Latency ' + Math.round(p50) + ' ms (p95 ' + Math.round(p95) + ')';
+  }
+
   function handleSessionReset(msg) {
     // Reset cook timer and chart state once the server confirms the reset.
     // Doing this here (instead of optimistically on button click) avoids a
@@ -386,13 +568,14 @@
     resetCookTimer();
     latestServerTs = null;
 
-    for (var i = 0; i < chartData.length; i++) {
-      chartData[i] = [];
-    }
-    if (chart) {
-      chart.setData(chartData);
-    }
+    storeClear();
+    drawChart();
     updateLegendValues(null);
+    historySession = null;
+    historySeq = null;
+    historyLoading = false;
+    historyResuming = false;
+    clearHistoryCache();
 
     // Clear stale targets
     hideMeatTarget(1);
@@ -406,7 +589,13 @@
     }
   }
 
+  // The device answers with the URL of its streamed export; older firmware
+  // sent the whole CSV inline
   function handleSessionDownload(msg) {
+    if (msg.url) {
+      downloadExport(msg.url, msg.format === 'json' ? 'cook-session.json' : 'cook-session.csv');
+      return;
+    }
     if (!msg.data) return;
     var blob = new Blob([msg.data], { type: 'text/csv' });
     var url = URL.createObjectURL(blob);
@@ -419,7 +608,56 @@
     URL.revokeObjectURL(url);
   }
 
+  function downloadExport(url, name) {
+    var a = document.createElement('a');
+    a.href = url;
+    a.download = name;
+    document.body.appendChild(a);
+    a.click();
+    document.body.removeChild(a);
+  }
+
+  // History arrives either as one message or, from the device, as a series
+  // of chunks ({chunk: n, final: bool}). Chunk 0 carries the session,
+  // setpoint and targets and resets the chart, unless it's a resume: then
+  // the chunks are the tail the hello asked for. Frames that beat it are
+  // dropped and later ones wait, so the tail lands in order. The final
+  // chunk carries the seq to resume from next time and redraws the chart.
   function loadHistory(msg) {
+    var chunked = msg.chunk !== undefined;
+    var first = !chunked || msg.chunk === 0;
+    var final = !chunked || msg.final;
+
+    if (first) {
+      applyHistoryHeader(msg);
+      // Legacy history with no points leaves the current chart alone
+      if (!chunked && !msg.hasData) return;
+      historySession = msg.session !== undefined ? msg.session : null;
+      historySeq = null;
+      historyLoading = true;
+      historyResuming = !!msg.resume;
+      if (historyResuming) {
+        if (resumeFrom !== null) storeDropAfter(resumeFrom);
+      } else {
+        storeClear();
+        // Reset cook timer and re-derive from history (server is source of truth)
+        resetCookTimer();
+      }
+    }
+
+    appendHistoryPoints(msg.cols);
+
+    if (final) {
+      historySeq = msg.next !== undefined ? msg.next : null;
+      historyLoading = false;
+      historyResuming = false;
+      resumeFrom = null;
+      finishHistory();
+      saveHistoryCache();
+    }
+  }
+
+  function applyHistoryHeader(msg) {
     // Restore alarm targets and setpoint (server values are always °F)
     if (msg.sp !== undefined) {
       pitSetpoint = msg.sp;
@@ -440,44 +678,42 @@
         hideMeatTarget(2);
       }
     }
+  }
 
-    // Populate chart data from history (stored as °F)
-    if (!msg.data || !msg.data.length) return;
-
-    // Reset chart arrays
-    for (var i = 0; i < chartData.length; i++) {
-      chartData[i] = [];
+  // Columns decoded by decoder.js (°F, NaN for missing values)
+  function appendHistoryPoints(cols) {
+    var t1 = meat1Target !== null ? meat1Target : NaN;
+    var t2 = meat2Target !== null ? meat2Target : NaN;
+    // A resumed tail may overlap what the chart already has
+    var after = historyResuming ? storeLast(0) : null;
+    for (var j = 0; j < cols.n; j++) {
+      if (after !== null && cols.ts[j] <= after) continue;
+      var sp = cols.sp[j];
+      storePush(cols.ts[j], cols.pit[j], cols.meat1[j], cols.meat2[j], cols.fan[j],
+                cols.damper[j], sp === sp ? sp : pitSetpoint, t1, t2);
     }
+    if (cols.firstMeatTs !== null) startCookTimer(cols.firstMeatTs);
+  }
 
-    for (var j = 0; j < msg.data.length; j++) {
-      var d = msg.data[j];
-      chartData[0].push(d.ts);
-      chartData[1].push(d.pit !== null && d.pit !== undefined && d.pit !== -1 ? d.pit : null);
-      chartData[2].push(d.meat1 !== null && d.meat1 !== undefined && d.meat1 !== -1 ? d.meat1 : null);
-      chartData[3].push(d.meat2 !== null && d.meat2 !== undefined && d.meat2 !== -1 ? d.meat2 : null);
-      chartData[4].push(d.fan !== undefined ? d.fan : null);
-      chartData[5].push(d.damper !== undefined ? d.damper : null);
-      chartData[6].push(d.sp !== undefined ? d.sp : pitSetpoint);
-      chartData[7].push(meat1Target);
-      chartData[8].push(meat2Target);
-    }
+  function finishHistory() {
+    if (!store.len) return;
 
     // Update display with the latest point
-    var last = msg.data[msg.data.length - 1];
+    var last = {
+      ts: storeLast(0),
+      pit: storeLast(1),
+      meat1: storeLast(2),
+      meat2: storeLast(3),
+      fan: storeLast(4),
+      damper: storeLast(5),
+      sp: storeLast(6)
+    };
     latestServerTs = last.ts;
     updateTemperatures(last);
     updateOutputs(last);
 
-    // Reset cook timer and re-derive from history (server is source of truth)
-    resetCookTimer();
-    for (var k = 0; k < msg.data.length; k++) {
-      updateCookTimer(msg.data[k]);
-      if (cookTimerStart) break;
-    }
-
-    if (chart) {
-      chart.setData(buildChartDataWithPrediction());
-    }
+    viewStale = true;
+    drawChart();
     updatePredictions();
     updateLegendValues(null);
   }
@@ -487,6 +723,8 @@
     dom.pitTemp.textContent = formatTemp(msg.pit);
     dom.meat1Temp.textContent = formatTemp(msg.meat1);
     dom.meat2Temp.textContent = formatTemp(msg.meat2);
+    updateExtraProbes(msg);
+    updateZones(msg);
 
     if (msg.sp !== undefined) {
       pitSetpoint = msg.sp;
@@ -511,6 +749,101 @@
     }
   }
 
+  // Builds with more than three probe channels send meat3..meat7 and
+  // their targets. Each gets a card with its target, added the first time
+  // the key shows up; the firmware raises the done alarm for it as for
+  // meat1/meat2.
+  var extraProbeCards = {};
+
+  function addExtraProbeCard(n) {
+    var key = 'meat' + n;
+    var card = document.createElement('div');
+    card.className = 'card temp-card extra-probe-card no-target';
+    card.innerHTML = '<div class="card-header"><span class="probe-label">Meat ' + n + '</span>' +
+      '<span class="probe-icon">&#x1F969;</span></div>' +
+      '<div class="temp-display"><span class="temp-value">---</span>' +
+      '<span class="temp-unit">' + unitLabel() + '</span></div>' +
+      '<div class="setpoint-display"><span class="setpoint-label">Target:</span>' +
+      '<span class="setpoint-value">---</span>' +
+      '<span class="temp-unit">' + unitLabel() + '</span></div>' +
+      '<div class="probe-target"><input type="number" class="probe-target-input" step="5" placeholder="---">' +
+      '<button class="btn btn-primary btn-sm probe-target-set">Set</button></div>';
+    var input = card.querySelector('.probe-target-input');
+    card.querySelector('.probe-target-set').addEventListener('click', function () {
+      var cmd = { type: 'alarm' };
+      var raw = input.value.trim();
+      if (raw === '') {
+        cmd[key + 'Target'] = null;
+      } else {
+        var displayVal = parseInt(raw, 10);
+        var min = currentUnits === 'C' ? 38 : 100;
+        var max = currentUnits === 'C' ? 100 : 212;
+        if (isNaN(displayVal) || displayVal < min || displayVal > max) return;
+        cmd[key + 'Target'] = displayTempFromInput(displayVal);
+      }
+      wsSend(cmd);
+    });
+    dom.tempCards.appendChild(card);
+    return extraProbeCards[key] = {
+      card: card,
+      temp: card.querySelector('.temp-value'),
+      target: card.querySelector('.setpoint-value'),
+      input: input
+    };
+  }
+
+  function updateExtraProbes(msg) {
+    for (var n = 3; n < 8; n++) {
+      var key = 'meat' + n;
+      if (msg[key] === undefined) break;
+      var el = extraProbeCards[key] || addExtraProbeCard(n);
+      el.temp.textContent = formatTemp(msg[key]);
+
+      var target = msg[key + 'Target'];
+      if (target === undefined) continue;
+      var has = target !== null && target > 0;
+      el.card.classList.toggle('no-target', !has);
+      el.target.textContent = has ? displayTemp(target) : '---';
+      if (document.activeElement !== el.input) el.input.value = has ? displayTemp(target) : '';
+    }
+  }
+
+  // Multi-zone units send zones past zone 0 (the pit) in msg.zones. Each
+  // gets a card with its probe, setpoint and outputs, added the first time
+  // the zone shows up.
+  var zoneCards = {};
+
+  function updateZones(msg) {
+    if (!msg.zones) return;
+    msg.zones.forEach(function (z) {
+      var card = zoneCards[z.zone];
+      if (!card) {
+        card = document.createElement('div');
+        card.className = 'card temp-card zone-card no-target';
+        card.innerHTML = '<div class="card-header"><span class="probe-label">Zone ' + z.zone + '</span>' +
+          '<span class="zone-probe"></span></div>' +
+          '<div class="temp-display"><span class="temp-value">---</span>' +
+          '<span class="temp-unit">' + unitLabel() + '</span></div>' +
+          '<div class="zone-setpoint"><input type="number" class="zone-sp-input" step="5">' +
+          '<button class="btn btn-primary btn-sm zone-sp-set">Set</button></div>' +
+          '<div class="zone-outputs"></div>';
+        var input = card.querySelector('.zone-sp-input');
+        card.querySelector('.zone-sp-set').addEventListener('click', function () {
+          var val = parseFloat(input.value);
+          if (!isNaN(val)) wsSend({ type: 'set', zone: z.zone, sp: displayTempFromInput(val) });
+        });
+        dom.tempCards.appendChild(card);
+        zoneCards[z.zone] = card;
+      }
+      card.querySelector('.zone-probe').textContent = z.probe;
+      card.querySelector('.temp-value').textContent = formatTemp(msg[z.probe]);
+      var spInput = card.querySelector('.zone-sp-input');
+      if (document.activeElement !== spInput) spInput.value = displayTemp(z.sp);
+      card.querySelector('.zone-outputs').textContent =
+        'Fan ' + Math.round(z.fan) + '% \u00B7 Damper ' + Math.round(z.damper) + '%' + (z.lid ? ' \u00B7 Lid open' : '');
+    });
+  }
+
   function updateOutputs(msg) {
     var fan = msg.fan !== undefined ? msg.fan : 0;
     var damper = msg.damper !== undefined ? msg.damper : 0;
@@ -525,13 +858,15 @@
   // Cook Timer
   // ---------------------------------------------------------------------------
   function updateCookTimer(msg) {
-    if (cookTimerStart) return; // already started
     var meat1Valid = msg.meat1 !== null && msg.meat1 !== undefined && msg.meat1 !== -1;
     var meat2Valid = msg.meat2 !== null && msg.meat2 !== undefined && msg.meat2 !== -1;
-    if (meat1Valid || meat2Valid) {
-      cookTimerStart = msg.ts || Math.floor(Date.now() / 1000);
-      localStorage.setItem('bbq_cook_timer_start', cookTimerStart.toString());
-    }
+    if (meat1Valid || meat2Valid) startCookTimer(msg.ts || Math.floor(Date.now() / 1000));
+  }
+
+  function startCookTimer(ts) {
+    if (cookTimerStart) return; // already started
+    cookTimerStart = ts;
+    localStorage.setItem('bbq_cook_timer_start', cookTimerStart.toString());
   }
 
   function tickCookTimer() {
@@ -734,7 +1069,9 @@
       return;
     }
 
-    chart = new uPlot(buildChartOpts(), chartData, dom.chartContainer);
+    viewStale = true;
+    chart = new uPlot(buildChartOpts(), chartView, dom.chartContainer);
+    if (store.len) drawChart();
   }
 
   function recreateChart() {
@@ -750,56 +1087,274 @@
         chart.setSeries(i, { show: seriesShow[i] });
       }
     }
-    if (chartData[0].length > 0 && chart) {
-      chart.setData(buildChartDataWithPrediction());
-    }
     syncLegendClasses();
   }
 
+  // ---------------------------------------------------------------------------
+  // Chart store
+  // ---------------------------------------------------------------------------
+  // Every point is kept in a ring of typed-array columns: a live frame is
+  // written in place and old points are dropped by moving the head, with
+  // no per-frame push/shift/slice of nine arrays. Missing values are NaN in
+  // the store and null in chartView. store.base counts the points dropped
+  // since the last clear, so base + i identifies a point across trims.
+  function storeCreate(cap) {
+    var cols = [new Float64Array(cap)];
+    for (var c = 1; c < CHART_COLS; c++) cols.push(new Float32Array(cap));
+    return { cols: cols, cap: cap, head: 0, len: 0, base: 0 };
+  }
+
+  function storeClear() {
+    store.head = 0;
+    store.len = 0;
+    store.base = 0;
+    viewStale = true;
+  }
+
+  // Copy of a column in order, oldest first
+  function storeColumn(col) {
+    var src = store.cols[col];
+    var out = new src.constructor(store.len);
+    var tail = Math.min(store.len, store.cap - store.head);
+    out.set(src.subarray(store.head, store.head + tail), 0);
+    out.set(src.subarray(0, store.len - tail), tail);
+    return out;
+  }
+
+  function storeGrow() {
+    var next = storeCreate(store.cap * 2);
+    for (var c = 0; c < CHART_COLS; c++) next.cols[c].set(storeColumn(c), 0);
+    next.len = store.len;
+    next.base = store.base;
+    store = next;
+  }
+
+  function storePush(ts, pit, meat1, meat2, fan, damper, sp, t1, t2) {
+    if (store.len === store.cap) storeGrow();
+    var i = (store.head + store.len) % store.cap;
+    var cols = store.cols;
+    cols[0][i] = ts; cols[1][i] = pit; cols[2][i] = meat1; cols[3][i] = meat2;
+    cols[4][i] = fan; cols[5][i] = damper; cols[6][i] = sp; cols[7][i] = t1; cols[8][i] = t2;
+    store.len++;
+  }
+
+  function storeDropBefore(ts) {
+    while (store.len > 0 && store.cols[0][store.head] < ts) {
+      store.head = (store.head + 1) % store.cap;
+      store.len--;
+      store.base++;
+    }
+  }
+
+  // Drop the newest points back to timestamp ts
+  function storeDropAfter(ts) {
+    while (store.len > 0 && store.cols[0][(store.head + store.len - 1) % store.cap] > ts) {
+      store.len--;
+      viewStale = true;
+    }
+  }
+
+  // Value i points from the oldest, null when missing
+  function storeGet(col, i) {
+    var v = store.cols[col][(store.head + i) % store.cap];
+    return v !== v ? null : v;
+  }
+
+  function storeLast(col) {
+    return store.len ? storeGet(col, store.len - 1) : null;
+  }
+
+  function storeFill(col, v) {
+    store.cols[col].fill(v === null ? NaN : v);
+  }
+
+  // Value for a JSON field: null, undefined and the -1 sentinel are missing
+  function tempOrNaN(v) {
+    return v !== null && v !== undefined && v !== -1 ? v : NaN;
+  }
+
+  // ---------------------------------------------------------------------------
+  // History cache
+  // ---------------------------------------------------------------------------
+  // The store is copied to IndexedDB with the session and seq it's complete
+  // up to, so a reloaded page draws the cook at once and its hello only
+  // asks the device for the points it missed. Without IndexedDB the page
+  // simply gets the full replay.
+  function openHistoryCache(done) {
+    var req;
+    try {
+      req = indexedDB.open(HISTORY_DB, 1);
+    } catch (e) {
+      done();
+      return;
+    }
+    req.onupgradeneeded = function () { req.result.createObjectStore('history'); };
+    req.onsuccess = function () {
+      historyDb = req.result;
+      loadHistoryCache(done);
+    };
+    req.onerror = function () { done(); };
+  }
+
+  function loadHistoryCache(done) {
+    var get;
+    try {
+      get = historyDb.transaction('history').objectStore('history').get('current');
+    } catch (e) {
+      done();
+      return;
+    }
+    get.onsuccess = function () {
+      var c = get.result;
+      if (c && c.n > 0 && c.cols && c.cols.length === CHART_COLS && !store.len) {
+        for (var i = 0; i < c.n; i++) {
+          storePush(c.cols[0][i], c.cols[1][i], c.cols[2][i], c.cols[3][i], c.cols[4][i],
+                    c.cols[5][i], c.cols[6][i], c.cols[7][i], c.cols[8][i]);
+        }
+        historySession = c.session;
+        historySeq = c.seq;
+        finishHistory();
+      }
+      done();
+    };
+    get.onerror = function () { done(); };
+  }
+
+  function saveHistoryCache() {
+    historySavedMs = Date.now();
+    if (!historyDb || historySession === null || historySeq === null || !store.len) return;
+    var cols = [];
+    for (var c = 0; c < CHART_COLS; c++) cols.push(storeColumn(c));
+    try {
+      historyDb.transaction('history', 'readwrite').objectStore('history').put(
+        { session: historySession, seq: historySeq, n: store.len, cols: cols }, 'current');
+    } catch (e) {
+      console.warn('History cache write failed:', e);
+    }
+  }
+
+  function clearHistoryCache() {
+    if (!historyDb) return;
+    try {
+      historyDb.transaction('history', 'readwrite').objectStore('history').delete('current');
+    } catch (e) {
+      console.warn('History cache clear failed:', e);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // Chart view
+  // ---------------------------------------------------------------------------
+  // uPlot gets at most two points per pixel column. Past that the store is
+  // split into one bucket per pixel and each bucket contributes its first
+  // and last timestamp carrying every series' min and max in the order they
+  // occurred, so spikes survive. New points are appended to the view as is
+  // until it holds three points per pixel, then it's rebuilt.
+  function chartBuckets() {
+    var width = chart ? chart.width : dom.chartContainer.clientWidth;
+    return Math.max(1, Math.round(width || 1));
+  }
+
+  function viewPush(i) {
+    for (var c = 0; c < CHART_COLS; c++) chartView[c].push(storeGet(c, i));
+  }
+
+  function rebuildView() {
+    var n = store.len;
+    var buckets = chartBuckets();
+    var c;
+    for (c = 0; c < CHART_COLS; c++) chartView[c].length = 0;
+
+    if (n <= buckets * 2) {
+      for (var i = 0; i < n; i++) viewPush(i);
+    } else {
+      for (var b = 0; b < buckets; b++) {
+        var from = Math.floor(b * n / buckets);
+        var to = Math.floor((b + 1) * n / buckets) - 1;
+        if (to <= from) {
+          viewPush(from);
+          continue;
+        }
+        chartView[0].push(storeGet(0, from), storeGet(0, to));
+        for (c = 1; c < CHART_COLS; c++) {
+          var lo = null, hi = null, loAt = 0, hiAt = 0;
+          for (var j = from; j <= to; j++) {
+            var v = storeGet(c, j);
+            if (v === null) continue;
+            if (lo === null || v < lo) { lo = v; loAt = j; }
+            if (hi === null || v > hi) { hi = v; hiAt = j; }
+          }
+          if (loAt <= hiAt) chartView[c].push(lo, hi);
+          else chartView[c].push(hi, lo);
+        }
+      }
+    }
+    viewStart = store.base;
+    viewEnd = store.base + n;
+    viewStale = false;
+  }
+
+  function updateView() {
+    var end = store.base + store.len;
+    if (viewStale || store.base !== viewStart ||
+        chartView[0].length + (end - viewEnd) > chartBuckets() * 3) {
+      rebuildView();
+      return;
+    }
+    for (var k = viewEnd; k < end; k++) viewPush(k - store.base);
+    viewEnd = end;
+  }
+
+  // Redraws are coalesced to one per animation frame, and skipped while
+  // the tab is hidden (the browser holds the frame back until it's shown)
+  function drawChart() {
+    if (drawPending || !chart) return;
+    drawPending = true;
+    requestAnimationFrame(function () {
+      drawPending = false;
+      if (!chart) return;
+      updateView();
+      chart.setData(chartView);
+    });
+  }
+
   function appendChartData(msg) {
     var now = msg.ts || Math.floor(Date.now() / 1000);
     latestServerTs = now;
 
-    chartData[0].push(now);
-    chartData[1].push(msg.pit !== null && msg.pit !== undefined && msg.pit !== -1 ? msg.pit : null);
-    chartData[2].push(msg.meat1 !== null && msg.meat1 !== undefined && msg.meat1 !== -1 ? msg.meat1 : null);
-    chartData[3].push(msg.meat2 !== null && msg.meat2 !== undefined && msg.meat2 !== -1 ? msg.meat2 : null);
-    chartData[4].push(msg.fan !== undefined ? msg.fan : null);
-    chartData[5].push(msg.damper !== undefined ? msg.damper : null);
-    chartData[6].push(msg.sp !== undefined ? msg.sp : pitSetpoint);
-    chartData[7].push(meat1Target);
-    chartData[8].push(meat2Target);
-
-    // Trim data older than 4 hours (keep extra buffer beyond 2h visible window)
-    var cutoff = now - 4 * 60 * 60;
-    while (chartData[0].length > 0 && chartData[0][0] < cutoff) {
-      for (var i = 0; i < chartData.length; i++) {
-        chartData[i].shift();
-      }
-    }
+    storePush(now, tempOrNaN(msg.pit), tempOrNaN(msg.meat1), tempOrNaN(msg.meat2),
+              msg.fan !== undefined ? msg.fan : NaN,
+              msg.damper !== undefined ? msg.damper : NaN,
+              msg.sp !== undefined ? msg.sp : pitSetpoint,
+              meat1Target !== null ? meat1Target : NaN,
+              meat2Target !== null ? meat2Target : NaN);
 
-    if (chart) {
-      chart.setData(buildChartDataWithPrediction());
+    // Drop points older than CHART_KEEP_SEC, a batch at a time
+    if (store.cols[0][store.head] < now - CHART_KEEP_SEC - CHART_TRIM_SLACK_SEC) {
+      storeDropBefore(now - CHART_KEEP_SEC);
     }
+
+    drawChart();
     updateLegendValues(null);
+    if (Date.now() - historySavedMs > HISTORY_CACHE_MS) saveHistoryCache();
   }
 
   function clearTargetFromChart(seriesIndex) {
-    for (var i = 0; i < chartData[seriesIndex].length; i++) {
-      chartData[seriesIndex][i] = null;
-    }
-    if (chart) {
-      chart.setData(buildChartDataWithPrediction());
-    }
+    setTargetInChart(seriesIndex, null);
   }
 
   function restoreTargetInChart(seriesIndex, fVal) {
-    for (var i = 0; i < chartData[seriesIndex].length; i++) {
-      chartData[seriesIndex][i] = fVal;
-    }
-    if (chart) {
-      chart.setData(buildChartDataWithPrediction());
-    }
+    setTargetInChart(seriesIndex, fVal);
+  }
+
+  // A target column always holds a single value, so the oldest point says
+  // whether it changed; data frames repeat the targets every time
+  function setTargetInChart(seriesIndex, fVal) {
+    var v = fVal === null ? NaN : Math.fround(fVal);
+    if (!store.len || Object.is(store.cols[seriesIndex][store.head], v)) return;
+    storeFill(seriesIndex, fVal);
+    viewStale = true;
+    drawChart();
   }
 
   function showMeatTarget(probe, fVal) {
@@ -836,20 +1391,13 @@
     }
   }
 
-  function buildChartDataWithPrediction() {
-    // Base data (copy)
-    var data = [];
-    for (var i = 0; i < chartData.length; i++) {
-      data.push(chartData[i].slice());
-    }
-    return data;
-  }
-
   function resizeChart() {
     if (!chart || !dom.chartContainer) return;
     var width = dom.chartContainer.clientWidth;
     var height = Math.max(280, Math.min(500, window.innerHeight * 0.45));
     chart.setSize({ width: width, height: height });
+    viewStale = true;
+    drawChart();
   }
 
   function initLegendToggles() {
@@ -876,10 +1424,11 @@
     }
   }
 
+  // idx is a chartView index from the cursor; null shows the latest point
   function updateLegendValues(idx) {
-    var len = chartData[0].length;
-    if (idx == null || idx < 0 || idx >= len) idx = len - 1;
-    if (len === 0 || idx < 0) {
+    var len = chartView[0].length;
+    var latest = idx == null || idx < 0 || idx >= len;
+    if (latest && !store.len) {
       dom.legTime.textContent = '--:--';
       dom.legPit.textContent = '--';
       dom.legMeat1.textContent = '--';
@@ -891,16 +1440,17 @@
       dom.legDamper.textContent = '--';
       return;
     }
-    dom.legTime.textContent = formatClockTime(new Date(chartData[0][idx] * 1000));
+    function val(col) { return latest ? storeLast(col) : chartView[col][idx]; }
+    dom.legTime.textContent = formatClockTime(new Date(val(0) * 1000));
     var v;
-    v = chartData[1][idx]; dom.legPit.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
-    v = chartData[2][idx]; dom.legMeat1.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
-    v = chartData[3][idx]; dom.legMeat2.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
-    v = chartData[4][idx]; dom.legFan.textContent = v == null ? '--' : Math.round(v) + '%';
-    v = chartData[5][idx]; dom.legDamper.textContent = v == null ? '--' : Math.round(v) + '%';
-    v = chartData[6][idx]; dom.legSP.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
-    v = chartData[7][idx]; dom.legM1Tgt.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
-    v = chartData[8][idx]; dom.legM2Tgt.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
+    v = val(1); dom.legPit.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
+    v = val(2); dom.legMeat1.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
+    v = val(3); dom.legMeat2.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
+    v = val(4); dom.legFan.textContent = v == null ? '--' : Math.round(v) + '%';
+    v = val(5); dom.legDamper.textContent = v == null ? '--' : Math.round(v) + '%';
+    v = val(6); dom.legSP.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
+    v = val(7); dom.legM1Tgt.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
+    v = val(8); dom.legM2Tgt.textContent = v == null ? '--' : displayTemp(v) + '\u00B0';
   }
 
   // ---------------------------------------------------------------------------
@@ -924,18 +1474,21 @@
   }
 
   function predictDoneTime(seriesIndex, target) {
-    if (!target || chartData[0].length < MIN_PREDICTION_POINTS) return null;
+    if (!target || store.len < MIN_PREDICTION_POINTS) return null;
 
-    var now = chartData[0][chartData[0].length - 1];
+    var now = storeLast(0);
     var windowStart = now - PREDICTION_WINDOW_SEC;
 
-    // Collect recent valid data points
+    // Collect recent valid data points, walking back from the newest
+    var first = store.len;
+    while (first > 0 && storeGet(0, first - 1) >= windowStart) first--;
     var xs = [];
     var ys = [];
-    for (var i = 0; i < chartData[0].length; i++) {
-      if (chartData[0][i] >= windowStart && chartData[seriesIndex][i] !== null) {
-        xs.push(chartData[0][i]);
-        ys.push(chartData[seriesIndex][i]);
+    for (var i = first; i < store.len; i++) {
+      var y = storeGet(seriesIndex, i);
+      if (y !== null) {
+        xs.push(storeGet(0, i));
+        ys.push(y);
       }
     }
 
@@ -961,12 +1514,12 @@
   }
 
   function updatePitPrediction() {
-    if (!pitSetpoint || chartData[0].length < MIN_PREDICTION_POINTS) {
-      dom.pitPrediction.textContent = chartData[0].length > 0 ? 'Calculating...' : '';
+    if (!pitSetpoint || store.len < MIN_PREDICTION_POINTS) {
+      dom.pitPrediction.textContent = store.len > 0 ? 'Calculating...' : '';
       return;
     }
 
-    var last = chartData[1][chartData[1].length - 1];
+    var last = storeLast(1);
     if (last !== null && last >= pitSetpoint) {
       dom.pitPrediction.textContent = '';
       return;
@@ -996,7 +1549,7 @@
       return;
     }
 
-    if (chartData[0].length < MIN_PREDICTION_POINTS) {
+    if (store.len < MIN_PREDICTION_POINTS) {
       domElement.textContent = 'Calculating...';
       return;
     }
@@ -1004,7 +1557,7 @@
     var pred = predictDoneTime(seriesIndex, target);
     if (!pred) {
       // Check if already at target
-      var last = chartData[seriesIndex][chartData[seriesIndex].length - 1];
+      var last = storeLast(seriesIndex);
       if (last !== null && last >= target) {
         domElement.textContent = 'Target reached!';
       } else {
@@ -1110,11 +1663,10 @@
 
   function refreshAllDisplayValues() {
     // Re-display all temps from internal °F state
-    var len = chartData[0].length;
-    if (len > 0) {
-      dom.pitTemp.textContent = formatTemp(chartData[1][len - 1]);
-      dom.meat1Temp.textContent = formatTemp(chartData[2][len - 1]);
-      dom.meat2Temp.textContent = formatTemp(chartData[3][len - 1]);
+    if (store.len > 0) {
+      dom.pitTemp.textContent = formatTemp(storeLast(1));
+      dom.meat1Temp.textContent = formatTemp(storeLast(2));
+      dom.meat2Temp.textContent = formatTemp(storeLast(3));
     }
 
     dom.pitSetpoint.textContent = displayTemp(pitSetpoint);
@@ -1309,8 +1861,18 @@
       }
     });
 
+    // PID auto-tune: the device reports progress through the 'tuning' flag
+    dom.btnAutoTune.addEventListener('click', function () {
+      if (autoTuning) {
+        wsSend({ type: 'autotune', action: 'cancel' });
+      } else if (confirm('Start PID auto-tune? The pit will swing a few degrees around the set point for up to an hour, and the new tunings are saved when it finishes.')) {
+        wsSend({ type: 'autotune', action: 'start' });
+      }
+    });
+
     dom.btnDownloadCSV.addEventListener('click', function () {
-      wsSend({ type: 'session', action: 'download', format: 'csv' });
+      // Streamed over HTTP so the device never holds the whole export in RAM
+      downloadExport('/api/session.csv', 'cook-session.csv');
     });
 
     // Fan mode buttons
@@ -1332,6 +1894,88 @@
     });
   }
 
+  // ---------------------------------------------------------------------------
+  // Probe Calibration
+  // ---------------------------------------------------------------------------
+  // The unit watches the probe and records a point once the readings settle
+  // (/api/calibrate); apply solves and saves new coefficients on the device.
+  var calProbe = 1;
+  var calState = 'idle';
+  var calTimer = null;
+
+  function calRequest(action, query) {
+    var url = '/api/calibrate' + (action ? '?action=' + action + (query || '') : '');
+    return fetch(url, { method: action ? 'POST' : 'GET', cache: 'no-store' })
+      .then(function (r) { return r.json(); })
+      .then(showCalStatus)
+      .catch(function () {
+        dom.calStatus.textContent = 'Calibration request failed';
+      });
+  }
+
+  function showCalStatus(s) {
+    calState = s.state || 'idle';
+    var active = calState !== 'idle';
+    var points = s.points || [];
+
+    dom.btnCalStart.textContent = active ? 'Cancel Calibration' : 'Start Calibration';
+    dom.btnCalCapture.disabled = calState !== 'sampling' || points.length >= 3;
+    dom.btnCalApply.disabled = calState !== 'sampling' || points.length === 0;
+    dom.btnCalApply.textContent = points.length ? 'Apply ' + points.length + '-Point Calibration' : 'Apply';
+    for (var i = 0; i < dom.calProbeButtons.length; i++) {
+      var btn = dom.calProbeButtons[i];
+      btn.disabled = active;
+      if (active) btn.classList.toggle('active', Number(btn.getAttribute('data-probe')) === s.probe);
+    }
+
+    var text;
+    if (active) {
+      var r = s.reading;
+      text = 'Reading ' + (r === null || r === undefined ? '---' : (currentUnits === 'C' ? fToC(r) : r).toFixed(1)) +
+             unitLabel() + (calState === 'capturing' ? (s.stable ? '' : ', settling (' + s.samples + ' s)') :
+             (s.stable ? ', steady' : '')) + ' \u2022 ' + points.length + ' of 3 points';
+    } else {
+      text = 'Hold the probe in a reference, enter its temperature and capture up to 3 points.';
+    }
+    if (s.error) text = s.error + '. ' + text;
+    dom.calStatus.textContent = text;
+
+    clearTimeout(calTimer);
+    if (active) calTimer = setTimeout(function () { calRequest(''); }, CAL_POLL_MS);
+  }
+
+  function initCalibration() {
+    for (var i = 0; i < dom.calProbeButtons.length; i++) {
+      dom.calProbeButtons[i].addEventListener('click', function () {
+        calProbe = Number(this.getAttribute('data-probe'));
+        for (var j = 0; j < dom.calProbeButtons.length; j++) {
+          dom.calProbeButtons[j].classList.toggle('active', dom.calProbeButtons[j] === this);
+        }
+      });
+    }
+
+    dom.btnCalStart.addEventListener('click', function () {
+      calRequest(calState === 'idle' ? 'start' : 'cancel', '&probe=' + calProbe);
+    });
+
+    dom.btnCalCapture.addEventListener('click', function () {
+      var v = parseFloat(dom.calRefInput.value);
+      if (isNaN(v)) {
+        dom.calStatus.textContent = 'Enter the reference temperature first.';
+        return;
+      }
+      // The unit works in its own units (F); convert what the user typed
+      calRequest('capture', '&ref=' + (currentUnits === 'C' ? cToF(v) : v).toFixed(2));
+    });
+
+    dom.btnCalApply.addEventListener('click', function () {
+      if (confirm('Replace this probe\'s calibration with the one measured?')) calRequest('apply');
+    });
+
+    // A run left open by another client, or before a reload
+    calRequest('');
+  }
+
   // ---------------------------------------------------------------------------
   // Notifications
   // ---------------------------------------------------------------------------
@@ -1462,6 +2106,100 @@
     resizeTimeout = setTimeout(resizeChart, 150);
   }
 
+  // ---------------------------------------------------------------------------
+  // Hub Mode (other units, merged by this one; see hub_peers.h)
+  // ---------------------------------------------------------------------------
+  function pollHub() {
+    fetch('/api/hub', { cache: 'no-store' })
+      .then(function (r) {
+        if (r.status === 404) throw new Error('off');
+        if (!r.ok) throw new Error('Hub ' + r.status);
+        return r.json();
+      })
+      .then(function (hub) {
+        if (Date.now() - hubHistoryMs >= HUB_HISTORY_MS) {
+          hubHistoryMs = Date.now();
+          fetchHubHistory(hub.units);
+        }
+        renderHub(hub.units);
+        setTimeout(pollHub, HUB_POLL_MS);
+      })
+      .catch(function (err) {
+        // Not a hub: no panel, no more polling
+        if (err.message === 'off') {
+          dom.hubUnits.style.display = 'none';
+          return;
+        }
+        setTimeout(pollHub, HUB_POLL_MS);
+      });
+  }
+
+  function fetchHubHistory(units) {
+    units.forEach(function (u) {
+      if (u.local) return;
+      var pts = hubHistory[u.id] || [];
+      var since = pts.length ? pts[pts.length - 1][0] : 0;
+      fetch('/api/hub/history?id=' + u.id + '&since=' + since, { cache: 'no-store' })
+        .then(function (r) { return r.ok ? r.json() : null; })
+        .then(function (h) {
+          if (!h) return;
+          // A peer's clock moving back means a new cook (or a different unit in the slot)
+          if (h.points.length && pts.length && h.points[0][0] < since) pts = [];
+          pts = pts.concat(h.points).slice(-HUB_HISTORY_POINTS);
+          hubHistory[u.id] = pts;
+        })
+        .catch(function () {});
+    });
+  }
+
+  // Pit temperature over the peer's trend as an SVG polyline
+  function hubSparkline(pts) {
+    var vals = pts.filter(function (p) { return p[1] !== null; });
+    if (vals.length < 2) return '';
+    var t0 = vals[0][0], t1 = vals[vals.length - 1][0];
+    var lo = Infinity, hi = -Infinity;
+    vals.forEach(function (p) { lo = Math.min(lo, p[1]); hi = Math.max(hi, p[1]); });
+    if (hi - lo < 10) { hi += 5; lo -= 5; }
+    var line = vals.map(function (p) {
+      var x = ((p[0] - t0) / Math.max(1, t1 - t0)) * 100;
+      var y = 28 - ((p[1] - lo) / (hi - lo)) * 26;
+      return x.toFixed(1) + ',' + y.toFixed(1);
+    }).join(' ');
+    return '<svg class="hub-spark" viewBox="0 0 100 30" preserveAspectRatio="none">' +
+      '<polyline points="' + line + '"/></svg>';
+  }
+
+  function escapeHtml(text) {
+    return String(text).replace(/[&<>"']/g, function (c) {
+      return { '&': '&amp;', '<': '&lt;', '>': '&gt;', '"': '&quot;', "'": '&#39;' }[c];
+    });
+  }
+
+  function renderHub(units) {
+    dom.hubUnits.style.display = '';
+    var unit = unitLabel();
+    dom.hubUnits.innerHTML = units.map(function (u) {
+      var d = u.data || {};
+      var url = u.local ? '' : 'http://' + u.host + (u.port && u.port !== 80 ? ':' + u.port : '') + '/';
+      var status = u.local ? 'This unit' : (u.online ? 'Online' : (u.age === null ? 'Connecting' : 'Offline'));
+      var name = escapeHtml(u.name) + (u.local ? '' : ' <span class="hub-host">' + escapeHtml(u.host) + '</span>');
+      return '<div class="card hub-unit' + (u.online ? '' : ' hub-offline') + '">' +
+        '<div class="hub-unit-header">' +
+          (url ? '<a href="' + escapeHtml(url) + '" target="_blank" rel="noopener">' + name + '</a>' : name) +
+          '<span class="hub-status">' + status + '</span>' +
+        '</div>' +
+        '<div class="hub-temps">' +
+          '<span class="hub-pit">' + formatTemp(d.pit) + unit +
+            (d.sp ? ' <small>/ ' + displayTemp(d.sp) + '</small>' : '') + '</span>' +
+          '<span class="hub-meat1">' + formatTemp(d.meat1) + '</span>' +
+          '<span class="hub-meat2">' + formatTemp(d.meat2) + '</span>' +
+          (d.errors && d.errors.length ? '<span class="hub-error">' + escapeHtml(d.errors[0]) + '</span>' : '') +
+        '</div>' +
+        (u.local ? '' : hubSparkline(hubHistory[u.id] || [])) +
+        '</div>';
+    }).join('');
+  }
+
   // ---------------------------------------------------------------------------
   // Firmware Version & OTA Update
   // ---------------------------------------------------------------------------
@@ -1515,12 +2253,14 @@
   function performUpdate() {
     if (!latestRelease) return;
 
-    // Find firmware .bin asset
+    // Find the firmware asset, gzipped if the release has it (the unit
+    // inflates it as it writes)
     var asset = null;
     for (var i = 0; i < latestRelease.assets.length; i++) {
-      if (/pitclaw-firmware-.*\.bin$/.test(latestRelease.assets[i].name)) {
+      var name = latestRelease.assets[i].name;
+      if (/pitclaw-firmware-.*\.bin\.gz$/.test(name) ||
+          (!asset && /pitclaw-firmware-.*\.bin$/.test(name))) {
         asset = latestRelease.assets[i];
-        break;
       }
     }
     if (!asset) {
@@ -1582,36 +2322,82 @@
       });
   }
 
+  // Resumable upload (see ota_manager.h): every reply carries the offset the
+  // unit wants next, so a dropped chunk is just sent again from there
   function uploadFirmwareOTA(buffer) {
     var size = buffer.byteLength;
+    var offset = 0;
+    var failures = 0;
+
+    function otaPost(url, body) {
+      return fetch(url, {
+        method: 'POST',
+        body: body,
+        headers: body ? { 'Content-Type': 'application/octet-stream' } : undefined
+      }).then(function (r) {
+        return r.json().catch(function () { return {}; }).then(function (st) {
+          if (!r.ok) throw new Error(st.error || 'HTTP ' + r.status);
+          return st;
+        });
+      });
+    }
 
-    // ElegantOTA v3 protocol: start session, then upload chunks
-    return fetch('/ota/start?mode=fr&hash=0&size=' + size)
-      .then(function (r) {
-        if (!r.ok) throw new Error('OTA start failed: ' + r.status);
-        // Upload in chunks
-        var offset = 0;
-        function sendChunk() {
-          if (offset >= size) return Promise.resolve();
-          var end = Math.min(offset + OTA_CHUNK_SIZE, size);
-          var chunk = buffer.slice(offset, end);
-          return fetch('/ota/upload', {
-            method: 'POST',
-            body: chunk,
-            headers: { 'Content-Type': 'application/octet-stream' }
-          }).then(function (r) {
-            if (!r.ok) throw new Error('Chunk upload failed at ' + offset);
-            offset = end;
-            var pct = 40 + Math.round((offset / size) * 55);
-            dom.updateProgress.style.width = pct + '%';
-            dom.updateStatus.textContent = 'Uploading... ' + Math.round((offset / size) * 100) + '%';
-            return sendChunk();
-          });
-        }
+    function showUpload() {
+      var pct = 40 + Math.round((offset / size) * 55);
+      dom.updateProgress.style.width = pct + '%';
+      dom.updateStatus.textContent = 'Uploading... ' + Math.round((offset / size) * 100) + '%';
+    }
+
+    function retry() {
+      if (++failures > OTA_MAX_RETRIES) throw new Error('Upload lost at ' + offset + ' bytes');
+      dom.updateStatus.textContent = 'Connection lost, resuming...';
+      return new Promise(function (resolve) { setTimeout(resolve, OTA_RETRY_MS); })
+        .then(function () { return fetch('/api/ota/status'); })
+        .then(function (r) { return r.json(); })
+        .then(function (st) {
+          if (st.state !== 'receiving') throw new Error(st.error || 'Update ' + st.state);
+          offset = st.offset;
+          return sendChunk();
+        }, retry);
+    }
+
+    function sendChunk() {
+      if (offset >= size) return waitDone();
+      var end = Math.min(offset + OTA_CHUNK_SIZE, size);
+      return otaPost('/api/ota/chunk?offset=' + offset, buffer.slice(offset, end))
+        .then(function (st) {
+          if (st.state !== 'receiving' && st.state !== 'done') {
+            throw new Error(st.error || 'Update ' + st.state);
+          }
+          failures = 0;
+          offset = st.offset;
+          showUpload();
+          return sendChunk();
+        }, retry);
+    }
+
+    // The last bytes are still being inflated and written when the final
+    // chunk is accepted
+    function waitDone() {
+      dom.updateStatus.textContent = 'Writing firmware...';
+      return fetch('/api/ota/status')
+        .then(function (r) { return r.json(); })
+        .then(function (st) {
+          if (st.state === 'done') return;
+          if (st.state !== 'receiving') throw new Error(st.error || 'Update ' + st.state);
+          return new Promise(function (resolve) { setTimeout(resolve, OTA_POLL_MS); }).then(waitDone);
+        });
+    }
+
+    // A start for the same size resumes an upload the unit still has open
+    return otaPost('/api/ota/start?size=' + size)
+      .then(function (st) {
+        if (st.state !== 'receiving') throw new Error('OTA start failed: ' + (st.error || st.state));
+        offset = st.offset;
         return sendChunk();
       })
       .catch(function (err) {
-        // On reboot during final chunk, the connection drops — that's expected
+        // The unit restarts into the new firmware soon after it reports done
         if (err.name === 'TypeError' && err.message.indexOf('Failed to fetch') !== -1) {
           return; // device is rebooting
         }
@@ -1629,7 +2415,9 @@
     updateToggleButtons();
     updateUnitLabels();
     restoreCookTimer();
+    initDecoder();
     initControls();
+    initCalibration();
     initChart();
     initLegendToggles();
     syncLegendClasses();
@@ -1638,7 +2426,13 @@
     dom.meat1Card.classList.add('no-target');
     dom.meat2Card.classList.add('no-target');
 
-    wsConnect();
+    // Draw the cached cook first, so the hello can ask for just the tail
+    if (typeof indexedDB !== 'undefined') {
+      openHistoryCache(wsConnect);
+    } else {
+      wsConnect();
+    }
+    window.addEventListener('pagehide', saveHistoryCache);
 
     // Notification bell
     dom.btnNotify.addEventListener('click', toggleNotifications);
@@ -1673,6 +2467,15 @@
     // Window resize
     window.addEventListener('resize', onResize);
 
+    // Slow the data stream while hidden
+    document.addEventListener('visibilitychange', sendDataRate);
+
+    // Clock sync and latency reports
+    setInterval(function () { if (connected) sendPing(); }, LATENCY_PING_MS);
+
+    // Other units, if this one is a hub
+    pollHub();
+
     // Firmware version and OTA update
     fetchVersion();
     dom.btnUpdate.addEventListener('click', performUpdate);
@@ -0,0 +1,174 @@
+// Pit Claw - decoder.js
+// Turns WebSocket messages into the objects app.js handles. Loaded as a
+// plain script (app.js falls back to it on the main thread) and as a Web
+// Worker, so long history replays and binary frames decode off the UI
+// thread. Messages come back out in the order they went in.
+
+var PitClawDecoder = (function () {
+  'use strict';
+
+  // Binary delta frames (see web_protocol.h)
+  var BIN_FRAME_DATA = 0x01;
+  var BIN_TEMP_NONE = -32768;
+  var BIN_FAN_MODES = ['fan_only', 'fan_and_damper', 'damper_primary'];
+
+  // History point fields copied into columns; missing values are NaN
+  var HISTORY_COLS = ['pit', 'meat1', 'meat2', 'fan', 'damper', 'sp'];
+
+  function create() {
+    var last = null; // last decoded binary data message (deltas apply on top)
+    var text = typeof TextDecoder !== 'undefined' ? new TextDecoder() : null;
+
+    // Decode a binary delta frame into a full 'data' message. Fields absent
+    // from the frame keep their previous values.
+    function decodeBinaryFrame(buf) {
+      var v = new DataView(buf);
+      var pos = 0;
+      if (v.getUint8(pos++) !== BIN_FRAME_DATA) return null;
+      var mask = v.getUint16(pos, true); pos += 2;
+
+      var msg = last ? Object.assign({}, last) : {
+        pit: null, meat1: null, meat2: null, fan: 0, damper: 0, sp: 0, lid: false,
+        stall: false, tuning: false, meat1Target: null, meat2Target: null, est: null,
+        estLow: null, estHigh: null, errors: []
+      };
+      msg.type = 'data';
+      msg.ts = v.getUint32(pos, true); pos += 4;
+
+      function temp() {
+        var t = v.getInt16(pos, true); pos += 2;
+        return t === BIN_TEMP_NONE ? null : t / 10;
+      }
+      function target() {
+        var t = v.getInt16(pos, true); pos += 2;
+        return t > 0 ? t : null;
+      }
+      function epoch() {
+        var t = v.getUint32(pos, true); pos += 4;
+        return t > 0 ? t : null;
+      }
+
+      if (mask & 0x0001) msg.pit = temp();
+      if (mask & 0x0002) msg.meat1 = temp();
+      if (mask & 0x0004) msg.meat2 = temp();
+      if (mask & 0x0008) msg.fan = v.getUint8(pos++);
+      if (mask & 0x0010) msg.damper = v.getUint8(pos++);
+      if (mask & 0x0020) { msg.sp = v.getInt16(pos, true); pos += 2; }
+      if (mask & 0x0040) {
+        var flags = v.getUint8(pos++);
+        msg.lid = (flags & 0x01) !== 0;
+        msg.stall = (flags & 0x02) !== 0;
+        msg.tuning = (flags & 0x04) !== 0;
+      }
+      if (mask & 0x0080) { msg.meat1Target = target(); msg.meat2Target = target(); }
+      if (mask & 0x0100) msg.est = epoch();
+      if (mask & 0x0200) { msg.estLow = epoch(); msg.estHigh = epoch(); }
+      if (mask & 0x0400) {
+        var fm = v.getUint8(pos++);
+        if (fm < BIN_FAN_MODES.length) msg.fanMode = BIN_FAN_MODES[fm];
+      }
+      if (mask & 0x0800) {
+        var count = v.getUint8(pos++);
+        msg.errors = [];
+        for (var i = 0; i < count; i++) {
+          var len = v.getUint8(pos++);
+          msg.errors.push(text ? text.decode(new Uint8Array(buf, pos, len)) : '');
+          pos += len;
+        }
+      }
+      if (mask & 0x1000) {
+        // Channels past meat2 on PROBE_CHANNELS > 3 builds, meat3 first:
+        // every temp, then every target
+        var extra = v.getUint8(pos++);
+        for (var e = 0; e < extra; e++) msg['meat' + (3 + e)] = temp();
+        for (e = 0; e < extra; e++) msg['meat' + (3 + e) + 'Target'] = target();
+      }
+      if (mask & 0x2000) {
+        // Control zones past zone 0 (multi-zone units)
+        var zones = v.getUint8(pos++);
+        msg.zones = [];
+        for (var z = 0; z < zones; z++) {
+          var probe = v.getUint8(pos++);
+          var zsp = v.getInt16(pos, true); pos += 2;
+          var zfan = v.getUint8(pos++);
+          var zdamper = v.getUint8(pos++);
+          var zflags = v.getUint8(pos++);
+          msg.zones.push({ zone: z + 1, probe: probe === 0 ? 'pit' : 'meat' + probe,
+                           sp: zsp, fan: zfan, damper: zdamper, lid: (zflags & 0x01) !== 0 });
+        }
+      }
+      if (mask & 0x4000) { msg.seq = v.getUint32(pos, true); pos += 4; }
+      if (mask & 0x8000) { msg.sampleUs = v.getUint32(pos, true); pos += 4; }
+
+      last = msg;
+      return msg;
+    }
+
+    // Replace a history message's point objects with typed-array columns
+    // (msg.cols) the chart store copies straight in. A disconnected probe
+    // (null or -1) and a missing field both become NaN. cols.firstMeatTs is
+    // the first point with a meat probe reading, for the cook timer.
+    function decodeHistory(msg) {
+      var data = msg.data || [];
+      var n = data.length;
+      var cols = { n: n, ts: new Float64Array(n), firstMeatTs: null };
+      for (var c = 0; c < HISTORY_COLS.length; c++) {
+        cols[HISTORY_COLS[c]] = new Float32Array(n);
+      }
+      for (var i = 0; i < n; i++) {
+        var d = data[i];
+        cols.ts[i] = d.ts;
+        for (c = 0; c < HISTORY_COLS.length; c++) {
+          var val = d[HISTORY_COLS[c]];
+          cols[HISTORY_COLS[c]][i] = val === null || val === undefined || (c < 3 && val === -1) ? NaN : val;
+        }
+        if (cols.firstMeatTs === null && (cols.meat1[i] === cols.meat1[i] || cols.meat2[i] === cols.meat2[i])) {
+          cols.firstMeatTs = d.ts;
+        }
+      }
+      msg.hasData = n > 0;
+      delete msg.data;
+      msg.cols = cols;
+      return msg;
+    }
+
+    return {
+      reset: function () { last = null; },
+      decode: function (raw) {
+        var msg = raw instanceof ArrayBuffer ? decodeBinaryFrame(raw) : JSON.parse(raw);
+        if (msg && msg.type === 'history') decodeHistory(msg);
+        return msg;
+      }
+    };
+  }
+
+  // Buffers to hand over with postMessage instead of copying
+  function transferList(msg) {
+    if (!msg || !msg.cols) return [];
+    var list = [msg.cols.ts.buffer];
+    for (var c = 0; c < HISTORY_COLS.length; c++) list.push(msg.cols[HISTORY_COLS[c]].buffer);
+    return list;
+  }
+
+  return { create: create, transferList: transferList };
+})();
+
+// Worker side: raw WebSocket data in, decoded messages out. 'reset' drops
+// the binary delta state when the socket reconnects.
+if (typeof WorkerGlobalScope !== 'undefined' && self instanceof WorkerGlobalScope) {
+  (function () {
+    var decoder = PitClawDecoder.create();
+    self.onmessage = function (evt) {
+      if (evt.data === 'reset') {
+        decoder.reset();
+        return;
+      }
+      try {
+        var msg = decoder.decode(evt.data);
+        if (msg) self.postMessage(msg, PitClawDecoder.transferList(msg));
+      } catch (e) {
+        console.warn('Failed to parse WS message:', e);
+      }
+    };
+  })();
+}
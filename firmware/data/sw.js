@@ -1,10 +1,11 @@
 // Pit Claw - Service Worker
 // Cache-first for app shell, network-first for data/WebSocket
 
-var CACHE_VERSION = 'pitclaw-v1';
+var CACHE_VERSION = 'pitclaw-v10';
 var APP_SHELL = [
   '/',
   '/index.html',
+  '/decoder.js',
   '/app.js',
   '/style.css',
   '/favicon.svg',
@@ -77,7 +78,9 @@ self.addEventListener('fetch', function (event) {
     if (shellUrl.startsWith('http')) {
       return event.request.url === shellUrl;
     }
-    return url.pathname === shellUrl || (shellUrl === '/' && url.pathname === '/index.html');
+    // Built images version shell URLs as /name?v=<hash>; match on the path
+    var shellPath = shellUrl.split('?')[0];
+    return url.pathname === shellPath || (shellPath === '/' && url.pathname === '/index.html');
   });
 
   if (isAppShell) {
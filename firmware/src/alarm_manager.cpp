@@ -5,21 +5,21 @@
 #endif
 
 AlarmManager::AlarmManager()
-    : _meat1Target(0.0f)
-    , _meat2Target(0.0f)
-    , _pitBand(ALARM_PIT_BAND_DEFAULT)
+    : _pitBand(ALARM_PIT_BAND_DEFAULT)
     , _activeCount(0)
     , _acknowledged(false)
     , _enabled(true)
     , _buzzerOn(false)
-    , _meat1Triggered(false)
-    , _meat2Triggered(false)
     , _pitTriggered(false)
     , _lastBuzzerToggleMs(0)
 {
     for (uint8_t i = 0; i < MAX_ACTIVE_ALARMS; i++) {
         _activeAlarms[i] = AlarmType::NONE;
     }
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        _meatTarget[m] = 0.0f;
+        _meatTriggered[m] = false;
+    }
 }
 
 void AlarmManager::begin() {
@@ -30,7 +30,7 @@ void AlarmManager::begin() {
 #endif
 }
 
-void AlarmManager::update(float pitTemp, float meat1Temp, float meat2Temp,
+void AlarmManager::update(float pitTemp, const float* meatTemps,
                            float setpoint, bool pitReached) {
     if (!_enabled) {
         setBuzzer(false);
@@ -56,19 +56,14 @@ void AlarmManager::update(float pitTemp, float meat1Temp, float meat2Temp,
         }
     }
 
-    // --- Meat 1 alarm ---
-    if (_meat1Target > 0.0f && meat1Temp > 0.0f && !_meat1Triggered) {
-        if (meat1Temp >= _meat1Target) {
-            addAlarm(AlarmType::MEAT1_DONE);
-            _meat1Triggered = true;  // Prevent re-trigger after acknowledgment
-        }
-    }
-
-    // --- Meat 2 alarm ---
-    if (_meat2Target > 0.0f && meat2Temp > 0.0f && !_meat2Triggered) {
-        if (meat2Temp >= _meat2Target) {
-            addAlarm(AlarmType::MEAT2_DONE);
-            _meat2Triggered = true;
+    // --- Meat done alarms ---
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        float temp = meatTemps[m];
+        if (_meatTarget[m] > 0.0f && temp > 0.0f && !_meatTriggered[m]) {
+            if (temp >= _meatTarget[m]) {
+                addAlarm(alarmMeatDone(m));
+                _meatTriggered[m] = true;  // Prevent re-trigger after acknowledgment
+            }
         }
     }
 
@@ -94,19 +89,11 @@ void AlarmManager::acknowledge() {
 
     // Mark current alarms as triggered so they don't re-fire
     for (uint8_t i = 0; i < _activeCount; i++) {
-        switch (_activeAlarms[i]) {
-            case AlarmType::PIT_HIGH:
-            case AlarmType::PIT_LOW:
-                _pitTriggered = true;
-                break;
-            case AlarmType::MEAT1_DONE:
-                _meat1Triggered = true;
-                break;
-            case AlarmType::MEAT2_DONE:
-                _meat2Triggered = true;
-                break;
-            default:
-                break;
+        AlarmType a = _activeAlarms[i];
+        if (a == AlarmType::PIT_HIGH || a == AlarmType::PIT_LOW) {
+            _pitTriggered = true;
+        } else if (alarmMeatIndex(a) < NUM_MEATS) {
+            _meatTriggered[alarmMeatIndex(a)] = true;
         }
     }
 
@@ -121,14 +108,10 @@ void AlarmManager::acknowledge() {
 #endif
 }
 
-void AlarmManager::setMeat1Target(float target) {
-    _meat1Target = target;
-    _meat1Triggered = false;  // Reset trigger on new target
-}
-
-void AlarmManager::setMeat2Target(float target) {
-    _meat2Target = target;
-    _meat2Triggered = false;
+void AlarmManager::setMeatTarget(uint8_t meat, float target) {
+    if (meat >= NUM_MEATS) return;
+    _meatTarget[meat] = target;
+    _meatTriggered[meat] = false;  // Reset trigger on new target
 }
 
 void AlarmManager::setPitBand(float band) {
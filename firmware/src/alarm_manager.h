@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "probe_channels.h"
 #include <stdint.h>
 
 #ifndef NATIVE_BUILD
@@ -13,11 +14,22 @@ enum class AlarmType : uint8_t {
     PIT_HIGH   = 1,   // Pit above setpoint + band
     PIT_LOW    = 2,   // Pit below setpoint - band
     MEAT1_DONE = 3,   // Meat 1 reached target
-    MEAT2_DONE = 4    // Meat 2 reached target
+    MEAT2_DONE = 4    // Meat 2 reached target; meat n is MEAT1_DONE + n - 1
 };
 
-// Maximum number of simultaneous active alarms
-#define MAX_ACTIVE_ALARMS 4
+// Done alarm for a meat probe (0 = meat1), and the meat probe an alarm is
+// for (NUM_MEATS if it isn't a done alarm)
+inline AlarmType alarmMeatDone(uint8_t meat) {
+    return (AlarmType)((uint8_t)AlarmType::MEAT1_DONE + meat);
+}
+inline uint8_t alarmMeatIndex(AlarmType type) {
+    uint8_t m = (uint8_t)type - (uint8_t)AlarmType::MEAT1_DONE;
+    return (uint8_t)type >= (uint8_t)AlarmType::MEAT1_DONE && m < NUM_MEATS ? m : NUM_MEATS;
+}
+
+// Maximum number of simultaneous active alarms: one pit alarm plus a done
+// alarm per meat probe
+#define MAX_ACTIVE_ALARMS (1 + NUM_MEATS)
 
 class AlarmManager {
 public:
@@ -26,10 +38,10 @@ public:
     // Initialize buzzer pin. Call once from setup().
     void begin();
 
-    // Check all alarm conditions. Call every loop().
+    // Check all alarm conditions. Call every loop(). meatTemps holds
+    // NUM_MEATS temperatures (&temp[PROBE_MEAT1] of a channel-indexed array).
     // pitReached: true if pit has at some point reached setpoint (for pit alarm arming)
-    void update(float pitTemp, float meat1Temp, float meat2Temp,
-                float setpoint, bool pitReached);
+    void update(float pitTemp, const float* meatTemps, float setpoint, bool pitReached);
 
     // Get array of currently active alarm types
     // Returns count of active alarms, fills the array up to maxCount
@@ -41,13 +53,9 @@ public:
     // Acknowledge/silence the current alarm(s)
     void acknowledge();
 
-    // Set meat target temperatures
-    void setMeat1Target(float target);
-    void setMeat2Target(float target);
-
-    // Get meat targets
-    float getMeat1Target() const { return _meat1Target; }
-    float getMeat2Target() const { return _meat2Target; }
+    // Meat target temperature by meat probe (0 = meat1), 0 = not set
+    void setMeatTarget(uint8_t meat, float target);
+    float getMeatTarget(uint8_t meat) const { return meat < NUM_MEATS ? _meatTarget[meat] : 0.0f; }
 
     // Set pit alarm band (+/- degrees from setpoint)
     void setPitBand(float band);
@@ -74,8 +82,7 @@ private:
     void removeAlarm(AlarmType type);
 
     // Meat targets
-    float _meat1Target;
-    float _meat2Target;
+    float _meatTarget[NUM_MEATS];
 
     // Pit band
     float _pitBand;
@@ -90,8 +97,7 @@ private:
     bool _buzzerOn;         // Current buzzer state
 
     // Hysteresis: track whether each alarm has been triggered and acknowledged
-    bool _meat1Triggered;   // Meat1 alarm has fired (prevents re-trigger after ack)
-    bool _meat2Triggered;
+    bool _meatTriggered[NUM_MEATS];   // Done alarm has fired (prevents re-trigger after ack)
     bool _pitTriggered;
 
     // Buzzer timing
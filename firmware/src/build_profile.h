@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+
+// Build profiles: the capacities and rates that trade RAM against history
+// and clients, chosen per PlatformIO env with -DBBQ_PROFILE=<id>:
+//
+//   BBQ_PROFILE_STANDARD      Stock WT32-SC01 Plus (the default)
+//   BBQ_PROFILE_LOW_MEMORY    Small rings, few sockets, no hub mode
+//   BBQ_PROFILE_MANY_CLIENTS  Competition: every phone on the team watching
+//   BBQ_PROFILE_LONG_COOK     PSRAM ring and rollups sized for multi-day cooks
+//
+// config.h maps SESSION_BUFFER_SIZE, WS_MAX_CLIENTS and the rest onto the
+// selected struct, so modules keep using the macros and size their static
+// buffers from them. A single value can still be overridden on its own
+// (-DWS_MAX_CLIENTS=6). Feature switches are macros rather than fields so
+// the code they guard drops out with #if.
+
+#define BBQ_PROFILE_STANDARD      0
+#define BBQ_PROFILE_LOW_MEMORY    1
+#define BBQ_PROFILE_MANY_CLIENTS  2
+#define BBQ_PROFILE_LONG_COOK     3
+
+#ifndef BBQ_PROFILE
+#define BBQ_PROFILE BBQ_PROFILE_STANDARD
+#endif
+
+struct BuildProfile {
+    const char* name;
+    uint16_t sessionBufferSize;          // Ring samples in internal RAM
+    uint16_t sessionRollupCapacity;      // Buckets per rollup tier in internal RAM
+    uint16_t sessionPsramBufferSize;     // Ring samples when PSRAM is found
+    uint16_t sessionPsramRollupCapacity; // Buckets per tier when PSRAM is found
+    uint16_t predictorWindowSize;        // Samples in the predictor's fit (one per 5 s)
+    uint16_t graphHistorySize;           // Display graph points
+    uint8_t  wsMaxClients;               // WebSocket clients served at once
+    uint32_t tempSampleIntervalMs;       // Probe read interval
+    uint32_t pidSampleMs;                // Default PID interval (pid.sampleMs)
+};
+
+namespace build_profiles {
+
+constexpr BuildProfile kStandard = {
+    "standard",
+    600, 360,       // 50 min ring; 6 h / 30 h / 180 h tiers
+    17280, 1440,    // 24 h ring; 24 h / 5 d / 30 d tiers
+    60,             // 5 min fit
+    240,
+    12,             // Leaves HTTP room in lwIP's 16 active TCP connections
+    1000,
+    4000,
+};
+
+constexpr BuildProfile kLowMemory = {
+    "low-memory",
+    300, 180,
+    300, 180,       // Same as internal: PSRAM, if any, isn't relied on
+    36,             // 3 min fit
+    120,
+    4,
+    1000,
+    4000,
+};
+
+constexpr BuildProfile kManyClients = {
+    "many-clients",
+    600, 360,
+    17280, 1440,
+    60,
+    240,
+    14,             // Two connections left for HTTP: API and OTA, not page loads under load
+    1000,
+    4000,
+};
+
+constexpr BuildProfile kLongCook = {
+    "long-cook",
+    600, 360,
+    34560, 2880,    // 48 h ring; 48 h / 10 d / 60 d tiers
+    120,            // 10 min fit, steadier through a long stall
+    480,
+    12,
+    1000,
+    4000,
+};
+
+// Limits every profile has to respect; checked for all of them so a bad
+// edit fails the build whichever profile is selected
+constexpr bool valid(const BuildProfile& p) {
+    return p.sessionBufferSize >= 60
+        && p.sessionPsramBufferSize >= p.sessionBufferSize
+        && p.sessionRollupCapacity >= 16
+        && p.sessionPsramRollupCapacity >= p.sessionRollupCapacity
+        && p.predictorWindowSize >= 24
+        && p.graphHistorySize >= 32 && p.graphHistorySize % 4 == 0
+        && p.wsMaxClients >= 1 && p.wsMaxClients <= 14
+        && p.tempSampleIntervalMs >= 250
+        && p.pidSampleMs >= p.tempSampleIntervalMs;
+}
+
+static_assert(valid(kStandard),    "standard build profile out of range");
+static_assert(valid(kLowMemory),   "low-memory build profile out of range");
+static_assert(valid(kManyClients), "many-clients build profile out of range");
+static_assert(valid(kLongCook),    "long-cook build profile out of range");
+
+}  // namespace build_profiles
+
+#if BBQ_PROFILE == BBQ_PROFILE_STANDARD
+constexpr BuildProfile kBuildProfile = build_profiles::kStandard;
+#elif BBQ_PROFILE == BBQ_PROFILE_LOW_MEMORY
+constexpr BuildProfile kBuildProfile = build_profiles::kLowMemory;
+#elif BBQ_PROFILE == BBQ_PROFILE_MANY_CLIENTS
+constexpr BuildProfile kBuildProfile = build_profiles::kManyClients;
+#elif BBQ_PROFILE == BBQ_PROFILE_LONG_COOK
+constexpr BuildProfile kBuildProfile = build_profiles::kLongCook;
+#else
+#error "Unknown BBQ_PROFILE"
+#endif
+
+// Hub mode (hub_manager.h): following peers and serving /api/hub
+#ifndef BBQ_FEATURE_HUB
+#define BBQ_FEATURE_HUB (BBQ_PROFILE != BBQ_PROFILE_LOW_MEMORY)
+#endif
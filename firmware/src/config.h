@@ -1,5 +1,10 @@
 #pragma once
 
+// --- Build Profile (see build_profile.h) ---
+// Capacities and rates below marked "profile" come from the selected
+// profile unless overridden individually with -D<NAME>=<value>
+#include "build_profile.h"
+
 // --- Pin Assignments (WT32-SC01 Plus Extension Connector) ---
 #define PIN_SDA         10
 #define PIN_SCL         11
@@ -14,8 +19,16 @@
 #define ADC_CHANNEL_MEAT2 2
 #define ADC_CHANNEL_SPARE 3
 
+// --- Probe Channels (see probe_channels.h) ---
+#ifndef PROBE_CHANNELS
+#define PROBE_CHANNELS  3           // 3 stock, 4 adds the spare input, 5-8 need a second ADS1115
+#endif
+
 // --- ADS1115 ---
 #define ADS1115_ADDR    0x48
+#define ADS1115_ADDR_2  0x49        // Second ADC (ADDR strapped to VDD), probe channels 4-7
+#define ADS1115_ALERT_PIN    -1     // ALERT/RDY GPIO (-1 = not wired, poll over I2C)
+#define ADS1115_TIMEOUT_MS   50     // Abandon a conversion that hasn't completed by now
 #ifndef NATIVE_BUILD
 #define ADS1115_GAIN    GAIN_ONE    // +/- 4.096V range
 #endif
@@ -34,10 +47,75 @@
 #define PID_KP          4.0
 #define PID_KI          0.02
 #define PID_KD          5.0
-#define PID_SAMPLE_MS   4000    // Compute every 4 seconds
+#ifndef PID_SAMPLE_MS
+#define PID_SAMPLE_MS   (kBuildProfile.pidSampleMs)  // Profile; default interval (pid.sampleMs in config.json)
+#endif
+#define PID_SAMPLE_MS_MIN 1000  // Fastest rate; probes update at 1 Hz
+#define PID_SAMPLE_MS_MAX 10000
+#define PID_D_FILTER_N  8.0     // Derivative low-pass at Td/N (0 = unfiltered)
 #define PID_OUTPUT_MIN  0.0
 #define PID_OUTPUT_MAX  100.0
 
+// --- PID Feed-Forward & Gain Schedule ---
+// Setpoint steps preload the output with PID_FEEDFORWARD % per degree of
+// step (the pit's steady-state output slope) instead of ramping on the
+// integrator alone. Gains are scaled by the setpoint band the setpoint
+// falls in and by the fan mode's actuator authority.
+#define PID_FEEDFORWARD         0.3     // % output per degree of setpoint step (0 = off)
+#define PID_SCHEDULE_MAX_BANDS  4
+#define PID_BAND1_MAX_SP        250.0   // Low & slow
+#define PID_BAND1_SCALE         1.0
+#define PID_BAND2_MAX_SP        300.0   // Hot & fast
+#define PID_BAND2_SCALE         0.85
+#define PID_BAND3_SCALE         0.7     // Above band 2 (searing, pizza)
+#define PID_SCALE_FAN_ONLY      0.8     // Fan pushes more air per % than the damper
+#define PID_SCALE_FAN_AND_DAMPER 1.0
+#define PID_SCALE_DAMPER_PRIMARY 1.25
+
+// --- PID Auto-Tune (relay method) ---
+#define AUTOTUNE_OUTPUT_BIAS  50.0    // Relay centre, % PID output
+#define AUTOTUNE_OUTPUT_STEP  30.0    // Relay swings bias +/- step
+#define AUTOTUNE_HYSTERESIS   2.0     // Degrees either side of setpoint before switching
+#define AUTOTUNE_CYCLES       3       // Oscillations averaged (after one discarded)
+#define AUTOTUNE_TIMEOUT_MS   (4UL * 3600UL * 1000UL)  // Give up after 4 hours
+
+// --- Control Task ---
+// Sampling, PID and actuation run pinned to CONTROL_TASK_CORE; loop() (LVGL,
+// Wi-Fi, web) runs on the other core (ARDUINO_RUNNING_CORE in platformio.ini).
+#define CONTROL_TASK_CORE      1
+#define CONTROL_TASK_PRIORITY  5      // Above loopTask (1) and async_tcp (3)
+#define CONTROL_TASK_STACK     6144
+#define CONTROL_TICK_MS        10     // 100 Hz control tick
+#define BOOT_CONTROL_FIRST     true   // Once set up, start control before the splash, Wi-Fi and web server
+
+// --- Loop Profiler ---
+// Per-phase budgets for the numbered steps of controlTick() and loop(). A
+// phase whose p99 over a window is above budget raises a LOOP_OVERRUN
+// warning until a window comes back within it (see loop_profiler.h).
+#define PROFILE_WINDOW_MS           10000  // Rolling window for max/p99
+#define PROFILE_MIN_SAMPLES         50     // Fewer samples in a window never flag
+#define PROFILE_BUDGET_TEMP_US      2000   // TempManager + predictor (I2C read)
+#define PROFILE_BUDGET_PID_US       500
+#define PROFILE_BUDGET_SPLIT_US     200
+#define PROFILE_BUDGET_FAN_US       200
+#define PROFILE_BUDGET_ALARMS_US    300
+#define PROFILE_BUDGET_ERRORS_US    300
+#define PROFILE_BUDGET_SESSION_US   20000  // Includes the periodic flash flush
+#define PROFILE_BUDGET_WEB_US       5000
+#define PROFILE_BUDGET_WIFI_US      2000
+#define PROFILE_BUDGET_OTA_US       1000
+#define PROFILE_BUDGET_DISPLAY_US   5000   // Label updates, once a second
+#define PROFILE_BUDGET_LVGL_US      15000  // ui_handler() redraw and flush
+
+// --- Warm Restart ---
+// Controller state (integrator, lid event, setpoint, targets) is checkpointed
+// to RTC memory by the control task and mirrored to flash by loop(), so a
+// reset mid-cook resumes where it left off (see controller_state.h).
+#define CONTROL_STATE_RTC_MS    1000    // RTC memory checkpoint interval
+#define CONTROL_STATE_FLASH_MS  60000   // Flash mirror interval (sooner on a setpoint/target change)
+#define CONTROL_STATE_PATH      "/ctrl.dat"
+#define PREDICTOR_WARM_POINTS   720     // Session points replayed into the predictor on restore (1 h)
+
 // --- Fan Control ---
 #define FAN_PWM_FREQ       25000   // 25 kHz
 #define FAN_PWM_CHANNEL    0
@@ -47,39 +125,147 @@
 #define FAN_MIN_SPEED      15      // Minimum sustained speed %
 #define FAN_LONGPULSE_THRESHOLD 10 // Below 10%, use long-pulse mode
 #define FAN_LONGPULSE_CYCLE_MS 10000 // 10-second cycle
+#define FAN_RAMP_MS        250     // Hardware (LEDC fade) ramp between steady speeds
+
+// --- Fan Tachometer (optional, on PIN_SPARE; see FanController::beginTach) ---
+#define FAN_TACH_PCNT_UNIT    0       // PCNT unit counting tach pulses
+#define FAN_TACH_FILTER       1000    // PCNT glitch filter, APB cycles (12.5 us)
+#define FAN_TACH_PULSES       0       // Default fan.tachPulses: pulses per revolution, 0 = no tach (PC fans: 2)
+#define FAN_TACH_MAX_RPM      3000    // Default fan.maxRpm: RPM that 100% airflow maps to
+#define FAN_TACH_WINDOW_MS    1000    // RPM measurement window
+#define FAN_TACH_SPIN_PULSES  2       // Pulses that end a kick-start early
+#define FAN_RPM_KI            0.5f    // Closed-loop trim, % duty per % RPM error per window
+#define FAN_RPM_TRIM_MAX      30.0f   // Closed-loop trim limit (+/- % duty)
+#define FAN_STALL_MS          3000    // Driven with no pulses for this long = stall (re-kicked each time)
 
 // --- Servo (Damper) ---
 #define SERVO_MIN_US    544     // 0 degrees
 #define SERVO_MAX_US    2400    // 180 degrees
 #define DAMPER_CLOSED   0       // Servo angle for closed
 #define DAMPER_OPEN     90      // Servo angle for full open
+#define SERVO_SLEW_DEG_S    60.0f   // Default damper.slewRate: max travel, deg/s (0 = unlimited)
+#define SERVO_DEADBAND_DEG  1.0f    // Target moves smaller than this are ignored
+#define SERVO_DETACH_MS     1500    // Detach this long after motion settles
 
 // --- Split-Range Fan+Damper ---
 #define FAN_ON_THRESHOLD   30   // Default fan-on threshold (runtime value from configManager)
 
+// --- Control Zones (see control_zone.h) ---
+#define CONTROL_ZONES_MAX     4        // Zone 0 (pit, PIN_FAN_PWM, PIN_SERVO) + 3 from config.json "zones"
+#define ZONE_DEFAULT_SETPOINT 225.0f   // Setpoint of a zone until one is set
+#define ZONE_REACHED_BAND     5.0f     // Within this of the setpoint counts as reached (arms pit-band alarms)
+
 // --- Temperature Reading ---
-#define TEMP_SAMPLE_INTERVAL_MS  1000   // Read probes every 1 second
-#define TEMP_AVG_SAMPLES         4      // Average 4 readings
+#ifndef TEMP_SAMPLE_INTERVAL_MS
+#define TEMP_SAMPLE_INTERVAL_MS  (kBuildProfile.tempSampleIntervalMs)  // Profile; 1 s stock
+#endif
+#define TEMP_AVG_SAMPLES         5      // Conversions per probe per sample (median/trimmed-mean ring, max 8)
+#define TEMP_TRIM_COUNT          1      // Trimmed mean: readings dropped from each end
+#define TEMP_LUT_ENABLED         true   // Convert via precomputed raw->C table instead of logf per sample
+#define TEMP_LUT_SHIFT           6      // Table step = 2^6 ADC counts (513 entries/probe, <0.1C error)
 #define TEMP_EMA_ALPHA           0.2    // EMA smoothing factor (lower = smoother, less derivative noise)
 
+// --- Probe Calibration (see probe_calibration.h) ---
+#define CAL_MAX_POINTS          3        // Reference points per probe (1 = A only, 2 = A+B, 3 = A+B+C)
+#define CAL_STABLE_SAMPLES      30       // Readings (one per TEMP_SAMPLE_INTERVAL_MS) that must agree
+#define CAL_STABLE_SPREAD_C     0.3f     // ...to within this (max - min, deg C)
+#define CAL_CAPTURE_TIMEOUT_MS  300000   // Give up on a capture that never settles (5 min)
+#define CAL_MIN_SPREAD_C        10.0f    // Reference points at least this far apart
+#define CAL_FIT_TOLERANCE_C     0.5f     // Solved curve must reproduce every point to within this
+#define CAL_R_MIN               100.0    // Resistance range (ohms) the curve must stay monotonic over
+#define CAL_R_MAX               1000000.0
+
 // --- Lid-Open Detection ---
 #define LID_OPEN_DROP_PCT   6    // 6% drop below setpoint triggers lid-open
 #define LID_OPEN_RECOVER_PCT 2   // Recovered when within 2% of setpoint
+#define LID_DROP_RATE       30.0 // Deg/min fall over two samples marks the lid opening early
+#define LID_DROP_MIN_DEG    5.0  // ...once the pit is at least this far below setpoint
+#define LID_RECOVERY_TAU_S      300.0   // Natural recovery time constant until one is learned
+#define LID_RECOVERY_TAU_MIN_S  60.0
+#define LID_RECOVERY_TAU_MAX_S  1800.0
+#define LID_RECOVERY_LAG_FRAC   0.25    // PID takes over when recovery lags the prediction by this much of the drop
+#define LID_EVENT_TIMEOUT_MS    (15UL * 60UL * 1000UL)  // Give the pit back to the PID after 15 min regardless
 
 // --- Cook Session ---
-#define SESSION_BUFFER_SIZE     600     // RAM buffer samples
+#ifndef SESSION_BUFFER_SIZE
+#define SESSION_BUFFER_SIZE     (kBuildProfile.sessionBufferSize)  // Profile; RAM buffer samples (internal SRAM)
+#endif
 #define SESSION_SAMPLE_INTERVAL 5000    // 5 seconds between data points
 #define SESSION_FLUSH_INTERVAL  60000   // Flush to LittleFS every 60 seconds
-#define SESSION_FILE_PATH       "/session.dat"
+#define SESSION_FILE_PATH       "/session.dat"   // Pre-log flat file, removed with the session
+#define SESSION_LOG_PATH        "/session_%03u.log"  // Log segment, %u = segment 0..
+#define SESSION_BLOCK_BYTES     256     // Log block = one flash page, written in one go
+#define SESSION_SEGMENT_BLOCKS  64      // Blocks per segment file (16 KB)
+#define SESSION_LOG_MAX_SEGMENTS 64     // 1 MB of log per cook
+#define SESSION_ARCHIVE_DIR     "/cooks"
+#define SESSION_ARCHIVE_INDEX   "/cooks/index.dat"
+#define SESSION_ARCHIVE_LOG_PATH    "/cooks/%u_%03u.log"  // %u = cook id, segment
+#define SESSION_ARCHIVE_ROLLUP_PATH "/cooks/%u_r%u.dat"   // %u = cook id, level
+#define SESSION_ARCHIVE_MAX     32      // Past cooks kept
+#define SESSION_ARCHIVE_BUDGET  (2UL * 1024UL * 1024UL)   // Flash for past cooks (of ~3.4 MB LittleFS)
+#define SESSION_READ_PAGE       32      // Points per page when walking the full cook
+#define SESSION_ROLLUP_LEVELS   3       // Downsampled tiers kept alongside the raw points
+#define SESSION_ROLLUP_FACTORS  { 12, 60, 360 }  // Samples per bucket: 1, 5, 30 min
+#ifndef SESSION_ROLLUP_CAPACITY
+#define SESSION_ROLLUP_CAPACITY (kBuildProfile.sessionRollupCapacity)  // Profile; buckets kept per tier
+#endif
+#define SESSION_ROLLUP_PATH     "/session_r%u.dat"  // Per-tier file, %u = level 1..3
+#define SESSION_EVENT_CAPACITY  256     // Journalled setpoint/target/fan-mode/lid/ack events per cook
+#define SESSION_EVENT_PATH      "/session_ev.dat"
+#define SESSION_ARCHIVE_EVENT_PATH  "/cooks/%u_ev.dat"    // %u = cook id
+
+// With PSRAM the ring holds a day or more, so history replay and export
+// rarely touch flash, and the rollup tiers cover much longer cooks.
+// Falls back to the sizes above when the board has no PSRAM.
+#ifdef BOARD_HAS_PSRAM
+#define SESSION_USE_PSRAM       true    // Ring, rollup tiers and replay scratch in PSRAM
+#else
+#define SESSION_USE_PSRAM       false
+#endif
+#ifndef SESSION_PSRAM_BUFFER_SIZE
+#define SESSION_PSRAM_BUFFER_SIZE     (kBuildProfile.sessionPsramBufferSize)      // Profile; 24 h at 5 s stock
+#endif
+#ifndef SESSION_PSRAM_ROLLUP_CAPACITY
+#define SESSION_PSRAM_ROLLUP_CAPACITY (kBuildProfile.sessionPsramRollupCapacity)  // Profile; 24 h / 5 d / 30 d stock
+#endif
 
 // --- Config ---
 #define CONFIG_FILE_PATH  "/config.json"
+#define CONFIG_SAVE_DEBOUNCE_MS   2000    // Save once changes have been quiet this long
+#define CONFIG_SAVE_MAX_DELAY_MS  10000   // ...or this long after the first unsaved change
 
 // --- Web Server ---
 #define WEB_PORT          80
 #define WS_PATH           "/ws"
-#define WS_MAX_CLIENTS    4
+#ifndef WS_MAX_CLIENTS
+#define WS_MAX_CLIENTS    (kBuildProfile.wsMaxClients)  // Profile; 12 stock leaves HTTP room in lwIP's 16
+#endif
 #define WS_SEND_INTERVAL  1500   // Send data every 1.5 seconds
+#define WS_BINARY_KEYFRAME_EVERY 20  // Full binary frame every N sends (~30 s) to bound drift
+#define WS_HISTORY_CHUNK_POINTS  24  // History points per replay chunk
+#define WS_HISTORY_MAX_POINTS  1500  // Replay LOD budget until the client reports its chart width
+#define WS_HISTORY_CHUNK_BYTES   (HISTORY_HEADER_MAX_BYTES + WS_HISTORY_CHUNK_POINTS * HISTORY_POINT_MAX_BYTES)
+#define WS_HELLO_WAIT_MS   500   // Replay on connect waits this long for the client's hello
+#define WS_RESUME_MAX_POINTS 720 // Longest tail (1 h of points) resumed instead of a full replay
+#define WS_RATE_MAX_MS   60000   // Slowest data interval a client may request
+#define WS_QUEUE_BUDGET  16384   // Unacked bytes across all clients before frames are skipped
+#define WS_EVENT_QUEUE   32      // Connects, hellos and disconnects waiting for update() (power of two)
+#define SSE_PATH         "/api/stream"
+#define SSE_MAX_CLIENTS  2       // Event-stream viewers (share the 16 TCP connections)
+#define SSE_MAX_BACKLOG  4       // Average queued events per viewer before frames are skipped
+#define WEB_ASSET_MANIFEST "/assets.etag"  // "<path> <etag>" lines written by web_assets.py
+#define WEB_ASSET_MAX      12            // Static assets served with ETags
+#define WEB_ASSET_PATH_LEN 32
+#define WEB_ASSET_ETAG_LEN 16            // Hex digits of the content hash
+#define WEB_ASSET_MAX_AGE  31536000      // Cache lifetime of ?v=<etag> URLs (1 year)
+
+// --- Wi-Fi Connection (see wifi_link.h) ---
+#define WIFI_CONNECT_TIMEOUT_MS  15000  // An attempt with no IP by now has failed
+#define WIFI_BOOT_ATTEMPTS       3      // Failed attempts before the first connection -> AP mode
+#define WIFI_RECONNECT_ATTEMPTS  20     // Failed attempts after losing a connection -> AP mode
+#define WIFI_RECONNECT_BASE_MS   5000   // First retry delay, doubled per failure
+#define WIFI_RECONNECT_MAX_MS    60000  // Retry delay cap
+#define WIFI_AP_SETTLE_MS        100    // Radio off before the setup portal starts
 
 // --- Alarms ---
 #define ALARM_PIT_BAND_DEFAULT  15.0    // +/- 15F
@@ -87,15 +273,119 @@
 #define ALARM_BUZZER_DURATION   500     // 500ms beep
 #define ALARM_BUZZER_PAUSE      500     // 500ms pause between beeps
 
+// --- Notifications (see notify_queue.h) ---
+// Alarm and error onsets are queued by loop() and delivered by a background
+// task, so a slow or dead network never holds up the buzzer or the UI.
+#define NOTIFY_QUEUE_LEN        8       // Pending notifications; newest dropped when full
+#define NOTIFY_MAX_ATTEMPTS     5       // Per sink, before a notification is given up
+#define NOTIFY_RETRY_BASE_MS    2000    // First retry delay, doubled per failure
+#define NOTIFY_RETRY_MAX_MS     60000
+#define NOTIFY_MAX_AGE_MS       600000  // Undelivered after 10 min -> stale, dropped
+#define NOTIFY_RATE_BURST       5       // Per sink: sends allowed back to back...
+#define NOTIFY_RATE_REFILL_MS   12000   // ...then one per this long (5/min)
+#define NOTIFY_IDLE_MS          1000    // Task wakes at least this often
+#define NOTIFY_HTTP_TIMEOUT_MS  5000
+#define NOTIFY_TASK_STACK       8192    // TLS handshake needs the room
+#define NOTIFY_TASK_PRIORITY    1       // Same as loopTask, below async_tcp and control
+#define NOTIFY_TASK_CORE        0
+#define NOTIFY_PUSHOVER_URL     "https://api.pushover.net/1/messages.json"
+
+// --- MQTT Telemetry (see mqtt_batch.h) ---
+#define MQTT_PORT_DEFAULT        1883
+#define MQTT_BASE_TOPIC_DEFAULT  "pitclaw"  // Topics are <base>/<device id>/...
+#define MQTT_INTERVAL_DEFAULT_MS 5000   // Telemetry sample interval
+#define MQTT_BATCH_MAX           32     // Samples per publish when the link falls behind
+#define MQTT_BATCH_BYTES         2048   // Batch buffer (room for a worst-case frame is kept free)
+#define MQTT_ACK_TIMEOUT_MS      10000  // QoS 1 publish with no PUBACK by now is treated as lost
+#define MQTT_RETRY_MS            500    // Wait after the client refuses a publish (send buffer full)
+#define MQTT_RECONNECT_MS        10000  // Broker reconnect interval
+#define MQTT_KEEPALIVE_S         30
+#define MQTT_BACKFILL_MAX_S      3600   // Oldest gap replayed from the session log after an outage
+#define MQTT_EVENT_MAX_BYTES     512    // Notification JSON handed over by the notifier task
+
+// --- Hub Mode (see hub_peers.h) ---
+// One unit (or the desktop simulator) can gather the others' streams and
+// serve them as one merged view, so phones connect once.
+#define HUB_MAX_PEERS            6
+#define HUB_CONFIG_PEERS         4      // Fixed peers in config.json, for networks without mDNS
+#define HUB_NAME_LEN             24     // Peer's mDNS host name
+#define HUB_HOST_LEN             40     // Address the hub connects to (IP or name)
+#define HUB_DISCOVER_MS          30000  // mDNS browse interval
+#define HUB_PEER_EXPIRE_MS       120000 // Discovered peer gone this long (no answer, no data) -> forgotten
+#define HUB_PEER_STALE_MS        10000  // No data frame this long -> offline, reconnect
+#define HUB_RETRY_BASE_MS        5000   // First reconnect delay, doubled per failure
+#define HUB_RETRY_MAX_MS         60000
+#define HUB_CONNECT_TIMEOUT_MS   2000
+#define HUB_POLL_MS              2000   // Simulator hub: /api/state poll interval per peer
+#define HUB_HISTORY_POINTS       180    // Per peer, one point per HUB_HISTORY_INTERVAL_S (3 h)
+#define HUB_HISTORY_INTERVAL_S   60
+#define HUB_TASK_POLL_MS         50     // Peer streams are read this often
+#define HUB_TASK_STACK           6144
+#define HUB_TASK_PRIORITY        1      // Same as loopTask and notify
+#define HUB_TASK_CORE            0
+#define HUB_MDNS_TXT_KEY         "pitclaw"  // TXT record that marks a Pit Claw's _http._tcp service
+
+// --- OTA Updates (see ota_stream.h, ota_manager.h) ---
+// Uploaded and pulled images are inflated and written to flash by a
+// background task, so async_tcp and loop() only ever copy bytes.
+#define OTA_WINDOW_SIZE          32768  // Deflate window (PSRAM), power of two
+#define OTA_WRITE_CHUNK          4096   // Flash write size, one sector
+#define OTA_INPUT_BUFFER         16384  // Uploaded bytes waiting for the task (PSRAM)
+#define OTA_READ_CHUNK           1024   // Task reads the input buffer or socket this much at a time
+#define OTA_BODY_WAIT_MS         50     // async_tcp waits at most this long for input buffer room
+#define OTA_IDLE_TIMEOUT_MS      600000 // Upload with no new bytes for 10 min -> abandoned
+#define OTA_URL_LEN              256
+#define OTA_PULL_RETRIES         5      // Dropped pull resumed with a Range request this many times
+#define OTA_PULL_RETRY_MS        5000
+#define OTA_HTTP_TIMEOUT_MS      15000  // Pull with no bytes this long -> dropped, retried
+#define OTA_RESTART_DELAY_MS     1500   // After success, so a status poll sees "done"
+#define OTA_TASK_STACK           8192   // TLS handshake for https pulls
+#define OTA_TASK_PRIORITY        1      // Same as loopTask, below async_tcp and control
+#define OTA_TASK_CORE            0
+
 // --- Error Detection ---
 #define ERROR_PROBE_OPEN_THRESHOLD   32000  // ADC value indicating open circuit
 #define ERROR_PROBE_SHORT_THRESHOLD  100    // ADC value indicating short
-#define ERROR_FIREOUT_RATE           2.0    // Degrees F per minute decline
-#define ERROR_FIREOUT_DURATION_MS    600000 // 10 minutes of decline
+#define ERROR_FIREOUT_RATE           2.0    // Degrees per minute of decline at full output
+
+// --- Trend Warnings (see trend_monitor.h) ---
+// Leading indicators from rolling regressions on the pit and the PID output
+#define TREND_SAMPLE_MS          10000  // Pit and output sampled this often
+#define TREND_SHORT_WINDOW       12     // Samples (2 min): pit slope and output saturation
+#define TREND_LONG_WINDOW        60     // Samples (10 min): output trend for fuel low
+#define TREND_MIN_SAMPLES        9      // 90 s of the short window before judging fire-out
+#define TREND_SATURATED_PCT      95.0f  // Mean output at or above this has nothing left to give
+#define TREND_SATURATED_EXIT_PCT 85.0f  // Fire-out clears below this (or once the pit stops falling)
+#define TREND_FUEL_DUTY_PCT      60.0f  // Fuel low: long-window mean output above this...
+#define TREND_FUEL_RISE_PCT_MIN  1.0f   // ...climbing at least this fast (%/min)...
+#define TREND_FUEL_BAND          15.0f  // ...while the pit holds within this of the setpoint
+#define TREND_DONE_SOON_SEC      900    // Meat pre-alarm lead (15 min)
 
 // --- Display ---
 #define DISPLAY_WIDTH   480
 #define DISPLAY_HEIGHT  320
+#define GRAPH_CONDENSE_ENVELOPE true  // Graph condense keeps min/max per bucket (false = pairwise average)
+#define GRAPH_REBUILD_MAX_POINTS 2880 // Finest session level fed to the boot-time graph bulk load
+#define DISPLAY_DMA_FLUSH   true      // i8080 DMA flush via esp_lcd (false = blocking TFT_eSPI pushColors)
+#define DISPLAY_BUF_LINES   40        // Lines per partial draw buffer (two are allocated)
+#define DISPLAY_BUF_PSRAM   false     // Draw buffers in PSRAM instead of internal DMA-capable SRAM
+#define DISPLAY_PCLK_HZ     20000000  // i8080 write clock (drop to ~10 MHz with PSRAM buffers)
+#define UI_FREE_SCREENS_BELOW 8192   // Free LVGL heap (bytes) below which hidden graph/settings screens and modals are deleted (0 = keep)
+#define UI_MEM_CHECK_MS       1000   // LVGL heap check interval
+
+// --- Display Bus (WT32-SC01 Plus ST7796, 8-bit i8080) ---
+#define PIN_LCD_D0   9
+#define PIN_LCD_D1   46
+#define PIN_LCD_D2   3
+#define PIN_LCD_D3   8
+#define PIN_LCD_D4   18
+#define PIN_LCD_D5   17
+#define PIN_LCD_D6   16
+#define PIN_LCD_D7   15
+#define PIN_LCD_WR   47
+#define PIN_LCD_DC   0
+#define PIN_LCD_RST  4
+#define PIN_LCD_BL   45
 
 // --- Misc ---
 #define WIFI_HOSTNAME       "bbq"
@@ -1,4 +1,5 @@
 #include "config_manager.h"
+#include "cook_session.h"
 #include <string.h>
 
 #ifndef NATIVE_BUILD
@@ -12,8 +13,25 @@ const ProbeSettings ConfigManager::_defaultProbe = {
 
 ConfigManager::ConfigManager()
     : _mounted(false)
+    , _changeSeq(0)
+    , _savedSeq(0)
+    , _firstChangeMs(0)
+    , _lastChangeMs(0)
+#ifdef NATIVE_BUILD
+    , _testNowMs(0)
+    , _testWriteFails(false)
+#endif
 {
     applyDefaults();
+    _saved = _config;
+}
+
+unsigned long ConfigManager::nowMs() const {
+#ifndef NATIVE_BUILD
+    return millis();
+#else
+    return _testNowMs;
+#endif
 }
 
 bool ConfigManager::begin() {
@@ -26,10 +44,14 @@ bool ConfigManager::begin() {
     _mounted = true;
     Serial.println("[CFG] LittleFS mounted.");
 
+    // Left behind by a save interrupted before its rename
+    if (LittleFS.exists(CONFIG_FILE_PATH ".tmp")) LittleFS.remove(CONFIG_FILE_PATH ".tmp");
+
     if (!load()) {
         Serial.println("[CFG] No valid config found, creating defaults.");
         applyDefaults();
-        save();
+        writeFile(_config);
+        _saved = _config;
     } else {
         Serial.println("[CFG] Configuration loaded from flash.");
     }
@@ -38,13 +60,51 @@ bool ConfigManager::begin() {
 }
 
 bool ConfigManager::save() {
+    return saveSnapshot(_config, _changeSeq);
+}
+
+void ConfigManager::markDirty() {
+    unsigned long now = nowMs();
+    if (!isDirty()) _firstChangeMs = now;
+    _lastChangeMs = now;
+    _changeSeq = _changeSeq + 1;
+}
+
+bool ConfigManager::saveDue(unsigned long now) const {
+    if (!isDirty()) return false;
+    return now - _lastChangeMs >= CONFIG_SAVE_DEBOUNCE_MS ||
+           now - _firstChangeMs >= CONFIG_SAVE_MAX_DELAY_MS;
+}
+
+bool ConfigManager::saveSnapshot(const AppConfig& snapshot, uint32_t seq) {
+    // Changed and changed back since the last write: nothing to do
+    if (memcmp(&snapshot, &_saved, sizeof(AppConfig)) == 0) {
+        _savedSeq = seq;
+        return true;
+    }
+
+    if (!writeFile(snapshot)) {
+        // Still dirty: start the debounce over, so the next try waits
+        // CONFIG_SAVE_DEBOUNCE_MS instead of coming on the next loop pass
+        _firstChangeMs = _lastChangeMs = nowMs();
+        return false;
+    }
+    _saved = snapshot;
+    _savedSeq = seq;
+    return true;
+}
+
+bool ConfigManager::writeFile(const AppConfig& config) {
 #ifndef NATIVE_BUILD
     if (!_mounted) return false;
 
+    // Serialized from the snapshot, not _config, which may be changing under us
     JsonDocument doc;
-    toJson(doc);
+    toJson(config, doc);
 
-    File file = LittleFS.open(CONFIG_FILE_PATH, "w");
+    // Write aside and rename over, so a power cut keeps the previous file
+    static const char* tmp = CONFIG_FILE_PATH ".tmp";
+    File file = LittleFS.open(tmp, "w");
     if (!file) {
         Serial.println("[CFG] Failed to open config file for writing!");
         return false;
@@ -52,11 +112,17 @@ bool ConfigManager::save() {
 
     size_t written = serializeJson(doc, file);
     file.close();
+    if (written == 0 || !LittleFS.rename(tmp, CONFIG_FILE_PATH)) {
+        LittleFS.remove(tmp);
+        Serial.println("[CFG] Config save failed!");
+        return false;
+    }
 
     Serial.printf("[CFG] Config saved (%u bytes).\n", (unsigned)written);
-    return written > 0;
-#else
     return true;
+#else
+    (void)config;
+    return !_testWriteFails;
 #endif
 }
 
@@ -79,6 +145,8 @@ bool ConfigManager::load() {
     }
 
     fromJson(doc);
+    _saved = _config;
+    _savedSeq = _changeSeq;
     return true;
 #else
     return false;
@@ -90,7 +158,9 @@ void ConfigManager::factoryReset() {
     Serial.println("[CFG] Factory reset! Deleting config and rebooting...");
     if (_mounted) {
         LittleFS.remove(CONFIG_FILE_PATH);
-        LittleFS.remove(SESSION_FILE_PATH);
+        CookSession::removeStoredData();
+        CookSession::removeArchive();
+        LittleFS.remove(CONTROL_STATE_PATH);
     }
     delay(500);
     ESP.restart();
@@ -99,76 +169,90 @@ void ConfigManager::factoryReset() {
 
 void ConfigManager::resetDefaults() {
     applyDefaults();
+    markDirty();
+}
+
+void ConfigManager::setString(char* field, size_t size, const char* value) {
+    char buf[CFG_KEY_MAX_LEN];
+    if (size > sizeof(buf)) size = sizeof(buf);
+    // strncpy zero-fills, so equal fields compare equal byte for byte
+    strncpy(buf, value ? value : "", size - 1);
+    buf[size - 1] = '\0';
+    if (strcmp(field, buf) == 0) return;
+    memcpy(field, buf, size);
+    markDirty();
 }
 
 void ConfigManager::setWifiCredentials(const char* ssid, const char* password) {
-    strncpy(_config.wifi.ssid, ssid ? ssid : "", CFG_SSID_MAX_LEN - 1);
-    _config.wifi.ssid[CFG_SSID_MAX_LEN - 1] = '\0';
-    strncpy(_config.wifi.password, password ? password : "", CFG_PASSWORD_MAX_LEN - 1);
-    _config.wifi.password[CFG_PASSWORD_MAX_LEN - 1] = '\0';
+    setString(_config.wifi.ssid, CFG_SSID_MAX_LEN, ssid);
+    setString(_config.wifi.password, CFG_PASSWORD_MAX_LEN, password);
 }
 
 void ConfigManager::setUnits(const char* units) {
-    strncpy(_config.units, units ? units : "F", sizeof(_config.units) - 1);
-    _config.units[sizeof(_config.units) - 1] = '\0';
+    setString(_config.units, sizeof(_config.units), units ? units : "F");
 }
 
 void ConfigManager::setPidTunings(float kp, float ki, float kd) {
-    _config.pid.kp = kp;
-    _config.pid.ki = ki;
-    _config.pid.kd = kd;
+    setField(_config.pid.kp, kp);
+    setField(_config.pid.ki, ki);
+    setField(_config.pid.kd, kd);
+}
+
+void ConfigManager::setFanMode(FanMode mode) {
+    setField(_config.fan.mode, mode);
 }
 
 void ConfigManager::setFanMode(const char* mode) {
-    strncpy(_config.fan.mode, mode ? mode : "fan_and_damper", CFG_NAME_MAX_LEN - 1);
-    _config.fan.mode[CFG_NAME_MAX_LEN - 1] = '\0';
+    setFanMode(fanModeParse(mode));
 }
 
 void ConfigManager::setFanMinSpeed(float minSpeed) {
-    _config.fan.minSpeed = minSpeed;
+    setField(_config.fan.minSpeed, minSpeed);
 }
 
 void ConfigManager::setFanOnThreshold(float threshold) {
-    _config.fan.fanOnThreshold = threshold;
+    setField(_config.fan.fanOnThreshold, threshold);
 }
 
 const ProbeSettings& ConfigManager::getProbeSettings(uint8_t probe) const {
-    if (probe >= 3) return _defaultProbe;
+    if (probe >= NUM_PROBES) return _defaultProbe;
     return _config.probes[probe];
 }
 
 void ConfigManager::setProbeName(uint8_t probe, const char* name) {
-    if (probe >= 3) return;
-    strncpy(_config.probes[probe].name, name ? name : "", CFG_NAME_MAX_LEN - 1);
-    _config.probes[probe].name[CFG_NAME_MAX_LEN - 1] = '\0';
+    if (probe >= NUM_PROBES) return;
+    setString(_config.probes[probe].name, CFG_NAME_MAX_LEN, name);
 }
 
 void ConfigManager::setProbeCoefficients(uint8_t probe, float a, float b, float c) {
-    if (probe >= 3) return;
-    _config.probes[probe].a = a;
-    _config.probes[probe].b = b;
-    _config.probes[probe].c = c;
+    if (probe >= NUM_PROBES) return;
+    setField(_config.probes[probe].a, a);
+    setField(_config.probes[probe].b, b);
+    setField(_config.probes[probe].c, c);
 }
 
 void ConfigManager::setProbeOffset(uint8_t probe, float offset) {
-    if (probe >= 3) return;
-    _config.probes[probe].offset = offset;
+    if (probe >= NUM_PROBES) return;
+    setField(_config.probes[probe].offset, offset);
 }
 
 void ConfigManager::setAlarmPitBand(float band) {
-    _config.alarms.pitBand = band;
+    setField(_config.alarms.pitBand, band);
 }
 
 void ConfigManager::setPushoverSettings(bool enabled, const char* userKey, const char* apiToken) {
-    _config.alarms.pushover.enabled = enabled;
-    strncpy(_config.alarms.pushover.userKey, userKey ? userKey : "", CFG_KEY_MAX_LEN - 1);
-    _config.alarms.pushover.userKey[CFG_KEY_MAX_LEN - 1] = '\0';
-    strncpy(_config.alarms.pushover.apiToken, apiToken ? apiToken : "", CFG_KEY_MAX_LEN - 1);
-    _config.alarms.pushover.apiToken[CFG_KEY_MAX_LEN - 1] = '\0';
+    setField(_config.alarms.pushover.enabled, enabled);
+    setString(_config.alarms.pushover.userKey, CFG_KEY_MAX_LEN, userKey);
+    setString(_config.alarms.pushover.apiToken, CFG_KEY_MAX_LEN, apiToken);
+}
+
+void ConfigManager::setWebhookSettings(bool enabled, const char* url) {
+    setField(_config.alarms.webhook.enabled, enabled);
+    setString(_config.alarms.webhook.url, CFG_URL_MAX_LEN, url);
 }
 
 void ConfigManager::setSetupComplete(bool complete) {
-    _config.setupComplete = complete;
+    setField(_config.setupComplete, complete);
 }
 
 void ConfigManager::applyDefaults() {
@@ -185,16 +269,24 @@ void ConfigManager::applyDefaults() {
     _config.pid.kp = PID_KP;
     _config.pid.ki = PID_KI;
     _config.pid.kd = PID_KD;
+    _config.pid.sampleMs = PID_SAMPLE_MS;
+    _config.pid.dFilterN = PID_D_FILTER_N;
+    _config.pid.feedForward = PID_FEEDFORWARD;
+    _config.pid.schedule = pidScheduleDefaults();
 
     // Fan
-    strncpy(_config.fan.mode, "fan_and_damper", CFG_NAME_MAX_LEN);
+    _config.fan.mode = FAN_MODE_DEFAULT;
     _config.fan.minSpeed = FAN_MIN_SPEED;
     _config.fan.fanOnThreshold = FAN_ON_THRESHOLD;
+    _config.fan.tachPulses = FAN_TACH_PULSES;
+    _config.fan.maxRpm = FAN_TACH_MAX_RPM;
+
+    // Damper
+    _config.damper.slewRate = SERVO_SLEW_DEG_S;
 
     // Probes
-    const char* probeNames[] = {"Pit", "Meat 1", "Meat 2"};
-    for (int i = 0; i < 3; i++) {
-        strncpy(_config.probes[i].name, probeNames[i], CFG_NAME_MAX_LEN - 1);
+    for (int i = 0; i < NUM_PROBES; i++) {
+        strncpy(_config.probes[i].name, kProbeChannels[i].label, CFG_NAME_MAX_LEN - 1);
         _config.probes[i].name[CFG_NAME_MAX_LEN - 1] = '\0';
         _config.probes[i].a = THERM_A;
         _config.probes[i].b = THERM_B;
@@ -207,54 +299,131 @@ void ConfigManager::applyDefaults() {
     _config.alarms.pushover.enabled = false;
     _config.alarms.pushover.userKey[0] = '\0';
     _config.alarms.pushover.apiToken[0] = '\0';
+    _config.alarms.webhook.enabled = false;
+    _config.alarms.webhook.url[0] = '\0';
+    _config.alarms.webhook.insecure = false;
+
+    // MQTT
+    memset(&_config.mqtt, 0, sizeof(_config.mqtt));
+    _config.mqtt.port = MQTT_PORT_DEFAULT;
+    strncpy(_config.mqtt.baseTopic, MQTT_BASE_TOPIC_DEFAULT, CFG_NAME_MAX_LEN - 1);
+    _config.mqtt.intervalMs = MQTT_INTERVAL_DEFAULT_MS;
+    _config.mqtt.qos = 1;
+
+    // Hub
+    memset(&_config.hub, 0, sizeof(_config.hub));
+
+    // OTA
+    _config.ota.insecure = false;
+
+    // Control zones: only the stock one
+    memset(_config.zones, 0, sizeof(_config.zones));
+    _config.zoneCount = 0;
 
     // Setup
     _config.setupComplete = false;
 }
 
-void ConfigManager::toJson(JsonDocument& doc) const {
+void ConfigManager::toJson(const AppConfig& config, JsonDocument& doc) {
     // WiFi
     JsonObject wifi = doc["wifi"].to<JsonObject>();
-    wifi["ssid"] = _config.wifi.ssid;
-    wifi["password"] = _config.wifi.password;
+    wifi["ssid"] = config.wifi.ssid;
+    wifi["password"] = config.wifi.password;
 
     // Units
-    doc["units"] = _config.units;
+    doc["units"] = config.units;
 
     // PID
     JsonObject pid = doc["pid"].to<JsonObject>();
-    pid["p"] = _config.pid.kp;
-    pid["i"] = _config.pid.ki;
-    pid["d"] = _config.pid.kd;
+    pid["p"] = config.pid.kp;
+    pid["i"] = config.pid.ki;
+    pid["d"] = config.pid.kd;
+    pid["sampleMs"] = config.pid.sampleMs;
+    pid["dFilterN"] = config.pid.dFilterN;
+    pid["ff"] = config.pid.feedForward;
+    JsonObject sched = pid["schedule"].to<JsonObject>();
+    sched["enabled"] = config.pid.schedule.enabled;
+    JsonArray bands = sched["bands"].to<JsonArray>();
+    for (uint8_t i = 0; i < config.pid.schedule.bandCount; i++) {
+        JsonObject b = bands.add<JsonObject>();
+        b["maxSp"] = config.pid.schedule.bands[i].maxSetpoint;
+        b["scale"] = config.pid.schedule.bands[i].scale;
+    }
+    JsonObject modes = sched["modes"].to<JsonObject>();
+    modes["fan_only"] = config.pid.schedule.fanOnlyScale;
+    modes["fan_and_damper"] = config.pid.schedule.fanAndDamperScale;
+    modes["damper_primary"] = config.pid.schedule.damperPrimaryScale;
 
     // Fan
     JsonObject fan = doc["fan"].to<JsonObject>();
-    fan["mode"] = _config.fan.mode;
-    fan["minSpeed"] = _config.fan.minSpeed;
-    fan["fanOnThreshold"] = _config.fan.fanOnThreshold;
+    fan["mode"] = fanModeName(config.fan.mode);
+    fan["minSpeed"] = config.fan.minSpeed;
+    fan["fanOnThreshold"] = config.fan.fanOnThreshold;
+    fan["tachPulses"] = config.fan.tachPulses;
+    fan["maxRpm"] = config.fan.maxRpm;
+
+    // Damper
+    doc["damper"]["slewRate"] = config.damper.slewRate;
 
     // Probes
     JsonObject probes = doc["probes"].to<JsonObject>();
-    const char* probeKeys[] = {"pit", "meat1", "meat2"};
-    for (int i = 0; i < 3; i++) {
-        JsonObject p = probes[probeKeys[i]].to<JsonObject>();
-        p["name"] = _config.probes[i].name;
-        p["a"] = _config.probes[i].a;
-        p["b"] = _config.probes[i].b;
-        p["c"] = _config.probes[i].c;
-        p["offset"] = _config.probes[i].offset;
+    for (int i = 0; i < NUM_PROBES; i++) {
+        JsonObject p = probes[kProbeChannels[i].key].to<JsonObject>();
+        p["name"] = config.probes[i].name;
+        p["a"] = config.probes[i].a;
+        p["b"] = config.probes[i].b;
+        p["c"] = config.probes[i].c;
+        p["offset"] = config.probes[i].offset;
     }
 
     // Alarms
     JsonObject alarms = doc["alarms"].to<JsonObject>();
-    alarms["pitBand"] = _config.alarms.pitBand;
+    alarms["pitBand"] = config.alarms.pitBand;
     JsonObject pushover = alarms["pushover"].to<JsonObject>();
-    pushover["enabled"] = _config.alarms.pushover.enabled;
-    pushover["userKey"] = _config.alarms.pushover.userKey;
-    pushover["apiToken"] = _config.alarms.pushover.apiToken;
+    pushover["enabled"] = config.alarms.pushover.enabled;
+    pushover["userKey"] = config.alarms.pushover.userKey;
+    pushover["apiToken"] = config.alarms.pushover.apiToken;
+    JsonObject webhook = alarms["webhook"].to<JsonObject>();
+    webhook["enabled"] = config.alarms.webhook.enabled;
+    webhook["url"] = config.alarms.webhook.url;
+    webhook["insecure"] = config.alarms.webhook.insecure;
+
+    // MQTT
+    JsonObject mqtt = doc["mqtt"].to<JsonObject>();
+    mqtt["enabled"] = config.mqtt.enabled;
+    mqtt["host"] = config.mqtt.host;
+    mqtt["port"] = config.mqtt.port;
+    mqtt["user"] = config.mqtt.user;
+    mqtt["password"] = config.mqtt.password;
+    mqtt["baseTopic"] = config.mqtt.baseTopic;
+    mqtt["intervalMs"] = config.mqtt.intervalMs;
+    mqtt["qos"] = config.mqtt.qos;
+
+    // Hub
+    JsonObject hub = doc["hub"].to<JsonObject>();
+    hub["enabled"] = config.hub.enabled;
+    JsonArray hubPeers = hub["peers"].to<JsonArray>();
+    for (uint8_t i = 0; i < config.hub.peerCount; i++) {
+        hubPeers.add(config.hub.peers[i]);
+    }
+
+    // OTA
+    JsonObject ota = doc["ota"].to<JsonObject>();
+    ota["insecure"] = config.ota.insecure;
+
+    // Control zones past zone 0
+    JsonArray zones = doc["zones"].to<JsonArray>();
+    for (uint8_t i = 0; i < config.zoneCount; i++) {
+        const ZoneSettings& zs = config.zones[i];
+        JsonObject z = zones.add<JsonObject>();
+        z["probe"] = kProbeChannels[zs.probe].key;
+        z["fanPin"] = zs.fanPin;
+        z["fanChannel"] = zs.fanChannel;
+        z["servoPin"] = zs.servoPin;
+    }
 
     // Setup
-    doc["setupComplete"] = _config.setupComplete;
+    doc["setupComplete"] = config.setupComplete;
 }
 
 void ConfigManager::fromJson(const JsonDocument& doc) {
@@ -278,18 +447,54 @@ void ConfigManager::fromJson(const JsonDocument& doc) {
     if (doc["pid"]["p"].is<float>()) _config.pid.kp = doc["pid"]["p"].as<float>();
     if (doc["pid"]["i"].is<float>()) _config.pid.ki = doc["pid"]["i"].as<float>();
     if (doc["pid"]["d"].is<float>()) _config.pid.kd = doc["pid"]["d"].as<float>();
+    if (doc["pid"]["sampleMs"].is<uint32_t>()) {
+        uint32_t ms = doc["pid"]["sampleMs"].as<uint32_t>();
+        if (ms < PID_SAMPLE_MS_MIN) ms = PID_SAMPLE_MS_MIN;
+        if (ms > PID_SAMPLE_MS_MAX) ms = PID_SAMPLE_MS_MAX;
+        _config.pid.sampleMs = ms;
+    }
+    if (doc["pid"]["dFilterN"].is<float>()) _config.pid.dFilterN = doc["pid"]["dFilterN"].as<float>();
+    if (doc["pid"]["ff"].is<float>()) _config.pid.feedForward = doc["pid"]["ff"].as<float>();
+
+    JsonObjectConst sched = doc["pid"]["schedule"];
+    if (sched) {
+        PidSchedule& ps = _config.pid.schedule;
+        if (sched["enabled"].is<bool>()) ps.enabled = sched["enabled"].as<bool>();
+        JsonArrayConst bands = sched["bands"];
+        uint8_t count = 0;
+        PidGainBand parsed[PID_SCHEDULE_MAX_BANDS];
+        for (JsonObjectConst b : bands) {
+            if (count >= PID_SCHEDULE_MAX_BANDS) break;
+            if (!b["maxSp"].is<float>() || !b["scale"].is<float>()) continue;
+            parsed[count].maxSetpoint = b["maxSp"].as<float>();
+            parsed[count].scale = b["scale"].as<float>();
+            count++;
+        }
+        if (count > 0) {  // Keep the defaults when no band parses
+            memcpy(ps.bands, parsed, sizeof(PidGainBand) * count);
+            ps.bandCount = count;
+        }
+        JsonObjectConst modes = sched["modes"];
+        if (modes["fan_only"].is<float>()) ps.fanOnlyScale = modes["fan_only"].as<float>();
+        if (modes["fan_and_damper"].is<float>()) ps.fanAndDamperScale = modes["fan_and_damper"].as<float>();
+        if (modes["damper_primary"].is<float>()) ps.damperPrimaryScale = modes["damper_primary"].as<float>();
+    }
 
     // Fan
     if (doc["fan"]["mode"].is<const char*>()) {
-        strncpy(_config.fan.mode, doc["fan"]["mode"].as<const char*>(), CFG_NAME_MAX_LEN - 1);
+        _config.fan.mode = fanModeParse(doc["fan"]["mode"].as<const char*>());
     }
     if (doc["fan"]["minSpeed"].is<float>()) _config.fan.minSpeed = doc["fan"]["minSpeed"].as<float>();
     if (doc["fan"]["fanOnThreshold"].is<float>()) _config.fan.fanOnThreshold = doc["fan"]["fanOnThreshold"].as<float>();
+    if (doc["fan"]["tachPulses"].is<uint8_t>()) _config.fan.tachPulses = doc["fan"]["tachPulses"].as<uint8_t>();
+    if (doc["fan"]["maxRpm"].is<float>()) _config.fan.maxRpm = doc["fan"]["maxRpm"].as<float>();
+
+    // Damper
+    if (doc["damper"]["slewRate"].is<float>()) _config.damper.slewRate = doc["damper"]["slewRate"].as<float>();
 
     // Probes
-    const char* probeKeys[] = {"pit", "meat1", "meat2"};
-    for (int i = 0; i < 3; i++) {
-        JsonObjectConst p = doc["probes"][probeKeys[i]];
+    for (int i = 0; i < NUM_PROBES; i++) {
+        JsonObjectConst p = doc["probes"][kProbeChannels[i].key];
         if (p) {
             if (p["name"].is<const char*>()) {
                 strncpy(_config.probes[i].name, p["name"].as<const char*>(), CFG_NAME_MAX_LEN - 1);
@@ -316,6 +521,70 @@ void ConfigManager::fromJson(const JsonDocument& doc) {
         strncpy(_config.alarms.pushover.apiToken,
                 doc["alarms"]["pushover"]["apiToken"].as<const char*>(), CFG_KEY_MAX_LEN - 1);
     }
+    if (doc["alarms"]["webhook"]["enabled"].is<bool>()) {
+        _config.alarms.webhook.enabled = doc["alarms"]["webhook"]["enabled"].as<bool>();
+    }
+    if (doc["alarms"]["webhook"]["url"].is<const char*>()) {
+        strncpy(_config.alarms.webhook.url,
+                doc["alarms"]["webhook"]["url"].as<const char*>(), CFG_URL_MAX_LEN - 1);
+    }
+    if (doc["alarms"]["webhook"]["insecure"].is<bool>()) {
+        _config.alarms.webhook.insecure = doc["alarms"]["webhook"]["insecure"].as<bool>();
+    }
+
+    // MQTT
+    JsonObjectConst mqtt = doc["mqtt"];
+    if (mqtt["enabled"].is<bool>()) _config.mqtt.enabled = mqtt["enabled"].as<bool>();
+    if (mqtt["host"].is<const char*>()) {
+        strncpy(_config.mqtt.host, mqtt["host"].as<const char*>(), sizeof(_config.mqtt.host) - 1);
+    }
+    if (mqtt["port"].is<uint16_t>()) _config.mqtt.port = mqtt["port"].as<uint16_t>();
+    if (mqtt["user"].is<const char*>()) {
+        strncpy(_config.mqtt.user, mqtt["user"].as<const char*>(), sizeof(_config.mqtt.user) - 1);
+    }
+    if (mqtt["password"].is<const char*>()) {
+        strncpy(_config.mqtt.password, mqtt["password"].as<const char*>(),
+                sizeof(_config.mqtt.password) - 1);
+    }
+    if (mqtt["baseTopic"].is<const char*>()) {
+        strncpy(_config.mqtt.baseTopic, mqtt["baseTopic"].as<const char*>(),
+                sizeof(_config.mqtt.baseTopic) - 1);
+    }
+    if (mqtt["intervalMs"].is<uint32_t>()) {
+        uint32_t ms = mqtt["intervalMs"].as<uint32_t>();
+        _config.mqtt.intervalMs = ms < 1000 ? 1000 : ms;
+    }
+    if (mqtt["qos"].is<uint8_t>()) _config.mqtt.qos = mqtt["qos"].as<uint8_t>() > 0 ? 1 : 0;
+
+    // Hub
+    JsonObjectConst hub = doc["hub"];
+    if (hub["enabled"].is<bool>()) _config.hub.enabled = hub["enabled"].as<bool>();
+    for (JsonVariantConst peer : hub["peers"].as<JsonArrayConst>()) {
+        if (_config.hub.peerCount >= HUB_CONFIG_PEERS) break;
+        if (!peer.is<const char*>()) continue;
+        strncpy(_config.hub.peers[_config.hub.peerCount++], peer.as<const char*>(), HUB_HOST_LEN - 1);
+    }
+
+    // OTA
+    if (doc["ota"]["insecure"].is<bool>()) _config.ota.insecure = doc["ota"]["insecure"].as<bool>();
+
+    // Control zones: a zone needs a probe channel other than the pit's
+    for (JsonVariantConst zone : doc["zones"].as<JsonArrayConst>()) {
+        if (_config.zoneCount >= CONTROL_ZONES_MAX - 1) break;
+        JsonObjectConst z = zone.as<JsonObjectConst>();
+        if (!z) continue;
+        const char* key = z["probe"] | "";
+        uint8_t probe = 0;
+        for (uint8_t c = 1; c < NUM_PROBES; c++) {
+            if (strcmp(key, kProbeChannels[c].key) == 0) probe = c;
+        }
+        if (probe == 0) continue;
+        ZoneSettings& zs = _config.zones[_config.zoneCount++];
+        zs.probe      = probe;
+        zs.fanPin     = z["fanPin"] | -1;
+        zs.fanChannel = z["fanChannel"] | (uint8_t)(FAN_PWM_CHANNEL + _config.zoneCount);   // Default: one past zone 0's
+        zs.servoPin   = z["servoPin"] | -1;
+    }
 
     // Setup
     if (doc["setupComplete"].is<bool>()) {
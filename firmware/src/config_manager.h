@@ -1,11 +1,16 @@
 #pragma once
 
 #include "config.h"
+#include "fan_mode.h"
+#include "pid_schedule.h"
+#include "probe_channels.h"
 #include <stdint.h>
+#include <stddef.h>
+
+#include <ArduinoJson.h>
 
 #ifndef NATIVE_BUILD
 #include <LittleFS.h>
-#include <ArduinoJson.h>
 #endif
 
 // Maximum string lengths for config fields
@@ -13,6 +18,7 @@
 #define CFG_PASSWORD_MAX_LEN 64
 #define CFG_NAME_MAX_LEN     32
 #define CFG_KEY_MAX_LEN      64
+#define CFG_URL_MAX_LEN      128
 
 // Probe config within the overall Config struct
 struct ProbeSettings {
@@ -30,10 +36,18 @@ struct PushoverSettings {
     char apiToken[CFG_KEY_MAX_LEN];
 };
 
+// Generic webhook: alarm and error onsets POSTed as JSON
+struct WebhookSettings {
+    bool enabled;
+    char url[CFG_URL_MAX_LEN];  // http:// or https://
+    bool insecure;              // Skip https:// certificate checks (private CA)
+};
+
 // Alarm settings
 struct AlarmSettings {
     float pitBand;  // +/- deviation from setpoint (in configured units)
     PushoverSettings pushover;
+    WebhookSettings  webhook;
 };
 
 // PID settings
@@ -41,13 +55,24 @@ struct PidSettings {
     float kp;
     float ki;
     float kd;
+    uint32_t sampleMs;      // PID interval, PID_SAMPLE_MS_MIN..PID_SAMPLE_MS_MAX
+    float dFilterN;         // Derivative filter divisor (0 = unfiltered)
+    float feedForward;      // % output per degree of setpoint step
+    PidSchedule schedule;   // Gain scale by setpoint band and fan mode
 };
 
 // Fan settings
 struct FanSettings {
-    char  mode[CFG_NAME_MAX_LEN];  // "fan_only", "fan_and_damper", "damper_primary"
+    FanMode mode;                  // Parsed from "fan_only", "fan_and_damper", "damper_primary"
     float minSpeed;
     float fanOnThreshold;
+    uint8_t tachPulses;            // Tach pulses per revolution on PIN_SPARE, 0 = no tach
+    float   maxRpm;                // RPM at 100% airflow (closed loop with a tach)
+};
+
+// Damper servo settings
+struct DamperSettings {
+    float slewRate;                // Max travel, deg/s (0 = unlimited)
 };
 
 // WiFi settings
@@ -56,14 +81,52 @@ struct WifiSettings {
     char password[CFG_PASSWORD_MAX_LEN];
 };
 
+// MQTT telemetry publisher (see mqtt_batch.h)
+struct MqttSettings {
+    bool     enabled;
+    char     host[CFG_NAME_MAX_LEN * 2];
+    uint16_t port;
+    char     user[CFG_NAME_MAX_LEN];
+    char     password[CFG_PASSWORD_MAX_LEN];
+    char     baseTopic[CFG_NAME_MAX_LEN];   // Topics are <baseTopic>/<device id>/...
+    uint32_t intervalMs;                    // Telemetry sample interval
+    uint8_t  qos;                           // 0 or 1
+};
+
+// Hub mode (see hub_peers.h)
+struct HubSettings {
+    bool    enabled;
+    char    peers[HUB_CONFIG_PEERS][HUB_HOST_LEN];   // "host" or "host:port", besides mDNS
+    uint8_t peerCount;
+};
+
+// Firmware pulls (POST /api/ota/pull, see ota_manager.h)
+struct OtaSettings {
+    bool insecure;              // Skip https:// certificate checks (private CA)
+};
+
+// A control zone past zone 0 (see control_zone.h)
+struct ZoneSettings {
+    uint8_t probe;        // Probe channel the zone regulates on
+    int8_t  fanPin;       // -1 = no fan
+    uint8_t fanChannel;   // LEDC channel for the fan
+    int8_t  servoPin;     // -1 = no damper
+};
+
 // Complete configuration structure matching config.json schema
 struct AppConfig {
     WifiSettings    wifi;
     char            units[4];     // "F" or "C"
     PidSettings     pid;
     FanSettings     fan;
-    ProbeSettings   probes[3];    // pit, meat1, meat2
+    DamperSettings  damper;
+    ProbeSettings   probes[NUM_PROBES];   // By channel (probe_channels.h)
     AlarmSettings   alarms;
+    MqttSettings    mqtt;
+    HubSettings     hub;
+    OtaSettings     ota;
+    ZoneSettings    zones[CONTROL_ZONES_MAX - 1];   // Zones 1.., besides the stock zone 0
+    uint8_t         zoneCount;
     bool            setupComplete;
 };
 
@@ -74,9 +137,24 @@ public:
     // Mount LittleFS and load config from file. Call once from setup().
     bool begin();
 
-    // Save current config to LittleFS
+    // Save current config to LittleFS now (temp file + rename)
     bool save();
 
+    // Deferred saving. Setters only mark the config dirty when a value
+    // actually changes; loop() polls saveDue() and writes a copy taken
+    // under the control lock, so a burst of changes costs one flash write
+    // and the control task never waits on it.
+    void markDirty();                               // After edits via getConfigMutable()
+    bool isDirty() const { return _changeSeq != _savedSeq; }
+    bool saveDue(unsigned long nowMs) const;
+    uint32_t changeSeq() const { return _changeSeq; }
+
+    // Write snapshot, a copy of getConfig() taken when changeSeq() was seq.
+    // Skips the write if it matches what's already on flash. A failed
+    // write leaves the config dirty and pushes saveDue() out by another
+    // debounce, so a bad flash is retried every few seconds, not every pass.
+    bool saveSnapshot(const AppConfig& snapshot, uint32_t seq);
+
     // Reload config from LittleFS into RAM
     bool load();
 
@@ -107,12 +185,16 @@ public:
     float getPidKi() const { return _config.pid.ki; }
     float getPidKd() const { return _config.pid.kd; }
     void setPidTunings(float kp, float ki, float kd);
+    float getPidFeedForward() const { return _config.pid.feedForward; }
+    const PidSchedule& getPidSchedule() const { return _config.pid.schedule; }
 
     // --- Fan ---
-    const char* getFanMode() const { return _config.fan.mode; }
+    FanMode getFanMode() const { return _config.fan.mode; }
+    const char* getFanModeName() const { return fanModeName(_config.fan.mode); }
     float getFanMinSpeed() const { return _config.fan.minSpeed; }
     float getFanOnThreshold() const { return _config.fan.fanOnThreshold; }
-    void setFanMode(const char* mode);
+    void setFanMode(FanMode mode);
+    void setFanMode(const char* mode);   // Unknown names select fan_and_damper
     void setFanMinSpeed(float minSpeed);
     void setFanOnThreshold(float threshold);
 
@@ -127,24 +209,69 @@ public:
     void setAlarmPitBand(float band);
     const PushoverSettings& getPushoverSettings() const { return _config.alarms.pushover; }
     void setPushoverSettings(bool enabled, const char* userKey, const char* apiToken);
+    const WebhookSettings& getWebhookSettings() const { return _config.alarms.webhook; }
+    void setWebhookSettings(bool enabled, const char* url);
+
+    // --- MQTT ---
+    const MqttSettings& getMqttSettings() const { return _config.mqtt; }
+
+    // --- Hub ---
+    const HubSettings& getHubSettings() const { return _config.hub; }
+
+    // --- OTA ---
+    const OtaSettings& getOtaSettings() const { return _config.ota; }
 
     // --- Setup ---
     bool isSetupComplete() const { return _config.setupComplete; }
     void setSetupComplete(bool complete);
 
+#ifdef NATIVE_BUILD
+    // Test helpers: the clock the dirty tracking reads in place of millis(),
+    // and whether writes fail in place of LittleFS
+    void setNowMs(unsigned long ms) { _testNowMs = ms; }
+    void setWriteFails(bool fails) { _testWriteFails = fails; }
+#endif
+
 private:
+    // Assign a field, marking the config dirty only if the value changed
+    template <typename T>
+    void setField(T& field, T value) {
+        if (field == value) return;
+        field = value;
+        markDirty();
+    }
+    void setString(char* field, size_t size, const char* value);
+
+    unsigned long nowMs() const;
+
     // Set all fields to compiled-in defaults
     void applyDefaults();
 
-    // Serialize config to JSON document
-    void toJson(JsonDocument& doc) const;
+    // Serialize a config to JSON document
+    static void toJson(const AppConfig& config, JsonDocument& doc);
+
+    // Write config to CONFIG_FILE_PATH via a temp file and rename
+    bool writeFile(const AppConfig& config);
 
     // Deserialize JSON document to config
     void fromJson(const JsonDocument& doc);
 
     AppConfig _config;
+    AppConfig _saved;     // Last config written to (or read from) flash
     bool      _mounted;   // Whether LittleFS is mounted
 
+    // Dirty tracking: setters bump _changeSeq (under the control lock);
+    // saveSnapshot() records the seq it wrote
+    volatile uint32_t _changeSeq;
+    volatile uint32_t _savedSeq;
+    volatile unsigned long _firstChangeMs;   // First change since the last save
+    volatile unsigned long _lastChangeMs;
+
+#ifdef NATIVE_BUILD
+    unsigned long _testNowMs;
+    bool          _testWriteFails;
+#endif
+
     // Static default probe settings (for getProbeSettings fallback)
     static const ProbeSettings _defaultProbe;
 };
@@ -0,0 +1,61 @@
+#include "control_zone.h"
+#include "metrics.h"
+#include "split_range.h"
+#include <math.h>
+
+ControlZone::ControlZone()
+    : _probe(0)
+    , _setpoint(ZONE_DEFAULT_SETPOINT)
+    , _prevSetpoint(ZONE_DEFAULT_SETPOINT)
+    , _pitReached(false)
+    , _lastPidMs(0)
+{
+}
+
+void ControlZone::begin(uint8_t probe, int8_t fanPin, uint8_t fanChannel, int8_t servoPin) {
+    _probe = probe;
+    _fan.begin(fanPin, fanChannel);
+    _servo.begin(servoPin);
+}
+
+void ControlZone::restoreSetpoint(float sp, bool pitReached) {
+    _setpoint = sp;
+    _prevSetpoint = sp;
+    _pitReached = pitReached;
+}
+
+bool ControlZone::computeDue(unsigned long now, float temp, bool connected, FanMode fanMode) {
+    if (now - _lastPidMs < _pid.getSampleMs()) return false;
+    _lastPidMs = now;
+
+    // Feed-forward the setpoint step instead of ramping on the integrator
+    _pid.setFanMode(fanMode);
+    if (_setpoint != _prevSetpoint) {
+        _pid.stepSetpoint(_prevSetpoint, _setpoint);
+        _pitReached = false;  // Suppress pit-band alarms during ramp to new setpoint
+        _prevSetpoint = _setpoint;
+    }
+
+    // Only compute when the probe is connected. When disconnected the
+    // output retains its last value to maintain current fire management.
+    if (connected) {
+        {
+            MetricTimer timer(Metric::PID_COMPUTE);
+            _pid.compute(temp, _setpoint);
+        }
+        if (!_pitReached && fabsf(temp - _setpoint) <= ZONE_REACHED_BAND) {
+            _pitReached = true;
+        }
+    } else if (_pid.isAutoTuning()) {
+        _pid.cancelAutoTune();  // Can't measure the oscillation blind
+    }
+    return true;
+}
+
+void ControlZone::actuate(FanMode fanMode, float fanOnThreshold) {
+    SplitRangeOutput sr = splitRange(_pid.getOutput(), fanMode, fanOnThreshold);
+    _servo.setPosition(sr.damperPercent);
+    _servo.update();
+    _fan.setSpeed(sr.fanPercent);
+    _fan.update();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "config.h"
+#include "fan_mode.h"
+#include "probe_channels.h"
+#include "fan_controller.h"
+#include "pid_controller.h"
+#include "servo_controller.h"
+#include <stdint.h>
+
+// One independently controlled cook chamber: the probe channel it
+// regulates on, its own PID loop and setpoint, and the fan and damper the
+// split-range drives.
+//
+// Zone 0 is the stock pit probe, PIN_FAN_PWM and PIN_SERVO. Further zones
+// come from config.json "zones" (up to CONTROL_ZONES_MAX - 1), each naming
+// a probe channel from probe_channels.h, a fan pin and LEDC channel, and a
+// servo pin. Zones share the PID tunings, gain schedule and fan mode; the
+// control task steps each one in turn every tick. Pure C++ on top of the
+// controller modules, testable on native.
+class ControlZone {
+public:
+    ControlZone();
+
+    // Wire the zone. A negative pin leaves that actuator out.
+    void begin(uint8_t probe, int8_t fanPin, uint8_t fanChannel, int8_t servoPin);
+
+    uint8_t getProbe() const { return _probe; }
+
+    float getSetpoint() const { return _setpoint; }
+    void  setSetpoint(float sp) { _setpoint = sp; }
+
+    // Take a setpoint without the feed-forward step a change would get
+    // (warm restart, journal replay)
+    void restoreSetpoint(float sp, bool pitReached);
+
+    // Has the zone's probe come within ZONE_REACHED_BAND of the setpoint
+    // since the last setpoint change or new cook?
+    bool isPitReached() const { return _pitReached; }
+    void resetPitReached() { _pitReached = false; }
+
+    // PID sample clock starts now
+    void startClock(unsigned long now) { _lastPidMs = now; }
+
+    // One PID step once pid.sampleMs has passed: feed-forward a setpoint
+    // change, then compute from the zone's probe. Disconnected, the output
+    // holds and an auto-tune is cancelled. Returns true if a step ran.
+    bool computeDue(unsigned long now, float temp, bool connected, FanMode fanMode);
+
+    // Split-range the PID output onto fan and damper and service both
+    // (fan kick-start and long-pulse, damper slew and detach)
+    void actuate(FanMode fanMode, float fanOnThreshold);
+
+    PidController&         pid()         { return _pid; }
+    const PidController&   pid()   const { return _pid; }
+    FanController&         fan()         { return _fan; }
+    const FanController&   fan()   const { return _fan; }
+    ServoController&       servo()       { return _servo; }
+    const ServoController& servo() const { return _servo; }
+
+private:
+    PidController   _pid;
+    FanController   _fan;
+    ServoController _servo;
+
+    uint8_t       _probe;
+    float         _setpoint;
+    float         _prevSetpoint;   // For change detection
+    bool          _pitReached;
+    unsigned long _lastPidMs;
+};
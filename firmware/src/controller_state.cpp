@@ -0,0 +1,74 @@
+#include "controller_state.h"
+#include "session_log.h"
+#include <stddef.h>
+
+#ifndef NATIVE_BUILD
+#include <LittleFS.h>
+#endif
+
+static uint32_t controllerStateCrc(const ControllerState& s) {
+    return sessionCrc32(&s, offsetof(ControllerState, crc));
+}
+
+void controllerStateSeal(ControllerState& s) {
+    s.magic   = CONTROLLER_STATE_MAGIC;
+    s.version = CONTROLLER_STATE_VERSION;
+    s.size    = sizeof(ControllerState);
+    s.seq++;
+    s.crc     = controllerStateCrc(s);
+}
+
+bool controllerStateValid(const ControllerState& s) {
+    return s.magic == CONTROLLER_STATE_MAGIC
+        && s.version == CONTROLLER_STATE_VERSION
+        && s.size == sizeof(ControllerState)
+        && s.crc == controllerStateCrc(s);
+}
+
+static bool qualifies(const ControllerState* s, uint32_t sessionStart, bool fahrenheit) {
+    return s && sessionStart != 0
+        && controllerStateValid(*s)
+        && s->sessionStart == sessionStart
+        && (s->fahrenheit != 0) == fahrenheit;
+}
+
+const ControllerState* controllerStatePick(const ControllerState* a,
+                                           const ControllerState* b,
+                                           uint32_t sessionStart,
+                                           bool fahrenheit) {
+    bool useA = qualifies(a, sessionStart, fahrenheit);
+    bool useB = qualifies(b, sessionStart, fahrenheit);
+    if (useA && useB) return (int32_t)(a->seq - b->seq) >= 0 ? a : b;
+    if (useA) return a;
+    if (useB) return b;
+    return nullptr;
+}
+
+bool controllerStateLoad(ControllerState& out) {
+#ifndef NATIVE_BUILD
+    File f = LittleFS.open(CONTROL_STATE_PATH, "r");
+    if (!f) return false;
+    bool ok = f.read((uint8_t*)&out, sizeof(out)) == sizeof(out);
+    f.close();
+    return ok && controllerStateValid(out);
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+bool controllerStateSave(const ControllerState& s) {
+#ifndef NATIVE_BUILD
+    static const char* tmp = CONTROL_STATE_PATH ".tmp";
+    File f = LittleFS.open(tmp, "w");
+    if (!f) return false;
+    bool ok = f.write((const uint8_t*)&s, sizeof(s)) == sizeof(s);
+    f.close();
+    if (ok) ok = LittleFS.rename(tmp, CONTROL_STATE_PATH);
+    if (!ok) LittleFS.remove(tmp);
+    return ok;
+#else
+    (void)s;
+    return false;
+#endif
+}
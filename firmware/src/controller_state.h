@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pid_controller.h"
+#include "probe_channels.h"
+#include <stdint.h>
+
+// Checkpoint of the control loop's running state, for warm restarts.
+//
+// The session log brings back what the cook did; this brings back what the
+// controller was doing — integrator, lid-event tracking, setpoint, meat
+// targets — so a reset mid-cook resumes at the same fan output instead of
+// winding the integrator up from zero while the pit sags. The control task
+// refreshes a copy in RTC memory, which survives software, watchdog and
+// panic resets, and loop() mirrors it to flash less often for power loss.
+//
+// The image handling is pure C++ and testable on native; the flash
+// load/save below are no-ops there.
+
+#define CONTROLLER_STATE_MAGIC    0x4C525443UL   // "CTRL"
+#define CONTROLLER_STATE_VERSION  3
+
+// A control zone past zone 0 (control_zone.h); zone 0 is the state's own
+// setpoint/pitReached/pid
+struct ZoneCheckpoint {
+    float       setpoint;
+    uint8_t     pitReached;
+    uint8_t     reserved[3];
+    PidSnapshot pid;
+};
+
+struct ControllerState {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    size;           // sizeof(ControllerState) when sealed
+    uint32_t    seq;            // Bumped on every checkpoint; newer wins
+    uint32_t    sessionStart;   // Cook the state belongs to (CookSession start epoch)
+    float       setpoint;
+    float       meatTarget[NUM_MEATS];  // By meat probe (channel - 1), 0 = not set
+    uint8_t     pitReached;
+    uint8_t     fahrenheit;     // Units the temperatures are in
+    uint8_t     zoneCount;      // Entries of zones[] in use
+    uint8_t     reserved;
+    PidSnapshot pid;
+    ZoneCheckpoint zones[CONTROL_ZONES_MAX - 1];
+    uint32_t    crc;            // sessionCrc32 of everything before it
+};
+
+// Fill in the framing and CRC (bumps seq)
+void controllerStateSeal(ControllerState& s);
+
+// Framing, size, version and CRC all check out
+bool controllerStateValid(const ControllerState& s);
+
+// The image to resume from: valid, belonging to sessionStart (non-zero),
+// in the current units, and the newer of the two if both qualify.
+// Either input may be null. Returns null when neither qualifies.
+const ControllerState* controllerStatePick(const ControllerState* a,
+                                           const ControllerState* b,
+                                           uint32_t sessionStart,
+                                           bool fahrenheit);
+
+// Flash copy at CONTROL_STATE_PATH. save() writes aside and renames over,
+// so a power cut mid-write keeps the previous image. load() returns false
+// when there's no file or it doesn't validate.
+bool controllerStateLoad(ControllerState& out);
+bool controllerStateSave(const ControllerState& s);
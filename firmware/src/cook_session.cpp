@@ -1,13 +1,57 @@
 #include "cook_session.h"
+#include "ext_ram.h"
 #include <string.h>
+#include <stdio.h>
+
+static const uint32_t kRollupFactor[SESSION_ROLLUP_LEVELS] = SESSION_ROLLUP_FACTORS;
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
 #include <time.h>
+#include "session_log.h"
+#include "metrics.h"
+
+#define SESSION_LOG_MAX_BLOCKS (SESSION_SEGMENT_BLOCKS * SESSION_LOG_MAX_SEGMENTS)
+
+static void logSegmentPath(char* path, size_t len, uint32_t segment) {
+    snprintf(path, len, SESSION_LOG_PATH, (unsigned)segment);
+}
+
+// Block reader over the segment files, keeping the current segment open
+struct LogReader {
+    File    file;
+    int32_t segment;
+
+    LogReader() : segment(-1) {}
+    ~LogReader() { if (file) file.close(); }
+};
+
+static bool readLogBlock(uint32_t block, uint8_t* out, void* ctx) {
+    LogReader* r = (LogReader*)ctx;
+    int32_t seg = (int32_t)(block / SESSION_SEGMENT_BLOCKS);
+    if (seg != r->segment) {
+        if (r->file) r->file.close();
+        r->segment = seg;
+        char path[24];
+        logSegmentPath(path, sizeof(path), seg);
+        if (!LittleFS.exists(path)) return false;
+        r->file = LittleFS.open(path, "r");
+    }
+    if (!r->file) return false;
+    if (!r->file.seek((block % SESSION_SEGMENT_BLOCKS) * SESSION_BLOCK_BYTES)) return false;
+    return r->file.read(out, SESSION_BLOCK_BYTES) == SESSION_BLOCK_BYTES;
+}
 #endif
 
 CookSession::CookSession()
-    : _head(0)
+    : CookSession(0, 0)
+{
+}
+
+CookSession::CookSession(uint32_t bufferCapacity, uint32_t rollupCapacity)
+    : _buffer(nullptr)
+    , _capacity(bufferCapacity)
+    , _head(0)
     , _count(0)
     , _wrapped(false)
     , _active(false)
@@ -16,18 +60,92 @@ CookSession::CookSession()
     , _lastSampleMs(0)
     , _lastFlushMs(0)
     , _flushedToIndex(0)
-    , _getPitTemp(nullptr)
-    , _getMeat1Temp(nullptr)
-    , _getMeat2Temp(nullptr)
+    , _logBlocks(0)
+    , _readHint(0)
+    , _tailOpen(false)
+    , _tailFirst(0)
+    , _eventsFlushed(0)
+    , _rollupCapacity(rollupCapacity)
+    , _getTemp(nullptr)
+    , _isConnected(nullptr)
     , _getFanPct(nullptr)
     , _getDamperPct(nullptr)
     , _getFlags(nullptr)
+    , _getAlarms(nullptr)
 {
-    memset(_buffer, 0, sizeof(_buffer));
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) _rollup[l] = nullptr;
+    resetRollups();
+    for (uint8_t c = 0; c < NUM_PROBES; c++) _peak[c] = SESSION_PEAK_NONE;
+}
+
+CookSession::~CookSession() {
+    extRamFree(_buffer);
+    extRamFree(_rollup[0]);
+}
+
+bool CookSession::allocStorage() {
+    if (_buffer) return true;
+
+    bool ext = extRamAvailable();
+    bool sized = _capacity == 0 || _rollupCapacity == 0;
+    if (_capacity == 0)       _capacity       = ext ? SESSION_PSRAM_BUFFER_SIZE : SESSION_BUFFER_SIZE;
+    if (_rollupCapacity == 0) _rollupCapacity = ext ? SESSION_PSRAM_ROLLUP_CAPACITY : SESSION_ROLLUP_CAPACITY;
+
+    RollupPoint* tiers = nullptr;
+    for (;;) {
+        _buffer = (DataPoint*)extRamAlloc(_capacity * sizeof(DataPoint));
+        tiers = (RollupPoint*)extRamAlloc(
+            SESSION_ROLLUP_LEVELS * _rollupCapacity * sizeof(RollupPoint));
+        if (_buffer && tiers) break;
+
+        extRamFree(_buffer);
+        extRamFree(tiers);
+        _buffer = nullptr;
+        tiers = nullptr;
+
+        // PSRAM-sized buffers that didn't fit (PSRAM exhausted, and too big
+        // for the internal heap extRamAlloc falls back to): retry at the
+        // internal-RAM sizes rather than run without a session
+        if (ext && sized && (_capacity > SESSION_BUFFER_SIZE ||
+                             _rollupCapacity > SESSION_ROLLUP_CAPACITY)) {
+#ifndef NATIVE_BUILD
+            Serial.println("[SESSION] PSRAM session buffer failed, retrying at internal RAM size");
+#endif
+            if (_capacity > SESSION_BUFFER_SIZE) _capacity = SESSION_BUFFER_SIZE;
+            if (_rollupCapacity > SESSION_ROLLUP_CAPACITY) _rollupCapacity = SESSION_ROLLUP_CAPACITY;
+            ext = false;
+            continue;
+        }
+
+        _capacity = 0;
+        _rollupCapacity = 0;
+#ifndef NATIVE_BUILD
+        Serial.println("[SESSION] Out of memory for the session buffer!");
+#endif
+        return false;
+    }
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+        _rollup[l] = tiers + l * _rollupCapacity;
+    }
+
+#ifndef NATIVE_BUILD
+    // extRamAlloc() falls back to the internal heap per block, so report
+    // where each one actually landed
+    bool bufExt = extRamIsExternal(_buffer);
+    bool tierExt = extRamIsExternal(tiers);
+    Serial.printf("[SESSION] Buffer: %u points in %s, %u buckets per tier in %s\n",
+                  (unsigned)_capacity, bufExt ? "PSRAM" : "internal RAM",
+                  (unsigned)_rollupCapacity, tierExt ? "PSRAM" : "internal RAM");
+#endif
+    return true;
 }
 
 void CookSession::begin() {
+    allocStorage();
+
 #ifndef NATIVE_BUILD
+    loadArchiveIndex();
+
     // Attempt to recover a session from flash
     if (loadFromFlash()) {
         Serial.printf("[SESSION] Recovered session from flash. %u points loaded.\n",
@@ -66,12 +184,16 @@ void CookSession::update() {
     dp.timestamp = (uint32_t)nowEpoch;
 
     // Fill from data sources if set
-    if (_getPitTemp)   dp.pitTemp   = (int16_t)(_getPitTemp() * 10.0f);
-    if (_getMeat1Temp) dp.meat1Temp = (int16_t)(_getMeat1Temp() * 10.0f);
-    if (_getMeat2Temp) dp.meat2Temp = (int16_t)(_getMeat2Temp() * 10.0f);
+    uint16_t disc = 0;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        if (_getTemp) dp.temp[c] = (int16_t)(_getTemp(c) * 10.0f);
+        if (_isConnected && !_isConnected(c)) disc |= (uint16_t)(1u << c);
+    }
     if (_getFanPct)    dp.fanPct    = _getFanPct();
     if (_getDamperPct) dp.damperPct = _getDamperPct();
     if (_getFlags)     dp.flags     = _getFlags();
+    if (_getAlarms)    dpSetAlarmMask(dp, _getAlarms());
+    if (_isConnected)  dpSetDiscMask(dp, disc);
 
     addPoint(dp);
 
@@ -84,6 +206,7 @@ void CookSession::update() {
 }
 
 void CookSession::startSession() {
+    archiveSession();
     clear();
     _active = true;
 
@@ -109,129 +232,175 @@ void CookSession::endSession() {
 }
 
 void CookSession::addPoint(const DataPoint& point) {
+    if (!allocStorage()) return;
+
     _buffer[_head] = point;
-    _head = (_head + 1) % SESSION_BUFFER_SIZE;
+    _head = (_head + 1) % _capacity;
 
-    if (_count < SESSION_BUFFER_SIZE) {
+    if (_count < _capacity) {
         _count++;
     } else {
         _wrapped = true;
     }
 
     _totalPoints++;
+
+    updatePeaks(point);
+    accumulateRollups(point);
+}
+
+void CookSession::updatePeaks(const DataPoint& dp) {
+    uint16_t disc = dpDiscMask(dp);
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        if (disc & (1u << c)) continue;
+        if (_peak[c] == SESSION_PEAK_NONE || dp.temp[c] > _peak[c]) _peak[c] = dp.temp[c];
+    }
 }
 
 void CookSession::flush() {
 #ifndef NATIVE_BUILD
     if (_count == 0) return;
+    MetricTimer timer(Metric::SESSION_FLUSH);
 
-    // Append unflushed data points to the session file
-    File file = LittleFS.open(SESSION_FILE_PATH, "a");
-    if (!file) {
-        // Try creating the file
-        file = LittleFS.open(SESSION_FILE_PATH, "w");
-        if (!file) {
-            Serial.println("[SESSION] Failed to open session file for writing!");
-            return;
-        }
-        // Write header: start time + data point size for recovery
-        file.write((uint8_t*)&_startTime, sizeof(_startTime));
+    if (_flushedToIndex >= _totalPoints) {
+        flushRollups();
+        flushEvents();
+        return;
     }
 
-    // Determine which points to flush (those not yet written)
-    // We write from _flushedToIndex to _totalPoints
-    uint32_t pointsToFlush = _totalPoints - _flushedToIndex;
+    // The last block is kept open while it has room: each flush rewrites it
+    // in place with its earlier points plus the new ones, so a 60 s flush
+    // doesn't burn a whole block. LittleFS commits the rewrite on close, so
+    // a power cut leaves the previous version. Its points are still in the
+    // ring unless the ring overran them.
+    uint32_t ramFirst = getFirstRamIndex();
+    if (_tailOpen && _tailFirst < ramFirst) _tailOpen = false;
 
-    if (pointsToFlush > _count) {
-        pointsToFlush = _count;  // Can't flush more than what's in RAM
-    }
+    // If the ring overran unflushed points (flash unwritable for a whole
+    // ring's worth) the log resumes at the oldest point still in RAM, and
+    // recovery will stop at that gap.
+    uint32_t idx = _tailOpen ? _tailFirst : _flushedToIndex;
+    if (idx < ramFirst) idx = ramFirst;
 
-    if (pointsToFlush > 0) {
-        // Write from the oldest unflushed point in the circular buffer
-        uint32_t startIdx;
-        if (_wrapped) {
-            // Buffer has wrapped; oldest point is at _head
-            startIdx = _head;
-        } else {
-            startIdx = 0;
+    alignas(4) uint8_t block[SESSION_BLOCK_BYTES];
+    File     file;
+    int32_t  openSeg = -1;
+    uint32_t before  = _flushedToIndex;
+
+    while (idx < _totalPoints) {
+        uint32_t pos = _tailOpen ? _logBlocks - 1 : _logBlocks;
+        if (pos >= SESSION_LOG_MAX_BLOCKS) {
+            Serial.println("[SESSION] Session log full; no more points will be stored.");
+            break;
         }
 
-        // Calculate how far back we need to go for unflushed points
-        uint32_t flushStart;
-        if (pointsToFlush <= _count) {
-            // Write the most recent pointsToFlush entries
-            if (_head >= pointsToFlush) {
-                flushStart = _head - pointsToFlush;
-            } else {
-                flushStart = SESSION_BUFFER_SIZE - (pointsToFlush - _head);
+        SessionBlockWriter w;
+        sessionBlockBegin(w, block, _startTime, idx);
+        while (idx + w.count < _totalPoints &&
+               sessionBlockAdd(w, *getPoint(idx + w.count - ramFirst))) {}
+        sessionBlockEnd(w);
+        bool full = idx + w.count < _totalPoints;
+
+        // Write at the block after the last valid one (or over the open
+        // tail). After a torn write that is the torn block itself, so it
+        // gets overwritten in place.
+        int32_t seg = (int32_t)(pos / SESSION_SEGMENT_BLOCKS);
+        if (seg != openSeg) {
+            if (file) file.close();
+            char path[24];
+            logSegmentPath(path, sizeof(path), seg);
+            file = LittleFS.open(path, LittleFS.exists(path) ? "r+" : "w");
+            openSeg = seg;
+            if (!file) {
+                Serial.printf("[SESSION] Failed to open %s for writing!\n", path);
+                break;
             }
-        } else {
-            flushStart = startIdx;
         }
 
-        for (uint32_t i = 0; i < pointsToFlush; i++) {
-            uint32_t idx = (flushStart + i) % SESSION_BUFFER_SIZE;
-            file.write((uint8_t*)&_buffer[idx], sizeof(DataPoint));
+        if (!file.seek((pos % SESSION_SEGMENT_BLOCKS) * SESSION_BLOCK_BYTES) ||
+            file.write(block, SESSION_BLOCK_BYTES) != SESSION_BLOCK_BYTES) {
+            Serial.println("[SESSION] Session log write failed!");
+            break;
         }
+        counterAdd(Counter::SESSION_FLUSH_BYTES, SESSION_BLOCK_BYTES);
 
-        _flushedToIndex = _totalPoints;
+        if (!_tailOpen) _logBlocks++;
+        _flushedToIndex = idx + w.count;
 
-        Serial.printf("[SESSION] Flushed %u points to flash.\n", pointsToFlush);
+        // A block that took every pending point stays open for the next flush
+        _tailOpen = !full;
+        _tailFirst = idx;
+        if (full) idx += w.count;
+        else break;
     }
 
-    file.close();
+    if (file) file.close();
+
+    if (_flushedToIndex > before) {
+        Serial.printf("[SESSION] Flushed %u points to flash (%u log blocks).\n",
+                      _flushedToIndex - before, _logBlocks);
+    }
+
+    flushRollups();
+    flushEvents();
 #endif
 }
 
 bool CookSession::loadFromFlash() {
 #ifndef NATIVE_BUILD
-    File file = LittleFS.open(SESSION_FILE_PATH, "r");
-    if (!file) return false;
-
-    size_t fileSize = file.size();
-    if (fileSize < sizeof(uint32_t)) {
-        file.close();
-        return false;
+    SessionLogScan scan;
+    {
+        LogReader reader;
+        scan = sessionLogScan(readLogBlock, &reader, SESSION_LOG_MAX_BLOCKS);
     }
-
-    // Read start time header
-    file.read((uint8_t*)&_startTime, sizeof(_startTime));
-
-    // Read data points
-    size_t dataSize = fileSize - sizeof(uint32_t);
-    uint32_t numPoints = dataSize / sizeof(DataPoint);
-
-    if (numPoints == 0) {
-        file.close();
-        return false;
+    if (scan.torn) {
+        Serial.printf("[SESSION] Log ends at block %u; discarding the torn block after it.\n",
+                      scan.blocks);
     }
+    if (scan.points == 0) return false;
 
-    // Clear buffer first
     _head = 0;
     _count = 0;
     _wrapped = false;
-    _totalPoints = 0;
+    _startTime = scan.startTime;
+    _logBlocks = scan.blocks;
+    _readHint = 0;
+    _tailOpen = false;      // Recovered blocks are left as they are
 
-    // Read points into circular buffer (keep only the most recent SESSION_BUFFER_SIZE)
-    if (numPoints > SESSION_BUFFER_SIZE) {
-        // Skip older points that don't fit in buffer
-        uint32_t skip = numPoints - SESSION_BUFFER_SIZE;
-        file.seek(sizeof(uint32_t) + skip * sizeof(DataPoint));
-        numPoints = SESSION_BUFFER_SIZE;
-    }
+    // Older points stay on flash and are served by readPoints(); only the
+    // most recent _capacity points are loaded into the ring
+    if (!allocStorage()) return false;
+    uint32_t toLoad = scan.points;
+    if (toLoad > _capacity) toLoad = _capacity;
+    uint32_t first = scan.points - toLoad;
 
-    for (uint32_t i = 0; i < numPoints; i++) {
-        DataPoint dp;
-        if (file.read((uint8_t*)&dp, sizeof(DataPoint)) == sizeof(DataPoint)) {
-            _buffer[_head] = dp;
-            _head = (_head + 1) % SESSION_BUFFER_SIZE;
+    DataPoint page[SESSION_READ_PAGE];
+    while (_count < toLoad) {
+        uint32_t want = toLoad - _count;
+        if (want > SESSION_READ_PAGE) want = SESSION_READ_PAGE;
+        uint32_t n = readLog(first + _count, page, want);
+        for (uint32_t i = 0; i < n; i++) {
+            _buffer[_head] = page[i];
+            _head = (_head + 1) % _capacity;
             _count++;
-            _totalPoints++;
         }
+        if (n < want) break;
     }
 
+    // Absolute indices continue from the whole log, not just the ring
+    _totalPoints = scan.points - (toLoad - _count);
     _flushedToIndex = _totalPoints;
-    file.close();
+
+    // Peaks cover the whole cook, not just what fits in the ring
+    for (uint32_t idx = 0; idx < _totalPoints; ) {
+        uint32_t n = readPoints(idx, page, SESSION_READ_PAGE);
+        if (n == 0) break;
+        for (uint32_t i = 0; i < n; i++) updatePeaks(page[i]);
+        idx += n;
+    }
+
+    loadRollups();
+    loadEvents();
     return _count > 0;
 #else
     return false;
@@ -244,71 +413,133 @@ void CookSession::clear() {
     _wrapped = false;
     _totalPoints = 0;
     _flushedToIndex = 0;
+    _logBlocks = 0;
+    _readHint = 0;
+    _tailOpen = false;
+    _tailFirst = 0;
     _startTime = 0;
     _active = false;
-    memset(_buffer, 0, sizeof(_buffer));
+    if (_buffer) memset(_buffer, 0, _capacity * sizeof(DataPoint));
+    resetRollups();
+    for (uint8_t c = 0; c < NUM_PROBES; c++) _peak[c] = SESSION_PEAK_NONE;
+    _events.clear();
+    _eventsFlushed = 0;
 
+    removeStoredData();
 #ifndef NATIVE_BUILD
-    LittleFS.remove(SESSION_FILE_PATH);
     Serial.println("[SESSION] Session data cleared.");
 #endif
 }
 
-String CookSession::toCSV() const {
-    String csv;
-    csv.reserve(_count * 60);  // Rough estimate
-
-    // Header
-    csv += "timestamp,pit,meat1,meat2,fan,damper,flags\n";
-
-    // Data rows
-    for (uint32_t i = 0; i < _count; i++) {
-        const DataPoint* dp = getPoint(i);
-        if (dp == nullptr) continue;
-
-        char line[80];
-        snprintf(line, sizeof(line), "%u,%.1f,%.1f,%.1f,%u,%u,%u\n",
-                 dp->timestamp,
-                 dp->pitTemp / 10.0f,
-                 dp->meat1Temp / 10.0f,
-                 dp->meat2Temp / 10.0f,
-                 dp->fanPct,
-                 dp->damperPct,
-                 dp->flags);
-        csv += line;
+void CookSession::removeStoredData() {
+#ifndef NATIVE_BUILD
+    char path[24];
+    if (LittleFS.exists(SESSION_FILE_PATH)) LittleFS.remove(SESSION_FILE_PATH);
+    for (uint32_t seg = 0; seg < SESSION_LOG_MAX_SEGMENTS; seg++) {
+        logSegmentPath(path, sizeof(path), seg);
+        if (LittleFS.exists(path)) LittleFS.remove(path);
     }
+    for (uint8_t l = 1; l <= SESSION_ROLLUP_LEVELS; l++) {
+        snprintf(path, sizeof(path), SESSION_ROLLUP_PATH, (unsigned)l);
+        LittleFS.remove(path);
+    }
+    if (LittleFS.exists(SESSION_EVENT_PATH)) LittleFS.remove(SESSION_EVENT_PATH);
+#endif
+}
 
-    return csv;
+void CookSession::beginExport(ExportCursor& cursor, ExportFormat format) const {
+    cursor.format  = format;
+    cursor.stage   = 0;
+    cursor.first   = true;
+    cursor.next    = 0;
+    cursor.pageLen = 0;
+    cursor.pagePos = 0;
+    cursor.lineLen = 0;
+    cursor.lineOff = 0;
 }
 
-String CookSession::toJSON() const {
-    String json;
-    json.reserve(_count * 80);
+size_t CookSession::exportChunk(ExportCursor& c, char* buf, size_t maxLen) const {
+    size_t pos = 0;
 
-    json += "[";
+    while (pos < maxLen) {
+        // Drain the pending row first
+        if (c.lineOff < c.lineLen) {
+            size_t take = c.lineLen - c.lineOff;
+            if (take > maxLen - pos) take = maxLen - pos;
+            memcpy(buf + pos, c.line + c.lineOff, take);
+            pos += take;
+            c.lineOff += take;
+            continue;
+        }
+        c.lineLen = c.lineOff = 0;
 
-    for (uint32_t i = 0; i < _count; i++) {
-        const DataPoint* dp = getPoint(i);
-        if (dp == nullptr) continue;
+        int n = 0;
+        if (c.stage == 0) {
+            if (c.format == ExportFormat::CSV) {
+                n = snprintf(c.line, sizeof(c.line), "timestamp");
+                for (uint8_t ch = 0; ch < NUM_PROBES; ch++) {
+                    n += snprintf(c.line + n, sizeof(c.line) - n, ",%s", kProbeChannels[ch].key);
+                }
+                n += snprintf(c.line + n, sizeof(c.line) - n, ",fan,damper,flags%s\n",
+                              NUM_PROBES > 3 ? ",alarmExt" : "");
+            } else {
+                n = snprintf(c.line, sizeof(c.line), "[");
+            }
+            c.stage = 1;
+        } else if (c.stage == 1) {
+            if (c.pagePos >= c.pageLen) {
+                // Page in the next run of points; an unreadable flash range
+                // falls back to what RAM still holds
+                c.pageLen = 0;
+                if (c.next < getFirstRamIndex()) {
+                    c.pageLen = readPoints(c.next, c.page, SESSION_READ_PAGE);
+                    if (c.pageLen == 0) c.next = getFirstRamIndex();
+                }
+                if (c.pageLen == 0) c.pageLen = readPoints(c.next, c.page, SESSION_READ_PAGE);
+                c.pagePos = 0;
+                c.next += c.pageLen;
+                if (c.pageLen == 0) { c.stage = 2; continue; }
+            }
 
-        if (i > 0) json += ",";
+            // EXPORT_LINE_MAX fits the widest row, so n stays in the buffer
+            const DataPoint* dp = &c.page[c.pagePos++];
+            if (c.format == ExportFormat::CSV) {
+                n = snprintf(c.line, sizeof(c.line), "%u", dp->timestamp);
+                for (uint8_t ch = 0; ch < NUM_PROBES; ch++) {
+                    n += snprintf(c.line + n, sizeof(c.line) - n, ",%.1f", dp->temp[ch] / 10.0f);
+                }
+                n += snprintf(c.line + n, sizeof(c.line) - n, ",%u,%u,%u",
+                              dp->fanPct, dp->damperPct, dp->flags);
+                // Done alarms past meat2 (bit 0 = channel 3)
+                if (NUM_PROBES > 3) n += snprintf(c.line + n, sizeof(c.line) - n, ",%u", dp->alarmExt);
+                n += snprintf(c.line + n, sizeof(c.line) - n, "\n");
+            } else {
+                n = snprintf(c.line, sizeof(c.line), "%s{\"ts\":%u",
+                             c.first ? "" : ",", dp->timestamp);
+                for (uint8_t ch = 0; ch < NUM_PROBES; ch++) {
+                    n += snprintf(c.line + n, sizeof(c.line) - n, ",\"%s\":%.1f",
+                                  kProbeChannels[ch].key, dp->temp[ch] / 10.0f);
+                }
+                n += snprintf(c.line + n, sizeof(c.line) - n,
+                              ",\"fan\":%u,\"damper\":%u,\"flags\":%u",
+                              dp->fanPct, dp->damperPct, dp->flags);
+                if (NUM_PROBES > 3) {
+                    n += snprintf(c.line + n, sizeof(c.line) - n, ",\"alarmExt\":%u", dp->alarmExt);
+                }
+                n += snprintf(c.line + n, sizeof(c.line) - n, "}");
+            }
+            c.first = false;
+        } else if (c.stage == 2) {
+            n = snprintf(c.line, sizeof(c.line), "%s", c.format == ExportFormat::JSON ? "]" : "");
+            c.stage = 3;
+        } else {
+            break;
+        }
 
-        char entry[120];
-        snprintf(entry, sizeof(entry),
-                 "{\"ts\":%u,\"pit\":%.1f,\"meat1\":%.1f,\"meat2\":%.1f,"
-                 "\"fan\":%u,\"damper\":%u,\"flags\":%u}",
-                 dp->timestamp,
-                 dp->pitTemp / 10.0f,
-                 dp->meat1Temp / 10.0f,
-                 dp->meat2Temp / 10.0f,
-                 dp->fanPct,
-                 dp->damperPct,
-                 dp->flags);
-        json += entry;
+        if (n > 0) c.lineLen = ((size_t)n < sizeof(c.line)) ? n : sizeof(c.line) - 1;
     }
 
-    json += "]";
-    return json;
+    return pos;
 }
 
 uint32_t CookSession::getPointCount() const {
@@ -340,7 +571,7 @@ const DataPoint* CookSession::getPoint(uint32_t index) const {
     uint32_t actualIdx;
     if (_wrapped) {
         // When wrapped, oldest is at _head (it was overwritten next)
-        actualIdx = (_head + index) % SESSION_BUFFER_SIZE;
+        actualIdx = (_head + index) % _capacity;
     } else {
         // Not wrapped: oldest is at index 0
         actualIdx = index;
@@ -353,12 +584,530 @@ uint32_t CookSession::getTotalPointCount() const {
     return _totalPoints;
 }
 
-void CookSession::setDataSources(TempGetter pitFn, TempGetter meat1Fn, TempGetter meat2Fn,
-                                  PctGetter fanFn, PctGetter damperFn, FlagGetter flagFn) {
-    _getPitTemp   = pitFn;
-    _getMeat1Temp = meat1Fn;
-    _getMeat2Temp = meat2Fn;
+uint32_t CookSession::readPoints(uint32_t first, DataPoint* out, uint32_t maxCount) const {
+    if (first >= _totalPoints || maxCount == 0) return 0;
+    if (maxCount > _totalPoints - first) maxCount = _totalPoints - first;
+
+    uint32_t ramFirst = getFirstRamIndex();
+    uint32_t n = 0;
+
+    // Older than the ring: page from the session log. Every point below
+    // ramFirst has been flushed, in order.
+    if (first < ramFirst) {
+        uint32_t want = ramFirst - first;
+        if (want > maxCount) want = maxCount;
+        n = readLog(first, out, want);
+        if (n < want) return n;
+    }
+
+    // Remainder from the RAM ring
+    while (n < maxCount) {
+        const DataPoint* dp = getPoint(first + n - ramFirst);
+        if (!dp) break;
+        out[n++] = *dp;
+    }
+    return n;
+}
+
+uint32_t CookSession::readLog(uint32_t first, DataPoint* out, uint32_t maxCount) const {
+#ifndef NATIVE_BUILD
+    LogReader reader;
+    alignas(4) uint8_t block[SESSION_BLOCK_BYTES];
+    uint32_t n = 0;
+
+    int32_t b = sessionLogFind(readLogBlock, &reader, _logBlocks, first, _readHint, block);
+    while (b >= 0) {
+        SessionBlockHeader hdr;
+        if (!sessionDecodeBlock(block, hdr) || hdr.firstIndex > first + n) break;
+
+        // Packed records only decode forwards from the keyframe
+        SessionBlockPoints it;
+        DataPoint dp;
+        uint32_t idx = hdr.firstIndex;
+        sessionPointsBegin(it, block, hdr);
+        while (n < maxCount && sessionPointsNext(it, dp)) {
+            if (idx++ >= first + n) out[n++] = dp;
+        }
+
+        // Next read most likely continues here or in the following block
+        bool rest = idx < hdr.firstIndex + hdr.count;
+        _readHint = rest ? (uint32_t)b : (uint32_t)b + 1;
+        if (n == maxCount || rest || ++b >= (int32_t)_logBlocks) break;
+        if (!readLogBlock((uint32_t)b, block, &reader)) break;
+    }
+    return n;
+#else
+    (void)first;
+    (void)out;
+    (void)maxCount;
+    return 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Event journal
+// ---------------------------------------------------------------------------
+
+void CookSession::logEvent(SessionEventType type, int16_t value) {
+#ifndef NATIVE_BUILD
+    time_t now;
+    time(&now);
+    logEvent(type, value, (uint32_t)now);
+#else
+    logEvent(type, value, 0);
+#endif
+}
+
+void CookSession::logEvent(SessionEventType type, int16_t value, uint32_t timestamp) {
+    if (!_active) return;
+    if (_events.record(timestamp, type, value) && _events.full()) {
+#ifndef NATIVE_BUILD
+        Serial.println("[SESSION] Event journal full; later changes won't be replayed.");
+#endif
+    }
+}
+
+void CookSession::flushEvents() {
+#ifndef NATIVE_BUILD
+    if (_eventsFlushed >= _events.count()) return;
+
+    File file = LittleFS.open(SESSION_EVENT_PATH, _eventsFlushed == 0 ? "w" : "a");
+    if (!file) {
+        Serial.printf("[SESSION] Failed to open %s for writing!\n", SESSION_EVENT_PATH);
+        return;
+    }
+    for (uint16_t i = _eventsFlushed; i < _events.count(); i++) {
+        const SessionEvent& e = _events.event(i);
+        counterAdd(Counter::SESSION_FLUSH_BYTES, file.write((const uint8_t*)&e, sizeof(SessionEvent)));
+    }
+    file.close();
+    _eventsFlushed = _events.count();
+#endif
+}
+
+void CookSession::loadEvents() {
+    _events.clear();
+    _eventsFlushed = 0;
+
+#ifndef NATIVE_BUILD
+    File file = LittleFS.open(SESSION_EVENT_PATH, "r");
+    if (!file) return;
+
+    // A torn last record (short read or bad checksum) ends the journal
+    static SessionEvent records[SESSION_EVENT_CAPACITY];
+    uint16_t n = file.read((uint8_t*)records, sizeof(records)) / sizeof(SessionEvent);
+    bool longer = file.size() > n * sizeof(SessionEvent);
+    file.close();
+
+    _eventsFlushed = _events.load(records, n);
+    // Anything past a bad record is rewritten from scratch on the next flush
+    if (_eventsFlushed < n || longer) _eventsFlushed = 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Archive
+// ---------------------------------------------------------------------------
+
+void CookSession::archiveSession() {
+#ifndef NATIVE_BUILD
+    if (_totalPoints == 0) return;
+
+    // Everything onto the log before its files move
+    flush();
+
+    SessionArchiveEntry e;
+    memset(&e, 0, sizeof(e));
+    e.startTime = _startTime;
+    e.points = _flushedToIndex;
+    memcpy(e.peak, _peak, sizeof(e.peak));
+    const DataPoint* last = getPoint(_count - 1);
+    if (last && last->timestamp > _startTime) e.durationSec = last->timestamp - _startTime;
+
+    uint32_t id = _archive.nextId();
+    char from[32], to[32];
+
+    uint32_t segments = (_logBlocks + SESSION_SEGMENT_BLOCKS - 1) / SESSION_SEGMENT_BLOCKS;
+    for (uint32_t seg = 0; seg < segments; seg++) {
+        logSegmentPath(from, sizeof(from), seg);
+        snprintf(to, sizeof(to), SESSION_ARCHIVE_LOG_PATH, (unsigned)id, (unsigned)seg);
+        File f = LittleFS.open(from, "r");
+        if (!f) break;
+        e.bytes += f.size();
+        f.close();
+        if (!LittleFS.rename(from, to)) break;
+        e.segments++;
+    }
+    for (uint8_t l = 1; l <= SESSION_ROLLUP_LEVELS; l++) {
+        snprintf(from, sizeof(from), SESSION_ROLLUP_PATH, (unsigned)l);
+        snprintf(to, sizeof(to), SESSION_ARCHIVE_ROLLUP_PATH, (unsigned)id, (unsigned)l);
+        if (!LittleFS.exists(from)) continue;
+        File f = LittleFS.open(from, "r");
+        if (f) {
+            e.bytes += f.size();
+            f.close();
+        }
+        LittleFS.rename(from, to);
+    }
+    snprintf(to, sizeof(to), SESSION_ARCHIVE_EVENT_PATH, (unsigned)id);
+    if (LittleFS.exists(SESSION_EVENT_PATH)) {
+        File f = LittleFS.open(SESSION_EVENT_PATH, "r");
+        if (f) {
+            e.bytes += f.size();
+            f.close();
+        }
+        LittleFS.rename(SESSION_EVENT_PATH, to);
+    }
+
+    if (e.segments == 0) {
+        Serial.println("[SESSION] Nothing on flash to archive.");
+        return;
+    }
+
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    uint8_t n = _archive.add(e, evicted, SESSION_ARCHIVE_MAX);
+    for (uint8_t i = 0; i < n; i++) removeArchivedCook(evicted[i]);
+    saveArchiveIndex();
+
+    Serial.printf("[SESSION] Archived cook %u (%u points, %u bytes); %u rotated out.\n",
+                  (unsigned)id, e.points, e.bytes, n);
+#endif
+}
+
+void CookSession::loadArchiveIndex() {
+    _archive.clear();
+#ifndef NATIVE_BUILD
+    if (!LittleFS.exists(SESSION_ARCHIVE_DIR)) LittleFS.mkdir(SESSION_ARCHIVE_DIR);
+    if (!LittleFS.exists(SESSION_ARCHIVE_INDEX)) return;
+
+    // Sized for an index from a build with more channels
+    static uint8_t image[SESSION_ARCHIVE_IMAGE_MAX];
+    File f = LittleFS.open(SESSION_ARCHIVE_INDEX, "r");
+    if (!f) return;
+    size_t got = f.read(image, sizeof(image));
+    f.close();
+
+    if (!_archive.deserialize(image, got)) {
+        _archive.clear();
+        Serial.println("[SESSION] Archive index unreadable; past cooks not listed.");
+        return;
+    }
+    Serial.printf("[SESSION] Archive: %u past cooks, %u bytes.\n",
+                  _archive.count(), _archive.totalBytes());
+#endif
+}
+
+void CookSession::saveArchiveIndex() {
+#ifndef NATIVE_BUILD
+    static uint8_t image[sizeof(SessionArchiveIndex) + 32];
+    size_t len = _archive.serialize(image, sizeof(image));
+
+    // Write aside and rename over, so a power cut keeps the old index
+    static const char* tmp = SESSION_ARCHIVE_INDEX ".tmp";
+    File f = LittleFS.open(tmp, "w");
+    if (!f) {
+        Serial.println("[SESSION] Failed to write archive index!");
+        return;
+    }
+    bool ok = f.write(image, len) == len;
+    f.close();
+    if (ok) LittleFS.rename(tmp, SESSION_ARCHIVE_INDEX);
+    else LittleFS.remove(tmp);
+#endif
+}
+
+void CookSession::removeArchivedCook(uint32_t id) {
+#ifndef NATIVE_BUILD
+    char path[32];
+    for (uint32_t seg = 0; seg < SESSION_LOG_MAX_SEGMENTS; seg++) {
+        snprintf(path, sizeof(path), SESSION_ARCHIVE_LOG_PATH, (unsigned)id, (unsigned)seg);
+        if (!LittleFS.exists(path)) break;
+        LittleFS.remove(path);
+    }
+    for (uint8_t l = 1; l <= SESSION_ROLLUP_LEVELS; l++) {
+        snprintf(path, sizeof(path), SESSION_ARCHIVE_ROLLUP_PATH, (unsigned)id, (unsigned)l);
+        if (LittleFS.exists(path)) LittleFS.remove(path);
+    }
+    snprintf(path, sizeof(path), SESSION_ARCHIVE_EVENT_PATH, (unsigned)id);
+    if (LittleFS.exists(path)) LittleFS.remove(path);
+#else
+    (void)id;
+#endif
+}
+
+void CookSession::removeArchive() {
+#ifndef NATIVE_BUILD
+    File dir = LittleFS.open(SESSION_ARCHIVE_DIR);
+    if (!dir || !dir.isDirectory()) return;
+
+    char path[48];
+    File f = dir.openNextFile();
+    while (f) {
+        snprintf(path, sizeof(path), "%s/%s", SESSION_ARCHIVE_DIR, f.name());
+        f.close();
+        LittleFS.remove(path);
+        f = dir.openNextFile();
+    }
+    dir.close();
+    LittleFS.rmdir(SESSION_ARCHIVE_DIR);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Rollup tiers
+// ---------------------------------------------------------------------------
+
+void CookSession::resetRollups() {
+    memset(_rollupCount, 0, sizeof(_rollupCount));
+    memset(_rollupFlushed, 0, sizeof(_rollupFlushed));
+    memset(_rollupTruncated, 0, sizeof(_rollupTruncated));
+    memset(_accum, 0, sizeof(_accum));
+}
+
+void CookSession::accumulateRollups(const DataPoint& dp) {
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+        accumulateLevel(l, dp);
+    }
+}
+
+void CookSession::accumulateLevel(uint8_t l, const DataPoint& dp) {
+    RollupAccum& a = _accum[l];
+    if (a.n == 0) {
+        memset(&a, 0, sizeof(a));
+        a.timestamp = dp.timestamp;
+    }
+
+    uint16_t disc = dpDiscMask(dp);
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        if (disc & (1u << c)) continue;
+        int16_t t = dp.temp[c];
+        if (a.valid[c] == 0 || t < a.min[c]) a.min[c] = t;
+        if (a.valid[c] == 0 || t > a.max[c]) a.max[c] = t;
+        a.sum[c] += t;
+        a.valid[c]++;
+    }
+    a.fanSum    += dp.fanPct;
+    a.damperSum += dp.damperPct;
+    a.flags     |= dp.flags & ~DP_FLAG_DISC_MASK;
+    a.alarmExt  |= dp.alarmExt;
+    a.n++;
+
+    if (a.n < kRollupFactor[l]) return;
+
+    // Bucket complete: emit it, or mark the tier as no longer covering the cook
+    if (_rollupCount[l] < _rollupCapacity) {
+        closeBucket(a, _rollup[l][_rollupCount[l]++]);
+    } else {
+        _rollupTruncated[l] = true;
+    }
+    a.n = 0;
+}
+
+void CookSession::closeBucket(const RollupAccum& a, RollupPoint& r) {
+    r.timestamp = a.timestamp;
+    r.flags = a.flags;
+    r.alarmExt = a.alarmExt;
+    uint16_t rDisc = 0;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        if (a.valid[c] > 0) {
+            r.tMin[c] = a.min[c];
+            r.tMax[c] = a.max[c];
+            r.tAvg[c] = (int16_t)(a.sum[c] / (int32_t)a.valid[c]);
+        } else {
+            r.tMin[c] = r.tMax[c] = r.tAvg[c] = 0;
+            rDisc |= (uint16_t)(1u << c);
+        }
+    }
+    dpSetDiscMask(r, rDisc);
+    r.fanPct    = (uint8_t)(a.fanSum / a.n);
+    r.damperPct = (uint8_t)(a.damperSum / a.n);
+}
+
+bool CookSession::hasPartialBucket(uint8_t l) const {
+    return _accum[l].n > 0 && !_rollupTruncated[l];
+}
+
+void rollupFileHeaderInit(RollupFileHeader& hdr, uint8_t level) {
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic     = SESSION_ROLLUP_MAGIC;
+    hdr.version   = SESSION_ROLLUP_VERSION;
+    hdr.channels  = NUM_PROBES;
+    hdr.level     = level;
+    hdr.pointSize = sizeof(RollupPoint);
+}
+
+bool rollupFileHeaderValid(const RollupFileHeader& hdr, uint8_t level) {
+    return hdr.magic == SESSION_ROLLUP_MAGIC && hdr.version == SESSION_ROLLUP_VERSION &&
+           hdr.channels == NUM_PROBES && hdr.level == level &&
+           hdr.pointSize == sizeof(RollupPoint);
+}
+
+void CookSession::flushRollups() {
+#ifndef NATIVE_BUILD
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+        if (_rollupFlushed[l] >= _rollupCount[l]) continue;
+
+        char path[24];
+        snprintf(path, sizeof(path), SESSION_ROLLUP_PATH, (unsigned)(l + 1));
+        File file = LittleFS.open(path, _rollupFlushed[l] == 0 ? "w" : "a");
+        if (!file) {
+            Serial.printf("[SESSION] Failed to open %s for writing!\n", path);
+            continue;
+        }
+        if (_rollupFlushed[l] == 0) {
+            RollupFileHeader hdr;
+            rollupFileHeaderInit(hdr, l + 1);
+            counterAdd(Counter::SESSION_FLUSH_BYTES, file.write((uint8_t*)&hdr, sizeof(hdr)));
+        }
+        uint32_t n = _rollupCount[l] - _rollupFlushed[l];
+        counterAdd(Counter::SESSION_FLUSH_BYTES,
+                   file.write((uint8_t*)&_rollup[l][_rollupFlushed[l]], n * sizeof(RollupPoint)));
+        file.close();
+        _rollupFlushed[l] = _rollupCount[l];
+    }
+#endif
+}
+
+void CookSession::loadRollups() {
+    resetRollups();
+
+#ifndef NATIVE_BUILD
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+        char path[24];
+        snprintf(path, sizeof(path), SESSION_ROLLUP_PATH, (unsigned)(l + 1));
+        File file = LittleFS.open(path, "r");
+        if (!file) continue;
+
+        // Another layout (older firmware, another build profile's channel
+        // count): leave the tier empty so it's rebuilt from the log below
+        // and the file rewritten on the next flush
+        RollupFileHeader hdr;
+        if (file.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) ||
+            !rollupFileHeaderValid(hdr, l + 1)) {
+            file.close();
+            Serial.printf("[SESSION] %s has another format, rebuilding it\n", path);
+            continue;
+        }
+
+        // Never trust more buckets than the raw points can account for
+        uint32_t stored = (file.size() - sizeof(hdr)) / sizeof(RollupPoint);
+        uint32_t n = stored;
+        uint32_t maxN = _totalPoints / kRollupFactor[l];
+        if (n > maxN) n = maxN;
+        if (n > _rollupCapacity) n = _rollupCapacity;
+
+        bool stale = stored > n;
+        size_t got = file.read((uint8_t*)_rollup[l], n * sizeof(RollupPoint));
+        file.close();
+        _rollupCount[l] = got / sizeof(RollupPoint);
+        // A file longer than the raw data is rewritten from scratch on the next flush
+        _rollupFlushed[l] = stale ? 0 : _rollupCount[l];
+    }
+#endif
+
+    // A full tier can't take more buckets, so it needn't be re-fed
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+        if (_rollupCount[l] == _rollupCapacity &&
+            _totalPoints >= (_rollupCapacity + 1) * kRollupFactor[l]) {
+            _rollupTruncated[l] = true;
+        }
+    }
+
+    // Re-accumulate each tier from the end of its last stored bucket. Usually
+    // that's just the in-progress bucket; a missing tier file (older firmware)
+    // is rebuilt from the raw points once, here, and flushed on the next flush().
+    uint32_t start = _totalPoints;
+    for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+        if (_rollupTruncated[l]) continue;
+        uint32_t s = _rollupCount[l] * kRollupFactor[l];
+        if (s < start) start = s;
+    }
+
+    DataPoint page[SESSION_READ_PAGE];
+    uint32_t idx = start;
+    while (idx < _totalPoints) {
+        uint32_t n = readPoints(idx, page, SESSION_READ_PAGE);
+        if (n == 0) break;
+        for (uint32_t i = 0; i < n; i++) {
+            for (uint8_t l = 0; l < SESSION_ROLLUP_LEVELS; l++) {
+                // Feed only tiers that haven't already stored this point
+                if (!_rollupTruncated[l] &&
+                    idx + i >= _rollupCount[l] * kRollupFactor[l] + _accum[l].n) {
+                    accumulateLevel(l, page[i]);
+                }
+            }
+        }
+        idx += n;
+    }
+}
+
+uint32_t CookSession::getLevelCount(uint8_t level) const {
+    if (level == 0) return _totalPoints;
+    if (level > SESSION_ROLLUP_LEVELS) return 0;
+    return _rollupCount[level - 1] + (hasPartialBucket(level - 1) ? 1 : 0);
+}
+
+uint32_t CookSession::getLevelFactor(uint8_t level) const {
+    if (level == 0 || level > SESSION_ROLLUP_LEVELS) return 1;
+    return kRollupFactor[level - 1];
+}
+
+uint8_t CookSession::selectLevel(uint32_t maxPoints) const {
+    if (_totalPoints <= maxPoints) return 0;
+    for (uint8_t l = 1; l <= SESSION_ROLLUP_LEVELS; l++) {
+        // The in-progress bucket is read as one more point
+        if (!_rollupTruncated[l - 1] && _rollupCount[l - 1] + 1 <= maxPoints) return l;
+    }
+    return SESSION_ROLLUP_LEVELS;
+}
+
+uint32_t CookSession::readLevel(uint8_t level, uint32_t first, RollupPoint* out,
+                                uint32_t maxCount) const {
+    if (level > SESSION_ROLLUP_LEVELS) return 0;
+
+    if (level > 0) {
+        // Completed buckets, then the one being filled as the last point so
+        // the tier reaches the newest sample
+        uint8_t l = level - 1;
+        uint32_t count = _rollupCount[l];
+        uint32_t total = count + (hasPartialBucket(l) ? 1 : 0);
+        if (first >= total) return 0;
+        if (maxCount > total - first) maxCount = total - first;
+        uint32_t stored = first < count ? count - first : 0;
+        if (stored > maxCount) stored = maxCount;
+        memcpy(out, &_rollup[l][first], stored * sizeof(RollupPoint));
+        if (stored < maxCount) closeBucket(_accum[l], out[stored]);
+        return maxCount;
+    }
+
+    // Raw level: page DataPoints through the caller's buffer, widening in
+    // place from the back so a RollupPoint never overwrites an unread point
+    static_assert(sizeof(RollupPoint) >= sizeof(DataPoint), "in-place widening");
+    DataPoint* raw = (DataPoint*)out;
+    uint32_t n = readPoints(first, raw, maxCount);
+    for (uint32_t i = n; i-- > 0; ) {
+        DataPoint dp = raw[i];
+        RollupPoint& r = out[i];
+        r.timestamp = dp.timestamp;
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            r.tMin[c] = r.tMax[c] = r.tAvg[c] = dp.temp[c];
+        }
+        r.fanPct    = dp.fanPct;
+        r.damperPct = dp.damperPct;
+        r.flags     = dp.flags;
+        r.discExt   = dp.discExt;
+        r.alarmExt  = dp.alarmExt;
+    }
+    return n;
+}
+
+void CookSession::setDataSources(TempGetter tempFn, ConnectedGetter connectedFn,
+                                  PctGetter fanFn, PctGetter damperFn, FlagGetter flagFn,
+                                  AlarmGetter alarmFn) {
+    _getTemp      = tempFn;
+    _isConnected  = connectedFn;
     _getFanPct    = fanFn;
     _getDamperPct = damperFn;
     _getFlags     = flagFn;
+    _getAlarms    = alarmFn;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "config.h"
+#include "data_point.h"
+#include "session_archive.h"
+#include "session_events.h"
 #include <stdint.h>
 
 #ifndef NATIVE_BUILD
@@ -8,30 +11,78 @@
 #include <ArduinoJson.h>
 #endif
 
-// Compact data point struct (13 bytes) for RAM and flash storage
-struct DataPoint {
-    uint32_t timestamp;     // Unix epoch seconds
-    int16_t  pitTemp;       // Pit temperature * 10 (e.g., 2255 = 225.5F)
-    int16_t  meat1Temp;     // Meat 1 temperature * 10
-    int16_t  meat2Temp;     // Meat 2 temperature * 10
-    uint8_t  fanPct;        // Fan speed 0-100%
-    uint8_t  damperPct;     // Damper position 0-100%
-    uint8_t  flags;         // Bit flags (lid-open, alarms, errors)
+// Channel order for RollupPoint temperature arrays (the probe channel table)
+#define ROLLUP_PIT    PROBE_PIT
+#define ROLLUP_MEAT1  PROBE_MEAT1
+#define ROLLUP_MEAT2  PROBE_MEAT2
+
+// One downsampled bucket. Temps are *10 like DataPoint. A channel with no
+// connected sample in the bucket is marked disconnected (dpDiscMask); other
+// flag bits and alarmExt are OR'd across the bucket.
+struct RollupPoint {
+    uint32_t timestamp;     // Timestamp of the bucket's first sample
+    int16_t  tMin[NUM_PROBES];
+    int16_t  tMax[NUM_PROBES];
+    int16_t  tAvg[NUM_PROBES];
+    uint8_t  fanPct;        // Average fan speed
+    uint8_t  damperPct;     // Average damper position
+    uint8_t  flags;
+    uint8_t  discExt;       // As DataPoint::discExt
+    uint8_t  alarmExt;      // As DataPoint::alarmExt
+};
+
+// Header at the start of each rollup tier file (SESSION_ROLLUP_PATH). A
+// file written with another channel count or RollupPoint layout is ignored
+// and the tier rebuilt from the session log.
+#define SESSION_ROLLUP_MAGIC    0x4C4C4F52UL   // "ROLL"
+#define SESSION_ROLLUP_VERSION  2
+
+struct RollupFileHeader {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  channels;      // NUM_PROBES
+    uint8_t  level;         // 1..SESSION_ROLLUP_LEVELS
+    uint8_t  reserved;
+    uint16_t pointSize;     // sizeof(RollupPoint)
+    uint16_t reserved2;
 };
 
-// Flag bits for DataPoint.flags
-#define DP_FLAG_LID_OPEN      0x01
-#define DP_FLAG_ALARM_PIT     0x02
-#define DP_FLAG_ALARM_MEAT1   0x04
-#define DP_FLAG_ALARM_MEAT2   0x08
-#define DP_FLAG_ERROR_FIREOUT 0x10
-#define DP_FLAG_PIT_DISC      0x20
-#define DP_FLAG_MEAT1_DISC    0x40
-#define DP_FLAG_MEAT2_DISC    0x80
+void rollupFileHeaderInit(RollupFileHeader& hdr, uint8_t level);
+bool rollupFileHeaderValid(const RollupFileHeader& hdr, uint8_t level);
+
+// Longest export row: CSV or JSON with every channel at its widest
+#define EXPORT_LINE_MAX (72 + 20 * NUM_PROBES)
+
+// Export formats for streaming downloads
+enum class ExportFormat { CSV, JSON };
+
+// Resumable position in a streaming export. Holds one page of points and
+// one formatted row, so any output chunk size works, down to one byte.
+struct ExportCursor {
+    ExportFormat format;
+    uint8_t      stage;         // 0 header, 1 rows, 2 footer, 3 done
+    bool         first;         // No row written yet (JSON comma handling)
+    uint32_t     next;          // Absolute index of the next point to page in
+    DataPoint    page[SESSION_READ_PAGE];
+    uint16_t     pageLen;
+    uint16_t     pagePos;
+    char         line[EXPORT_LINE_MAX];   // Formatted row not yet fully copied out
+    uint16_t     lineLen;
+    uint16_t     lineOff;
+};
 
 class CookSession {
 public:
+    // Ring and rollup-tier sizes are picked when storage is first needed:
+    // SESSION_PSRAM_* in PSRAM when the board has it (SESSION_USE_PSRAM),
+    // SESSION_BUFFER_SIZE / SESSION_ROLLUP_CAPACITY in internal RAM if not.
+    // The second form asks for specific sizes.
     CookSession();
+    CookSession(uint32_t bufferCapacity, uint32_t rollupCapacity);
+    ~CookSession();
+
+    CookSession(const CookSession&) = delete;
+    CookSession& operator=(const CookSession&) = delete;
 
     // Initialize buffer and attempt to recover a session from LittleFS.
     // Call once from setup().
@@ -40,7 +91,8 @@ public:
     // Sample a data point if the interval has elapsed. Call every loop().
     void update();
 
-    // Start a new cook session (clears buffer, creates new file)
+    // Start a new cook session. The previous cook, if it has any points,
+    // is moved into the archive first; then the buffer is cleared.
     void startSession();
 
     // End the current session and flush remaining data
@@ -49,21 +101,44 @@ public:
     // Add a data point to the circular buffer
     void addPoint(const DataPoint& point);
 
-    // Force-flush the RAM buffer to LittleFS now
+    // Force-flush the RAM buffer to LittleFS now. Unflushed points are
+    // packed into the session log's CRC-framed blocks (see session_log.h).
     void flush();
 
-    // Load/recover session data from LittleFS on boot (power-loss recovery)
+    // Load/recover session data from LittleFS on boot (power-loss recovery).
+    // The log is replayed up to the last intact block.
     bool loadFromFlash();
 
     // Clear all session data (RAM + file)
     void clear();
 
-    // Generate CSV string of all data points
-    // WARNING: This can be large. Caller should use chunked transfer or stream.
-    String toCSV() const;
+    // Remove the session log, rollup tier files and any pre-log session
+    // file from LittleFS (also used by factory reset)
+    static void removeStoredData();
+
+    // Highest connected temperature this cook (*10) for a probe channel,
+    // or SESSION_PEAK_NONE if the probe never reported
+    int16_t getPeak(uint8_t channel) const { return channel < NUM_PROBES ? _peak[channel] : SESSION_PEAK_NONE; }
+
+    // Journal a control change with the current time (see session_events.h).
+    // Ignored while no session is recording, and for unchanged state.
+    void logEvent(SessionEventType type, int16_t value);
+    void logEvent(SessionEventType type, int16_t value, uint32_t timestamp);
+
+    // This cook's event journal, for merging into history replay
+    const SessionEventJournal& getEvents() const { return _events; }
 
-    // Generate JSON array of all data points
-    String toJSON() const;
+    // Past cooks, summarised from the archive index loaded by begin()
+    const SessionArchiveIndex& getArchive() const { return _archive; }
+
+    // Delete every archived cook and the index (factory reset)
+    static void removeArchive();
+
+    // Streaming export of the full cook with a fixed-size cursor.
+    // exportChunk() fills up to maxLen bytes and returns the count,
+    // 0 once the export is complete.
+    void beginExport(ExportCursor& cursor, ExportFormat format) const;
+    size_t exportChunk(ExportCursor& cursor, char* buf, size_t maxLen) const;
 
     // Number of stored data points
     uint32_t getPointCount() const;
@@ -83,18 +158,49 @@ public:
     // Get total number of points (including those on flash)
     uint32_t getTotalPointCount() const;
 
+    // Ring size in points and buckets per rollup tier (0 until allocated)
+    uint32_t getBufferCapacity() const { return _capacity; }
+    uint32_t getRollupCapacity() const { return _rollupCapacity; }
+
+    // Absolute index (0 = first point of the cook) of the oldest point in RAM
+    uint32_t getFirstRamIndex() const { return _totalPoints - _count; }
+
+    // Read up to maxCount points starting at absolute index `first`.
+    // Points still in RAM come from the ring; older ones are paged from
+    // the session log. Returns the number copied into out, stopping early
+    // rather than skipping if the flash read comes up short.
+    uint32_t readPoints(uint32_t first, DataPoint* out, uint32_t maxCount) const;
+
+    // Level-of-detail access. Level 0 is the raw points (min = max = avg);
+    // levels 1..SESSION_ROLLUP_LEVELS are the rollup tiers, maintained as
+    // points arrive and persisted next to the session log.
+    uint32_t getLevelCount(uint8_t level) const;
+    uint32_t getLevelFactor(uint8_t level) const;   // Raw samples per point
+
+    // Finest level that covers the whole cook in at most maxPoints points
+    uint8_t selectLevel(uint32_t maxPoints) const;
+
+    // Read up to maxCount points of a level starting at index first. A
+    // rollup level ends with its in-progress bucket, so its last point can
+    // change as samples arrive
+    uint32_t readLevel(uint8_t level, uint32_t first, RollupPoint* out, uint32_t maxCount) const;
+
     // Set function pointers for getting current sensor data
     // (called by update() to auto-fill data points)
-    typedef float (*TempGetter)();
+    typedef float (*TempGetter)(uint8_t probe);
+    typedef bool (*ConnectedGetter)(uint8_t probe);
     typedef uint8_t (*PctGetter)();
     typedef uint8_t (*FlagGetter)();
+    typedef uint16_t (*AlarmGetter)();   // As dpAlarmMask(), so channels 3+ are logged
 
-    void setDataSources(TempGetter pitFn, TempGetter meat1Fn, TempGetter meat2Fn,
-                        PctGetter fanFn, PctGetter damperFn, FlagGetter flagFn);
+    void setDataSources(TempGetter tempFn, ConnectedGetter connectedFn,
+                        PctGetter fanFn, PctGetter damperFn, FlagGetter flagFn,
+                        AlarmGetter alarmFn = nullptr);
 
 private:
-    // Circular buffer
-    DataPoint _buffer[SESSION_BUFFER_SIZE];
+    // Circular buffer (extRamAlloc'd by allocStorage())
+    DataPoint* _buffer;
+    uint32_t  _capacity;      // Ring size in points
     uint32_t  _head;          // Next write position
     uint32_t  _count;         // Number of valid entries in buffer
     bool      _wrapped;       // Buffer has wrapped around
@@ -111,11 +217,73 @@ private:
     // Number of points written to flash (for flush tracking)
     uint32_t _flushedToIndex;
 
+    // Session log position: valid blocks on flash, and the block after the
+    // last one read (sequential paging skips the search)
+    uint32_t _logBlocks;
+    mutable uint32_t _readHint;
+
+    // Last block is only partly filled and is rewritten by the next flush;
+    // _tailFirst is the absolute index of its first point
+    bool     _tailOpen;
+    uint32_t _tailFirst;
+
+    // Read points [first, first + maxCount) from the session log only
+    uint32_t readLog(uint32_t first, DataPoint* out, uint32_t maxCount) const;
+
+    // Highest connected temp per channel this cook (*10, SESSION_PEAK_NONE)
+    int16_t _peak[NUM_PROBES];
+    void updatePeaks(const DataPoint& dp);
+
+    // Event journal and how much of it is on flash
+    SessionEventJournal _events;
+    uint16_t _eventsFlushed;
+    void flushEvents();
+    void loadEvents();
+
+    // Archive of past cooks
+    SessionArchiveIndex _archive;
+    void archiveSession();
+    void loadArchiveIndex();
+    void saveArchiveIndex();
+    static void removeArchivedCook(uint32_t id);
+
+    // Rollup tiers: completed buckets plus the bucket being filled
+    struct RollupAccum {
+        int32_t  sum[NUM_PROBES];
+        int16_t  min[NUM_PROBES];
+        int16_t  max[NUM_PROBES];
+        uint16_t valid[NUM_PROBES];
+        uint32_t fanSum;
+        uint32_t damperSum;
+        uint32_t timestamp;
+        uint16_t n;
+        uint8_t  flags;
+        uint8_t  alarmExt;
+    };
+
+    RollupPoint* _rollup[SESSION_ROLLUP_LEVELS];          // One allocation, split per tier
+    uint32_t    _rollupCapacity;                          // Buckets per tier
+    uint32_t    _rollupCount[SESSION_ROLLUP_LEVELS];
+    uint32_t    _rollupFlushed[SESSION_ROLLUP_LEVELS];   // Buckets already on flash
+    bool        _rollupTruncated[SESSION_ROLLUP_LEVELS]; // Ran out of capacity
+    RollupAccum _accum[SESSION_ROLLUP_LEVELS];
+
+    // Allocate the ring and tiers on first use. False if out of memory.
+    bool allocStorage();
+
+    void resetRollups();
+    void accumulateRollups(const DataPoint& dp);
+    static void closeBucket(const RollupAccum& a, RollupPoint& r);
+    bool hasPartialBucket(uint8_t l) const;
+    void accumulateLevel(uint8_t level, const DataPoint& dp);
+    void flushRollups();
+    void loadRollups();
+
     // Data source callbacks
-    TempGetter _getPitTemp;
-    TempGetter _getMeat1Temp;
-    TempGetter _getMeat2Temp;
+    TempGetter      _getTemp;
+    ConnectedGetter _isConnected;
     PctGetter  _getFanPct;
     PctGetter  _getDamperPct;
     FlagGetter _getFlags;
+    AlarmGetter _getAlarms;
 };
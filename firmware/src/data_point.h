@@ -0,0 +1,66 @@
+#pragma once
+
+#include "probe_channels.h"
+#include <stdint.h>
+
+// Compact data point struct for RAM and flash storage (16 bytes with the
+// stock three channels, 2 more per extra channel)
+struct DataPoint {
+    uint32_t timestamp;         // Unix epoch seconds
+    int16_t  temp[NUM_PROBES];  // Per channel (probe_channels.h), * 10 (e.g., 2255 = 225.5F)
+    uint8_t  fanPct;            // Fan speed 0-100%
+    uint8_t  damperPct;         // Damper position 0-100%
+    uint8_t  flags;             // Bit flags (lid-open, alarms, errors)
+    uint8_t  discExt;           // Disconnected bits for channels 3+ (bit 0 = channel 3)
+    uint8_t  alarmExt;          // Done-alarm bits for channels 3+ (bit 0 = channel 3)
+};
+
+// Flag bits for DataPoint.flags
+#define DP_FLAG_LID_OPEN      0x01
+#define DP_FLAG_ALARM_PIT     0x02
+#define DP_FLAG_ALARM_MEAT1   0x04
+#define DP_FLAG_ALARM_MEAT2   0x08
+#define DP_FLAG_ERROR_FIREOUT 0x10
+#define DP_FLAG_PIT_DISC      0x20
+#define DP_FLAG_MEAT1_DISC    0x40
+#define DP_FLAG_MEAT2_DISC    0x80
+
+#define DP_FLAG_DISC_MASK     (DP_FLAG_PIT_DISC | DP_FLAG_MEAT1_DISC | DP_FLAG_MEAT2_DISC)
+#define DP_FLAG_DISC_SHIFT    5
+
+#define DP_FLAG_ALARM_MASK    (DP_FLAG_ALARM_PIT | DP_FLAG_ALARM_MEAT1 | DP_FLAG_ALARM_MEAT2)
+#define DP_FLAG_ALARM_SHIFT   1
+
+// Disconnected channels as one mask, bit c = channel c. The first three
+// live in flags (their bits predate the channel table), the rest in
+// discExt. Works for DataPoint and RollupPoint.
+template <typename P>
+inline uint16_t dpDiscMask(const P& p) {
+    return (uint16_t)(((p.flags & DP_FLAG_DISC_MASK) >> DP_FLAG_DISC_SHIFT) |
+                      ((uint16_t)p.discExt << 3));
+}
+
+template <typename P>
+inline void dpSetDiscMask(P& p, uint16_t mask) {
+    p.flags   = (uint8_t)((p.flags & ~DP_FLAG_DISC_MASK) | ((mask & 0x07) << DP_FLAG_DISC_SHIFT));
+    p.discExt = (uint8_t)(mask >> 3);
+}
+
+template <typename P>
+inline bool dpDisconnected(const P& p, uint8_t channel) {
+    return (dpDiscMask(p) >> channel) & 1;
+}
+
+// Alarms as one mask, bit 0 = pit high or low, bit c = channel c's done
+// alarm. Split between flags and alarmExt as dpDiscMask() is.
+template <typename P>
+inline uint16_t dpAlarmMask(const P& p) {
+    return (uint16_t)(((p.flags & DP_FLAG_ALARM_MASK) >> DP_FLAG_ALARM_SHIFT) |
+                      ((uint16_t)p.alarmExt << 3));
+}
+
+template <typename P>
+inline void dpSetAlarmMask(P& p, uint16_t mask) {
+    p.flags    = (uint8_t)((p.flags & ~DP_FLAG_ALARM_MASK) | ((mask & 0x07) << DP_FLAG_ALARM_SHIFT));
+    p.alarmExt = (uint8_t)(mask >> 3);
+}
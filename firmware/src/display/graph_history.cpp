@@ -1,30 +1,108 @@
 #include "graph_history.h"
 
-GraphHistory::GraphHistory() : _count(0) {}
+#include <string.h>
 
-void GraphHistory::addPoint(float pit, float meat1, float meat2, float setpoint,
-                             bool pitDisc, bool meat1Disc, bool meat2Disc) {
+GraphHistory::GraphHistory(GraphCondense mode) : _count(0), _mode(mode), _loadRun(1) {
+    memset(&_load, 0, sizeof(_load));
+}
+
+bool GraphHistory::addPoint(const float* temps, const bool* disc, float setpoint) {
+    bool condensed = false;
     if (_count >= GRAPH_HISTORY_SIZE) {
         condense();
+        condensed = true;
     }
 
     GraphSlot& slot = _buffer[_count];
-    slot.pit = pit;
-    slot.meat1 = meat1;
-    slot.meat2 = meat2;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        slot.temp[c] = temps[c];
+        slot.valid[c] = !disc[c];
+    }
     slot.setpoint = setpoint;
-    slot.pitValid = !pitDisc;
-    slot.meat1Valid = !meat1Disc;
-    slot.meat2Valid = !meat2Disc;
     _count++;
+    return condensed;
 }
 
 void GraphHistory::clear() {
     _count = 0;
 }
 
+void GraphHistory::beginLoad(uint32_t total) {
+    clear();
+    memset(&_load, 0, sizeof(_load));
+
+    // Shortest power-of-two run that fits all points in the buffer. An
+    // ENVELOPE run of 2 * _loadRun points yields two slots, so the slot
+    // count comes out the same either way.
+    _loadRun = 1;
+    while ((total + _loadRun - 1) / _loadRun > GRAPH_HISTORY_SIZE) _loadRun *= 2;
+}
+
+void GraphHistory::loadPoint(const float* temps, const bool* disc, float setpoint) {
+    if (_loadRun == 1) {
+        if (_count < GRAPH_HISTORY_SIZE) addPoint(temps, disc, setpoint);
+        return;
+    }
+
+    LoadAccum& a = _load;
+    for (uint8_t s = 0; s < NUM_PROBES; s++) {
+        if (disc[s]) continue;
+        float v = temps[s];
+        if (a.valid[s] == 0 || v < a.lo[s]) { a.lo[s] = v; a.loAt[s] = a.n; }
+        if (a.valid[s] == 0 || v > a.hi[s]) { a.hi[s] = v; a.hiAt[s] = a.n; }
+        a.sum[s] += v;
+        a.valid[s]++;
+    }
+    if (a.n == 0) a.spFirst = setpoint;
+    a.spLast = setpoint;
+    a.spSum += setpoint;
+    a.n++;
+
+    uint32_t runLen = _mode == GraphCondense::ENVELOPE ? _loadRun * 2 : _loadRun;
+    if (a.n >= runLen) emitLoadRun();
+}
+
+void GraphHistory::endLoad() {
+    if (_load.n > 0) emitLoadRun();
+}
+
+void GraphHistory::emitLoadRun() {
+    LoadAccum& a = _load;
+    bool envelope = _mode == GraphCondense::ENVELOPE && a.n > 1;
+    uint8_t slots = envelope ? 2 : 1;
+    if (_count + slots > GRAPH_HISTORY_SIZE) {
+        memset(&a, 0, sizeof(a));
+        return;
+    }
+
+    GraphSlot& first  = _buffer[_count];
+    GraphSlot& second = _buffer[_count + slots - 1];
+    for (uint8_t s = 0; s < NUM_PROBES; s++) {
+        bool valid = a.valid[s] > 0;
+        first.valid[s] = second.valid[s] = valid;
+        if (!valid) {
+            first.temp[s] = second.temp[s] = 0.0f;
+        } else if (envelope) {
+            // Min and max in the order they happened, as condenseEnvelope()
+            bool loFirst = a.loAt[s] <= a.hiAt[s];
+            first.temp[s]  = loFirst ? a.lo[s] : a.hi[s];
+            second.temp[s] = loFirst ? a.hi[s] : a.lo[s];
+        } else {
+            first.temp[s] = a.sum[s] / (float)a.valid[s];
+        }
+    }
+    if (envelope) {
+        first.setpoint  = a.spFirst;
+        second.setpoint = a.spLast;
+    } else {
+        first.setpoint = a.spSum / (float)a.n;
+    }
+    _count += slots;
+    memset(&a, 0, sizeof(a));
+}
+
 const GraphSlot& GraphHistory::getSlot(uint16_t index) const {
-    static const GraphSlot empty = {0, 0, 0, 0, false, false, false};
+    static const GraphSlot empty = {};
     if (index >= _count) return empty;
     return _buffer[index];
 }
@@ -46,6 +124,14 @@ float GraphHistory::mergeValues(float a, bool aValid, float b, bool bValid, bool
 }
 
 void GraphHistory::condense() {
+    if (_mode == GraphCondense::ENVELOPE) {
+        condenseEnvelope();
+    } else {
+        condenseAverage();
+    }
+}
+
+void GraphHistory::condenseAverage() {
     uint16_t dst = 0;
     for (uint16_t i = 0; i < _count; i += 2) {
         if (i + 1 < _count) {
@@ -53,9 +139,9 @@ void GraphHistory::condense() {
             const GraphSlot& b = _buffer[i + 1];
             GraphSlot& out = _buffer[dst];
 
-            out.pit = mergeValues(a.pit, a.pitValid, b.pit, b.pitValid, out.pitValid);
-            out.meat1 = mergeValues(a.meat1, a.meat1Valid, b.meat1, b.meat1Valid, out.meat1Valid);
-            out.meat2 = mergeValues(a.meat2, a.meat2Valid, b.meat2, b.meat2Valid, out.meat2Valid);
+            for (uint8_t c = 0; c < NUM_PROBES; c++) {
+                out.temp[c] = mergeValues(a.temp[c], a.valid[c], b.temp[c], b.valid[c], out.valid[c]);
+            }
             out.setpoint = (a.setpoint + b.setpoint) * 0.5f;
         } else {
             _buffer[dst] = _buffer[i];
@@ -64,3 +150,50 @@ void GraphHistory::condense() {
     }
     _count = dst;
 }
+
+void GraphHistory::envelope(const GraphSlot* in, uint8_t n, uint8_t ch,
+                            GraphSlot& first, GraphSlot& second) {
+    int8_t lo = -1, hi = -1;
+    for (uint8_t i = 0; i < n; i++) {
+        if (!in[i].valid[ch]) continue;
+        if (lo < 0 || in[i].temp[ch] < in[lo].temp[ch]) lo = i;
+        if (hi < 0 || in[i].temp[ch] > in[hi].temp[ch]) hi = i;
+    }
+
+    if (lo < 0) {
+        first.valid[ch] = second.valid[ch] = false;
+        first.temp[ch] = second.temp[ch] = 0.0f;
+        return;
+    }
+
+    uint8_t a = lo < hi ? lo : hi;
+    uint8_t b = lo < hi ? hi : lo;
+    first.temp[ch]  = in[a].temp[ch];
+    second.temp[ch] = in[b].temp[ch];
+    first.valid[ch] = second.valid[ch] = true;
+}
+
+void GraphHistory::condenseEnvelope() {
+    uint16_t dst = 0;
+    for (uint16_t i = 0; i < _count; i += 4) {
+        uint8_t n = (_count - i) < 4 ? (uint8_t)(_count - i) : 4;
+
+        if (n <= 2) {
+            // Too short to halve; keep as-is
+            for (uint8_t k = 0; k < n; k++) _buffer[dst++] = _buffer[i + k];
+            continue;
+        }
+
+        // Bucket is read in full before slot dst/dst+1 (<= i) is written
+        GraphSlot in[4];
+        for (uint8_t k = 0; k < n; k++) in[k] = _buffer[i + k];
+
+        GraphSlot& first  = _buffer[dst];
+        GraphSlot& second = _buffer[dst + 1];
+        for (uint8_t c = 0; c < NUM_PROBES; c++) envelope(in, n, c, first, second);
+        first.setpoint  = in[0].setpoint;
+        second.setpoint = in[n - 1].setpoint;
+        dst += 2;
+    }
+    _count = dst;
+}
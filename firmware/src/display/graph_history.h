@@ -1,39 +1,75 @@
 #pragma once
 
+#include "../config.h"
+#include "../probe_channels.h"
 #include <stdint.h>
 
-#define GRAPH_HISTORY_SIZE 240
+#ifndef GRAPH_HISTORY_SIZE
+#define GRAPH_HISTORY_SIZE (kBuildProfile.graphHistorySize)  // Build profile; 240 stock
+#endif
+static_assert(GRAPH_HISTORY_SIZE % 4 == 0, "GRAPH_HISTORY_SIZE must condense by fours");
 
-// A single condensable graph data slot
+// How a full buffer is condensed to half its size
+enum class GraphCondense : uint8_t {
+    AVERAGE,    // Each adjacent pair becomes its average
+    ENVELOPE    // Each run of four becomes its min and max, in time order
+};
+
+// A single condensable graph data slot, one series per probe channel
 struct GraphSlot {
-    float pit;
-    float meat1;
-    float meat2;
+    float temp[NUM_PROBES];
     float setpoint;
-    bool pitValid;
-    bool meat1Valid;
-    bool meat2Valid;
+    bool  valid[NUM_PROBES];
 };
 
 // Adaptive-condensing graph history buffer.
-// Stores up to 240 slots. When full, merges all 240 into 120 by pairwise
-// averaging, then continues appending from slot 120. A 12-hour cook at 5s
-// intervals triggers ~5-6 merges; oldest points gradually represent wider
-// time spans while recent data stays detailed.
+// Stores up to 240 slots. When full, merges all 240 into 120, then continues
+// appending from slot 120. A 12-hour cook at 5s intervals triggers ~5-6
+// merges; oldest points gradually represent wider time spans while recent
+// data stays detailed.
+//
+// AVERAGE merges pairs, which smooths away short pit spikes and lid dips
+// after a few merges. ENVELOPE min-max buckets every four slots into two,
+// the lowest and highest value in the order they happened (per series), so
+// a line through the slots still reaches every extreme of the cook at the
+// same 240-slot memory cost. The setpoint keeps each bucket's first and
+// last value so steps stay sharp.
+//
+// Bulk load (session recovery) replaces the buffer in one pass instead of
+// replaying points through repeated condenses: with the point count known
+// up front, each slot covers a fixed power-of-two run of points (two slots
+// per doubled run in ENVELOPE mode), chosen so the whole range fits.
 //
 // Pure C++ — no LVGL or Arduino dependencies. Fully testable on native.
 class GraphHistory {
 public:
-    GraphHistory();
+    explicit GraphHistory(GraphCondense mode = GraphCondense::AVERAGE);
+
+    // Condense strategy for future merges (existing slots are untouched)
+    void setMode(GraphCondense mode) { _mode = mode; }
+    GraphCondense getMode() const { return _mode; }
 
-    // Append a data point. Disconnected probes are marked invalid.
-    // When the buffer is full, condenses 240 -> 120 before appending.
-    void addPoint(float pit, float meat1, float meat2, float setpoint,
-                  bool pitDisc, bool meat1Disc, bool meat2Disc);
+    // Append a data point; temps and disc hold NUM_PROBES, by channel.
+    // Disconnected probes are marked invalid. When the buffer is full,
+    // condenses 240 -> 120 before appending. Returns true if it condensed
+    // (every slot index moved), false if the point was simply appended at
+    // getCount() - 1.
+    bool addPoint(const float* temps, const bool* disc, float setpoint);
 
     // Clear all stored data
     void clear();
 
+    // Bulk load about `total` points: beginLoad() clears the buffer and
+    // picks the run length, loadPoint() takes the points oldest first, and
+    // endLoad() stores the last partial run. Feeding more than total points
+    // stops at a full buffer; fewer just leaves it partly filled.
+    void beginLoad(uint32_t total);
+    void loadPoint(const float* temps, const bool* disc, float setpoint);
+    void endLoad();
+
+    // Points per slot chosen by the last beginLoad() (1 = stored as is)
+    uint32_t getLoadRun() const { return _loadRun; }
+
     // Number of valid slots currently stored
     uint16_t getCount() const { return _count; }
 
@@ -43,9 +79,29 @@ public:
 private:
     GraphSlot _buffer[GRAPH_HISTORY_SIZE];
     uint16_t _count;
+    GraphCondense _mode;
 
-    // Merge the full buffer into half by pairwise averaging
+    // Bulk load run in progress (see beginLoad)
+    struct LoadAccum {
+        uint32_t n;             // Points in the run so far
+        float    sum[NUM_PROBES];
+        uint32_t valid[NUM_PROBES];
+        float    lo[NUM_PROBES], hi[NUM_PROBES];
+        uint32_t loAt[NUM_PROBES], hiAt[NUM_PROBES];
+        float    spSum, spFirst, spLast;
+    };
+    uint32_t  _loadRun;         // Points per AVERAGE slot (ENVELOPE: per two slots / 2)
+    LoadAccum _load;
+    void emitLoadRun();
+
+    // Merge the full buffer into half using _mode
     void condense();
+    void condenseAverage();
+    void condenseEnvelope();
+
+    // Min and max of channel ch over in[0..n), written to first/second in time order
+    static void envelope(const GraphSlot* in, uint8_t n, uint8_t ch,
+                         GraphSlot& first, GraphSlot& second);
 
     // Average two values respecting validity flags
     static float mergeValues(float a, bool aValid, float b, bool bValid, bool& outValid);
@@ -0,0 +1,155 @@
+#include "lcd_dma.h"
+
+#if !defined(NATIVE_BUILD)
+
+#include <Arduino.h>
+#include <esp_lcd_panel_io.h>
+#include <esp_heap_caps.h>
+
+static esp_lcd_i80_bus_handle_t s_bus = nullptr;
+static esp_lcd_panel_io_handle_t s_io = nullptr;
+
+// ST7796 commands
+#define ST7796_SWRESET  0x01
+#define ST7796_SLPOUT   0x11
+#define ST7796_INVON    0x21
+#define ST7796_DISPON   0x29
+#define ST7796_CASET    0x2A
+#define ST7796_RASET    0x2B
+#define ST7796_RAMWR    0x2C
+#define ST7796_MADCTL   0x36
+#define ST7796_COLMOD   0x3A
+
+#define ST7796_MADCTL_LANDSCAPE 0x28   // MV | BGR, same as TFT_eSPI rotation 1
+#define ST7796_COLMOD_RGB565    0x55
+
+// Runs in the LCD peripheral's ISR once a color transfer has left the
+// buffer. The buffer is free again, so LVGL may render into it.
+static bool on_color_trans_done(esp_lcd_panel_io_handle_t io,
+                                esp_lcd_panel_io_event_data_t* edata,
+                                void* user_ctx) {
+    (void)io;
+    (void)edata;
+    lv_display_flush_ready((lv_display_t*)user_ctx);
+    return false;
+}
+
+static void disp_flush_dma_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
+    (void)disp;
+    uint8_t col[4] = {
+        (uint8_t)(area->x1 >> 8), (uint8_t)(area->x1 & 0xFF),
+        (uint8_t)(area->x2 >> 8), (uint8_t)(area->x2 & 0xFF)
+    };
+    uint8_t row[4] = {
+        (uint8_t)(area->y1 >> 8), (uint8_t)(area->y1 & 0xFF),
+        (uint8_t)(area->y2 >> 8), (uint8_t)(area->y2 & 0xFF)
+    };
+    size_t len = (size_t)(area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1) * 2;
+
+    // Window commands and pixels are queued in order on the same bus;
+    // tx_color returns as soon as the DMA transfer is queued
+    esp_lcd_panel_io_tx_param(s_io, ST7796_CASET, col, sizeof(col));
+    esp_lcd_panel_io_tx_param(s_io, ST7796_RASET, row, sizeof(row));
+    esp_lcd_panel_io_tx_color(s_io, ST7796_RAMWR, px_map, len);
+}
+
+static void panel_init() {
+    if (PIN_LCD_RST >= 0) {
+        pinMode(PIN_LCD_RST, OUTPUT);
+        digitalWrite(PIN_LCD_RST, LOW);
+        delay(10);
+        digitalWrite(PIN_LCD_RST, HIGH);
+        delay(120);
+    }
+
+    esp_lcd_panel_io_tx_param(s_io, ST7796_SWRESET, nullptr, 0);
+    delay(120);
+    esp_lcd_panel_io_tx_param(s_io, ST7796_SLPOUT, nullptr, 0);
+    delay(120);
+
+    uint8_t madctl = ST7796_MADCTL_LANDSCAPE;
+    uint8_t colmod = ST7796_COLMOD_RGB565;
+    esp_lcd_panel_io_tx_param(s_io, ST7796_MADCTL, &madctl, 1);
+    esp_lcd_panel_io_tx_param(s_io, ST7796_COLMOD, &colmod, 1);
+    esp_lcd_panel_io_tx_param(s_io, ST7796_INVON, nullptr, 0);
+    esp_lcd_panel_io_tx_param(s_io, ST7796_DISPON, nullptr, 0);
+    delay(20);
+
+    if (PIN_LCD_BL >= 0) {
+        pinMode(PIN_LCD_BL, OUTPUT);
+        digitalWrite(PIN_LCD_BL, HIGH);
+    }
+}
+
+static void* alloc_draw_buf(size_t bytes) {
+    uint32_t caps = DISPLAY_BUF_PSRAM ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+                                      : (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    // PSRAM DMA needs cache-line alignment
+    return heap_caps_aligned_alloc(DISPLAY_BUF_PSRAM ? 64 : 4, bytes, caps);
+}
+
+bool lcd_dma_init(lv_display_t* disp) {
+    const size_t bufBytes = (size_t)DISPLAY_WIDTH * DISPLAY_BUF_LINES * 2;
+
+    esp_lcd_i80_bus_config_t bus_cfg = {};
+    bus_cfg.dc_gpio_num = PIN_LCD_DC;
+    bus_cfg.wr_gpio_num = PIN_LCD_WR;
+    bus_cfg.clk_src = LCD_CLK_SRC_PLL160M;
+    const int dataPins[8] = {
+        PIN_LCD_D0, PIN_LCD_D1, PIN_LCD_D2, PIN_LCD_D3,
+        PIN_LCD_D4, PIN_LCD_D5, PIN_LCD_D6, PIN_LCD_D7
+    };
+    for (uint8_t i = 0; i < 8; i++) bus_cfg.data_gpio_nums[i] = dataPins[i];
+    bus_cfg.bus_width = 8;
+    bus_cfg.max_transfer_bytes = bufBytes;
+    bus_cfg.psram_trans_align = 64;
+    bus_cfg.sram_trans_align = 4;
+
+    esp_err_t err = esp_lcd_new_i80_bus(&bus_cfg, &s_bus);
+    if (err != ESP_OK) {
+        Serial.printf("[LCD] i8080 bus init failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+
+    esp_lcd_panel_io_i80_config_t io_cfg = {};
+    io_cfg.cs_gpio_num = -1;                  // CS tied low on the WT32-SC01 Plus
+    io_cfg.pclk_hz = DISPLAY_PCLK_HZ;
+    io_cfg.trans_queue_depth = 10;
+    io_cfg.on_color_trans_done = on_color_trans_done;
+    io_cfg.user_ctx = disp;
+    io_cfg.lcd_cmd_bits = 8;
+    io_cfg.lcd_param_bits = 8;
+    io_cfg.dc_levels.dc_idle_level = 0;
+    io_cfg.dc_levels.dc_cmd_level = 0;
+    io_cfg.dc_levels.dc_dummy_level = 0;
+    io_cfg.dc_levels.dc_data_level = 1;
+    io_cfg.flags.swap_color_bytes = 1;        // LVGL RGB565 is little-endian, the panel wants MSB first
+
+    err = esp_lcd_new_panel_io_i80(s_bus, &io_cfg, &s_io);
+    if (err != ESP_OK) {
+        Serial.printf("[LCD] Panel IO init failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+
+    void* buf1 = alloc_draw_buf(bufBytes);
+    void* buf2 = alloc_draw_buf(bufBytes);
+    if (buf1 == nullptr || buf2 == nullptr) {
+        Serial.printf("[LCD] Draw buffer alloc failed (%u bytes x2, %s)\n",
+                      (unsigned)bufBytes, DISPLAY_BUF_PSRAM ? "PSRAM" : "SRAM");
+        heap_caps_free(buf1);
+        heap_caps_free(buf2);
+        return false;
+    }
+
+    panel_init();
+
+    lv_display_set_buffers(disp, buf1, buf2, bufBytes, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, disp_flush_dma_cb);
+
+    Serial.printf("[LCD] i8080 DMA flush, 2 x %u byte buffers in %s, %u MHz\n",
+                  (unsigned)bufBytes, DISPLAY_BUF_PSRAM ? "PSRAM" : "SRAM",
+                  (unsigned)(DISPLAY_PCLK_HZ / 1000000));
+    return true;
+}
+
+#endif // !NATIVE_BUILD
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../config.h"
+#include <stdint.h>
+
+#if !defined(NATIVE_BUILD)
+#include <lvgl.h>
+
+// ST7796 driven over the ESP32-S3 LCD peripheral (8-bit i8080) with DMA.
+//
+// Two partial draw buffers of DISPLAY_BUF_LINES lines are allocated from
+// DMA-capable internal SRAM (or PSRAM with DISPLAY_BUF_PSRAM). The flush
+// callback only queues the transfer and returns; the peripheral's
+// transfer-done interrupt calls lv_display_flush_ready(), so LVGL renders
+// the next area into the other buffer while this one is on the bus and
+// loop() is no longer blocked for the length of each flush.
+//
+// Returns false (and logs why) if the bus, panel IO or buffers could not
+// be set up; the display stays dark but the rest of the firmware runs.
+bool lcd_dma_init(lv_display_t* disp);
+
+#endif // !NATIVE_BUILD
@@ -2,6 +2,7 @@
 #include "ui_update.h"
 #include "ui_setup_wizard.h"
 #include "ui_colors.h"
+#include "../probe_channels.h"
 
 #if !defined(NATIVE_BUILD) || defined(SIMULATOR_BUILD)
 
@@ -12,15 +13,21 @@
 
 #ifndef SIMULATOR_BUILD
 #include <TFT_eSPI.h>
+#if DISPLAY_DMA_FLUSH
+#include "lcd_dma.h"
+#endif
 
 // --------------------------------------------------------------------------
 // Display driver (hardware)
 // --------------------------------------------------------------------------
 
+// Touch is read through TFT_eSPI in both flush modes
 static TFT_eSPI tft = TFT_eSPI();
 
-static lv_color_t draw_buf1[DISPLAY_WIDTH * 40];
-static lv_color_t draw_buf2[DISPLAY_WIDTH * 40];
+#if !DISPLAY_DMA_FLUSH
+// Blocking fallback: the CPU pushes every pixel before the flush returns
+static lv_color_t draw_buf1[DISPLAY_WIDTH * DISPLAY_BUF_LINES];
+static lv_color_t draw_buf2[DISPLAY_WIDTH * DISPLAY_BUF_LINES];
 
 static void disp_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
     uint32_t w = area->x2 - area->x1 + 1;
@@ -33,6 +40,7 @@ static void disp_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px
 
     lv_display_flush_ready(disp);
 }
+#endif
 
 static void touchpad_read_cb(lv_indev_t* indev, lv_indev_data_t* data) {
     uint16_t touchX, touchY;
@@ -91,9 +99,7 @@ lv_obj_t* lbl_alert_text   = nullptr;
 
 // Graph widgets
 lv_obj_t* chart_temps      = nullptr;
-lv_chart_series_t* ser_pit   = nullptr;
-lv_chart_series_t* ser_meat1 = nullptr;
-lv_chart_series_t* ser_meat2 = nullptr;
+lv_chart_series_t* ser_probe[NUM_PROBES] = {};   // By channel
 lv_chart_series_t* ser_setpoint = nullptr;
 lv_obj_t* graph_y_labels[5] = {};
 
@@ -250,6 +256,15 @@ static void show_modal(lv_obj_t* modal) {
     if (modal) lv_obj_remove_flag(modal, LV_OBJ_FLAG_HIDDEN);
 }
 
+// Modals are built the first time they're opened
+static void create_setpoint_modal();
+static void create_meat_target_modal();
+static void create_confirm_modal();
+
+static void ensure_modal(lv_obj_t* modal, void (*create)()) {
+    if (!modal) create();
+}
+
 // --------------------------------------------------------------------------
 // Setpoint modal
 // --------------------------------------------------------------------------
@@ -291,6 +306,7 @@ static void sp_apply_cb(lv_event_t* e) {
 
 static void pit_card_click_cb(lv_event_t* e) {
     (void)e;
+    ensure_modal(modal_setpoint, create_setpoint_modal);
     update_sp_modal_display();
     show_modal(modal_setpoint);
 }
@@ -435,6 +451,7 @@ static void meat1_card_click_cb(lv_event_t* e) {
     (void)e;
     modal_meat_probe = 1;
     if (modal_meat_value <= 0) modal_meat_value = 195;
+    ensure_modal(modal_meat, create_meat_target_modal);
     update_meat_modal_display();
     show_modal(modal_meat);
 }
@@ -443,6 +460,7 @@ static void meat2_card_click_cb(lv_event_t* e) {
     (void)e;
     modal_meat_probe = 2;
     if (modal_meat_value <= 0) modal_meat_value = 195;
+    ensure_modal(modal_meat, create_meat_target_modal);
     update_meat_modal_display();
     show_modal(modal_meat);
 }
@@ -558,6 +576,7 @@ static void confirm_ok_cb(lv_event_t* e) {
 }
 
 static void show_confirm(const char* title, const char* msg, void (*action)()) {
+    ensure_modal(modal_confirm, create_confirm_modal);
     confirm_action_cb = action;
     if (lbl_confirm_title) lv_label_set_text(lbl_confirm_title, title);
     if (lbl_confirm_msg) lv_label_set_text(lbl_confirm_msg, msg);
@@ -838,6 +857,15 @@ static void create_dashboard_screen() {
 // Graph screen
 // --------------------------------------------------------------------------
 
+// Line colour and legend text by probe channel: pit, the two dashboard
+// meats, then the rest
+static const uint32_t kGraphColors[PROBE_MAX] = {
+    0xFF6600, 0xFF3333, 0x3399FF, 0x33CC33, 0x8855FF, 0xFFCC00, 0x33CCCC, 0xFF66CC
+};
+static const char* const kGraphLegend[PROBE_MAX] = {
+    "Pit", "Meat1", "Meat2", "M3", "M4", "M5", "M6", "M7"
+};
+
 static void create_graph_screen() {
     scr_graph = lv_obj_create(nullptr);
     lv_obj_set_style_bg_color(scr_graph, COLOR_BG, 0);
@@ -893,10 +921,10 @@ static void create_graph_screen() {
         lv_obj_set_pos(graph_y_labels[i], 2, line_y - 7);  // -7 to center 14px font
     }
 
-    // Series — order matters for legend
-    ser_pit      = lv_chart_add_series(chart_temps, COLOR_ORANGE, LV_CHART_AXIS_PRIMARY_Y);
-    ser_meat1    = lv_chart_add_series(chart_temps, COLOR_RED, LV_CHART_AXIS_PRIMARY_Y);
-    ser_meat2    = lv_chart_add_series(chart_temps, COLOR_BLUE, LV_CHART_AXIS_PRIMARY_Y);
+    // Series — one per probe channel, order matters for legend
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        ser_probe[c] = lv_chart_add_series(chart_temps, lv_color_hex(kGraphColors[c]), LV_CHART_AXIS_PRIMARY_Y);
+    }
     ser_setpoint = lv_chart_add_series(chart_temps, lv_color_hex(0x999999), LV_CHART_AXIS_PRIMARY_Y);
 
     // Legend with colored swatches — positioned just below chart
@@ -925,13 +953,16 @@ static void create_graph_screen() {
         lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, 0);
     };
 
-    add_legend_item(COLOR_ORANGE,        "Pit");
-    add_legend_item(COLOR_RED,           "Meat1");
-    add_legend_item(COLOR_BLUE,          "Meat2");
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        add_legend_item(lv_color_hex(kGraphColors[c]), kGraphLegend[c]);
+    }
     add_legend_item(lv_color_hex(0x999999), "Set");
 
     // Navigation bar
     create_nav_bar(scr_graph, 1);
+
+    // Bind external arrays to chart series for adaptive condensing
+    ui_graph_init();
 }
 
 // --------------------------------------------------------------------------
@@ -1223,30 +1254,29 @@ void ui_init() {
     lv_indev_t* mouse = lv_sdl_mouse_create();
     (void)disp;
     (void)mouse;
+#else
+    lv_display_t* disp = lv_display_create(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+#if DISPLAY_DMA_FLUSH
+    // Panel owned by the LCD peripheral; LVGL renders into one buffer
+    // while DMA sends the other
+    lcd_dma_init(disp);
 #else
     tft.begin();
     tft.setRotation(1);
     tft.fillScreen(TFT_BLACK);
 
-    lv_display_t* disp = lv_display_create(DISPLAY_WIDTH, DISPLAY_HEIGHT);
     lv_display_set_buffers(disp, draw_buf1, draw_buf2, sizeof(draw_buf1), LV_DISPLAY_RENDER_MODE_PARTIAL);
     lv_display_set_flush_cb(disp, disp_flush_cb);
+#endif
 
     lv_indev_t* indev = lv_indev_create();
     lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(indev, touchpad_read_cb);
 #endif
 
+    // Only the dashboard is built at boot. The graph, settings and the
+    // modals are built the first time they're needed.
     create_dashboard_screen();
-    create_graph_screen();
-    create_settings_screen();
-
-    create_setpoint_modal();
-    create_meat_target_modal();
-    create_confirm_modal();
-
-    // Bind external arrays to chart series for adaptive condensing
-    ui_graph_init();
 
     lv_screen_load(scr_dashboard);
     current_screen = Screen::DASHBOARD;
@@ -1256,17 +1286,98 @@ void ui_init() {
     lv_timer_handler();
 }
 
-void ui_switch_screen(Screen screen) {
-    lv_obj_t* target = nullptr;
+// --------------------------------------------------------------------------
+// Lazy screens and memory budget
+// --------------------------------------------------------------------------
+// The graph and settings screens are built on their first ui_switch_screen()
+// and the modals on first open, so boot only pays for the dashboard. When
+// free LVGL heap drops under UI_FREE_SCREENS_BELOW, ui_handler() deletes
+// whichever of those aren't showing; they're rebuilt the next time they're
+// needed and ui_update re-applies their state. The dashboard always stays.
+
+static uint32_t last_switch_ms   = 0;
+static uint32_t last_mem_check_ms = 0;
+
+static lv_obj_t* ensure_screen(Screen screen) {
     switch (screen) {
-        case Screen::DASHBOARD: target = scr_dashboard; break;
-        case Screen::GRAPH:     target = scr_graph;     break;
-        case Screen::SETTINGS:  target = scr_settings;  break;
+        case Screen::DASHBOARD:
+            return scr_dashboard;
+        case Screen::GRAPH:
+            if (!scr_graph) {
+                create_graph_screen();
+                ui_update_screen_built(Screen::GRAPH);
+            }
+            return scr_graph;
+        case Screen::SETTINGS:
+            if (!scr_settings) {
+                create_settings_screen();
+                ui_update_screen_built(Screen::SETTINGS);
+            }
+            return scr_settings;
     }
+    return nullptr;
+}
+
+static void free_graph_screen() {
+    lv_obj_delete(scr_graph);
+    scr_graph = nullptr;
+    chart_temps = nullptr;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) ser_probe[c] = nullptr;
+    ser_setpoint = nullptr;
+    for (int i = 0; i < 5; i++) graph_y_labels[i] = nullptr;
+    for (int b = 0; b < 3; b++) nav_btns[1][b] = nullptr;
+}
+
+static void free_settings_screen() {
+    lv_obj_delete(scr_settings);
+    scr_settings = nullptr;
+    btn_units_f = btn_units_c = nullptr;
+    btn_fan_only = btn_fan_damper = btn_damper_pri = nullptr;
+    lbl_wifi_status = lbl_wifi_ssid = lbl_wifi_ip = lbl_wifi_signal = nullptr;
+    btn_wifi_action = lbl_wifi_action = nullptr;
+    for (int b = 0; b < 3; b++) nav_btns[2][b] = nullptr;
+}
+
+// Delete a modal that isn't open
+static bool free_modal(lv_obj_t*& modal) {
+    if (!modal || !lv_obj_has_flag(modal, LV_OBJ_FLAG_HIDDEN)) return false;
+    lv_obj_delete(modal);
+    modal = nullptr;
+    return true;
+}
+
+static void free_hidden_ui() {
+    if (free_modal(modal_setpoint)) lbl_modal_sp_value = nullptr;
+    if (free_modal(modal_meat)) lbl_modal_meat_value = lbl_modal_meat_title = nullptr;
+    if (free_modal(modal_confirm)) lbl_confirm_title = lbl_confirm_msg = nullptr;
+    if (scr_graph && current_screen != Screen::GRAPH) free_graph_screen();
+    if (scr_settings && current_screen != Screen::SETTINGS) free_settings_screen();
+}
+
+static void check_ui_memory() {
+#if UI_FREE_SCREENS_BELOW > 0
+    uint32_t now = lv_tick_get();
+    if (now - last_mem_check_ms < UI_MEM_CHECK_MS) return;
+    last_mem_check_ms = now;
+
+    // The outgoing screen is still drawn during the load animation
+    if (now - last_switch_ms < UI_MEM_CHECK_MS) return;
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    if (mon.total_size == 0) return;   // Not LVGL's own pool, nothing to measure
+    if (mon.free_size < UI_FREE_SCREENS_BELOW) free_hidden_ui();
+#endif
+}
+
+void ui_switch_screen(Screen screen) {
+    lv_obj_t* target = ensure_screen(screen);
     if (target) {
         lv_screen_load_anim(target, LV_SCR_LOAD_ANIM_FADE_IN, 200, 0, false);
         current_screen = screen;
+        last_switch_ms = lv_tick_get();
         update_nav_highlight(screen);
+        ui_update_screen_shown(screen);
     }
 }
 
@@ -1280,6 +1391,7 @@ void ui_tick(uint32_t ms) {
 
 void ui_handler() {
     lv_timer_handler();
+    check_ui_memory();
 }
 
 #else // NATIVE_BUILD && !SIMULATOR_BUILD
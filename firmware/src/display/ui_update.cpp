@@ -8,8 +8,10 @@
 #include <time.h>
 #include <math.h>
 
+#include "ui_init.h"
 #include "ui_colors.h"
 #include "graph_history.h"
+#include "../probe_channels.h"
 
 // --------------------------------------------------------------------------
 // External widget references (defined in ui_init.cpp)
@@ -45,9 +47,7 @@ extern lv_obj_t* lbl_alert_text;
 
 // Graph
 extern lv_obj_t* chart_temps;
-extern lv_chart_series_t* ser_pit;
-extern lv_chart_series_t* ser_meat1;
-extern lv_chart_series_t* ser_meat2;
+extern lv_chart_series_t* ser_probe[NUM_PROBES];
 extern lv_chart_series_t* ser_setpoint;
 extern lv_obj_t* graph_y_labels[5];
 
@@ -81,56 +81,150 @@ static const char* unit_suffix() {
 }
 
 // --------------------------------------------------------------------------
-// Public API
+// Change-only widget writes
 // --------------------------------------------------------------------------
+// main.cpp pushes every dashboard value once a second whether or not it
+// moved. lv_label_set_text() with the same text still re-measures the label
+// and invalidates it, so a steady cook would re-render and flush every card
+// each second. These compare against what the widget already shows (the
+// label's own text is the cache) and touch LVGL only on a change.
+
+static void set_text(lv_obj_t* lbl, const char* text) {
+    if (!lbl) return;
+    const char* cur = lv_label_get_text(lbl);
+    if (cur && strcmp(cur, text) == 0) return;
+    lv_label_set_text(lbl, text);
+}
 
-void ui_update_temps(float pit, float meat1, float meat2,
-                     bool pitConn, bool meat1Conn, bool meat2Conn) {
-    if (!lbl_pit_temp) return;
+static void set_text_color(lv_obj_t* obj, lv_color_t color) {
+    if (lv_color_eq(lv_obj_get_style_text_color(obj, LV_PART_MAIN), color)) return;
+    lv_obj_set_style_text_color(obj, color, 0);
+}
 
-    char buf[16];
+static void set_bg_color(lv_obj_t* obj, lv_color_t color) {
+    if (lv_color_eq(lv_obj_get_style_bg_color(obj, LV_PART_MAIN), color)) return;
+    lv_obj_set_style_bg_color(obj, color, 0);
+}
 
-    if (pitConn) {
-        snprintf(buf, sizeof(buf), "%.0f\xC2\xB0", pit);
-        lv_label_set_text(lbl_pit_temp, buf);
-        lv_obj_set_style_text_color(lbl_pit_temp, COLOR_ORANGE, 0);
-    } else {
-        lv_label_set_text(lbl_pit_temp, "---");
-        lv_obj_set_style_text_color(lbl_pit_temp, COLOR_TEXT_DIM, 0);
-    }
+static void set_hidden(lv_obj_t* obj, bool hidden) {
+    if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) == hidden) return;
+    if (hidden) lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    else        lv_obj_remove_flag(obj, LV_OBJ_FLAG_HIDDEN);
+}
 
-    if (lbl_meat1_temp) {
-        if (meat1Conn) {
-            snprintf(buf, sizeof(buf), "%.0f\xC2\xB0", meat1);
-            lv_label_set_text(lbl_meat1_temp, buf);
-            lv_obj_set_style_text_color(lbl_meat1_temp, COLOR_RED, 0);
-        } else {
-            lv_label_set_text(lbl_meat1_temp, "---");
-            lv_obj_set_style_text_color(lbl_meat1_temp, COLOR_TEXT_DIM, 0);
-        }
-    }
+// --------------------------------------------------------------------------
+// Hidden-screen deferral
+// --------------------------------------------------------------------------
+// Updates for a screen that isn't showing only record their arguments and
+// a pending bit. ui_update_screen_shown() replays the pending ones when the
+// screen is loaded, so a hidden screen costs no label layout at all. A
+// screen that was just built (ui_init.cpp builds them lazily and may free
+// them) marks everything it has been sent as pending again.
+
+enum : uint16_t {
+    DASH_TEMPS      = 1 << 0,
+    DASH_SETPOINT   = 1 << 1,
+    DASH_TIMER      = 1 << 2,
+    DASH_TARGET1    = 1 << 3,
+    DASH_TARGET2    = 1 << 4,
+    DASH_EST1       = 1 << 5,
+    DASH_EST2       = 1 << 6,
+    DASH_ALERTS     = 1 << 7,
+    DASH_BARS       = 1 << 8,
+    DASH_WIFI       = 1 << 9,
+};
+
+static struct {
+    uint16_t valid;     // Updates received at least once
+    uint16_t pending;
+    float    pit, meat1, meat2;
+    bool     pitConn, meat1Conn, meat2Conn;
+    float    setpoint;
+    uint32_t startEpoch, elapsedSec, estDoneEpoch;
+    float    target1, target2;
+    uint32_t est1, est2;
+    uint8_t  alarmType;
+    bool     lidOpen, fireOut;
+    uint8_t  probeErrors;
+    float    fanPct, damperPct;
+    bool     wifi;
+} s_dash;
+
+static struct {
+    bool valid;
+    bool pending;
+    bool connected, apMode;
+    char ssid[33];
+    char ip[16];
+    int  rssi;
+} s_wifiInfo;
+
+static struct {
+    bool valid;
+    bool pending;
+    bool fahrenheit;
+    char fanMode[16];
+} s_settings;
+
+static bool s_graphStale = false;   // Arrays behind GraphHistory while hidden
+
+// True (and the update marked pending) when the dashboard isn't showing
+static bool dash_deferred(uint16_t bit) {
+    s_dash.valid |= bit;
+    if (ui_get_current_screen() == Screen::DASHBOARD) return false;
+    s_dash.pending |= bit;
+    return true;
+}
 
-    if (lbl_meat2_temp) {
-        if (meat2Conn) {
-            snprintf(buf, sizeof(buf), "%.0f\xC2\xB0", meat2);
-            lv_label_set_text(lbl_meat2_temp, buf);
-            lv_obj_set_style_text_color(lbl_meat2_temp, COLOR_BLUE, 0);
-        } else {
-            lv_label_set_text(lbl_meat2_temp, "---");
-            lv_obj_set_style_text_color(lbl_meat2_temp, COLOR_TEXT_DIM, 0);
-        }
+// --------------------------------------------------------------------------
+// Public API
+// --------------------------------------------------------------------------
+
+static void update_probe_temp(lv_obj_t* lbl, float temp, bool connected, lv_color_t color) {
+    if (!lbl) return;
+
+    if (connected) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%.0f\xC2\xB0", temp);
+        set_text(lbl, buf);
+        set_text_color(lbl, color);
+    } else {
+        set_text(lbl, "---");
+        set_text_color(lbl, COLOR_TEXT_DIM);
     }
 }
 
+void ui_update_temps(float pit, float meat1, float meat2,
+                     bool pitConn, bool meat1Conn, bool meat2Conn) {
+    s_dash.pit = pit;
+    s_dash.meat1 = meat1;
+    s_dash.meat2 = meat2;
+    s_dash.pitConn = pitConn;
+    s_dash.meat1Conn = meat1Conn;
+    s_dash.meat2Conn = meat2Conn;
+    if (dash_deferred(DASH_TEMPS)) return;
+
+    update_probe_temp(lbl_pit_temp, pit, pitConn, COLOR_ORANGE);
+    update_probe_temp(lbl_meat1_temp, meat1, meat1Conn, COLOR_RED);
+    update_probe_temp(lbl_meat2_temp, meat2, meat2Conn, COLOR_BLUE);
+}
+
 void ui_update_setpoint(float sp) {
+    s_dash.setpoint = sp;
+    if (dash_deferred(DASH_SETPOINT)) return;
     if (!lbl_setpoint) return;
 
     char buf[24];
     snprintf(buf, sizeof(buf), "Set: %.0f\xC2\xB0%s", sp, unit_suffix());
-    lv_label_set_text(lbl_setpoint, buf);
+    set_text(lbl_setpoint, buf);
 }
 
 void ui_update_cook_timer(uint32_t startEpoch, uint32_t elapsedSec, uint32_t estDoneEpoch) {
+    s_dash.startEpoch = startEpoch;
+    s_dash.elapsedSec = elapsedSec;
+    s_dash.estDoneEpoch = estDoneEpoch;
+    if (dash_deferred(DASH_TIMER)) return;
+
     // Elapsed time (center, hero element)
     if (lbl_elapsed) {
         uint32_t h = elapsedSec / 3600;
@@ -139,7 +233,7 @@ void ui_update_cook_timer(uint32_t startEpoch, uint32_t elapsedSec, uint32_t est
         char buf[16];
         snprintf(buf, sizeof(buf), "%02lu:%02lu:%02lu",
                  (unsigned long)h, (unsigned long)m, (unsigned long)s);
-        lv_label_set_text(lbl_elapsed, buf);
+        set_text(lbl_elapsed, buf);
     }
 
     // Start time
@@ -150,10 +244,10 @@ void ui_update_cook_timer(uint32_t startEpoch, uint32_t elapsedSec, uint32_t est
             if (tm) {
                 char buf[24];
                 snprintf(buf, sizeof(buf), "Start %02d:%02d", tm->tm_hour, tm->tm_min);
-                lv_label_set_text(lbl_start_time, buf);
+                set_text(lbl_start_time, buf);
             }
         } else {
-            lv_label_set_text(lbl_start_time, "");
+            set_text(lbl_start_time, "");
         }
     }
 
@@ -165,40 +259,40 @@ void ui_update_cook_timer(uint32_t startEpoch, uint32_t elapsedSec, uint32_t est
             if (tm) {
                 char buf[24];
                 snprintf(buf, sizeof(buf), "Done ~%d:%02d", tm->tm_hour, tm->tm_min);
-                lv_label_set_text(lbl_done_time, buf);
+                set_text(lbl_done_time, buf);
             }
         } else {
-            lv_label_set_text(lbl_done_time, "");
+            set_text(lbl_done_time, "");
         }
     }
 }
 
-void ui_update_meat1_target(float target) {
-    if (!lbl_meat1_target) return;
+static void update_meat_target(lv_obj_t* lbl, float target) {
+    if (!lbl) return;
 
     if (target > 0) {
         char buf[24];
         snprintf(buf, sizeof(buf), "Target: %.0f\xC2\xB0%s", target, unit_suffix());
-        lv_label_set_text(lbl_meat1_target, buf);
+        set_text(lbl, buf);
     } else {
-        lv_label_set_text(lbl_meat1_target, "Target: ---");
+        set_text(lbl, "Target: ---");
     }
 }
 
-void ui_update_meat2_target(float target) {
-    if (!lbl_meat2_target) return;
+void ui_update_meat1_target(float target) {
+    s_dash.target1 = target;
+    if (dash_deferred(DASH_TARGET1)) return;
+    update_meat_target(lbl_meat1_target, target);
+}
 
-    if (target > 0) {
-        char buf[24];
-        snprintf(buf, sizeof(buf), "Target: %.0f\xC2\xB0%s", target, unit_suffix());
-        lv_label_set_text(lbl_meat2_target, buf);
-    } else {
-        lv_label_set_text(lbl_meat2_target, "Target: ---");
-    }
+void ui_update_meat2_target(float target) {
+    s_dash.target2 = target;
+    if (dash_deferred(DASH_TARGET2)) return;
+    update_meat_target(lbl_meat2_target, target);
 }
 
-void ui_update_meat1_estimate(uint32_t estEpoch) {
-    if (!lbl_meat1_est) return;
+static void update_meat_estimate(lv_obj_t* lbl, uint32_t estEpoch) {
+    if (!lbl) return;
 
     if (estEpoch > 0) {
         time_t t = (time_t)estEpoch;
@@ -206,94 +300,94 @@ void ui_update_meat1_estimate(uint32_t estEpoch) {
         if (tm) {
             char buf[32];
             snprintf(buf, sizeof(buf), "Est: %d:%02d PM", tm->tm_hour % 12 ? tm->tm_hour % 12 : 12, tm->tm_min);
-            lv_label_set_text(lbl_meat1_est, buf);
+            set_text(lbl, buf);
         }
     } else {
-        lv_label_set_text(lbl_meat1_est, "");
+        set_text(lbl, "");
     }
 }
 
+void ui_update_meat1_estimate(uint32_t estEpoch) {
+    s_dash.est1 = estEpoch;
+    if (dash_deferred(DASH_EST1)) return;
+    update_meat_estimate(lbl_meat1_est, estEpoch);
+}
+
 void ui_update_meat2_estimate(uint32_t estEpoch) {
-    if (!lbl_meat2_est) return;
+    s_dash.est2 = estEpoch;
+    if (dash_deferred(DASH_EST2)) return;
+    update_meat_estimate(lbl_meat2_est, estEpoch);
+}
 
-    if (estEpoch > 0) {
-        time_t t = (time_t)estEpoch;
-        struct tm* tm = localtime(&t);
-        if (tm) {
-            char buf[32];
-            snprintf(buf, sizeof(buf), "Est: %d:%02d PM", tm->tm_hour % 12 ? tm->tm_hour % 12 : 12, tm->tm_min);
-            lv_label_set_text(lbl_meat2_est, buf);
-        }
-    } else {
-        lv_label_set_text(lbl_meat2_est, "");
-    }
+static void show_alert(const char* text, lv_color_t color) {
+    set_text(lbl_alert_text, text);
+    set_bg_color(alert_banner, color);
+    set_hidden(alert_banner, false);
 }
 
 void ui_update_alerts(uint8_t alarmType, bool lidOpen, bool fireOut, uint8_t probeErrors) {
+    s_dash.alarmType = alarmType;
+    s_dash.lidOpen = lidOpen;
+    s_dash.fireOut = fireOut;
+    s_dash.probeErrors = probeErrors;
+    if (dash_deferred(DASH_ALERTS)) return;
     if (!alert_banner || !lbl_alert_text) return;
 
     // Priority: Alarm > Fire > Lid > Probe errors
-    // alarmType: 0=none, 1=pit_high, 2=pit_low, 3=meat1_done, 4=meat2_done
-    if (alarmType == 3) {
-        lv_label_set_text(lbl_alert_text, "MEAT 1 DONE - Tap to silence");
-        lv_obj_set_style_bg_color(alert_banner, COLOR_RED, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
-    } else if (alarmType == 4) {
-        lv_label_set_text(lbl_alert_text, "MEAT 2 DONE - Tap to silence");
-        lv_obj_set_style_bg_color(alert_banner, COLOR_RED, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+    // alarmType: 0=none, 1=pit_high, 2=pit_low, 3 + n = meat n+1 done
+    if (alarmType >= 3 && alarmType < 3 + NUM_PROBES - 1) {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "MEAT %u DONE - Tap to silence", (unsigned)(alarmType - 2));
+        show_alert(buf, COLOR_RED);
     } else if (alarmType == 1) {
-        lv_label_set_text(lbl_alert_text, "PIT HIGH - Tap to silence");
-        lv_obj_set_style_bg_color(alert_banner, COLOR_RED, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+        show_alert("PIT HIGH - Tap to silence", COLOR_RED);
     } else if (alarmType == 2) {
-        lv_label_set_text(lbl_alert_text, "PIT LOW - Tap to silence");
-        lv_obj_set_style_bg_color(alert_banner, COLOR_RED, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+        show_alert("PIT LOW - Tap to silence", COLOR_RED);
     } else if (fireOut) {
-        lv_label_set_text(lbl_alert_text, "FIRE MAY BE OUT");
-        lv_obj_set_style_bg_color(alert_banner, COLOR_RED, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+        show_alert("FIRE MAY BE OUT", COLOR_RED);
     } else if (lidOpen) {
-        lv_label_set_text(lbl_alert_text, "LID OPEN");
-        lv_obj_set_style_bg_color(alert_banner, COLOR_ORANGE, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+        show_alert("LID OPEN", COLOR_ORANGE);
     } else if (probeErrors) {
-        char buf[40] = "PROBE ERROR:";
-        if (probeErrors & 0x01) strcat(buf, " Pit");
-        if (probeErrors & 0x02) strcat(buf, " Meat1");
-        if (probeErrors & 0x04) strcat(buf, " Meat2");
-        lv_label_set_text(lbl_alert_text, buf);
-        lv_obj_set_style_bg_color(alert_banner, COLOR_ORANGE, 0);
-        lv_obj_remove_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+        char buf[64] = "PROBE ERROR:";
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            if (!(probeErrors & (1u << c))) continue;
+            strcat(buf, " ");
+            strcat(buf, kProbeChannels[c].label);
+        }
+        show_alert(buf, COLOR_ORANGE);
     } else {
-        lv_obj_add_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+        set_hidden(alert_banner, true);
     }
 }
 
-void ui_update_output_bars(float fanPct, float damperPct) {
-    if (lbl_fan_bar) {
+static void update_output_bar(lv_obj_t* bar, lv_obj_t* lbl, const char* name, float pct) {
+    // Label and bar share the whole-percent value, so a change under 0.5%
+    // touches neither
+    int32_t value = (int32_t)(pct + 0.5f);
+    if (lbl) {
         char buf[16];
-        snprintf(buf, sizeof(buf), "FAN %.0f%%", fanPct);
-        lv_label_set_text(lbl_fan_bar, buf);
+        snprintf(buf, sizeof(buf), "%s %ld%%", name, (long)value);
+        set_text(lbl, buf);
     }
-    if (bar_fan) {
-        lv_bar_set_value(bar_fan, (int32_t)(fanPct + 0.5f), LV_ANIM_ON);
-    }
-    if (lbl_damper_bar) {
-        char buf[16];
-        snprintf(buf, sizeof(buf), "DAMPER %.0f%%", damperPct);
-        lv_label_set_text(lbl_damper_bar, buf);
-    }
-    if (bar_damper) {
-        lv_bar_set_value(bar_damper, (int32_t)(damperPct + 0.5f), LV_ANIM_ON);
+    if (bar && lv_bar_get_value(bar) != value) {
+        lv_bar_set_value(bar, value, LV_ANIM_ON);
     }
 }
 
+void ui_update_output_bars(float fanPct, float damperPct) {
+    s_dash.fanPct = fanPct;
+    s_dash.damperPct = damperPct;
+    if (dash_deferred(DASH_BARS)) return;
+
+    update_output_bar(bar_fan, lbl_fan_bar, "FAN", fanPct);
+    update_output_bar(bar_damper, lbl_damper_bar, "DAMPER", damperPct);
+}
+
 void ui_update_wifi(bool connected) {
+    s_dash.wifi = connected;
+    if (dash_deferred(DASH_WIFI)) return;
     if (lbl_wifi_icon) {
-        lv_obj_set_style_text_color(lbl_wifi_icon,
-            connected ? COLOR_GREEN : COLOR_RED, 0);
+        set_text_color(lbl_wifi_icon, connected ? COLOR_GREEN : COLOR_RED);
     }
 }
 
@@ -301,108 +395,194 @@ void ui_update_wifi(bool connected) {
 // Graph — adaptive condensing with external arrays
 // --------------------------------------------------------------------------
 
-static GraphHistory s_history;
-static int32_t s_pit_arr[GRAPH_HISTORY_SIZE];
-static int32_t s_meat1_arr[GRAPH_HISTORY_SIZE];
-static int32_t s_meat2_arr[GRAPH_HISTORY_SIZE];
+static GraphHistory s_history(GRAPH_CONDENSE_ENVELOPE ? GraphCondense::ENVELOPE
+                                                      : GraphCondense::AVERAGE);
+static int32_t s_temp_arr[NUM_PROBES][GRAPH_HISTORY_SIZE];   // By channel
 static int32_t s_sp_arr[GRAPH_HISTORY_SIZE];
 
-// Sync GraphHistory buffer → LVGL external arrays, auto-scale Y axis
+// Running extremes of everything plotted, and the Y range derived from them
+static float   s_yMinF = 9999.0f, s_yMaxF = -9999.0f;
+static int32_t s_rangeMin = 0, s_rangeMax = 0;
+
+// Copy one GraphHistory slot into the external arrays and widen the
+// running min/max to cover it
+static void write_graph_slot(uint16_t i) {
+    const GraphSlot& slot = s_history.getSlot(i);
+
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        s_temp_arr[c][i] = LV_CHART_POINT_NONE;
+        if (!slot.valid[c]) continue;
+        float v = slot.temp[c];
+        s_temp_arr[c][i] = (int32_t)(v + 0.5f);
+        if (v < s_yMinF) s_yMinF = v;
+        if (v > s_yMaxF) s_yMaxF = v;
+    }
+    // Setpoint is always valid
+    s_sp_arr[i] = (int32_t)(slot.setpoint + 0.5f);
+    if (slot.setpoint < s_yMinF) s_yMinF = slot.setpoint;
+    if (slot.setpoint > s_yMaxF) s_yMaxF = slot.setpoint;
+}
+
+// Auto-scale Y axis with 15-degree padding, rounded to 25-degree steps.
+// Returns true if the range (and so every point's position) changed.
+static bool update_graph_range() {
+    if (s_history.getCount() == 0 || s_yMinF >= 9000.0f) return false;
+
+    int32_t yMin = (int32_t)(floorf((s_yMinF - 15.0f) / 25.0f)) * 25;
+    int32_t yMax = (int32_t)(ceilf((s_yMaxF + 15.0f) / 25.0f)) * 25;
+    if (yMax - yMin < 150) yMax = yMin + 150;  // minimum 150-degree range
+    if (yMin < 0) yMin = 0;
+
+    if (yMin == s_rangeMin && yMax == s_rangeMax) return false;
+    s_rangeMin = yMin;
+    s_rangeMax = yMax;
+
+    lv_chart_set_range(chart_temps, LV_CHART_AXIS_PRIMARY_Y, yMin, yMax);
+
+    // Update Y-axis labels at each of the 5 division line positions
+    for (int i = 0; i < 5; i++) {
+        if (graph_y_labels[i]) {
+            int temp = yMax - (yMax - yMin) * (i + 1) / 6;
+            char buf[8];
+            snprintf(buf, sizeof(buf), "%d", temp);
+            lv_label_set_text(graph_y_labels[i], buf);
+        }
+    }
+    return true;
+}
+
+// Invalidate only the strip of the chart holding the segment from slot
+// i-1 to slot i, so LVGL redraws (and flushes) a few columns, not the chart
+static void invalidate_graph_slot(uint16_t i) {
+    lv_area_t chartArea;
+    lv_obj_get_coords(chart_temps, &chartArea);
+
+    lv_point_t from, to;
+    lv_chart_get_point_pos_by_id(chart_temps, ser_probe[PROBE_PIT], i > 0 ? i - 1 : 0, &from);
+    lv_chart_get_point_pos_by_id(chart_temps, ser_probe[PROBE_PIT], i, &to);
+
+    // Half a segment past each end covers the line width and its joins
+    int32_t margin = (to.x - from.x) / 2 + lv_obj_get_style_line_width(chart_temps, LV_PART_ITEMS) + 1;
+
+    lv_area_t strip;
+    strip.x1 = chartArea.x1 + from.x - margin;
+    strip.x2 = chartArea.x1 + to.x + margin;
+    strip.y1 = chartArea.y1;
+    strip.y2 = chartArea.y2;
+    if (strip.x1 < chartArea.x1) strip.x1 = chartArea.x1;
+    if (strip.x2 > chartArea.x2) strip.x2 = chartArea.x2;
+    lv_obj_invalidate_area(chart_temps, &strip);
+}
+
+// Full re-sync of GraphHistory -> LVGL external arrays. Only needed when
+// slot indices move (condense) or the history is cleared; the chart's point
+// count stays at GRAPH_HISTORY_SIZE so appends never shift existing points.
 static void sync_graph_arrays() {
     if (!chart_temps) return;
+    s_graphStale = false;
 
     uint16_t count = s_history.getCount();
 
-    // Dynamically set point count so data spans the full chart width.
-    // Min 2 to avoid division-by-zero in LVGL's x-position math.
-    uint16_t displayCount = count < 2 ? 2 : count;
-    lv_chart_set_point_count(chart_temps, displayCount);
-
-    // Clear only the used portion of arrays
-    for (uint16_t i = 0; i < displayCount; i++) {
-        s_pit_arr[i]   = LV_CHART_POINT_NONE;
-        s_meat1_arr[i] = LV_CHART_POINT_NONE;
-        s_meat2_arr[i] = LV_CHART_POINT_NONE;
-        s_sp_arr[i]    = LV_CHART_POINT_NONE;
-    }
-
     // Left-align data: index 0 = oldest point
-    float yMinF = 9999.0f, yMaxF = -9999.0f;
-
+    s_yMinF = 9999.0f;
+    s_yMaxF = -9999.0f;
     for (uint16_t i = 0; i < count; i++) {
-        const GraphSlot& slot = s_history.getSlot(i);
-
-        if (slot.pitValid) {
-            s_pit_arr[i] = (int32_t)(slot.pit + 0.5f);
-            if (slot.pit < yMinF) yMinF = slot.pit;
-            if (slot.pit > yMaxF) yMaxF = slot.pit;
-        }
-        if (slot.meat1Valid) {
-            s_meat1_arr[i] = (int32_t)(slot.meat1 + 0.5f);
-            if (slot.meat1 < yMinF) yMinF = slot.meat1;
-            if (slot.meat1 > yMaxF) yMaxF = slot.meat1;
-        }
-        if (slot.meat2Valid) {
-            s_meat2_arr[i] = (int32_t)(slot.meat2 + 0.5f);
-            if (slot.meat2 < yMinF) yMinF = slot.meat2;
-            if (slot.meat2 > yMaxF) yMaxF = slot.meat2;
-        }
-        // Setpoint is always valid
-        s_sp_arr[i] = (int32_t)(slot.setpoint + 0.5f);
-        if (slot.setpoint < yMinF) yMinF = slot.setpoint;
-        if (slot.setpoint > yMaxF) yMaxF = slot.setpoint;
-    }
-
-    // Auto-scale Y axis with 15-degree padding, rounded to 25-degree steps
-    if (count > 0 && yMinF < 9000.0f) {
-        int32_t yMin = (int32_t)(floorf((yMinF - 15.0f) / 25.0f)) * 25;
-        int32_t yMax = (int32_t)(ceilf((yMaxF + 15.0f) / 25.0f)) * 25;
-        if (yMax - yMin < 150) yMax = yMin + 150;  // minimum 150-degree range
-        if (yMin < 0) yMin = 0;
-
-        lv_chart_set_range(chart_temps, LV_CHART_AXIS_PRIMARY_Y, yMin, yMax);
-
-        // Update Y-axis labels at each of the 5 division line positions
-        for (int i = 0; i < 5; i++) {
-            if (graph_y_labels[i]) {
-                int temp = yMax - (yMax - yMin) * (i + 1) / 6;
-                char buf[8];
-                snprintf(buf, sizeof(buf), "%d", temp);
-                lv_label_set_text(graph_y_labels[i], buf);
-            }
-        }
+        write_graph_slot(i);
+    }
+    for (uint16_t i = count; i < GRAPH_HISTORY_SIZE; i++) {
+        for (uint8_t c = 0; c < NUM_PROBES; c++) s_temp_arr[c][i] = LV_CHART_POINT_NONE;
+        s_sp_arr[i] = LV_CHART_POINT_NONE;
     }
 
+    update_graph_range();
     lv_chart_refresh(chart_temps);
 }
 
+// Incremental path: write the newest slot and redraw just its segment,
+// unless it widened the Y range (then every point moved)
+static void append_graph_point() {
+    if (!chart_temps) return;
+
+    uint16_t i = s_history.getCount() - 1;
+    write_graph_slot(i);
+
+    if (update_graph_range()) {
+        lv_chart_refresh(chart_temps);
+    } else {
+        invalidate_graph_slot(i);
+    }
+}
+
 void ui_graph_init() {
     if (!chart_temps) return;
 
+    // A new chart starts at its default range; sync on the next show
+    s_rangeMin = s_rangeMax = 0;
+    s_graphStale = true;
+
     // Initialize arrays to LV_CHART_POINT_NONE
     for (int i = 0; i < GRAPH_HISTORY_SIZE; i++) {
-        s_pit_arr[i]   = LV_CHART_POINT_NONE;
-        s_meat1_arr[i] = LV_CHART_POINT_NONE;
-        s_meat2_arr[i] = LV_CHART_POINT_NONE;
-        s_sp_arr[i]    = LV_CHART_POINT_NONE;
+        for (uint8_t c = 0; c < NUM_PROBES; c++) s_temp_arr[c][i] = LV_CHART_POINT_NONE;
+        s_sp_arr[i] = LV_CHART_POINT_NONE;
     }
 
+    // Fixed point count: slot i always sits at the same x, so an append
+    // only touches its own columns
+    lv_chart_set_point_count(chart_temps, GRAPH_HISTORY_SIZE);
+
     // Bind external arrays to chart series
-    lv_chart_set_ext_y_array(chart_temps, ser_pit,      s_pit_arr);
-    lv_chart_set_ext_y_array(chart_temps, ser_meat1,    s_meat1_arr);
-    lv_chart_set_ext_y_array(chart_temps, ser_meat2,    s_meat2_arr);
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        lv_chart_set_ext_y_array(chart_temps, ser_probe[c], s_temp_arr[c]);
+    }
     lv_chart_set_ext_y_array(chart_temps, ser_setpoint, s_sp_arr);
 }
 
-void ui_graph_add_point(float pit, float meat1, float meat2, float setpoint,
-                        bool pitDisc, bool meat1Disc, bool meat2Disc) {
-    s_history.addPoint(pit, meat1, meat2, setpoint, pitDisc, meat1Disc, meat2Disc);
-    sync_graph_arrays();
+// Set between ui_graph_begin_batch() and ui_graph_end_batch()
+static bool s_graphBatch = false;
+
+void ui_graph_add_point(const float* temps, const bool* disc, float setpoint) {
+    if (s_graphBatch) {
+        s_history.loadPoint(temps, disc, setpoint);
+        return;
+    }
+
+    bool condensed = s_history.addPoint(temps, disc, setpoint);
+    if (ui_get_current_screen() != Screen::GRAPH) {
+        s_graphStale = true;   // One sync when the graph is shown
+        return;
+    }
+    if (condensed) {
+        sync_graph_arrays();
+    } else {
+        append_graph_point();
+    }
+}
+
+// Full sync now, or on the next ui_update_screen_shown(GRAPH)
+static void sync_graph_when_shown() {
+    if (ui_get_current_screen() == Screen::GRAPH) {
+        sync_graph_arrays();
+    } else {
+        s_graphStale = true;
+    }
 }
 
 void ui_graph_clear() {
     s_history.clear();
-    sync_graph_arrays();
+    s_rangeMin = s_rangeMax = 0;
+    sync_graph_when_shown();
+}
+
+void ui_graph_begin_batch(uint32_t total) {
+    s_history.beginLoad(total);
+    s_rangeMin = s_rangeMax = 0;
+    s_graphBatch = true;
+}
+
+void ui_graph_end_batch() {
+    s_history.endLoad();
+    s_graphBatch = false;
+    sync_graph_when_shown();
 }
 
 static const char* rssi_quality(int rssi) {
@@ -413,17 +593,17 @@ static const char* rssi_quality(int rssi) {
     return "Weak";
 }
 
-void ui_update_wifi_info(const WifiInfo& info) {
+static void apply_wifi_info(const WifiInfo& info) {
     if (lbl_wifi_status) {
         if (info.connected) {
-            lv_label_set_text(lbl_wifi_status, "Connected");
-            lv_obj_set_style_text_color(lbl_wifi_status, COLOR_GREEN, 0);
+            set_text(lbl_wifi_status, "Connected");
+            set_text_color(lbl_wifi_status, COLOR_GREEN);
         } else if (info.apMode) {
-            lv_label_set_text(lbl_wifi_status, "AP Mode");
-            lv_obj_set_style_text_color(lbl_wifi_status, COLOR_ORANGE, 0);
+            set_text(lbl_wifi_status, "AP Mode");
+            set_text_color(lbl_wifi_status, COLOR_ORANGE);
         } else {
-            lv_label_set_text(lbl_wifi_status, "Disconnected");
-            lv_obj_set_style_text_color(lbl_wifi_status, COLOR_RED, 0);
+            set_text(lbl_wifi_status, "Disconnected");
+            set_text_color(lbl_wifi_status, COLOR_RED);
         }
     }
 
@@ -434,7 +614,7 @@ void ui_update_wifi_info(const WifiInfo& info) {
         } else {
             snprintf(buf, sizeof(buf), "SSID: ---");
         }
-        lv_label_set_text(lbl_wifi_ssid, buf);
+        set_text(lbl_wifi_ssid, buf);
     }
 
     if (lbl_wifi_ip) {
@@ -446,7 +626,7 @@ void ui_update_wifi_info(const WifiInfo& info) {
         } else {
             snprintf(buf, sizeof(buf), "IP: ---");
         }
-        lv_label_set_text(lbl_wifi_ip, buf);
+        set_text(lbl_wifi_ip, buf);
     }
 
     if (lbl_wifi_signal) {
@@ -456,36 +636,105 @@ void ui_update_wifi_info(const WifiInfo& info) {
         } else {
             snprintf(buf, sizeof(buf), "Signal: ---");
         }
-        lv_label_set_text(lbl_wifi_signal, buf);
+        set_text(lbl_wifi_signal, buf);
     }
 
     // Toggle button label between Disconnect and Reconnect
     if (lbl_wifi_action) {
         if (info.connected || info.apMode) {
-            lv_label_set_text(lbl_wifi_action, "Disconnect");
+            set_text(lbl_wifi_action, "Disconnect");
         } else {
-            lv_label_set_text(lbl_wifi_action, "Reconnect");
+            set_text(lbl_wifi_action, "Reconnect");
         }
     }
 }
 
-void ui_update_settings_state(bool isFahrenheit, const char* fanMode) {
+// The settings screen keeps a copy: the caller's strings needn't outlive
+// the call
+void ui_update_wifi_info(const WifiInfo& info) {
+    s_wifiInfo.connected = info.connected;
+    s_wifiInfo.apMode = info.apMode;
+    s_wifiInfo.rssi = info.rssi;
+    snprintf(s_wifiInfo.ssid, sizeof(s_wifiInfo.ssid), "%s", info.ssid ? info.ssid : "");
+    snprintf(s_wifiInfo.ip, sizeof(s_wifiInfo.ip), "%s", info.ip ? info.ip : "");
+    s_wifiInfo.valid = true;
+
+    if (ui_get_current_screen() != Screen::SETTINGS) {
+        s_wifiInfo.pending = true;
+        return;
+    }
+    apply_wifi_info(info);
+}
+
+static void apply_settings_state(bool isFahrenheit, const char* fanMode) {
     if (btn_units_f && btn_units_c) {
-        lv_obj_set_style_bg_color(btn_units_f, isFahrenheit ? COLOR_ORANGE : COLOR_BAR_BG, 0);
-        lv_obj_set_style_bg_color(btn_units_c, isFahrenheit ? COLOR_BAR_BG : COLOR_ORANGE, 0);
+        set_bg_color(btn_units_f, isFahrenheit ? COLOR_ORANGE : COLOR_BAR_BG);
+        set_bg_color(btn_units_c, isFahrenheit ? COLOR_BAR_BG : COLOR_ORANGE);
     }
 
     if (btn_fan_only && btn_fan_damper && btn_damper_pri && fanMode) {
-        lv_obj_set_style_bg_color(btn_fan_only, COLOR_BAR_BG, 0);
-        lv_obj_set_style_bg_color(btn_fan_damper, COLOR_BAR_BG, 0);
-        lv_obj_set_style_bg_color(btn_damper_pri, COLOR_BAR_BG, 0);
-
-        if (strcmp(fanMode, "fan_only") == 0) {
-            lv_obj_set_style_bg_color(btn_fan_only, COLOR_ORANGE, 0);
-        } else if (strcmp(fanMode, "fan_and_damper") == 0) {
-            lv_obj_set_style_bg_color(btn_fan_damper, COLOR_ORANGE, 0);
-        } else if (strcmp(fanMode, "damper_primary") == 0) {
-            lv_obj_set_style_bg_color(btn_damper_pri, COLOR_ORANGE, 0);
+        set_bg_color(btn_fan_only,   strcmp(fanMode, "fan_only") == 0       ? COLOR_ORANGE : COLOR_BAR_BG);
+        set_bg_color(btn_fan_damper, strcmp(fanMode, "fan_and_damper") == 0 ? COLOR_ORANGE : COLOR_BAR_BG);
+        set_bg_color(btn_damper_pri, strcmp(fanMode, "damper_primary") == 0 ? COLOR_ORANGE : COLOR_BAR_BG);
+    }
+}
+
+void ui_update_settings_state(bool isFahrenheit, const char* fanMode) {
+    s_settings.fahrenheit = isFahrenheit;
+    snprintf(s_settings.fanMode, sizeof(s_settings.fanMode), "%s", fanMode ? fanMode : "");
+    s_settings.valid = true;
+
+    if (ui_get_current_screen() != Screen::SETTINGS) {
+        s_settings.pending = true;
+        return;
+    }
+    apply_settings_state(isFahrenheit, fanMode);
+}
+
+void ui_update_screen_built(Screen screen) {
+    switch (screen) {
+        case Screen::DASHBOARD:
+            s_dash.pending = s_dash.valid;
+            break;
+        case Screen::GRAPH:
+            s_graphStale = true;
+            break;
+        case Screen::SETTINGS:
+            s_wifiInfo.pending = s_wifiInfo.valid;
+            s_settings.pending = s_settings.valid;
+            break;
+    }
+}
+
+void ui_update_screen_shown(Screen screen) {
+    if (screen == Screen::DASHBOARD && s_dash.pending) {
+        uint16_t pending = s_dash.pending;
+        s_dash.pending = 0;
+        if (pending & DASH_TEMPS)    ui_update_temps(s_dash.pit, s_dash.meat1, s_dash.meat2,
+                                                     s_dash.pitConn, s_dash.meat1Conn, s_dash.meat2Conn);
+        if (pending & DASH_SETPOINT) ui_update_setpoint(s_dash.setpoint);
+        if (pending & DASH_TIMER)    ui_update_cook_timer(s_dash.startEpoch, s_dash.elapsedSec, s_dash.estDoneEpoch);
+        if (pending & DASH_TARGET1)  ui_update_meat1_target(s_dash.target1);
+        if (pending & DASH_TARGET2)  ui_update_meat2_target(s_dash.target2);
+        if (pending & DASH_EST1)     ui_update_meat1_estimate(s_dash.est1);
+        if (pending & DASH_EST2)     ui_update_meat2_estimate(s_dash.est2);
+        if (pending & DASH_ALERTS)   ui_update_alerts(s_dash.alarmType, s_dash.lidOpen,
+                                                      s_dash.fireOut, s_dash.probeErrors);
+        if (pending & DASH_BARS)     ui_update_output_bars(s_dash.fanPct, s_dash.damperPct);
+        if (pending & DASH_WIFI)     ui_update_wifi(s_dash.wifi);
+    } else if (screen == Screen::GRAPH && s_graphStale) {
+        sync_graph_arrays();
+    } else if (screen == Screen::SETTINGS) {
+        if (s_wifiInfo.pending) {
+            s_wifiInfo.pending = false;
+            WifiInfo info = { s_wifiInfo.connected, s_wifiInfo.apMode,
+                              s_wifiInfo.ssid, s_wifiInfo.ip[0] ? s_wifiInfo.ip : nullptr,
+                              s_wifiInfo.rssi };
+            apply_wifi_info(info);
+        }
+        if (s_settings.pending) {
+            s_settings.pending = false;
+            apply_settings_state(s_settings.fahrenheit, s_settings.fanMode[0] ? s_settings.fanMode : nullptr);
         }
     }
 }
@@ -504,8 +753,12 @@ void ui_update_output_bars(float, float) {}
 void ui_update_wifi(bool) {}
 void ui_update_wifi_info(const WifiInfo&) {}
 void ui_graph_init() {}
-void ui_graph_add_point(float, float, float, float, bool, bool, bool) {}
+void ui_graph_add_point(const float*, const bool*, float) {}
 void ui_graph_clear() {}
+void ui_graph_begin_batch(uint32_t) {}
+void ui_graph_end_batch() {}
 void ui_update_settings_state(bool, const char*) {}
+void ui_update_screen_shown(Screen) {}
+void ui_update_screen_built(Screen) {}
 void ui_set_units(bool) {}
 #endif
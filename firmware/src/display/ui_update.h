@@ -1,8 +1,13 @@
 #pragma once
 
 #include "../config.h"
+#include "ui_init.h"
 #include <stdint.h>
 
+// Each update writes to LVGL only what changed since the last call, and an
+// update for a screen that isn't showing is held until that screen is
+// loaded (see ui_update_screen_shown).
+
 // Update temperature displays on the dashboard.
 // Shows "---" for disconnected probes.
 void ui_update_temps(float pit, float meat1, float meat2,
@@ -24,7 +29,7 @@ void ui_update_meat1_estimate(uint32_t estEpoch);
 void ui_update_meat2_estimate(uint32_t estEpoch);
 
 // Update alert banner. alarmType is a uint8_t cast of AlarmType enum.
-// probeErrors is a bitmask: bit 0=pit, bit 1=meat1, bit 2=meat2.
+// probeErrors is a bitmask by probe channel: bit 0=pit, bit 1=meat1, ...
 void ui_update_alerts(uint8_t alarmType, bool lidOpen, bool fireOut, uint8_t probeErrors);
 
 // Update thin output bars (fan and damper percentage).
@@ -45,19 +50,32 @@ struct WifiInfo {
 // Update settings screen Wi-Fi info card with current connection details.
 void ui_update_wifi_info(const WifiInfo& info);
 
-// Initialize graph external arrays. Call once after chart/series creation.
+// Initialize graph external arrays. Call after each chart/series creation.
 void ui_graph_init();
 
-// Add a data point to the graph with adaptive condensing.
-// Disconnected probes are marked invalid (pass true for disconnected).
-void ui_graph_add_point(float pit, float meat1, float meat2, float setpoint,
-                        bool pitDisc, bool meat1Disc, bool meat2Disc);
+// Add a data point to the graph with adaptive condensing. temps and disc
+// hold NUM_PROBES, by channel; disconnected probes are marked invalid.
+void ui_graph_add_point(const float* temps, const bool* disc, float setpoint);
 
 // Clear graph history (e.g., on new session).
 void ui_graph_clear();
 
+// Bulk load (session recovery): replaces the graph with about `total`
+// points passed to ui_graph_add_point() between begin and end, bucketed in
+// one pass (GraphHistory::beginLoad). end syncs the chart once.
+void ui_graph_begin_batch(uint32_t total);
+void ui_graph_end_batch();
+
 // Update settings screen state to reflect current values.
 void ui_update_settings_state(bool isFahrenheit, const char* fanMode);
 
+// Apply the updates held while a screen was hidden. ui_switch_screen()
+// calls this for the screen it loads.
+void ui_update_screen_shown(Screen screen);
+
+// A screen's widgets were just (re)created: everything sent to it so far
+// is applied again on the next ui_update_screen_shown().
+void ui_update_screen_built(Screen screen);
+
 // Set the display units (affects temperature labels like °F / °C).
 void ui_set_units(bool fahrenheit);
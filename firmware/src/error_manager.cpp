@@ -8,16 +8,14 @@
 
 ErrorManager::ErrorManager()
     : _errorCount(0)
-    , _pitHistoryIndex(0)
-    , _pitHistoryCount(0)
-    , _lastPitSampleMs(0)
-    , _declineStartMs(0)
-    , _declining(false)
-    , _lastPitTemp(0.0f)
+    , _revision(0)
     , _wifiConnected(true)
+    , _fanStalled(false)
+    , _overrunPhase(nullptr)
+    , _overrunShown(nullptr)
 {
     memset(_errors, 0, sizeof(_errors));
-    memset(_pitTempHistory, 0, sizeof(_pitTempHistory));
+    memset(&_trend, 0, sizeof(_trend));
 }
 
 void ErrorManager::begin() {
@@ -26,26 +24,18 @@ void ErrorManager::begin() {
 #endif
 }
 
-void ErrorManager::update(float pitTemp, float fanPct, const ProbeState probeStates[3]) {
-#ifndef NATIVE_BUILD
-    unsigned long now = millis();
-#else
-    unsigned long now = 0;
-#endif
-
+void ErrorManager::update(const ProbeState probeStates[NUM_PROBES]) {
     // --- Probe errors ---
-    const char* probeNames[] = {"Pit", "Meat 1", "Meat 2"};
-
-    for (uint8_t i = 0; i < 3; i++) {
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
         if (probeStates[i].openCircuit) {
             char msg[48];
-            snprintf(msg, sizeof(msg), "%s probe disconnected", probeNames[i]);
+            snprintf(msg, sizeof(msg), "%s probe disconnected", kProbeChannels[i].label);
             addError(ErrorCode::PROBE_OPEN, i, msg);
             // Remove short error if present for this probe
             removeError(ErrorCode::PROBE_SHORT, i);
         } else if (probeStates[i].shortCircuit) {
             char msg[48];
-            snprintf(msg, sizeof(msg), "%s probe shorted", probeNames[i]);
+            snprintf(msg, sizeof(msg), "%s probe shorted", kProbeChannels[i].label);
             addError(ErrorCode::PROBE_SHORT, i, msg);
             // Remove open error if present for this probe
             removeError(ErrorCode::PROBE_OPEN, i);
@@ -56,43 +46,26 @@ void ErrorManager::update(float pitTemp, float fanPct, const ProbeState probeSta
         }
     }
 
-    // --- Fire-out detection ---
-    // Sample pit temperature once per minute for fire-out analysis.
-    // Fire-out: pit declining > ERROR_FIREOUT_RATE deg/min for
-    // ERROR_FIREOUT_DURATION_MS continuous minutes despite fan at 100%.
-    if (now - _lastPitSampleMs >= 60000 || _lastPitSampleMs == 0) {
-        _lastPitSampleMs = now;
-
-        if (pitTemp > 0.0f) {
-            // Store in circular history buffer
-            _pitTempHistory[_pitHistoryIndex] = pitTemp;
-            _pitHistoryIndex = (_pitHistoryIndex + 1) % 10;
-            if (_pitHistoryCount < 10) _pitHistoryCount++;
-
-            // Check for sustained decline over the last minute
-            if (_pitHistoryCount >= 2 && _lastPitTemp > 0.0f) {
-                float ratePerMin = _lastPitTemp - pitTemp;  // Positive = declining
-
-                if (ratePerMin >= ERROR_FIREOUT_RATE && fanPct >= 95.0f) {
-                    // Temperature is declining despite fan at near-maximum
-                    if (!_declining) {
-                        _declining = true;
-                        _declineStartMs = now;
-                    }
-
-                    // Check if decline has persisted for the required duration
-                    if (now - _declineStartMs >= ERROR_FIREOUT_DURATION_MS) {
-                        addError(ErrorCode::FIRE_OUT, 0xFF, "Fire may be out");
-                    }
-                } else {
-                    // Not declining or fan not at max -- reset the timer
-                    _declining = false;
-                    _declineStartMs = 0;
-                    removeError(ErrorCode::FIRE_OUT, 0xFF);
-                }
-            }
-
-            _lastPitTemp = pitTemp;
+    // --- Trend warnings (trend_monitor.h) ---
+    if (_trend.fireOut) {
+        addError(ErrorCode::FIRE_OUT, 0xFF, "Fire may be out");
+    } else {
+        removeError(ErrorCode::FIRE_OUT, 0xFF);
+    }
+    if (_trend.fuelLow) {
+        addError(ErrorCode::FUEL_LOW, 0xFF, "Fuel running low");
+    } else {
+        removeError(ErrorCode::FUEL_LOW, 0xFF);
+    }
+    for (uint8_t i = 0; i < TREND_MEAT_PROBES; i++) {
+        uint8_t ch = PROBE_MEAT1 + i;
+        if (_trend.doneSoon[i]) {
+            char msg[48];
+            snprintf(msg, sizeof(msg), "%s done in ~%u min",
+                     kProbeChannels[ch].label, (unsigned)(TREND_DONE_SOON_SEC / 60));
+            addError(ErrorCode::MEAT_DONE_SOON, ch, msg);
+        } else {
+            removeError(ErrorCode::MEAT_DONE_SOON, ch);
         }
     }
 
@@ -102,18 +75,38 @@ void ErrorManager::update(float pitTemp, float fanPct, const ProbeState probeSta
     } else {
         removeError(ErrorCode::WIFI_LOST, 0xFF);
     }
+
+    // --- Fan stall ---
+    if (_fanStalled) {
+        addError(ErrorCode::FAN_STALL, 0xFF, "Fan stalled");
+    } else {
+        removeError(ErrorCode::FAN_STALL, 0xFF);
+    }
+
+    // --- Loop overrun ---
+    // One entry naming a phase, so a slow loop can't crowd out probe errors
+    if (_overrunPhase != _overrunShown) {
+        removeError(ErrorCode::LOOP_OVERRUN, 0xFF);
+        if (_overrunPhase) {
+            char msg[48];
+            snprintf(msg, sizeof(msg), "Loop slow: %s over budget", _overrunPhase);
+            addError(ErrorCode::LOOP_OVERRUN, 0xFF, msg);
+        }
+        _overrunShown = _overrunPhase;
+    }
 }
 
-#ifndef NATIVE_BUILD
-std::vector<ErrorEntry> ErrorManager::getErrors() const {
-    std::vector<ErrorEntry> result;
-    result.reserve(_errorCount);
-    for (uint8_t i = 0; i < _errorCount; i++) {
-        result.push_back(_errors[i]);
+uint8_t ErrorManager::getErrors(ErrorEntry* out, uint8_t maxCount) const {
+    uint8_t n = 0;
+    for (; n < _errorCount && n < maxCount; n++) {
+        out[n] = _errors[n];
     }
-    return result;
+    return n;
+}
+
+const ErrorEntry* ErrorManager::getError(uint8_t index) const {
+    return index < _errorCount ? &_errors[index] : nullptr;
 }
-#endif
 
 uint8_t ErrorManager::getErrorCount() const {
     return _errorCount;
@@ -131,16 +124,25 @@ bool ErrorManager::isFireOut() const {
 }
 
 void ErrorManager::clearAll() {
+    if (_errorCount > 0) _revision++;
     _errorCount = 0;
     memset(_errors, 0, sizeof(_errors));
-    _declining = false;
-    _declineStartMs = 0;
+    memset(&_trend, 0, sizeof(_trend));
+    _overrunShown = nullptr;
 }
 
 void ErrorManager::setWifiConnected(bool connected) {
     _wifiConnected = connected;
 }
 
+void ErrorManager::setFanStalled(bool stalled) {
+    _fanStalled = stalled;
+}
+
+void ErrorManager::setLoopOverrun(const char* phase) {
+    _overrunPhase = phase;
+}
+
 void ErrorManager::addError(ErrorCode code, uint8_t probeIndex, const char* message) {
     // Check if this exact error already exists
     if (errorExists(code, probeIndex)) return;
@@ -153,6 +155,7 @@ void ErrorManager::addError(ErrorCode code, uint8_t probeIndex, const char* mess
     strncpy(_errors[_errorCount].message, message, sizeof(_errors[_errorCount].message) - 1);
     _errors[_errorCount].message[sizeof(_errors[_errorCount].message) - 1] = '\0';
     _errorCount++;
+    _revision++;
 
 #ifndef NATIVE_BUILD
     Serial.printf("[ERROR] Error added: %s (code=%d)\n", message, (int)code);
@@ -172,6 +175,7 @@ void ErrorManager::removeError(ErrorCode code, uint8_t probeIndex) {
                 _errors[j] = _errors[j + 1];
             }
             _errorCount--;
+            _revision++;
             memset(&_errors[_errorCount], 0, sizeof(ErrorEntry));
             // Don't increment i -- re-check this index since we shifted
         } else {
@@ -1,11 +1,12 @@
 #pragma once
 
 #include "config.h"
+#include "probe_channels.h"
+#include "trend_monitor.h"
 #include <stdint.h>
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
-#include <vector>
 #endif
 
 // Error codes
@@ -14,14 +15,17 @@ enum class ErrorCode : uint8_t {
     PROBE_OPEN   = 1,   // Probe disconnected (open circuit)
     PROBE_SHORT  = 2,   // Probe shorted
     FIRE_OUT     = 3,   // Fire appears to have gone out
-    FAN_STALL    = 4,   // Fan not responding (future: tachometer)
-    WIFI_LOST    = 5    // WiFi connection lost
+    FAN_STALL    = 4,   // Fan driven but the tachometer sees no pulses
+    WIFI_LOST    = 5,   // WiFi connection lost
+    LOOP_OVERRUN = 6,   // A loop phase is over its time budget (warning)
+    FUEL_LOW     = 7,   // Output climbing to hold temperature (warning)
+    MEAT_DONE_SOON = 8  // Meat probe predicted to reach target soon (probeIndex = channel)
 };
 
 // Error entry with code and descriptive message
 struct ErrorEntry {
     ErrorCode code;
-    uint8_t   probeIndex;  // Which probe, if applicable (0-2), or 0xFF for non-probe errors
+    uint8_t   probeIndex;  // Which probe, if applicable (channel index), or 0xFF for non-probe errors
     char      message[48]; // Human-readable description
 };
 
@@ -34,7 +38,7 @@ struct ProbeState {
 };
 
 // Maximum number of simultaneous errors
-#define MAX_ERRORS 8
+#define MAX_ERRORS (NUM_PROBES + 6 + TREND_MEAT_PROBES)
 
 class ErrorManager {
 public:
@@ -44,19 +48,24 @@ public:
     void begin();
 
     // Check for error conditions. Call every loop().
-    // pitTemp: current pit temperature
-    // fanPct: current fan output percentage
-    // probeStates: array of 3 ProbeState structs (pit, meat1, meat2)
-    void update(float pitTemp, float fanPct, const ProbeState probeStates[3]);
+    // probeStates: one ProbeState per probe channel (probe_channels.h)
+    void update(const ProbeState probeStates[NUM_PROBES]);
 
-    // Get all currently active errors
-#ifndef NATIVE_BUILD
-    std::vector<ErrorEntry> getErrors() const;
-#endif
+    // Copy up to maxCount active errors into a caller-provided array, oldest
+    // first. Returns the number copied. Never allocates.
+    uint8_t getErrors(ErrorEntry* out, uint8_t maxCount) const;
+
+    // Active error at index (0..getErrorCount()-1), or nullptr. The pointer
+    // is valid until the next update()/clearAll().
+    const ErrorEntry* getError(uint8_t index) const;
 
     // Get error count
     uint8_t getErrorCount() const;
 
+    // Bumped whenever an error is added or removed. Callers that mirror the
+    // list compare against a saved value and re-copy only on change.
+    uint32_t getRevision() const { return _revision; }
+
     // Check if a specific error code is active
     bool hasError(ErrorCode code) const;
 
@@ -69,6 +78,16 @@ public:
     // Set WiFi connection state (called by WiFi manager)
     void setWifiConnected(bool connected);
 
+    // Set fan stall state (FanController::isStalled(), tach fitted only)
+    void setFanStalled(bool stalled);
+
+    // Name of a loop phase over its budget (see loop_profiler.h), or nullptr
+    // once none is. Must point at a string that outlives the error manager.
+    void setLoopOverrun(const char* phase);
+
+    // Trend warnings (fire out, fuel low, meat done soon) from TrendMonitor
+    void setTrend(const TrendStatus& trend) { _trend = trend; }
+
 private:
     // Add an error if not already present
     void addError(ErrorCode code, uint8_t probeIndex, const char* message);
@@ -82,16 +101,18 @@ private:
     // Active errors
     ErrorEntry _errors[MAX_ERRORS];
     uint8_t    _errorCount;
+    uint32_t   _revision;
 
-    // Fire-out detection state
-    float         _pitTempHistory[10];  // Store last 10 minutes of pit temps (sampled per minute)
-    uint8_t       _pitHistoryIndex;
-    uint8_t       _pitHistoryCount;
-    unsigned long _lastPitSampleMs;     // When we last sampled pit temp for fire-out
-    uint32_t      _declineStartMs;      // When the decline started
-    bool          _declining;           // Whether we're in a decline state
-    float         _lastPitTemp;         // Previous pit temp reading
+    // Trend warnings
+    TrendStatus _trend;
 
     // WiFi state
     bool _wifiConnected;
+
+    // Fan tach state
+    bool _fanStalled;
+
+    // Loop profiler state
+    const char* _overrunPhase;   // Requested
+    const char* _overrunShown;   // In the error list
 };
@@ -0,0 +1,42 @@
+#include "ext_ram.h"
+#include "config.h"
+#include <stdlib.h>
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+#endif
+
+bool extRamAvailable() {
+#if !defined(NATIVE_BUILD) && SESSION_USE_PSRAM
+    return psramFound();
+#else
+    return false;
+#endif
+}
+
+void* extRamAlloc(size_t bytes) {
+#ifndef NATIVE_BUILD
+    if (extRamAvailable()) {
+        void* p = heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (p) return p;
+        Serial.printf("[BOOT] PSRAM allocation of %u bytes failed, using internal RAM\n",
+                      (unsigned)bytes);
+    }
+#endif
+    return calloc(1, bytes);
+}
+
+bool extRamIsExternal(const void* p) {
+#ifndef NATIVE_BUILD
+    return p && esp_ptr_external_ram(p);
+#else
+    (void)p;
+    return false;
+#endif
+}
+
+void extRamFree(void* p) {
+    free(p);   // heap_caps blocks are freed the same way
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+
+// Allocation for large buffers that aren't used for DMA or by the control
+// task: the session ring, rollup tiers and history replay scratch.
+//
+// With SESSION_USE_PSRAM on a board where PSRAM was found these come from
+// the 8 MB OPI PSRAM, leaving internal SRAM to LVGL's draw buffers, the TCP
+// stack and the control state. Otherwise they come from the internal heap
+// (calloc on native).
+
+// PSRAM present and enabled for these buffers
+bool extRamAvailable();
+
+// Zeroed block of bytes, from PSRAM when available and the internal heap
+// if not (or if PSRAM is exhausted). nullptr when both fail.
+void* extRamAlloc(size_t bytes);
+
+// True when p (from extRamAlloc()) landed in PSRAM rather than the
+// internal heap. Always false on native.
+bool extRamIsExternal(const void* p);
+
+// Free a block from extRamAlloc(). nullptr is ignored.
+void extRamFree(void* p);
@@ -2,10 +2,23 @@
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
+#include <driver/ledc.h>
+#include <driver/pcnt.h>
+
+// Output changes come from the control task and the edge timer's task
+struct OutputLock {
+    explicit OutputLock(SemaphoreHandle_t m) : _m(m) { xSemaphoreTake(_m, portMAX_DELAY); }
+    ~OutputLock() { xSemaphoreGive(_m); }
+    SemaphoreHandle_t _m;
+};
 #endif
 
+#define TACH_COUNTER_LIMIT 32767   // PCNT counter wraps to 0 here
+
 FanController::FanController()
-    : _targetPct(0.0f)
+    : _pin(-1)
+    , _channel(FAN_PWM_CHANNEL)
+    , _targetPct(0.0f)
     , _currentPct(0.0f)
     , _currentDuty(0)
     , _kickStartActive(false)
@@ -15,24 +28,101 @@ FanController::FanController()
     , _longPulseCycleStartMs(0)
     , _wasOff(true)
     , _manualMode(false)
+#ifndef NATIVE_BUILD
+    , _edgeTimer(nullptr)
+    , _outputMutex(nullptr)
+    , _hwDuty(0)
+#endif
+    , _tachPulsesPerRev(0)
+    , _maxRpm((float)FAN_TACH_MAX_RPM)
+    , _tachUnit(-1)
+    , _tachLastCount(0)
+    , _tachWindowPulses(0)
+    , _tachWindowStartMs(0)
+    , _rpm(0.0f)
+    , _rpmTrimPct(0.0f)
+    , _trimActive(false)
+    , _kickPulses(0)
+    , _lastSpinMs(0)
+    , _stalled(false)
+#ifdef NATIVE_BUILD
+    , _testNowMs(0)
+    , _testPulses(0)
+#endif
 {
 }
 
-void FanController::begin() {
+void FanController::begin(int8_t pin, uint8_t channel) {
+    _pin = pin;
+    _channel = channel;
 #ifndef NATIVE_BUILD
-    // Configure LEDC for PWM output
-    ledcSetup(FAN_PWM_CHANNEL, FAN_PWM_FREQ, FAN_PWM_RESOLUTION);
-    ledcAttachPin(PIN_FAN_PWM, FAN_PWM_CHANNEL);
-    ledcWrite(FAN_PWM_CHANNEL, 0);
+    if (_pin >= 0) {
+        // Configure LEDC for PWM output. Arduino channels 0-7 are the
+        // S3's low-speed LEDC channels, which the fade and duty calls use.
+        ledcSetup(_channel, FAN_PWM_FREQ, FAN_PWM_RESOLUTION);
+        ledcAttachPin(_pin, _channel);
+        ledcWrite(_channel, 0);
+
+        // Kick-start ends and long-pulse edges fire from esp_timer, ramps
+        // run on the LEDC fader: the output no longer waits on update()
+        static bool fadeInstalled = false;
+        if (!fadeInstalled) {
+            ledc_fade_func_install(0);
+            fadeInstalled = true;
+        }
+        _outputMutex = xSemaphoreCreateMutex();
+        esp_timer_create_args_t args = {};
+        args.callback = &FanController::onOutputEdge;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "fan_edge";
+        esp_timer_create(&args, &_edgeTimer);
 
-    Serial.printf("[FAN] PWM initialized: pin=%d, freq=%dHz, resolution=%d-bit\n",
-                  PIN_FAN_PWM, FAN_PWM_FREQ, FAN_PWM_RESOLUTION);
+        Serial.printf("[FAN] PWM initialized: pin=%d, channel=%u, freq=%dHz, resolution=%d-bit\n",
+                      _pin, (unsigned)_channel, FAN_PWM_FREQ, FAN_PWM_RESOLUTION);
+    }
 #endif
     _currentDuty = 0;
     _currentPct = 0.0f;
     _wasOff = true;
 }
 
+void FanController::beginTach(int8_t pin, uint8_t pcntUnit, uint8_t pulsesPerRev, float maxRpm) {
+    if (pin < 0 || pulsesPerRev == 0 || maxRpm <= 0.0f) return;
+    _tachPulsesPerRev = pulsesPerRev;
+    _maxRpm = maxRpm;
+    _tachUnit = (int8_t)pcntUnit;
+    _tachLastCount = 0;
+#ifndef NATIVE_BUILD
+    // Open-collector tach output: pull up, count rising edges only
+    pinMode(pin, INPUT_PULLUP);
+    pcnt_config_t cfg = {};
+    cfg.pulse_gpio_num = pin;
+    cfg.ctrl_gpio_num  = PCNT_PIN_NOT_USED;
+    cfg.lctrl_mode     = PCNT_MODE_KEEP;
+    cfg.hctrl_mode     = PCNT_MODE_KEEP;
+    cfg.pos_mode       = PCNT_COUNT_INC;
+    cfg.neg_mode       = PCNT_COUNT_DIS;
+    cfg.counter_h_lim  = TACH_COUNTER_LIMIT;
+    cfg.counter_l_lim  = 0;
+    cfg.unit           = (pcnt_unit_t)pcntUnit;
+    cfg.channel        = PCNT_CHANNEL_0;
+    pcnt_unit_config(&cfg);
+    pcnt_set_filter_value((pcnt_unit_t)pcntUnit, FAN_TACH_FILTER);
+    pcnt_filter_enable((pcnt_unit_t)pcntUnit);
+    pcnt_counter_pause((pcnt_unit_t)pcntUnit);
+    pcnt_counter_clear((pcnt_unit_t)pcntUnit);
+    pcnt_counter_resume((pcnt_unit_t)pcntUnit);
+
+    _tachWindowStartMs = millis();
+    Serial.printf("[FAN] Tach on pin %d (PCNT %u), %u pulses/rev, 100%% = %.0f RPM\n",
+                  pin, (unsigned)pcntUnit, (unsigned)pulsesPerRev, maxRpm);
+#else
+    _tachWindowStartMs = _testNowMs;
+#endif
+    _lastSpinMs = _tachWindowStartMs;
+}
+
 void FanController::setSpeed(float percent) {
     if (_manualMode) return;
 
@@ -49,21 +139,30 @@ void FanController::update() {
 #ifndef NATIVE_BUILD
     unsigned long now = millis();
 #else
-    unsigned long now = 0;
+    unsigned long now = _testNowMs;
 #endif
 
+    uint16_t pulses = readTachPulses();
+    if (hasTach()) serviceTach(now, pulses);
+
+    // Long-pulse cycles right after a kick-start count from its end, the
+    // same origin the hardware used when it ended the kick
+    unsigned long pulseOrigin = now;
+
     // --- Handle kick-start phase ---
     if (_kickStartActive) {
-        if (now >= _kickStartEndMs) {
-            // Kick-start done, apply the real target speed
+        _kickPulses += pulses;
+        if (now >= _kickStartEndMs || (hasTach() && _kickPulses >= FAN_TACH_SPIN_PULSES)) {
+            // Kick-start done (or the tach already sees the fan turning),
+            // apply the real target speed
             _kickStartActive = false;
+            if (now >= _kickStartEndMs) pulseOrigin = _kickStartEndMs;
             // Fall through to normal speed logic below
         } else {
             // Still in kick-start: keep at kick-start speed
-            uint8_t duty = percentToDuty((float)FAN_KICKSTART_PCT);
             _currentPct = (float)FAN_KICKSTART_PCT;
-            _currentDuty = duty;
-            writePWM(duty);
+            _currentDuty = percentToDuty((float)FAN_KICKSTART_PCT);
+            applyOutput(kickOutput(_targetPct));
             return;
         }
     }
@@ -76,7 +175,7 @@ void FanController::update() {
         _longPulseActive = false;
         _currentPct = 0.0f;
         _currentDuty = 0;
-        writePWM(0);
+        applyOutput(outputFor(0.0f, now));
         return;
     }
 
@@ -86,11 +185,11 @@ void FanController::update() {
         _kickStartActive = true;
         _kickStartEndMs = now + FAN_KICKSTART_MS;
         _kickStartTargetPct = effectivePct;
+        _kickPulses = 0;
 
-        uint8_t duty = percentToDuty((float)FAN_KICKSTART_PCT);
         _currentPct = (float)FAN_KICKSTART_PCT;
-        _currentDuty = duty;
-        writePWM(duty);
+        _currentDuty = percentToDuty((float)FAN_KICKSTART_PCT);
+        applyOutput(kickOutput(effectivePct));
         return;
     }
 
@@ -103,29 +202,23 @@ void FanController::update() {
         // The on-fraction is proportional to the target percentage / threshold.
         if (!_longPulseActive) {
             _longPulseActive = true;
-            _longPulseCycleStartMs = now;
+            _longPulseCycleStartMs = pulseOrigin;
         }
 
-        unsigned long elapsed = now - _longPulseCycleStartMs;
-        unsigned long cycleMs = FAN_LONGPULSE_CYCLE_MS;
-        unsigned long posInCycle = elapsed % cycleMs;
-
-        // On-time fraction: target / threshold
-        float onFraction = effectivePct / (float)FAN_LONGPULSE_THRESHOLD;
-        unsigned long onTimeMs = (unsigned long)(onFraction * cycleMs);
-
-        if (posInCycle < onTimeMs) {
+        // The edges themselves are timed by applyOutput(); this only mirrors
+        // the phase for getCurrentSpeedPct()
+        FanOutput out = outputFor(effectivePct, _longPulseCycleStartMs);
+        unsigned long posInCycle = (now - _longPulseCycleStartMs) % FAN_LONGPULSE_CYCLE_MS;
+        if (posInCycle < out.onMs) {
             // ON phase: run at min speed
-            uint8_t duty = percentToDuty((float)FAN_MIN_SPEED);
             _currentPct = (float)FAN_MIN_SPEED;
-            _currentDuty = duty;
-            writePWM(duty);
+            _currentDuty = out.duty;
         } else {
             // OFF phase
             _currentPct = 0.0f;
             _currentDuty = 0;
-            writePWM(0);
         }
+        applyOutput(out);
         return;
     }
 
@@ -136,10 +229,14 @@ void FanController::update() {
         effectivePct = (float)FAN_MIN_SPEED;
     }
 
-    uint8_t duty = percentToDuty(effectivePct);
+    // With a tach, outputFor() trims the duty so the RPM tracks the
+    // requested airflow
+    FanOutput out = outputFor(effectivePct, now);
+    if (hasTach() && effectivePct < 100.0f) _trimActive = true;
+
     _currentPct = effectivePct;
-    _currentDuty = duty;
-    writePWM(duty);
+    _currentDuty = out.duty;
+    applyOutput(out);
 }
 
 void FanController::off() {
@@ -150,7 +247,7 @@ void FanController::off() {
     _wasOff = true;
     _currentPct = 0.0f;
     _currentDuty = 0;
-    writePWM(0);
+    applyOutput(FanOutput());
 }
 
 float FanController::getCurrentSpeedPct() const {
@@ -169,15 +266,151 @@ void FanController::setManualDuty(uint8_t duty) {
     _manualMode = true;
     _currentDuty = duty;
     _currentPct = (float)duty / 255.0f * 100.0f;
-    writePWM(duty);
+    FanOutput out;
+    out.duty = duty;
+    applyOutput(out);
+}
+
+FanOutput FanController::outputFor(float pct, unsigned long cycleStartMs) const {
+    FanOutput out;
+    if (pct <= 0.0f) return out;
+
+    if (pct < (float)FAN_LONGPULSE_THRESHOLD) {
+        out.duty = percentToDuty((float)FAN_MIN_SPEED);
+        out.onMs = (uint32_t)(pct / (float)FAN_LONGPULSE_THRESHOLD * FAN_LONGPULSE_CYCLE_MS);
+        out.cycleStartMs = cycleStartMs;
+        return out;
+    }
+
+    if (pct < (float)FAN_MIN_SPEED) pct = (float)FAN_MIN_SPEED;
+    if (hasTach() && pct < 100.0f) {
+        pct += _rpmTrimPct;
+        if (pct < (float)FAN_MIN_SPEED) pct = (float)FAN_MIN_SPEED;
+        if (pct > 100.0f) pct = 100.0f;
+    }
+    out.duty = percentToDuty(pct);
+    return out;
 }
 
-void FanController::writePWM(uint8_t duty) {
+FanOutput FanController::kickOutput(float pct) const {
+    FanOutput out = outputFor(pct, _kickStartEndMs);
+    out.kick = true;
+    out.kickDuty = percentToDuty((float)FAN_KICKSTART_PCT);
+    out.kickEndMs = _kickStartEndMs;
+    return out;
+}
+
+uint16_t FanController::readTachPulses() {
 #ifndef NATIVE_BUILD
-    ledcWrite(FAN_PWM_CHANNEL, duty);
+    if (_tachUnit < 0) return 0;
+    int16_t count = 0;
+    pcnt_get_counter_value((pcnt_unit_t)_tachUnit, &count);
+    int32_t delta = (int32_t)count - _tachLastCount;
+    if (delta < 0) delta += TACH_COUNTER_LIMIT;   // Counter wrapped at h_lim
+    _tachLastCount = count;
+    return (uint16_t)delta;
+#else
+    uint16_t n = _testPulses;
+    _testPulses = 0;
+    return n;
 #endif
 }
 
+void FanController::serviceTach(unsigned long now, uint16_t pulses) {
+    // --- RPM window, and one closed-loop trim step per window ---
+    _tachWindowPulses += pulses;
+    unsigned long windowMs = now - _tachWindowStartMs;
+    if (windowMs >= FAN_TACH_WINDOW_MS) {
+        _rpm = (float)_tachWindowPulses * 60000.0f / ((float)_tachPulsesPerRev * (float)windowMs);
+        if (_trimActive && !_kickStartActive) {
+            float errPct = (_currentPct - _rpm / _maxRpm * 100.0f);
+            _rpmTrimPct += FAN_RPM_KI * errPct;
+            if (_rpmTrimPct >  FAN_RPM_TRIM_MAX) _rpmTrimPct =  FAN_RPM_TRIM_MAX;
+            if (_rpmTrimPct < -FAN_RPM_TRIM_MAX) _rpmTrimPct = -FAN_RPM_TRIM_MAX;
+        }
+        _trimActive = false;
+        _tachWindowPulses = 0;
+        _tachWindowStartMs = now;
+    }
+
+    // --- Stall: driven, yet no pulses for FAN_STALL_MS ---
+    if (_currentDuty == 0 || pulses > 0) {
+        _lastSpinMs = now;
+        if (pulses > 0) _stalled = false;
+    } else if (now - _lastSpinMs >= FAN_STALL_MS) {
+        _stalled = true;
+        _lastSpinMs = now;
+        if (!_manualMode) _wasOff = true;   // Kick it again on this update
+    }
+}
+
+static bool sameOutput(const FanOutput& a, const FanOutput& b) {
+    return a.kick == b.kick && a.kickDuty == b.kickDuty && a.kickEndMs == b.kickEndMs
+        && a.duty == b.duty && a.onMs == b.onMs && a.cycleStartMs == b.cycleStartMs;
+}
+
+void FanController::applyOutput(const FanOutput& out) {
+    if (sameOutput(out, _output)) return;
+#ifndef NATIVE_BUILD
+    if (_pin < 0 || !_outputMutex) { _output = out; return; }
+    OutputLock lock(_outputMutex);
+
+    // A steady duty change on a running fan ramps in hardware; anything
+    // else takes effect now and arms its next edge
+    bool ramp = !out.kick && out.onMs == 0 && out.duty > 0
+             && !_output.kick && _output.onMs == 0 && _hwDuty > 0;
+    _output = out;
+    esp_timer_stop(_edgeTimer);   // Not running is fine
+    if (ramp) {
+        ledc_set_fade_time_and_start(LEDC_LOW_SPEED_MODE, (ledc_channel_t)(_channel % 8),
+                                     out.duty, FAN_RAMP_MS, LEDC_FADE_NO_WAIT);
+        _hwDuty = out.duty;
+    } else {
+        outputEdge();
+    }
+#else
+    _output = out;
+#endif
+}
+
+#ifndef NATIVE_BUILD
+void FanController::onOutputEdge(void* arg) {
+    FanController* fan = static_cast<FanController*>(arg);
+    OutputLock lock(fan->_outputMutex);
+    fan->outputEdge();
+}
+
+void FanController::outputEdge() {
+    const FanOutput& o = _output;
+    unsigned long now = millis();
+    uint8_t  duty;
+    uint32_t nextMs = 0;   // 0 = nothing more to time
+
+    if (o.kick && (long)(o.kickEndMs - now) > 0) {
+        duty = o.kickDuty;
+        nextMs = o.kickEndMs - now;
+    } else if (o.onMs == 0) {
+        duty = o.duty;
+    } else {
+        long sinceStart = (long)(now - o.cycleStartMs);
+        unsigned long pos = sinceStart > 0 ? (unsigned long)sinceStart % FAN_LONGPULSE_CYCLE_MS : 0;
+        if (pos < o.onMs) {
+            duty = o.duty;
+            nextMs = o.onMs - pos;
+        } else {
+            duty = 0;
+            nextMs = FAN_LONGPULSE_CYCLE_MS - pos;
+        }
+    }
+
+    if (duty != _hwDuty) {
+        ledc_set_duty_and_update(LEDC_LOW_SPEED_MODE, (ledc_channel_t)(_channel % 8), duty, 0);
+        _hwDuty = duty;
+    }
+    if (nextMs > 0) esp_timer_start_once(_edgeTimer, (uint64_t)nextMs * 1000ULL);
+}
+#endif
+
 uint8_t FanController::percentToDuty(float pct) {
     if (pct <= 0.0f) return 0;
     if (pct >= 100.0f) return 255;
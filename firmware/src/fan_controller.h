@@ -3,19 +3,45 @@
 #include "config.h"
 #include <stdint.h>
 
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#include <esp_timer.h>
+#endif
+
+// What the PWM output does until update() changes it. The kick-start end,
+// long-pulse edges and speed ramps are then timed by the hardware (esp_timer
+// and the LEDC fader), so the fan keeps the right output even if the loop
+// calling update() stalls.
+struct FanOutput {
+    bool          kick = false;          // Run kickDuty until kickEndMs, then the rest
+    uint8_t       kickDuty = 0;
+    unsigned long kickEndMs = 0;
+    uint8_t       duty = 0;              // Steady duty, or the long-pulse on duty
+    uint32_t      onMs = 0;              // Long-pulse on time per FAN_LONGPULSE_CYCLE_MS, 0 = steady
+    unsigned long cycleStartMs = 0;      // Long-pulse cycle origin
+};
+
 class FanController {
 public:
     FanController();
 
-    // Configure PWM channel at 25kHz. Call once from setup().
-    void begin();
+    // Configure the LEDC channel at 25kHz on pin. Call once from setup().
+    // A negative pin runs the logic without driving an output.
+    void begin(int8_t pin = PIN_FAN_PWM, uint8_t channel = FAN_PWM_CHANNEL);
+
+    // Count tach pulses on pin with a PCNT unit, so no CPU work is needed
+    // per pulse. pulsesPerRev of 0 leaves the fan open-loop. With a tach,
+    // update() trims the duty until the RPM matches percent of maxRpm, ends
+    // the kick-start as soon as the fan spins, and flags a stall.
+    void beginTach(int8_t pin, uint8_t pcntUnit, uint8_t pulsesPerRev, float maxRpm);
 
     // Set fan speed from 0-100%. Handles kick-start, min-speed clamping,
     // and long-pulse mode internally.
     void setSpeed(float percent);
 
-    // Must be called every loop iteration to manage kick-start timing
-    // and long-pulse cycling.
+    // Call every control tick: works out the output from the target (and
+    // the tach) and hands it to the hardware. Kick-start and long-pulse
+    // timing don't depend on how often it runs.
     void update();
 
     // Immediately stop the fan
@@ -33,13 +59,55 @@ public:
     // Force fan to a specific duty (0-255) bypassing all logic. Useful for testing.
     void setManualDuty(uint8_t duty);
 
+    // Output last handed to the hardware
+    const FanOutput& getOutput() const { return _output; }
+
+    // Tach fitted (beginTach with pulsesPerRev > 0)?
+    bool hasTach() const { return _tachPulsesPerRev > 0; }
+
+    // Measured speed over the last FAN_TACH_WINDOW_MS (0 without a tach)
+    float getRpm() const { return _rpm; }
+
+    // Driven for FAN_STALL_MS without a tach pulse. Clears when it spins.
+    bool isStalled() const { return _stalled; }
+
+#ifdef NATIVE_BUILD
+    // Test helpers: the clock update() reads in place of millis(), and
+    // pulses the next update() counts in place of the PCNT unit
+    void setNowMs(unsigned long ms) { _testNowMs = ms; }
+    void addTachPulses(uint16_t n) { _testPulses += n; }
+#endif
+
 private:
-    // Write a PWM duty value (0-255) to the hardware
-    void writePWM(uint8_t duty);
+    // Program the output if it changed
+    void applyOutput(const FanOutput& out);
+
+    // Steady or long-pulse output for pct, with the tach trim
+    FanOutput outputFor(float pct, unsigned long cycleStartMs) const;
+
+    // Kick-start until _kickStartEndMs, then outputFor(pct)
+    FanOutput kickOutput(float pct) const;
+
+#ifndef NATIVE_BUILD
+    // Edge timer callback (esp_timer task)
+    static void onOutputEdge(void* arg);
+
+    // Write the duty due now and arm the next edge. Holds _outputMutex.
+    void outputEdge();
+#endif
 
     // Convert percent (0-100) to duty (0-255)
     static uint8_t percentToDuty(float pct);
 
+    // Pulses since the last call
+    uint16_t readTachPulses();
+
+    // Count pulses into the RPM window, step the closed-loop trim when it
+    // closes, and watch for a stall. Runs before the output is recomputed.
+    void serviceTach(unsigned long now, uint16_t pulses);
+
+    int8_t   _pin;               // -1 = no output
+    uint8_t  _channel;           // LEDC channel
     float    _targetPct;         // Requested speed percent (0-100)
     float    _currentPct;        // Actual output percent
     uint8_t  _currentDuty;       // Actual PWM duty value
@@ -58,4 +126,31 @@ private:
 
     // Manual override mode
     bool _manualMode;
+
+    // Output handed to the hardware
+    FanOutput _output;
+#ifndef NATIVE_BUILD
+    esp_timer_handle_t _edgeTimer;
+    SemaphoreHandle_t  _outputMutex;
+    uint8_t            _hwDuty;           // Duty last written to LEDC
+#endif
+
+    // Tach state
+    uint8_t       _tachPulsesPerRev;    // 0 = no tach
+    float         _maxRpm;              // RPM at 100% airflow
+    int8_t        _tachUnit;            // PCNT unit, -1 = none
+    int16_t       _tachLastCount;       // PCNT counter at the last read
+    uint32_t      _tachWindowPulses;
+    unsigned long _tachWindowStartMs;
+    float         _rpm;
+    float         _rpmTrimPct;          // Closed-loop correction added to the duty
+    bool          _trimActive;          // Output was closed-loop through the window
+    uint16_t      _kickPulses;          // Pulses since the kick-start began
+    unsigned long _lastSpinMs;          // Last pulse while driven, or last time undriven
+    bool          _stalled;
+
+#ifdef NATIVE_BUILD
+    unsigned long _testNowMs;
+    uint16_t      _testPulses;
+#endif
 };
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// How the PID output is shared between the fan and the damper. Parsed from
+// its name once (config load, a web or touch command) so the control loop
+// switches on the value instead of comparing strings. The values double as
+// the binary protocol's BF_FAN_MODE byte and the FAN_MODE session event, so
+// append new modes rather than reordering.
+enum class FanMode : uint8_t {
+    FAN_ONLY       = 0,   // Damper held open, the fan does everything
+    FAN_AND_DAMPER = 1,   // Damper first, fan above fanOnThreshold (default)
+    DAMPER_PRIMARY = 2,   // Damper first, fan only above 50% or the threshold
+    COUNT
+};
+
+#define FAN_MODE_COUNT ((uint8_t)FanMode::COUNT)
+#define FAN_MODE_DEFAULT FanMode::FAN_AND_DAMPER
+
+static const char* const kFanModeNames[FAN_MODE_COUNT] = {
+    "fan_only", "fan_and_damper", "damper_primary"
+};
+
+inline const char* fanModeName(FanMode mode) {
+    uint8_t i = (uint8_t)mode;
+    return i < FAN_MODE_COUNT ? kFanModeNames[i] : kFanModeNames[(uint8_t)FAN_MODE_DEFAULT];
+}
+
+// Look up a mode by name. False (and out unchanged) for null or unknown.
+inline bool fanModeFromName(const char* name, FanMode& out) {
+    if (name == nullptr) return false;
+    for (uint8_t i = 0; i < FAN_MODE_COUNT; i++) {
+        if (strcmp(name, kFanModeNames[i]) == 0) {
+            out = (FanMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Name to mode, falling back to fan_and_damper like the old string dispatch
+inline FanMode fanModeParse(const char* name) {
+    FanMode mode = FAN_MODE_DEFAULT;
+    fanModeFromName(name, mode);
+    return mode;
+}
@@ -0,0 +1,77 @@
+#include "history_stream.h"
+#include <math.h>
+
+void historyStreamBegin(HistoryStream& s, const CookSession& session, uint16_t maxPoints) {
+    s.active = true;
+    s.chunk  = 0;
+    s.next   = 0;
+    s.level  = session.selectLevel(maxPoints);
+    s.resume = false;
+    sessionEventsBegin(s.events);
+}
+
+void historyStreamResume(HistoryStream& s, uint32_t since) {
+    s.active = true;
+    s.chunk  = 0;
+    s.next   = since;
+    s.level  = 0;
+    s.resume = true;
+    sessionEventsBegin(s.events);
+}
+
+size_t historyStreamNext(HistoryStream& s, const CookSession& session, HistoryScratch& scratch,
+                         float sp, const float* meatTargets, bool& final) {
+    final = false;
+    if (!s.active) return 0;
+
+    uint8_t level = s.level;
+    uint32_t total = session.getLevelCount(level);
+    if (s.next > total) s.next = total;   // Session was cleared
+
+    RollupPoint* raw = scratch.raw;
+    uint32_t n = session.readLevel(level, s.next, raw, WS_HISTORY_CHUNK_POINTS);
+    if (n == 0 && level == 0 && s.next < session.getFirstRamIndex()) {
+        // Flash range unreadable: skip ahead to what RAM still holds
+        s.next = session.getFirstRamIndex();
+        n = session.readLevel(level, s.next, raw, WS_HISTORY_CHUNK_POINTS);
+    }
+
+    for (uint32_t j = 0; j < n; j++) {
+        const RollupPoint* dp = &raw[j];
+        bbq_protocol::HistoryPoint& p = scratch.points[j];
+        p.ts = dp->timestamp;
+
+        // Convert int16 temps (x10) back to float, check disconnect flags
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            p.temp[c] = dpDisconnected(*dp, c) ? NAN : dp->tAvg[c] / 10.0f;
+        }
+
+        p.fan    = dp->fanPct;
+        p.damper = dp->damperPct;
+        // Setpoint in force at the point; points older than the journal
+        // (pre-journal firmware) fall back to the current one
+        sessionEventsSeek(session.getEvents(), s.events, dp->timestamp);
+        int16_t jsp = s.events.value[(uint8_t)SessionEventType::SETPOINT];
+        p.sp     = jsp != SESSION_EVENT_NONE ? jsp / 10.0f : sp;
+        p.lid    = (dp->flags & DP_FLAG_LID_OPEN) != 0;
+    }
+
+    bool last = s.next + n >= total;
+    bbq_protocol::HistoryReplay replay;
+    replay.session = session.getStartTime();
+    replay.next    = session.getTotalPointCount();
+    replay.resume  = s.resume;
+    size_t len = bbq_protocol::buildHistoryChunk(scratch.buf, sizeof(scratch.buf), s.chunk, last,
+                                                 replay, sp, meatTargets,
+                                                 scratch.points, n);
+    if (len == 0) {
+        s.active = false;
+        return 0;
+    }
+
+    s.next += n;
+    s.chunk++;
+    if (last) s.active = false;
+    final = last;
+    return len;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "config.h"
+#include "cook_session.h"
+#include "session_events.h"
+#include "web_protocol.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Chunked history replay of a CookSession: which LOD level is being sent,
+// how far it has got, and the journal position that gives each point the
+// setpoint in force at the time. The device web server keeps one per
+// WebSocket client and the simulator does the same, so both replay through
+// this code. Transport, back-pressure and pacing stay with the caller.
+struct HistoryStream {
+    bool     active;    // Replay in progress
+    uint16_t chunk;     // Index of the next chunk
+    uint32_t next;      // Index within level to send next
+    uint8_t  level;     // CookSession level being replayed
+    bool     resume;    // Replay is the tail after the client's hello `since`
+    SessionEventCursor events;   // Journal merged into the replay
+};
+
+// Working space for building one chunk. Chunks are built and handed off
+// one at a time, so one of these serves every stream.
+struct HistoryScratch {
+    bbq_protocol::HistoryPoint points[WS_HISTORY_CHUNK_POINTS];
+    RollupPoint raw[WS_HISTORY_CHUNK_POINTS];
+    char buf[WS_HISTORY_CHUNK_BYTES];
+};
+
+// Replay the whole cook at the finest level that fits maxPoints
+void historyStreamBegin(HistoryStream& s, const CookSession& session, uint16_t maxPoints);
+
+// Replay raw points from absolute index since on (a reconnect's tail)
+void historyStreamResume(HistoryStream& s, uint32_t since);
+
+// Build the next chunk into scratch.buf and advance. sp is the fallback
+// setpoint for points older than the journal, and with the targets goes
+// in chunk 0. final is set on the last chunk, after which the stream is
+// inactive. Returns the length, or 0 (stream stopped, chunk not advanced)
+// if the chunk overflowed.
+size_t historyStreamNext(HistoryStream& s, const CookSession& session, HistoryScratch& scratch,
+                         float sp, const float* meatTargets, bool& final);
@@ -0,0 +1,218 @@
+#include "hub_manager.h"
+#include "ext_ram.h"
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NATIVE_BUILD
+#include <ESPmDNS.h>
+#include <WiFi.h>
+#endif
+
+HubManager::HubManager()
+    : _table(nullptr)
+    , _sse(nullptr)
+#ifndef NATIVE_BUILD
+    , _mutex(nullptr)
+    , _task(nullptr)
+    , _lastDiscoverMs(0)
+#endif
+{
+    memset(&_settings, 0, sizeof(_settings));
+#ifndef NATIVE_BUILD
+    memset(_streaming, 0, sizeof(_streaming));
+    memset(_streamMs, 0, sizeof(_streamMs));
+#endif
+}
+
+void HubManager::begin(const HubSettings& settings) {
+    _settings = settings;
+    if (!_settings.enabled || _table) return;
+
+    void* table = extRamAlloc(sizeof(HubTable));
+    void* sse = extRamAlloc(sizeof(HubSseParser) * HUB_MAX_PEERS);
+    if (!table || !sse) {
+        extRamFree(table);
+        extRamFree(sse);
+#ifndef NATIVE_BUILD
+        Serial.println("[HUB] Out of memory, hub mode off");
+#endif
+        return;
+    }
+    _table = new (table) HubTable();
+    _sse = static_cast<HubSseParser*>(sse);
+    for (uint8_t i = 0; i < HUB_MAX_PEERS; i++) new (&_sse[i]) HubSseParser();
+
+    // Fixed peers: "host" or "host:port"
+    for (uint8_t i = 0; i < _settings.peerCount; i++) {
+        char host[HUB_HOST_LEN];
+        strncpy(host, _settings.peers[i], sizeof(host) - 1);
+        host[sizeof(host) - 1] = '\0';
+        uint16_t port = WEB_PORT;
+        char* colon = strchr(host, ':');
+        if (colon) {
+            *colon = '\0';
+            port = (uint16_t)atoi(colon + 1);
+        }
+        _table->add(nullptr, host, port ? port : WEB_PORT, 0, true);
+    }
+
+#ifndef NATIVE_BUILD
+    _mutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(taskMain, "hub", HUB_TASK_STACK, this,
+                            HUB_TASK_PRIORITY, &_task, HUB_TASK_CORE);
+    Serial.printf("[HUB] Hub mode on (%u fixed peers, mDNS browse every %u s)\n",
+                  (unsigned)_settings.peerCount, (unsigned)(HUB_DISCOVER_MS / 1000));
+#endif
+}
+
+void HubManager::writeState(HubOut out, void* ctx, const char* localFrame, size_t localLen) {
+    if (!_table) return;
+#ifndef NATIVE_BUILD
+    Lock lock(_mutex);
+    _table->writeState(out, ctx, MDNS_HOSTNAME, localFrame, localLen, millis());
+#endif
+}
+
+bool HubManager::writeHistory(HubOut out, void* ctx, int id, uint32_t sinceTs) {
+    if (!_table) return false;
+#ifndef NATIVE_BUILD
+    Lock lock(_mutex);
+    return _table->writeHistory(out, ctx, id, sinceTs);
+#else
+    return false;
+#endif
+}
+
+#ifndef NATIVE_BUILD
+
+void HubManager::taskMain(void* arg) {
+    HubManager* self = static_cast<HubManager*>(arg);
+    bool wasOnline = false;
+    for (;;) {
+        uint32_t now = millis();
+        bool online = WiFi.status() == WL_CONNECTED;
+        if (!online) {
+            if (wasOnline) {
+                for (int i = 0; i < HUB_MAX_PEERS; i++) self->closePeer(i);
+                Serial.println("[HUB] Wi-Fi down, peer streams closed");
+            }
+            wasOnline = false;
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        if (!wasOnline || now - self->_lastDiscoverMs >= HUB_DISCOVER_MS) {
+            self->discover(now);
+            self->_lastDiscoverMs = millis();
+        }
+        wasOnline = true;
+
+        for (int i = 0; i < HUB_MAX_PEERS; i++) self->servicePeer(i, millis());
+        vTaskDelay(pdMS_TO_TICKS(HUB_TASK_POLL_MS));
+    }
+}
+
+void HubManager::discover(uint32_t nowMs) {
+    // Blocks this task for the query timeout; the table stays readable
+    int n = MDNS.queryService("http", "tcp");
+    IPAddress self = WiFi.localIP();
+
+    uint8_t found = 0;
+    for (int i = 0; i < n; i++) {
+        if (!MDNS.hasTxt(i, HUB_MDNS_TXT_KEY)) continue;
+        IPAddress ip = MDNS.IP(i);
+        if (ip == self) continue;
+
+        char host[16];
+        snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        String name = MDNS.hostname(i);
+        Lock lock(_mutex);
+        if (_table->add(name.c_str(), host, MDNS.port(i), nowMs) >= 0) found++;
+    }
+
+    uint8_t dropped, known;
+    bool gone[HUB_MAX_PEERS];
+    {
+        Lock lock(_mutex);
+        dropped = _table->expire(nowMs);
+        known = _table->count();
+        for (int i = 0; i < HUB_MAX_PEERS; i++) gone[i] = !_table->peer(i);
+    }
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        if (gone[i] && _streaming[i]) closePeer(i);
+    }
+    if (found || dropped) {
+        Serial.printf("[HUB] Discovery: %u peers answered, %u dropped, %u known\n",
+                      (unsigned)found, (unsigned)dropped, (unsigned)known);
+    }
+}
+
+void HubManager::closePeer(int slot) {
+    if (_streaming[slot] || _conn[slot].connected()) _conn[slot].stop();
+    _streaming[slot] = false;
+}
+
+void HubManager::servicePeer(int slot, uint32_t nowMs) {
+    char host[HUB_HOST_LEN];
+    uint16_t port;
+    {
+        Lock lock(_mutex);
+        const HubPeer* p = _table->peer(slot);
+        if (!p) return;
+        if (!_streaming[slot] && !_table->connectDue(slot, nowMs)) return;
+        strncpy(host, p->host, sizeof(host));
+        port = p->port;
+    }
+
+    WiFiClient& c = _conn[slot];
+    if (!_streaming[slot]) {
+        if (!c.connect(host, port, HUB_CONNECT_TIMEOUT_MS)) {
+            Lock lock(_mutex);
+            _table->failed(slot, millis());
+            return;
+        }
+        c.printf("GET %s HTTP/1.1\r\nHost: %s\r\nAccept: text/event-stream\r\n\r\n",
+                 SSE_PATH, host);
+        _sse[slot].reset();
+        _streaming[slot] = true;
+        _streamMs[slot] = millis();
+        Serial.printf("[HUB] Following %s:%u\n", host, (unsigned)port);
+        return;
+    }
+
+    // Read what has arrived; frames go to the table as they complete
+    char buf[512];
+    int avail;
+    while ((avail = c.available()) > 0) {
+        int n = c.read((uint8_t*)buf, avail < (int)sizeof(buf) ? avail : (int)sizeof(buf));
+        if (n <= 0) break;
+        size_t pos = 0;
+        while (pos < (size_t)n) {
+            size_t used = 0;
+            HubSseResult r = _sse[slot].feed(buf + pos, n - pos, &used);
+            pos += used;
+            if (r == HubSseResult::FRAME) {
+                Lock lock(_mutex);
+                _table->frame(slot, _sse[slot].data(), _sse[slot].length(), millis());
+                _streamMs[slot] = millis();
+            } else if (r == HubSseResult::REJECTED) {
+                Serial.printf("[HUB] %s:%u refused the stream\n", host, (unsigned)port);
+                closePeer(slot);
+                Lock lock(_mutex);
+                _table->failed(slot, millis());
+                return;
+            }
+        }
+    }
+
+    // Closed by the peer, or nothing for too long
+    if (!c.connected() || millis() - _streamMs[slot] >= HUB_PEER_STALE_MS) {
+        Serial.printf("[HUB] Lost %s:%u\n", host, (unsigned)port);
+        closePeer(slot);
+        Lock lock(_mutex);
+        _table->failed(slot, millis());
+    }
+}
+
+#endif // NATIVE_BUILD
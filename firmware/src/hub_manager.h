@@ -0,0 +1,67 @@
+#pragma once
+
+#include "config.h"
+#include "config_manager.h"
+#include "hub_peers.h"
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#include <WiFiClient.h>
+#endif
+
+/// Hub mode: follows the other Pit Claws on the network and serves them
+/// with this unit as one merged view (GET /api/hub, /api/hub/history).
+///
+/// A task on core 0 browses mDNS for _http._tcp services carrying the
+/// HUB_MDNS_TXT_KEY record every HUB_DISCOVER_MS, adds the fixed peers
+/// from config, and keeps one /api/stream connection open per peer. The
+/// mDNS query and connects block only that task. The peer table is shared
+/// with the web handlers under a mutex that is never held across network
+/// calls.
+class HubManager {
+public:
+    HubManager();
+
+    /// Start the task if hub mode is on. Call once, after Wi-Fi has begun.
+    void begin(const HubSettings& settings);
+
+    bool enabled() const { return _table != nullptr; }
+
+    /// Merged state with this unit's data frame first (see HubTable)
+    void writeState(HubOut out, void* ctx, const char* localFrame, size_t localLen);
+
+    /// One peer's trend. False if there is no such peer.
+    bool writeHistory(HubOut out, void* ctx, int id, uint32_t sinceTs);
+
+private:
+#ifndef NATIVE_BUILD
+    static void taskMain(void* arg);
+
+    // mDNS browse, then drop peers that have gone
+    void discover(uint32_t nowMs);
+
+    // Connect, read or time out the stream of the peer in `slot`
+    void servicePeer(int slot, uint32_t nowMs);
+
+    void closePeer(int slot);
+
+    struct Lock {
+        explicit Lock(SemaphoreHandle_t m) : _m(m) { xSemaphoreTake(_m, portMAX_DELAY); }
+        ~Lock() { xSemaphoreGive(_m); }
+        SemaphoreHandle_t _m;
+    };
+#endif
+
+    HubSettings   _settings;
+    HubTable*     _table;       // In PSRAM when available; null while hub mode is off
+    HubSseParser* _sse;         // One per slot, task only
+
+#ifndef NATIVE_BUILD
+    SemaphoreHandle_t _mutex;
+    TaskHandle_t      _task;
+    WiFiClient        _conn[HUB_MAX_PEERS];
+    bool              _streaming[HUB_MAX_PEERS];
+    uint32_t          _streamMs[HUB_MAX_PEERS];   // Stream opened or last frame
+    uint32_t          _lastDiscoverMs;
+#endif
+};
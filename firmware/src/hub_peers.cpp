@@ -0,0 +1,365 @@
+#include "hub_peers.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Frame fields
+// ---------------------------------------------------------------------------
+
+float hubJsonNumber(const char* json, size_t len, const char* key) {
+    size_t keyLen = strlen(key);
+    for (size_t i = 0; i + keyLen + 3 <= len; i++) {
+        if (json[i] != '"' || memcmp(json + i + 1, key, keyLen) != 0) continue;
+        size_t p = i + 1 + keyLen;
+        if (json[p] != '"' || json[p + 1] != ':') continue;
+        p += 2;
+
+        // strtof needs a terminated string; numbers are short
+        char num[24];
+        size_t n = 0;
+        while (p < len && n < sizeof(num) - 1 && strchr("-+.0123456789eE", json[p])) {
+            num[n++] = json[p++];
+        }
+        if (n == 0) return NAN;   // null, or not a number
+        num[n] = '\0';
+        return strtof(num, nullptr);
+    }
+    return NAN;
+}
+
+static int16_t packTemp(float v) {
+    if (isnan(v)) return BIN_TEMP_NONE;
+    long t = lroundf(v * 10.0f);
+    return (int16_t)(t > INT16_MAX ? INT16_MAX : t <= INT16_MIN ? INT16_MIN + 1 : t);
+}
+
+static bool isDataFrame(const char* json, size_t len) {
+    static const char kType[] = "\"type\":\"data\"";
+    for (size_t i = 0; i + sizeof(kType) - 1 <= len && i < 16; i++) {
+        if (memcmp(json + i, kType, sizeof(kType) - 1) == 0) return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// HubTable
+// ---------------------------------------------------------------------------
+
+HubTable::HubTable() {
+    memset(_peers, 0, sizeof(_peers));
+}
+
+int HubTable::add(const char* name, const char* host, uint16_t port, uint32_t nowMs,
+                  bool pinned) {
+    if (!host || !host[0]) return -1;
+
+    int freeSlot = -1;
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        HubPeer& p = _peers[i];
+        if (!p.used) {
+            if (freeSlot < 0) freeSlot = i;
+            continue;
+        }
+        if (p.port == port && strcmp(p.host, host) == 0) {
+            p.seenMs = nowMs;
+            p.pinned = p.pinned || pinned;
+            if (name && name[0]) strncpy(p.name, name, sizeof(p.name) - 1);
+            return i;
+        }
+    }
+    if (freeSlot < 0) return -1;
+
+    HubPeer& p = _peers[freeSlot];
+    memset(&p, 0, sizeof(p));
+    p.used = true;
+    p.pinned = pinned;
+    strncpy(p.name, name && name[0] ? name : host, sizeof(p.name) - 1);
+    strncpy(p.host, host, sizeof(p.host) - 1);
+    p.port = port;
+    p.seenMs = nowMs;
+    p.retryAtMs = nowMs;
+    return freeSlot;
+}
+
+uint8_t HubTable::expire(uint32_t nowMs) {
+    uint8_t dropped = 0;
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        HubPeer& p = _peers[i];
+        if (!p.used || p.pinned) continue;
+        uint32_t last = p.frameMs > p.seenMs ? p.frameMs : p.seenMs;
+        if (nowMs - last >= HUB_PEER_EXPIRE_MS) {
+            p.used = false;
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+bool HubTable::frame(int slot, const char* json, size_t len, uint32_t nowMs) {
+    if (slot < 0 || slot >= HUB_MAX_PEERS || !_peers[slot].used) return false;
+    if (len == 0 || len >= sizeof(_peers[slot].frame) || !isDataFrame(json, len)) return false;
+
+    HubPeer& p = _peers[slot];
+    memcpy(p.frame, json, len);
+    p.frame[len] = '\0';
+    p.frameLen = (uint16_t)len;
+    p.frameMs = nowMs ? nowMs : 1;
+    p.frames++;
+    p.failures = 0;
+
+    // One history point per interval of the peer's own clock
+    float ts = hubJsonNumber(json, len, "ts");
+    if (isnan(ts) || ts <= 0) return true;
+    uint32_t t = (uint32_t)ts;
+    if (p.historyCount > 0) {
+        const HubPoint& last = p.history[(p.historyHead + HUB_HISTORY_POINTS - 1) % HUB_HISTORY_POINTS];
+        if (t >= last.ts && t - last.ts < HUB_HISTORY_INTERVAL_S) return true;
+        if (t < last.ts) p.historyCount = 0;   // Peer's clock moved back: new cook or NTP
+    }
+
+    HubPoint& pt = p.history[p.historyHead];
+    pt.ts = t;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        pt.temp[c] = packTemp(hubJsonNumber(json, len, kProbeChannels[c].key));
+    }
+    float fan = hubJsonNumber(json, len, "fan");
+    pt.fan = isnan(fan) ? 0 : (uint8_t)fan;
+    p.historyHead = (p.historyHead + 1) % HUB_HISTORY_POINTS;
+    if (p.historyCount < HUB_HISTORY_POINTS) p.historyCount++;
+    return true;
+}
+
+void HubTable::failed(int slot, uint32_t nowMs) {
+    if (slot < 0 || slot >= HUB_MAX_PEERS || !_peers[slot].used) return;
+    HubPeer& p = _peers[slot];
+    uint32_t delay = HUB_RETRY_BASE_MS;
+    for (uint8_t i = 0; i < p.failures && delay < HUB_RETRY_MAX_MS; i++) delay *= 2;
+    if (delay > HUB_RETRY_MAX_MS) delay = HUB_RETRY_MAX_MS;
+    if (p.failures < 255) p.failures++;
+    p.retryAtMs = nowMs + delay;
+}
+
+bool HubTable::connectDue(int slot, uint32_t nowMs) const {
+    if (slot < 0 || slot >= HUB_MAX_PEERS || !_peers[slot].used) return false;
+    return (int32_t)(nowMs - _peers[slot].retryAtMs) >= 0;
+}
+
+bool HubTable::online(int slot, uint32_t nowMs) const {
+    if (slot < 0 || slot >= HUB_MAX_PEERS || !_peers[slot].used) return false;
+    const HubPeer& p = _peers[slot];
+    return p.frameMs != 0 && nowMs - p.frameMs < HUB_PEER_STALE_MS;
+}
+
+uint8_t HubTable::count() const {
+    uint8_t n = 0;
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        if (_peers[i].used) n++;
+    }
+    return n;
+}
+
+const HubPeer* HubTable::peer(int slot) const {
+    if (slot < 0 || slot >= HUB_MAX_PEERS || !_peers[slot].used) return nullptr;
+    return &_peers[slot];
+}
+
+// ---------------------------------------------------------------------------
+// JSON
+// ---------------------------------------------------------------------------
+
+static void put(HubOut out, void* ctx, const char* s) {
+    out(s, strlen(s), ctx);
+}
+
+// Names and hosts come from the network; keep only what needs no escaping
+static void putString(HubOut out, void* ctx, const char* s) {
+    char buf[HUB_HOST_LEN + 2];
+    size_t n = 0;
+    buf[n++] = '"';
+    for (; *s && n < sizeof(buf) - 1; s++) {
+        char c = *s;
+        if (c == '"' || c == '\\' || (uint8_t)c < 0x20) continue;
+        buf[n++] = c;
+    }
+    buf[n++] = '"';
+    out(buf, n, ctx);
+}
+
+void HubTable::writeState(HubOut out, void* ctx, const char* localName,
+                          const char* localFrame, size_t localLen, uint32_t nowMs) const {
+    put(out, ctx, "{\"type\":\"hub\",\"units\":[{\"id\":-1,\"name\":");
+    putString(out, ctx, localName ? localName : "");
+    put(out, ctx, ",\"local\":true,\"online\":true,\"data\":");
+    if (localFrame && localLen > 0) out(localFrame, localLen, ctx);
+    else                            put(out, ctx, "null");
+    put(out, ctx, "}");
+
+    char buf[96];
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        const HubPeer& p = _peers[i];
+        if (!p.used) continue;
+        snprintf(buf, sizeof(buf), ",{\"id\":%d,\"name\":", i);
+        put(out, ctx, buf);
+        putString(out, ctx, p.name);
+        put(out, ctx, ",\"host\":");
+        putString(out, ctx, p.host);
+        bool on = online(i, nowMs);
+        if (p.frameMs) {
+            snprintf(buf, sizeof(buf), ",\"port\":%u,\"online\":%s,\"age\":%u,\"data\":",
+                     (unsigned)p.port, on ? "true" : "false",
+                     (unsigned)((nowMs - p.frameMs) / 1000));
+            put(out, ctx, buf);
+            out(p.frame, p.frameLen, ctx);
+        } else {
+            snprintf(buf, sizeof(buf), ",\"port\":%u,\"online\":false,\"age\":null,\"data\":null",
+                     (unsigned)p.port);
+            put(out, ctx, buf);
+        }
+        put(out, ctx, "}");
+    }
+    put(out, ctx, "]}");
+}
+
+static void putTemp(char* buf, size_t size, int16_t t) {
+    if (t == BIN_TEMP_NONE) snprintf(buf, size, ",null");
+    else                    snprintf(buf, size, ",%.1f", t / 10.0f);
+}
+
+bool HubTable::writeHistory(HubOut out, void* ctx, int slot, uint32_t sinceTs) const {
+    const HubPeer* p = peer(slot);
+    if (!p) return false;
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "{\"id\":%d,\"name\":", slot);
+    put(out, ctx, buf);
+    putString(out, ctx, p->name);
+    put(out, ctx, ",\"points\":[");
+
+    bool first = true;
+    uint16_t start = (p->historyHead + HUB_HISTORY_POINTS - p->historyCount) % HUB_HISTORY_POINTS;
+    for (uint16_t n = 0; n < p->historyCount; n++) {
+        const HubPoint& pt = p->history[(start + n) % HUB_HISTORY_POINTS];
+        if (pt.ts <= sinceTs) continue;
+        snprintf(buf, sizeof(buf), "%s[%u", first ? "" : ",", (unsigned)pt.ts);
+        put(out, ctx, buf);
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            putTemp(buf, sizeof(buf), pt.temp[c]);
+            put(out, ctx, buf);
+        }
+        snprintf(buf, sizeof(buf), ",%u]", (unsigned)pt.fan);
+        put(out, ctx, buf);
+        first = false;
+    }
+    put(out, ctx, "]}");
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// HubSseParser
+// ---------------------------------------------------------------------------
+
+HubSseParser::HubSseParser() {
+    reset();
+}
+
+void HubSseParser::reset() {
+    _phase = Phase::STATUS;
+    _lineLen = 0;
+    _lineOverflow = false;
+    _skipEvent = false;
+    _ready = false;
+    _dataLen = 0;
+}
+
+void HubSseParser::line() {
+    // Strip the CR of a CRLF ending
+    if (_lineLen > 0 && _line[_lineLen - 1] == '\r') _lineLen--;
+    _line[_lineLen] = '\0';
+
+    switch (_phase) {
+        case Phase::STATUS:
+            // "HTTP/1.1 200 OK"
+            _phase = (_lineLen >= 12 && strncmp(_line, "HTTP/", 5) == 0
+                      && strncmp(_line + 9, "200", 3) == 0) ? Phase::HEADERS : Phase::FAILED;
+            return;
+
+        case Phase::HEADERS:
+            if (_lineLen == 0) _phase = Phase::BODY;
+            return;
+
+        case Phase::BODY:
+            break;
+
+        case Phase::FAILED:
+            return;
+    }
+
+    // Blank line: end of event
+    if (_lineLen == 0) {
+        if (!_skipEvent && _dataLen > 0) {
+            _data[_dataLen] = '\0';
+            _ready = true;
+        } else {
+            _dataLen = 0;
+        }
+        _skipEvent = false;
+        return;
+    }
+    if (_lineOverflow) {
+        _skipEvent = true;
+        return;
+    }
+
+    const char* value = strchr(_line, ':');
+    size_t nameLen = value ? (size_t)(value - _line) : _lineLen;
+    if (value) {
+        value++;
+        if (*value == ' ') value++;
+    } else {
+        value = _line + _lineLen;
+    }
+
+    if (nameLen == 5 && strncmp(_line, "event", 5) == 0) {
+        if (strcmp(value, "data") != 0) _skipEvent = true;
+    } else if (nameLen == 4 && strncmp(_line, "data", 4) == 0) {
+        size_t n = strlen(value);
+        size_t sep = _dataLen > 0 ? 1 : 0;
+        if (_dataLen + sep + n >= sizeof(_data)) {
+            _skipEvent = true;
+            return;
+        }
+        if (sep) _data[_dataLen++] = '\n';
+        memcpy(_data + _dataLen, value, n);
+        _dataLen += (uint16_t)n;
+    }
+    // id, retry and comments are ignored
+}
+
+HubSseResult HubSseParser::feed(const char* data, size_t len, size_t* used) {
+    if (_ready) {
+        _ready = false;
+        _dataLen = 0;
+    }
+
+    size_t i = 0;
+    while (i < len && _phase != Phase::FAILED) {
+        char c = data[i++];
+        if (c != '\n') {
+            if (_lineLen < sizeof(_line) - 1) _line[_lineLen++] = c;
+            else                              _lineOverflow = true;
+            continue;
+        }
+        line();
+        _lineLen = 0;
+        _lineOverflow = false;
+        if (_ready) {
+            if (used) *used = i;
+            return HubSseResult::FRAME;
+        }
+    }
+
+    if (used) *used = i;
+    return _phase == Phase::FAILED ? HubSseResult::REJECTED : HubSseResult::NONE;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "config.h"
+#include "web_protocol.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Peer table for hub mode.
+//
+// A hub finds the other units (mDNS on the device, a --peer list in the
+// simulator), follows each one's data frames and serves them all from one
+// address: GET /api/hub has every unit's latest frame, GET /api/hub/history
+// a slow per-peer trend. Phones then keep one connection to the hub and
+// each peer only feeds the hub.
+//
+// HubTable holds the peers, their last frame and a HUB_HISTORY_POINTS ring
+// of one point per HUB_HISTORY_INTERVAL_S taken from the frames. Reconnects
+// back off from HUB_RETRY_BASE_MS to HUB_RETRY_MAX_MS. HubSseParser turns
+// the bytes of a peer's /api/stream response into data frames. The caller
+// owns the sockets and any locking; nothing here blocks or allocates.
+//
+// Pure C++, testable on native.
+
+// Output for the JSON writers (same shape as MetricsOut)
+typedef void (*HubOut)(const char* text, size_t len, void* ctx);
+
+struct HubPoint {
+    uint32_t ts;                  // Peer's clock (epoch seconds)
+    int16_t  temp[NUM_PROBES];    // By this unit's channel keys, degrees x10; BIN_TEMP_NONE = not connected
+    uint8_t  fan;
+};
+
+struct HubPeer {
+    bool     used;
+    bool     pinned;              // From config: never expires
+    char     name[HUB_NAME_LEN];
+    char     host[HUB_HOST_LEN];
+    uint16_t port;
+    uint32_t seenMs;              // Last discovery answer
+    uint32_t frameMs;             // Last data frame (0 = none yet)
+    uint32_t frames;
+    uint8_t  failures;            // Failed connects/streams since the last frame
+    uint32_t retryAtMs;           // No connect before this
+
+    char     frame[DATA_MESSAGE_MAX_BYTES];   // Last data frame, as sent
+    uint16_t frameLen;
+
+    HubPoint history[HUB_HISTORY_POINTS];
+    uint16_t historyHead;         // Next write
+    uint16_t historyCount;
+};
+
+class HubTable {
+public:
+    HubTable();
+
+    // Add a peer or refresh one already known by host and port. Returns
+    // its slot, or -1 when the table is full (or host is empty).
+    int add(const char* name, const char* host, uint16_t port, uint32_t nowMs,
+            bool pinned = false);
+
+    // Forget discovered peers that have neither answered discovery nor
+    // sent a frame for HUB_PEER_EXPIRE_MS. Returns how many were dropped.
+    uint8_t expire(uint32_t nowMs);
+
+    // A data frame from the peer in `slot`. Stored as is and sampled into
+    // the history ring. False if it isn't a data frame.
+    bool frame(int slot, const char* json, size_t len, uint32_t nowMs);
+
+    // A connect or stream failed; schedules the retry.
+    void failed(int slot, uint32_t nowMs);
+
+    // Worth (re)connecting now
+    bool connectDue(int slot, uint32_t nowMs) const;
+
+    // Data within HUB_PEER_STALE_MS
+    bool online(int slot, uint32_t nowMs) const;
+
+    uint8_t count() const;
+    const HubPeer* peer(int slot) const;
+
+    // {"type":"hub","units":[...]} with this unit first (its data frame in
+    // localFrame, or nullptr) and then every peer in slot order.
+    void writeState(HubOut out, void* ctx, const char* localName,
+                    const char* localFrame, size_t localLen, uint32_t nowMs) const;
+
+    // {"id":N,"name":..,"points":[[ts,pit,meat1,meat2,..,fan],...]} oldest
+    // first (one temp per probe channel), only points newer than sinceTs.
+    // False if the slot is empty.
+    bool writeHistory(HubOut out, void* ctx, int slot, uint32_t sinceTs) const;
+
+private:
+    HubPeer _peers[HUB_MAX_PEERS];
+};
+
+// Finds a numeric field in a flat JSON object ("key":value). NAN when the
+// key is missing or null.
+float hubJsonNumber(const char* json, size_t len, const char* key);
+
+// --- Event stream ---
+
+enum class HubSseResult : uint8_t {
+    NONE,       // Need more bytes
+    FRAME,      // A complete data event is in data()/length()
+    REJECTED    // Response wasn't 200 (e.g. the peer's viewer slots are full)
+};
+
+// Incremental parser for an HTTP response carrying a text/event-stream.
+// Skips the status line and headers, then collects "data:" lines until the
+// blank line that ends each event. Events of a type other than "data" and
+// events too long for the buffer are dropped.
+class HubSseParser {
+public:
+    HubSseParser();
+
+    // Start over for a new connection
+    void reset();
+
+    // Consume bytes up to the end of the next complete event (or all of
+    // them). *used is set to the bytes consumed; call again with the rest.
+    HubSseResult feed(const char* data, size_t len, size_t* used);
+
+    const char* data() const { return _data; }
+    size_t length() const { return _dataLen; }
+
+private:
+    void line();
+
+    enum class Phase : uint8_t { STATUS, HEADERS, BODY, FAILED };
+    Phase    _phase;
+    char     _line[DATA_MESSAGE_MAX_BYTES + 8];
+    uint16_t _lineLen;
+    bool     _lineOverflow;
+    bool     _skipEvent;     // Non-data event type, or too long
+    bool     _ready;         // A frame finished on the last line
+    char     _data[DATA_MESSAGE_MAX_BYTES];
+    uint16_t _dataLen;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+
+// Running least-squares line through (t, y) samples, for rolling windows
+// that add the newest sample and drop the oldest in constant time. x is
+// t - base, so the x sums are exact integers; a window rebases on its
+// oldest sample now and then (reset(), then add() the samples again) to
+// keep x small and bound drift in the y sums.
+struct LinearFit {
+    uint32_t base;
+    uint16_t n;
+    int64_t  sumX;
+    int64_t  sumX2;
+    double   sumY;
+    double   sumXY;
+
+    void reset(uint32_t newBase) {
+        base  = newBase;
+        n     = 0;
+        sumX  = 0;
+        sumX2 = 0;
+        sumY  = 0.0;
+        sumXY = 0.0;
+    }
+
+    // sign +1 adds a sample, -1 takes one back out
+    void add(uint32_t t, float y, int sign) {
+        int64_t x = (int32_t)(t - base);
+        n     += sign;
+        sumX  += sign * x;
+        sumX2 += sign * x * x;
+        sumY  += sign * (double)y;
+        sumXY += sign * (double)x * y;
+    }
+
+    // slope = (N * sum(x*y) - sum(x) * sum(y)) / (N * sum(x^2) - (sum(x))^2),
+    // in y per unit of t. 0 until there are two distinct t.
+    float slope() const {
+        int64_t denom = (int64_t)n * sumX2 - sumX * sumX;
+        if (denom == 0) return 0.0f;
+        return (float)(((double)n * sumXY - (double)sumX * sumY) / (double)denom);
+    }
+
+    float mean() const { return n ? (float)(sumY / n) : 0.0f; }
+};
+
+// Fixed-size ring of (t, y) with its LinearFit kept current: push() adds
+// the newest sample and retires the oldest once full.
+template <uint16_t N>
+class TrendWindow {
+public:
+    TrendWindow() { clear(); }
+
+    void clear() {
+        _head = 0;
+        _count = 0;
+        _fit.reset(0);
+    }
+
+    void push(uint32_t t, float y) {
+        if (_count == 0) _fit.reset(t);
+        if (_count == N) _fit.add(_t[_head], _y[_head], -1);
+        _t[_head] = t;
+        _y[_head] = y;
+        _fit.add(t, y, +1);
+        _head = (uint16_t)((_head + 1) % N);
+        if (_count < N) _count++;
+
+        // Once per trip around a full ring, rebase on the oldest sample
+        if (_head == 0 && _count == N) {
+            _fit.reset(_t[0]);
+            for (uint16_t i = 0; i < N; i++) _fit.add(_t[i], _y[i], +1);
+        }
+    }
+
+    uint16_t count() const { return _count; }
+    bool     full() const { return _count == N; }
+    float    slope() const { return _fit.slope(); }
+    float    mean() const { return _fit.mean(); }
+
+    // Seconds from the oldest sample to the newest
+    uint32_t span() const {
+        if (_count == 0) return 0;
+        uint16_t oldest = _count < N ? 0 : _head;
+        uint16_t newest = (uint16_t)((_head + N - 1) % N);
+        return _t[newest] - _t[oldest];
+    }
+
+private:
+    uint32_t  _t[N];
+    float     _y[N];
+    uint16_t  _head;
+    uint16_t  _count;
+    LinearFit _fit;
+};
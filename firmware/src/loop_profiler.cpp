@@ -0,0 +1,176 @@
+#include "loop_profiler.h"
+#include "seqlock.h"
+
+#include <atomic>
+#include <string.h>
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#endif
+
+namespace {
+
+struct PhaseInfo {
+    const char* name;
+    uint32_t    budgetUs;
+};
+
+const PhaseInfo kPhaseInfo[(uint8_t)LoopPhase::COUNT] = {
+    { "temp",        PROFILE_BUDGET_TEMP_US },
+    { "pid",         PROFILE_BUDGET_PID_US },
+    { "split_range", PROFILE_BUDGET_SPLIT_US },
+    { "fan",         PROFILE_BUDGET_FAN_US },
+    { "alarms",      PROFILE_BUDGET_ALARMS_US },
+    { "errors",      PROFILE_BUDGET_ERRORS_US },
+    { "session",     PROFILE_BUDGET_SESSION_US },
+    { "web",         PROFILE_BUDGET_WEB_US },
+    { "wifi",        PROFILE_BUDGET_WIFI_US },
+    { "ota",         PROFILE_BUDGET_OTA_US },
+    { "display",     PROFILE_BUDGET_DISPLAY_US },
+    { "lvgl",        PROFILE_BUDGET_LVGL_US },
+};
+
+struct Phase {
+    // Writer-only window state
+    uint32_t hist[PROFILE_BUCKETS];
+    uint32_t samples;
+    uint32_t over;
+    uint32_t maxUs;
+    uint64_t startUs;
+    bool     started;
+    uint32_t peakUs;
+    uint32_t overTotal;
+
+    // Published at each window close
+    Seqlock<LoopPhaseStats> stats;
+};
+
+Phase g_phases[(uint8_t)LoopPhase::COUNT];
+std::atomic<uint32_t> g_overruns;
+
+uint32_t bucketBoundUs(uint8_t b) {
+    return 8u << b;
+}
+
+void closeWindow(LoopPhase p) {
+    Phase& ph = g_phases[(uint8_t)p];
+    const PhaseInfo& info = kPhaseInfo[(uint8_t)p];
+
+    // p99 is the smallest bound covering ceil(0.99 n) samples
+    uint32_t rank = ph.samples - ph.samples / 100;
+    uint32_t cumulative = 0;
+    uint32_t p99 = ph.maxUs;
+    for (uint8_t b = 0; b < PROFILE_BUCKETS - 1; b++) {
+        cumulative += ph.hist[b];
+        if (cumulative >= rank) {
+            p99 = bucketBoundUs(b) < ph.maxUs ? bucketBoundUs(b) : ph.maxUs;
+            break;
+        }
+    }
+
+    // Over budget for more than 1% of samples is the same as p99 > budget
+    bool flagged = ph.samples >= PROFILE_MIN_SAMPLES && ph.over * 100 > ph.samples;
+
+    // Edited in place: a loop phase is published on the loop task, which
+    // /metrics on async_tcp can preempt mid-write (see seqlock.h), so the
+    // write is kept to these stores and the writer never reads back
+    bool wasFlagged = false;
+    uint32_t prevPeak = 0;
+    ph.stats.update([&](LoopPhaseStats& st) {
+        wasFlagged    = st.flagged;
+        prevPeak      = st.peakUs;
+        st.budgetUs   = info.budgetUs;
+        st.p99Us      = p99;
+        st.maxUs      = ph.maxUs;
+        st.peakUs     = ph.peakUs;
+        st.samples    = ph.samples;
+        st.overBudget = ph.overTotal;
+        st.flagged    = flagged;
+    });
+
+    uint32_t bit = 1u << (uint8_t)p;
+    if (flagged) g_overruns.fetch_or(bit, std::memory_order_relaxed);
+    else         g_overruns.fetch_and(~bit, std::memory_order_relaxed);
+
+#ifndef NATIVE_BUILD
+    if (flagged != wasFlagged) {
+        Serial.printf("[PROF] %s %s budget: p99 %u us, max %u us (budget %u us)\n",
+                      info.name, flagged ? "over" : "back within",
+                      (unsigned)p99, (unsigned)ph.maxUs, (unsigned)info.budgetUs);
+    } else if (!flagged && ph.over > 0 && ph.peakUs > prevPeak) {
+        // Isolated slow passes: only report a new worst case
+        Serial.printf("[PROF] %s: %u/%u passes over %u us budget, new peak %u us\n",
+                      info.name, (unsigned)ph.over, (unsigned)ph.samples,
+                      (unsigned)info.budgetUs, (unsigned)ph.maxUs);
+    }
+#else
+    (void)wasFlagged;
+    (void)prevPeak;
+#endif
+
+    memset(ph.hist, 0, sizeof(ph.hist));
+    ph.samples = 0;
+    ph.over    = 0;
+    ph.maxUs   = 0;
+}
+
+} // namespace
+
+const char* loopPhaseName(LoopPhase p) {
+    return (uint8_t)p < (uint8_t)LoopPhase::COUNT ? kPhaseInfo[(uint8_t)p].name : "?";
+}
+
+uint32_t loopPhaseBudgetUs(LoopPhase p) {
+    return kPhaseInfo[(uint8_t)p].budgetUs;
+}
+
+void loopProfilerRecord(LoopPhase p, uint32_t us, uint64_t nowUs) {
+    Phase& ph = g_phases[(uint8_t)p];
+
+    // The sample that ends a window opens the next one
+    if (!ph.started) {
+        ph.started = true;
+        ph.startUs = nowUs;
+    } else if (nowUs - ph.startUs >= (uint64_t)PROFILE_WINDOW_MS * 1000ULL) {
+        closeWindow(p);
+        ph.startUs = nowUs;
+    }
+
+    uint8_t b = 0;
+    while (b < PROFILE_BUCKETS - 1 && us > bucketBoundUs(b)) b++;
+    ph.hist[b]++;
+    ph.samples++;
+    if (us > kPhaseInfo[(uint8_t)p].budgetUs) {
+        ph.over++;
+        ph.overTotal++;
+    }
+    if (us > ph.maxUs)  ph.maxUs = us;
+    if (us > ph.peakUs) ph.peakUs = us;
+}
+
+LoopPhaseStats loopProfilerRead(LoopPhase p) {
+    LoopPhaseStats out = g_phases[(uint8_t)p].stats.read();
+    // The budget is known before the first window closes
+    out.budgetUs = kPhaseInfo[(uint8_t)p].budgetUs;
+    return out;
+}
+
+uint32_t loopProfilerOverruns() {
+    return g_overruns.load(std::memory_order_relaxed);
+}
+
+void loopProfilerReset() {
+    for (uint8_t i = 0; i < (uint8_t)LoopPhase::COUNT; i++) {
+        Phase& ph = g_phases[i];
+        memset(ph.hist, 0, sizeof(ph.hist));
+        ph.samples   = 0;
+        ph.over      = 0;
+        ph.maxUs     = 0;
+        ph.startUs   = 0;
+        ph.started   = false;
+        ph.peakUs    = 0;
+        ph.overTotal = 0;
+        ph.stats.write(LoopPhaseStats{});
+    }
+    g_overruns.store(0, std::memory_order_relaxed);
+}
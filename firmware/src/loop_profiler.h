@@ -0,0 +1,86 @@
+#pragma once
+
+#include "config.h"
+#include "metrics.h"
+#include <stdint.h>
+
+// Per-phase timing of the numbered steps in controlTick() and loop().
+//
+// Each phase keeps a window of PROFILE_WINDOW_MS: a log2 histogram, the
+// max, and the number of samples over the phase's budget. When a window
+// closes its p99 and max are published and the phase is flagged if more
+// than 1% of its samples were over budget (i.e. the p99 is). The flag
+// clears after a window that stays within budget. A single slow pass only
+// logs a [PROF] line.
+//
+// Control phases are recorded by the control task and loop phases by
+// loop(), so every phase has one writer. Readers on other tasks (web,
+// /metrics) get a consistent copy through a per-phase Seqlock. /metrics
+// runs on async_tcp, which preempts loop() on core 0; a scrape that lands
+// mid-publish sleeps until the loop task finishes it (seqlock.h).
+// Pure C++ apart from the clock, so it's testable on native.
+
+enum class LoopPhase : uint8_t {
+    // controlTick()
+    TEMP,          // 1. Probe sampling and done-time prediction
+    PID,           // 2. PID computation
+    SPLIT_RANGE,   // 3. Fan/damper split
+    FAN,           // 4. Fan controller update
+    ALARMS,        // 5. Alarm manager
+    ERRORS,        // 6. Error manager
+    // loop()
+    SESSION,       // 7. Cook session update and flush
+    WEB,           // 8. Web server update
+    WIFI,          // 9. Wi-Fi manager
+    OTA,           // 10. OTA manager
+    DISPLAY,       // 11. Dashboard labels and graph
+    LVGL,          // 12. LVGL tick and handler
+    COUNT
+};
+
+#define PROFILE_BUCKETS 16   // Upper bounds 8 us << b; the last also counts the rest
+
+struct LoopPhaseStats {
+    uint32_t budgetUs;
+    uint32_t p99Us;        // Last closed window (histogram bound, capped at max)
+    uint32_t maxUs;        // Last closed window
+    uint32_t peakUs;       // Since boot
+    uint32_t samples;      // In the last closed window
+    uint32_t overBudget;   // Samples over budget since boot
+    bool     flagged;      // p99 over budget in the last closed window
+};
+
+// Short lowercase name, e.g. "split_range"; used for labels and messages
+const char* loopPhaseName(LoopPhase p);
+
+uint32_t loopPhaseBudgetUs(LoopPhase p);
+
+// Record one pass of a phase that took us, ending at nowUs
+void loopProfilerRecord(LoopPhase p, uint32_t us, uint64_t nowUs);
+
+LoopPhaseStats loopProfilerRead(LoopPhase p);
+
+// Bit per LoopPhase that is currently flagged
+uint32_t loopProfilerOverruns();
+
+// Clear everything (tests, and nothing else)
+void loopProfilerReset();
+
+// Times consecutive phases: each end() records the time since the
+// previous end() (or construction) against that phase.
+class PhaseLap {
+public:
+    PhaseLap() : _last(metricsNowUs()) {}
+
+    void end(LoopPhase p) {
+        uint64_t now = metricsNowUs();
+        loopProfilerRecord(p, (uint32_t)(now - _last), now);
+        _last = now;
+    }
+
+    // Restart the lap without recording (for unprofiled work in between)
+    void skip() { _last = metricsNowUs(); }
+
+private:
+    uint64_t _last;
+};
@@ -1,109 +1,257 @@
 #ifndef NATIVE_BUILD
 
 #include <Arduino.h>
+#include <esp_attr.h>
 #include "config.h"
-#include "split_range.h"
+#include "telemetry.h"
+#include "controller_state.h"
+#include "metrics.h"
+#include "loop_profiler.h"
 
 // --- Module headers ---
 #include "temp_manager.h"
-#include "pid_controller.h"
-#include "fan_controller.h"
-#include "servo_controller.h"
+#include "temp_predictor.h"
+#include "trend_monitor.h"
+#include "probe_calibration.h"
+#include "control_zone.h"
 #include "config_manager.h"
 #include "cook_session.h"
 #include "alarm_manager.h"
 #include "error_manager.h"
 #include "wifi_manager.h"
+#include "mqtt_publisher.h"
+#include "notifier.h"
+#if BBQ_FEATURE_HUB
+#include "hub_manager.h"
+#endif
 #include "web_server.h"
 #include "ota_manager.h"
 #include "display/ui_init.h"
 #include "display/ui_update.h"
 #include "display/ui_setup_wizard.h"
 #include "display/ui_boot_splash.h"
+#include "display/graph_history.h"
 
 // --- Module instances ---
 TempManager     tempManager;
-PidController   pidController;
-FanController   fanController;
-ServoController servoController;
+TempPredictor   tempPredictor;
+TrendMonitor    trendMonitor;
+ProbeCalibrator probeCalibrator;
 ConfigManager   configManager;
 CookSession     cookSession;
 AlarmManager    alarmManager;
 ErrorManager    errorManager;
 WifiManager     wifiManager;
+MqttPublisher   mqttPublisher;
+Notifier        notifier;
+#if BBQ_FEATURE_HUB
+HubManager      hubManager;
+#endif
 BBQWebServer    webServer;
 OtaManager      otaManager;
 
-// --- Control state ---
-static float    g_setpoint       = 225.0f;   // Default pit setpoint (degrees F)
-static float    g_prevSetpoint   = 225.0f;   // Previous setpoint for change detection
-static bool     g_pitReached     = false;     // Has pit ever reached setpoint?
+// --- Control zones ---
+// Zone 0 runs the stock fan and damper from the pit probe; config.json
+// "zones" adds the others (see control_zone.h). Owned by the control task.
+// Callbacks from the UI and web tasks change them only while holding
+// g_controlMutex (see ControlLock).
+static ControlZone g_zones[CONTROL_ZONES_MAX];
+static uint8_t     g_zoneCount = 1;
+PidController&     pidController   = g_zones[0].pid();
+FanController&     fanController   = g_zones[0].fan();
+ServoController&   servoController = g_zones[0].servo();
+
 static uint32_t g_cookStartTime  = 0;         // Epoch when cook timer started
-static unsigned long g_lastPidMs = 0;         // Last PID computation timestamp
+
+// --- Control task ---
+// Sampling, PID and actuation run in their own task pinned to
+// CONTROL_TASK_CORE; LVGL, Wi-Fi, the web server and session logging stay
+// in loop() on the other core. Each control tick runs under g_controlMutex
+// and ends by publishing a TelemetrySnapshot, which loop() and the web
+// server read lock-free.
+static TelemetryChannel  g_telemetry;
+static TelemetrySnapshot g_view;            // loop()'s copy, refreshed when the version moves
+static uint32_t          g_viewVersion = 0;
+static SemaphoreHandle_t g_controlMutex = nullptr;
+static TaskHandle_t      g_controlTask  = nullptr;
+static volatile bool     g_newSessionRequested = false;  // Set by the web task
+
+// Scoped hold of the control mutex for code outside the control task that
+// touches control-owned modules. Keep the scope short: the control tick
+// waits for it.
+struct ControlLock {
+    ControlLock()  { if (g_controlMutex) xSemaphoreTake(g_controlMutex, portMAX_DELAY); }
+    ~ControlLock() { if (g_controlMutex) xSemaphoreGive(g_controlMutex); }
+};
+
+// --- Warm restart checkpoint ---
+// The control task reseals g_ctrlState every CONTROL_STATE_RTC_MS and copies
+// it into RTC memory, which keeps its contents through software, watchdog
+// and panic resets. loop() mirrors it to flash for power loss.
+RTC_NOINIT_ATTR static ControllerState g_rtcState;
+static ControllerState   g_ctrlState;               // Control task's working copy
+static ControllerState   g_flashState;              // Last image mirrored to flash
+static volatile uint32_t g_stateSession    = 0;     // Active cook's start epoch, set by loop()
+static volatile bool     g_stateChanged    = false; // Setpoint, a target or the cook moved since the last mirror
+static unsigned long     g_lastStateMs     = 0;
+static unsigned long     g_lastStateSaveMs = 0;
 
 // --- Boot phase state machine ---
 enum class BootPhase { SPLASH, WIZARD, RUNNING };
 static BootPhase    g_bootPhase    = BootPhase::SPLASH;
 static unsigned long g_wizardDoneMs = 0;
 
+// Work deferred out of setup() so control resumes first. loop() runs one
+// stage per pass once the splash is done: the graph rebuild, then Wi-Fi,
+// then the web server and OTA.
+enum class BootStage { GRAPH, WIFI, WEB, DONE };
+static BootStage g_bootStage = BootStage::GRAPH;
+
 // --- CookSession data-source callbacks ---
 // These free functions bridge the global module instances into the function-pointer
 // interface that CookSession::setDataSources() expects.
 
-static float cb_getPitTemp()   { return tempManager.getPitTemp(); }
-static float cb_getMeat1Temp() { return tempManager.getMeat1Temp(); }
-static float cb_getMeat2Temp() { return tempManager.getMeat2Temp(); }
+// Session logging runs in loop(), so these read the telemetry snapshot.
+
+static float cb_getTemp(uint8_t probe)    { return g_view.temp[probe]; }
+static bool  cb_isConnected(uint8_t probe) { return g_view.connected[probe]; }
 
 static uint8_t cb_getFanPct() {
-    return static_cast<uint8_t>(fanController.getCurrentSpeedPct());
+    return static_cast<uint8_t>(g_view.fanPct);
 }
 
 static uint8_t cb_getDamperPct() {
-    return static_cast<uint8_t>(servoController.getCurrentPositionPct());
+    return static_cast<uint8_t>(g_view.damperPct);
 }
 
 static uint8_t cb_getFlags() {
-    uint8_t flags = 0;
-    if (pidController.isLidOpen())                    flags |= DP_FLAG_LID_OPEN;
-    if (!tempManager.isConnected(PROBE_PIT))          flags |= DP_FLAG_PIT_DISC;
-    if (!tempManager.isConnected(PROBE_MEAT1))        flags |= DP_FLAG_MEAT1_DISC;
-    if (!tempManager.isConnected(PROBE_MEAT2))        flags |= DP_FLAG_MEAT2_DISC;
-    if (errorManager.isFireOut())                     flags |= DP_FLAG_ERROR_FIREOUT;
+    return telemetryFlags(g_view);
+}
 
-    AlarmType activeAlarms[MAX_ACTIVE_ALARMS];
-    uint8_t count = alarmManager.getActiveAlarms(activeAlarms, MAX_ACTIVE_ALARMS);
-    for (uint8_t i = 0; i < count; i++) {
-        if (activeAlarms[i] == AlarmType::PIT_HIGH ||
-            activeAlarms[i] == AlarmType::PIT_LOW)    flags |= DP_FLAG_ALARM_PIT;
-        if (activeAlarms[i] == AlarmType::MEAT1_DONE) flags |= DP_FLAG_ALARM_MEAT1;
-        if (activeAlarms[i] == AlarmType::MEAT2_DONE) flags |= DP_FLAG_ALARM_MEAT2;
-    }
-    return flags;
+static uint16_t cb_getAlarms() {
+    return telemetryAlarmMask(g_view);
 }
 
-// --- WebSocket command callbacks ---
-static void ws_onSetpoint(float sp) {
-    g_setpoint = sp;
+// --- WebSocket command callbacks (run on the async TCP task) ---
+static void ws_onSetpoint(uint8_t zone, float sp) {
+    ControlLock lock;
+    if (zone < g_zoneCount) g_zones[zone].setSetpoint(sp);
 }
 
 static void ws_onAlarm(const char* probe, float target) {
-    if (strcmp(probe, "meat1") == 0)      alarmManager.setMeat1Target(target);
-    else if (strcmp(probe, "meat2") == 0) alarmManager.setMeat2Target(target);
-    else if (strcmp(probe, "pitBand") == 0) alarmManager.setPitBand(target);
+    ControlLock lock;
+    if (strcmp(probe, "pitBand") == 0) {
+        alarmManager.setPitBand(target);
+        return;
+    }
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        if (strcmp(probe, kProbeChannels[PROBE_MEAT1 + m].key) == 0) alarmManager.setMeatTarget(m, target);
+    }
 }
 
 static void ws_onFanMode(const char* mode) {
-    configManager.setFanMode(mode);
-    ui_update_settings_state(configManager.isFahrenheit(), configManager.getFanMode());
+    {
+        ControlLock lock;
+        configManager.setFanMode(mode);
+    }
+    ui_update_settings_state(configManager.isFahrenheit(), configManager.getFanModeName());
+}
+
+static void ws_onAutoTune(bool start) {
+    ControlLock lock;
+    if (!start) {
+        pidController.cancelAutoTune();
+    } else if (tempManager.isConnected(PROBE_PIT)) {
+        pidController.startAutoTune(g_zones[0].getSetpoint());
+    }
+}
+
+// /api/calibrate, from the async TCP task. The calibrator is fed by the
+// control task, so every action runs under the control lock.
+static bool web_onCalibrate(const char* action, uint8_t probe, float ref,
+                            char* json, size_t jsonSize) {
+    ControlLock lock;
+    bool f = configManager.isFahrenheit();
+    bool ok = true;
+    if (strcmp(action, "start") == 0) {
+        const ProbeSettings& ps = configManager.getProbeSettings(probe);
+        ProbeConfig cur;
+        cur.a = ps.a;
+        cur.b = ps.b;
+        cur.c = ps.c;
+        cur.offset = ps.offset;
+        ok = probeCalibrator.start(probe, cur);
+    } else if (strcmp(action, "capture") == 0) {
+        ok = probeCalibrator.capture(f ? fahrenheitToCelsius(ref) : ref);
+    } else if (strcmp(action, "apply") == 0) {
+        ProbeConfig out;
+        uint8_t p = probeCalibrator.getProbe();
+        uint8_t points = probeCalibrator.getPointCount();
+        ok = probeCalibrator.solve(out);
+        if (ok) {
+            tempManager.setCoefficients(p, out.a, out.b, out.c);
+            tempManager.setOffset(p, 0.0f);
+            configManager.setProbeCoefficients(p, out.a, out.b, out.c);
+            configManager.setProbeOffset(p, 0.0f);
+            Serial.printf("[TEMP] %s calibrated from %u points: A=%.7e B=%.7e C=%.7e\n",
+                          kProbeChannels[p].label, (unsigned)points, out.a, out.b, out.c);
+        }
+    } else if (strcmp(action, "cancel") == 0) {
+        probeCalibrator.cancel();
+    } else if (strcmp(action, "status") != 0) {
+        snprintf(json, jsonSize, "{\"error\":\"Unknown action\"}");
+        return false;
+    }
+    probeCalibrator.writeStatus(json, jsonSize, f);
+    return ok;
 }
 
 static void ws_onSession(const char* action, const char* format) {
+    // The session and the graph belong to loop(); hand the request over
     if (strcmp(action, "new") == 0) {
-        cookSession.endSession();
-        cookSession.startSession();
-        g_cookStartTime = 0;
-        g_pitReached = false;
-        ui_graph_clear();
+        g_newSessionRequested = true;
+    }
+}
+
+// Overall done time = the later of the per-probe estimates (est 0 = none).
+// Control task only; everyone else reads the snapshot's estimate.
+static PredictorEstimate latestEstimate() {
+    PredictorEstimate e = tempPredictor.getEstimate(0);
+    bool stalled = e.stalled;
+    for (uint8_t i = 1; i < PREDICTOR_NUM_PROBES; i++) {
+        PredictorEstimate m = tempPredictor.getEstimate(i);
+        if (m.est > e.est) e = m;
+        stalled = stalled || m.stalled;
+    }
+    e.stalled = stalled;
+    return e;
+}
+
+// Journal control changes from the snapshot. Unchanged values are dropped by
+// the journal, so this runs on every new snapshot. Loop task only.
+static void logSessionEvents() {
+    cookSession.logEvent(SessionEventType::SETPOINT, (int16_t)(g_view.setpoint * 10.0f));
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        cookSession.logEvent(sessionMeatTargetEvent(m), (int16_t)(g_view.meatTarget[m] * 10.0f));
+    }
+    cookSession.logEvent(SessionEventType::FAN_MODE, sessionFanModeIndex(g_view.fanMode));
+    cookSession.logEvent(SessionEventType::LID, g_view.lidOpen ? 1 : 0);
+    for (uint8_t i = 0; i < g_view.zoneCount; i++) {
+        cookSession.logEvent(sessionZoneSetpointEvent(i + 1), (int16_t)(g_view.zones[i].setpoint * 10.0f));
+    }
+}
+
+// Alarm and error onsets for Pushover/webhook. Posting never blocks; the
+// notifier task does the network side.
+static NotifyTracker g_notifyTracker;
+
+static void postNotifications() {
+    static Notification batch[MAX_ACTIVE_ALARMS + MAX_ERRORS];
+    uint8_t n = notifyCollect(g_notifyTracker, g_view, configManager.isFahrenheit(),
+                              batch, MAX_ACTIVE_ALARMS + MAX_ERRORS);
+    for (uint8_t i = 0; i < n; i++) {
+        Serial.printf("[NOTIFY] %s: %s\n", batch[i].title, batch[i].message);
+        notifier.post(batch[i]);
     }
 }
 
@@ -111,26 +259,35 @@ static void ws_onSession(const char* action, const char* format) {
 static unsigned long g_lastDisplayMs = 0;
 static unsigned long g_lastGraphMs   = 0;
 
-// --- UI callbacks ---
+// --- UI callbacks (run inside ui_handler() on the loop task) ---
 static void ui_cb_setpoint(float sp) {
-    g_setpoint = sp;
+    ControlLock lock;
+    g_zones[0].setSetpoint(sp);
 }
 
 static void ui_cb_meat_target(uint8_t probe, float target) {
-    if (probe == 1) alarmManager.setMeat1Target(target);
-    if (probe == 2) alarmManager.setMeat2Target(target);
+    ControlLock lock;
+    if (probe >= PROBE_MEAT1) alarmManager.setMeatTarget(probe - PROBE_MEAT1, target);
 }
 
 static void ui_cb_alarm_ack() {
+    if (g_view.alarmCount > 0) {
+        cookSession.logEvent(SessionEventType::ALARM_ACK, (int16_t)g_view.alarms[0]);
+    }
+    ControlLock lock;
     alarmManager.acknowledge();
 }
 
 static void ui_cb_units(bool isFahrenheit) {
+    ControlLock lock;
     configManager.setUnits(isFahrenheit ? "F" : "C");
     tempManager.setUseFahrenheit(isFahrenheit);
+    tempPredictor.reset();  // History is in the old units
+    trendMonitor.reset();
 }
 
 static void ui_cb_fan_mode(const char* mode) {
+    ControlLock lock;
     configManager.setFanMode(mode);
 }
 
@@ -138,8 +295,15 @@ static void ui_cb_new_session() {
     cookSession.endSession();
     cookSession.startSession();
     g_cookStartTime = 0;
-    g_pitReached = false;
     ui_graph_clear();
+
+    ControlLock lock;
+    tempPredictor.reset();
+    trendMonitor.reset();
+    for (uint8_t z = 0; z < g_zoneCount; z++) {
+        g_zones[z].resetPitReached();
+        g_zones[z].pid().resetLidModel();
+    }
 }
 
 static void ui_cb_factory_reset() {
@@ -172,8 +336,10 @@ static void wiz_buzzer_test() {
 }
 
 static void wiz_complete() {
-    configManager.setSetupComplete(true);
-    configManager.save();
+    {
+        ControlLock lock;
+        configManager.setSetupComplete(true);
+    }
     Serial.println("[BOOT] Setup wizard complete");
 }
 
@@ -187,6 +353,302 @@ static void ui_cb_wifi_action(const char* action) {
     }
 }
 
+// ---------------------------------------------------------------------------
+// Control tick — sampling, prediction, PID, actuation, alarms, errors.
+// Runs in the control task with g_controlMutex held. Probe state is read
+// from TempManager once into the snapshot, and every later stage of the
+// tick works from that copy.
+// ---------------------------------------------------------------------------
+static TelemetrySnapshot g_publish;         // Built in place each tick
+static uint32_t          g_publishErrorRev = 0;
+
+static void checkpointControllerState(const TelemetrySnapshot& t) {
+    ControllerState& s = g_ctrlState;
+    if (s.sessionStart != g_stateSession || s.setpoint != t.setpoint
+        || s.zoneCount != t.zoneCount) {
+        g_stateChanged = true;
+    }
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        if (s.meatTarget[m] != t.meatTarget[m]) g_stateChanged = true;
+        s.meatTarget[m] = t.meatTarget[m];
+    }
+    for (uint8_t i = 0; i < t.zoneCount; i++) {
+        if (s.zones[i].setpoint != t.zones[i].setpoint) g_stateChanged = true;
+    }
+    s.sessionStart = g_stateSession;
+    s.setpoint     = t.setpoint;
+    s.pitReached   = t.pitReached ? 1 : 0;
+    s.fahrenheit   = configManager.isFahrenheit() ? 1 : 0;
+    s.pid          = pidController.snapshot();
+    s.zoneCount    = t.zoneCount;
+    for (uint8_t i = 0; i < t.zoneCount; i++) {
+        s.zones[i].setpoint   = t.zones[i].setpoint;
+        s.zones[i].pitReached = t.zones[i].pitReached ? 1 : 0;
+        s.zones[i].pid        = g_zones[i + 1].pid().snapshot();
+    }
+    controllerStateSeal(s);
+    g_rtcState = s;
+}
+
+// First phase flagged by the loop profiler, for the error list
+static const char* overrunPhaseName() {
+    uint32_t mask = loopProfilerOverruns();
+    for (uint8_t i = 0; i < (uint8_t)LoopPhase::COUNT; i++) {
+        if (mask & (1u << i)) return loopPhaseName((LoopPhase)i);
+    }
+    return nullptr;
+}
+
+static void controlTick(unsigned long now) {
+    TelemetrySnapshot& t = g_publish;
+    t.tickMs = (uint32_t)now;
+    PhaseLap lap;
+
+    // 1. Read temperatures from all probes (internally gated at TEMP_SAMPLE_INTERVAL_MS)
+    tempManager.update();
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        t.temp[i]      = tempManager.getTemp(i);
+        t.connected[i] = tempManager.isConnected(i);
+        t.status[i]    = tempManager.getStatus(i);
+    }
+    t.sampleUs = tempManager.getSampleUs(PROBE_PIT);
+    probeCalibrator.update((uint32_t)now, tempManager.getRawADC(probeCalibrator.getProbe()),
+                           tempManager.isConnected(probeCalibrator.getProbe()));
+
+    // Done-time prediction (internally gated at PREDICTOR_SAMPLE_INTERVAL)
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        t.meatTarget[m] = alarmManager.getMeatTarget(m);
+        tempPredictor.setTarget(m, t.meatTarget[m]);
+    }
+    tempPredictor.setPitTemp(t.temp[PROBE_PIT], t.connected[PROBE_PIT]);
+    tempPredictor.update(&t.temp[PROBE_MEAT1], &t.connected[PROBE_MEAT1]);
+    lap.end(LoopPhase::TEMP);
+
+    // 2. PID computation per zone (every pid.sampleMs, default PID_SAMPLE_MS)
+    FanMode fanMode = configManager.getFanMode();
+    telemetrySetFanMode(t, fanModeName(fanMode));
+    for (uint8_t z = 0; z < g_zoneCount; z++) {
+        ControlZone& zone = g_zones[z];
+        uint8_t probe = zone.getProbe();
+        zone.computeDue(now, t.temp[probe], t.connected[probe], fanMode);
+    }
+    t.setpoint   = g_zones[0].getSetpoint();
+    t.pitReached = g_zones[0].isPitReached();
+    t.pidOutput  = pidController.getOutput();
+    t.autoTuning = pidController.isAutoTuning();
+    t.lidOpen    = pidController.isLidOpen();
+
+    // A finished auto-tune has already been applied; loop() persists it
+    {
+        float kp, ki, kd;
+        if (pidController.takeAutoTuneResult(kp, ki, kd)) {
+            configManager.setPidTunings(kp, ki, kd);
+        }
+    }
+    lap.end(LoopPhase::PID);
+
+    // 3-4. Mode-aware fan + damper from each zone's PID output
+    //      (split-range coordination), then the fan's kick-start timing
+    //      and long-pulse cycling
+    for (uint8_t z = 0; z < g_zoneCount; z++) {
+        g_zones[z].actuate(fanMode, configManager.getFanOnThreshold());
+    }
+    t.fanPct    = fanController.getCurrentSpeedPct();
+    t.damperPct = servoController.getCurrentPositionPct();
+    t.zoneCount = g_zoneCount - 1;
+    for (uint8_t z = 1; z < g_zoneCount; z++) {
+        const ControlZone& zone = g_zones[z];
+        ZoneReading& r = t.zones[z - 1];
+        r.probe      = zone.getProbe();
+        r.setpoint   = zone.getSetpoint();
+        r.pidOutput  = zone.pid().getOutput();
+        r.fanPct     = zone.fan().getCurrentSpeedPct();
+        r.damperPct  = zone.servo().getCurrentPositionPct();
+        r.lidOpen    = zone.pid().isLidOpen();
+        r.pitReached = zone.isPitReached();
+    }
+    lap.end(LoopPhase::FAN);
+
+    // 5. Alarm manager
+    alarmManager.update(t.temp[PROBE_PIT],
+                        &t.temp[PROBE_MEAT1],
+                        t.setpoint,
+                        t.pitReached);
+    t.alarmCount = alarmManager.getActiveAlarms(t.alarms, MAX_ACTIVE_ALARMS);
+    lap.end(LoopPhase::ALARMS);
+
+    // 6. Trend warnings (internally gated at TREND_SAMPLE_MS), then the
+    //    error manager
+    {
+        TrendInput ti;
+        ti.pitTemp       = t.temp[PROBE_PIT];
+        ti.pitConnected  = t.connected[PROBE_PIT];
+        ti.outputPct     = t.pidOutput;
+        ti.setpoint      = t.setpoint;
+        ti.lidOpen       = t.lidOpen;
+        for (uint8_t m = 0; m < TREND_MEAT_PROBES; m++) {
+            ti.meatTemp[m]   = t.temp[PROBE_MEAT1 + m];
+            ti.meatTarget[m] = t.meatTarget[m];
+            ti.meatEtaSec[m] = tempPredictor.getSecondsToTarget(m);
+        }
+        trendMonitor.update((uint32_t)now, ti);
+    }
+    errorManager.setTrend(trendMonitor.status());
+    errorManager.setLoopOverrun(overrunPhaseName());
+    errorManager.setFanStalled(fanController.isStalled());
+    {
+        ProbeState probeStates[NUM_PROBES];
+        telemetryProbeStates(t, probeStates);
+        errorManager.update(probeStates);
+    }
+    t.fireOut = errorManager.isFireOut();
+
+    // The error list only changes on fault transitions; re-copy it then
+    if (errorManager.getRevision() != g_publishErrorRev) {
+        g_publishErrorRev = errorManager.getRevision();
+        t.errorCount = errorManager.getErrors(t.errors, MAX_ERRORS);
+    }
+
+    t.estimate = latestEstimate();
+    for (uint8_t m = 0; m < NUM_MEATS; m++) t.meatEst[m] = tempPredictor.getEstTime(m);
+    lap.end(LoopPhase::ERRORS);
+
+    // 7. Warm-restart checkpoint
+    if (now - g_lastStateMs >= CONTROL_STATE_RTC_MS) {
+        g_lastStateMs = now;
+        checkpointControllerState(t);
+    }
+
+    // 8. Publish for the UI/network side
+    g_telemetry.write(t);
+}
+
+static void controlTaskMain(void*) {
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        {
+            ControlLock lock;
+            MetricTimer timer(Metric::CONTROL_TICK);
+            controlTick(millis());
+        }
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_TICK_MS));
+    }
+}
+
+// Start the control task once the device enters normal operation. Until
+// then (splash, setup wizard) loop() drives the hardware directly.
+static void startControlTask() {
+    if (g_controlTask) return;
+    for (uint8_t z = 0; z < g_zoneCount; z++) g_zones[z].startClock(millis());
+    xTaskCreatePinnedToCore(controlTaskMain, "control", CONTROL_TASK_STACK, nullptr,
+                            CONTROL_TASK_PRIORITY, &g_controlTask, CONTROL_TASK_CORE);
+    Serial.printf("[BOOT] Control task started on core %d (loop on core %d)\n",
+                  CONTROL_TASK_CORE, xPortGetCoreID());
+}
+
+// ---------------------------------------------------------------------------
+// Warm restart
+// ---------------------------------------------------------------------------
+
+// Refill the predictor windows from the tail of the session log, so done-time
+// estimates come back straight away rather than after a fresh window.
+static void warmPredictor() {
+    uint32_t total = cookSession.getLevelCount(0);
+    uint32_t idx = total > PREDICTOR_WARM_POINTS ? total - PREDICTOR_WARM_POINTS : 0;
+    uint32_t fed = 0;
+    RollupPoint page[SESSION_READ_PAGE];
+
+    while (idx < total) {
+        uint32_t n = cookSession.readLevel(0, idx, page, SESSION_READ_PAGE);
+        if (n == 0) {
+            if (idx < cookSession.getFirstRamIndex()) {
+                idx = cookSession.getFirstRamIndex();
+                continue;
+            }
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            const RollupPoint& rp = page[i];
+            float pit = dpDisconnected(rp, PROBE_PIT) ? NAN : rp.tAvg[ROLLUP_PIT] / 10.0f;
+            for (uint8_t m = 0; m < PREDICTOR_NUM_PROBES; m++) {
+                uint8_t ch = PROBE_MEAT1 + m;
+                if (!dpDisconnected(rp, ch)) {
+                    tempPredictor.prefill(m, rp.timestamp, rp.tAvg[ch] / 10.0f, pit);
+                }
+            }
+        }
+        fed += n;
+        idx += n;
+    }
+    if (fed > 0) Serial.printf("[BOOT] Predictor warmed from %u points\n", fed);
+}
+
+// Resume the controller where it was if the recovered cook is the one the
+// newest checkpoint belongs to. Without a checkpoint (first boot of this
+// firmware, or it was lost) the setpoint and targets come from the event
+// journal and the PID starts cold. Runs before the control task starts.
+static void restoreControllerState() {
+    uint32_t session = cookSession.isActive() ? cookSession.getStartTime() : 0;
+    g_stateSession = session;
+    if (session == 0) return;
+
+    bool haveFlash = controllerStateLoad(g_flashState);
+    if (!haveFlash) memset(&g_flashState, 0, sizeof(g_flashState));
+    const ControllerState* s = controllerStatePick(&g_rtcState,
+                                                   haveFlash ? &g_flashState : nullptr,
+                                                   session, configManager.isFahrenheit());
+    if (s) {
+        g_zones[0].restoreSetpoint(s->setpoint, s->pitReached != 0);
+        for (uint8_t m = 0; m < NUM_MEATS; m++) alarmManager.setMeatTarget(m, s->meatTarget[m]);
+        pidController.restore(s->pid);
+        for (uint8_t i = 0; i < s->zoneCount && i + 1 < g_zoneCount; i++) {
+            g_zones[i + 1].restoreSetpoint(s->zones[i].setpoint, s->zones[i].pitReached != 0);
+            g_zones[i + 1].pid().restore(s->zones[i].pid);
+        }
+        g_ctrlState = *s;   // Keep counting seq up from the restored image
+        Serial.printf("[BOOT] Warm restart from %s: setpoint %.0f, output %.0f%%%s\n",
+                      s == &g_rtcState ? "RTC memory" : "flash",
+                      s->setpoint, pidController.getOutput(),
+                      pidController.isLidOpen() ? ", lid open" : "");
+    } else {
+        const SessionEventJournal& ev = cookSession.getEvents();
+        for (uint8_t z = 0; z < g_zoneCount; z++) {
+            int16_t sp = ev.latest(sessionZoneSetpointEvent(z));
+            if (sp != SESSION_EVENT_NONE) g_zones[z].restoreSetpoint(sp / 10.0f, false);
+        }
+        for (uint8_t m = 0; m < NUM_MEATS; m++) {
+            int16_t target = ev.latest(sessionMeatTargetEvent(m));
+            if (target != SESSION_EVENT_NONE) alarmManager.setMeatTarget(m, target / 10.0f);
+        }
+        Serial.printf("[BOOT] No controller checkpoint for this cook; setpoint %.0f from journal\n",
+                      g_zones[0].getSetpoint());
+    }
+    warmPredictor();
+}
+
+// Mirror the RTC checkpoint to flash every CONTROL_STATE_FLASH_MS, or at
+// the next checkpoint after the setpoint, a target or the cook changed. The
+// image is copied under the lock and written outside it. Loop task only.
+static void saveControllerState(unsigned long now) {
+    if (!g_stateChanged && now - g_lastStateSaveMs < CONTROL_STATE_FLASH_MS) return;
+    g_lastStateSaveMs = now;
+
+    static ControllerState image;
+    {
+        ControlLock lock;
+        image = g_ctrlState;
+        g_stateChanged = false;
+    }
+    // Not checkpointed yet, nothing new since the last mirror, or no cook to resume
+    if (!controllerStateValid(image) || image.seq == g_flashState.seq) return;
+    if (image.sessionStart == 0) return;
+    if (controllerStateSave(image)) {
+        g_flashState = image;
+    } else {
+        Serial.println("[PID] Failed to save controller state!");
+    }
+}
+
 // ---------------------------------------------------------------------------
 // setup()
 // ---------------------------------------------------------------------------
@@ -199,6 +661,7 @@ void setup() {
     Serial.println("========================================");
     Serial.printf("  Pit Claw v%s\n", FIRMWARE_VERSION);
     Serial.println("  Board: WT32-SC01 Plus (ESP32-S3)");
+    Serial.printf("  Profile: %s\n", kBuildProfile.name);
     Serial.println("========================================");
     Serial.println();
 
@@ -223,89 +686,191 @@ void setup() {
         tempManager.setOffset(i, ps.offset);
     }
     tempManager.setUseFahrenheit(configManager.isFahrenheit());
-
-    // 5. Initialize PID controller with saved tunings
-    pidController.begin(cfg.pid.kp, cfg.pid.ki, cfg.pid.kd);
-
-    // 6. Initialize fan PWM output
-    fanController.begin();
-
-    // 7. Initialize servo / damper output
-    servoController.begin();
+    tempPredictor.begin();
+    tempPredictor.setMode(PredictorMode::NEWTON);
+
+    // 5-7. Control zones: PID with the saved tunings, fan PWM and damper
+    //      servo. Zone 0 is the stock pit probe and outputs.
+    g_zoneCount = 1 + cfg.zoneCount;
+    for (uint8_t z = 0; z < g_zoneCount; z++) {
+        PidController& pid = g_zones[z].pid();
+        pid.setSampleMs(cfg.pid.sampleMs);
+        pid.setDerivativeFilter(cfg.pid.dFilterN);
+        pid.setFeedForward(cfg.pid.feedForward);
+        pid.setSchedule(cfg.pid.schedule);
+        pid.setFanMode(cfg.fan.mode);
+        pid.begin(cfg.pid.kp, cfg.pid.ki, cfg.pid.kd);
+        g_zones[z].servo().setSlewRate(cfg.damper.slewRate);
+    }
+    g_zones[0].begin(PROBE_PIT, PIN_FAN_PWM, FAN_PWM_CHANNEL, PIN_SERVO);
+    fanController.beginTach(PIN_SPARE, FAN_TACH_PCNT_UNIT, cfg.fan.tachPulses, cfg.fan.maxRpm);
+    for (uint8_t z = 1; z < g_zoneCount; z++) {
+        const ZoneSettings& zs = cfg.zones[z - 1];
+        g_zones[z].begin(zs.probe, zs.fanPin, zs.fanChannel, zs.servoPin);
+        Serial.printf("[BOOT] Zone %u on %s: fan pin %d (LEDC %u), servo pin %d\n",
+                      (unsigned)z, kProbeChannels[zs.probe].key, zs.fanPin,
+                      (unsigned)zs.fanChannel, zs.servoPin);
+    }
 
     // 8. Initialize alarm manager (buzzer)
     alarmManager.begin();
     alarmManager.setPitBand(cfg.alarms.pitBand);
 
-    // 9. Initialize error detection
+    // 9. Initialize error detection, and the MQTT publisher and notifier
+    //    that report telemetry, alarms and errors once Wi-Fi is up
     errorManager.begin();
+    mqttPublisher.begin(cfg.mqtt, &cookSession);
+    notifyTrackerReset(g_notifyTracker);
+    notifier.begin(cfg.alarms.pushover, cfg.alarms.webhook, &mqttPublisher);
 
-    // 10. Connect WiFi (splash screen visible during connection)
-    wifiManager.begin();
-
-    // 11. Start HTTP server and WebSocket, pass module references
-    webServer.begin();
-    webServer.setModules(&tempManager, &pidController, &fanController,
-                         &servoController, &configManager, &cookSession,
-                         &alarmManager, &errorManager);
-    webServer.onSetpoint(ws_onSetpoint);
-    webServer.onAlarm(ws_onAlarm);
-    webServer.onSession(ws_onSession);
-    webServer.onFanMode(ws_onFanMode);
-
-    // 12. Initialize OTA updates (needs the AsyncWebServer to register /update route)
-    otaManager.begin(webServer.getAsyncServer());
-
-    // 13. Recover any existing cook session from flash
+    // 10. Recover any existing cook session from flash, and the controller
+    //     state that goes with it
     cookSession.begin();
-    cookSession.setDataSources(cb_getPitTemp, cb_getMeat1Temp, cb_getMeat2Temp,
-                               cb_getFanPct, cb_getDamperPct, cb_getFlags);
-
-    // 14. Wire up dashboard callbacks and set initial state
+    cookSession.setDataSources(cb_getTemp, cb_isConnected,
+                               cb_getFanPct, cb_getDamperPct, cb_getFlags, cb_getAlarms);
+    restoreControllerState();
+
+    // Control can run now; a mid-cook power blip gets the fan back under
+    // PID before the splash, Wi-Fi and web server
+    g_controlMutex = xSemaphoreCreateMutex();
+    Serial.printf("[BOOT] Sensing and outputs ready at %lu ms\n", millis());
+#if BOOT_CONTROL_FIRST
+    if (configManager.isSetupComplete()) startControlTask();
+#endif
+
+    // 11. Wire up dashboard callbacks and set initial state
     ui_set_callbacks(ui_cb_setpoint, ui_cb_meat_target, ui_cb_alarm_ack);
     ui_set_settings_callbacks(ui_cb_units, ui_cb_fan_mode, ui_cb_new_session, ui_cb_factory_reset);
     ui_set_wifi_callback(ui_cb_wifi_action);
 
     // Set initial display state
-    ui_update_setpoint(g_setpoint);
-    ui_update_meat1_target(alarmManager.getMeat1Target());
-    ui_update_meat2_target(alarmManager.getMeat2Target());
-    ui_update_settings_state(configManager.isFahrenheit(), configManager.getFanMode());
+    ui_update_setpoint(g_zones[0].getSetpoint());
+    ui_update_meat1_target(alarmManager.getMeatTarget(0));
+    ui_update_meat2_target(alarmManager.getMeatTarget(1));
+    ui_update_settings_state(configManager.isFahrenheit(), configManager.getFanModeName());
 
-    // Pre-populate graph from recovered session data
+    Serial.printf("[BOOT] Setup complete at %lu ms; graph and network follow\n", millis());
+
+    for (uint8_t z = 0; z < g_zoneCount; z++) g_zones[z].startClock(millis());
+    g_lastDisplayMs = millis();
+    g_lastGraphMs = millis();
+}
+
+// ---------------------------------------------------------------------------
+// Deferred boot stages
+// ---------------------------------------------------------------------------
+
+// Rebuild the graph from recovered session data in one bulk load, from the
+// finest level of detail within GRAPH_REBUILD_MAX_POINTS (raw points for
+// up to 4 h, then the rollup tiers). GraphHistory buckets the points in
+// a single pass and the chart is synced once at the end. The setpoint line follows the event journal; points before its
+// first entry use the current setpoint.
+static void rebuildGraph() {
+    unsigned long startMs = millis();
+    float currentSp;
     {
-        uint32_t sessionPoints = cookSession.getTotalPointCount();
-        for (uint32_t i = 0; i < sessionPoints; i++) {
-            const DataPoint* dp = cookSession.getPoint(i);
-            if (dp) {
-                ui_graph_add_point(
-                    dp->pitTemp / 10.0f,
-                    dp->meat1Temp / 10.0f,
-                    dp->meat2Temp / 10.0f,
-                    g_setpoint,
-                    (dp->flags & DP_FLAG_PIT_DISC) != 0,
-                    (dp->flags & DP_FLAG_MEAT1_DISC) != 0,
-                    (dp->flags & DP_FLAG_MEAT2_DISC) != 0
-                );
+        ControlLock lock;
+        currentSp = g_zones[0].getSetpoint();
+    }
+
+    uint8_t level = cookSession.selectLevel(GRAPH_REBUILD_MAX_POINTS);
+    uint32_t total = cookSession.getLevelCount(level);
+    uint32_t idx = 0;
+    uint32_t added = 0;
+    RollupPoint page[SESSION_READ_PAGE];
+    SessionEventCursor events;
+    sessionEventsBegin(events);
+
+    ui_graph_begin_batch(total);
+    while (idx < total) {
+        uint32_t n = cookSession.readLevel(level, idx, page, SESSION_READ_PAGE);
+        if (n == 0) {
+            if (level == 0 && idx < cookSession.getFirstRamIndex()) {
+                idx = cookSession.getFirstRamIndex();
+                continue;
+            }
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            const RollupPoint* rp = &page[i];
+            sessionEventsSeek(cookSession.getEvents(), events, rp->timestamp);
+            int16_t sp = events.value[(uint8_t)SessionEventType::SETPOINT];
+            float temps[NUM_PROBES];
+            bool disc[NUM_PROBES];
+            for (uint8_t c = 0; c < NUM_PROBES; c++) {
+                temps[c] = rp->tAvg[c] / 10.0f;
+                disc[c] = dpDisconnected(*rp, c);
             }
+            ui_graph_add_point(temps, disc, sp != SESSION_EVENT_NONE ? sp / 10.0f : currentSp);
         }
+        added += n;
+        idx += n;
     }
+    ui_graph_end_batch();
 
-    // 15. Log "Setup complete" with IP address
-    Serial.println();
-    Serial.printf("[BOOT] Setup complete. IP: %s\n", wifiManager.getIPAddress());
-    Serial.println();
+    if (added > 0) {
+        Serial.printf("[BOOT] Graph rebuilt from %u points (level %u) in %lu ms\n",
+                      added, level, millis() - startMs);
+    }
+}
 
-    g_lastPidMs = millis();
-    g_lastDisplayMs = millis();
-    g_lastGraphMs = millis();
+// Run the next deferred boot stage. Wi-Fi only starts connecting here;
+// wifiManager.update() sees it through, so nothing waits on the network.
+static void runBootStage() {
+    switch (g_bootStage) {
+        case BootStage::GRAPH:
+            rebuildGraph();
+            g_bootStage = BootStage::WIFI;
+            break;
+
+        case BootStage::WIFI:
+            wifiManager.begin();
+            Serial.printf("[BOOT] Wi-Fi connecting at %lu ms\n", millis());
+            g_bootStage = BootStage::WEB;
+            break;
+
+        case BootStage::WEB:
+            // HTTP server and WebSocket, with module references
+            webServer.begin();
+            webServer.setModules(&cookSession, &g_telemetry);
+            webServer.onSetpoint(ws_onSetpoint);
+            webServer.onAlarm(ws_onAlarm);
+            webServer.onSession(ws_onSession);
+            webServer.onFanMode(ws_onFanMode);
+            webServer.onAutoTune(ws_onAutoTune);
+            webServer.onCalibrate(web_onCalibrate);
+
+            // OTA updates (needs the AsyncWebServer to register /update route)
+            otaManager.begin(webServer.getAsyncServer(), configManager.getOtaSettings());
+
+#if BBQ_FEATURE_HUB
+            // Hub mode: follow the other units and serve them at /api/hub
+            hubManager.begin(configManager.getHubSettings());
+            webServer.setHub(&hubManager);
+#endif
+
+            // The IP is logged by [WIFI] once the connection comes up
+            Serial.printf("[BOOT] Web server up at %lu ms\n", millis());
+            g_bootStage = BootStage::DONE;
+            break;
+
+        case BootStage::DONE:
+            break;
+    }
 }
 
 // ---------------------------------------------------------------------------
-// loop()  — target ~100 Hz (10 ms delay at end); modules gate their own timing
+// loop()  — UI/network task, target ~100 Hz (10 ms delay at end); modules
+// gate their own timing. Control runs separately once RUNNING.
 // ---------------------------------------------------------------------------
 void loop() {
     unsigned long now = millis();
+    {
+        static uint64_t lastUs = 0;
+        uint64_t nowUs = metricsNowUs();
+        if (lastUs != 0) metricObserve(Metric::LOOP_PERIOD, (uint32_t)(nowUs - lastUs));
+        lastUs = nowUs;
+    }
 
     // --- Boot splash phase: only process LVGL and splash logic ---
     if (g_bootPhase == BootPhase::SPLASH) {
@@ -328,6 +893,7 @@ void loop() {
                 ui_switch_screen(Screen::DASHBOARD);
                 g_bootPhase = BootPhase::RUNNING;
                 Serial.println("[BOOT] Entering normal operation");
+                startControlTask();
             }
         }
         ui_tick(10);
@@ -336,10 +902,17 @@ void loop() {
         return;
     }
 
+    // Graph, Wi-Fi and web server, one stage per pass
+    if (g_bootStage != BootStage::DONE) {
+        runBootStage();
+    }
+    bool wifiStarted = g_bootStage > BootStage::WIFI;
+
     // --- Setup wizard phase: process LVGL, temp readings, and WiFi ---
     if (g_bootPhase == BootPhase::WIZARD) {
         tempManager.update();
-        wifiManager.update();
+        if (wifiStarted) wifiManager.update();
+        servoController.update();   // Damper test slew and detach
 
         // Handle hardware test timeouts (non-blocking)
         if (g_hwTest != HwTest::NONE) {
@@ -354,7 +927,8 @@ void loop() {
                     }
                     break;
                 case HwTest::SERVO:
-                    if (elapsed >= 500) {
+                    // Open at the slew rate, then close again
+                    if (elapsed >= 500 && !servoController.isMoving()) {
                         servoController.setPosition(0);
                         g_hwTest = HwTest::NONE;
                     }
@@ -388,6 +962,7 @@ void loop() {
                 ui_switch_screen(Screen::DASHBOARD);
                 g_bootPhase = BootPhase::RUNNING;
                 Serial.println("[BOOT] Entering normal operation");
+                startControlTask();
             }
         }
         ui_tick(10);
@@ -397,100 +972,77 @@ void loop() {
     }
 
     // --- Normal running phase ---
-    // 1. Read temperatures from all probes (internally gated at TEMP_SAMPLE_INTERVAL_MS)
-    tempManager.update();
-
-    // 2. PID computation (every PID_SAMPLE_MS)
-    if (now - g_lastPidMs >= PID_SAMPLE_MS) {
-        g_lastPidMs = now;
-
-        // Reset integrator on setpoint change for bumpless transfer
-        if (g_setpoint != g_prevSetpoint) {
-            pidController.resetIntegrator();
-            g_pitReached = false;  // Suppress pit-band alarms during ramp to new setpoint
-            g_prevSetpoint = g_setpoint;
-        }
-
-        // Only compute PID when pit probe is connected. When disconnected,
-        // _pidOutput retains its last value to maintain current fire management.
-        if (tempManager.isConnected(PROBE_PIT)) {
-            float pitTemp = tempManager.getPitTemp();
-            pidController.compute(pitTemp, g_setpoint);
-
-            // Track whether pit has ever reached setpoint (within 5 degrees F).
-            if (!g_pitReached) {
-                if (fabsf(pitTemp - g_setpoint) <= 5.0f) {
-                    g_pitReached = true;
-                }
-            }
-        }
+    // Sampling, PID and actuation run in the control task (controlTick).
+    // This side handles UI, network and logging from the published snapshot.
+    if (g_telemetry.version() != g_viewVersion) {
+        g_viewVersion = g_telemetry.version();
+        g_view = g_telemetry.read();
+        logSessionEvents();
+        postNotifications();
     }
 
-    // 3. Mode-aware fan + damper from PID output (split-range coordination)
-    {
-        SplitRangeOutput sr = splitRange(pidController.getOutput(),
-                                         configManager.getFanMode(),
-                                         configManager.getFanOnThreshold());
-        servoController.setPosition(sr.damperPercent);
-        fanController.setSpeed(sr.fanPercent);
+    if (g_newSessionRequested) {
+        g_newSessionRequested = false;
+        ui_cb_new_session();
     }
 
-    // 4. Fan controller update (kick-start timing, long-pulse cycling)
-    fanController.update();
-
-    // 5. Alarm manager
-    alarmManager.update(tempManager.getPitTemp(),
-                        tempManager.getMeat1Temp(),
-                        tempManager.getMeat2Temp(),
-                        g_setpoint,
-                        g_pitReached);
-
-    // 6. Error manager
-    {
-        ProbeState probeStates[NUM_PROBES];
-        for (uint8_t i = 0; i < NUM_PROBES; i++) {
-            ProbeStatus st = tempManager.getStatus(i);
-            probeStates[i].connected    = tempManager.isConnected(i);
-            probeStates[i].openCircuit  = (st == ProbeStatus::OPEN_CIRCUIT);
-            probeStates[i].shortCircuit = (st == ProbeStatus::SHORT_CIRCUIT);
-            probeStates[i].temperature  = tempManager.getTemp(i);
+    // Persist config changes once they've settled. The copy is taken under
+    // the lock and written outside it, so the control task never waits on flash.
+    if (configManager.saveDue(now)) {
+        static AppConfig snapshot;
+        uint32_t seq;
+        {
+            ControlLock lock;
+            snapshot = configManager.getConfig();
+            seq = configManager.changeSeq();
         }
-        errorManager.update(tempManager.getPitTemp(),
-                            fanController.getCurrentSpeedPct(),
-                            probeStates);
+        configManager.saveSnapshot(snapshot, seq);
     }
 
     // 7. Cook session update (auto-samples and flushes on its own timers)
+    PhaseLap lap;
     cookSession.update();
-
-    // 8. Web server update (broadcasts to WebSocket clients at WS_SEND_INTERVAL)
-    webServer.setSetpoint(g_setpoint);
-    webServer.update();
-
-    // 9. WiFi manager (handles reconnection)
-    wifiManager.update();
+    g_stateSession = cookSession.isActive() ? cookSession.getStartTime() : 0;
+    saveControllerState(now);
+    lap.end(LoopPhase::SESSION);
+
+    // 8. Web server update (broadcasts to WebSocket clients at WS_SEND_INTERVAL).
+    // It reads the telemetry channel itself, so no lock is needed.
+    if (g_bootStage == BootStage::DONE) webServer.update();
+    lap.end(LoopPhase::WEB);
+
+    // 9. WiFi manager (handles reconnection), then MQTT telemetry, which
+    //    batches and backfills on its own timers
+    if (wifiStarted) {
+        wifiManager.update();
+        if (mqttPublisher.sampleDue(now)) {
+            mqttPublisher.addSample(webServer.buildDataPayload(g_view), now);
+        }
+        mqttPublisher.update(now, wifiManager.isConnected());
+    }
+    lap.end(LoopPhase::WIFI);
 
     // 10. OTA manager (handles OTA progress)
-    otaManager.update();
+    if (g_bootStage == BootStage::DONE) otaManager.update();
+    lap.end(LoopPhase::OTA);
 
     // 11. LVGL display update (~1 Hz for data, ~5s for graph)
     if (now - g_lastDisplayMs >= 1000) {
         g_lastDisplayMs = now;
 
-        ui_update_temps(tempManager.getPitTemp(),
-                        tempManager.getMeat1Temp(),
-                        tempManager.getMeat2Temp(),
-                        tempManager.isConnected(PROBE_PIT),
-                        tempManager.isConnected(PROBE_MEAT1),
-                        tempManager.isConnected(PROBE_MEAT2));
+        ui_update_temps(g_view.temp[PROBE_PIT],
+                        g_view.temp[PROBE_MEAT1],
+                        g_view.temp[PROBE_MEAT2],
+                        g_view.connected[PROBE_PIT],
+                        g_view.connected[PROBE_MEAT1],
+                        g_view.connected[PROBE_MEAT2]);
 
-        ui_update_setpoint(g_setpoint);
-        ui_update_output_bars(fanController.getCurrentSpeedPct(),
-                              servoController.getCurrentPositionPct());
+        ui_update_setpoint(g_view.setpoint);
+        ui_update_output_bars(g_view.fanPct, g_view.damperPct);
 
         // Cook timer — starts when first meat probe connects
         if (g_cookStartTime == 0) {
-            if (tempManager.isConnected(PROBE_MEAT1) || tempManager.isConnected(PROBE_MEAT2)) {
+            if (g_view.connected[PROBE_MEAT1] || g_view.connected[PROBE_MEAT2]) {
                 g_cookStartTime = (uint32_t)(millis() / 1000);
             }
         }
@@ -498,8 +1050,10 @@ void loop() {
             uint32_t elapsed = g_cookStartTime > 0
                 ? (uint32_t)(millis() / 1000) - g_cookStartTime
                 : 0;
-            ui_update_cook_timer(0, elapsed, 0);
+            ui_update_cook_timer(0, elapsed, g_view.estimate.est);
         }
+        ui_update_meat1_estimate(g_view.meatEst[0]);
+        ui_update_meat2_estimate(g_view.meatEst[1]);
 
         // WiFi status
         ui_update_wifi(wifiManager.isConnected() || wifiManager.isAPMode());
@@ -519,39 +1073,34 @@ void loop() {
         }
 
         // Alerts
-        AlarmType activeAlarms[MAX_ACTIVE_ALARMS];
-        uint8_t alarmCount = alarmManager.getActiveAlarms(activeAlarms, MAX_ACTIVE_ALARMS);
-        uint8_t topAlarm = 0;
-        for (uint8_t i = 0; i < alarmCount; i++) {
-            topAlarm = (uint8_t)activeAlarms[i];
-            break; // Take the first active alarm
-        }
+        uint8_t topAlarm = g_view.alarmCount > 0 ? (uint8_t)g_view.alarms[0] : 0;  // First active alarm
         uint8_t probeErrors = 0;
-        if (tempManager.getStatus(PROBE_PIT) != ProbeStatus::OK)   probeErrors |= 0x01;
-        if (tempManager.getStatus(PROBE_MEAT1) != ProbeStatus::OK) probeErrors |= 0x02;
-        if (tempManager.getStatus(PROBE_MEAT2) != ProbeStatus::OK) probeErrors |= 0x04;
-        ui_update_alerts(topAlarm, pidController.isLidOpen(), errorManager.isFireOut(), probeErrors);
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            if (g_view.status[c] != ProbeStatus::OK) probeErrors |= (uint8_t)(1u << c);
+        }
+        ui_update_alerts(topAlarm, g_view.lidOpen, g_view.fireOut, probeErrors);
 
         // Meat targets
-        ui_update_meat1_target(alarmManager.getMeat1Target());
-        ui_update_meat2_target(alarmManager.getMeat2Target());
+        ui_update_meat1_target(g_view.meatTarget[0]);
+        ui_update_meat2_target(g_view.meatTarget[1]);
     }
 
     // Graph update (every 5 seconds)
     if (now - g_lastGraphMs >= 5000) {
         g_lastGraphMs = now;
-        ui_graph_add_point(tempManager.getPitTemp(),
-                           tempManager.getMeat1Temp(),
-                           tempManager.getMeat2Temp(),
-                           g_setpoint,
-                           !tempManager.isConnected(PROBE_PIT),
-                           !tempManager.isConnected(PROBE_MEAT1),
-                           !tempManager.isConnected(PROBE_MEAT2));
+        bool disc[NUM_PROBES];
+        for (uint8_t c = 0; c < NUM_PROBES; c++) disc[c] = !g_view.connected[c];
+        ui_graph_add_point(g_view.temp, disc, g_view.setpoint);
     }
+    lap.end(LoopPhase::DISPLAY);
 
     // 12. LVGL tick and task handler
     ui_tick(10);
-    ui_handler();
+    {
+        MetricTimer timer(Metric::UI_HANDLER);
+        ui_handler();
+    }
+    lap.end(LoopPhase::LVGL);
 
     // Yield to FreeRTOS / keep loop at ~100 Hz
     delay(10);
@@ -0,0 +1,156 @@
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#ifndef NATIVE_BUILD
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+const uint32_t kMetricBoundsUs[METRIC_BUCKETS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000, 2500000
+};
+
+namespace {
+
+// Relaxed atomics, not a Seqlock: several metrics are written on loop()
+// and scraped on async_tcp, which preempts it on the same core, so a
+// scrape must never wait on a write. A scrape can miss a sample in flight
+// (buckets and sum a sample apart), which Prometheus tolerates; the count
+// is summed from the buckets so +Inf always matches them. The 64-bit sum
+// isn't lock-free on Xtensa; libatomic wraps it in a critical section of
+// a few instructions, which nothing can preempt.
+struct Histogram {
+    std::atomic<uint32_t> buckets[METRIC_BUCKETS + 1];
+    std::atomic<uint64_t> sumUs;
+};
+
+Histogram g_hist[(uint8_t)Metric::COUNT];
+std::atomic<uint32_t> g_counters[(uint8_t)Counter::COUNT];
+
+struct MetricInfo {
+    const char* name;
+    const char* help;
+};
+
+const MetricInfo kHistInfo[(uint8_t)Metric::COUNT] = {
+    { "pitclaw_loop_period_seconds",     "Time between loop() passes" },
+    { "pitclaw_control_tick_seconds",    "Duration of a control task tick" },
+    { "pitclaw_temp_update_seconds",     "Duration of TempManager::update()" },
+    { "pitclaw_adc_conversion_seconds",  "ADS1115 conversion latency, start to result" },
+    { "pitclaw_pid_compute_seconds",     "Duration of PidController::compute()" },
+    { "pitclaw_ui_handler_seconds",      "Duration of ui_handler() (LVGL)" },
+    { "pitclaw_web_update_seconds",      "Duration of BBQWebServer::update()" },
+    { "pitclaw_session_flush_seconds",   "Duration of a cook session flush to flash" },
+    { "pitclaw_sample_to_send_seconds",  "Age of the pit reading when its data frame is queued" },
+    { "pitclaw_sample_to_paint_seconds", "Age of the pit reading when the web UI paints it" },
+};
+
+const MetricInfo kCounterInfo[(uint8_t)Counter::COUNT] = {
+    { "pitclaw_session_flush_bytes_total", "Bytes written to flash by session flushes" },
+};
+
+void emit(MetricsOut out, void* ctx, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+void emit(MetricsOut out, void* ctx, const char* fmt, ...) {
+    char line[192];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (n <= 0) return;
+    if ((size_t)n >= sizeof(line)) n = sizeof(line) - 1;
+    out(line, (size_t)n, ctx);
+}
+
+} // namespace
+
+uint64_t metricsNowUs() {
+#ifndef NATIVE_BUILD
+    return (uint64_t)esp_timer_get_time();
+#else
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void metricObserve(Metric m, uint32_t us) {
+    uint8_t b = 0;
+    while (b < METRIC_BUCKETS && us > kMetricBoundsUs[b]) b++;
+
+    // Single writer per metric, so load and store rather than read-modify-write
+    Histogram& h = g_hist[(uint8_t)m];
+    h.buckets[b].store(h.buckets[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    h.sumUs.store(h.sumUs.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+}
+
+MetricSnapshot metricRead(Metric m) {
+    const Histogram& h = g_hist[(uint8_t)m];
+    MetricSnapshot out;
+    out.count = 0;
+    for (uint8_t b = 0; b <= METRIC_BUCKETS; b++) {
+        out.buckets[b] = h.buckets[b].load(std::memory_order_relaxed);
+        out.count += out.buckets[b];
+    }
+    out.sumUs = h.sumUs.load(std::memory_order_relaxed);
+    return out;
+}
+
+void counterAdd(Counter c, uint32_t n) {
+    g_counters[(uint8_t)c].fetch_add(n, std::memory_order_relaxed);
+}
+
+uint32_t counterRead(Counter c) {
+    return g_counters[(uint8_t)c].load(std::memory_order_relaxed);
+}
+
+void metricsReset() {
+    for (uint8_t i = 0; i < (uint8_t)Metric::COUNT; i++) {
+        for (std::atomic<uint32_t>& b : g_hist[i].buckets) b.store(0, std::memory_order_relaxed);
+        g_hist[i].sumUs.store(0, std::memory_order_relaxed);
+    }
+    for (uint8_t i = 0; i < (uint8_t)Counter::COUNT; i++) {
+        g_counters[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void metricsWrite(MetricsOut out, void* ctx) {
+    for (uint8_t i = 0; i < (uint8_t)Metric::COUNT; i++) {
+        const MetricInfo& info = kHistInfo[i];
+        MetricSnapshot s = metricRead((Metric)i);
+        emit(out, ctx, "# HELP %s %s\n# TYPE %s histogram\n", info.name, info.help, info.name);
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b < METRIC_BUCKETS; b++) {
+            cumulative += s.buckets[b];
+            emit(out, ctx, "%s_bucket{le=\"%g\"} %u\n", info.name,
+                 kMetricBoundsUs[b] / 1e6, (unsigned)cumulative);
+        }
+        emit(out, ctx, "%s_bucket{le=\"+Inf\"} %u\n", info.name, (unsigned)s.count);
+        emit(out, ctx, "%s_sum %.6f\n%s_count %u\n", info.name, s.sumUs / 1e6,
+             info.name, (unsigned)s.count);
+    }
+    for (uint8_t i = 0; i < (uint8_t)Counter::COUNT; i++) {
+        const MetricInfo& info = kCounterInfo[i];
+        emit(out, ctx, "# HELP %s %s\n# TYPE %s counter\n", info.name, info.help, info.name);
+        emit(out, ctx, "%s %u\n", info.name, (unsigned)counterRead((Counter)i));
+    }
+}
+
+static void sample(MetricsOut out, void* ctx, const char* type, const char* name,
+                   const char* help, double value, const char* labels) {
+    if (help) emit(out, ctx, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    if (labels) emit(out, ctx, "%s{%s} %.10g\n", name, labels, value);
+    else        emit(out, ctx, "%s %.10g\n", name, value);
+}
+
+void metricsGauge(MetricsOut out, void* ctx, const char* name, const char* help,
+                  double value, const char* labels) {
+    sample(out, ctx, "gauge", name, help, value, labels);
+}
+
+void metricsCounter(MetricsOut out, void* ctx, const char* name, const char* help,
+                    double value, const char* labels) {
+    sample(out, ctx, "counter", name, help, value, labels);
+}
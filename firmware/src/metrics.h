@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+// Hot-path latency histograms and counters, exposed as Prometheus text by
+// GET /metrics.
+//
+// Every metric has a single writer. Latencies are recorded by the module that owns
+// them, on the control task or loop(); latencies reported by web clients
+// come in on the WebSocket task. Recording is a scan over
+// METRIC_BUCKETS bounds plus a few stores, with no allocation. The /metrics
+// handler reads the relaxed atomic buckets without waiting on a writer, so
+// a scrape can run one sample behind. Buckets are fixed, so scrapes from
+// different firmware versions can be compared directly.
+//
+// Pure C++ apart from the clock, so it's testable on native.
+
+enum class Metric : uint8_t {
+    LOOP_PERIOD,      // loop() entry to entry
+    CONTROL_TICK,     // controlTick() under the lock
+    TEMP_UPDATE,      // TempManager::update()
+    ADC_CONVERSION,   // ADS1115 conversion start to result
+    PID_COMPUTE,      // PidController::compute()
+    UI_HANDLER,       // ui_handler() (LVGL timers and redraw)
+    WEB_UPDATE,       // BBQWebServer::update()
+    SESSION_FLUSH,    // CookSession::flush()
+    SAMPLE_TO_SEND,   // Pit reading's ADC conversion to its data frame being queued
+    SAMPLE_TO_PAINT,  // Same reading to the web UI painting it, as clients report it
+    COUNT
+};
+
+enum class Counter : uint8_t {
+    SESSION_FLUSH_BYTES,  // Bytes written by session flushes
+    COUNT
+};
+
+#define METRIC_BUCKETS 13   // Finite bounds; one more bucket counts the rest
+
+// Upper bounds of the buckets in microseconds, 100 us to 2.5 s
+extern const uint32_t kMetricBoundsUs[METRIC_BUCKETS];
+
+struct MetricSnapshot {
+    uint32_t buckets[METRIC_BUCKETS + 1];   // Per bucket, not cumulative; last is +Inf
+    uint32_t count;
+    uint64_t sumUs;
+};
+
+// Monotonic microseconds (esp_timer on the device)
+uint64_t metricsNowUs();
+
+void metricObserve(Metric m, uint32_t us);
+MetricSnapshot metricRead(Metric m);
+
+void     counterAdd(Counter c, uint32_t n);
+uint32_t counterRead(Counter c);
+
+// Clear everything (tests, and nothing else)
+void metricsReset();
+
+// Records the time from construction to destruction
+class MetricTimer {
+public:
+    explicit MetricTimer(Metric m) : _metric(m), _start(metricsNowUs()) {}
+    ~MetricTimer() { metricObserve(_metric, (uint32_t)(metricsNowUs() - _start)); }
+private:
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+    Metric   _metric;
+    uint64_t _start;
+};
+
+// Output sink for the text format, e.g. an HTTP response stream
+typedef void (*MetricsOut)(const char* text, size_t len, void* ctx);
+
+// Write every histogram and counter in the Prometheus text format
+void metricsWrite(MetricsOut out, void* ctx);
+
+// Write one gauge. labels is the inside of {...}, or null. The HELP and
+// TYPE lines are skipped when help is null, so a labelled series can follow
+// its first sample.
+void metricsGauge(MetricsOut out, void* ctx, const char* name, const char* help,
+                  double value, const char* labels = nullptr);
+
+// Same for a counter kept elsewhere (e.g. the protocol builder totals)
+void metricsCounter(MetricsOut out, void* ctx, const char* name, const char* help,
+                    double value, const char* labels = nullptr);
@@ -0,0 +1,179 @@
+#include "mqtt_batch.h"
+
+// ---------------------------------------------------------------------------
+// MqttBatcher
+// ---------------------------------------------------------------------------
+
+MqttBatcher::MqttBatcher() {
+    reset();
+}
+
+void MqttBatcher::reset() {
+    _buf[0] = BIN_FRAME_BATCH;
+    _buf[1] = 0;
+    _len = 2;
+    _count = 0;
+    _firstTs = 0;
+    _lastTs = 0;
+    bbq_protocol::resetBinaryState(_state);
+}
+
+bool MqttBatcher::full() const {
+    return _count >= MQTT_BATCH_MAX || MQTT_BATCH_BYTES - _len < 2 + BIN_MAX_FRAME;
+}
+
+bool MqttBatcher::add(const bbq_protocol::DataPayload& d) {
+    if (full()) return false;
+
+    // The first frame after reset() is a keyframe (the state is invalid)
+    size_t n = bbq_protocol::buildBinaryDelta(_buf + _len + 2, MQTT_BATCH_BYTES - _len - 2,
+                                              d, _state, false);
+    if (n == 0) return false;
+    _buf[_len]     = (uint8_t)(n & 0xFF);
+    _buf[_len + 1] = (uint8_t)(n >> 8);
+    _len += 2 + n;
+
+    if (_count == 0) _firstTs = d.ts;
+    _lastTs = d.ts;
+    _buf[1] = ++_count;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// MqttFlow
+// ---------------------------------------------------------------------------
+
+MqttFlow::MqttFlow()
+    : _qos(0)
+    , _up(false)
+    , _retryAtMs(0)
+    , _inflightId(0)
+    , _inflightKind(Kind::LIVE)
+    , _inflightLastTs(0)
+    , _inflightMs(0)
+    , _deliveredTs(0)
+    , _gap(false)
+    , _gapFromTs(0)
+    , _gapToTs(0)
+    , _gapsOpened(0)
+{
+}
+
+void MqttFlow::begin(uint8_t qos) {
+    _qos = qos > 0 ? 1 : 0;
+}
+
+void MqttFlow::openGap() {
+    if (!_gap) {
+        _gap = true;
+        _gapFromTs = _deliveredTs;
+        _gapsOpened++;
+    }
+    // Where live data resumes is only known at the next live publish
+    _gapToTs = 0;
+}
+
+void MqttFlow::linkUp() {
+    _up = true;
+    _retryAtMs = 0;
+}
+
+void MqttFlow::linkDown() {
+    _up = false;
+    if (_inflightId != 0) {
+        if (_inflightKind == Kind::LIVE) openGap();
+        _inflightId = 0;
+    }
+    if (!_live.empty()) {
+        openGap();
+        _live.reset();
+    }
+}
+
+void MqttFlow::addSample(const bbq_protocol::DataPayload& d) {
+    if (!_up) {
+        openGap();  // The session log has it
+        return;
+    }
+    if (_live.full()) {
+        // Fallen a whole batch behind: stop holding samples in RAM and
+        // let the replay catch up from the session log instead
+        openGap();
+        _live.reset();
+    }
+    _live.add(d);
+}
+
+bool MqttFlow::liveReady(uint32_t nowMs) const {
+    return _up && _inflightId == 0 && !_live.empty()
+        && (int32_t)(nowMs - _retryAtMs) >= 0;
+}
+
+void MqttFlow::livePublished(uint16_t packetId, uint32_t nowMs) {
+    if (packetId == 0) {
+        _retryAtMs = nowMs + MQTT_RETRY_MS;   // Keep the batch; it grows meanwhile
+        return;
+    }
+    if (_gap && _gapToTs == 0) _gapToTs = _live.firstTs();
+
+    if (_qos == 0) {
+        _deliveredTs = _live.lastTs();
+    } else {
+        _inflightId = packetId;
+        _inflightKind = Kind::LIVE;
+        _inflightLastTs = _live.lastTs();
+        _inflightMs = nowMs;
+    }
+    _live.reset();
+}
+
+bool MqttFlow::backfillDue(uint32_t nowMs, uint32_t& fromTs, uint32_t& toTs) const {
+    if (!_up || !_gap || _gapToTs == 0 || _inflightId != 0 || !_live.empty()) return false;
+    if ((int32_t)(nowMs - _retryAtMs) < 0) return false;
+
+    fromTs = _gapFromTs;
+    if (_gapToTs > MQTT_BACKFILL_MAX_S && fromTs < _gapToTs - MQTT_BACKFILL_MAX_S) {
+        fromTs = _gapToTs - MQTT_BACKFILL_MAX_S;
+    }
+    toTs = _gapToTs;
+    return true;
+}
+
+void MqttFlow::historyPublished(uint16_t packetId, uint32_t lastTs, uint32_t nowMs) {
+    if (packetId == 0) {
+        _retryAtMs = nowMs + MQTT_RETRY_MS;
+        return;
+    }
+    if (_qos == 0) {
+        _gapFromTs = lastTs;
+    } else {
+        _inflightId = packetId;
+        _inflightKind = Kind::HISTORY;
+        _inflightLastTs = lastTs;
+        _inflightMs = nowMs;
+    }
+}
+
+void MqttFlow::backfillDone() {
+    _gap = false;
+    _gapFromTs = 0;
+    _gapToTs = 0;
+}
+
+void MqttFlow::acked(uint16_t packetId) {
+    if (packetId == 0 || packetId != _inflightId) return;
+    if (_inflightKind == Kind::LIVE) {
+        _deliveredTs = _inflightLastTs;
+    } else if (_gap) {
+        _gapFromTs = _inflightLastTs;
+    }
+    _inflightId = 0;
+}
+
+void MqttFlow::tick(uint32_t nowMs) {
+    if (_inflightId == 0 || nowMs - _inflightMs < MQTT_ACK_TIMEOUT_MS) return;
+    // A lost live batch joins the gap; a lost history batch is simply
+    // replayed again from the same place
+    if (_inflightKind == Kind::LIVE) openGap();
+    _inflightId = 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "config.h"
+#include "web_protocol.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Batching and delivery tracking for the MQTT telemetry publisher.
+//
+// Each publish on <base>/<id>/telemetry (and .../history for backfill) is
+// a batch frame of the WebSocket binary delta frames (web_protocol.h):
+//
+//   u8  BIN_FRAME_BATCH
+//   u8  sample count
+//   per sample: u16 length, then one BIN_FRAME_DATA frame
+//
+// The first sample is a keyframe and the rest are deltas against the one
+// before, so every publish decodes on its own whatever was lost before it.
+//
+// MqttFlow decides what goes out. While the link keeps up each sample is
+// published alone; while a QoS 1 publish waits for its PUBACK (or the
+// client refuses one) samples accumulate, up to MQTT_BATCH_MAX. Nothing is
+// buffered in RAM beyond that: an outage, a lost publish or a full batch
+// opens a gap after the last delivered sample, and once live publishing
+// resumes the gap is replayed from the session log on the history topic.
+// Delivery is at least once: a replay can repeat samples, so consumers
+// should key on the timestamp.
+//
+// Pure C++ — the MQTT client itself is MqttPublisher's. Fully testable on
+// native.
+
+#define BIN_FRAME_BATCH  0x02
+
+class MqttBatcher {
+public:
+    MqttBatcher();
+
+    void reset();
+
+    // Append one sample. False (and nothing appended) if the batch is full.
+    bool add(const bbq_protocol::DataPayload& d);
+
+    bool full() const;
+    bool empty() const { return _count == 0; }
+    uint8_t count() const { return _count; }
+
+    const uint8_t* data() const { return _buf; }
+    size_t size() const { return _len; }
+
+    uint32_t firstTs() const { return _firstTs; }
+    uint32_t lastTs() const { return _lastTs; }
+
+private:
+    uint8_t  _buf[MQTT_BATCH_BYTES];
+    size_t   _len;
+    uint8_t  _count;
+    uint32_t _firstTs;
+    uint32_t _lastTs;
+    bbq_protocol::BinaryDeltaState _state;
+};
+
+class MqttFlow {
+public:
+    MqttFlow();
+
+    // QoS for telemetry: 0 = delivered once the client takes it, 1 = on PUBACK
+    void begin(uint8_t qos);
+
+    void linkUp();
+    void linkDown();
+    bool isUp() const { return _up; }
+
+    // A sampled payload. Dropped into the gap while the link is down.
+    void addSample(const bbq_protocol::DataPayload& d);
+
+    // The live batch is due: link up, nothing in flight, samples waiting
+    bool liveReady(uint32_t nowMs) const;
+    const MqttBatcher& live() const { return _live; }
+
+    // Result of publishing live(): the packet id, or 0 if the client refused it
+    void livePublished(uint16_t packetId, uint32_t nowMs);
+
+    // A gap wants replaying: session points with fromTs < ts < toTs.
+    // Only once the live batch is out and nothing is in flight.
+    bool backfillDue(uint32_t nowMs, uint32_t& fromTs, uint32_t& toTs) const;
+
+    // Result of publishing a history batch ending at lastTs
+    void historyPublished(uint16_t packetId, uint32_t lastTs, uint32_t nowMs);
+
+    // The session had nothing left in the gap
+    void backfillDone();
+
+    void acked(uint16_t packetId);
+
+    // Expire a publish whose PUBACK never came. Call every update.
+    void tick(uint32_t nowMs);
+
+    uint16_t inflightId() const    { return _inflightId; }
+    bool     gapOpen() const       { return _gap; }
+    uint32_t deliveredTs() const   { return _deliveredTs; }
+    uint32_t gapsOpened() const    { return _gapsOpened; }
+
+private:
+    enum class Kind : uint8_t { LIVE, HISTORY };
+
+    void openGap();
+
+    uint8_t     _qos;
+    bool        _up;
+    MqttBatcher _live;
+    uint32_t    _retryAtMs;         // Client refused a publish; not before this
+
+    uint16_t    _inflightId;        // 0 = none
+    Kind        _inflightKind;
+    uint32_t    _inflightLastTs;
+    uint32_t    _inflightMs;
+
+    uint32_t    _deliveredTs;       // Newest live sample known delivered
+    bool        _gap;
+    uint32_t    _gapFromTs;         // Replay points after this...
+    uint32_t    _gapToTs;           // ...and before this (0 = live not resumed yet)
+    uint32_t    _gapsOpened;
+};
@@ -0,0 +1,214 @@
+#include "mqtt_publisher.h"
+
+#include <math.h>
+#include <string.h>
+
+MqttPublisher::MqttPublisher()
+    : _session(nullptr)
+    , _enabled(false)
+    , _lastSampleMs(0)
+    , _lastConnectMs(0)
+    , _connected(false)
+    , _trackedId(0)
+    , _ackedId(0)
+    , _eventReady(false)
+    , _eventLen(0)
+{
+    memset(&_settings, 0, sizeof(_settings));
+    _deviceId[0] = '\0';
+}
+
+void MqttPublisher::begin(const MqttSettings& settings, const CookSession* session) {
+    _settings = settings;
+    _session = session;
+    _enabled = _settings.enabled && _settings.host[0] != '\0';
+    _flow.begin(_settings.qos);
+    if (!_enabled) return;
+
+#ifndef NATIVE_BUILD
+    // Stable per unit: hostname plus the low half of the MAC
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(_deviceId, sizeof(_deviceId), "%s-%06lx", WIFI_HOSTNAME,
+             (unsigned long)((mac >> 24) & 0xFFFFFF));
+    const char* base = _settings.baseTopic[0] ? _settings.baseTopic : MQTT_BASE_TOPIC_DEFAULT;
+    snprintf(_topicTelemetry, sizeof(_topicTelemetry), "%s/%s/telemetry", base, _deviceId);
+    snprintf(_topicHistory, sizeof(_topicHistory), "%s/%s/history", base, _deviceId);
+    snprintf(_topicStatus, sizeof(_topicStatus), "%s/%s/status", base, _deviceId);
+    snprintf(_topicEvent, sizeof(_topicEvent), "%s/%s/event", base, _deviceId);
+
+    // The client keeps these pointers; they live in _settings and the topics
+    _client.setServer(_settings.host, _settings.port);
+    _client.setClientId(_deviceId);
+    if (_settings.user[0]) _client.setCredentials(_settings.user, _settings.password);
+    _client.setKeepAlive(MQTT_KEEPALIVE_S);
+    _client.setWill(_topicStatus, 1, true, "{\"online\":false}");
+
+    // AsyncTCP task: hand over, don't act
+    _client.onConnect([this](bool) { _connected.store(true); });
+    _client.onDisconnect([this](AsyncMqttClientDisconnectReason) { _connected.store(false); });
+    _client.onPublish([this](uint16_t packetId) {
+        if (packetId == _trackedId.load()) _ackedId.store(packetId);
+    });
+
+    Serial.printf("[MQTT] Publishing to %s:%u as %s (QoS %u, every %lu ms)\n",
+                  _settings.host, _settings.port, _deviceId, _settings.qos,
+                  (unsigned long)_settings.intervalMs);
+#endif
+}
+
+bool MqttPublisher::sampleDue(uint32_t nowMs) const {
+    return _enabled && nowMs - _lastSampleMs >= _settings.intervalMs;
+}
+
+void MqttPublisher::addSample(const bbq_protocol::DataPayload& d, uint32_t nowMs) {
+    _lastSampleMs = nowMs;
+    _flow.addSample(d);
+}
+
+bool MqttPublisher::postEvent(const char* json, size_t len) {
+    if (!_enabled || !_connected.load() || _eventReady.load()) return false;
+    if (len >= sizeof(_event)) return false;
+    memcpy(_event, json, len);
+    _event[len] = '\0';
+    _eventLen = len;
+    _eventReady.store(true);
+    return true;
+}
+
+#ifndef NATIVE_BUILD
+
+void MqttPublisher::update(uint32_t nowMs, bool wifiUp) {
+    if (!_enabled) return;
+
+    bool up = _connected.load();
+    if (up != _flow.isUp()) {
+        if (up) {
+            _flow.linkUp();
+            publishStatus();
+            Serial.printf("[MQTT] Connected to %s%s\n", _settings.host,
+                          _flow.gapOpen() ? ", backfilling the gap" : "");
+        } else {
+            _flow.linkDown();
+            _trackedId.store(0);
+            Serial.println("[MQTT] Disconnected");
+        }
+    }
+
+    if (!up) {
+        if (wifiUp && nowMs - _lastConnectMs >= MQTT_RECONNECT_MS) {
+            _lastConnectMs = nowMs;
+            _client.connect();   // Returns at once; onConnect reports back
+        }
+        return;
+    }
+
+    uint16_t acked = _ackedId.exchange(0);
+    if (acked) _flow.acked(acked);
+    _flow.tick(nowMs);
+
+    if (_eventReady.load()) {
+        if (_client.publish(_topicEvent, 1, false, _event, _eventLen) != 0) {
+            _eventReady.store(false);
+        }
+    }
+
+    if (_flow.liveReady(nowMs)) {
+        const MqttBatcher& b = _flow.live();
+        uint16_t id = _client.publish(_topicTelemetry, _settings.qos, false,
+                                      (const char*)b.data(), b.size());
+        _flow.livePublished(id, nowMs);
+        track(id);
+        return;
+    }
+
+    uint32_t fromTs, toTs;
+    if (_flow.backfillDue(nowMs, fromTs, toTs)) {
+        publishBackfill(nowMs, fromTs, toTs);
+    }
+}
+
+void MqttPublisher::track(uint16_t packetId) {
+    _trackedId.store(_settings.qos > 0 ? packetId : 0);
+}
+
+void MqttPublisher::publishStatus() {
+    char buf[96];
+    int n = snprintf(buf, sizeof(buf), "{\"online\":true,\"fw\":\"%s\",\"intervalMs\":%lu}",
+                     FIRMWARE_VERSION, (unsigned long)_settings.intervalMs);
+    _client.publish(_topicStatus, 1, true, buf, (size_t)n);
+}
+
+// Index of the first session point newer than ts (binary search: points
+// are in time order)
+uint32_t MqttPublisher::findFirstAfter(uint32_t ts) const {
+    uint32_t lo = 0;
+    uint32_t hi = _session->getTotalPointCount();
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        DataPoint dp;
+        if (_session->readPoints(mid, &dp, 1) == 1 && dp.timestamp > ts) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+void MqttPublisher::publishBackfill(uint32_t nowMs, uint32_t fromTs, uint32_t toTs) {
+    if (!_session || !_session->isActive()) {
+        _flow.backfillDone();
+        return;
+    }
+
+    uint32_t idx = findFirstAfter(fromTs);
+    uint32_t n = _session->readPoints(idx, _page, MQTT_BATCH_MAX);
+    if (n == 0 && idx < _session->getFirstRamIndex()) {
+        // Flash range unreadable: replay what RAM still holds
+        n = _session->readPoints(_session->getFirstRamIndex(), _page, MQTT_BATCH_MAX);
+    }
+
+    // Targets and setpoint as of each point, from the event journal
+    SessionEventCursor events;
+    sessionEventsBegin(events);
+    _history.reset();
+    for (uint32_t i = 0; i < n; i++) {
+        const DataPoint& dp = _page[i];
+        if (dp.timestamp <= fromTs) continue;
+        if (dp.timestamp >= toTs) break;
+
+        sessionEventsSeek(_session->getEvents(), events, dp.timestamp);
+        int16_t sp = events.value[(uint8_t)SessionEventType::SETPOINT];
+
+        bbq_protocol::DataPayload p;
+        memset(&p, 0, sizeof(p));
+        p.ts          = dp.timestamp;
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            p.temp[c] = dpDisconnected(dp, c) ? NAN : dp.temp[c] / 10.0f;
+        }
+        p.fan         = dp.fanPct;
+        p.damper      = dp.damperPct;
+        p.lid         = (dp.flags & DP_FLAG_LID_OPEN) != 0;
+        p.sp          = sp != SESSION_EVENT_NONE ? sp / 10.0f : 0.0f;
+        for (uint8_t m = 0; m < NUM_MEATS; m++) {
+            int16_t target = events.value[(uint8_t)sessionMeatTargetEvent(m)];
+            p.meatTarget[m] = target != SESSION_EVENT_NONE ? target / 10.0f : 0.0f;
+        }
+        p.fanMode     = sessionFanModeName(events.value[(uint8_t)SessionEventType::FAN_MODE]);
+        if (!_history.add(p)) break;
+    }
+
+    if (_history.empty()) {
+        _flow.backfillDone();
+        Serial.println("[MQTT] Backfill complete");
+        return;
+    }
+
+    uint16_t id = _client.publish(_topicHistory, _settings.qos, false,
+                                  (const char*)_history.data(), _history.size());
+    _flow.historyPublished(id, _history.lastTs(), nowMs);
+    track(id);
+}
+
+#else
+
+void MqttPublisher::update(uint32_t, bool) {}
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "config.h"
+#include "config_manager.h"
+#include "cook_session.h"
+#include "mqtt_batch.h"
+#include "web_protocol.h"
+#include <atomic>
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#include <AsyncMqttClient.h>
+#endif
+
+/// Publishes telemetry to an MQTT broker for fleet dashboards.
+///
+/// Topics, under <baseTopic>/<device id>/:
+///   telemetry  batch frames of binary data samples (mqtt_batch.h)
+///   history    the same, replaying an outage from the session log
+///   status     retained {"online":...}; the broker's last will clears it
+///   event      alarm/error notifications as JSON (a notifier sink)
+///
+/// The client is asynchronous (AsyncMqttClient on the AsyncTCP task), so
+/// nothing here waits on the broker. Its callbacks only set atomics that
+/// update() picks up on the loop task.
+class MqttPublisher {
+public:
+    MqttPublisher();
+
+    /// Take the settings. The broker is not contacted until update() sees
+    /// Wi-Fi up. Call once.
+    void begin(const MqttSettings& settings, const CookSession* session);
+
+    bool enabled() const { return _enabled; }
+    bool isConnected() const { return _connected.load(); }
+    const char* deviceId() const { return _deviceId; }
+
+    /// Whether a telemetry sample is due (every intervalMs).
+    bool sampleDue(uint32_t nowMs) const;
+
+    /// Add a sample built by BBQWebServer::buildDataPayload().
+    void addSample(const bbq_protocol::DataPayload& d, uint32_t nowMs);
+
+    /// Connect/reconnect, publish the live batch or the next history batch.
+    /// Call every loop().
+    void update(uint32_t nowMs, bool wifiUp);
+
+    /// Hand a notification JSON to the loop task for the event topic. Safe
+    /// from the notifier task; false if offline or the previous one is
+    /// still waiting.
+    bool postEvent(const char* json, size_t len);
+
+private:
+#ifndef NATIVE_BUILD
+    void publishStatus();
+    void publishBackfill(uint32_t nowMs, uint32_t fromTs, uint32_t toTs);
+    uint32_t findFirstAfter(uint32_t ts) const;
+    void track(uint16_t packetId);
+#endif
+
+    MqttSettings       _settings;
+    const CookSession* _session;
+    bool               _enabled;
+    MqttFlow           _flow;
+    MqttBatcher        _history;
+    DataPoint          _page[MQTT_BATCH_MAX];
+    uint32_t           _lastSampleMs;
+    uint32_t           _lastConnectMs;
+
+    char _deviceId[24];
+    char _topicTelemetry[CFG_NAME_MAX_LEN + 40];
+    char _topicHistory[CFG_NAME_MAX_LEN + 40];
+    char _topicStatus[CFG_NAME_MAX_LEN + 40];
+    char _topicEvent[CFG_NAME_MAX_LEN + 40];
+
+    // Set from the AsyncTCP task (client callbacks) or the notifier task
+    std::atomic<bool>     _connected;
+    std::atomic<uint16_t> _trackedId;   // Packet id update() waits on
+    std::atomic<uint16_t> _ackedId;
+    std::atomic<bool>     _eventReady;
+    char                  _event[MQTT_EVENT_MAX_BYTES];
+    size_t                _eventLen;
+
+#ifndef NATIVE_BUILD
+    AsyncMqttClient _client;
+#endif
+};
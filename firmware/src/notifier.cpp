@@ -0,0 +1,170 @@
+#include "notifier.h"
+
+#ifndef NATIVE_BUILD
+#include <WiFi.h>
+#include "notify_ca.h"
+#endif
+
+Notifier::Notifier()
+    : _dispatcher(_queue)
+    , _mqtt(nullptr)
+    , _sinks(0)
+    , _loggedFailed(0)
+    , _loggedExpired(0)
+#ifndef NATIVE_BUILD
+    , _task(nullptr)
+#endif
+{
+    memset(&_pushover, 0, sizeof(_pushover));
+    memset(&_webhook, 0, sizeof(_webhook));
+}
+
+void Notifier::begin(const PushoverSettings& pushover, const WebhookSettings& webhook,
+                     MqttPublisher* mqtt) {
+    _pushover = pushover;
+    _webhook = webhook;
+    _mqtt = mqtt;
+
+    _sinks = 0;
+    if (_pushover.enabled && _pushover.userKey[0] && _pushover.apiToken[0]) {
+        _sinks |= 1u << (uint8_t)NotifySink::PUSHOVER;
+    }
+    if (_webhook.enabled && _webhook.url[0]) {
+        _sinks |= 1u << (uint8_t)NotifySink::WEBHOOK;
+    }
+    if (_mqtt && _mqtt->enabled()) {
+        _sinks |= 1u << (uint8_t)NotifySink::MQTT;
+    }
+    _dispatcher.setSinks(_sinks);
+
+#ifndef NATIVE_BUILD
+    if (_sinks == 0) {
+        Serial.println("[NOTIFY] No notification sinks configured");
+        return;
+    }
+    if (_task) return;
+
+    _dispatcher.setSender(sendThunk, this);
+
+    // The Pushover request carries the user key and API token, so the
+    // server is always authenticated against the pinned roots. A webhook
+    // may be self-hosted with a private CA; skipping verification for it
+    // has to be asked for with alarms.webhook.insecure
+    _pushoverClient.setCACert(NOTIFY_ROOT_CA);
+    if (_webhook.insecure) {
+        _webhookTls.setInsecure();
+        Serial.println("[NOTIFY] Webhook TLS certificate is not verified (alarms.webhook.insecure)");
+    } else {
+        _webhookTls.setCACert(NOTIFY_ROOT_CA);
+    }
+    _pushoverHttp.setReuse(true);
+    _webhookHttp.setReuse(true);
+    _pushoverHttp.setTimeout(NOTIFY_HTTP_TIMEOUT_MS);
+    _webhookHttp.setTimeout(NOTIFY_HTTP_TIMEOUT_MS);
+
+    xTaskCreatePinnedToCore(taskMain, "notify", NOTIFY_TASK_STACK, this,
+                            NOTIFY_TASK_PRIORITY, &_task, NOTIFY_TASK_CORE);
+    Serial.printf("[NOTIFY] Task started (pushover %s, webhook %s, mqtt %s)\n",
+                  (_sinks & (1u << (uint8_t)NotifySink::PUSHOVER)) ? "on" : "off",
+                  (_sinks & (1u << (uint8_t)NotifySink::WEBHOOK)) ? "on" : "off",
+                  (_sinks & (1u << (uint8_t)NotifySink::MQTT)) ? "on" : "off");
+#endif
+}
+
+bool Notifier::post(const Notification& n) {
+    if (_sinks == 0) return false;
+    if (!_queue.post(n)) {
+#ifndef NATIVE_BUILD
+        Serial.printf("[NOTIFY] Queue full, dropped '%s'\n", n.title);
+#endif
+        return false;
+    }
+#ifndef NATIVE_BUILD
+    if (_task) xTaskNotifyGive(_task);
+#endif
+    return true;
+}
+
+#ifndef NATIVE_BUILD
+
+void Notifier::taskMain(void* arg) {
+    Notifier* self = static_cast<Notifier*>(arg);
+    for (;;) {
+        bool online = (WiFi.status() == WL_CONNECTED);
+        uint32_t waitMs = self->_dispatcher.service(millis(), online);
+        self->logTotals();
+        // A post() wakes us early; otherwise sleep until a retry is due
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs ? waitMs : 1));
+    }
+}
+
+NotifyResult Notifier::sendThunk(NotifySink sink, const Notification& n, void* ctx) {
+    Notifier* self = static_cast<Notifier*>(ctx);
+    switch (sink) {
+        case NotifySink::PUSHOVER: return self->sendPushover(n);
+        case NotifySink::WEBHOOK:  return self->sendWebhook(n);
+        case NotifySink::MQTT:     return self->sendMqtt(n);
+        default:                   return NotifyResult::REJECTED;
+    }
+}
+
+NotifyResult Notifier::sendPushover(const Notification& n) {
+    size_t len = notifyFormatPushover(n, _pushover.apiToken, _pushover.userKey,
+                                      _body, sizeof(_body));
+    if (len == 0) return NotifyResult::REJECTED;
+    return postRequest(_pushoverHttp, _pushoverClient, NOTIFY_PUSHOVER_URL,
+                       "application/x-www-form-urlencoded", _body, len);
+}
+
+NotifyResult Notifier::sendWebhook(const Notification& n) {
+    size_t len = notifyFormatWebhook(n, MDNS_HOSTNAME, millis(), _body, sizeof(_body));
+    if (len == 0) return NotifyResult::REJECTED;
+    bool tls = strncmp(_webhook.url, "https://", 8) == 0;
+    WiFiClient& client = tls ? static_cast<WiFiClient&>(_webhookTls) : _webhookPlain;
+    return postRequest(_webhookHttp, client, _webhook.url, "application/json", _body, len);
+}
+
+NotifyResult Notifier::sendMqtt(const Notification& n) {
+    size_t len = notifyFormatWebhook(n, _mqtt->deviceId(), millis(), _body, sizeof(_body));
+    if (len == 0) return NotifyResult::REJECTED;
+    // The loop task publishes it; until the broker is up, back off and retry
+    return _mqtt->postEvent(_body, len) ? NotifyResult::SENT : NotifyResult::RETRY;
+}
+
+NotifyResult Notifier::postRequest(HTTPClient& http, WiFiClient& client, const char* url,
+                                   const char* contentType, const char* body, size_t len) {
+    // With reuse on, begin() keeps the open connection when the host matches
+    if (!http.begin(client, url)) {
+        Serial.printf("[NOTIFY] Bad URL: %s\n", url);
+        return NotifyResult::REJECTED;
+    }
+    http.addHeader("Content-Type", contentType);
+    unsigned long startMs = millis();
+    int code = http.POST((uint8_t*)body, len);
+    http.end();
+
+    if (code >= 200 && code < 300) {
+        Serial.printf("[NOTIFY] Sent to %s in %lu ms\n", url, millis() - startMs);
+        return NotifyResult::SENT;
+    }
+    Serial.printf("[NOTIFY] POST %s failed: %d\n", url, code);
+    // Client errors won't fix themselves, except throttling and timeouts
+    if (code >= 400 && code < 500 && code != 408 && code != 429) {
+        return NotifyResult::REJECTED;
+    }
+    return NotifyResult::RETRY;
+}
+
+void Notifier::logTotals() {
+    if (_dispatcher.failed() != _loggedFailed) {
+        _loggedFailed = _dispatcher.failed();
+        Serial.printf("[NOTIFY] Gave up on a delivery (%lu so far)\n", (unsigned long)_loggedFailed);
+    }
+    if (_dispatcher.expired() != _loggedExpired) {
+        _loggedExpired = _dispatcher.expired();
+        Serial.printf("[NOTIFY] Dropped a stale notification (%lu so far)\n",
+                      (unsigned long)_loggedExpired);
+    }
+}
+
+#endif
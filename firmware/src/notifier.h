@@ -0,0 +1,69 @@
+#pragma once
+
+#include "config.h"
+#include "config_manager.h"
+#include "notify_queue.h"
+#include "mqtt_publisher.h"
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#endif
+
+/// Delivers alarm and error notifications to Pushover, a generic webhook
+/// and the MQTT event topic from its own low-priority task, so TLS handshakes and slow
+/// servers never stall loop() or the control task. loop() only posts to
+/// the queue (see notify_queue.h); retries, backoff and rate limiting are
+/// the dispatcher's. Connections are kept alive between sends.
+class Notifier {
+public:
+    Notifier();
+
+    /// Take the sink settings and start the delivery task. Call once.
+    /// mqtt, if enabled, adds its event topic as a sink.
+    void begin(const PushoverSettings& pushover, const WebhookSettings& webhook,
+               MqttPublisher* mqtt);
+
+    /// Queue a notification and wake the task. Never blocks. False if no
+    /// sink is enabled or the queue is full.
+    bool post(const Notification& n);
+
+    /// Whether any sink is enabled.
+    bool enabled() const { return _sinks != 0; }
+
+    uint32_t dropped() const { return _queue.dropped(); }
+
+private:
+#ifndef NATIVE_BUILD
+    static void taskMain(void* arg);
+    static NotifyResult sendThunk(NotifySink sink, const Notification& n, void* ctx);
+
+    NotifyResult sendPushover(const Notification& n);
+    NotifyResult sendWebhook(const Notification& n);
+    NotifyResult sendMqtt(const Notification& n);
+    NotifyResult postRequest(HTTPClient& http, WiFiClient& client, const char* url,
+                          const char* contentType, const char* body, size_t len);
+    void logTotals();
+#endif
+
+    NotifyQueue      _queue;
+    NotifyDispatcher _dispatcher;
+    PushoverSettings _pushover;
+    WebhookSettings  _webhook;
+    MqttPublisher*   _mqtt;
+    uint8_t          _sinks;
+    uint32_t         _loggedFailed;
+    uint32_t         _loggedExpired;
+
+#ifndef NATIVE_BUILD
+    TaskHandle_t     _task;
+    char             _body[512];
+    WiFiClientSecure _pushoverClient;
+    HTTPClient       _pushoverHttp;
+    WiFiClientSecure _webhookTls;
+    WiFiClient       _webhookPlain;
+    HTTPClient       _webhookHttp;
+#endif
+};
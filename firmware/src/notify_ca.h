@@ -0,0 +1,11 @@
+#pragma once
+
+// Root certificates HTTPS servers are verified against, by the notifier and
+// by OTA pulls: the public roots api.pushover.net's chain, most webhook
+// hosts and public firmware hosts end in. One PEM block per root; mbedTLS
+// parses the concatenation. Update when Pushover moves to a CA not listed
+// here (sends then fail with a TLS error in the log rather than going out
+// unauthenticated). Defined once in notify_ca.cpp so the PEM is in flash
+// once.
+
+extern const char NOTIFY_ROOT_CA[];
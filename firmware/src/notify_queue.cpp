@@ -0,0 +1,372 @@
+#include "notify_queue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Done alarm names by meat probe, as the channel keys
+static const char* const kMeatDoneNames[PROBE_MAX - 1] = {
+    "meat1_done", "meat2_done", "meat3_done", "meat4_done",
+    "meat5_done", "meat6_done", "meat7_done"
+};
+
+const char* notifyTypeName(const Notification& n) {
+    if (n.kind == NotifyKind::ALARM) {
+        AlarmType a = (AlarmType)n.code;
+        if (a == AlarmType::PIT_HIGH) return "pit_high";
+        if (a == AlarmType::PIT_LOW)  return "pit_low";
+        uint8_t m = alarmMeatIndex(a);
+        return m < NUM_MEATS ? kMeatDoneNames[m] : "alarm";
+    }
+    switch ((ErrorCode)n.code) {
+        case ErrorCode::PROBE_OPEN:  return "probe_open";
+        case ErrorCode::PROBE_SHORT: return "probe_short";
+        case ErrorCode::FIRE_OUT:    return "fire_out";
+        case ErrorCode::FAN_STALL:   return "fan_stall";
+        case ErrorCode::FUEL_LOW:    return "fuel_low";
+        case ErrorCode::MEAT_DONE_SOON: return "meat_done_soon";
+        default:                     return "error";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// NotifyQueue
+// ---------------------------------------------------------------------------
+
+NotifyQueue::NotifyQueue()
+    : _head(0)
+    , _tail(0)
+    , _dropped(0)
+{
+    memset(_slots, 0, sizeof(_slots));
+}
+
+bool NotifyQueue::post(const Notification& n) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= NOTIFY_QUEUE_LEN) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _slots[head % NOTIFY_QUEUE_LEN] = n;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool NotifyQueue::take(Notification& out) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;
+    out = _slots[tail % NOTIFY_QUEUE_LEN];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t NotifyQueue::size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+// ---------------------------------------------------------------------------
+// Transition tracking
+// ---------------------------------------------------------------------------
+
+void notifyTrackerReset(NotifyTracker& tr) {
+    memset(&tr, 0, sizeof(tr));
+}
+
+static void fillAlarm(Notification& n, AlarmType a, const TelemetrySnapshot& t, char unit) {
+    n.kind = NotifyKind::ALARM;
+    n.code = (uint8_t)a;
+    switch (a) {
+        case AlarmType::PIT_HIGH:
+        case AlarmType::PIT_LOW:
+            n.probe = PROBE_PIT;
+            n.priority = 0;
+            n.value = t.temp[PROBE_PIT];
+            snprintf(n.title, sizeof(n.title), "Pit %s", a == AlarmType::PIT_HIGH ? "high" : "low");
+            snprintf(n.message, sizeof(n.message), "Pit at %.0f%c, setpoint %.0f%c",
+                     n.value, unit, t.setpoint, unit);
+            break;
+        default: {
+            uint8_t m = alarmMeatIndex(a);
+            if (m >= NUM_MEATS) m = 0;
+            n.probe = PROBE_MEAT1 + m;
+            n.priority = 1;
+            n.value = t.temp[n.probe];
+            snprintf(n.title, sizeof(n.title), "%s done", kProbeChannels[n.probe].label);
+            snprintf(n.message, sizeof(n.message), "%s at %.0f%c (target %.0f%c)",
+                     kProbeChannels[n.probe].label, n.value, unit, t.meatTarget[m], unit);
+            break;
+        }
+    }
+}
+
+static void fillError(Notification& n, const ErrorEntry& e, const TelemetrySnapshot& t) {
+    n.kind = NotifyKind::ERROR;
+    n.code = (uint8_t)e.code;
+    n.probe = e.probeIndex;
+    n.priority = (e.code == ErrorCode::FIRE_OUT) ? 1 : 0;
+    n.value = t.temp[e.probeIndex < NUM_PROBES ? e.probeIndex : (uint8_t)PROBE_PIT];
+    switch (e.code) {
+        case ErrorCode::FIRE_OUT:  strncpy(n.title, "Fire out", sizeof(n.title) - 1); break;
+        case ErrorCode::FAN_STALL: strncpy(n.title, "Fan stall", sizeof(n.title) - 1); break;
+        case ErrorCode::FUEL_LOW:  strncpy(n.title, "Fuel low", sizeof(n.title) - 1); break;
+        case ErrorCode::MEAT_DONE_SOON: strncpy(n.title, "Almost done", sizeof(n.title) - 1); break;
+        default:                   strncpy(n.title, "Probe error", sizeof(n.title) - 1); break;
+    }
+    strncpy(n.message, e.message, sizeof(n.message) - 1);
+}
+
+static bool reportable(ErrorCode c) {
+    return c != ErrorCode::NONE && c != ErrorCode::WIFI_LOST && c != ErrorCode::LOOP_OVERRUN;
+}
+
+uint8_t notifyCollect(NotifyTracker& tr, const TelemetrySnapshot& t, bool fahrenheit,
+                      Notification* out, uint8_t maxCount) {
+    char unit = fahrenheit ? 'F' : 'C';
+    uint8_t count = 0;
+
+    uint16_t alarmMask = 0;
+    for (uint8_t i = 0; i < t.alarmCount && i < MAX_ACTIVE_ALARMS; i++) {
+        AlarmType a = t.alarms[i];
+        if (a == AlarmType::NONE) continue;
+        uint16_t bit = (uint16_t)(1u << (uint8_t)a);
+        if (!(tr.alarmMask & bit) && !(alarmMask & bit) && count < maxCount) {
+            Notification& n = out[count++];
+            memset(&n, 0, sizeof(n));
+            n.createdMs = t.tickMs;
+            fillAlarm(n, a, t, unit);
+        }
+        alarmMask |= bit;
+    }
+    tr.alarmMask = alarmMask;
+
+    uint16_t keys[MAX_ERRORS];
+    uint8_t keyCount = 0;
+    for (uint8_t i = 0; i < t.errorCount && i < MAX_ERRORS; i++) {
+        const ErrorEntry& e = t.errors[i];
+        uint16_t key = (uint16_t)(((uint8_t)e.code << 8) | e.probeIndex);
+        keys[keyCount++] = key;
+        if (!reportable(e.code)) continue;
+
+        bool seen = false;
+        for (uint8_t j = 0; j < tr.errorCount; j++) {
+            if (tr.errorKeys[j] == key) { seen = true; break; }
+        }
+        if (!seen && count < maxCount) {
+            Notification& n = out[count++];
+            memset(&n, 0, sizeof(n));
+            n.createdMs = t.tickMs;
+            fillError(n, e, t);
+        }
+    }
+    memcpy(tr.errorKeys, keys, sizeof(keys[0]) * keyCount);
+    tr.errorCount = keyCount;
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Rate limit and backoff
+// ---------------------------------------------------------------------------
+
+void notifyBucketInit(NotifyBucket& b, uint32_t nowMs) {
+    b.tokens = NOTIFY_RATE_BURST;
+    b.refillMs = nowMs;
+}
+
+bool notifyBucketTake(NotifyBucket& b, uint32_t nowMs) {
+    uint32_t earned = (nowMs - b.refillMs) / NOTIFY_RATE_REFILL_MS;
+    if (earned > 0) {
+        uint32_t tokens = b.tokens + earned;
+        b.tokens = tokens > NOTIFY_RATE_BURST ? NOTIFY_RATE_BURST : (uint8_t)tokens;
+        b.refillMs += earned * NOTIFY_RATE_REFILL_MS;
+    }
+    if (b.tokens == NOTIFY_RATE_BURST) b.refillMs = nowMs;  // A full bucket doesn't bank time
+    if (b.tokens == 0) return false;
+    b.tokens--;
+    return true;
+}
+
+uint32_t notifyBackoffMs(uint8_t failures) {
+    uint32_t ms = NOTIFY_RETRY_BASE_MS;
+    for (uint8_t i = 1; i < failures && ms < NOTIFY_RETRY_MAX_MS; i++) ms *= 2;
+    return ms < NOTIFY_RETRY_MAX_MS ? ms : NOTIFY_RETRY_MAX_MS;
+}
+
+// ---------------------------------------------------------------------------
+// NotifyDispatcher
+// ---------------------------------------------------------------------------
+
+NotifyDispatcher::NotifyDispatcher(NotifyQueue& queue)
+    : _queue(queue)
+    , _send(nullptr)
+    , _ctx(nullptr)
+    , _sinks(0)
+    , _haveCurrent(false)
+    , _pending(0)
+    , _bucketsReady(false)
+    , _sent(0)
+    , _failed(0)
+    , _expired(0)
+{
+    memset(&_current, 0, sizeof(_current));
+    memset(_failures, 0, sizeof(_failures));
+    memset(_retryAtMs, 0, sizeof(_retryAtMs));
+}
+
+void NotifyDispatcher::setSender(NotifySendFn fn, void* ctx) {
+    _send = fn;
+    _ctx = ctx;
+}
+
+void NotifyDispatcher::finishCurrent() {
+    _haveCurrent = false;
+    _pending = 0;
+}
+
+uint32_t NotifyDispatcher::service(uint32_t nowMs, bool online) {
+    if (!_bucketsReady) {
+        for (uint8_t s = 0; s < NOTIFY_SINKS; s++) notifyBucketInit(_bucket[s], nowMs);
+        _bucketsReady = true;
+    }
+
+    for (;;) {
+        if (!_haveCurrent) {
+            if (!_queue.take(_current)) return NOTIFY_IDLE_MS;
+            _haveCurrent = true;
+            _pending = _sinks;
+            memset(_failures, 0, sizeof(_failures));
+            for (uint8_t s = 0; s < NOTIFY_SINKS; s++) _retryAtMs[s] = nowMs;
+        }
+
+        if (nowMs - _current.createdMs >= NOTIFY_MAX_AGE_MS) {
+            _expired++;
+            finishCurrent();
+            continue;
+        }
+        if (_pending == 0 || !_send) {
+            finishCurrent();
+            continue;
+        }
+        if (!online) return NOTIFY_IDLE_MS;
+
+        // One pass over the sinks still owed this notification; each
+        // waits on its own backoff and rate limit
+        uint32_t wait = NOTIFY_IDLE_MS;
+        for (uint8_t s = 0; s < NOTIFY_SINKS; s++) {
+            uint8_t bit = (uint8_t)(1u << s);
+            if (!(_pending & bit)) continue;
+
+            int32_t due = (int32_t)(_retryAtMs[s] - nowMs);
+            if (due > 0) {
+                if ((uint32_t)due < wait) wait = (uint32_t)due;
+                continue;
+            }
+            if (!notifyBucketTake(_bucket[s], nowMs)) {
+                uint32_t refill = NOTIFY_RATE_REFILL_MS - (nowMs - _bucket[s].refillMs);
+                if (refill < wait) wait = refill;
+                continue;
+            }
+
+            NotifyResult r = _send((NotifySink)s, _current, _ctx);
+            if (r == NotifyResult::SENT) {
+                _pending &= (uint8_t)~bit;
+                _sent++;
+            } else if (r == NotifyResult::REJECTED || ++_failures[s] >= NOTIFY_MAX_ATTEMPTS) {
+                _pending &= (uint8_t)~bit;
+                _failed++;
+            } else {
+                uint32_t backoff = notifyBackoffMs(_failures[s]);
+                _retryAtMs[s] = nowMs + backoff;
+                if (backoff < wait) wait = backoff;
+            }
+        }
+
+        if (_pending != 0) return wait;
+        finishCurrent();
+        // Delivered everywhere: go straight on to the next one
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Payloads
+// ---------------------------------------------------------------------------
+
+// Appends `s` percent-encoded to buf at *pos. False if it did not fit.
+static bool appendUrlEncoded(char* buf, size_t len, size_t* pos, const char* s) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        bool plain = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+                     (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~';
+        size_t need = plain ? 1 : 3;
+        if (*pos + need >= len) return false;
+        if (plain) {
+            buf[(*pos)++] = (char)c;
+        } else {
+            buf[(*pos)++] = '%';
+            buf[(*pos)++] = HEX_DIGITS[c >> 4];
+            buf[(*pos)++] = HEX_DIGITS[c & 0x0F];
+        }
+    }
+    buf[*pos] = '\0';
+    return true;
+}
+
+static bool appendRaw(char* buf, size_t len, size_t* pos, const char* s) {
+    size_t n = strlen(s);
+    if (*pos + n >= len) return false;
+    memcpy(buf + *pos, s, n + 1);
+    *pos += n;
+    return true;
+}
+
+size_t notifyFormatPushover(const Notification& n, const char* token, const char* user,
+                            char* buf, size_t len) {
+    if (len == 0) return 0;
+    size_t pos = 0;
+    char priority[8];
+    snprintf(priority, sizeof(priority), "%d", n.priority);
+    bool ok = appendRaw(buf, len, &pos, "token=")    && appendUrlEncoded(buf, len, &pos, token)
+           && appendRaw(buf, len, &pos, "&user=")    && appendUrlEncoded(buf, len, &pos, user)
+           && appendRaw(buf, len, &pos, "&title=")   && appendUrlEncoded(buf, len, &pos, n.title)
+           && appendRaw(buf, len, &pos, "&message=") && appendUrlEncoded(buf, len, &pos, n.message)
+           && appendRaw(buf, len, &pos, "&priority=") && appendRaw(buf, len, &pos, priority);
+    return ok ? pos : 0;
+}
+
+// Appends `s` as a JSON string body (no quotes). Control characters other
+// than the common escapes are dropped.
+static bool appendJsonEscaped(char* buf, size_t len, size_t* pos, const char* s) {
+    for (; *s; s++) {
+        char c = *s;
+        const char* esc = nullptr;
+        if (c == '"')       esc = "\\\"";
+        else if (c == '\\') esc = "\\\\";
+        else if (c == '\n') esc = "\\n";
+        else if ((unsigned char)c < 0x20) continue;
+        if (esc) {
+            if (!appendRaw(buf, len, pos, esc)) return false;
+        } else {
+            if (*pos + 1 >= len) return false;
+            buf[(*pos)++] = c;
+            buf[*pos] = '\0';
+        }
+    }
+    return true;
+}
+
+size_t notifyFormatWebhook(const Notification& n, const char* device, uint32_t nowMs,
+                           char* buf, size_t len) {
+    if (len == 0) return 0;
+    size_t pos = 0;
+    char tail[96];
+    snprintf(tail, sizeof(tail), "\",\"priority\":%d,\"value\":%.1f,\"probe\":%d,\"ageMs\":%lu}",
+             n.priority, n.value, n.probe < NUM_PROBES ? (int)n.probe : -1,
+             (unsigned long)(nowMs - n.createdMs));
+    bool ok = appendRaw(buf, len, &pos, "{\"device\":\"")  && appendJsonEscaped(buf, len, &pos, device)
+           && appendRaw(buf, len, &pos, "\",\"kind\":\"")
+           && appendRaw(buf, len, &pos, n.kind == NotifyKind::ALARM ? "alarm" : "error")
+           && appendRaw(buf, len, &pos, "\",\"type\":\"")  && appendRaw(buf, len, &pos, notifyTypeName(n))
+           && appendRaw(buf, len, &pos, "\",\"title\":\"") && appendJsonEscaped(buf, len, &pos, n.title)
+           && appendRaw(buf, len, &pos, "\",\"message\":\"") && appendJsonEscaped(buf, len, &pos, n.message)
+           && appendRaw(buf, len, &pos, tail);
+    return ok ? pos : 0;
+}
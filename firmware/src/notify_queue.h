@@ -0,0 +1,158 @@
+#pragma once
+
+#include "config.h"
+#include "telemetry.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Outbound notifications for alarm and error onsets.
+//
+// loop() diffs each new TelemetrySnapshot against the last (NotifyTracker)
+// and posts what became active to a NotifyQueue. A background task owns the
+// consumer side through a NotifyDispatcher, which delivers each notification
+// to every enabled sink with per-sink retry/backoff and a token-bucket rate
+// limit. The send itself is a callback, so the HTTP (or MQTT) client lives
+// in the task and nothing here blocks.
+//
+// Pure C++ — no FreeRTOS, Arduino or network dependencies. Fully testable
+// on native.
+
+enum class NotifyKind : uint8_t {
+    ALARM = 0,      // code = AlarmType
+    ERROR = 1       // code = ErrorCode
+};
+
+struct Notification {
+    uint32_t   createdMs;
+    NotifyKind kind;
+    uint8_t    code;
+    uint8_t    probe;       // Probe index, 0xFF if none
+    int8_t     priority;    // Pushover scale: 0 normal, 1 high
+    float      value;       // Temperature that raised it, in configured units
+    char       title[32];
+    char       message[96];
+};
+
+// Short machine name of a notification's type ("meat1_done", "fire_out", ...)
+const char* notifyTypeName(const Notification& n);
+
+// --- Queue ---
+
+// Bounded single-producer, single-consumer ring. post() and take() never
+// block; a full queue drops the new notification and counts it.
+class NotifyQueue {
+public:
+    NotifyQueue();
+
+    bool post(const Notification& n);   // Producer (loop)
+    bool take(Notification& out);       // Consumer (notifier task)
+
+    uint32_t size() const;
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    Notification          _slots[NOTIFY_QUEUE_LEN];
+    std::atomic<uint32_t> _head;        // Next write, producer only
+    std::atomic<uint32_t> _tail;        // Next read, consumer only
+    std::atomic<uint32_t> _dropped;
+};
+
+// --- Transition tracking ---
+
+struct NotifyTracker {
+    uint16_t alarmMask;                 // 1 << AlarmType of each active alarm
+    uint16_t errorKeys[MAX_ERRORS];     // (code << 8) | probe of each active error
+    uint8_t  errorCount;
+};
+
+void notifyTrackerReset(NotifyTracker& tr);
+
+// Notifications for alarms and errors active in `t` but not in the previous
+// snapshot seen. Loop overruns and Wi-Fi loss are not reported. Returns the
+// number written to `out`.
+uint8_t notifyCollect(NotifyTracker& tr, const TelemetrySnapshot& t, bool fahrenheit,
+                      Notification* out, uint8_t maxCount);
+
+// --- Delivery ---
+
+enum class NotifySink : uint8_t {
+    PUSHOVER = 0,
+    WEBHOOK,
+    MQTT,           // <base>/<id>/event on the telemetry broker
+    COUNT
+};
+
+#define NOTIFY_SINKS  ((uint8_t)NotifySink::COUNT)
+
+enum class NotifyResult : uint8_t {
+    SENT,
+    RETRY,      // Transient (timeout, 5xx): try again after the backoff
+    REJECTED    // Permanent (4xx, bad settings): give up on this sink
+};
+
+typedef NotifyResult (*NotifySendFn)(NotifySink sink, const Notification& n, void* ctx);
+
+// Token bucket: NOTIFY_RATE_BURST sends, refilled one per NOTIFY_RATE_REFILL_MS
+struct NotifyBucket {
+    uint8_t  tokens;
+    uint32_t refillMs;      // When the last token was credited
+};
+
+void notifyBucketInit(NotifyBucket& b, uint32_t nowMs);
+bool notifyBucketTake(NotifyBucket& b, uint32_t nowMs);
+
+// Retry delay after `failures` failed sends (1 = first failure)
+uint32_t notifyBackoffMs(uint8_t failures);
+
+class NotifyDispatcher {
+public:
+    explicit NotifyDispatcher(NotifyQueue& queue);
+
+    void setSender(NotifySendFn fn, void* ctx);
+
+    // Bitmask of enabled sinks (1 << NotifySink)
+    void setSinks(uint8_t mask) { _sinks = mask; }
+
+    // Deliver what is due. Offline, nothing is attempted (and no attempts
+    // are used up) but stale notifications still expire. Returns how long
+    // the caller may sleep before there is more to do, at most NOTIFY_IDLE_MS.
+    uint32_t service(uint32_t nowMs, bool online);
+
+    uint32_t sent() const     { return _sent; }
+    uint32_t failed() const   { return _failed; }   // Sink deliveries given up
+    uint32_t expired() const  { return _expired; }
+    bool     busy() const     { return _haveCurrent; }
+
+private:
+    void finishCurrent();
+
+    NotifyQueue& _queue;
+    NotifySendFn _send;
+    void*        _ctx;
+    uint8_t      _sinks;
+
+    Notification _current;
+    bool         _haveCurrent;
+    uint8_t      _pending;                      // Sinks still to deliver _current to
+    uint8_t      _failures[NOTIFY_SINKS];
+    uint32_t     _retryAtMs[NOTIFY_SINKS];
+    NotifyBucket _bucket[NOTIFY_SINKS];
+    bool         _bucketsReady;
+
+    uint32_t     _sent;
+    uint32_t     _failed;
+    uint32_t     _expired;
+};
+
+// --- Payloads ---
+
+// Pushover form body (application/x-www-form-urlencoded). Returns the
+// length written, or 0 if it did not fit.
+size_t notifyFormatPushover(const Notification& n, const char* token, const char* user,
+                            char* buf, size_t len);
+
+// Webhook JSON body. `nowMs` gives the notification's age. Returns the
+// length written, or 0 if it did not fit.
+size_t notifyFormatWebhook(const Notification& n, const char* device, uint32_t nowMs,
+                           char* buf, size_t len);
@@ -1,4 +1,9 @@
 #include "ota_manager.h"
+#include "ext_ram.h"
+#include "notify_ca.h"
+#include <new>
+#include <stdlib.h>
+#include <string.h>
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
@@ -9,13 +14,34 @@ OtaManager::OtaManager()
     : _updating(false)
     , _progress(0)
     , _initialized(false)
+    , _insecure(false)
+    , _state(OtaState::IDLE)
+    , _size(0)
+    , _received(0)
+    , _written(0)
+    , _abort(false)
+    , _error(nullptr)
+    , _restartAtMs(0)
+    , _lastInputMs(0)
+    , _window(nullptr)
+    , _stream(nullptr)
 #ifndef NATIVE_BUILD
     , _server(nullptr)
+    , _task(nullptr)
+    , _input(nullptr)
+    , _inputStorage(nullptr)
+    , _chunkLen(0)
+    , _chunkPos(0)
+    , _skip(0)
 #endif
 {
+#ifndef NATIVE_BUILD
+    _url[0] = '\0';
+    _md5[0] = '\0';
+#endif
 }
 
-void OtaManager::begin(AsyncWebServer* server) {
+void OtaManager::begin(AsyncWebServer* server, const OtaSettings& settings) {
 #ifndef NATIVE_BUILD
     if (server == nullptr) {
         Serial.println("[OTA] Error: null server pointer, OTA not initialized.");
@@ -23,6 +49,8 @@ void OtaManager::begin(AsyncWebServer* server) {
     }
 
     _server = server;
+    _insecure = settings.insecure;
+    if (_insecure) Serial.println("[OTA] https pull certificates are not verified (ota.insecure)");
 
     // Set up ElegantOTA callbacks for progress tracking
     ElegantOTA.onStart([this]() {
@@ -60,23 +88,383 @@ void OtaManager::begin(AsyncWebServer* server) {
     // Register the /update endpoint on the existing web server
     ElegantOTA.begin(_server);
 
+    // Chunked, resumable uploads and URL pulls for the web UI
+    _server->on("/api/ota/start", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        handleStart(request);
+    });
+    _server->on("/api/ota/chunk", HTTP_POST,
+        [this](AsyncWebServerRequest* request) { sendStatus(request); },
+        nullptr,
+        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            handleChunkBody(request, data, len, index);
+        });
+    _server->on("/api/ota/pull", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        handlePull(request);
+    });
+    _server->on("/api/ota/abort", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        handleAbort(request);
+    });
+    _server->on("/api/ota/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        sendStatus(request);
+    });
+
     _initialized = true;
-    Serial.println("[OTA] ElegantOTA initialized at /update");
+    Serial.println("[OTA] ElegantOTA initialized at /update, resumable uploads at /api/ota");
 #endif
 }
 
 void OtaManager::update() {
 #ifndef NATIVE_BUILD
-    // ElegantOTA handles everything asynchronously via the web server.
-    // This method is provided for interface consistency with other managers.
     ElegantOTA.loop();
+
+    if (_restartAtMs != 0 && (int32_t)(millis() - _restartAtMs) >= 0) {
+        Serial.println("[OTA] Rebooting into the new firmware...");
+        ESP.restart();
+    }
 #endif
 }
 
 bool OtaManager::isUpdating() const {
-    return _updating;
+    return _updating || _state == OtaState::RECEIVING || _state == OtaState::PULLING;
 }
 
 uint8_t OtaManager::getProgress() const {
-    return _progress;
+    if (_updating) return _progress;
+    if (_state == OtaState::DONE) return 100;
+    uint32_t size = _size;
+    if (!isUpdating() || size == 0) return 0;
+    uint32_t received = _received;
+    return (uint8_t)((uint64_t)(received < size ? received : size) * 100 / size);
+}
+
+const char* OtaManager::stateName(OtaState state) {
+    switch (state) {
+        case OtaState::IDLE:      return "idle";
+        case OtaState::RECEIVING: return "receiving";
+        case OtaState::PULLING:   return "pulling";
+        case OtaState::DONE:      return "done";
+        case OtaState::FAILED:    return "failed";
+    }
+    return "idle";
+}
+
+#ifndef NATIVE_BUILD
+
+// ---------------------------------------------------------------------------
+// Routes (async_tcp)
+// ---------------------------------------------------------------------------
+
+static uint32_t paramU32(AsyncWebServerRequest* request, const char* name) {
+    AsyncWebParameter* p = request->getParam(name);
+    return p ? (uint32_t)strtoul(p->value().c_str(), nullptr, 10) : 0;
+}
+
+static const char* paramStr(AsyncWebServerRequest* request, const char* name) {
+    AsyncWebParameter* p = request->getParam(name);
+    return p ? p->value().c_str() : "";
+}
+
+void OtaManager::handleStart(AsyncWebServerRequest* request) {
+    uint32_t size = paramU32(request, "size");
+    if (size == 0) {
+        request->send(400, "text/plain", "Missing size");
+        return;
+    }
+
+    // Same image still being received: carry on from where it stopped
+    if (_state == OtaState::RECEIVING && size == _size) {
+        Serial.printf("[OTA] Upload resumed at %u / %u bytes\n",
+                      (unsigned)_received, (unsigned)_size);
+        sendStatus(request);
+        return;
+    }
+    if (!startTask(OtaState::RECEIVING, size, paramStr(request, "md5"))) {
+        sendStatus(request, 409);
+        return;
+    }
+    Serial.printf("[OTA] Upload started (%u bytes)\n", (unsigned)size);
+    sendStatus(request);
+}
+
+// Body parts of one chunk. Only bytes that continue the image are taken;
+// the reply's offset tells the client where to send from next.
+void OtaManager::handleChunkBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                                 size_t index) {
+    if (_state != OtaState::RECEIVING || !request->hasParam("offset")) return;
+
+    uint32_t at = paramU32(request, "offset") + (uint32_t)index;
+    uint32_t received = _received;
+    if (at > received || at + len <= received) return;   // Gap, or already have it
+    size_t skip = received - at;
+
+    size_t sent = xStreamBufferSend(_input, data + skip, len - skip, pdMS_TO_TICKS(OTA_BODY_WAIT_MS));
+    _received = received + (uint32_t)sent;
+    if (sent > 0) _lastInputMs = millis();
+}
+
+void OtaManager::handlePull(AsyncWebServerRequest* request) {
+    const char* url = paramStr(request, "url");
+    if ((strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) ||
+        strlen(url) >= sizeof(_url)) {
+        request->send(400, "text/plain", "Missing or bad url");
+        return;
+    }
+    // Nothing authenticates a plain http download, so the image has to
+    // come with the hash it must match
+    const char* md5 = paramStr(request, "md5");
+    if (strncmp(url, "http://", 7) == 0 && strlen(md5) != 32) {
+        request->send(400, "text/plain", "http:// pulls need an md5");
+        return;
+    }
+    if (_task == nullptr) strcpy(_url, url);
+    if (!startTask(OtaState::PULLING, 0, md5)) {
+        sendStatus(request, 409);
+        return;
+    }
+    Serial.printf("[OTA] Pulling %s\n", _url);
+    sendStatus(request);
+}
+
+void OtaManager::handleAbort(AsyncWebServerRequest* request) {
+    if (_task != nullptr) {
+        _abort = true;
+        Serial.println("[OTA] Abort requested");
+    }
+    sendStatus(request);
+}
+
+void OtaManager::sendStatus(AsyncWebServerRequest* request, int code) {
+    const char* err = _error;
+    char json[192];
+    snprintf(json, sizeof(json),
+             "{\"state\":\"%s\",\"offset\":%u,\"size\":%u,\"written\":%u,\"progress\":%u%s%s%s}",
+             stateName(_state), (unsigned)_received, (unsigned)_size, (unsigned)_written,
+             (unsigned)getProgress(),
+             err ? ",\"error\":\"" : "", err ? err : "", err ? "\"" : "");
+    request->send(code, "application/json", json);
+}
+
+// ---------------------------------------------------------------------------
+// Update task
+// ---------------------------------------------------------------------------
+
+bool OtaManager::allocBuffers() {
+    if (_stream) return true;
+
+    if (!_window) _window = (uint8_t*)extRamAlloc(OTA_WINDOW_SIZE);
+    if (!_inputStorage) _inputStorage = (uint8_t*)extRamAlloc(OTA_INPUT_BUFFER + 1);
+    void* stream = extRamAlloc(sizeof(OtaStream));
+    if (!_window || !_inputStorage || !stream) {
+        extRamFree(stream);
+        return false;
+    }
+    _input = xStreamBufferCreateStatic(OTA_INPUT_BUFFER, 1, _inputStorage, &_inputCtl);
+    _stream = new (stream) OtaStream(_window);
+    return true;
+}
+
+bool OtaManager::startTask(OtaState state, uint32_t size, const char* md5) {
+    if (_task != nullptr || _updating) {
+        _error = "another update is in progress";
+        return false;
+    }
+    if (!allocBuffers()) {
+        _error = "out of memory";
+        _state = OtaState::FAILED;
+        return false;
+    }
+
+    xStreamBufferReset(_input);
+    _chunkLen = 0;
+    _chunkPos = 0;
+    _skip = 0;
+    _size = size;
+    _received = 0;
+    _written = 0;
+    _abort = false;
+    _error = nullptr;
+    _lastInputMs = millis();
+    strncpy(_md5, md5, sizeof(_md5) - 1);
+    _md5[sizeof(_md5) - 1] = '\0';
+    _state = state;
+
+    if (xTaskCreatePinnedToCore(taskMain, "ota", OTA_TASK_STACK, this,
+                                OTA_TASK_PRIORITY, &_task, OTA_TASK_CORE) != pdPASS) {
+        _task = nullptr;
+        _error = "no memory for the update task";
+        _state = OtaState::FAILED;
+        return false;
+    }
+    return true;
+}
+
+void OtaManager::taskMain(void* arg) {
+    OtaManager* self = static_cast<OtaManager*>(arg);
+    self->runUpdate();
+    self->_task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void OtaManager::runUpdate() {
+    bool pulling = _state == OtaState::PULLING;
+    OtaStreamResult result = OtaStreamResult::INPUT_ENDED;
+
+    if (pulling && !connectPull()) {
+        if (!_error) _error = "pull failed";
+    } else if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+        _error = Update.errorString();
+    } else {
+        if (_md5[0] != '\0') Update.setMD5(_md5);
+        result = _stream->run(_size, readInput, writeFlash, this);
+        if (result == OtaStreamResult::OK) {
+            if (Update.end(true)) {
+                Serial.printf("[OTA] %s image verified (%u bytes in, %u written)\n",
+                              _stream->compressed() ? "Gzip" : "Raw",
+                              (unsigned)_received, (unsigned)_written);
+                _state = OtaState::DONE;
+                _restartAtMs = (millis() + OTA_RESTART_DELAY_MS) | 1;
+            } else {
+                _error = Update.errorString();
+            }
+        } else {
+            // INPUT_ENDED says why through _error (timed out, aborted, dropped)
+            if (result != OtaStreamResult::INPUT_ENDED || !_error) {
+                _error = _abort ? "aborted" : OtaStream::resultName(result);
+            }
+            Update.abort();
+        }
+    }
+    if (pulling) _http.end();
+
+    if (_state != OtaState::DONE) {
+        _state = OtaState::FAILED;
+        Serial.printf("[OTA] Update failed at %u bytes: %s\n", (unsigned)_received, _error);
+    }
+}
+
+int OtaManager::readInput(void* ctx) {
+    OtaManager* self = static_cast<OtaManager*>(ctx);
+    if (self->_chunkPos >= self->_chunkLen) {
+        bool more = self->_state == OtaState::PULLING ? self->refillPull() : self->refillUpload();
+        if (!more) return -1;
+    }
+    return self->_chunk[self->_chunkPos++];
+}
+
+bool OtaManager::writeFlash(void* ctx, const uint8_t* data, size_t len) {
+    OtaManager* self = static_cast<OtaManager*>(ctx);
+    if (Update.write(const_cast<uint8_t*>(data), len) != len) return false;
+    self->_written += len;
+    // A sector at a time, then let loop() and async_tcp have the core
+    vTaskDelay(1);
+    return true;
 }
+
+// Wait for async_tcp to queue the next bytes
+bool OtaManager::refillUpload() {
+    for (;;) {
+        if (_abort) {
+            _error = "aborted";
+            return false;
+        }
+        size_t n = xStreamBufferReceive(_input, _chunk, sizeof(_chunk), pdMS_TO_TICKS(1000));
+        if (n > 0) {
+            _chunkLen = n;
+            _chunkPos = 0;
+            return true;
+        }
+        if (millis() - _lastInputMs >= OTA_IDLE_TIMEOUT_MS) {
+            _error = "upload timed out";
+            return false;
+        }
+    }
+}
+
+// Read the next bytes of a pull, reconnecting from _received when the
+// connection drops or stalls
+bool OtaManager::refillPull() {
+    uint8_t retries = 0;
+    for (;;) {
+        if (_abort) {
+            _error = "aborted";
+            return false;
+        }
+        WiFiClient* s = _http.getStreamPtr();
+        int avail = s ? s->available() : 0;
+        if (avail > 0) {
+            size_t n = s->readBytes(_chunk, avail < (int)sizeof(_chunk) ? avail : sizeof(_chunk));
+            _lastInputMs = millis();
+            size_t drop = _skip < n ? _skip : n;
+            _skip -= drop;
+            if (drop == n) continue;
+            _chunkPos = drop;
+            _chunkLen = n;
+            _received += (uint32_t)(n - drop);
+            return true;
+        }
+        if (s && s->connected() && millis() - _lastInputMs < OTA_HTTP_TIMEOUT_MS) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        if (retries++ >= OTA_PULL_RETRIES) {
+            _error = "download dropped";
+            return false;
+        }
+        Serial.printf("[OTA] Pull dropped at %u bytes, resuming\n", (unsigned)_received);
+        vTaskDelay(pdMS_TO_TICKS(OTA_PULL_RETRY_MS));
+        connectPull();
+    }
+}
+
+// GET the image, from _received on. A server that ignores the Range
+// header sends it all again and the bytes already used are dropped.
+bool OtaManager::connectPull() {
+    _http.end();
+    bool ok;
+    if (strncmp(_url, "https://", 8) == 0) {
+        // Verified like the notifier's Pushover and webhook servers; a
+        // private CA needs ota.insecure
+        if (_insecure) _tls.setInsecure();
+        else           _tls.setCACert(NOTIFY_ROOT_CA);
+        ok = _http.begin(_tls, _url);
+    } else {
+        ok = _http.begin(_plain, _url);   // Only with an md5 (handlePull)
+    }
+    if (!ok) {
+        _error = "bad url";
+        return false;
+    }
+    _http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    _http.setTimeout(OTA_HTTP_TIMEOUT_MS);
+    uint32_t from = _received;
+    if (from > 0) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%u-", (unsigned)from);
+        _http.addHeader("Range", range);
+    }
+
+    int code = _http.GET();
+    _lastInputMs = millis();
+    if (code == 206 && from > 0) {
+        _skip = 0;
+    } else if (code == 200) {
+        int len = _http.getSize();
+        if (from == 0) {
+            if (len <= 0) {
+                _error = "no Content-Length";
+                return false;
+            }
+            _size = (uint32_t)len;
+        }
+        _skip = from;
+    } else {
+        Serial.printf("[OTA] Pull: HTTP %d\n", code);
+        _error = "download failed";
+        return false;
+    }
+    _error = nullptr;
+    return true;
+}
+
+#endif
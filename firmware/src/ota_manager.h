@@ -1,25 +1,57 @@
 #pragma once
 
 #include "config.h"
+#include "config_manager.h"
+#include "ota_stream.h"
 
 #ifndef NATIVE_BUILD
 #include <ESPAsyncWebServer.h>
 #include <ElegantOTA.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/stream_buffer.h>
 #endif
 
-/// Manages over-the-air firmware updates via ElegantOTA.
-/// Registers the /update endpoint on the existing AsyncWebServer.
+enum class OtaState : uint8_t {
+    IDLE = 0,
+    RECEIVING,   // Chunks are being uploaded to /api/ota/chunk
+    PULLING,     // Fetching the image from a URL
+    DONE,        // Image written and verified, restarting
+    FAILED
+};
+
+/// Manages over-the-air firmware updates.
+///
+/// The web UI uploads the image (raw or gzipped, see ota_stream.h) in
+/// chunks tagged with their offset, so a transfer that drops picks up where
+/// it stopped instead of starting over. /api/ota/pull has the unit fetch
+/// an image from a URL itself, resuming with Range requests. Either way a
+/// low-priority task on core 0 inflates and writes the image; async_tcp
+/// only copies bytes into a buffer, and the control task on core 1 keeps
+/// running. ElegantOTA's /update page stays for manual uploads.
+///
+///   POST /api/ota/start?size=N[&md5=hex]   begin, or resume a same-size upload
+///   POST /api/ota/chunk?offset=N            body: image bytes from offset N
+///   POST /api/ota/pull?url=U[&md5=hex]      fetch from a URL in the background
+///   POST /api/ota/abort
+///   GET  /api/ota/status
+///
+/// Every route answers with the status JSON; "offset" is where the next
+/// chunk must start. md5 is of the decoded image, checked before it is
+/// made bootable. An https:// pull is verified against the pinned roots in
+/// notify_ca.h unless ota.insecure is set; a plain http:// pull has nothing
+/// authenticating it, so it is refused without an md5.
 class OtaManager {
 public:
     OtaManager();
 
     /// Register OTA routes on the given web server.
     /// Call once from setup() after web server is created and WiFi is up.
-    void begin(AsyncWebServer* server);
+    void begin(AsyncWebServer* server, const OtaSettings& settings);
 
-    /// Service OTA events. Call every loop().
-    /// Mostly a no-op since ElegantOTA handles updates asynchronously,
-    /// but keeps the interface consistent with other managers.
+    /// Service OTA events. Call every loop(). Restarts the unit once an
+    /// update has been written and its status had time to go out.
     void update();
 
     /// Whether an OTA update is currently in progress.
@@ -28,12 +60,67 @@ public:
     /// Progress of current update as a percentage (0-100).
     uint8_t getProgress() const;
 
+    OtaState getState() const { return _state; }
+
+    static const char* stateName(OtaState state);
+
 private:
-    bool     _updating;
-    uint8_t  _progress;
+#ifndef NATIVE_BUILD
+    void handleStart(AsyncWebServerRequest* request);
+    void handleChunkBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index);
+    void handlePull(AsyncWebServerRequest* request);
+    void handleAbort(AsyncWebServerRequest* request);
+    void sendStatus(AsyncWebServerRequest* request, int code = 200);
+
+    bool allocBuffers();
+    bool startTask(OtaState state, uint32_t size, const char* md5);
+    static void taskMain(void* arg);
+    void runUpdate();
+
+    // OtaStream callbacks
+    static int readInput(void* ctx);
+    static bool writeFlash(void* ctx, const uint8_t* data, size_t len);
+    bool refillUpload();
+    bool refillPull();
+    bool connectPull();
+#endif
+
+    bool     _updating;        // ElegantOTA /update upload in progress
+    uint8_t  _progress;        // ...and its progress
     bool     _initialized;
+    bool     _insecure;        // ota.insecure: https pulls skip certificate checks
+
+    volatile OtaState    _state;
+    volatile uint32_t    _size;       // Bytes to transfer (0 until a pull connects)
+    volatile uint32_t    _received;   // Bytes accepted so far = next chunk's offset
+    volatile uint32_t    _written;    // Decoded image bytes in flash
+    volatile bool        _abort;
+    const char* volatile _error;      // Why the last update failed
+    uint32_t             _restartAtMs;
+    volatile uint32_t    _lastInputMs;
+
+    uint8_t*   _window;
+    OtaStream* _stream;
 
 #ifndef NATIVE_BUILD
     AsyncWebServer* _server;
+    TaskHandle_t    _task;
+
+    // Uploaded bytes, async_tcp -> task
+    StreamBufferHandle_t _input;
+    StaticStreamBuffer_t _inputCtl;
+    uint8_t*             _inputStorage;
+
+    // Task's read buffer
+    uint8_t  _chunk[OTA_READ_CHUNK];
+    size_t   _chunkLen;
+    size_t   _chunkPos;
+
+    char     _url[OTA_URL_LEN];
+    char     _md5[33];
+    uint32_t _skip;              // Pull resumed without Range support: bytes to drop
+    HTTPClient       _http;
+    WiFiClient       _plain;
+    WiFiClientSecure _tls;
 #endif
 };
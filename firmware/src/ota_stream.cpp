@@ -0,0 +1,377 @@
+#include "ota_stream.h"
+#include <string.h>
+
+// Inflate follows RFC 1951 closely (in the style of zlib's puff.c): codes
+// are decoded a bit at a time against canonical code counts, which is slow
+// next to a table-driven inflater but needs under 2 KB of tables, and the
+// decoder spends most of its time waiting on Wi-Fi and flash anyway.
+
+#define OTA_WINDOW_MASK (OTA_WINDOW_SIZE - 1)
+
+static_assert((OTA_WINDOW_SIZE & OTA_WINDOW_MASK) == 0, "OTA_WINDOW_SIZE must be a power of two");
+static_assert(OTA_WINDOW_SIZE >= 32768, "Deflate distances reach back 32 KB");
+static_assert(OTA_WINDOW_SIZE % OTA_WRITE_CHUNK == 0, "Writes must not wrap the window");
+
+static const uint8_t  ESP_IMAGE_MAGIC = 0xE9;
+static const uint8_t  GZIP_ID1 = 0x1F;
+static const uint8_t  GZIP_ID2 = 0x8B;
+static const uint8_t  GZIP_CM_DEFLATE = 8;
+static const uint8_t  GZIP_FHCRC = 0x02;
+static const uint8_t  GZIP_FEXTRA = 0x04;
+static const uint8_t  GZIP_FNAME = 0x08;
+static const uint8_t  GZIP_FCOMMENT = 0x10;
+static const uint8_t  GZIP_FRESERVED = 0xE0;
+
+static const uint16_t kLenBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t kLenExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577};
+static const uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order of the code length code lengths in a dynamic block header
+static const uint8_t kCodeOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// CRC-32 (gzip polynomial), a nibble at a time
+static const uint32_t kCrcNibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+OtaStream::OtaStream(uint8_t* window)
+    : _window(window)
+    , _read(nullptr)
+    , _write(nullptr)
+    , _ctx(nullptr)
+    , _bitBuf(0)
+    , _bitCnt(0)
+    , _outPos(0)
+    , _flushed(0)
+    , _crc(0)
+    , _compressed(false)
+    , _fail(OtaStreamResult::OK)
+    , _fixedBuilt(false)
+{
+}
+
+OtaStreamResult OtaStream::run(uint32_t inputSize, OtaReadFn read, OtaWriteFn write, void* ctx) {
+    _read = read;
+    _write = write;
+    _ctx = ctx;
+    _bitBuf = 0;
+    _bitCnt = 0;
+    _outPos = 0;
+    _flushed = 0;
+    _crc = 0xFFFFFFFF;
+    _compressed = false;
+    _fail = OtaStreamResult::OK;
+    if (_window == nullptr || inputSize == 0) return OtaStreamResult::BAD_HEADER;
+
+    int first = nextByte();
+    if (first < 0) return _fail;
+    if (first == ESP_IMAGE_MAGIC) {
+        put((uint8_t)first);
+        return runRaw(inputSize - 1);
+    }
+    if (first != GZIP_ID1 || nextByte() != GZIP_ID2) {
+        return _fail != OtaStreamResult::OK ? _fail : OtaStreamResult::BAD_HEADER;
+    }
+    _compressed = true;
+    return runGzip();
+}
+
+const char* OtaStream::resultName(OtaStreamResult r) {
+    switch (r) {
+        case OtaStreamResult::OK:           return "ok";
+        case OtaStreamResult::INPUT_ENDED:  return "input ended";
+        case OtaStreamResult::BAD_HEADER:   return "not a firmware image";
+        case OtaStreamResult::BAD_DATA:     return "corrupt gzip data";
+        case OtaStreamResult::BAD_CHECKSUM: return "gzip checksum mismatch";
+        case OtaStreamResult::WRITE_FAILED: return "flash write failed";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// Raw and gzip framing
+// ---------------------------------------------------------------------------
+
+OtaStreamResult OtaStream::runRaw(uint32_t remaining) {
+    while (remaining > 0 && _fail == OtaStreamResult::OK) {
+        int b = nextByte();
+        if (b < 0) break;
+        put((uint8_t)b);
+        remaining--;
+    }
+    if (_fail == OtaStreamResult::OK) flush();
+    return _fail;
+}
+
+OtaStreamResult OtaStream::runGzip() {
+    if (!skipGzipHeader()) {
+        return _fail != OtaStreamResult::OK ? _fail : OtaStreamResult::BAD_HEADER;
+    }
+
+    bool last = false;
+    while (!last) {
+        last = bits(1) != 0;
+        uint32_t type = bits(2);
+        if (_fail != OtaStreamResult::OK) return _fail;
+        bool ok;
+        switch (type) {
+            case 0:  ok = inflateStored(); break;
+            case 1:  ok = inflateFixed(); break;
+            case 2:  ok = inflateDynamic(); break;
+            default: ok = false; break;
+        }
+        if (!ok) return _fail != OtaStreamResult::OK ? _fail : OtaStreamResult::BAD_DATA;
+    }
+    if (!flush()) return _fail;
+
+    // Trailer: CRC-32 and length (mod 2^32) of the inflated data, byte aligned
+    _bitBuf = 0;
+    _bitCnt = 0;
+    uint32_t crc = bits(16);
+    crc |= bits(16) << 16;
+    uint32_t size = bits(16);
+    size |= bits(16) << 16;
+    if (_fail != OtaStreamResult::OK) return _fail;
+    if (crc != (_crc ^ 0xFFFFFFFF) || size != _outPos) return OtaStreamResult::BAD_CHECKSUM;
+    return OtaStreamResult::OK;
+}
+
+bool OtaStream::skipGzipHeader() {
+    if (nextByte() != GZIP_CM_DEFLATE) return false;
+    int flags = nextByte();
+    if (flags < 0 || (flags & GZIP_FRESERVED)) return false;
+    for (uint8_t i = 0; i < 6; i++) nextByte();   // MTIME, XFL, OS
+    if (flags & GZIP_FEXTRA) {
+        int lo = nextByte();
+        int hi = nextByte();
+        if (hi < 0) return false;
+        for (uint16_t n = (uint16_t)(lo | (hi << 8)); n > 0; n--) {
+            if (nextByte() < 0) return false;
+        }
+    }
+    for (uint8_t field = GZIP_FNAME; field <= GZIP_FCOMMENT; field <<= 1) {
+        if (!(flags & field)) continue;
+        int b;
+        do {
+            b = nextByte();
+        } while (b > 0);
+        if (b < 0) return false;
+    }
+    if (flags & GZIP_FHCRC) {
+        nextByte();
+        nextByte();
+    }
+    return _fail == OtaStreamResult::OK;
+}
+
+// ---------------------------------------------------------------------------
+// Deflate blocks
+// ---------------------------------------------------------------------------
+
+bool OtaStream::inflateStored() {
+    _bitBuf = 0;   // Stored blocks start on a byte boundary
+    _bitCnt = 0;
+    uint32_t len = bits(16);
+    uint32_t nlen = bits(16);
+    if (_fail != OtaStreamResult::OK) return false;
+    if (len != (~nlen & 0xFFFF)) return false;
+    while (len-- > 0) {
+        int b = nextByte();
+        if (b < 0) return false;
+        put((uint8_t)b);
+        if (_fail != OtaStreamResult::OK) return false;
+    }
+    return true;
+}
+
+bool OtaStream::inflateCodes(const Huffman& lens, const Huffman& dists) {
+    for (;;) {
+        int sym = decode(lens);
+        if (sym < 0 || _fail != OtaStreamResult::OK) return false;
+        if (sym < 256) {
+            put((uint8_t)sym);
+        } else if (sym == 256) {
+            return true;
+        } else {
+            sym -= 257;
+            if (sym >= 29) return false;
+            uint32_t len = kLenBase[sym] + bits(kLenExtra[sym]);
+            int dsym = decode(dists);
+            if (dsym < 0 || dsym >= 30) return false;
+            uint32_t dist = kDistBase[dsym] + bits(kDistExtra[dsym]);
+            if (_fail != OtaStreamResult::OK) return false;
+            if (dist > _outPos) return false;   // Reaches before the start
+            while (len-- > 0) put(_window[(_outPos - dist) & OTA_WINDOW_MASK]);
+        }
+        if (_fail != OtaStreamResult::OK) return false;
+    }
+}
+
+bool OtaStream::inflateFixed() {
+    if (!_fixedBuilt) {
+        uint8_t lengths[288];
+        uint16_t sym = 0;
+        for (; sym < 144; sym++) lengths[sym] = 8;
+        for (; sym < 256; sym++) lengths[sym] = 9;
+        for (; sym < 280; sym++) lengths[sym] = 7;
+        for (; sym < 288; sym++) lengths[sym] = 8;
+        construct(_fixedLens, lengths, 288);
+        for (sym = 0; sym < 30; sym++) lengths[sym] = 5;
+        construct(_fixedDists, lengths, 30);
+        _fixedBuilt = true;
+    }
+    return inflateCodes(_fixedLens, _fixedDists);
+}
+
+bool OtaStream::inflateDynamic() {
+    uint8_t lengths[320];   // Literal/length then distance code lengths
+    uint16_t nlen = (uint16_t)(bits(5) + 257);
+    uint16_t ndist = (uint16_t)(bits(5) + 1);
+    uint16_t ncode = (uint16_t)(bits(4) + 4);
+    if (_fail != OtaStreamResult::OK || nlen > 286 || ndist > 30) return false;
+
+    // Code length code, which must be complete
+    uint16_t i = 0;
+    for (; i < ncode; i++) lengths[kCodeOrder[i]] = (uint8_t)bits(3);
+    for (; i < 19; i++) lengths[kCodeOrder[i]] = 0;
+    if (_fail != OtaStreamResult::OK || construct(_lens, lengths, 19) != 0) return false;
+
+    // Literal/length and distance code lengths, run-length coded
+    i = 0;
+    while (i < nlen + ndist) {
+        int sym = decode(_lens);
+        if (sym < 0 || _fail != OtaStreamResult::OK) return false;
+        if (sym < 16) {
+            lengths[i++] = (uint8_t)sym;
+            continue;
+        }
+        uint8_t repeat = 0;
+        uint32_t count;
+        if (sym == 16) {
+            if (i == 0) return false;   // Nothing to repeat
+            repeat = lengths[i - 1];
+            count = 3 + bits(2);
+        } else if (sym == 17) {
+            count = 3 + bits(3);
+        } else {
+            count = 11 + bits(7);
+        }
+        if (_fail != OtaStreamResult::OK || i + count > (uint32_t)(nlen + ndist)) return false;
+        while (count-- > 0) lengths[i++] = repeat;
+    }
+    if (lengths[256] == 0) return false;   // No end-of-block code
+
+    // Incomplete codes are only allowed for a single code
+    int err = construct(_lens, lengths, nlen);
+    if (err < 0 || (err > 0 && nlen - _lens.count[0] != 1)) return false;
+    err = construct(_dists, lengths + nlen, ndist);
+    if (err < 0 || (err > 0 && ndist - _dists.count[0] != 1)) return false;
+
+    return inflateCodes(_lens, _dists);
+}
+
+// ---------------------------------------------------------------------------
+// Bits and Huffman codes
+// ---------------------------------------------------------------------------
+
+int OtaStream::nextByte() {
+    if (_fail != OtaStreamResult::OK) return -1;
+    int b = _read(_ctx);
+    if (b < 0) _fail = OtaStreamResult::INPUT_ENDED;
+    return b;
+}
+
+// Deflate packs values LSB first; need is at most 16
+uint32_t OtaStream::bits(uint8_t need) {
+    uint32_t val = _bitBuf;
+    while (_bitCnt < need) {
+        int b = nextByte();
+        if (b < 0) return 0;
+        val |= (uint32_t)b << _bitCnt;
+        _bitCnt += 8;
+    }
+    _bitBuf = val >> need;
+    _bitCnt -= need;
+    return val & ((1u << need) - 1);
+}
+
+// Huffman codes are packed MSB first, so the code is built a bit at a time
+// and compared against the first code of each length
+int OtaStream::decode(const Huffman& h) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (uint8_t len = 1; len < 16; len++) {
+        code |= (int)bits(1);
+        if (_fail != OtaStreamResult::OK) return -1;
+        int count = h.count[len];
+        if (code - count < first) return h.symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;   // Ran out of codes
+}
+
+// Build a canonical code from symbol lengths. 0 for a complete code, > 0
+// for an incomplete one, < 0 if over-subscribed.
+int OtaStream::construct(Huffman& h, const uint8_t* lengths, uint16_t n) {
+    memset(h.count, 0, sizeof(h.count));
+    for (uint16_t sym = 0; sym < n; sym++) h.count[lengths[sym]]++;
+    if (h.count[0] == n) return 0;   // No codes: complete, but decode fails
+
+    int left = 1;
+    for (uint8_t len = 1; len < 16; len++) {
+        left <<= 1;
+        left -= h.count[len];
+        if (left < 0) return left;
+    }
+
+    uint16_t offs[16];
+    offs[1] = 0;
+    for (uint8_t len = 1; len < 15; len++) offs[len + 1] = offs[len] + h.count[len];
+    for (uint16_t sym = 0; sym < n; sym++) {
+        if (lengths[sym] != 0) h.symbol[offs[lengths[sym]]++] = sym;
+    }
+    return left;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+void OtaStream::put(uint8_t b) {
+    _window[_outPos & OTA_WINDOW_MASK] = b;
+    _outPos++;
+    if (_compressed) {
+        _crc ^= b;
+        _crc = (_crc >> 4) ^ kCrcNibble[_crc & 0x0F];
+        _crc = (_crc >> 4) ^ kCrcNibble[_crc & 0x0F];
+    }
+    if ((_outPos & (OTA_WRITE_CHUNK - 1)) == 0) flush();
+}
+
+// Chunks are aligned to OTA_WRITE_CHUNK, so never wrap the window
+bool OtaStream::flush() {
+    if (_fail != OtaStreamResult::OK) return false;
+    uint32_t n = _outPos - _flushed;
+    if (n == 0) return true;
+    if (!_write(_ctx, _window + (_flushed & OTA_WINDOW_MASK), n)) {
+        _fail = OtaStreamResult::WRITE_FAILED;
+        return false;
+    }
+    _flushed = _outPos;
+    return true;
+}
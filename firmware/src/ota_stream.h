@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Firmware image decoder for OTA updates. Takes the bytes of an uploaded
+// (or pulled) image one at a time and hands the flash writer the plain
+// image in OTA_WRITE_CHUNK pieces. The input is either a raw ESP32 app
+// image (first byte 0xE9) or the same image gzipped (1f 8b), which is
+// inflated on the fly: no more than the 32 KB deflate window is ever held,
+// and the gzip trailer's CRC-32 and length are checked before success.
+//
+// The decoder pulls its input, so it runs on a task that can block in the
+// read callback until the next bytes arrive. A transfer that drops and
+// resumes from the same offset just looks like a slow read.
+
+// Next input byte (0-255), or -1 once the input is gone (aborted, timed out)
+typedef int (*OtaReadFn)(void* ctx);
+
+// Image bytes out. False stops the decode (flash write failed).
+typedef bool (*OtaWriteFn)(void* ctx, const uint8_t* data, size_t len);
+
+enum class OtaStreamResult : uint8_t {
+    OK = 0,
+    INPUT_ENDED,     // Read callback gave up before the image was complete
+    BAD_HEADER,      // Neither an app image nor gzip (or unsupported gzip flags)
+    BAD_DATA,        // Corrupt deflate stream
+    BAD_CHECKSUM,    // Gzip CRC-32 or length doesn't match what was inflated
+    WRITE_FAILED     // Write callback returned false
+};
+
+class OtaStream {
+public:
+    // window: OTA_WINDOW_SIZE bytes owned by the caller (PSRAM on device)
+    explicit OtaStream(uint8_t* window);
+
+    // Decode one image. inputSize bounds a raw image's length (a gzip
+    // stream ends itself); bytes after the gzip trailer are not read.
+    OtaStreamResult run(uint32_t inputSize, OtaReadFn read, OtaWriteFn write, void* ctx);
+
+    // Image bytes handed to the write callback so far
+    uint32_t outputBytes() const { return _flushed; }
+
+    // Whether the image being decoded is gzipped (valid once run() has
+    // read the first two bytes)
+    bool compressed() const { return _compressed; }
+
+    static const char* resultName(OtaStreamResult r);
+
+private:
+    struct Huffman {
+        uint16_t count[16];    // Codes of each length (0 = unused symbols)
+        uint16_t symbol[288];  // Symbols ordered by code
+    };
+
+    OtaStreamResult runRaw(uint32_t inputSize);
+    OtaStreamResult runGzip();
+    bool skipGzipHeader();
+    bool inflateStored();
+    bool inflateCodes(const Huffman& lens, const Huffman& dists);
+    bool inflateFixed();
+    bool inflateDynamic();
+
+    int nextByte();
+    uint32_t bits(uint8_t need);
+    int decode(const Huffman& h);
+    static int construct(Huffman& h, const uint8_t* lengths, uint16_t n);
+
+    void put(uint8_t b);
+    bool flush();
+
+    uint8_t*   _window;
+    OtaReadFn  _read;
+    OtaWriteFn _write;
+    void*      _ctx;
+
+    uint32_t _bitBuf;
+    uint8_t  _bitCnt;
+    uint32_t _outPos;     // Bytes decoded
+    uint32_t _flushed;    // Bytes written
+    uint32_t _crc;
+    bool     _compressed;
+    OtaStreamResult _fail;   // First failure (OK while decoding is fine)
+
+    // Fixed Huffman tables, built on first use
+    bool    _fixedBuilt;
+    Huffman _fixedLens;
+    Huffman _fixedDists;
+    // Current dynamic block
+    Huffman _lens;
+    Huffman _dists;
+};
@@ -0,0 +1,139 @@
+#include "pid_autotune.h"
+#include <math.h>
+
+// Oscillations thrown away before measuring, while the cycle settles
+static const uint8_t AUTOTUNE_DISCARD_CYCLES = 1;
+
+PidAutoTune::PidAutoTune()
+    : _state(AutoTuneState::IDLE)
+    , _setpoint(0.0f)
+    , _bias(0.0f)
+    , _step(0.0f)
+    , _hysteresis(0.0f)
+    , _sampleMs(PID_SAMPLE_MS)
+    , _high(true)
+    , _samples(0)
+    , _lastSwitchDown(0)
+    , _haveSwitchDown(false)
+    , _phaseMax(0.0f)
+    , _phaseMin(0.0f)
+    , _lastLowMax(0.0f)
+    , _haveLowMax(false)
+    , _cycles(0)
+    , _discarded(0)
+    , _sumAmplitude(0.0f)
+    , _sumPeriodSec(0.0f)
+    , _ku(0.0f)
+    , _pu(0.0f)
+    , _kp(0.0f)
+    , _ki(0.0f)
+    , _kd(0.0f)
+{
+}
+
+void PidAutoTune::start(float setpoint, float bias, float step, float hysteresis,
+                        uint32_t sampleMs) {
+    _state      = AutoTuneState::RUNNING;
+    _setpoint   = setpoint;
+    _bias       = bias;
+    _step       = step;
+    _hysteresis = hysteresis;
+    _sampleMs   = sampleMs > 0 ? sampleMs : PID_SAMPLE_MS;
+
+    _high = true;
+    _samples = 0;
+    _lastSwitchDown = 0;
+    _haveSwitchDown = false;
+    _phaseMax = -1e9f;
+    _phaseMin = 1e9f;
+    _lastLowMax = 0.0f;
+    _haveLowMax = false;
+    _cycles = 0;
+    _discarded = 0;
+    _sumAmplitude = 0.0f;
+    _sumPeriodSec = 0.0f;
+    _ku = _pu = _kp = _ki = _kd = 0.0f;
+}
+
+void PidAutoTune::cancel() {
+    if (_state == AutoTuneState::RUNNING) {
+        _state = AutoTuneState::IDLE;
+    }
+}
+
+float PidAutoTune::update(float temp) {
+    if (_state != AutoTuneState::RUNNING) return _bias;
+
+    _samples++;
+
+    if (_high) {
+        if (temp < _phaseMin) _phaseMin = temp;
+
+        if (temp > _setpoint + _hysteresis) {
+            // High phase over: one full cycle since the previous switch-down
+            if (_haveSwitchDown && _haveLowMax) {
+                float periodSec = (float)(_samples - _lastSwitchDown) * _sampleMs / 1000.0f;
+                float amplitude = (_lastLowMax - _phaseMin) / 2.0f;
+
+                if (_discarded < AUTOTUNE_DISCARD_CYCLES) {
+                    _discarded++;
+                } else {
+                    _sumAmplitude += amplitude;
+                    _sumPeriodSec += periodSec;
+                    _cycles++;
+                }
+            }
+            _lastSwitchDown = _samples;
+            _haveSwitchDown = true;
+            _high = false;
+            _phaseMax = temp;
+
+            if (_cycles >= AUTOTUNE_CYCLES) {
+                finish();
+                return _bias;
+            }
+        }
+    } else {
+        if (temp > _phaseMax) _phaseMax = temp;
+
+        if (temp < _setpoint - _hysteresis) {
+            _lastLowMax = _phaseMax;
+            _haveLowMax = true;
+            _high = true;
+            _phaseMin = temp;
+        }
+    }
+
+    if ((uint64_t)_samples * _sampleMs >= (uint64_t)AUTOTUNE_TIMEOUT_MS) {
+        _state = AutoTuneState::FAILED;
+        return _bias;
+    }
+
+    float out = _high ? _bias + _step : _bias - _step;
+    if (out < PID_OUTPUT_MIN) out = PID_OUTPUT_MIN;
+    if (out > PID_OUTPUT_MAX) out = PID_OUTPUT_MAX;
+    return out;
+}
+
+void PidAutoTune::finish() {
+    float a  = _sumAmplitude / _cycles;
+    float pu = _sumPeriodSec / _cycles;
+
+    // Hysteresis shifts the switching point; correct the describing function
+    float a2 = a * a - _hysteresis * _hysteresis;
+    float aEff = a2 > 0.0f ? sqrtf(a2) : a;
+
+    if (aEff <= 0.0f || pu <= 0.0f) {
+        _state = AutoTuneState::FAILED;
+        return;
+    }
+
+    _ku = 4.0f * _step / ((float)M_PI * aEff);
+    _pu = pu;
+
+    // Tyreus-Luyben: Kp = Ku/2.2, Ti = 2.2 Pu, Td = Pu/6.3
+    _kp = _ku / 2.2f;
+    _ki = _kp / (2.2f * _pu);
+    _kd = _kp * (_pu / 6.3f);
+    _state = AutoTuneState::DONE;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "config.h"
+#include <stdint.h>
+
+// Relay (Åström-Hägglund) auto-tune state
+enum class AutoTuneState : uint8_t {
+    IDLE,       // Not running
+    RUNNING,    // Relay oscillation in progress
+    DONE,       // Ultimate gain/period measured, tunings available
+    FAILED      // Timed out without a stable oscillation
+};
+
+// Relay-feedback auto-tuner. Drives the output between bias-step and
+// bias+step with hysteresis around the setpoint, so the pit settles into a
+// limit cycle. The cycle's amplitude a and period Pu give the ultimate gain
+// Ku = 4*step / (pi * sqrt(a^2 - h^2)), and PID tunings follow from the
+// Tyreus-Luyben rule, which favours low overshoot on lag-dominated plants.
+//
+// update() is called once per PID sample with a fixed sampleMs spacing, so
+// the tuner needs no clock and runs the same against SimThermalModel on
+// the desktop. Pure C++ with no logging — fully testable on native and
+// built into the simulator.
+class PidAutoTune {
+public:
+    PidAutoTune();
+
+    // Begin a relay test around setpoint. Output swings bias +/- step
+    // (clamped to PID_OUTPUT_MIN..MAX); hysteresis is in temperature units.
+    void start(float setpoint, float bias, float step, float hysteresis,
+               uint32_t sampleMs);
+
+    // Feed one sample; returns the relay output to apply (0-100%).
+    float update(float temp);
+
+    // Abort a running test (state returns to IDLE)
+    void cancel();
+
+    AutoTuneState getState() const { return _state; }
+    bool isRunning() const { return _state == AutoTuneState::RUNNING; }
+    float getSetpoint() const { return _setpoint; }
+    float getBias() const { return _bias; }
+
+    // Completed, counted oscillation cycles so far
+    uint8_t getCycles() const { return _cycles; }
+
+    // Results (valid once getState() == DONE)
+    float getUltimateGain() const { return _ku; }
+    float getUltimatePeriodSec() const { return _pu; }
+    float getKp() const { return _kp; }
+    float getKi() const { return _ki; }   // Per second (PidController convention)
+    float getKd() const { return _kd; }   // Seconds
+
+private:
+    void finish();
+
+    AutoTuneState _state;
+    float    _setpoint;
+    float    _bias;
+    float    _step;
+    float    _hysteresis;
+    uint32_t _sampleMs;
+
+    bool     _high;             // Relay currently at bias + step
+    uint32_t _samples;          // Samples since start()
+    uint32_t _lastSwitchDown;   // Sample index of the previous high->low switch
+    bool     _haveSwitchDown;
+    float    _phaseMax;         // Highest temp seen in the current low phase
+    float    _phaseMin;         // Lowest temp seen in the current high phase
+    float    _lastLowMax;       // Peak of the most recent completed low phase
+    bool     _haveLowMax;
+
+    uint8_t  _cycles;           // Counted (post-discard) cycles
+    uint8_t  _discarded;        // Start-up cycles thrown away
+    float    _sumAmplitude;
+    float    _sumPeriodSec;
+
+    float _ku, _pu;
+    float _kp, _ki, _kd;
+};
@@ -1,4 +1,6 @@
 #include "pid_controller.h"
+#include <math.h>
+#include <string.h>
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
@@ -8,15 +10,32 @@ PidController::PidController()
     : _kp(PID_KP)
     , _ki(PID_KI)
     , _kd(PID_KD)
-    , _pidInput(0.0f)
+    , _feedForward(PID_FEEDFORWARD)
+    , _schedule(pidScheduleDefaults())
+    , _fanMode(FAN_MODE_DEFAULT)
+    , _gainScale(1.0f)
+    , _scaleSetpoint(-1.0f)
     , _pidOutput(0.0f)
-    , _pidSetpoint(0.0f)
-#ifndef NATIVE_BUILD
-    , _pid(nullptr)
-#endif
+    , _outputSum(0.0f)
+    , _lastInput(0.0f)
+    , _haveLastInput(false)
+    , _dTerm(0.0f)
+    , _sampleMs(PID_SAMPLE_MS)
+    , _dFilterN(PID_D_FILTER_N)
     , _lidState(LidState::CLOSED)
     , _enabled(true)
-    , _lastComputeMs(0)
+    , _lidArmed(false)
+    , _prevTemp(0.0f)
+    , _havePrevTemp(false)
+    , _fastDropCount(0)
+    , _dropStartOutput(0.0f)
+    , _lidHoldOutput(0.0f)
+    , _lidTrough(0.0f)
+    , _lidSamples(0)
+    , _lidRecoverSamples(0)
+    , _lidTauSec(LID_RECOVERY_TAU_S)
+    , _lidEventsLearned(0)
+    , _autoTuneResultPending(false)
 {
 }
 
@@ -28,33 +47,31 @@ void PidController::begin(float kp, float ki, float kd) {
     _kp = kp;
     _ki = ki;
     _kd = kd;
-    _pidInput = 0.0f;
     _pidOutput = 0.0f;
-    _pidSetpoint = 0.0f;
+    reseed(0.0f);
     _lidState = LidState::CLOSED;
     _enabled = true;
+    _lidArmed = false;
+    _havePrevTemp = false;
+    _fastDropCount = 0;
+    resetLidModel();
+    _autoTune.cancel();
+    _autoTuneResultPending = false;
 
 #ifndef NATIVE_BUILD
-    if (_pid != nullptr) {
-        delete _pid;
-    }
-
-    _pid = new QuickPID(&_pidInput, &_pidOutput, &_pidSetpoint,
-                        _kp, _ki, _kd,
-                        QuickPID::pMode::pOnMeas,
-                        QuickPID::dMode::dOnMeas,
-                        QuickPID::iAwMode::iAwCondition,
-                        QuickPID::Action::direct);
-
-    _pid->SetOutputLimits(PID_OUTPUT_MIN, PID_OUTPUT_MAX);
-    _pid->SetSampleTimeUs(PID_SAMPLE_MS * 1000UL);
-    _pid->SetMode(QuickPID::Control::automatic);
+    Serial.printf("[PID] Initialized: Kp=%.2f Ki=%.3f Kd=%.2f, interval=%lums, D filter N=%.0f\n",
+                  _kp, _ki, _kd, (unsigned long)_sampleMs, _dFilterN);
+#endif
+}
 
-    _lastComputeMs = millis();
+void PidController::setSampleMs(uint32_t ms) {
+    if (ms < PID_SAMPLE_MS_MIN) ms = PID_SAMPLE_MS_MIN;
+    if (ms > PID_SAMPLE_MS_MAX) ms = PID_SAMPLE_MS_MAX;
+    _sampleMs = ms;
+}
 
-    Serial.printf("[PID] Initialized: Kp=%.2f Ki=%.3f Kd=%.2f, interval=%dms\n",
-                  _kp, _ki, _kd, PID_SAMPLE_MS);
-#endif
+void PidController::setDerivativeFilter(float n) {
+    _dFilterN = n > 0.0f ? n : 0.0f;
 }
 
 float PidController::compute(float currentTemp, float setpoint) {
@@ -63,31 +80,79 @@ float PidController::compute(float currentTemp, float setpoint) {
         return 0.0f;
     }
 
+    if (_autoTune.isRunning()) {
+        // A new setpoint invalidates the test
+        if (setpoint != _autoTune.getSetpoint()) {
+            cancelAutoTune();
+        } else {
+            _pidOutput = _autoTune.update(currentTemp);
+            if (!_autoTune.isRunning()) finishAutoTune();
+            return _pidOutput;
+        }
+    }
+
     // Update lid-open detection
     updateLidState(currentTemp, setpoint);
 
-    // If lid is open, suspend PID output
-    if (_lidState == LidState::OPEN) {
-        _pidOutput = 0.0f;
-        return 0.0f;
+    // Through a lid event, hold the output from before the drop
+    if (_lidState != LidState::CLOSED) {
+        _pidOutput = _lidHoldOutput;
+        return _pidOutput;
     }
 
-#ifndef NATIVE_BUILD
-    unsigned long now = millis();
+    updateGainScale(setpoint);
+    _pidOutput = pidStep(currentTemp, setpoint);
+    return _pidOutput;
+}
 
-    // QuickPID manages its own sample timing internally, but we feed it
-    // current values each call
-    _pidInput = currentTemp;
-    _pidSetpoint = setpoint;
+float PidController::pidStep(float input, float setpoint) {
+    const float dt = _sampleMs / 1000.0f;
+    const float kp = _kp * _gainScale;
+    const float ki = _ki * _gainScale;
+    const float kd = _kd * _gainScale;
 
-    _pid->Compute();
+    float dInput = _haveLastInput ? input - _lastInput : 0.0f;
+    _lastInput = input;
+    _haveLastInput = true;
 
-    // Clamp output to 0-100%
-    if (_pidOutput < PID_OUTPUT_MIN) _pidOutput = PID_OUTPUT_MIN;
-    if (_pidOutput > PID_OUTPUT_MAX) _pidOutput = PID_OUTPUT_MAX;
-#endif
+    // Proportional on measurement: no kick on setpoint steps, and the P
+    // action accumulates in the sum alongside the integral
+    _outputSum -= kp * dInput;
 
-    return _pidOutput;
+    // Integral with conditional anti-windup: don't integrate further into
+    // a saturated output
+    float error = setpoint - input;
+    float iTerm = ki * error * dt;
+    bool windingUp   = _outputSum >= PID_OUTPUT_MAX && iTerm > 0.0f;
+    bool windingDown = _outputSum <= PID_OUTPUT_MIN && iTerm < 0.0f;
+    if (!windingUp && !windingDown) _outputSum += iTerm;
+
+    if (_outputSum < PID_OUTPUT_MIN) _outputSum = PID_OUTPUT_MIN;
+    if (_outputSum > PID_OUTPUT_MAX) _outputSum = PID_OUTPUT_MAX;
+
+    // Derivative on measurement through a first-order low-pass, so probe
+    // noise at short sample intervals doesn't chatter the fan
+    float rawD = -kd * dInput / dt;
+    if (_dFilterN > 0.0f && kp > 0.0f && kd > 0.0f) {
+        float tf = (kd / kp) / _dFilterN;
+        float alpha = tf / (tf + dt);
+        _dTerm = alpha * _dTerm + (1.0f - alpha) * rawD;
+    } else {
+        _dTerm = rawD;
+    }
+
+    float out = _outputSum + _dTerm;
+    if (out < PID_OUTPUT_MIN) out = PID_OUTPUT_MIN;
+    if (out > PID_OUTPUT_MAX) out = PID_OUTPUT_MAX;
+    return out;
+}
+
+void PidController::reseed(float output) {
+    if (output < PID_OUTPUT_MIN) output = PID_OUTPUT_MIN;
+    if (output > PID_OUTPUT_MAX) output = PID_OUTPUT_MAX;
+    _outputSum = output;
+    _dTerm = 0.0f;
+    _haveLastInput = false;
 }
 
 float PidController::getOutput() const {
@@ -100,36 +165,139 @@ void PidController::setTunings(float kp, float ki, float kd) {
     _kd = kd;
 
 #ifndef NATIVE_BUILD
-    if (_pid != nullptr) {
-        _pid->SetTunings(_kp, _ki, _kd);
-    }
-    Serial.printf("[PID] Tunings updated: Kp=%.2f Ki=%.3f Kd=%.2f\n", _kp, _ki, _kd);
+    Serial.printf("[PID] Tunings updated: Kp=%.2f Ki=%.3f Kd=%.2f (scale %.2f)\n",
+                  _kp, _ki, _kd, _gainScale);
+#endif
+}
+
+void PidController::setFeedForward(float pctPerDegree) {
+    _feedForward = pctPerDegree > 0.0f ? pctPerDegree : 0.0f;
+}
+
+void PidController::setSchedule(const PidSchedule& schedule) {
+    _schedule = schedule;
+    if (_schedule.bandCount > PID_SCHEDULE_MAX_BANDS) _schedule.bandCount = PID_SCHEDULE_MAX_BANDS;
+    _scaleSetpoint = -1.0f;   // Re-evaluate on the next compute
+}
+
+void PidController::setFanMode(FanMode mode) {
+    if (mode == _fanMode) return;
+    _fanMode = mode;
+    _scaleSetpoint = -1.0f;
+}
+
+void PidController::updateGainScale(float setpoint) {
+    if (setpoint == _scaleSetpoint) return;
+    _scaleSetpoint = setpoint;
+
+    float scale = pidScheduleScale(_schedule, setpoint, _fanMode);
+    if (scale == _gainScale) return;
+    _gainScale = scale;
+
+#ifndef NATIVE_BUILD
+    Serial.printf("[PID] Gain scale %.2f (sp=%.0f, %s)\n", _gainScale, setpoint, fanModeName(_fanMode));
 #endif
 }
 
 void PidController::resetIntegrator() {
+    if (_autoTune.isRunning()) return;  // The relay owns the output until the test ends
+
+    _outputSum = 0.0f;
+    _dTerm = 0.0f;
 #ifndef NATIVE_BUILD
-    if (_pid != nullptr) {
-        _pid->Reset();
-        _pid->SetMode(QuickPID::Control::automatic);
-    }
     Serial.println("[PID] Integrator reset (setpoint change)");
 #endif
 }
 
+void PidController::stepSetpoint(float from, float to) {
+    if (_autoTune.isRunning()) return;
+    if (to > from) _lidArmed = false;   // The climb to the new setpoint is not a lid event
+
+    if (_feedForward <= 0.0f || from <= 0.0f || _lidState != LidState::CLOSED) {
+        resetIntegrator();
+        return;
+    }
+
+    updateGainScale(to);
+
+    float out = _pidOutput + _feedForward * (to - from);
+    if (out < PID_OUTPUT_MIN) out = PID_OUTPUT_MIN;
+    if (out > PID_OUTPUT_MAX) out = PID_OUTPUT_MAX;
+    _pidOutput = out;
+    _outputSum = out - _dTerm;
+
+#ifndef NATIVE_BUILD
+    Serial.printf("[PID] Setpoint %.0f -> %.0f, feed-forward output %.1f%%\n", from, to, out);
+#endif
+}
+
 bool PidController::isLidOpen() const {
-    return _lidState == LidState::OPEN;
+    return _lidState != LidState::CLOSED;
+}
+
+void PidController::resetLidModel() {
+    _lidTauSec = LID_RECOVERY_TAU_S;
+    _lidEventsLearned = 0;
+}
+
+PidSnapshot PidController::snapshot() const {
+    PidSnapshot s;
+    memset(&s, 0, sizeof(s));
+    s.outputSum         = _outputSum;
+    s.pidOutput         = _pidOutput;
+    s.lastInput         = _lastInput;
+    s.dTerm             = _dTerm;
+    s.prevTemp          = _prevTemp;
+    s.dropStartOutput   = _dropStartOutput;
+    s.lidHoldOutput     = _lidHoldOutput;
+    s.lidTrough         = _lidTrough;
+    s.lidTauSec         = _lidTauSec;
+    s.lidSamples        = _lidSamples;
+    s.lidRecoverSamples = _lidRecoverSamples;
+    s.lidState          = (uint8_t)_lidState;
+    s.lidEventsLearned  = _lidEventsLearned;
+    s.fastDropCount     = _fastDropCount;
+    if (_haveLastInput) s.flags |= PID_SNAP_HAVE_INPUT;
+    if (_havePrevTemp)  s.flags |= PID_SNAP_HAVE_PREV;
+    if (_lidArmed)      s.flags |= PID_SNAP_LID_ARMED;
+    return s;
+}
+
+void PidController::restore(const PidSnapshot& s) {
+    _autoTune.cancel();
+    _autoTuneResultPending = false;
+
+    _outputSum         = s.outputSum;
+    _pidOutput         = s.pidOutput;
+    _lastInput         = s.lastInput;
+    _dTerm             = s.dTerm;
+    _prevTemp          = s.prevTemp;
+    _dropStartOutput   = s.dropStartOutput;
+    _lidHoldOutput     = s.lidHoldOutput;
+    _lidTrough         = s.lidTrough;
+    _lidTauSec         = s.lidTauSec;
+    _lidSamples        = s.lidSamples;
+    _lidRecoverSamples = s.lidRecoverSamples;
+    _lidState          = s.lidState <= (uint8_t)LidState::RECOVERING
+                             ? (LidState)s.lidState : LidState::CLOSED;
+    _lidEventsLearned  = s.lidEventsLearned;
+    _fastDropCount     = s.fastDropCount;
+    _haveLastInput     = (s.flags & PID_SNAP_HAVE_INPUT) != 0;
+    _havePrevTemp      = (s.flags & PID_SNAP_HAVE_PREV) != 0;
+    _lidArmed          = (s.flags & PID_SNAP_LID_ARMED) != 0;
+
+    // A corrupt-but-CRC-valid image can't push the actuators out of range
+    if (_outputSum < PID_OUTPUT_MIN) _outputSum = PID_OUTPUT_MIN;
+    if (_outputSum > PID_OUTPUT_MAX) _outputSum = PID_OUTPUT_MAX;
+    if (_pidOutput < PID_OUTPUT_MIN) _pidOutput = PID_OUTPUT_MIN;
+    if (_pidOutput > PID_OUTPUT_MAX) _pidOutput = PID_OUTPUT_MAX;
 }
 
 void PidController::setEnabled(bool enabled) {
+    if (!enabled) cancelAutoTune();
+    if (enabled && !_enabled) reseed(_pidOutput);  // Resume from the parked output
     _enabled = enabled;
 
-#ifndef NATIVE_BUILD
-    if (_pid != nullptr) {
-        _pid->SetMode(enabled ? QuickPID::Control::automatic : QuickPID::Control::manual);
-    }
-#endif
-
     if (!enabled) {
         _pidOutput = 0.0f;
     }
@@ -139,33 +307,191 @@ bool PidController::isEnabled() const {
     return _enabled;
 }
 
+void PidController::startAutoTune(float setpoint) {
+    if (!_enabled || setpoint <= 0.0f) return;
+
+    _lidState = LidState::CLOSED;  // Relay swings would look like lid events
+    _autoTuneResultPending = false;
+    updateGainScale(setpoint);     // Result is de-scaled with this band's scale
+    _autoTune.start(setpoint, AUTOTUNE_OUTPUT_BIAS, AUTOTUNE_OUTPUT_STEP,
+                    AUTOTUNE_HYSTERESIS, _sampleMs);
+
+#ifndef NATIVE_BUILD
+    Serial.printf("[PID] Auto-tune started: sp=%.0f, output %.0f +/- %.0f%%\n",
+                  setpoint, (float)AUTOTUNE_OUTPUT_BIAS, (float)AUTOTUNE_OUTPUT_STEP);
+#endif
+}
+
+void PidController::cancelAutoTune() {
+    if (!_autoTune.isRunning()) return;
+    _autoTune.cancel();
+    finishAutoTune();
+}
+
+bool PidController::isAutoTuning() const {
+    return _autoTune.isRunning();
+}
+
+AutoTuneState PidController::getAutoTuneState() const {
+    return _autoTune.getState();
+}
+
+bool PidController::takeAutoTuneResult(float& kp, float& ki, float& kd) {
+    if (!_autoTuneResultPending) return false;
+    _autoTuneResultPending = false;
+    kp = _kp;
+    ki = _ki;
+    kd = _kd;
+    return true;
+}
+
+void PidController::finishAutoTune() {
+    if (_autoTune.getState() == AutoTuneState::DONE) {
+#ifndef NATIVE_BUILD
+        Serial.printf("[PID] Auto-tune done: Ku=%.2f Pu=%.0fs\n",
+                      _autoTune.getUltimateGain(), _autoTune.getUltimatePeriodSec());
+#endif
+        // The relay measured the loop as scheduled; store base tunings
+        setTunings(_autoTune.getKp() / _gainScale,
+                   _autoTune.getKi() / _gainScale,
+                   _autoTune.getKd() / _gainScale);
+        _autoTuneResultPending = true;
+    } else {
+#ifndef NATIVE_BUILD
+        Serial.printf("[PID] Auto-tune %s, keeping current tunings\n",
+                      _autoTune.getState() == AutoTuneState::FAILED ? "failed" : "cancelled");
+#endif
+    }
+
+    // Resume from the relay centre so the hand-back is bumpless
+    _pidOutput = _autoTune.getBias();
+    reseed(_pidOutput);
+}
+
 void PidController::updateLidState(float currentTemp, float setpoint) {
     if (setpoint <= 0.0f) return;  // No setpoint, no lid detection
 
+    const float sampleSec = _sampleMs / 1000.0f;
+    float ratePerMin = _havePrevTemp ? (currentTemp - _prevTemp) * 60.0f / sampleSec : 0.0f;
+    _prevTemp = currentTemp;
+    _havePrevTemp = true;
+
+    // Opening the lid dumps heat far faster than the fire ever changes it
+    bool fastDrop = ratePerMin <= -LID_DROP_RATE;
+    if (fastDrop) {
+        if (_fastDropCount == 0) _dropStartOutput = _pidOutput;
+        if (_fastDropCount < 255) _fastDropCount++;
+    } else {
+        _fastDropCount = 0;
+    }
+
     float dropThreshold = setpoint * (1.0f - LID_OPEN_DROP_PCT / 100.0f);
     float recoverThreshold = setpoint * (1.0f - LID_OPEN_RECOVER_PCT / 100.0f);
+    bool timedOut = (uint64_t)_lidSamples * _sampleMs >= (uint64_t)LID_EVENT_TIMEOUT_MS;
+
+    // A cold start or a raised setpoint is below the drop threshold too;
+    // only a pit that has been up to temperature can lose it to the lid
+    if (currentTemp >= recoverThreshold) _lidArmed = true;
 
     switch (_lidState) {
-        case LidState::CLOSED:
-            // Detect lid open: temp drops more than LID_OPEN_DROP_PCT below setpoint
-            if (currentTemp < dropThreshold) {
+        case LidState::CLOSED: {
+            // Detect lid open: a sustained fast fall below setpoint, or (as a
+            // backstop) temp more than LID_OPEN_DROP_PCT below setpoint
+            bool falling = _fastDropCount >= 2 && currentTemp < setpoint - LID_DROP_MIN_DEG;
+            if (falling || (_lidArmed && currentTemp < dropThreshold)) {
                 _lidState = LidState::OPEN;
+                _lidHoldOutput = _fastDropCount > 0 ? _dropStartOutput : _pidOutput;
+                _lidTrough = currentTemp;
+                _lidSamples = 0;
+                _lidRecoverSamples = 0;
 #ifndef NATIVE_BUILD
-                Serial.printf("[PID] Lid-open detected! Temp=%.1f, threshold=%.1f\n",
-                              currentTemp, dropThreshold);
+                Serial.printf("[PID] Lid-open detected! Temp=%.1f, rate=%.0f/min, holding %.0f%%\n",
+                              currentTemp, ratePerMin, _lidHoldOutput);
 #endif
             }
             break;
+        }
 
         case LidState::OPEN:
-            // Recover: temp comes back within LID_OPEN_RECOVER_PCT of setpoint
+            _lidSamples++;
+            if (currentTemp < _lidTrough) _lidTrough = currentTemp;
+
+            if (currentTemp >= recoverThreshold) {
+                endLidEvent(currentTemp, setpoint, false);
+            } else if (ratePerMin > 0.0f) {
+                // Lid closed: the fall has turned around
+                _lidState = LidState::RECOVERING;
+                _lidRecoverSamples = 1;   // This sample is already one past the trough
+#ifndef NATIVE_BUILD
+                Serial.printf("[PID] Lid closed at %.1f, expecting recovery tau=%.0fs\n",
+                              _lidTrough, _lidTauSec);
+#endif
+            } else if (timedOut) {
+                endLidEvent(currentTemp, setpoint, false);
+            }
+            break;
+
+        case LidState::RECOVERING: {
+            _lidSamples++;
+            _lidRecoverSamples++;
+
+            if (_fastDropCount >= 2) {
+                _lidState = LidState::OPEN;  // Opened again
+                if (currentTemp < _lidTrough) _lidTrough = currentTemp;
+                break;
+            }
+            if (currentTemp < _lidTrough) {
+                _lidTrough = currentTemp;
+                _lidRecoverSamples = 0;
+            }
+
             if (currentTemp >= recoverThreshold) {
-                _lidState = LidState::CLOSED;
+                endLidEvent(currentTemp, setpoint, true);
+                break;
+            }
+
+            // Natural recovery: first-order return from the trough
+            float depth = setpoint - _lidTrough;
+            float elapsed = _lidRecoverSamples * sampleSec;
+            float predicted = setpoint - depth * expf(-elapsed / _lidTauSec);
+            float allowedLag = fmaxf((float)LID_DROP_MIN_DEG, depth * LID_RECOVERY_LAG_FRAC);
+
+            if (currentTemp < predicted - allowedLag) {
 #ifndef NATIVE_BUILD
-                Serial.printf("[PID] Lid-open recovery. Temp=%.1f, threshold=%.1f\n",
-                              currentTemp, recoverThreshold);
+                Serial.printf("[PID] Lid recovery behind prediction (%.1f < %.1f), PID resuming\n",
+                              currentTemp, predicted);
 #endif
+                endLidEvent(currentTemp, setpoint, false);
+            } else if (timedOut) {
+                endLidEvent(currentTemp, setpoint, false);
             }
             break;
+        }
+    }
+}
+
+void PidController::endLidEvent(float currentTemp, float setpoint, bool learn) {
+    if (learn) {
+        // Solve remaining = depth * exp(-t / tau) for this event's tau
+        float depth = setpoint - _lidTrough;
+        float remaining = fmaxf(setpoint - currentTemp, 0.5f);
+        float elapsed = _lidRecoverSamples * (_sampleMs / 1000.0f);
+        if (depth > remaining && elapsed > 0.0f) {
+            float tau = elapsed / logf(depth / remaining);
+            if (tau < LID_RECOVERY_TAU_MIN_S) tau = LID_RECOVERY_TAU_MIN_S;
+            if (tau > LID_RECOVERY_TAU_MAX_S) tau = LID_RECOVERY_TAU_MAX_S;
+            _lidTauSec = (_lidEventsLearned == 0) ? tau : 0.5f * (_lidTauSec + tau);
+            if (_lidEventsLearned < 255) _lidEventsLearned++;
+        }
     }
+
+    _lidState = LidState::CLOSED;
+    _fastDropCount = 0;
+    _pidOutput = _lidHoldOutput;
+    reseed(_lidHoldOutput);
+
+#ifndef NATIVE_BUILD
+    Serial.printf("[PID] Lid-open recovery. Temp=%.1f, tau=%.0fs (%u learned)\n",
+                  currentTemp, _lidTauSec, _lidEventsLearned);
+#endif
 }
@@ -1,18 +1,42 @@
 #pragma once
 
 #include "config.h"
+#include "pid_autotune.h"
+#include "pid_schedule.h"
 #include <stdint.h>
 
-#ifndef NATIVE_BUILD
-#include <QuickPID.h>
-#endif
-
 // Lid-open state machine
 enum class LidState : uint8_t {
     CLOSED,     // Normal operation
-    OPEN        // Lid detected open, PID output suspended
+    OPEN,       // Lid detected open, pre-event output held
+    RECOVERING  // Lid closed again, pit recovering on the held output
+};
+
+// Everything compute() carries from one sample to the next, so a warm
+// restart can resume mid-cook without re-winding the integrator. Tunings,
+// schedule and fan mode come from config and aren't included.
+struct PidSnapshot {
+    float    outputSum;
+    float    pidOutput;
+    float    lastInput;
+    float    dTerm;
+    float    prevTemp;
+    float    dropStartOutput;
+    float    lidHoldOutput;
+    float    lidTrough;
+    float    lidTauSec;
+    uint32_t lidSamples;
+    uint32_t lidRecoverSamples;
+    uint8_t  lidState;          // LidState
+    uint8_t  lidEventsLearned;
+    uint8_t  fastDropCount;
+    uint8_t  flags;             // PID_SNAP_* bits
 };
 
+#define PID_SNAP_HAVE_INPUT  0x01
+#define PID_SNAP_HAVE_PREV   0x02
+#define PID_SNAP_LID_ARMED   0x04
+
 class PidController {
 public:
     PidController();
@@ -23,49 +47,147 @@ public:
     // Initialize PID with custom tunings
     void begin(float kp, float ki, float kd);
 
-    // Run one PID computation if the sample interval has elapsed.
-    // Returns the PID output (0-100%). Handles lid-open detection internally.
+    // Run one PID step. Call once every getSampleMs(); the math assumes
+    // that spacing. Returns the PID output (0-100%). Handles lid-open
+    // detection internally.
     float compute(float currentTemp, float setpoint);
 
+    // PID sample interval, clamped to PID_SAMPLE_MS_MIN..PID_SAMPLE_MS_MAX.
+    // Tunings keep their meaning across rates (Ki per second, Kd seconds).
+    void setSampleMs(uint32_t ms);
+    uint32_t getSampleMs() const { return _sampleMs; }
+
+    // Derivative low-pass: the D term is filtered with time constant
+    // (Kd/Kp)/N. Higher N = less filtering; 0 disables the filter.
+    void setDerivativeFilter(float n);
+    float getDerivativeFilter() const { return _dFilterN; }
+
     // PID output in the range [0..100] percent
     float getOutput() const;
 
-    // Update tuning parameters at runtime
+    // Update tuning parameters at runtime. These are the base tunings;
+    // the gain schedule scales them before they reach the PID.
     void setTunings(float kp, float ki, float kd);
 
-    // Get current tuning values
+    // Get current (base) tuning values
     float getKp() const { return _kp; }
     float getKi() const { return _ki; }
     float getKd() const { return _kd; }
 
-    // Lid-open detection
-    bool isLidOpen() const;
+    // Lid-open detection. A lid event is detected from a fast fall (or,
+    // as a backstop once the pit has come up to setpoint, a
+    // LID_OPEN_DROP_PCT drop below it). The output
+    // before the drop is held through the event, and the pit is left to
+    // recover along the curve learned from earlier events this session;
+    // the PID only takes over early if recovery falls behind it.
+    bool isLidOpen() const;            // OPEN or RECOVERING
+    LidState getLidState() const { return _lidState; }
+
+    // Recovery time constant predicted for the next lid event (seconds)
+    float getLidRecoveryTau() const { return _lidTauSec; }
+    uint8_t getLidEventsLearned() const { return _lidEventsLearned; }
+
+    // Forget learned lid recoveries (new cook session)
+    void resetLidModel();
 
     // Reset integrator for bumpless transfer on setpoint change
     void resetIntegrator();
 
+    // Setpoint change with feed-forward: preload the output with
+    // feedForward * (to - from) on top of the current output, so the pit
+    // heads straight for the new steady state instead of waiting on the
+    // integrator. Falls back to resetIntegrator() when feed-forward is off.
+    void stepSetpoint(float from, float to);
+
+    // Feed-forward slope, % output per degree of setpoint step (0 = off)
+    void setFeedForward(float pctPerDegree);
+    float getFeedForward() const { return _feedForward; }
+
+    // Gain schedule by setpoint band and fan mode
+    void setSchedule(const PidSchedule& schedule);
+    const PidSchedule& getSchedule() const { return _schedule; }
+    void setFanMode(FanMode mode);
+
+    // Multiplier currently applied to the base tunings
+    float getGainScale() const { return _gainScale; }
+
+    // Capture or resume the running state (warm restart). restore()
+    // cancels any auto-tune and keeps the current tunings.
+    PidSnapshot snapshot() const;
+    void restore(const PidSnapshot& s);
+
     // Enable or disable PID computation
     void setEnabled(bool enabled);
     bool isEnabled() const;
 
+    // Relay auto-tune. While running, compute() returns the relay output
+    // instead of the PID output. On success the measured tunings are
+    // applied and held for takeAutoTuneResult(); changing the setpoint
+    // or disabling the controller cancels the test.
+    void startAutoTune(float setpoint);
+    void cancelAutoTune();
+    bool isAutoTuning() const;
+    AutoTuneState getAutoTuneState() const;
+
+    // One-shot: true (and the new tunings) the first time it is called
+    // after an auto-tune completes, so the caller can persist them.
+    bool takeAutoTuneResult(float& kp, float& ki, float& kd);
+
 private:
     // Check lid-open condition and update state
     void updateLidState(float currentTemp, float setpoint);
 
-    float _kp, _ki, _kd;
+    // Leave a lid event and hand the held output back to the PID bumplessly.
+    // learn: the pit recovered on its own, fold the recovery into the model.
+    void endLidEvent(float currentTemp, float setpoint, bool learn);
 
-    // QuickPID uses float references for input/output/setpoint
-    float _pidInput;
-    float _pidOutput;
-    float _pidSetpoint;
+    // Apply a finished (or cancelled) auto-tune and hand back to the PID
+    void finishAutoTune();
+
+    // Re-evaluate the schedule for a setpoint
+    void updateGainScale(float setpoint);
+
+    // One step of the PID math with the scheduled gains
+    float pidStep(float input, float setpoint);
+
+    // Restart the PID from a given output: the integrator carries it and
+    // the next sample re-seeds the derivative, so there is no kick
+    void reseed(float output);
+
+    float _kp, _ki, _kd;
 
-#ifndef NATIVE_BUILD
-    QuickPID* _pid;
-#endif
+    float       _feedForward;
+    PidSchedule _schedule;
+    FanMode     _fanMode;
+    float       _gainScale;
+    float       _scaleSetpoint;     // Setpoint _gainScale was computed for
+
+    // PID state. Proportional-on-measurement folds the P term into
+    // _outputSum, so the sum alone is the bumpless output.
+    float    _pidOutput;
+    float    _outputSum;
+    float    _lastInput;
+    bool     _haveLastInput;
+    float    _dTerm;             // Filtered derivative-on-measurement
+    uint32_t _sampleMs;
+    float    _dFilterN;
 
     LidState _lidState;
     bool _enabled;
 
-    // Timing
-    unsigned long _lastComputeMs;
+    // Lid event tracking (one entry per compute() sample)
+    bool     _lidArmed;          // Pit has reached setpoint; threshold backstop active
+    float    _prevTemp;
+    bool     _havePrevTemp;
+    uint8_t  _fastDropCount;     // Consecutive samples falling faster than LID_DROP_RATE
+    float    _dropStartOutput;   // Output when the current fast fall began
+    float    _lidHoldOutput;     // Pre-event output held through the event
+    float    _lidTrough;         // Lowest temp of the event
+    uint32_t _lidSamples;        // Samples since the event began
+    uint32_t _lidRecoverSamples; // Samples since the trough
+    float    _lidTauSec;         // Predicted recovery time constant
+    uint8_t  _lidEventsLearned;
+
+    PidAutoTune _autoTune;
+    bool _autoTuneResultPending;
 };
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "config.h"
+#include "fan_mode.h"
+#include <stdint.h>
+#include <string.h>
+
+// One setpoint band of the gain schedule: setpoints up to maxSetpoint use
+// the base tunings multiplied by scale.
+struct PidGainBand {
+    float maxSetpoint;
+    float scale;
+};
+
+// Gain schedule applied on top of the base Kp/Ki/Kd. The pit's gain (degrees
+// per % output) rises with temperature and with actuator authority, so a
+// single set of tunings is either sluggish at 225 or twitchy at 350. Bands
+// are ascending by maxSetpoint; the last band catches everything above.
+struct PidSchedule {
+    bool        enabled;
+    uint8_t     bandCount;
+    PidGainBand bands[PID_SCHEDULE_MAX_BANDS];
+    float       fanOnlyScale;
+    float       fanAndDamperScale;
+    float       damperPrimaryScale;
+};
+
+// Defaults from config.h
+inline PidSchedule pidScheduleDefaults() {
+    PidSchedule s;
+    memset(&s, 0, sizeof(s));
+    s.enabled   = true;
+    s.bandCount = 3;
+    s.bands[0]  = { (float)PID_BAND1_MAX_SP, (float)PID_BAND1_SCALE };
+    s.bands[1]  = { (float)PID_BAND2_MAX_SP, (float)PID_BAND2_SCALE };
+    s.bands[2]  = { 1000.0f,                 (float)PID_BAND3_SCALE };
+    s.fanOnlyScale       = PID_SCALE_FAN_ONLY;
+    s.fanAndDamperScale  = PID_SCALE_FAN_AND_DAMPER;
+    s.damperPrimaryScale = PID_SCALE_DAMPER_PRIMARY;
+    return s;
+}
+
+// Index of the band a setpoint falls in (0 when the schedule has no bands)
+inline uint8_t pidScheduleBand(const PidSchedule& s, float setpoint) {
+    if (s.bandCount == 0) return 0;
+    for (uint8_t i = 0; i + 1 < s.bandCount; i++) {
+        if (setpoint <= s.bands[i].maxSetpoint) return i;
+    }
+    return s.bandCount - 1;
+}
+
+// Gain multiplier for a setpoint and fan mode. 1.0 when the schedule is
+// disabled.
+inline float pidScheduleScale(const PidSchedule& s, float setpoint, FanMode fanMode) {
+    if (!s.enabled) return 1.0f;
+
+    float scale = s.bandCount > 0 ? s.bands[pidScheduleBand(s, setpoint)].scale : 1.0f;
+
+    switch (fanMode) {
+        case FanMode::FAN_ONLY:       scale *= s.fanOnlyScale; break;
+        case FanMode::DAMPER_PRIMARY: scale *= s.damperPrimaryScale; break;
+        default:                      scale *= s.fanAndDamperScale; break;
+    }
+
+    return scale > 0.0f ? scale : 1.0f;
+}
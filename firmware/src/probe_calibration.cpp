@@ -0,0 +1,265 @@
+#include "probe_calibration.h"
+#include "units.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Solver
+// ---------------------------------------------------------------------------
+
+// Solve m * x = y for 3x3 m by Gaussian elimination with partial pivoting.
+// False if m is singular.
+static bool solve3(double m[3][3], double y[3], double x[3]) {
+    for (uint8_t col = 0; col < 3; col++) {
+        uint8_t pivot = col;
+        for (uint8_t r = col + 1; r < 3; r++) {
+            if (fabs(m[r][col]) > fabs(m[pivot][col])) pivot = r;
+        }
+        if (fabs(m[pivot][col]) < 1e-12) return false;
+        if (pivot != col) {
+            for (uint8_t k = 0; k < 3; k++) {
+                double t = m[col][k]; m[col][k] = m[pivot][k]; m[pivot][k] = t;
+            }
+            double t = y[col]; y[col] = y[pivot]; y[pivot] = t;
+        }
+        for (uint8_t r = col + 1; r < 3; r++) {
+            double f = m[r][col] / m[col][col];
+            for (uint8_t k = col; k < 3; k++) m[r][k] -= f * m[col][k];
+            y[r] -= f * y[col];
+        }
+    }
+    for (int8_t r = 2; r >= 0; r--) {
+        double s = y[r];
+        for (uint8_t k = r + 1; k < 3; k++) s -= m[r][k] * x[k];
+        x[r] = s / m[r][r];
+    }
+    return true;
+}
+
+bool solveSteinhartHart(const CalPoint* points, uint8_t n, float& a, float& b, float& c) {
+    if (n < 1 || n > CAL_MAX_POINTS) return false;
+
+    // 1/T = A + B*L + C*L^3, L = ln(R), T in Kelvin
+    double L[CAL_MAX_POINTS], y[CAL_MAX_POINTS];
+    for (uint8_t i = 0; i < n; i++) {
+        if (!(points[i].resistance > 0.0f) || points[i].tempC <= -273.15f) return false;
+        L[i] = log((double)points[i].resistance);
+        y[i] = 1.0 / ((double)points[i].tempC + 273.15);
+    }
+
+    double A = a, B = b, C = c;
+    if (n == 1) {
+        A = y[0] - B * L[0] - C * L[0] * L[0] * L[0];
+    } else if (n == 2) {
+        double dL = L[1] - L[0];
+        if (fabs(dL) < 1e-6) return false;
+        double y0 = y[0] - C * L[0] * L[0] * L[0];
+        double y1 = y[1] - C * L[1] * L[1] * L[1];
+        B = (y1 - y0) / dL;
+        A = y0 - B * L[0];
+    } else {
+        double m[3][3], x[3];
+        for (uint8_t i = 0; i < 3; i++) {
+            m[i][0] = 1.0;
+            m[i][1] = L[i];
+            m[i][2] = L[i] * L[i] * L[i];
+        }
+        if (!solve3(m, y, x)) return false;
+        A = x[0];
+        B = x[1];
+        C = x[2];
+    }
+
+    // An NTC reads colder as resistance rises everywhere in range: 1/T
+    // positive and increasing in L. d(1/T)/dL = B + 3CL^2 is monotonic in
+    // L > 0, so checking both ends covers the range.
+    const double ends[2] = { log(CAL_R_MIN), log(CAL_R_MAX) };
+    for (uint8_t i = 0; i < 2; i++) {
+        if (B + 3.0 * C * ends[i] * ends[i] <= 0.0) return false;
+    }
+    if (A + B * ends[0] + C * ends[0] * ends[0] * ends[0] <= 0.0) return false;
+
+    // The rounded coefficients must still land on every point
+    ProbeConfig cfg;
+    cfg.a = (float)A;
+    cfg.b = (float)B;
+    cfg.c = (float)C;
+    for (uint8_t i = 0; i < n; i++) {
+        float t = TempManager::resistanceToTempC(points[i].resistance, cfg);
+        if (!(fabsf(t - points[i].tempC) <= CAL_FIT_TOLERANCE_C)) return false;
+    }
+
+    a = cfg.a;
+    b = cfg.b;
+    c = cfg.c;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ProbeCalibrator
+// ---------------------------------------------------------------------------
+
+ProbeCalibrator::ProbeCalibrator()
+    : _state(CalState::IDLE)
+    , _probe(0)
+    , _pointCount(0)
+    , _refTempC(0.0f)
+    , _captureMs(0)
+    , _error("")
+    , _head(0)
+    , _count(0)
+    , _lastSampleMs(0)
+    , _sampled(false)
+{
+    memset(_points, 0, sizeof(_points));
+}
+
+bool ProbeCalibrator::start(uint8_t probe, const ProbeConfig& current) {
+    if (probe >= NUM_PROBES) {
+        _error = "Bad probe";
+        return false;
+    }
+    _state = CalState::SAMPLING;
+    _probe = probe;
+    _current = current;
+    _current.offset = 0.0f;
+    _pointCount = 0;
+    _error = "";
+    _head = 0;
+    _count = 0;
+    _sampled = false;
+    return true;
+}
+
+void ProbeCalibrator::cancel() {
+    _state = CalState::IDLE;
+    _pointCount = 0;
+    _error = "";
+}
+
+bool ProbeCalibrator::capture(float refTempC) {
+    if (_state != CalState::SAMPLING) {
+        _error = (_state == CalState::IDLE) ? "Not calibrating" : "Capture in progress";
+        return false;
+    }
+    if (_pointCount >= CAL_MAX_POINTS) {
+        _error = "All points taken";
+        return false;
+    }
+    if (isnan(refTempC)) {
+        _error = "Missing reference temperature";
+        return false;
+    }
+    for (uint8_t i = 0; i < _pointCount; i++) {
+        if (fabsf(_points[i].tempC - refTempC) < CAL_MIN_SPREAD_C) {
+            _error = "Too close to an earlier point";
+            return false;
+        }
+    }
+
+    // Only readings taken from here on count, so a probe still on its way
+    // to the reference can't be captured from an old window
+    _state = CalState::CAPTURING;
+    _refTempC = refTempC;
+    _captureMs = _lastSampleMs;
+    _head = 0;
+    _count = 0;
+    _error = "";
+    return true;
+}
+
+void ProbeCalibrator::update(uint32_t nowMs, int16_t raw, bool connected) {
+    if (_state == CalState::IDLE) return;
+    if (_sampled && nowMs - _lastSampleMs < TEMP_SAMPLE_INTERVAL_MS) return;
+    if (!_sampled) _captureMs = nowMs;
+    _lastSampleMs = nowMs;
+    _sampled = true;
+
+    if (connected) {
+        _window[_head] = TempManager::adcToResistance(raw);
+        _head = (uint16_t)((_head + 1) % CAL_STABLE_SAMPLES);
+        if (_count < CAL_STABLE_SAMPLES) _count++;
+    } else {
+        _head = 0;
+        _count = 0;
+    }
+
+    if (_state != CalState::CAPTURING) return;
+    if (isStable()) {
+        float sum = 0.0f;
+        for (uint16_t i = 0; i < _count; i++) sum += _window[i];
+        CalPoint& p = _points[_pointCount++];
+        p.resistance = sum / _count;
+        p.tempC = _refTempC;
+        _state = CalState::SAMPLING;
+    } else if (nowMs - _captureMs >= CAL_CAPTURE_TIMEOUT_MS) {
+        _state = CalState::SAMPLING;
+        _error = connected ? "Reading never settled" : "Probe disconnected";
+    }
+}
+
+bool ProbeCalibrator::solve(ProbeConfig& out) {
+    if (_state != CalState::SAMPLING || _pointCount == 0) {
+        _error = (_state == CalState::CAPTURING) ? "Capture in progress" : "No points taken";
+        return false;
+    }
+    ProbeConfig cfg = _current;
+    if (!solveSteinhartHart(_points, _pointCount, cfg.a, cfg.b, cfg.c)) {
+        _error = "Points don't fit a thermistor curve";
+        return false;
+    }
+    out = cfg;
+    _state = CalState::IDLE;
+    _error = "";
+    return true;
+}
+
+float ProbeCalibrator::spreadC() const {
+    float lo = _window[0], hi = _window[0];
+    for (uint16_t i = 1; i < _count; i++) {
+        if (_window[i] < lo) lo = _window[i];
+        if (_window[i] > hi) hi = _window[i];
+    }
+    // Temperature falls as resistance rises
+    return TempManager::resistanceToTempC(lo, _current) - TempManager::resistanceToTempC(hi, _current);
+}
+
+bool ProbeCalibrator::isStable() const {
+    return _count == CAL_STABLE_SAMPLES && spreadC() <= CAL_STABLE_SPREAD_C;
+}
+
+float ProbeCalibrator::getReadingC() const {
+    if (_count == 0) return NAN;
+    float sum = 0.0f;
+    for (uint16_t i = 0; i < _count; i++) sum += _window[i];
+    return TempManager::resistanceToTempC(sum / _count, _current);
+}
+
+size_t ProbeCalibrator::writeStatus(char* buf, size_t size, bool fahrenheit) const {
+    static const char* const kStateNames[] = { "idle", "sampling", "capturing" };
+    if (size == 0) return 0;
+
+    size_t n = 0;
+    auto put = [&](int w) {
+        if (w > 0) n += (size_t)w;
+        if (n >= size) n = size - 1;
+    };
+    put(snprintf(buf + n, size - n, "{\"state\":\"%s\",\"probe\":%u,\"points\":[",
+                 kStateNames[(uint8_t)_state], (unsigned)_probe));
+    for (uint8_t i = 0; i < _pointCount; i++) {
+        float ref = fahrenheit ? celsiusToFahrenheit(_points[i].tempC) : _points[i].tempC;
+        put(snprintf(buf + n, size - n, "%s{\"ref\":%.1f,\"ohms\":%.0f}",
+                     i ? "," : "", ref, _points[i].resistance));
+    }
+    float reading = getReadingC();
+    if (_state == CalState::IDLE || isnan(reading)) {
+        put(snprintf(buf + n, size - n, "],\"reading\":null"));
+    } else {
+        if (fahrenheit) reading = celsiusToFahrenheit(reading);
+        put(snprintf(buf + n, size - n, "],\"reading\":%.1f", reading));
+    }
+    put(snprintf(buf + n, size - n, ",\"samples\":%u,\"stable\":%s,\"error\":\"%s\"}",
+                 (unsigned)_count, isStable() ? "true" : "false", _error));
+    return n;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "config.h"
+#include "temp_manager.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Multi-point probe calibration. The probe sits in a reference (ice bath,
+// boiling water, next to a reference thermometer) and the calibrator waits
+// for CAL_STABLE_SAMPLES raw readings that agree to CAL_STABLE_SPREAD_C,
+// then records the window's mean resistance against the reference
+// temperature. From 1-3 such points it solves the Steinhart-Hart
+// coefficients on-device:
+//
+//   1 point   A only (B and C kept) -- an offset in 1/T, exact at that point
+//   2 points  A and B (C kept)
+//   3 points  A, B and C exactly
+//
+// The new coefficients absorb any offset, so the caller applies them with
+// the probe's offset reset to 0. Owned by the control task; the web server
+// reaches it through a callback under the control lock.
+
+// One reference point
+struct CalPoint {
+    float resistance;   // Ohms, mean over the stable window
+    float tempC;        // Reference temperature
+};
+
+// Solve coefficients through n points (1..CAL_MAX_POINTS). a, b and c come
+// in as the current coefficients (the ones a 1- or 2-point fit keeps) and
+// are replaced on success. False, with a/b/c untouched, if the points are
+// degenerate or the curve isn't physical (not monotonic over
+// CAL_R_MIN..CAL_R_MAX, or off a point by more than CAL_FIT_TOLERANCE_C).
+bool solveSteinhartHart(const CalPoint* points, uint8_t n, float& a, float& b, float& c);
+
+enum class CalState : uint8_t {
+    IDLE,        // Not calibrating
+    SAMPLING,    // Watching the probe, ready for a capture
+    CAPTURING    // A reference is set, waiting for the readings to settle
+};
+
+class ProbeCalibrator {
+public:
+    ProbeCalibrator();
+
+    // Start calibrating a probe from its current coefficients. Drops any
+    // points from an earlier run. False if the probe is out of range.
+    bool start(uint8_t probe, const ProbeConfig& current);
+
+    // Stop without changing anything
+    void cancel();
+
+    // Record the next stable window against a reference temperature. False
+    // (see getError()) if not sampling, out of points, the reference is NAN
+    // or within CAL_MIN_SPREAD_C of a point already taken.
+    bool capture(float refTempC);
+
+    // Feed the probe's latest raw reading. Call every control tick;
+    // internally gated at TEMP_SAMPLE_INTERVAL_MS.
+    void update(uint32_t nowMs, int16_t raw, bool connected);
+
+    // Solve from the points taken so far. On success fills out (offset 0)
+    // and goes back to IDLE; on failure stays put with getError() set.
+    bool solve(ProbeConfig& out);
+
+    CalState getState() const { return _state; }
+    uint8_t  getProbe() const { return _probe; }
+    uint8_t  getPointCount() const { return _pointCount; }
+    const CalPoint& getPoint(uint8_t i) const { return _points[i]; }
+
+    // Whether the last CAL_STABLE_SAMPLES readings agree
+    bool isStable() const;
+
+    // Mean of the window with the current coefficients, deg C (NAN if empty)
+    float getReadingC() const;
+
+    // Last failure, or "" (points to a string literal)
+    const char* getError() const { return _error; }
+
+    // Status as JSON: {"state":..,"probe":..,"points":[{"ref":..,"ohms":..}],
+    // "reading":..,"samples":..,"stable":..,"error":..}. Temperatures in F
+    // if fahrenheit.
+    size_t writeStatus(char* buf, size_t size, bool fahrenheit) const;
+
+private:
+    // Reading range over the window, deg C
+    float spreadC() const;
+
+    CalState    _state;
+    uint8_t     _probe;
+    ProbeConfig _current;       // Coefficients the probe is reading with
+    CalPoint    _points[CAL_MAX_POINTS];
+    uint8_t     _pointCount;
+    float       _refTempC;      // CAPTURING: reference for the next point
+    uint32_t    _captureMs;     // CAPTURING: when it was requested
+    const char* _error;
+
+    // Raw readings as resistance, CAL_STABLE_SAMPLES ring
+    float    _window[CAL_STABLE_SAMPLES];
+    uint16_t _head;
+    uint16_t _count;
+    uint32_t _lastSampleMs;
+    bool     _sampled;
+};
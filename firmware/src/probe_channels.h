@@ -0,0 +1,54 @@
+#pragma once
+
+#include "config.h"
+#include <stdint.h>
+
+// Probe channel table.
+//
+// One row per probe: the ADS1115 it's wired to, the input on that ADC and
+// the key it goes by in JSON, CSV and MQTT. Channel 0 is always the pit,
+// the rest are meat probes. Sampling, the session record, the protocol and
+// the UIs loop over the first NUM_PROBES rows instead of naming probes, so
+// a bigger build only needs -DPROBE_CHANNELS=N:
+//   3      pit, meat1, meat2 on inputs 0-2 (stock board)
+//   4      + meat3 on the spare input 3
+//   5..8   + meat4..meat7 on a second ADS1115 at ADS1115_ADDR_2
+//
+// Every meat channel gets a target, a done alarm and a done-time estimate,
+// indexed by meat number (channel - 1) in TempPredictor and AlarmManager.
+// Only the LCD cards are fixed at pit, meat1 and meat2; its graph and alert
+// banner cover every channel.
+
+#define NUM_PROBES       PROBE_CHANNELS
+#define NUM_MEATS        (NUM_PROBES - 1)
+#define PROBE_MAX        8
+#define PROBE_ADC_COUNT  ((NUM_PROBES + 3) / 4)
+
+static_assert(NUM_PROBES >= 3 && NUM_PROBES <= PROBE_MAX, "PROBE_CHANNELS must be 3..8");
+
+// Channels with a fixed role
+enum ProbeIndex : uint8_t {
+    PROBE_PIT   = 0,
+    PROBE_MEAT1 = 1,
+    PROBE_MEAT2 = 2
+};
+
+struct ProbeChannel {
+    const char* key;      // JSON/CSV/MQTT name
+    const char* label;    // Display name
+    uint8_t     adc;      // Index into kProbeAdcAddr
+    uint8_t     input;    // ADS1115 single-ended input 0-3
+};
+
+static const uint8_t kProbeAdcAddr[2] = { ADS1115_ADDR, ADS1115_ADDR_2 };
+
+static const ProbeChannel kProbeChannels[PROBE_MAX] = {
+    { "pit",   "Pit",    0, ADC_CHANNEL_PIT   },
+    { "meat1", "Meat 1", 0, ADC_CHANNEL_MEAT1 },
+    { "meat2", "Meat 2", 0, ADC_CHANNEL_MEAT2 },
+    { "meat3", "Meat 3", 0, ADC_CHANNEL_SPARE },
+    { "meat4", "Meat 4", 1, 0 },
+    { "meat5", "Meat 5", 1, 1 },
+    { "meat6", "Meat 6", 1, 2 },
+    { "meat7", "Meat 7", 1, 3 }
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef NATIVE_BUILD
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+// Single-writer, multi-reader sequence lock for passing a plain struct
+// between tasks (or cores) without blocking the writer.
+//
+// The writer bumps the sequence to odd, copies the value in, then bumps it
+// back to even. A reader copies the value out and retries if the sequence
+// was odd or changed underneath it. T must be trivially copyable.
+//
+// A reader can only wait out a write that is actually running: the writer on
+// another core, or at a higher priority. A reader that preempts the writer on
+// its own core (async_tcp over loop(), both on core 0) would spin forever with
+// the writer parked mid-write, so after SEQLOCK_SPIN_LIMIT failed tries read()
+// sleeps a tick to let it finish. Writers never wait.
+//
+// C++11 apart from that sleep (std::this_thread::yield() on native). Fully
+// testable on native.
+
+#define SEQLOCK_SPIN_LIMIT 64   // Failed read attempts before sleeping a tick
+template <typename T>
+class Seqlock {
+public:
+    Seqlock() : _seq(0) { memset(&_value, 0, sizeof(_value)); }
+
+    // Publish a new value. Only one task may call this.
+    void write(const T& value) {
+        update([&](T& v) { memcpy(&v, &value, sizeof(T)); });
+    }
+
+    // Change the published value in place, e.g. bump a few counters without
+    // copying the whole struct in and out. Same single-writer rule as write().
+    template <typename Fn>
+    void update(Fn fn) {
+        uint32_t s = _seq.load(std::memory_order_relaxed);
+        _seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        fn(_value);
+        std::atomic_thread_fence(std::memory_order_release);
+        _seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Copy out a consistent value. Never blocks the writer; spins while a
+    // write is in progress, sleeping a tick every SEQLOCK_SPIN_LIMIT tries.
+    T read() const {
+        T out;
+        uint32_t tries = 0;
+        while (true) {
+            uint32_t before = _seq.load(std::memory_order_acquire);
+            if (!(before & 1)) {
+                memcpy(&out, &_value, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_seq.load(std::memory_order_relaxed) == before) return out;
+            }
+            if (++tries >= SEQLOCK_SPIN_LIMIT) {
+                tries = 0;
+                yieldToWriter();
+            }
+        }
+    }
+
+    // Number of completed writes. Readers can compare against a saved
+    // version to skip work when nothing was published since.
+    uint32_t version() const { return _seq.load(std::memory_order_acquire) >> 1; }
+
+private:
+    // Lets a preempted writer on this core run. vTaskDelay() blocks for a
+    // tick, so it hands the core to lower priorities too; taskYIELD()
+    // wouldn't.
+    static void yieldToWriter() {
+#ifndef NATIVE_BUILD
+        vTaskDelay(1);
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    std::atomic<uint32_t> _seq;
+    T _value;
+};
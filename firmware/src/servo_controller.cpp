@@ -1,28 +1,42 @@
 #include "servo_controller.h"
+#include <math.h>
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
 #endif
 
 ServoController::ServoController()
-    : _currentAngle(DAMPER_CLOSED)
+    : _pin(-1)
+    , _angle((float)DAMPER_CLOSED)
+    , _targetAngle((float)DAMPER_CLOSED)
+    , _slewDegPerSec(SERVO_SLEW_DEG_S)
+    , _lastUs(0)
+    , _lastUpdateMs(0)
+    , _settledMs(0)
     , _attached(false)
+#ifdef NATIVE_BUILD
+    , _testNowMs(0)
+#endif
 {
 }
 
-void ServoController::begin() {
+void ServoController::begin(int8_t pin) {
+    _pin = pin;
+    _angle = (float)DAMPER_CLOSED;
+    _targetAngle = (float)DAMPER_CLOSED;
+    _lastUpdateMs = nowMs();
+    _settledMs = _lastUpdateMs;
+    if (_pin < 0) return;
 #ifndef NATIVE_BUILD
     _servo.setPeriodHertz(50);  // Standard 50Hz servo frequency
-    _servo.attach(PIN_SERVO, SERVO_MIN_US, SERVO_MAX_US);
-    _attached = true;
+#endif
 
-    // Start at closed position
-    uint16_t us = angleToMicroseconds((float)DAMPER_CLOSED);
-    _servo.writeMicroseconds(us);
-    _currentAngle = DAMPER_CLOSED;
+    // Start at closed position; update() detaches once it has settled
+    writeMicroseconds(angleToMicroseconds((float)DAMPER_CLOSED));
 
-    Serial.printf("[SERVO] Attached to pin %d, range %d-%d us, closed=%d deg, open=%d deg\n",
-                  PIN_SERVO, SERVO_MIN_US, SERVO_MAX_US, DAMPER_CLOSED, DAMPER_OPEN);
+#ifndef NATIVE_BUILD
+    Serial.printf("[SERVO] Attached to pin %d, range %d-%d us, closed=%d deg, open=%d deg, %.0f deg/s\n",
+                  _pin, SERVO_MIN_US, SERVO_MAX_US, DAMPER_CLOSED, DAMPER_OPEN, _slewDegPerSec);
 #endif
 }
 
@@ -39,27 +53,56 @@ void ServoController::setPosition(float percent) {
     if (angle < (float)DAMPER_CLOSED) angle = (float)DAMPER_CLOSED;
     if (angle > (float)DAMPER_OPEN) angle = (float)DAMPER_OPEN;
 
-    _currentAngle = (uint8_t)(angle + 0.5f);
+    // Deadband: don't chase PID noise, but always reach the end stops
+    bool endStop = angle == (float)DAMPER_CLOSED || angle == (float)DAMPER_OPEN;
+    if (!endStop && fabsf(angle - _targetAngle) < SERVO_DEADBAND_DEG) return;
+    _targetAngle = angle;
+}
+
+void ServoController::update() {
+    unsigned long now = nowMs();
+    float dtSec = (float)(now - _lastUpdateMs) / 1000.0f;
+    _lastUpdateMs = now;
+
+    // --- Slew toward the target ---
+    if (_angle != _targetAngle) {
+        float step = _slewDegPerSec > 0.0f ? _slewDegPerSec * dtSec : 1000.0f;
+        float diff = _targetAngle - _angle;
+        if (fabsf(diff) <= step) {
+            _angle = _targetAngle;
+        } else {
+            _angle += diff > 0.0f ? step : -step;
+        }
+        writeMicroseconds(angleToMicroseconds(_angle));
+        _settledMs = now;
+        return;
+    }
 
-    uint16_t us = angleToMicroseconds(angle);
-    writeMicroseconds(us);
+    // --- Settled: let go of the signal once the servo has got there ---
+    if (_attached && now - _settledMs >= SERVO_DETACH_MS) {
+        detach();
+    }
+}
+
+void ServoController::setSlewRate(float degPerSec) {
+    _slewDegPerSec = degPerSec > 0.0f ? degPerSec : 0.0f;
 }
 
 void ServoController::setAngle(uint8_t angleDeg) {
     if (angleDeg > 180) angleDeg = 180;
-    _currentAngle = angleDeg;
-
-    uint16_t us = angleToMicroseconds((float)angleDeg);
-    writeMicroseconds(us);
+    _angle = (float)angleDeg;
+    _targetAngle = _angle;
+    _settledMs = nowMs();
+    writeMicroseconds(angleToMicroseconds(_angle));
 }
 
 uint8_t ServoController::getCurrentAngle() const {
-    return _currentAngle;
+    return (uint8_t)(_angle + 0.5f);
 }
 
 float ServoController::getCurrentPositionPct() const {
     if (DAMPER_OPEN == DAMPER_CLOSED) return 0.0f;
-    float pct = (float)(_currentAngle - DAMPER_CLOSED) /
+    float pct = (_angle - (float)DAMPER_CLOSED) /
                 (float)(DAMPER_OPEN - DAMPER_CLOSED) * 100.0f;
     if (pct < 0.0f) pct = 0.0f;
     if (pct > 100.0f) pct = 100.0f;
@@ -67,23 +110,23 @@ float ServoController::getCurrentPositionPct() const {
 }
 
 void ServoController::detach() {
+    if (!_attached) return;
 #ifndef NATIVE_BUILD
-    if (_attached) {
-        _servo.detach();
-        _attached = false;
-        Serial.println("[SERVO] Detached.");
-    }
+    _servo.detach();
 #endif
+    _attached = false;
+    _lastUs = 0;
 }
 
 void ServoController::writeMicroseconds(uint16_t us) {
+    if (_pin < 0) return;
+    if (_attached && us == _lastUs) return;   // Change-only writes
 #ifndef NATIVE_BUILD
-    if (!_attached) {
-        _servo.attach(PIN_SERVO, SERVO_MIN_US, SERVO_MAX_US);
-        _attached = true;
-    }
+    if (!_attached) _servo.attach(_pin, SERVO_MIN_US, SERVO_MAX_US);
     _servo.writeMicroseconds(us);
 #endif
+    _attached = true;
+    _lastUs = us;
 }
 
 uint16_t ServoController::angleToMicroseconds(float angle) const {
@@ -96,3 +139,11 @@ uint16_t ServoController::angleToMicroseconds(float angle) const {
                (angle / 180.0f) * (float)(SERVO_MAX_US - SERVO_MIN_US);
     return (uint16_t)(us + 0.5f);
 }
+
+unsigned long ServoController::nowMs() const {
+#ifndef NATIVE_BUILD
+    return millis();
+#else
+    return _testNowMs;
+#endif
+}
@@ -11,14 +11,25 @@ class ServoController {
 public:
     ServoController();
 
-    // Attach servo to PIN_SERVO. Call once from setup().
-    void begin();
+    // Attach servo to pin. Call once from setup(). A negative pin runs the
+    // position logic without driving an output.
+    void begin(int8_t pin = PIN_SERVO);
 
-    // Set damper position from 0-100% (0=closed, 100=open).
-    // Maps to DAMPER_CLOSED..DAMPER_OPEN angle range.
+    // Set the damper target from 0-100% (0=closed, 100=open), mapped to the
+    // DAMPER_CLOSED..DAMPER_OPEN angle range. Moves smaller than
+    // SERVO_DEADBAND_DEG are ignored. Nothing is written until update().
     void setPosition(float percent);
 
-    // Move servo to a specific angle in degrees. Useful for testing.
+    // Call every control tick: moves toward the target at the slew rate,
+    // writes the pulse only when it changes, and detaches the servo
+    // SERVO_DETACH_MS after it settles.
+    void update();
+
+    // Maximum travel in deg/s, 0 = jump straight to the target
+    void setSlewRate(float degPerSec);
+
+    // Move servo to a specific angle in degrees now, bypassing the slew
+    // limit. Useful for testing.
     void setAngle(uint8_t angleDeg);
 
     // Current servo angle in degrees
@@ -27,20 +38,44 @@ public:
     // Current position as a percentage (0-100)
     float getCurrentPositionPct() const;
 
+    // Still slewing toward the target?
+    bool isMoving() const { return _angle != _targetAngle; }
+
+    // Servo signal attached (energised)?
+    bool isAttached() const { return _attached; }
+
     // Detach the servo signal to avoid jitter when not actively moving
     void detach();
 
+#ifdef NATIVE_BUILD
+    // Test helper: the clock update() reads in place of millis()
+    void setNowMs(unsigned long ms) { _testNowMs = ms; }
+#endif
+
 private:
-    // Write microsecond pulse value to the servo
+    // Write microsecond pulse value to the servo, attaching it if needed,
+    // unless it is the pulse already written
     void writeMicroseconds(uint16_t us);
 
     // Map angle to microseconds for precise control
     uint16_t angleToMicroseconds(float angle) const;
 
+    unsigned long nowMs() const;
+
 #ifndef NATIVE_BUILD
     Servo _servo;
 #endif
 
-    uint8_t _currentAngle;
-    bool    _attached;
+    int8_t        _pin;           // -1 = no output
+    float         _angle;         // Commanded angle, slewing toward _targetAngle
+    float         _targetAngle;
+    float         _slewDegPerSec;
+    uint16_t      _lastUs;        // Pulse last written, 0 = none since attach
+    unsigned long _lastUpdateMs;
+    unsigned long _settledMs;     // When the angle last stopped moving
+    bool          _attached;
+
+#ifdef NATIVE_BUILD
+    unsigned long _testNowMs;
+#endif
 };
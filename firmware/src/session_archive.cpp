@@ -0,0 +1,132 @@
+#include "session_archive.h"
+#include "session_log.h"
+#include <stddef.h>
+#include <string.h>
+
+// Index file image: header, SESSION_ARCHIVE_MAX entries, CRC-32 of both
+struct ArchiveImageHeader {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  count;
+    uint8_t  channels;      // Peaks per entry (version 2; 3 before)
+    uint8_t  reserved;
+    uint32_t nextId;
+};
+
+static_assert(sizeof(SessionArchiveEntry) == SESSION_ARCHIVE_ENTRY_BYTES(NUM_PROBES),
+              "SESSION_ARCHIVE_ENTRY_BYTES out of step with SessionArchiveEntry");
+static_assert(sizeof(ArchiveImageHeader) + sizeof(uint32_t) == 16,
+              "SESSION_ARCHIVE_IMAGE_MAX out of step with ArchiveImageHeader");
+
+SessionArchiveIndex::SessionArchiveIndex() {
+    clear();
+}
+
+void SessionArchiveIndex::clear() {
+    memset(_entries, 0, sizeof(_entries));
+    _count = 0;
+    _nextId = 1;
+}
+
+const SessionArchiveEntry& SessionArchiveIndex::entry(uint8_t i) const {
+    static const SessionArchiveEntry empty = {};
+    if (i >= _count) return empty;
+    return _entries[i];
+}
+
+const SessionArchiveEntry* SessionArchiveIndex::find(uint32_t id) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_entries[i].id == id) return &_entries[i];
+    }
+    return nullptr;
+}
+
+uint32_t SessionArchiveIndex::totalBytes() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _count; i++) total += _entries[i].bytes;
+    return total;
+}
+
+void SessionArchiveIndex::removeOldest() {
+    if (_count == 0) return;
+    memmove(&_entries[0], &_entries[1], (_count - 1) * sizeof(SessionArchiveEntry));
+    _count--;
+}
+
+uint8_t SessionArchiveIndex::add(const SessionArchiveEntry& e, uint32_t* evicted,
+                                 uint8_t maxEvicted) {
+    uint8_t n = 0;
+
+    // Room for the new entry first, then the byte budget
+    while (_count >= SESSION_ARCHIVE_MAX ||
+           (_count > 0 && totalBytes() + e.bytes > SESSION_ARCHIVE_BUDGET)) {
+        if (n < maxEvicted) evicted[n] = _entries[0].id;
+        n++;
+        removeOldest();
+    }
+
+    _entries[_count] = e;
+    _entries[_count].id = _nextId++;
+    _count++;
+    return n < maxEvicted ? n : maxEvicted;
+}
+
+size_t SessionArchiveIndex::imageSize() {
+    return sizeof(ArchiveImageHeader) + sizeof(_entries) + sizeof(uint32_t);
+}
+
+size_t SessionArchiveIndex::serialize(uint8_t* buf, size_t len) const {
+    if (len < imageSize()) return 0;
+
+    ArchiveImageHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic    = SESSION_ARCHIVE_MAGIC;
+    hdr.version  = SESSION_ARCHIVE_VERSION;
+    hdr.count    = _count;
+    hdr.channels = NUM_PROBES;
+    hdr.nextId   = _nextId;
+
+    size_t pos = 0;
+    memcpy(buf + pos, &hdr, sizeof(hdr));
+    pos += sizeof(hdr);
+    memcpy(buf + pos, _entries, sizeof(_entries));
+    pos += sizeof(_entries);
+    uint32_t crc = sessionCrc32(buf, pos);
+    memcpy(buf + pos, &crc, sizeof(crc));
+    return pos + sizeof(crc);
+}
+
+bool SessionArchiveIndex::deserialize(const uint8_t* buf, size_t len) {
+    ArchiveImageHeader hdr;
+    if (len < sizeof(hdr)) return false;
+    memcpy(&hdr, buf, sizeof(hdr));
+    uint8_t channels = hdr.version == 1 ? 3 : hdr.channels;
+    if (hdr.magic != SESSION_ARCHIVE_MAGIC || hdr.version == 0 ||
+        hdr.version > SESSION_ARCHIVE_VERSION || channels < 3 || channels > PROBE_MAX) {
+        return false;
+    }
+
+    size_t stride = SESSION_ARCHIVE_ENTRY_BYTES(channels);
+    size_t body = sizeof(hdr) + SESSION_ARCHIVE_MAX * stride;
+    if (len < body + sizeof(uint32_t)) return false;
+    uint32_t crc;
+    memcpy(&crc, buf + body, sizeof(crc));
+    if (sessionCrc32(buf, body) != crc || hdr.count > SESSION_ARCHIVE_MAX) return false;
+
+    // Entry by entry: the peaks and what follows them move with the channel count
+    memset(_entries, 0, sizeof(_entries));
+    const size_t peaks = offsetof(SessionArchiveEntry, peak);
+    for (uint8_t i = 0; i < hdr.count; i++) {
+        const uint8_t* p = buf + sizeof(hdr) + i * stride;
+        SessionArchiveEntry& e = _entries[i];
+        memcpy(&e, p, peaks);
+        for (uint8_t c = 0; c < NUM_PROBES; c++) {
+            if (c < channels) memcpy(&e.peak[c], p + peaks + 2 * c, sizeof(int16_t));
+            else              e.peak[c] = SESSION_PEAK_NONE;
+        }
+        e.segments = p[peaks + 2 * channels];
+    }
+    _count  = hdr.count;
+    _nextId = hdr.nextId;
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "config.h"
+#include "probe_channels.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Index of archived cook sessions.
+//
+// When a new cook starts, the finished one's log and rollup files are moved
+// under SESSION_ARCHIVE_DIR and summarised here. The index is one small
+// CRC-checked file, so listing past cooks never opens a session file.
+// Oldest cooks rotate out once there are more than SESSION_ARCHIVE_MAX or
+// their files exceed SESSION_ARCHIVE_BUDGET bytes. Version 1 indexes
+// (peaks for pit, meat1 and meat2 only) still load; an index written with
+// another channel count loads with the peaks the two builds share.
+//
+// Pure C++ — file handling is CookSession's. Fully testable on native.
+
+#define SESSION_ARCHIVE_MAGIC    0x58444E49UL   // "INDX"
+#define SESSION_ARCHIVE_VERSION  2
+#define SESSION_PEAK_NONE        INT16_MIN      // Probe never connected
+
+// Index file entry with `channels` peaks (the struct layout), and the
+// longest index file: header, entries with PROBE_MAX peaks, CRC
+#define SESSION_ARCHIVE_ENTRY_BYTES(channels) ((22 + 2 * (channels) + 3) & ~3)
+#define SESSION_ARCHIVE_IMAGE_MAX \
+    (16 + SESSION_ARCHIVE_MAX * SESSION_ARCHIVE_ENTRY_BYTES(PROBE_MAX))
+
+struct SessionArchiveEntry {
+    uint32_t id;            // Names the archived files (SESSION_ARCHIVE_LOG_PATH)
+    uint32_t startTime;     // Session start epoch
+    uint32_t durationSec;   // First to last point
+    uint32_t points;
+    uint32_t bytes;         // Flash used by the archived files
+    int16_t  peak[NUM_PROBES];   // Max per channel * 10, or SESSION_PEAK_NONE
+    uint8_t  segments;      // Log segment files archived
+    uint8_t  reserved;
+};
+
+class SessionArchiveIndex {
+public:
+    SessionArchiveIndex();
+
+    void clear();
+
+    // Number of archived cooks; entry(0) is the oldest
+    uint8_t count() const { return _count; }
+    const SessionArchiveEntry& entry(uint8_t i) const;
+
+    // Entry by id, nullptr if not (or no longer) archived
+    const SessionArchiveEntry* find(uint32_t id) const;
+
+    // Id the next archived cook will get
+    uint32_t nextId() const { return _nextId; }
+
+    // Flash used by all archived cooks
+    uint32_t totalBytes() const;
+
+    // Add a cook as the newest entry; its id is taken from nextId().
+    // Evicts the oldest entries until count and bytes are within limits
+    // (the new entry itself is always kept) and writes their ids to
+    // evicted. Returns the number evicted.
+    uint8_t add(const SessionArchiveEntry& entry, uint32_t* evicted, uint8_t maxEvicted);
+
+    // Fixed-size image for the index file, CRC-checked on load. One from
+    // a build with more channels is longer, up to SESSION_ARCHIVE_IMAGE_MAX.
+    static size_t imageSize();
+    size_t serialize(uint8_t* buf, size_t len) const;
+    bool deserialize(const uint8_t* buf, size_t len);
+
+private:
+    SessionArchiveEntry _entries[SESSION_ARCHIVE_MAX];
+    uint8_t  _count;
+    uint32_t _nextId;
+
+    void removeOldest();
+};
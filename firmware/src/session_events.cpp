@@ -0,0 +1,96 @@
+#include "session_events.h"
+#include "session_log.h"
+#include "fan_mode.h"
+#include <string.h>
+#include <stddef.h>
+
+SessionEventJournal::SessionEventJournal() {
+    clear();
+}
+
+void SessionEventJournal::clear() {
+    memset(_events, 0, sizeof(_events));
+    _count = 0;
+    for (uint8_t t = 0; t < SESSION_EVENT_TYPES; t++) _latest[t] = SESSION_EVENT_NONE;
+}
+
+const SessionEvent& SessionEventJournal::event(uint16_t i) const {
+    static const SessionEvent empty = {};
+    if (i >= _count) return empty;
+    return _events[i];
+}
+
+int16_t SessionEventJournal::latest(SessionEventType type) const {
+    if ((uint8_t)type >= SESSION_EVENT_TYPES) return SESSION_EVENT_NONE;
+    return _latest[(uint8_t)type];
+}
+
+bool SessionEventJournal::record(uint32_t timestamp, SessionEventType type, int16_t value) {
+    uint8_t t = (uint8_t)type;
+    if (t >= SESSION_EVENT_TYPES) return false;
+    if (type != SessionEventType::ALARM_ACK && _latest[t] == value) return false;
+    if (full()) return false;
+
+    if (_count > 0 && timestamp < _events[_count - 1].timestamp) {
+        timestamp = _events[_count - 1].timestamp;
+    }
+
+    SessionEvent& e = _events[_count++];
+    e.timestamp = timestamp;
+    e.value = value;
+    e.type = t;
+    seal(e);
+    _latest[t] = value;
+    return true;
+}
+
+uint16_t SessionEventJournal::load(const SessionEvent* records, uint16_t n) {
+    clear();
+    for (uint16_t i = 0; i < n && _count < SESSION_EVENT_CAPACITY; i++) {
+        const SessionEvent& e = records[i];
+        if (!isValid(e)) break;
+        if (_count > 0 && e.timestamp < _events[_count - 1].timestamp) break;
+        _events[_count++] = e;
+        _latest[e.type] = e.value;
+    }
+    return _count;
+}
+
+void SessionEventJournal::seal(SessionEvent& e) {
+    e.check = (uint8_t)sessionCrc32(&e, offsetof(SessionEvent, check));
+}
+
+bool SessionEventJournal::isValid(const SessionEvent& e) {
+    return e.type < SESSION_EVENT_TYPES &&
+           e.check == (uint8_t)sessionCrc32(&e, offsetof(SessionEvent, check));
+}
+
+// ---------------------------------------------------------------------------
+// Replay
+// ---------------------------------------------------------------------------
+
+void sessionEventsBegin(SessionEventCursor& cursor) {
+    cursor.next = 0;
+    for (uint8_t t = 0; t < SESSION_EVENT_TYPES; t++) cursor.value[t] = SESSION_EVENT_NONE;
+}
+
+void sessionEventsSeek(const SessionEventJournal& journal, SessionEventCursor& cursor,
+                       uint32_t timestamp) {
+    while (cursor.next < journal.count()) {
+        const SessionEvent& e = journal.event(cursor.next);
+        if (e.timestamp > timestamp) break;
+        cursor.value[e.type] = e.value;
+        cursor.next++;
+    }
+}
+
+int16_t sessionFanModeIndex(const char* mode) {
+    FanMode m;
+    if (!fanModeFromName(mode, m)) return -1;
+    return (int16_t)m;
+}
+
+const char* sessionFanModeName(int16_t index) {
+    if (index < 0 || index >= (int16_t)FAN_MODE_COUNT) return nullptr;
+    return fanModeName((FanMode)index);
+}
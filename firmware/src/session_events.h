@@ -0,0 +1,112 @@
+#pragma once
+
+#include "config.h"
+#include "probe_channels.h"
+#include <stdint.h>
+
+// Sparse journal of control changes during a cook.
+//
+// DataPoints carry only what the probes and actuators did. What the cook
+// was asked to do — setpoint, meat targets, fan mode — plus lid events and
+// alarm acknowledgements change rarely, so they're journalled as timestamped
+// events next to the point stream instead of widening every point. Replay
+// walks the journal with a cursor in step with the points, so merging
+// costs O(events) over the whole cook.
+//
+// Pure C++ — file handling is CookSession's. Fully testable on native.
+
+enum class SessionEventType : uint8_t {
+    SETPOINT = 0,       // value = setpoint * 10
+    MEAT1_TARGET,       // value = target * 10, 0 = not set
+    MEAT2_TARGET,
+    FAN_MODE,           // value = sessionFanModeIndex()
+    LID,                // value = 1 open, 0 closed
+    ALARM_ACK,          // value = AlarmType acknowledged
+    ZONE1_SETPOINT,     // Setpoints of control zones 1-3 (control_zone.h), value * 10
+    ZONE2_SETPOINT,
+    ZONE3_SETPOINT,
+    MEAT3_TARGET,       // Targets of meat channels 3-7 (probe_channels.h), as MEAT1_TARGET
+    MEAT4_TARGET,
+    MEAT5_TARGET,
+    MEAT6_TARGET,
+    MEAT7_TARGET,
+    COUNT
+};
+
+#define SESSION_EVENT_TYPES  ((uint8_t)SessionEventType::COUNT)
+#define SESSION_EVENT_NONE   INT16_MIN      // No event of that type yet
+
+static_assert(CONTROL_ZONES_MAX <= 4, "One ZONEn_SETPOINT event type per control zone");
+
+// Setpoint event of a control zone: SETPOINT for zone 0
+inline SessionEventType sessionZoneSetpointEvent(uint8_t zone) {
+    return zone == 0 ? SessionEventType::SETPOINT
+                     : (SessionEventType)((uint8_t)SessionEventType::ZONE1_SETPOINT + zone - 1);
+}
+
+static_assert(PROBE_MAX <= 8, "One MEATn_TARGET event type per meat channel");
+
+// Target event of a meat probe (0 = meat1, as AlarmManager::setMeatTarget())
+inline SessionEventType sessionMeatTargetEvent(uint8_t meat) {
+    return meat < 2 ? (SessionEventType)((uint8_t)SessionEventType::MEAT1_TARGET + meat)
+                    : (SessionEventType)((uint8_t)SessionEventType::MEAT3_TARGET + meat - 2);
+}
+
+// One journal record, stored on flash as is
+struct SessionEvent {
+    uint32_t timestamp;     // Epoch, same clock as DataPoint.timestamp
+    int16_t  value;
+    uint8_t  type;          // SessionEventType
+    uint8_t  check;         // Checksum of the other fields (torn-write detection)
+};
+
+class SessionEventJournal {
+public:
+    SessionEventJournal();
+
+    void clear();
+
+    // Record a change. State events (everything but ALARM_ACK) that repeat
+    // the type's latest value are dropped, so callers can report every tick.
+    // Timestamps never go backwards; an earlier one is clamped to the last.
+    // Returns false if nothing was recorded (unchanged or journal full).
+    bool record(uint32_t timestamp, SessionEventType type, int16_t value);
+
+    uint16_t count() const { return _count; }
+    const SessionEvent& event(uint16_t i) const;
+    bool full() const { return _count >= SESSION_EVENT_CAPACITY; }
+
+    // Most recent value of a type, or SESSION_EVENT_NONE
+    int16_t latest(SessionEventType type) const;
+
+    // Replace the journal with records read back from flash, keeping them
+    // up to the first one that is torn, unknown or out of time order.
+    // Returns the number kept.
+    uint16_t load(const SessionEvent* records, uint16_t n);
+
+    static void seal(SessionEvent& e);
+    static bool isValid(const SessionEvent& e);
+
+private:
+    SessionEvent _events[SESSION_EVENT_CAPACITY];
+    uint16_t _count;
+    int16_t  _latest[SESSION_EVENT_TYPES];
+};
+
+// Replay position in the journal: the value of each type as of the last
+// timestamp sought to
+struct SessionEventCursor {
+    uint16_t next;
+    int16_t  value[SESSION_EVENT_TYPES];
+};
+
+void sessionEventsBegin(SessionEventCursor& cursor);
+
+// Apply every event at or before timestamp. Seek forwards only.
+void sessionEventsSeek(const SessionEventJournal& journal, SessionEventCursor& cursor,
+                       uint32_t timestamp);
+
+// Fan mode string ("fan_only", "fan_and_damper", "damper_primary") to the
+// FAN_MODE event value and back. Unknown strings map to -1 / nullptr.
+int16_t sessionFanModeIndex(const char* mode);
+const char* sessionFanModeName(int16_t index);
@@ -0,0 +1,402 @@
+#include "session_log.h"
+#include <string.h>
+
+// Record change mask bits (packed format)
+#define REC_PIT     0x01
+#define REC_MEAT1   0x02
+#define REC_MEAT2   0x04
+#define REC_FAN     0x08
+#define REC_DAMPER  0x10
+#define REC_FLAGS   0x20
+#define REC_DT      0x40    // Timestamp step isn't the nominal sample interval
+#define REC_EXT     0x80    // Extension byte follows (version 2+)
+
+// Extension byte bits: 0..4 = channels 3..7 changed, and
+#define EXT_ALARM   0x40    // alarmExt byte follows (version 3)
+#define EXT_DISC    0x80    // discExt byte follows
+
+static const int32_t kNominalDt = SESSION_SAMPLE_INTERVAL / 1000;
+
+uint32_t sessionCrc32(const void* data, size_t len, uint32_t crc) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// Version 0 covers only the points written; version 1 the whole payload
+// area, padding included, so it needs no length field
+static uint32_t blockCrc(const SessionBlockHeader& hdr, const uint8_t* payload) {
+    SessionBlockHeader h = hdr;
+    h.crc = 0;
+    uint32_t crc = sessionCrc32(&h, sizeof(h));
+    size_t len = hdr.version == 0 ? (size_t)hdr.count * sizeof(DataPoint)
+                                  : SESSION_BLOCK_PAYLOAD;
+    return sessionCrc32(payload, len, crc);
+}
+
+// ---------------------------------------------------------------------------
+// Varint / zigzag
+// ---------------------------------------------------------------------------
+
+static uint8_t putVarint(uint8_t* p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static uint8_t putZigzag(uint8_t* p, int32_t v) {
+    return putVarint(p, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+// False if the varint runs past end
+static bool getVarint(const uint8_t* p, uint16_t& pos, uint16_t end, uint32_t& v) {
+    v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (pos >= end) return false;
+        uint8_t b = p[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static bool getZigzag(const uint8_t* p, uint16_t& pos, uint16_t end, int32_t& v) {
+    uint32_t u;
+    if (!getVarint(p, pos, end, u)) return false;
+    v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+    return true;
+}
+
+static void put16(uint8_t* p, int16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+static int16_t get16(const uint8_t* p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+// Version 3 keyframe
+static void putKeyframe(uint8_t* p, const DataPoint& dp) {
+    p[0] = (uint8_t)dp.timestamp;
+    p[1] = (uint8_t)(dp.timestamp >> 8);
+    p[2] = (uint8_t)(dp.timestamp >> 16);
+    p[3] = (uint8_t)(dp.timestamp >> 24);
+    uint8_t pos = 4;
+    for (uint8_t c = 0; c < NUM_PROBES; c++, pos += 2) put16(p + pos, dp.temp[c]);
+    p[pos++] = dp.fanPct;
+    p[pos++] = dp.damperPct;
+    p[pos++] = dp.flags;
+    p[pos++] = dp.discExt;
+    p[pos]   = dp.alarmExt;
+}
+
+// Match a point decoded from a block with `channels` channels to this
+// build: channels only the build has read as disconnected, extra ones in
+// the block are dropped
+static void fitChannels(DataPoint& dp, uint8_t channels) {
+    const uint16_t all = (uint16_t)((1u << NUM_PROBES) - 1);
+    uint16_t missing = channels < NUM_PROBES ? (uint16_t)(all & ~((1u << channels) - 1)) : 0;
+    dpSetDiscMask(dp, (uint16_t)((dpDiscMask(dp) | missing) & all));
+}
+
+// Keyframe of a block with `channels` channels (version 1: 3, no discExt;
+// before version 3, no alarmExt). Returns its length.
+static uint16_t getKeyframe(const uint8_t* p, uint8_t version, uint8_t channels, DataPoint& dp) {
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                   ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    uint16_t pos = 4;
+    for (uint8_t c = 0; c < channels; c++, pos += 2) {
+        if (c < NUM_PROBES) dp.temp[c] = get16(p + pos);
+    }
+    dp.fanPct    = p[pos++];
+    dp.damperPct = p[pos++];
+    dp.flags     = p[pos++];
+    if (version >= 2) dp.discExt = p[pos++];
+    if (version >= 3) dp.alarmExt = p[pos++];
+    fitChannels(dp, channels);
+    return pos;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+void sessionBlockBegin(SessionBlockWriter& w, uint8_t* block,
+                       uint32_t startTime, uint32_t firstIndex) {
+    memset(block, 0xFF, SESSION_BLOCK_BYTES);
+
+    SessionBlockHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic      = SESSION_BLOCK_MAGIC;
+    hdr.startTime  = startTime;
+    hdr.firstIndex = firstIndex;
+    hdr.version    = SESSION_LOG_VERSION;
+    hdr.channels   = NUM_PROBES;
+    memcpy(block, &hdr, sizeof(hdr));
+
+    w.block = block;
+    w.pos   = 0;
+    w.count = 0;
+    memset(&w.prev, 0, sizeof(w.prev));
+}
+
+bool sessionBlockAdd(SessionBlockWriter& w, const DataPoint& dp) {
+    uint8_t* payload = w.block + sizeof(SessionBlockHeader);
+    if (w.count == 0xFFFF) return false;
+
+    if (w.count == 0) {
+        // Always fits (static_assert in the header)
+        putKeyframe(payload + w.pos, dp);
+        w.pos += SESSION_KEYFRAME_BYTES;
+    } else {
+        const DataPoint& p = w.prev;
+        int32_t dt = (int32_t)(dp.timestamp - p.timestamp);
+
+        uint8_t rec[SESSION_RECORD_MAX];
+        uint8_t n = 1;
+        uint8_t mask = 0;
+        if (dt != kNominalDt) {
+            mask |= REC_DT;
+            n += putZigzag(rec + n, dt);
+        }
+
+        uint8_t ext = 0;
+        for (uint8_t c = 3; c < NUM_PROBES; c++) {
+            if (dp.temp[c] != p.temp[c]) ext |= (uint8_t)(1u << (c - 3));
+        }
+        if (dp.discExt != p.discExt) ext |= EXT_DISC;
+        if (dp.alarmExt != p.alarmExt) ext |= EXT_ALARM;
+        if (ext) {
+            mask |= REC_EXT;
+            rec[n++] = ext;
+        }
+
+        // Channels 0-2, fan, damper in REC_PIT..REC_DAMPER bit order
+        int32_t d[5] = {
+            dp.temp[0] - p.temp[0], dp.temp[1] - p.temp[1], dp.temp[2] - p.temp[2],
+            dp.fanPct - p.fanPct,   dp.damperPct - p.damperPct
+        };
+        for (uint8_t i = 0; i < 5; i++) {
+            if (d[i] == 0) continue;
+            mask |= (uint8_t)(REC_PIT << i);
+            n += putZigzag(rec + n, d[i]);
+        }
+        for (uint8_t c = 3; c < NUM_PROBES; c++) {
+            if (ext & (1u << (c - 3))) n += putZigzag(rec + n, dp.temp[c] - p.temp[c]);
+        }
+        if (dp.flags != p.flags) {
+            mask |= REC_FLAGS;
+            rec[n++] = dp.flags;
+        }
+        if (ext & EXT_DISC) rec[n++] = dp.discExt;
+        if (ext & EXT_ALARM) rec[n++] = dp.alarmExt;
+        rec[0] = mask;
+
+        if (w.pos + n > SESSION_BLOCK_PAYLOAD) return false;
+        memcpy(payload + w.pos, rec, n);
+        w.pos += n;
+    }
+
+    w.prev = dp;
+    w.count++;
+    return true;
+}
+
+void sessionBlockEnd(SessionBlockWriter& w) {
+    SessionBlockHeader hdr;
+    memcpy(&hdr, w.block, sizeof(hdr));
+    hdr.count = w.count;
+    hdr.crc = blockCrc(hdr, w.block + sizeof(SessionBlockHeader));
+    memcpy(w.block, &hdr, sizeof(hdr));
+}
+
+uint16_t sessionEncodeBlock(uint8_t* block, uint32_t startTime, uint32_t firstIndex,
+                            const DataPoint* points, uint16_t count) {
+    SessionBlockWriter w;
+    sessionBlockBegin(w, block, startTime, firstIndex);
+    while (w.count < count && sessionBlockAdd(w, points[w.count])) {}
+    sessionBlockEnd(w);
+    return w.count;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+bool sessionDecodeBlock(const uint8_t* block, SessionBlockHeader& hdr) {
+    memcpy(&hdr, block, sizeof(hdr));
+    if (hdr.magic != SESSION_BLOCK_MAGIC || hdr.count == 0) return false;
+    if (hdr.version > SESSION_LOG_VERSION) return false;
+    if (hdr.version == 0 && (NUM_PROBES != 3 ||
+                             hdr.count > SESSION_BLOCK_PAYLOAD / sizeof(DataPoint))) return false;
+    if (hdr.version >= 2 && (hdr.channels < 3 || hdr.channels > PROBE_MAX)) return false;
+    return blockCrc(hdr, block + sizeof(SessionBlockHeader)) == hdr.crc;
+}
+
+void sessionPointsBegin(SessionBlockPoints& it, const uint8_t* block,
+                        const SessionBlockHeader& hdr) {
+    it.block   = block + sizeof(SessionBlockHeader);
+    it.version  = hdr.version;
+    it.channels = hdr.version >= 2 ? hdr.channels : 3;
+    it.pos      = 0;
+    it.left    = hdr.count;
+    memset(&it.prev, 0, sizeof(it.prev));
+}
+
+bool sessionPointsNext(SessionBlockPoints& it, DataPoint& out) {
+    if (it.left == 0) return false;
+    const uint16_t end = SESSION_BLOCK_PAYLOAD;
+
+    if (it.version == 0) {
+        memcpy(&out, it.block + it.pos, sizeof(DataPoint));
+        out.discExt  = 0;   // Struct padding before the channel table
+        out.alarmExt = 0;
+        it.pos += sizeof(DataPoint);
+        it.left--;
+        return true;
+    }
+
+    if (it.pos == 0) {
+        it.pos = getKeyframe(it.block, it.version, it.channels, it.prev);
+    } else {
+        if (it.pos >= end) { it.left = 0; return false; }
+        uint8_t mask = it.block[it.pos++];
+        DataPoint dp = it.prev;
+        int32_t v;
+
+        if (mask & REC_DT) {
+            if (!getZigzag(it.block, it.pos, end, v)) { it.left = 0; return false; }
+            dp.timestamp += (uint32_t)v;
+        } else {
+            dp.timestamp += (uint32_t)kNominalDt;
+        }
+
+        uint8_t ext = 0;
+        if (mask & REC_EXT) {
+            if (it.pos >= end) { it.left = 0; return false; }
+            ext = it.block[it.pos++];
+        }
+
+        uint8_t* pcts[2] = { &dp.fanPct, &dp.damperPct };
+        for (uint8_t i = 0; i < 5; i++) {
+            if (!(mask & (REC_PIT << i))) continue;
+            if (!getZigzag(it.block, it.pos, end, v)) { it.left = 0; return false; }
+            if (i < 3) dp.temp[i] = (int16_t)(dp.temp[i] + v);
+            else       *pcts[i - 3] = (uint8_t)(*pcts[i - 3] + v);
+        }
+        for (uint8_t c = 3; c < it.channels; c++) {
+            if (!(ext & (1u << (c - 3)))) continue;
+            if (!getZigzag(it.block, it.pos, end, v)) { it.left = 0; return false; }
+            if (c < NUM_PROBES) dp.temp[c] = (int16_t)(dp.temp[c] + v);
+        }
+
+        if (mask & REC_FLAGS) {
+            if (it.pos >= end) { it.left = 0; return false; }
+            dp.flags = it.block[it.pos++];
+        }
+        if (ext & EXT_DISC) {
+            if (it.pos >= end) { it.left = 0; return false; }
+            dp.discExt = it.block[it.pos++];
+        }
+        if (ext & EXT_ALARM) {
+            if (it.pos >= end) { it.left = 0; return false; }
+            dp.alarmExt = it.block[it.pos++];
+        }
+        fitChannels(dp, it.channels);
+        it.prev = dp;
+    }
+
+    out = it.prev;
+    it.left--;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Log scan / search
+// ---------------------------------------------------------------------------
+
+SessionLogScan sessionLogScan(SessionBlockReader read, void* ctx, uint32_t maxBlocks) {
+    SessionLogScan scan = { 0, 0, 0, false };
+    alignas(4) uint8_t block[SESSION_BLOCK_BYTES];
+    uint32_t lastTs = 0;
+
+    while (scan.blocks < maxBlocks) {
+        if (!read(scan.blocks, block, ctx)) break;
+
+        SessionBlockHeader hdr;
+        bool ok = sessionDecodeBlock(block, hdr) &&
+                  hdr.firstIndex == scan.points &&
+                  (scan.blocks == 0 || hdr.startTime == scan.startTime);
+
+        // A stale block left past a rewritten one can line up on index,
+        // but not on time. Every point must also unpack.
+        uint32_t firstTs = 0, ts = 0;
+        if (ok) {
+            SessionBlockPoints it;
+            DataPoint dp;
+            uint16_t n = 0;
+            sessionPointsBegin(it, block, hdr);
+            while (sessionPointsNext(it, dp)) {
+                if (n++ == 0) firstTs = dp.timestamp;
+                ts = dp.timestamp;
+            }
+            ok = n == hdr.count && firstTs >= lastTs;
+        }
+
+        if (!ok) {
+            scan.torn = true;
+            break;
+        }
+
+        if (scan.blocks == 0) scan.startTime = hdr.startTime;
+        lastTs = ts;
+        scan.points += hdr.count;
+        scan.blocks++;
+    }
+    return scan;
+}
+
+// Which way index lies from a block: -1 before it, 0 inside, 1 after,
+// 2 if the block can't be read or decoded
+static int8_t probe(SessionBlockReader read, void* ctx, uint32_t b,
+                    uint32_t index, uint8_t* block) {
+    SessionBlockHeader hdr;
+    if (!read(b, block, ctx) || !sessionDecodeBlock(block, hdr)) return 2;
+    if (index < hdr.firstIndex) return -1;
+    if (index >= hdr.firstIndex + hdr.count) return 1;
+    return 0;
+}
+
+int32_t sessionLogFind(SessionBlockReader read, void* ctx, uint32_t blocks,
+                       uint32_t index, uint32_t hint, uint8_t* block) {
+    if (blocks == 0) return -1;
+
+    if (hint < blocks) {
+        int8_t r = probe(read, ctx, hint, index, block);
+        if (r == 0) return (int32_t)hint;
+        if (r == 2) return -1;
+    }
+
+    uint32_t lo = 0, hi = blocks;   // Search [lo, hi)
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int8_t r = probe(read, ctx, mid, index, block);
+        if (r == 0) return (int32_t)mid;
+        if (r == 2) return -1;
+        if (r < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return -1;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "config.h"
+#include "data_point.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Block framing for the append-only session log.
+//
+// The log is a sequence of fixed SESSION_BLOCK_BYTES blocks (one flash page)
+// split across segment files of SESSION_SEGMENT_BLOCKS blocks each. Every
+// block carries the session start time, the absolute index of its first
+// point and a CRC-32 over header and payload, and is written with a single
+// write. A power cut can only tear the block being written; the recovery
+// scan accepts blocks while they are intact and contiguous and stops at the
+// first one that isn't, which is then overwritten by the next flush.
+//
+// Payload formats (SessionBlockHeader.version):
+//   0  Raw DataPoint structs, sizeof(DataPoint) each. Read only, and only
+//      by a three-channel build.
+//   1  Packed: a 13-byte little-endian keyframe, then one record per point.
+//      A record is a change mask byte followed by only the fields that
+//      changed: the timestamp step as a zigzag varint (when it isn't
+//      SESSION_SAMPLE_INTERVAL), zigzag varint deltas for the three temps,
+//      fan and damper, and the flags byte. A steady 5 s sample is 1-3
+//      bytes instead of 16, so a block holds about a hundred points.
+//      Read only.
+//   2  Version 1 for any number of probe channels (header `channels`).
+//      The keyframe carries every channel's temp and the discExt byte. A
+//      record with REC_EXT set has an extension byte after the timestamp
+//      step, naming which channels past the first three changed (bit 0 =
+//      channel 3) and whether discExt follows (bit 7); those deltas come
+//      after the damper. Channels a block has and the build doesn't are
+//      skipped; channels the build has and the block doesn't read as
+//      disconnected. Read only.
+//   3  Version 2 plus the alarmExt byte: last in the keyframe, and after
+//      discExt in a record whose extension byte has bit 6 set.
+//
+// Pure C++ over a block reader callback, so it's testable on native.
+
+#define SESSION_BLOCK_MAGIC   0x4B4C4253UL   // "SBLK"
+#define SESSION_LOG_VERSION   3              // Format written by this firmware
+
+struct SessionBlockHeader {
+    uint32_t magic;
+    uint32_t startTime;     // Session start epoch (ties the block to its cook)
+    uint32_t firstIndex;    // Absolute index of the block's first point
+    uint16_t count;         // Points in this block (>= 1)
+    uint8_t  version;       // Payload format
+    uint8_t  channels;      // Probe channels per point (version 2+; 0 before)
+    uint32_t crc;           // CRC-32 of the header (crc = 0) and payload
+};
+
+#define SESSION_BLOCK_PAYLOAD  (SESSION_BLOCK_BYTES - sizeof(SessionBlockHeader))
+#define SESSION_KEYFRAME_BYTES (4 + 2 * NUM_PROBES + 5)   // ts, temps, fan, damper, flags, discExt, alarmExt
+#define SESSION_RECORD_MAX     (14 + 3 * NUM_PROBES)      // Mask + dt(5) + ext + temps(3 each) + fan/damper(2 each) + flags + discExt + alarmExt
+
+static_assert(SESSION_BLOCK_PAYLOAD >= sizeof(DataPoint) + SESSION_RECORD_MAX,
+              "SESSION_BLOCK_BYTES too small");
+
+// CRC-32 (IEEE, reflected). Pass a previous result to continue a running CRC.
+uint32_t sessionCrc32(const void* data, size_t len, uint32_t crc = 0);
+
+// Builds one packed block point by point, so the caller needn't gather the
+// points into an array. Unused space is left 0xFF (erased flash).
+struct SessionBlockWriter {
+    uint8_t*  block;
+    uint16_t  pos;          // Payload bytes used
+    uint16_t  count;
+    DataPoint prev;
+};
+
+void sessionBlockBegin(SessionBlockWriter& w, uint8_t* block,
+                       uint32_t startTime, uint32_t firstIndex);
+
+// Append a point. False (and nothing written) when the block is full.
+bool sessionBlockAdd(SessionBlockWriter& w, const DataPoint& point);
+
+// Seal the header and CRC. Call once, after at least one point was added.
+void sessionBlockEnd(SessionBlockWriter& w);
+
+// Convenience: pack as many of points[0..count) as fit. Returns points stored.
+uint16_t sessionEncodeBlock(uint8_t* block, uint32_t startTime, uint32_t firstIndex,
+                            const DataPoint* points, uint16_t count);
+
+// Check a block's framing and CRC. Returns false for torn, corrupt,
+// never-written or unknown-version blocks.
+bool sessionDecodeBlock(const uint8_t* block, SessionBlockHeader& hdr);
+
+// Walks the points of a block that passed sessionDecodeBlock()
+struct SessionBlockPoints {
+    const uint8_t* block;
+    uint8_t   version;
+    uint8_t   channels;     // In the block, not the build
+    uint16_t  pos;
+    uint16_t  left;
+    DataPoint prev;
+};
+
+void sessionPointsBegin(SessionBlockPoints& it, const uint8_t* block,
+                        const SessionBlockHeader& hdr);
+
+// Next point in time order. False once all count points have been read,
+// or if a record runs off the end of the payload.
+bool sessionPointsNext(SessionBlockPoints& it, DataPoint& out);
+
+// Reads one whole block by log position into out. Returns false if the
+// block doesn't exist (past the end of its segment file, or no file).
+typedef bool (*SessionBlockReader)(uint32_t block, uint8_t* out, void* ctx);
+
+struct SessionLogScan {
+    uint32_t blocks;        // Valid blocks from the start of the log
+    uint32_t points;        // Points in those blocks
+    uint32_t startTime;     // Session start from block 0 (0 = empty log)
+    bool     torn;          // Scan stopped at a block that exists but is invalid
+};
+
+// Walk the log from block 0, accepting blocks that decode, belong to block
+// 0's session and continue its point indices and timestamps without a gap.
+SessionLogScan sessionLogScan(SessionBlockReader read, void* ctx, uint32_t maxBlocks);
+
+// Find the block holding absolute point index among the first `blocks`
+// valid blocks, reading it into block. hint is tried first (e.g. the block
+// after the last one read); the rest is a binary search on firstIndex.
+// Returns the block position, or -1.
+int32_t sessionLogFind(SessionBlockReader read, void* ctx, uint32_t blocks,
+                       uint32_t index, uint32_t hint, uint8_t* block);
@@ -0,0 +1,191 @@
+// Headless batch runner (see sim_batch.h). Built by [env:simbatch] only.
+
+#ifdef SIM_BATCH_BUILD
+
+#include "sim_batch.h"
+#include "sim_thermal.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// The firmware modules are compiled into this file under NATIVE_BUILD, as
+// the native tests do, so the simulator's SDL build is untouched
+#include "sim_string.h"
+
+#include "../pid_controller.cpp"
+#include "../pid_autotune.cpp"
+#include "../alarm_manager.cpp"
+#include "../cook_session.cpp"
+#include "../session_archive.cpp"
+#include "../session_events.cpp"
+#include "../session_log.cpp"
+#include "../ext_ram.cpp"
+
+SimBatchConfig simBatchDefaults() {
+    SimBatchConfig c;
+    c.hours       = 16.0f;
+    c.sampleMs    = PID_SAMPLE_MS;
+    c.kp          = PID_KP;
+    c.ki          = PID_KI;
+    c.kd          = PID_KD;
+    c.dFilterN    = PID_D_FILTER_N;
+    c.feedForward = PID_FEEDFORWARD;
+    c.fanMode     = "fan_and_damper";
+    c.fanOnThreshold = FAN_ON_THRESHOLD;
+    c.seed        = 1;
+    c.recordSession = true;
+    c.logEvents   = true;
+    return c;
+}
+
+static int16_t packTemp(float f, bool connected) {
+    return connected ? (int16_t)lroundf(f * 10.0f) : 0;
+}
+
+SimBatchMetrics runSimBatch(const SimProfile& profile, const SimBatchConfig& cfg) {
+    auto wallStart = std::chrono::steady_clock::now();
+
+    SimThermalModel model;
+    model.init(profile, cfg.seed);
+    model.setFanMode(cfg.fanMode);
+    model.setFanOnThreshold(cfg.fanOnThreshold);
+    model.externalControl = true;
+    model.logEvents = cfg.logEvents;
+
+    PidController pid;
+    pid.begin(cfg.kp, cfg.ki, cfg.kd);
+    pid.setSampleMs(cfg.sampleMs);
+    pid.setDerivativeFilter(cfg.dFilterN);
+    pid.setFeedForward(cfg.feedForward);
+    pid.setFanMode(fanModeParse(cfg.fanMode));
+
+    AlarmManager alarms;
+    alarms.begin();
+    alarms.setMeatTarget(0, profile.meat1Target);
+    alarms.setMeatTarget(1, profile.meat2Target);
+
+    static CookSession session;
+    static bool sessionReady = false;
+    if (cfg.recordSession) {
+        if (!sessionReady) {
+            session.begin();
+            sessionReady = true;
+        }
+        session.startSession();
+    }
+
+    SimBatchMetrics m;
+    memset(&m, 0, sizeof(m));
+    m.timeToSetpointMin = -1.0f;
+    m.meat1DoneHours = -1.0f;
+    m.meat2DoneHours = -1.0f;
+
+    const uint32_t endSec = (uint32_t)(cfg.hours * 3600.0f);
+    const uint32_t sampleSec = SESSION_SAMPLE_INTERVAL / 1000;
+    float sp = model.setpoint, prevSp = sp;
+    SimResult r = model.update(0.0f);
+    float pit = r.pitTemp;               // Through TempManager's EMA
+    float lastOut = -1.0f;
+    uint32_t sinceCompute = cfg.sampleMs;
+    bool reached = false, wasLid = false;
+    uint32_t bandSec = 0, alarmBandSec = 0, trackedSec = 0, fanOnSec = 0;
+    double fanSum = 0.0, damperSum = 0.0;
+    bool pitAlarmActive = false;
+
+    for (uint32_t t = 0; t < endSec; t++) {
+        // Control task: PID at its sample interval, as in controlTick()
+        sp = model.setpoint;             // Profile events may change it
+        if (sinceCompute >= cfg.sampleMs) {
+            sinceCompute = 0;
+            if (sp != prevSp) {
+                pid.stepSetpoint(prevSp, sp);
+                reached = false;
+                prevSp = sp;
+            }
+            float out = pid.compute(pit, sp);
+            model.controlOutput = out;
+            if (lastOut >= 0.0f) m.outputTravelPerHour += fabsf(out - lastOut);
+            lastOut = out;
+
+            bool lid = pid.isLidOpen();
+            if (lid && !wasLid) m.lidEvents++;
+            wasLid = lid;
+        }
+
+        r = model.update(1.0f);
+        sinceCompute += 1000;
+        pit += TEMP_EMA_ALPHA * (r.pitTemp - pit);
+
+        float err = r.pitTemp - sp;
+        if (!reached && fabsf(err) <= SIM_BATCH_BAND) {
+            reached = true;
+            if (m.timeToSetpointMin < 0.0f) m.timeToSetpointMin = t / 60.0f;
+        }
+        if (reached) {
+            if (err > m.overshoot) m.overshoot = err;
+            trackedSec++;
+            if (fabsf(err) <= SIM_BATCH_BAND) bandSec++;
+            if (fabsf(err) <= ALARM_PIT_BAND_DEFAULT) alarmBandSec++;
+        }
+        fanSum += r.fanPercent;
+        damperSum += r.damperPercent;
+        if (r.fanPercent > 0.0f) fanOnSec++;
+
+        // Alarms, as the control task feeds them; the model has two meat probes
+        float meats[NUM_MEATS];
+        for (float& v : meats) v = NAN;
+        meats[0] = r.meat1Connected ? r.meat1Temp : NAN;
+        meats[1] = r.meat2Connected ? r.meat2Temp : NAN;
+        alarms.update(r.pitTemp, meats, sp, reached);
+        AlarmType active[MAX_ACTIVE_ALARMS];
+        uint8_t n = alarms.getActiveAlarms(active, MAX_ACTIVE_ALARMS);
+        bool pitAlarm = false;
+        for (uint8_t i = 0; i < n; i++) {
+            if (active[i] == AlarmType::PIT_HIGH || active[i] == AlarmType::PIT_LOW) pitAlarm = true;
+            if (active[i] == AlarmType::MEAT1_DONE && m.meat1DoneHours < 0.0f) m.meat1DoneHours = t / 3600.0f;
+            if (active[i] == AlarmType::MEAT2_DONE && m.meat2DoneHours < 0.0f) m.meat2DoneHours = t / 3600.0f;
+        }
+        if (pitAlarm && !pitAlarmActive) m.pitAlarms++;
+        pitAlarmActive = pitAlarm;
+
+        // loop(): session sample every SESSION_SAMPLE_INTERVAL
+        if (cfg.recordSession && t % sampleSec == 0) {
+            DataPoint p;
+            memset(&p, 0, sizeof(p));
+            p.timestamp = t;
+            p.temp[PROBE_PIT]   = packTemp(r.pitTemp, true);
+            p.temp[PROBE_MEAT1] = packTemp(r.meat1Temp, r.meat1Connected);
+            p.temp[PROBE_MEAT2] = packTemp(r.meat2Temp, r.meat2Connected);
+            p.fanPct    = (uint8_t)r.fanPercent;
+            p.damperPct = (uint8_t)r.damperPercent;
+            p.flags     = 0;
+            if (r.lidOpen)         p.flags |= DP_FLAG_LID_OPEN;
+            if (r.fireOut)         p.flags |= DP_FLAG_ERROR_FIREOUT;
+            if (!r.meat1Connected) p.flags |= DP_FLAG_MEAT1_DISC;
+            if (!r.meat2Connected) p.flags |= DP_FLAG_MEAT2_DISC;
+            // The model has three probes; any further channels are unplugged
+            dpSetDiscMask(p, dpDiscMask(p) | (uint16_t)(((1u << NUM_PROBES) - 1) & ~0x07u));
+            session.addPoint(p);
+        }
+    }
+
+    m.simHours = endSec / 3600.0f;
+    if (trackedSec > 0) {
+        m.inBandPct = 100.0f * bandSec / trackedSec;
+        m.inAlarmBandPct = 100.0f * alarmBandSec / trackedSec;
+    }
+    if (endSec > 0) {
+        m.fanDutyPct = (float)(fanSum / endSec);
+        m.damperMeanPct = (float)(damperSum / endSec);
+        m.fanOnPct = 100.0f * fanOnSec / endSec;
+        m.outputTravelPerHour /= m.simHours;
+    }
+    if (cfg.recordSession) m.sessionPoints = session.getTotalPointCount();
+    m.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return m;
+}
+
+#endif // SIM_BATCH_BUILD
@@ -0,0 +1,54 @@
+#pragma once
+
+// Headless batch runs for the desktop simulator.
+//
+// A batch run steps the thermal model on a virtual 1 s clock as fast as the
+// CPU allows. The firmware's own PidController (at its sample rate), the
+// split-range mapping inside the model, AlarmManager and CookSession run
+// against it as the control task and loop() would. No LVGL, SDL or web
+// server is involved, so a 16-hour cook takes well under a second and
+// tunings and profiles can be compared quickly.
+
+#include "sim_profiles.h"
+#include <stdint.h>
+
+// Band used for time-to-setpoint, overshoot and time-in-band (degrees F)
+#define SIM_BATCH_BAND  5.0f
+
+struct SimBatchConfig {
+    float       hours;        // Simulated cook length
+    uint32_t    sampleMs;     // PID sample interval
+    float       kp, ki, kd;
+    float       dFilterN;
+    float       feedForward;
+    const char* fanMode;      // "fan_only", "fan_and_damper", "damper_primary"
+    float       fanOnThreshold;
+    unsigned    seed;         // Model noise seed, so runs are repeatable
+    bool        recordSession;  // Feed CookSession (single-threaded runs only)
+    bool        logEvents;      // Print profile events as they fire
+};
+
+// Firmware defaults from config.h, 16 hours, session recorded
+SimBatchConfig simBatchDefaults();
+
+struct SimBatchMetrics {
+    float    simHours;
+    float    timeToSetpointMin;    // Cold start to within the band (-1 = never)
+    float    overshoot;            // Peak above the active setpoint once reached
+    float    inBandPct;            // Time within +/-SIM_BATCH_BAND after first reaching setpoint
+    float    inAlarmBandPct;       // Same, within ALARM_PIT_BAND_DEFAULT
+    float    fanDutyPct;           // Mean fan output
+    float    fanOnPct;             // Time with the fan running
+    float    damperMeanPct;
+    float    outputTravelPerHour;  // Sum of |PID output change| per hour (chatter)
+    uint32_t lidEvents;            // Lid openings the controller detected
+    uint32_t pitAlarms;            // Pit high/low alarm onsets
+    float    meat1DoneHours;       // First meat-done alarm (-1 = none)
+    float    meat2DoneHours;
+    uint32_t sessionPoints;        // Points CookSession recorded
+    double   wallSeconds;          // Real time the run took
+};
+
+// Run one profile to completion. Safe to call from several threads at once
+// when recordSession is false; CookSession's buffers are process-wide.
+SimBatchMetrics runSimBatch(const SimProfile& profile, const SimBatchConfig& cfg);
@@ -0,0 +1,347 @@
+// Headless batch simulator for Pit Claw BBQ Controller
+//
+// Runs a cook profile against the firmware's PID, alarms and session logger
+// on a virtual clock and prints control metrics, with no window:
+//   pio run -e simbatch && .pio/build/simbatch/program
+//   .pio/build/simbatch/program --profile stall --hours 20
+//   .pio/build/simbatch/program --kp 5 --ki 0.03 --kd 4 --sample-ms 2000
+//
+// Any tuning option also takes a list ("3,4,5") or a range ("2:8:0.5"), and
+// --profile takes a list or "all". More than one combination makes a sweep:
+// the runs are spread over every core and the tunings ranked.
+//   .pio/build/simbatch/program --profile all --kp 2:8:1 --ki 0.01:0.05:0.01 --csv sweep.csv
+//
+// --replay runs a recorded cook through the signal path instead (see
+// sim_replay.h):
+//   .pio/build/simbatch/program --replay brisket.csv --meat1 203 --out replay.csv
+
+#ifdef SIM_BATCH_BUILD
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../config.h"
+#include "sim_batch.h"
+#include "sim_profiles.h"
+#include "sim_replay.h"
+#include "sim_sweep.h"
+
+static const ProfileEntry* find_profile(const char* name) {
+    for (int i = 0; i < sim_profile_count; i++) {
+        if (strcmp(sim_profiles[i].key, name) == 0) {
+            return &sim_profiles[i];
+        }
+    }
+    return nullptr;
+}
+
+// "a", "a,b,c" or "lo:hi:step" (items may mix: "1,2:4:1")
+static bool parse_values(const char* arg, std::vector<float>& out) {
+    out.clear();
+    char buf[256];
+    strncpy(buf, arg, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (char* item = strtok(buf, ","); item; item = strtok(nullptr, ",")) {
+        float lo, hi, step;
+        if (sscanf(item, "%f:%f:%f", &lo, &hi, &step) == 3) {
+            if (step <= 0.0f || hi < lo) return false;
+            int n = (int)((hi - lo) / step + 1.001f);
+            for (int k = 0; k < n; k++) out.push_back(lo + k * step);
+        } else {
+            char* end;
+            float v = strtof(item, &end);
+            if (end == item || *end) return false;
+            out.push_back(v);
+        }
+    }
+    return !out.empty();
+}
+
+// Comma-separated names; the strings point into argv
+static void parse_names(char* arg, std::vector<const char*>& out) {
+    out.clear();
+    for (char* item = strtok(arg, ","); item; item = strtok(nullptr, ",")) {
+        out.push_back(item);
+    }
+}
+
+static void print_usage(const char* prog) {
+    SimBatchConfig d = simBatchDefaults();
+    printf("Pit Claw Batch Simulator\n\n");
+    printf("Usage: %s [options]\n\n", prog);
+    printf("Options:\n");
+    printf("  --profile NAME   Cook profile(s), or \"all\" (default: normal)\n");
+    printf("  --hours H        Simulated cook length (default: %.0f)\n", d.hours);
+    printf("  --kp/--ki/--kd X PID tunings (default: %.3g/%.3g/%.3g)\n", d.kp, d.ki, d.kd);
+    printf("  --sample-ms N    PID sample interval (default: %u)\n", (unsigned)d.sampleMs);
+    printf("  --threshold X    Fan-on threshold, %% output (default: %.0f)\n", d.fanOnThreshold);
+    printf("  --fan-mode MODE  fan_only, fan_and_damper or damper_primary\n");
+    printf("  --ff X           Setpoint feed-forward, %% per degree (default: %.2g)\n", d.feedForward);
+    printf("  --dfilter N      Derivative filter N (default: %.3g)\n", d.dFilterN);
+    printf("  --seed N         Model noise seed (default: %u)\n", d.seed);
+    printf("\nSweeps (kp, ki, kd, sample-ms, threshold, fan-mode and profile take\n");
+    printf("lists \"a,b\" and numeric ranges \"lo:hi:step\"):\n");
+    printf("  --jobs N         Worker threads (default: one per core)\n");
+    printf("  --top N          Leaderboard rows to print (default: 10)\n");
+    printf("  --csv FILE       Write every run to FILE\n");
+    printf("  --json FILE      Write the ranked tunings to FILE\n");
+    printf("\nReplay of a recorded cook:\n");
+    printf("  --replay PATH    Session log directory, session.dat or CSV export\n");
+    printf("  --setpoint X     Pit setpoint until the journal sets one (default: 225)\n");
+    printf("  --meatN X        Meat N target until the journal sets one, N = 1..%u (default: none)\n",
+           (unsigned)NUM_MEATS);
+    printf("  --ema X          TempManager EMA alpha (default: %.2g)\n", (float)TEMP_EMA_ALPHA);
+    printf("  --lut            Use the conversion lookup table\n");
+    printf("  --celsius        Trace was recorded in Celsius\n");
+    printf("  --out FILE       Write the replayed signals per point to FILE\n");
+    printf("\nAvailable profiles:\n");
+    for (int i = 0; i < sim_profile_count; i++) {
+        printf("  %-18s %s\n", sim_profiles[i].key, sim_profiles[i].profile->name);
+    }
+}
+
+static void print_hours(const char* label, float h) {
+    if (h < 0.0f) printf("  %-22s -\n", label);
+    else          printf("  %-22s %.2f h\n", label, h);
+}
+
+static void print_run(const SimProfile& profile, const SimBatchConfig& cfg) {
+    printf("[SIM] Batch: %s profile, %.1f h, Kp=%.3g Ki=%.3g Kd=%.3g, %u ms, %s\n",
+           profile.name, cfg.hours, cfg.kp, cfg.ki, cfg.kd, (unsigned)cfg.sampleMs, cfg.fanMode);
+
+    SimBatchMetrics m = runSimBatch(profile, cfg);
+
+    if (m.timeToSetpointMin < 0.0f) printf("  %-22s never\n", "time to setpoint");
+    else                            printf("  %-22s %.1f min\n", "time to setpoint", m.timeToSetpointMin);
+    printf("  %-22s %.1f F\n", "overshoot", m.overshoot);
+    printf("  %-22s %.1f%% (+/-%.0f F), %.1f%% (+/-%.0f F)\n", "time in band",
+           m.inBandPct, SIM_BATCH_BAND, m.inAlarmBandPct, (float)ALARM_PIT_BAND_DEFAULT);
+    printf("  %-22s %.1f%% mean, on %.1f%% of the time\n", "fan duty", m.fanDutyPct, m.fanOnPct);
+    printf("  %-22s %.1f%% mean\n", "damper", m.damperMeanPct);
+    printf("  %-22s %.0f %%/h\n", "output travel", m.outputTravelPerHour);
+    printf("  %-22s %u\n", "lid events", (unsigned)m.lidEvents);
+    printf("  %-22s %u\n", "pit alarms", (unsigned)m.pitAlarms);
+    print_hours("meat 1 done", m.meat1DoneHours);
+    print_hours("meat 2 done", m.meat2DoneHours);
+    printf("  %-22s %u\n", "session points", (unsigned)m.sessionPoints);
+    printf("[SIM] %.1f h simulated in %.2f s (%.0fx real time)\n",
+           m.simHours, m.wallSeconds, m.wallSeconds > 0 ? m.simHours * 3600.0 / m.wallSeconds : 0.0);
+}
+
+static void print_replay_probe(const char* name, const SimReplayProbe& pr, bool meat) {
+    if (!pr.present) {
+        printf("  %-8s not connected\n", name);
+        return;
+    }
+    printf("  %-8s jitter %.2f -> %.2f per point, rms filtered-recorded %.2f\n",
+           name, pr.inputJitter, pr.outputJitter, pr.rmsDelta);
+    if (!meat) return;
+    if (pr.reachedHours < 0.0f) {
+        printf("  %-8s target not reached in trace\n", "");
+    } else {
+        printf("  %-8s reached target %.2f h, alarm %s", "", pr.reachedHours,
+               pr.alarmHours < 0.0f ? "never" : "");
+        if (pr.alarmHours >= 0.0f) printf("%.2f h", pr.alarmHours);
+        printf("\n");
+    }
+    if (pr.etaMaeMin >= 0.0f) {
+        printf("  %-8s ETA error %.0f min mean, %.0f / %.0f / %.0f min at 50/75/90%%\n", "",
+               pr.etaMaeMin, pr.etaErrMin[0], pr.etaErrMin[1], pr.etaErrMin[2]);
+    }
+    if (pr.stallHours > 0.0f) printf("  %-8s stall reported for %.2f h\n", "", pr.stallHours);
+}
+
+static int run_replay(const char* path, SimReplayConfig cfg, const char* outPath) {
+    std::vector<DataPoint> trace;
+    static SessionEventJournal events;
+    if (!loadTrace(path, trace, events)) return 1;
+    if (outPath) {
+        cfg.out = fopen(outPath, "w");
+        if (!cfg.out) {
+            fprintf(stderr, "Failed to write %s\n", outPath);
+            return 1;
+        }
+    }
+
+    printf("[SIM] Replay: %s, %zu points, ", path, trace.size());
+    if (events.count()) printf("%u journalled events\n", (unsigned)events.count());
+    else                printf("setpoint %.0f\n", cfg.setpoint);
+    SimReplayMetrics m = runSimReplay(trace, events, cfg);
+    if (cfg.out) fclose(cfg.out);
+
+    printf("  %.1f h of cook, %u gap%s\n", m.hours, (unsigned)m.gaps, m.gaps == 1 ? "" : "s");
+    for (uint8_t k = 0; k < NUM_PROBES; k++) {
+        print_replay_probe(kProbeChannels[k].key, m.probe[k], k != PROBE_PIT);
+    }
+    printf("  %-8s %u pit alarm%s, %u probe fault%s, fire out %s", "events",
+           (unsigned)m.pitAlarms, m.pitAlarms == 1 ? "" : "s",
+           (unsigned)m.probeFaults, m.probeFaults == 1 ? "" : "s",
+           m.fireOutHours < 0.0f ? "never" : "");
+    if (m.fireOutHours >= 0.0f) printf("at %.2f h", m.fireOutHours);
+    printf("\n[SIM] %.1f h replayed in %.3f s (%.0fx real time)\n", m.hours, m.wallSeconds,
+           m.wallSeconds > 0 ? m.hours * 3600.0 / m.wallSeconds : 0.0);
+    if (outPath) printf("[SIM] Wrote %s\n", outPath);
+    return 0;
+}
+
+static int run_sweep(const SimSweepGrid& grid, unsigned jobs, unsigned top,
+                     const char* csvPath, const char* jsonPath) {
+    size_t runs = simSweepRunCount(grid);
+    printf("[SIM] Sweep: %zu tunings x %zu profiles = %zu runs of %.1f h\n",
+           runs / grid.profiles.size(), grid.profiles.size(), runs, grid.base.hours);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<SimSweepEntry> board = runSimSweep(grid, jobs);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("\n%4s %7s %8s %7s %6s %4s %-15s %8s %8s %8s %8s %6s\n",
+           "rank", "kp", "ki", "kd", "ms", "thr", "fan mode",
+           "in band", "worst", "over", "worst", "alarms");
+    for (size_t r = 0; r < board.size() && r < top; r++) {
+        const SimSweepEntry& e = board[r];
+        printf("%4zu %7.3g %8.4g %7.3g %6u %4.0f %-15s %7.1f%% %7.1f%% %7.1fF %7.1fF %6u\n",
+               r + 1, e.cfg.kp, e.cfg.ki, e.cfg.kd, (unsigned)e.cfg.sampleMs,
+               e.cfg.fanOnThreshold, e.cfg.fanMode,
+               e.meanInBandPct, e.worstInBandPct, e.meanOvershoot, e.worstOvershoot,
+               (unsigned)e.pitAlarms);
+    }
+    printf("\n[SIM] %zu runs in %.2f s\n", runs, wall);
+
+    if (csvPath) {
+        if (!writeSimSweepCsv(csvPath, grid, board)) {
+            fprintf(stderr, "Failed to write %s\n", csvPath);
+            return 1;
+        }
+        printf("[SIM] Wrote %s\n", csvPath);
+    }
+    if (jsonPath) {
+        if (!writeSimSweepJson(jsonPath, grid, board)) {
+            fprintf(stderr, "Failed to write %s\n", jsonPath);
+            return 1;
+        }
+        printf("[SIM] Wrote %s\n", jsonPath);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    SimSweepGrid grid;
+    grid.base = simBatchDefaults();
+    grid.kp = { grid.base.kp };
+    grid.ki = { grid.base.ki };
+    grid.kd = { grid.base.kd };
+    grid.sampleMs = { (float)grid.base.sampleMs };
+    grid.fanOnThreshold = { grid.base.fanOnThreshold };
+    grid.fanModes = { grid.base.fanMode };
+    std::vector<const char*> profileNames = { "normal" };
+    unsigned jobs = 0, top = 10;
+    const char* csvPath = nullptr;
+    const char* jsonPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* replayOut = nullptr;
+    SimReplayConfig replay = simReplayDefaults();
+
+    struct ValueOption { const char* name; std::vector<float>* values; };
+    ValueOption valueOptions[] = {
+        { "--kp", &grid.kp }, { "--ki", &grid.ki }, { "--kd", &grid.kd },
+        { "--sample-ms", &grid.sampleMs }, { "--threshold", &grid.fanOnThreshold },
+    };
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        unsigned meat;
+        char junk;
+        bool matched = false;
+        for (ValueOption& o : valueOptions) {
+            if (strcmp(argv[i], o.name) == 0 && hasValue) {
+                if (!parse_values(argv[++i], *o.values)) {
+                    fprintf(stderr, "Bad value for %s: %s\n", o.name, argv[i]);
+                    return 1;
+                }
+                matched = true;
+                break;
+            }
+        }
+        if (matched) continue;
+
+        if (strcmp(argv[i], "--profile") == 0 && hasValue) {
+            parse_names(argv[++i], profileNames);
+        } else if (strcmp(argv[i], "--fan-mode") == 0 && hasValue) {
+            parse_names(argv[++i], grid.fanModes);
+        } else if (strcmp(argv[i], "--hours") == 0 && hasValue) {
+            grid.base.hours = (float)atof(argv[++i]);
+            if (grid.base.hours <= 0.0f) grid.base.hours = 1.0f;
+        } else if (strcmp(argv[i], "--ff") == 0 && hasValue) {
+            grid.base.feedForward = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--dfilter") == 0 && hasValue) {
+            grid.base.dFilterN = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            grid.base.seed = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jobs") == 0 && hasValue) {
+            jobs = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--top") == 0 && hasValue) {
+            top = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && hasValue) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--setpoint") == 0 && hasValue) {
+            replay.setpoint = (float)atof(argv[++i]);
+        } else if (sscanf(argv[i], "--meat%u%c", &meat, &junk) == 1 && meat >= 1 &&
+                   meat <= NUM_MEATS && hasValue) {
+            replay.meatTarget[meat - 1] = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ema") == 0 && hasValue) {
+            replay.emaAlpha = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--lut") == 0) {
+            replay.useLookupTable = true;
+        } else if (strcmp(argv[i], "--celsius") == 0) {
+            replay.fahrenheit = false;
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            replayOut = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (replayPath) return run_replay(replayPath, replay, replayOut);
+
+    for (const char* name : profileNames) {
+        if (strcmp(name, "all") == 0) {
+            grid.profiles.clear();
+            for (int p = 0; p < sim_profile_count; p++) grid.profiles.push_back(&sim_profiles[p]);
+            break;
+        }
+        const ProfileEntry* entry = find_profile(name);
+        if (!entry) {
+            fprintf(stderr, "Unknown profile: %s\n", name);
+            print_usage(argv[0]);
+            return 1;
+        }
+        grid.profiles.push_back(entry);
+    }
+
+    if (simSweepRunCount(grid) == 1 && !csvPath && !jsonPath) {
+        SimBatchConfig cfg = grid.base;
+        cfg.kp = grid.kp[0];
+        cfg.ki = grid.ki[0];
+        cfg.kd = grid.kd[0];
+        cfg.sampleMs = (uint32_t)grid.sampleMs[0];
+        cfg.fanOnThreshold = grid.fanOnThreshold[0];
+        cfg.fanMode = grid.fanModes[0];
+        print_run(*grid.profiles[0]->profile, cfg);
+        return 0;
+    }
+    return run_sweep(grid, jobs, top, csvPath, jsonPath);
+}
+
+#endif // SIM_BATCH_BUILD
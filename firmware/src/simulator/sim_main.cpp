@@ -6,6 +6,9 @@
 //   .pio/build/simulator/program --speed 10       # 10x time acceleration
 //   .pio/build/simulator/program --profile stall  # brisket stall scenario
 //   .pio/build/simulator/program --wizard         # test setup wizard flow
+//   .pio/build/simulator/program --autotune       # headless PID relay auto-tune
+//   .pio/build/simulator/program --hub --peer 192.168.1.20 --peer localhost:3001
+//                                                 # merged view of other units at /api/hub
 
 #ifdef SIMULATOR_BUILD
 
@@ -15,6 +18,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <string>
+#include <vector>
 
 #include "../display/ui_init.h"
 #include "../display/ui_update.h"
@@ -22,6 +27,8 @@
 #include "../display/ui_boot_splash.h"
 #include "../web_protocol.h"
 #include "../units.h"
+#include "../pid_autotune.h"
+#include "../metrics.h"
 #include "sim_thermal.h"
 #include "sim_profiles.h"
 #include "sim_web_server.h"
@@ -29,8 +36,7 @@
 // Simulator-local state
 static SimThermalModel* g_model = nullptr;
 static SimWebServer* g_webServer = nullptr;
-static float g_meat1_target = 203;
-static float g_meat2_target = 0;
+static float g_meat_target[NUM_MEATS] = { 203 };   // By meat probe (channel - 1)
 static bool  g_alarm_active = false;
 static uint8_t g_alarm_type = 0;
 static bool  g_alarm_acked = false;
@@ -77,16 +83,17 @@ static void on_setpoint(float sp) {
     }
 }
 
+// The LCD has cards for meat1 and meat2 only
+static void update_meat_target_ui(uint8_t meat, float target) {
+    if (meat == 0) ui_update_meat1_target(target);
+    if (meat == 1) ui_update_meat2_target(target);
+}
+
 static void on_meat_target(uint8_t probe, float target) {
-    if (probe == 1) {
-        g_meat1_target = target;
-        ui_update_meat1_target(target);
-        printf("[SIM] Meat1 target set to %.0f\n", target);
-    } else if (probe == 2) {
-        g_meat2_target = target;
-        ui_update_meat2_target(target);
-        printf("[SIM] Meat2 target set to %.0f\n", target);
-    }
+    if (probe < PROBE_MEAT1 || probe >= NUM_PROBES) return;
+    g_meat_target[probe - PROBE_MEAT1] = target;
+    update_meat_target_ui(probe - PROBE_MEAT1, target);
+    printf("[SIM] %s target set to %.0f\n", kProbeChannels[probe].key, target);
     // Reset alarm state when target changes
     g_alarm_active = false;
     g_alarm_acked = false;
@@ -112,8 +119,8 @@ static void on_units(bool isFahrenheit) {
                         display_temp(g_model->meat2Temp),
                         true, g_model->meat1Connected, g_model->meat2Connected);
     }
-    ui_update_meat1_target(g_meat1_target > 0 ? display_temp(g_meat1_target) : 0);
-    ui_update_meat2_target(g_meat2_target > 0 ? display_temp(g_meat2_target) : 0);
+    ui_update_meat1_target(g_meat_target[0] > 0 ? display_temp(g_meat_target[0]) : 0);
+    ui_update_meat2_target(g_meat_target[1] > 0 ? display_temp(g_meat_target[1]) : 0);
 
     printf("[SIM] Units changed to %s\n", isFahrenheit ? "F" : "C");
 }
@@ -133,8 +140,9 @@ static void reset_session() {
 
     // Reset targets to profile defaults
     if (g_activeProfile) {
-        g_meat1_target = g_activeProfile->meat1Target;
-        g_meat2_target = g_activeProfile->meat2Target;
+        for (float& target : g_meat_target) target = 0;
+        g_meat_target[0] = g_activeProfile->meat1Target;
+        g_meat_target[1] = g_activeProfile->meat2Target;
     }
 
     // Clear UI
@@ -151,14 +159,12 @@ static void reset_session() {
     if (g_model) {
         ui_update_setpoint(g_model->setpoint);
     }
-    ui_update_meat1_target(g_meat1_target);
-    ui_update_meat2_target(g_meat2_target);
+    ui_update_meat1_target(g_meat_target[0]);
+    ui_update_meat2_target(g_meat_target[1]);
 
     // Sync web server state
     if (g_webServer) {
-        g_webServer->setState(
-            g_model ? g_model->setpoint : 225,
-            g_meat1_target, g_meat2_target);
+        g_webServer->setState(g_model ? g_model->setpoint : 225, g_meat_target);
     }
 }
 
@@ -227,15 +233,12 @@ static void web_on_setpoint(float sp) {
 }
 
 static void web_on_alarm(const char* probe, float target) {
-    if (strcmp(probe, "meat1") == 0) {
-        g_meat1_target = target;
-        ui_update_meat1_target(target);
-        printf("[WEB] Meat1 target set to %.0f\n", target);
-    } else if (strcmp(probe, "meat2") == 0) {
-        g_meat2_target = target;
-        ui_update_meat2_target(target);
-        printf("[WEB] Meat2 target set to %.0f\n", target);
-    }
+    uint8_t meat = 0;
+    while (meat < NUM_MEATS && strcmp(probe, kProbeChannels[PROBE_MEAT1 + meat].key) != 0) meat++;
+    if (meat == NUM_MEATS) return;   // pitBand: the sim has no pit alarms
+    g_meat_target[meat] = target;
+    update_meat_target_ui(meat, target);
+    printf("[WEB] %s target set to %.0f\n", probe, target);
     g_alarm_active = false;
     g_alarm_acked = false;
     g_alarm_type = 0;
@@ -262,6 +265,9 @@ static void print_usage(const char* prog) {
     printf("  --profile NAME Cook profile (default: normal)\n");
     printf("  --port N       Web server port (default: 3000)\n");
     printf("  --wizard       Force setup wizard (resets saved setup state)\n");
+    printf("  --autotune     Run a PID relay auto-tune against the profile and exit\n");
+    printf("  --hub          Hub mode: serve this and the --peer units at /api/hub\n");
+    printf("  --peer H[:P]   Unit or simulator to follow in hub mode (repeatable)\n");
     printf("\nAvailable profiles:\n");
     for (int i = 0; i < sim_profile_count; i++) {
         printf("  %-18s %s\n", sim_profiles[i].key, sim_profiles[i].profile->name);
@@ -278,11 +284,11 @@ static void check_alarms(const SimResult& result) {
     uint8_t newAlarm = 0;
 
     // Check meat1 target
-    if (g_meat1_target > 0 && result.meat1Connected && result.meat1Temp >= g_meat1_target) {
+    if (g_meat_target[0] > 0 && result.meat1Connected && result.meat1Temp >= g_meat_target[0]) {
         newAlarm = 3; // MEAT1_DONE
     }
     // Check meat2 target
-    if (g_meat2_target > 0 && result.meat2Connected && result.meat2Temp >= g_meat2_target) {
+    if (g_meat_target[1] > 0 && result.meat2Connected && result.meat2Temp >= g_meat_target[1]) {
         newAlarm = 4; // MEAT2_DONE
     }
 
@@ -293,6 +299,47 @@ static void check_alarms(const SimResult& result) {
     }
 }
 
+// --------------------------------------------------------------------------
+// Headless auto-tune — the firmware's relay tuner against the thermal model
+// --------------------------------------------------------------------------
+
+static int run_autotune(SimProfile* profile) {
+    SimThermalModel model;
+    model.init(*profile);
+    model.externalControl = true;
+
+    PidAutoTune tune;
+    tune.start(profile->targetPitTemp, AUTOTUNE_OUTPUT_BIAS, AUTOTUNE_OUTPUT_STEP,
+               AUTOTUNE_HYSTERESIS, PID_SAMPLE_MS);
+    printf("[SIM] Auto-tune: %s profile, setpoint %.0f\n", profile->name, profile->targetPitTemp);
+
+    const uint32_t stepMs = 1000;
+    uint32_t elapsedMs = 0, sinceSample = PID_SAMPLE_MS;
+    SimResult r = model.update(0.0f);
+    while (tune.isRunning()) {
+        if (sinceSample >= PID_SAMPLE_MS) {
+            sinceSample = 0;
+            model.controlOutput = tune.update(r.pitTemp);
+        }
+        r = model.update(stepMs / 1000.0f);
+        elapsedMs += stepMs;
+        sinceSample += stepMs;
+        if (elapsedMs % 60000 == 0) {
+            printf("[SIM] t=%3um pit=%.1f output=%.0f%% cycles=%u\n",
+                   elapsedMs / 60000, r.pitTemp, model.controlOutput, tune.getCycles());
+        }
+    }
+
+    if (tune.getState() != AutoTuneState::DONE) {
+        printf("[SIM] Auto-tune failed after %u min\n", elapsedMs / 60000);
+        return 1;
+    }
+    printf("[SIM] Auto-tune done in %u min: Ku=%.2f Pu=%.0fs\n",
+           elapsedMs / 60000, tune.getUltimateGain(), tune.getUltimatePeriodSec());
+    printf("[SIM] Tunings: Kp=%.3f Ki=%.5f Kd=%.2f\n", tune.getKp(), tune.getKi(), tune.getKd());
+    return 0;
+}
+
 // --------------------------------------------------------------------------
 // Main
 // --------------------------------------------------------------------------
@@ -302,6 +349,9 @@ int main(int argc, char* argv[]) {
     int webPort = 3000;
     const char* profileName = "normal";
     bool forceWizard = false;
+    bool autoTune = false;
+    bool hubMode = false;
+    std::vector<std::string> hubPeers;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -315,6 +365,12 @@ int main(int argc, char* argv[]) {
             if (webPort < 1 || webPort > 65535) webPort = 3000;
         } else if (strcmp(argv[i], "--wizard") == 0) {
             forceWizard = true;
+        } else if (strcmp(argv[i], "--autotune") == 0) {
+            autoTune = true;
+        } else if (strcmp(argv[i], "--hub") == 0) {
+            hubMode = true;
+        } else if (strcmp(argv[i], "--peer") == 0 && i + 1 < argc) {
+            hubPeers.push_back(argv[++i]);
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -328,6 +384,10 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (autoTune) {
+        return run_autotune(profile);
+    }
+
     // Determine wizard mode: --wizard forces it, otherwise check persistent state
     if (forceWizard) sim_clear_setup();
     bool wizardMode = forceWizard || !sim_is_setup_complete();
@@ -352,13 +412,13 @@ int main(int argc, char* argv[]) {
     g_model = &model;
 
     // Set initial meat target from profile
-    g_meat1_target = profile->meat1Target;
-    g_meat2_target = profile->meat2Target;
+    g_meat_target[0] = profile->meat1Target;
+    g_meat_target[1] = profile->meat2Target;
 
     // Set initial UI state
     ui_update_setpoint(model.setpoint);
-    ui_update_meat1_target(g_meat1_target);
-    ui_update_meat2_target(g_meat2_target);
+    ui_update_meat1_target(g_meat_target[0]);
+    ui_update_meat2_target(g_meat_target[1]);
     ui_update_settings_state(true, "fan_and_damper");
 
     // Initialize web server for browser-based UI
@@ -369,7 +429,8 @@ int main(int argc, char* argv[]) {
     webServer.onAlarm(web_on_alarm);
     webServer.onNewSession(web_on_new_session);
     webServer.onFanMode(web_on_fan_mode);
-    webServer.setState(model.setpoint, g_meat1_target, g_meat2_target);
+    webServer.setState(model.setpoint, g_meat_target);
+    if (hubMode) webServer.enableHub(hubPeers);
 
     // Boot phase: wizard mode starts with splash, normal mode goes straight to running
     SimPhase simPhase = wizardMode ? SimPhase::SPLASH : SimPhase::RUNNING;
@@ -490,36 +551,31 @@ int main(int argc, char* argv[]) {
                 );
 
                 // Broadcast data to web clients and accumulate history
-                webServer.setState(model.setpoint, g_meat1_target, g_meat2_target);
+                webServer.setState(model.setpoint, g_meat_target);
                 {
                     bbq_protocol::DataPayload payload;
                     memset(&payload, 0, sizeof(payload));
                     payload.ts = g_simStartTs + (uint32_t)(model.simTime - g_sessionStartSimTime);
-                    payload.pit   = result.pitTemp;
-                    payload.meat1 = result.meat1Connected ? result.meat1Temp : NAN;
-                    payload.meat2 = result.meat2Connected ? result.meat2Temp : NAN;
+                    payload.sampleUs = (uint32_t)metricsNowUs();   // Model step stands in for the ADC read
+                    for (uint8_t c = 0; c < NUM_PROBES; c++) payload.temp[c] = NAN;   // Model has three probes
+                    payload.temp[PROBE_PIT]   = result.pitTemp;
+                    payload.temp[PROBE_MEAT1] = result.meat1Connected ? result.meat1Temp : NAN;
+                    payload.temp[PROBE_MEAT2] = result.meat2Connected ? result.meat2Temp : NAN;
                     payload.fan   = (uint8_t)result.fanPercent;
                     payload.damper = (uint8_t)result.damperPercent;
                     payload.sp    = model.setpoint;
                     payload.lid   = result.lidOpen;
-                    payload.meat1Target = g_meat1_target;
-                    payload.meat2Target = g_meat2_target;
+                    for (uint8_t m = 0; m < NUM_MEATS; m++) payload.meatTarget[m] = g_meat_target[m];
                     payload.est   = 0;
+                    payload.estLow = payload.estHigh = 0;
+                    payload.stall = false;
                     payload.fanMode = g_fan_mode;
                     payload.errorCount = 0;
-                    webServer.broadcastData(payload);
 
-                    // Accumulate for history replay
-                    bbq_protocol::HistoryPoint hp;
-                    hp.ts     = payload.ts;
-                    hp.pit    = payload.pit;
-                    hp.meat1  = payload.meat1;
-                    hp.meat2  = payload.meat2;
-                    hp.fan    = payload.fan;
-                    hp.damper = payload.damper;
-                    hp.sp     = payload.sp;
-                    hp.lid    = payload.lid;
-                    webServer.addHistoryPoint(hp);
+                    // Into the cook session for history replay and export
+                    webServer.recordSample(payload);
+                    payload.seq = webServer.getSession().getTotalPointCount();
+                    webServer.broadcastData(payload);
                 }
 
                 lastUpdate = now;
@@ -527,11 +583,17 @@ int main(int argc, char* argv[]) {
 
             // Update graph less frequently (every 5 real seconds)
             if (now - lastGraph >= 5000) {
-                ui_graph_add_point(display_temp(model.pitTemp),
-                                   display_temp(model.meat1Temp),
-                                   display_temp(model.meat2Temp),
-                                   display_temp(model.setpoint),
-                                   false, !model.meat1Connected, !model.meat2Connected);
+                // The model has three probes; any further channels are unplugged
+                float temps[NUM_PROBES] = {};
+                bool disc[NUM_PROBES];
+                for (bool& d : disc) d = true;
+                temps[PROBE_PIT]   = display_temp(model.pitTemp);
+                temps[PROBE_MEAT1] = display_temp(model.meat1Temp);
+                temps[PROBE_MEAT2] = display_temp(model.meat2Temp);
+                disc[PROBE_PIT]    = false;
+                disc[PROBE_MEAT1]  = !model.meat1Connected;
+                disc[PROBE_MEAT2]  = !model.meat2Connected;
+                ui_graph_add_point(temps, disc, display_temp(model.setpoint));
                 lastGraph = now;
             }
         }
@@ -8,9 +8,11 @@ struct SimEvent {
     const char* type;    // "setpoint", "lid-open", "fire-out", "probe-disconnect"
     float param1;        // setpoint: target temp; lid-open: duration (s)
     const char* param2;  // probe-disconnect: probe name ("meat1" or "meat2")
-    bool fired;
 };
 
+// Events per profile (the model tracks which have fired in a bitmask)
+#define SIM_MAX_EVENTS  32
+
 struct SimProfile {
     const char* name;
     float initialPitTemp;
@@ -47,7 +49,7 @@ inline SimProfile sim_profile_hot_fast = {
 
 // --- Temperature change profile ---
 static SimEvent temp_change_events[] = {
-    { 4 * 3600.0f, "setpoint", 275, nullptr, false }
+    { 4 * 3600.0f, "setpoint", 275, nullptr }
 };
 inline SimProfile sim_profile_temp_change = {
     "Temperature Change", 70, 225, 40, 40, 203, 185,
@@ -56,9 +58,9 @@ inline SimProfile sim_profile_temp_change = {
 
 // --- Lid open profile ---
 static SimEvent lid_open_events[] = {
-    { 2 * 3600.0f, "lid-open", 60, nullptr, false },
-    { 5 * 3600.0f, "lid-open", 90, nullptr, false },
-    { 8 * 3600.0f, "lid-open", 60, nullptr, false }
+    { 2 * 3600.0f, "lid-open", 60, nullptr },
+    { 5 * 3600.0f, "lid-open", 90, nullptr },
+    { 8 * 3600.0f, "lid-open", 60, nullptr }
 };
 inline SimProfile sim_profile_lid_open = {
     "Lid Opens", 70, 225, 40, 40, 203, 180,
@@ -67,7 +69,7 @@ inline SimProfile sim_profile_lid_open = {
 
 // --- Fire out profile ---
 static SimEvent fire_out_events[] = {
-    { 4 * 3600.0f, "fire-out", 0, nullptr, false }
+    { 4 * 3600.0f, "fire-out", 0, nullptr }
 };
 inline SimProfile sim_profile_fire_out = {
     "Fire Out", 70, 225, 40, 40, 203, 180,
@@ -76,7 +78,7 @@ inline SimProfile sim_profile_fire_out = {
 
 // --- Probe disconnect profile ---
 static SimEvent probe_disconnect_events[] = {
-    { 3 * 3600.0f, "probe-disconnect", 0, "meat1", false }
+    { 3 * 3600.0f, "probe-disconnect", 0, "meat1" }
 };
 inline SimProfile sim_profile_probe_disconnect = {
     "Probe Disconnect", 70, 225, 40, 40, 203, 180,
@@ -0,0 +1,475 @@
+// Trace replay (see sim_replay.h). Built by [env:simbatch] only.
+
+#ifdef SIM_BATCH_BUILD
+
+#include "sim_replay.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+// The signal-path modules are compiled into this file, as in sim_batch.cpp
+// (which supplies AlarmManager and the session log codec)
+#include "../temp_manager.cpp"
+#include "../temp_predictor.cpp"
+#include "../error_manager.cpp"
+#include "../trend_monitor.cpp"
+#include "../metrics.cpp"
+#include "../alarm_manager.h"
+#include "../session_log.h"
+
+// --------------------------------------------------------------------------
+// Loading
+// --------------------------------------------------------------------------
+
+struct LogReader {
+    std::string dir;       // Directory of session_NNN.log files, or
+    std::string single;    // one segment file on its own
+};
+
+static bool readLogBlock(uint32_t block, uint8_t* out, void* ctx) {
+    const LogReader* r = (const LogReader*)ctx;
+    uint32_t segment = block / SESSION_SEGMENT_BLOCKS;
+    std::string path;
+    if (!r->single.empty()) {
+        if (segment != 0) return false;
+        path = r->single;
+    } else {
+        char name[32];
+        snprintf(name, sizeof(name), SESSION_LOG_PATH, (unsigned)segment);
+        path = r->dir + name;
+    }
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    bool ok = fseek(f, (long)(block % SESSION_SEGMENT_BLOCKS) * SESSION_BLOCK_BYTES, SEEK_SET) == 0
+           && fread(out, 1, SESSION_BLOCK_BYTES, f) == SESSION_BLOCK_BYTES;
+    fclose(f);
+    return ok;
+}
+
+static bool loadLog(const LogReader& reader, std::vector<DataPoint>& out) {
+    SessionLogScan scan = sessionLogScan(readLogBlock, (void*)&reader,
+                                         SESSION_SEGMENT_BLOCKS * SESSION_LOG_MAX_SEGMENTS);
+    if (scan.blocks == 0) return false;
+    if (scan.torn) fprintf(stderr, "Session log torn after block %u, replaying up to it\n",
+                           (unsigned)scan.blocks);
+
+    out.reserve(scan.points);
+    uint8_t block[SESSION_BLOCK_BYTES];
+    for (uint32_t b = 0; b < scan.blocks; b++) {
+        SessionBlockHeader hdr;
+        if (!readLogBlock(b, block, (void*)&reader) || !sessionDecodeBlock(block, hdr)) break;
+        SessionBlockPoints it;
+        sessionPointsBegin(it, block, hdr);
+        DataPoint p;
+        while (sessionPointsNext(it, p)) out.push_back(p);
+    }
+    return !out.empty();
+}
+
+// The journal as CookSession::loadEvents() reads it, up to the first torn
+// record
+static void loadEvents(const std::string& path, SessionEventJournal& events) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return;
+    std::vector<SessionEvent> records(SESSION_EVENT_CAPACITY);
+    size_t n = fread(records.data(), sizeof(SessionEvent), records.size(), f);
+    fclose(f);
+    events.load(records.data(), (uint16_t)n);
+}
+
+// Pre-log format: uint32 start time, then DataPoint structs as in RAM
+static bool loadFlat(const char* path, std::vector<DataPoint>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint32_t start;
+    DataPoint p;
+    if (fread(&start, sizeof(start), 1, f) == 1) {
+        while (fread(&p, sizeof(p), 1, f) == 1) {
+            p.discExt = p.alarmExt = 0;   // Struct padding in that layout
+            out.push_back(p);
+        }
+    }
+    fclose(f);
+    return !out.empty();
+}
+
+static int16_t csvTemp(float v) {
+    return (int16_t)lroundf(v * 10.0f);
+}
+
+static bool loadCsv(const char* path, std::vector<DataPoint>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[160];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned ts, fan, damper, flags;
+        float pit, m1, m2;
+        if (sscanf(line, "%u,%f,%f,%f,%u,%u,%u", &ts, &pit, &m1, &m2, &fan, &damper, &flags) != 7) {
+            continue;   // Header or malformed row
+        }
+        // Replay CSVs carry the three stock channels; the rest read as unplugged
+        DataPoint p;
+        memset(&p, 0, sizeof(p));
+        p.timestamp = ts;
+        p.temp[PROBE_PIT]   = csvTemp(pit);
+        p.temp[PROBE_MEAT1] = csvTemp(m1);
+        p.temp[PROBE_MEAT2] = csvTemp(m2);
+        p.fanPct    = (uint8_t)fan;
+        p.damperPct = (uint8_t)damper;
+        p.flags     = (uint8_t)flags;
+        dpSetDiscMask(p, dpDiscMask(p) | (uint16_t)(((1u << NUM_PROBES) - 1) & ~0x07u));
+        out.push_back(p);
+    }
+    fclose(f);
+    return !out.empty();
+}
+
+bool loadTrace(const char* path, std::vector<DataPoint>& out, SessionEventJournal& events) {
+    out.clear();
+    events.clear();
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+
+    bool ok;
+    const char* ext = strrchr(path, '.');
+    if (S_ISDIR(st.st_mode)) {
+        LogReader r;
+        r.dir = path;
+        ok = loadLog(r, out);
+        if (ok) loadEvents(r.dir + SESSION_EVENT_PATH, events);
+    } else if (ext && strcmp(ext, ".csv") == 0) {
+        ok = loadCsv(path, out);
+    } else {
+        // A lone log segment starts with a block header; anything else is
+        // taken as the flat file
+        uint32_t magic = 0;
+        FILE* f = fopen(path, "rb");
+        if (f) {
+            if (fread(&magic, sizeof(magic), 1, f) != 1) magic = 0;
+            fclose(f);
+        }
+        if (magic == SESSION_BLOCK_MAGIC) {
+            LogReader r;
+            r.single = path;
+            ok = loadLog(r, out);
+            const char* slash = strrchr(path, '/');
+            std::string dir = slash ? std::string(path, slash - path) : std::string(".");
+            if (ok) loadEvents(dir + SESSION_EVENT_PATH, events);
+        } else {
+            ok = loadFlat(path, out);
+        }
+    }
+    if (!ok) fprintf(stderr, "No data points in %s\n", path);
+    return ok;
+}
+
+// --------------------------------------------------------------------------
+// Replay
+// --------------------------------------------------------------------------
+
+SimReplayConfig simReplayDefaults() {
+    SimReplayConfig c;
+    c.setpoint       = 225.0f;
+    for (float& target : c.meatTarget) target = 0.0f;
+    c.emaAlpha       = TEMP_EMA_ALPHA;
+    c.useLookupTable = false;
+    c.fahrenheit     = true;
+    c.out            = nullptr;
+    return c;
+}
+
+static bool pointConnected(const DataPoint& p, uint8_t probe) {
+    return !dpDisconnected(p, probe);
+}
+
+static float pointTemp(const DataPoint& p, uint8_t probe) {
+    return p.temp[probe] / 10.0f;
+}
+
+// Inverse of TempManager's divider and Steinhart-Hart conversion with the
+// default coefficients: solve C*x^3 + B*x + (A - 1/T) = 0 for x = ln(R)
+static int16_t tempToRaw(float temp, bool fahrenheit) {
+    double tempC = fahrenheit ? (temp - 32.0) * 5.0 / 9.0 : temp;
+    double q = (THERM_A - 1.0 / (tempC + 273.15)) / THERM_C;
+    double p = THERM_B / THERM_C;
+    double d = sqrt(p * p * p / 27.0 + q * q / 4.0);
+    double lnR = cbrt(-q / 2.0 + d) + cbrt(-q / 2.0 - d);
+    double r = exp(lnR);
+    long raw = lround(ADC_MAX_VALUE / (r / REFERENCE_RESISTANCE + 1.0));
+    if (raw >= ERROR_PROBE_OPEN_THRESHOLD) raw = ERROR_PROBE_OPEN_THRESHOLD - 1;
+    if (raw <= ERROR_PROBE_SHORT_THRESHOLD) raw = ERROR_PROBE_SHORT_THRESHOLD + 1;
+    return (int16_t)raw;
+}
+
+struct EtaSample {
+    uint32_t ts;
+    uint32_t est;
+};
+
+static bool probeFaulted(const ErrorManager& errors, uint8_t probe) {
+    for (uint8_t i = 0; i < errors.getErrorCount(); i++) {
+        const ErrorEntry* e = errors.getError(i);
+        if (e->probeIndex == probe &&
+            (e->code == ErrorCode::PROBE_OPEN || e->code == ErrorCode::PROBE_SHORT)) return true;
+    }
+    return false;
+}
+
+// Error of the estimates against the recorded done time, overall and at
+// fractions of the time from the start of the trace to done
+static void scoreEta(SimReplayProbe& pr, const std::vector<EtaSample>& etas,
+                     uint32_t startTs, uint32_t doneTs) {
+    static const float kFractions[3] = { 0.5f, 0.75f, 0.9f };
+    pr.etaMaeMin = -1.0f;
+    for (float& e : pr.etaErrMin) e = -1.0f;
+    if (doneTs == 0) return;
+
+    double sum = 0.0;
+    uint32_t n = 0;
+    for (const EtaSample& s : etas) {
+        if (s.ts >= doneTs) break;
+        sum += fabs((double)s.est - doneTs) / 60.0;
+        n++;
+    }
+    if (n) pr.etaMaeMin = (float)(sum / n);
+
+    for (int f = 0; f < 3; f++) {
+        uint32_t at = startTs + (uint32_t)((doneTs - startTs) * kFractions[f]);
+        for (const EtaSample& s : etas) {
+            if (s.ts >= at && s.ts < doneTs) {
+                pr.etaErrMin[f] = fabsf((float)((double)s.est - doneTs)) / 60.0f;
+                break;
+            }
+        }
+    }
+}
+
+SimReplayMetrics runSimReplay(const std::vector<DataPoint>& trace, const SessionEventJournal& events,
+                              const SimReplayConfig& cfg) {
+    auto wallStart = std::chrono::steady_clock::now();
+
+    SimReplayMetrics m;
+    memset(&m, 0, sizeof(m));
+    m.fireOutHours = -1.0f;
+    for (SimReplayProbe& pr : m.probe) {
+        pr.reachedHours = pr.alarmHours = pr.etaMaeMin = -1.0f;
+        for (float& e : pr.etaErrMin) e = -1.0f;
+    }
+    if (trace.empty()) return m;
+
+    TempManager temps;
+    temps.begin();
+    temps.setEMAAlpha(cfg.emaAlpha);
+    temps.setUseLookupTable(cfg.useLookupTable);
+    temps.setUseFahrenheit(cfg.fahrenheit);
+
+    TempPredictor predictor;
+    predictor.begin();
+    AlarmManager alarms;
+    alarms.begin();
+    for (uint8_t k = 0; k < NUM_MEATS; k++) {
+        predictor.setTarget(k, cfg.meatTarget[k]);
+        alarms.setMeatTarget(k, cfg.meatTarget[k]);
+    }
+
+    ErrorManager errors;
+    errors.begin();
+    TrendMonitor trend;
+
+    // In force at the current step, from the flags until the journal sets them
+    float setpoint = cfg.setpoint;
+    float targets[NUM_PROBES] = { 0.0f };   // By channel, as TempManager indexes
+    for (uint8_t k = 0; k < NUM_MEATS; k++) targets[PROBE_MEAT1 + k] = cfg.meatTarget[k];
+    SessionEventCursor cursor;
+    sessionEventsBegin(cursor);
+    const uint32_t startTs = trace[0].timestamp;
+    const uint32_t stepSec = TEMP_SAMPLE_INTERVAL_MS / 1000;
+    const uint32_t predictSec = PREDICTOR_SAMPLE_INTERVAL / 1000;
+    uint32_t lastPredictTs = 0;
+    bool pitReached = false, pitAlarm = false;
+    bool faulted[NUM_PROBES] = { false };
+    float prevIn[NUM_PROBES], prevOut[NUM_PROBES];
+    for (uint8_t k = 0; k < NUM_PROBES; k++) prevIn[k] = prevOut[k] = NAN;
+    uint32_t jitterN[NUM_PROBES] = { 0 }, deltaN[NUM_PROBES] = { 0 };
+    double sq[NUM_PROBES] = { 0 };
+    uint32_t doneTs[NUM_PROBES] = { 0 };
+    uint32_t stallSec[NUM_PROBES] = { 0 };
+    std::vector<EtaSample> etas[NUM_PROBES];
+
+    if (cfg.out) {
+        fprintf(cfg.out, "timestamp,pit,pit_filtered,meat1,meat1_filtered,meat2,meat2_filtered,"
+                         "meat1_eta,meat2_eta,alarms,errors\n");
+    }
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        const DataPoint& p = trace[i];
+        const DataPoint& prev = i ? trace[i - 1] : p;
+        uint32_t dt = p.timestamp - prev.timestamp;
+        if (i && dt > 60) m.gaps++;
+        bool interpolate = i && dt > 0 && dt <= 60;
+        uint32_t steps = interpolate ? (dt + stepSec - 1) / stepSec : 1;
+
+        for (uint32_t s = 1; s <= steps; s++) {
+            uint32_t ts = interpolate ? prev.timestamp + std::min(s * stepSec, dt) : p.timestamp;
+            float frac = interpolate ? (float)(ts - prev.timestamp) / dt : 1.0f;
+
+            // Setpoint and target changes journalled up to now. A new
+            // setpoint re-arms pit-reached, as ControlZone does.
+            sessionEventsSeek(events, cursor, ts);
+            int16_t sp = cursor.value[(uint8_t)SessionEventType::SETPOINT];
+            if (sp != SESSION_EVENT_NONE && sp / 10.0f != setpoint) {
+                setpoint = sp / 10.0f;
+                pitReached = false;
+            }
+            for (uint8_t k = 0; k < NUM_MEATS; k++) {
+                int16_t v = cursor.value[(uint8_t)sessionMeatTargetEvent(k)];
+                if (v == SESSION_EVENT_NONE || v / 10.0f == targets[PROBE_MEAT1 + k]) continue;
+                targets[PROBE_MEAT1 + k] = v / 10.0f;
+                predictor.setTarget(k, targets[PROBE_MEAT1 + k]);
+                alarms.setMeatTarget(k, targets[PROBE_MEAT1 + k]);
+            }
+
+            // 1. TempManager, fed raw readings rebuilt from the trace
+            for (uint8_t k = 0; k < NUM_PROBES; k++) {
+                int16_t raw = ERROR_PROBE_OPEN_THRESHOLD;
+                if (pointConnected(p, k)) {
+                    float v = pointTemp(p, k);
+                    if (interpolate && pointConnected(prev, k)) {
+                        v = pointTemp(prev, k) + (v - pointTemp(prev, k)) * frac;
+                    }
+                    raw = tempToRaw(v, cfg.fahrenheit);
+                }
+                temps.injectRawADC(k, raw);
+            }
+            float t[NUM_PROBES];
+            bool conn[NUM_PROBES];
+            ProbeState states[NUM_PROBES];
+            for (uint8_t k = 0; k < NUM_PROBES; k++) {
+                t[k] = temps.getTemp(k);
+                conn[k] = temps.isConnected(k);
+                states[k].connected = conn[k];
+                states[k].openCircuit = temps.getStatus(k) == ProbeStatus::OPEN_CIRCUIT;
+                states[k].shortCircuit = temps.getStatus(k) == ProbeStatus::SHORT_CIRCUIT;
+                states[k].temperature = t[k];
+            }
+
+            // Predictor at its own interval, on trace time
+            predictor.setPitTemp(t[PROBE_PIT], conn[PROBE_PIT]);
+            predictor.setCurrentTime(ts);
+            if (lastPredictTs == 0 || ts - lastPredictTs >= predictSec) {
+                lastPredictTs = ts;
+                predictor.update(&t[PROBE_MEAT1], &conn[PROBE_MEAT1]);
+            }
+            for (uint8_t k = PROBE_MEAT1; k < NUM_PROBES; k++) {
+                if (predictor.isStalled(k - PROBE_MEAT1)) stallSec[k] += stepSec;
+            }
+
+            // 5. Alarms, pit-reached as controlTick() tracks it
+            if (!pitReached && conn[PROBE_PIT] && fabsf(t[PROBE_PIT] - setpoint) <= 5.0f) {
+                pitReached = true;
+            }
+            alarms.update(t[PROBE_PIT], &t[PROBE_MEAT1], setpoint, pitReached);
+            AlarmType active[MAX_ACTIVE_ALARMS];
+            uint8_t n = alarms.getActiveAlarms(active, MAX_ACTIVE_ALARMS);
+            bool pitNow = false;
+            for (uint8_t a = 0; a < n; a++) {
+                float hours = (ts - startTs) / 3600.0f;
+                if (active[a] == AlarmType::PIT_HIGH || active[a] == AlarmType::PIT_LOW) pitNow = true;
+                uint8_t meat = alarmMeatIndex(active[a]);
+                if (meat < NUM_MEATS) {
+                    SimReplayProbe& pr = m.probe[PROBE_MEAT1 + meat];
+                    if (pr.alarmHours < 0.0f) pr.alarmHours = hours;
+                }
+            }
+            if (pitNow && !pitAlarm) m.pitAlarms++;
+            pitAlarm = pitNow;
+
+            // 6. Trend warnings, with the recorded fan output, then errors
+            TrendInput ti;
+            ti.pitTemp      = t[PROBE_PIT];
+            ti.pitConnected = conn[PROBE_PIT];
+            ti.outputPct    = p.fanPct;
+            ti.setpoint     = setpoint;
+            ti.lidOpen      = (p.flags & DP_FLAG_LID_OPEN) != 0;
+            for (uint8_t k = 0; k < TREND_MEAT_PROBES; k++) {
+                ti.meatTemp[k]   = t[k + 1];
+                ti.meatTarget[k] = targets[k + 1];
+                ti.meatEtaSec[k] = predictor.getSecondsToTarget(k);
+            }
+            trend.update((ts - startTs) * 1000UL, ti);
+            errors.setTrend(trend.status());
+            errors.update(states);
+            for (uint8_t k = 0; k < NUM_PROBES; k++) {
+                bool f = probeFaulted(errors, k);
+                if (f && !faulted[k]) m.probeFaults++;
+                faulted[k] = f;
+            }
+            if (errors.isFireOut() && m.fireOutHours < 0.0f) m.fireOutHours = (ts - startTs) / 3600.0f;
+        }
+
+        // Per-point comparison of the recorded and filtered signals
+        float filtered[NUM_PROBES];
+        for (uint8_t k = 0; k < NUM_PROBES; k++) {
+            filtered[k] = temps.getTemp(k);
+            SimReplayProbe& pr = m.probe[k];
+            bool have = pointConnected(p, k) && temps.isConnected(k);
+            if (!have) {
+                prevIn[k] = prevOut[k] = NAN;
+                continue;
+            }
+            pr.present = true;
+            float in = pointTemp(p, k);
+            if (!std::isnan(prevIn[k])) {
+                pr.inputJitter += fabsf(in - prevIn[k]);
+                pr.outputJitter += fabsf(filtered[k] - prevOut[k]);
+                jitterN[k]++;
+            }
+            prevIn[k] = in;
+            prevOut[k] = filtered[k];
+            double d = filtered[k] - in;
+            sq[k] += d * d;
+            deltaN[k]++;
+            if (k > 0 && targets[k] > 0.0f && doneTs[k] == 0 && in >= targets[k]) doneTs[k] = p.timestamp;
+        }
+
+        uint32_t est[NUM_PROBES] = { 0 };
+        for (uint8_t k = PROBE_MEAT1; k < NUM_PROBES; k++) {
+            est[k] = predictor.getEstTime(k - PROBE_MEAT1);
+            if (est[k]) etas[k].push_back({ p.timestamp, est[k] });
+        }
+
+        if (cfg.out) {
+            uint16_t alarmBits = 0;
+            AlarmType active[MAX_ACTIVE_ALARMS];
+            uint8_t n = alarms.getActiveAlarms(active, MAX_ACTIVE_ALARMS);
+            for (uint8_t a = 0; a < n; a++) alarmBits |= 1u << (uint8_t)active[a];
+            fprintf(cfg.out, "%u,%.1f,%.2f,%.1f,%.2f,%.1f,%.2f,%u,%u,%u,%u\n", p.timestamp,
+                    pointTemp(p, 0), filtered[0], pointTemp(p, 1), filtered[1],
+                    pointTemp(p, 2), filtered[2], est[1], est[2], alarmBits, errors.getErrorCount());
+        }
+    }
+
+    m.points = (uint32_t)trace.size();
+    m.hours = (trace.back().timestamp - startTs) / 3600.0f;
+    for (uint8_t k = 0; k < NUM_PROBES; k++) {
+        SimReplayProbe& pr = m.probe[k];
+        if (jitterN[k]) {
+            pr.inputJitter /= jitterN[k];
+            pr.outputJitter /= jitterN[k];
+        }
+        if (deltaN[k]) pr.rmsDelta = (float)sqrt(sq[k] / deltaN[k]);
+        pr.stallHours = stallSec[k] / 3600.0f;
+        if (doneTs[k]) pr.reachedHours = (doneTs[k] - startTs) / 3600.0f;
+        if (k > 0) scoreEta(pr, etas[k], startTs, doneTs[k]);
+    }
+    m.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return m;
+}
+
+#endif // SIM_BATCH_BUILD
@@ -0,0 +1,71 @@
+#pragma once
+
+// Replay of recorded cooks through the firmware's signal path.
+//
+// A trace is the DataPoint series of a real cook, loaded from any of:
+//   - a directory holding the session log (session_000.log, ...) copied
+//     off the device's LittleFS
+//   - a pre-log flat /session.dat (start time, then raw DataPoints)
+//   - a CSV export (timestamp,pit,meat1,meat2,fan,damper,flags)
+// A session log comes with its event journal (session_ev.dat, beside the
+// segments), which drives the setpoint and meat targets through the replay
+// as they were changed during the cook.
+//
+// The replay converts each recorded temperature back to a raw ADC reading
+// and feeds TempManager at TEMP_SAMPLE_INTERVAL_MS, interpolating between
+// the 5 s points. TempPredictor, AlarmManager and ErrorManager then run on
+// TempManager's output, on a virtual clock taken from the trace, as the
+// control task would. The recorded temps are already smoothed once, so
+// filter results are for comparing one build or setting against another
+// on the same trace, not absolute. Fully deterministic.
+
+#include "../data_point.h"
+#include "../probe_channels.h"
+#include "../session_events.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Loads a trace, picking the format from the path, and the event journal
+// next to a session log (left empty for other formats or when missing).
+// False (with a message on stderr) if no points could be read.
+bool loadTrace(const char* path, std::vector<DataPoint>& out, SessionEventJournal& events);
+
+struct SimReplayConfig {
+    // Used until the journal sets them, so throughout for CSV and
+    // session.dat traces, which have no journal
+    float setpoint;
+    float meatTarget[NUM_MEATS];   // By meat probe (channel - 1), 0 = no target
+    float emaAlpha;           // TempManager EMA (TEMP_EMA_ALPHA)
+    bool  useLookupTable;
+    bool  fahrenheit;         // Units the trace was recorded in
+    FILE* out;                // Optional per-sample CSV of the replay, or nullptr
+};
+
+SimReplayConfig simReplayDefaults();
+
+struct SimReplayProbe {
+    bool     present;          // Connected at some point in the trace
+    float    inputJitter;      // Mean |change| per trace point, recorded
+    float    outputJitter;     // Same, after TempManager
+    float    rmsDelta;         // RMS of (filtered - recorded)
+    float    reachedHours;     // Recorded temp first at/above target (-1 = never)
+    float    alarmHours;       // Done alarm raised (-1 = never)
+    float    etaMaeMin;        // Mean |predicted - actual done| over the cook (-1 = n/a)
+    float    etaErrMin[3];     // |error| at 50%, 75% and 90% of the time to done
+    float    stallHours;       // Time the predictor reported a stall
+};
+
+struct SimReplayMetrics {
+    uint32_t points;
+    uint32_t gaps;             // Breaks in the trace longer than a minute
+    float    hours;
+    SimReplayProbe probe[NUM_PROBES];   // By channel (meat fields unused for pit)
+    uint32_t pitAlarms;        // Pit high/low alarm onsets
+    uint32_t probeFaults;      // Probe open/short error onsets
+    float    fireOutHours;     // First fire-out error (-1 = never)
+    double   wallSeconds;
+};
+
+SimReplayMetrics runSimReplay(const std::vector<DataPoint>& trace, const SessionEventJournal& events,
+                              const SimReplayConfig& cfg);
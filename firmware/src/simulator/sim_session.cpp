@@ -0,0 +1,19 @@
+// Session storage and history replay for SimWebServer, and the metrics
+// clock its latency pings answer from. Built by [env:simulator] only. The
+// firmware modules are compiled here under NATIVE_BUILD, as sim_batch.cpp
+// does, so the simulator records and replays through the same code as the
+// device; LittleFS drops out and the ring and rollup tiers stay in memory.
+
+#ifdef SIMULATOR_BUILD
+
+#include "sim_string.h"
+
+#include "../cook_session.cpp"
+#include "../session_archive.cpp"
+#include "../session_events.cpp"
+#include "../session_log.cpp"
+#include "../ext_ram.cpp"
+#include "../history_stream.cpp"
+#include "../metrics.cpp"
+
+#endif // SIMULATOR_BUILD
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+// CookSession's String exports need a stand-in off the device. The
+// simulator builds the firmware's session modules under NATIVE_BUILD, as
+// the native tests do; this is the one String they all see.
+class String {
+public:
+    String() {}
+    String(const char* s) : _data(s ? s : "") {}
+    String& operator+=(const char* s) { if (s) _data += s; return *this; }
+    void reserve(size_t n) { _data.reserve(n); }
+    const char* c_str() const { return _data.c_str(); }
+    size_t length() const { return _data.length(); }
+private:
+    std::string _data;
+};
@@ -0,0 +1,155 @@
+// Parameter sweeps (see sim_sweep.h). Built by [env:simbatch] only.
+
+#ifdef SIM_BATCH_BUILD
+
+#include "sim_sweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+size_t simSweepRunCount(const SimSweepGrid& grid) {
+    return grid.profiles.size() * grid.kp.size() * grid.ki.size() * grid.kd.size()
+         * grid.sampleMs.size() * grid.fanOnThreshold.size() * grid.fanModes.size();
+}
+
+// Expand the grid into one config per tuning, profiles innermost
+static std::vector<SimSweepEntry> expandTunings(const SimSweepGrid& grid) {
+    std::vector<SimSweepEntry> tunings;
+    for (const char* mode : grid.fanModes)
+    for (float thr : grid.fanOnThreshold)
+    for (float ms : grid.sampleMs)
+    for (float kp : grid.kp)
+    for (float ki : grid.ki)
+    for (float kd : grid.kd) {
+        SimSweepEntry e = {};
+        e.cfg = grid.base;
+        e.cfg.kp = kp;
+        e.cfg.ki = ki;
+        e.cfg.kd = kd;
+        e.cfg.sampleMs = (uint32_t)ms;
+        e.cfg.fanOnThreshold = thr;
+        e.cfg.fanMode = mode;
+        e.cfg.recordSession = false;
+        e.cfg.logEvents = false;
+        e.perProfile.resize(grid.profiles.size());
+        tunings.push_back(e);
+    }
+    return tunings;
+}
+
+static void aggregate(SimSweepEntry& e) {
+    size_t n = e.perProfile.size();
+    if (n == 0) return;
+    e.worstInBandPct = 100.0f;
+    float tts = 0.0f;
+    for (const SimBatchMetrics& m : e.perProfile) {
+        e.meanInBandPct += m.inBandPct;
+        e.worstInBandPct = std::min(e.worstInBandPct, m.inBandPct);
+        e.meanOvershoot += m.overshoot;
+        e.worstOvershoot = std::max(e.worstOvershoot, m.overshoot);
+        e.meanFanDutyPct += m.fanDutyPct;
+        e.meanOutputTravelPerHour += m.outputTravelPerHour;
+        e.pitAlarms += m.pitAlarms;
+        if (m.timeToSetpointMin >= 0.0f) {
+            tts += m.timeToSetpointMin;
+            e.reached++;
+        }
+    }
+    e.meanInBandPct /= n;
+    e.meanOvershoot /= n;
+    e.meanFanDutyPct /= n;
+    e.meanOutputTravelPerHour /= n;
+    e.meanTimeToSetpointMin = e.reached ? tts / e.reached : -1.0f;
+}
+
+std::vector<SimSweepEntry> runSimSweep(const SimSweepGrid& grid, unsigned jobs) {
+    std::vector<SimSweepEntry> board = expandTunings(grid);
+    const size_t perTuning = grid.profiles.size();
+    const size_t total = board.size() * perTuning;
+
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    if (jobs > total) jobs = (unsigned)std::max<size_t>(1, total);
+
+    // Each run writes only its own perProfile slot, so workers share
+    // nothing but the next-run counter
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < total; i = next.fetch_add(1)) {
+            SimSweepEntry& e = board[i / perTuning];
+            size_t p = i % perTuning;
+            e.perProfile[p] = runSimBatch(*grid.profiles[p]->profile, e.cfg);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned j = 1; j < jobs; j++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    for (SimSweepEntry& e : board) aggregate(e);
+    std::stable_sort(board.begin(), board.end(),
+                     [](const SimSweepEntry& a, const SimSweepEntry& b) {
+        if (a.meanInBandPct != b.meanInBandPct) return a.meanInBandPct > b.meanInBandPct;
+        return a.worstOvershoot < b.worstOvershoot;
+    });
+    return board;
+}
+
+bool writeSimSweepCsv(const char* path, const SimSweepGrid& grid,
+                      const std::vector<SimSweepEntry>& board) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "rank,kp,ki,kd,sample_ms,fan_on_threshold,fan_mode,profile,"
+               "time_to_setpoint_min,overshoot,in_band_pct,in_alarm_band_pct,"
+               "fan_duty_pct,fan_on_pct,damper_mean_pct,output_travel_per_hour,"
+               "lid_events,pit_alarms,meat1_done_h,meat2_done_h\n");
+    for (size_t r = 0; r < board.size(); r++) {
+        const SimSweepEntry& e = board[r];
+        for (size_t p = 0; p < e.perProfile.size(); p++) {
+            const SimBatchMetrics& m = e.perProfile[p];
+            fprintf(f, "%zu,%g,%g,%g,%u,%g,%s,%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%u,%u,%.3f,%.3f\n",
+                    r + 1, e.cfg.kp, e.cfg.ki, e.cfg.kd, (unsigned)e.cfg.sampleMs,
+                    e.cfg.fanOnThreshold, e.cfg.fanMode, grid.profiles[p]->key,
+                    m.timeToSetpointMin, m.overshoot, m.inBandPct, m.inAlarmBandPct,
+                    m.fanDutyPct, m.fanOnPct, m.damperMeanPct, m.outputTravelPerHour,
+                    (unsigned)m.lidEvents, (unsigned)m.pitAlarms,
+                    m.meat1DoneHours, m.meat2DoneHours);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+bool writeSimSweepJson(const char* path, const SimSweepGrid& grid,
+                       const std::vector<SimSweepEntry>& board) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\"hours\":%g,\"seed\":%u,\"leaderboard\":[", grid.base.hours, grid.base.seed);
+    for (size_t r = 0; r < board.size(); r++) {
+        const SimSweepEntry& e = board[r];
+        fprintf(f, "%s\n{\"rank\":%zu,\"kp\":%g,\"ki\":%g,\"kd\":%g,\"sampleMs\":%u,"
+                   "\"fanOnThreshold\":%g,\"fanMode\":\"%s\","
+                   "\"meanInBandPct\":%.2f,\"worstInBandPct\":%.2f,"
+                   "\"meanOvershoot\":%.2f,\"worstOvershoot\":%.2f,"
+                   "\"meanTimeToSetpointMin\":%.2f,\"meanFanDutyPct\":%.2f,"
+                   "\"meanOutputTravelPerHour\":%.1f,\"pitAlarms\":%u,\"profiles\":{",
+                r ? "," : "", r + 1, e.cfg.kp, e.cfg.ki, e.cfg.kd, (unsigned)e.cfg.sampleMs,
+                e.cfg.fanOnThreshold, e.cfg.fanMode,
+                e.meanInBandPct, e.worstInBandPct, e.meanOvershoot, e.worstOvershoot,
+                e.meanTimeToSetpointMin, e.meanFanDutyPct, e.meanOutputTravelPerHour,
+                (unsigned)e.pitAlarms);
+        for (size_t p = 0; p < e.perProfile.size(); p++) {
+            const SimBatchMetrics& m = e.perProfile[p];
+            fprintf(f, "%s\"%s\":{\"inBandPct\":%.2f,\"overshoot\":%.2f,"
+                       "\"timeToSetpointMin\":%.2f,\"fanDutyPct\":%.2f,\"pitAlarms\":%u}",
+                    p ? "," : "", grid.profiles[p]->key, m.inBandPct, m.overshoot,
+                    m.timeToSetpointMin, m.fanDutyPct, (unsigned)m.pitAlarms);
+        }
+        fprintf(f, "}}");
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+#endif // SIM_BATCH_BUILD
@@ -0,0 +1,51 @@
+#pragma once
+
+// Parameter sweeps over the batch simulator.
+//
+// A sweep runs every combination of PID gains, sample interval, fan-on
+// threshold and fan mode against every chosen profile, spread over a pool
+// of threads, and ranks the tunings. Each run is an independent
+// runSimBatch() with session recording and event logging off.
+
+#include "sim_batch.h"
+#include "sim_profiles.h"
+#include <stddef.h>
+#include <vector>
+
+struct SimSweepGrid {
+    std::vector<const ProfileEntry*> profiles;
+    std::vector<float>       kp, ki, kd;
+    std::vector<float>       sampleMs;
+    std::vector<float>       fanOnThreshold;
+    std::vector<const char*> fanModes;
+    SimBatchConfig           base;       // hours, D filter, feed-forward, seed
+};
+
+// One tuning, aggregated over the grid's profiles
+struct SimSweepEntry {
+    SimBatchConfig cfg;
+    float    meanInBandPct;
+    float    worstInBandPct;
+    float    meanOvershoot;
+    float    worstOvershoot;
+    float    meanTimeToSetpointMin;    // Over the profiles that reached it
+    float    meanFanDutyPct;
+    float    meanOutputTravelPerHour;
+    uint32_t pitAlarms;                // Summed over profiles
+    uint8_t  reached;                  // Profiles that reached setpoint
+    std::vector<SimBatchMetrics> perProfile;   // In grid.profiles order
+};
+
+size_t simSweepRunCount(const SimSweepGrid& grid);
+
+// Run the grid on `jobs` threads (0 = one per core). The result is the
+// leaderboard: best mean time in band first, ties broken by the lower
+// worst-case overshoot.
+std::vector<SimSweepEntry> runSimSweep(const SimSweepGrid& grid, unsigned jobs);
+
+// Leaderboard files. CSV has one row per tuning per profile; JSON has the
+// ranked tunings with their per-profile metrics.
+bool writeSimSweepCsv(const char* path, const SimSweepGrid& grid,
+                      const std::vector<SimSweepEntry>& board);
+bool writeSimSweepJson(const char* path, const SimSweepGrid& grid,
+                       const std::vector<SimSweepEntry>& board);
@@ -9,15 +9,14 @@ SimThermalModel::SimThermalModel() {
 }
 
 void SimThermalModel::setFanMode(const char* mode) {
-    strncpy(fanMode, mode, sizeof(fanMode) - 1);
-    fanMode[sizeof(fanMode) - 1] = '\0';
+    fanMode = fanModeParse(mode);
 }
 
 void SimThermalModel::setFanOnThreshold(float threshold) {
     fanOnThreshold = threshold;
 }
 
-void SimThermalModel::init(const SimProfile& profile) {
+void SimThermalModel::init(const SimProfile& profile, uint32_t seed) {
     pitTemp = profile.initialPitTemp;
     meat1Temp = profile.meat1Start;
     meat2Temp = profile.meat2Start;
@@ -34,8 +33,13 @@ void SimThermalModel::init(const SimProfile& profile) {
     meat1Connected = true;
     meat2Connected = true;
     simTime = 0;
-    strncpy(fanMode, "fan_and_damper", sizeof(fanMode));
+    fanMode = FAN_MODE_DEFAULT;
     fanOnThreshold = 30.0f;
+    externalControl = false;
+    controlOutput = 0;
+    logEvents = true;
+    airflow_ = 0;
+    combustion_ = 0.25f;
 
     stallEnabled_ = profile.stallEnabled;
     stallTempLow_ = profile.stallTempLow;
@@ -49,15 +53,12 @@ void SimThermalModel::init(const SimProfile& profile) {
     pidPrevError_ = 0;
     hasReachedSetpoint_ = false;
     overshootRemaining_ = 0;
-    noisePhase_ = (float)(rand() % 1000) / 1000.0f * 6.283f;
+    rng_ = seed ? seed : 1;
+    noisePhase_ = (float)random1000() / 1000.0f * 6.283f;
 
     events_ = profile.events;
-    eventCount_ = profile.eventCount;
-
-    // Reset event fired flags
-    for (int i = 0; i < eventCount_; i++) {
-        events_[i].fired = false;
-    }
+    eventCount_ = profile.eventCount < SIM_MAX_EVENTS ? profile.eventCount : SIM_MAX_EVENTS;
+    eventsFired_ = 0;
 }
 
 SimResult SimThermalModel::update(float dt) {
@@ -75,8 +76,8 @@ SimResult SimThermalModel::update(float dt) {
         }
     }
 
-    // Simplified PID to compute fan/damper from pit error
-    float pidOutput = computePID(dt);
+    // Simplified PID to compute fan/damper from pit error (or the caller's output)
+    float pidOutput = externalControl ? controlOutput : computePID(dt);
     pidOutput = fmaxf(0, fminf(100, pidOutput));
 
     // Split-range fan/damper coordination (shared with firmware)
@@ -98,6 +99,7 @@ SimResult SimThermalModel::update(float dt) {
         float damperOpen = damperPercent / 100.0f;
         float fanFlow = fanPercent / 100.0f;
         float effectiveAirflow = damperOpen * fmaxf(naturalDraft, fanFlow);
+        airflow_ = effectiveAirflow;
 
         if (fireOut) {
             fireEnergy = fmaxf(0, fireEnergy - 0.0005f * dt);
@@ -174,6 +176,16 @@ void SimThermalModel::updatePitTemp(float dt) {
     float maxFireTemp = 400.0f;
     float maxAchievable = ambientTemp + (maxFireTemp - ambientTemp) * fireEnergy;
 
+    if (externalControl) {
+        // Burn rate follows airflow with a lag; the pit settles where heat
+        // from the coals balances losses, wherever that is
+        float burnTarget = 0.25f + 0.75f * airflow_;
+        combustion_ += (burnTarget - combustion_) * (1.0f - expf(-dt / 90.0f));
+        float heatTemp = ambientTemp + (maxFireTemp - ambientTemp) * fireEnergy * combustion_;
+        pitTemp += (heatTemp - pitTemp) * (1.0f - expf(-dt / PIT_TAU));
+        return;
+    }
+
     // Pit approaches the setpoint, capped by fire
     float targetTemp = fminf(setpoint, maxAchievable);
 
@@ -245,31 +257,31 @@ void SimThermalModel::updateMeatTemps(float dt) {
 
 void SimThermalModel::processEvents() {
     for (int i = 0; i < eventCount_; i++) {
-        SimEvent& event = events_[i];
-        if (event.fired) continue;
+        const SimEvent& event = events_[i];
+        if (eventsFired_ & (1u << i)) continue;
         if (simTime < event.time) continue;
 
-        event.fired = true;
+        eventsFired_ |= 1u << i;
 
         if (strcmp(event.type, "setpoint") == 0) {
             setpoint = event.param1;
             hasReachedSetpoint_ = false;
             pidIntegral_ = 0;
-            printf("[SIM] Setpoint changed to %.0f\n", event.param1);
+            if (logEvents) printf("[SIM] Setpoint changed to %.0f\n", event.param1);
         } else if (strcmp(event.type, "lid-open") == 0) {
             lidOpen = true;
             lidOpenTimer = event.param1 > 0 ? event.param1 : 60;
-            printf("[SIM] Lid opened for %.0fs\n", lidOpenTimer);
+            if (logEvents) printf("[SIM] Lid opened for %.0fs\n", lidOpenTimer);
         } else if (strcmp(event.type, "fire-out") == 0) {
             fireOut = true;
-            printf("[SIM] Fire out!\n");
+            if (logEvents) printf("[SIM] Fire out!\n");
         } else if (strcmp(event.type, "probe-disconnect") == 0) {
             if (event.param2 && strcmp(event.param2, "meat1") == 0) {
                 meat1Connected = false;
-                printf("[SIM] Meat1 probe disconnected\n");
+                if (logEvents) printf("[SIM] Meat1 probe disconnected\n");
             } else if (event.param2 && strcmp(event.param2, "meat2") == 0) {
                 meat2Connected = false;
-                printf("[SIM] Meat2 probe disconnected\n");
+                if (logEvents) printf("[SIM] Meat2 probe disconnected\n");
             }
         }
     }
@@ -279,6 +291,14 @@ float SimThermalModel::addNoise(float temp, float magnitude) {
     noisePhase_ += 0.01f;
     float noise = sinf(noisePhase_ * 7.3f) * magnitude * 0.5f
                 + sinf(noisePhase_ * 13.1f) * magnitude * 0.3f
-                + ((float)(rand() % 1000) / 1000.0f - 0.5f) * magnitude * 0.4f;
+                + ((float)random1000() / 1000.0f - 0.5f) * magnitude * 0.4f;
     return roundf((temp + noise) * 10.0f) / 10.0f;
 }
+
+// xorshift32, 0-999
+int SimThermalModel::random1000() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return (int)(rng_ % 1000);
+}
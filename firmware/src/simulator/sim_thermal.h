@@ -1,7 +1,9 @@
 #pragma once
 
 #include "sim_profiles.h"
+#include "../fan_mode.h"
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 
 // Result of a thermal model update step
@@ -38,14 +40,26 @@ public:
     float simTime;
 
     // Fan mode configuration
-    char fanMode[20];
+    FanMode fanMode;
     float fanOnThreshold;
 
+    // External control: the caller supplies the PID output in controlOutput
+    // instead of the built-in loop, and the pit is heated by airflow through
+    // the coals rather than pulled toward the setpoint. Used to run the
+    // firmware's controller and auto-tuner against the model.
+    bool externalControl;
+    float controlOutput;
+
+    // Print a [SIM] line when a profile event fires
+    bool logEvents;
+
     SimThermalModel();
-    void init(const SimProfile& profile);
+    // seed drives the model's own noise generator, so instances on
+    // different threads are independent and a run is repeatable
+    void init(const SimProfile& profile, uint32_t seed = 1);
     SimResult update(float dt);
 
-    void setFanMode(const char* mode);
+    void setFanMode(const char* mode);   // Parsed once; unknown names select fan_and_damper
     void setFanOnThreshold(float threshold);
 
 private:
@@ -60,6 +74,10 @@ private:
     bool inStall_;
     float fireDecayRate_;
 
+    // External-control plant state
+    float airflow_;        // Effective airflow from the last update (0-1)
+    float combustion_;     // Burn rate lagging airflow (0-1)
+
     // PID state
     float pidIntegral_;
     float pidPrevError_;
@@ -70,14 +88,17 @@ private:
 
     // Noise
     float noisePhase_;
+    uint32_t rng_;
 
     // Events
-    SimEvent* events_;
+    const SimEvent* events_;
     int eventCount_;
+    uint32_t eventsFired_;  // Bit i set once events_[i] has fired
 
     float computePID(float dt);
     void updatePitTemp(float dt);
     void updateMeatTemps(float dt);
     void processEvents();
     float addNoise(float temp, float magnitude);
+    int random1000();
 };
@@ -3,10 +3,12 @@
 #include "sim_web_server.h"
 #include "mongoose.h"
 #include "../config.h"
+#include "../metrics.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <cstdint>
 #include <string>
 
 SimWebServer* g_simWebServer = nullptr;
@@ -14,9 +16,11 @@ SimWebServer* g_simWebServer = nullptr;
 SimWebServer::SimWebServer()
     : _mgr(nullptr)
     , _port(3000)
+    , _session(SESSION_PSRAM_BUFFER_SIZE, SESSION_PSRAM_ROLLUP_CAPACITY)
+    , _lastSampleTs(0)
+    , _hub(nullptr)
     , _setpoint(225)
-    , _meat1Target(0)
-    , _meat2Target(0)
+    , _meatTarget{}
     , _onSetpoint(nullptr)
     , _onAlarm(nullptr)
     , _onNewSession(nullptr)
@@ -24,6 +28,9 @@ SimWebServer::SimWebServer()
     , _onFanMode(nullptr)
 {
     memset(_staticDir, 0, sizeof(_staticDir));
+    memset(_hubPolling, 0, sizeof(_hubPolling));
+    memset(_hubPollMs, 0, sizeof(_hubPollMs));
+    memset(_replays, 0, sizeof(_replays));
 }
 
 SimWebServer::~SimWebServer() {
@@ -32,6 +39,7 @@ SimWebServer::~SimWebServer() {
         free(_mgr);
         _mgr = nullptr;
     }
+    delete _hub;
     if (g_simWebServer == this) g_simWebServer = nullptr;
 }
 
@@ -41,6 +49,9 @@ void SimWebServer::begin(int port, const char* staticDir) {
 
     g_simWebServer = this;
 
+    _session.begin();
+    _session.startSession();
+
     _mgr = (struct mg_mgr*)malloc(sizeof(struct mg_mgr));
     mg_mgr_init(_mgr);
 
@@ -52,6 +63,8 @@ void SimWebServer::begin(int port, const char* staticDir) {
 
 void SimWebServer::tick() {
     if (_mgr) {
+        if (_hub) pollPeers();
+        pumpHistory();
         mg_mgr_poll(_mgr, 0);
     }
 }
@@ -59,28 +72,57 @@ void SimWebServer::tick() {
 void SimWebServer::broadcastData(const bbq_protocol::DataPayload& data) {
     if (!_mgr) return;
 
-    char buf[512];
+    char buf[DATA_MESSAGE_MAX_BYTES];
     size_t len = bbq_protocol::buildDataMessage(buf, sizeof(buf), data);
+    if (len == 0) return;
+    _stateJson.assign(buf, len);
 
-    // Iterate all connections, send to WebSocket ones
+    // Iterate all connections, send to WebSocket ones; data isn't
+    // interleaved with a replay's chunks
     for (struct mg_connection* c = _mgr->conns; c != nullptr; c = c->next) {
-        if (c->is_websocket) {
-            mg_ws_send(c, buf, len, WEBSOCKET_OP_TEXT);
-        }
+        if (!c->is_websocket) continue;
+        Replay* r = findReplay(c->id);
+        if (r && r->stream.active) continue;
+        mg_ws_send(c, buf, len, WEBSOCKET_OP_TEXT);
     }
 }
 
-void SimWebServer::addHistoryPoint(const bbq_protocol::HistoryPoint& point) {
-    _history.push_back(point);
+void SimWebServer::recordSample(const bbq_protocol::DataPayload& data) {
+    if (_lastSampleTs != 0 && data.ts - _lastSampleTs < SESSION_SAMPLE_INTERVAL / 1000) return;
+    _lastSampleTs = data.ts;
+
+    // As CookSession::update() builds it on the device
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = data.ts;
+    uint16_t disc = 0;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        if (std::isnan(data.temp[c])) disc |= (uint16_t)(1u << c);
+        else                          dp.temp[c] = (int16_t)(data.temp[c] * 10.0f);
+    }
+    dp.fanPct    = data.fan;
+    dp.damperPct = data.damper;
+    dp.flags     = data.lid ? DP_FLAG_LID_OPEN : 0;
+    dpSetDiscMask(dp, disc);
+
+    _session.logEvent(SessionEventType::SETPOINT, (int16_t)(data.sp * 10.0f), data.ts);
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        _session.logEvent(sessionMeatTargetEvent(m), (int16_t)(data.meatTarget[m] * 10.0f), data.ts);
+    }
+    _session.logEvent(SessionEventType::LID, data.lid ? 1 : 0, data.ts);
+    _session.addPoint(dp);
 }
 
 void SimWebServer::clearHistory() {
-    _history.clear();
+    _session.startSession();
+    _lastSampleTs = 0;
+    // Replays in flight belong to the old session
+    for (Replay& r : _replays) r.stream.active = false;
 }
 
 void SimWebServer::resetSession() {
     clearHistory();
-    char buf[128];
+    char buf[SESSION_RESET_MAX_BYTES];
     size_t n = bbq_protocol::buildSessionReset(buf, sizeof(buf), _setpoint);
     for (struct mg_connection* conn = _mgr->conns; conn != nullptr; conn = conn->next) {
         if (conn->is_websocket) {
@@ -89,10 +131,9 @@ void SimWebServer::resetSession() {
     }
 }
 
-void SimWebServer::setState(float setpoint, float meat1Target, float meat2Target) {
+void SimWebServer::setState(float setpoint, const float* meatTargets) {
     _setpoint = setpoint;
-    _meat1Target = meat1Target;
-    _meat2Target = meat2Target;
+    for (uint8_t m = 0; m < NUM_MEATS; m++) _meatTarget[m] = meatTargets[m];
 }
 
 void SimWebServer::onSetpoint(void (*cb)(float))       { _onSetpoint = cb; }
@@ -110,51 +151,169 @@ int SimWebServer::getClientCount() const {
     return count;
 }
 
-void SimWebServer::sendHistory(struct mg_connection* c) {
-    if (_history.empty()) return;
+// ---------------------------------------------------------------------------
+// Hub mode
+// ---------------------------------------------------------------------------
+
+void SimWebServer::enableHub(const std::vector<std::string>& peers) {
+    if (!_hub) _hub = new HubTable();
+    for (const std::string& peer : peers) {
+        std::string host = peer;
+        uint16_t port = 80;
+        size_t colon = peer.rfind(':');
+        if (colon != std::string::npos) {
+            host = peer.substr(0, colon);
+            port = (uint16_t)atoi(peer.c_str() + colon + 1);
+        }
+        if (_hub->add(nullptr, host.c_str(), port ? port : 80, 0, true) < 0) {
+            printf("[HUB] Peer table full, ignoring %s\n", peer.c_str());
+        }
+    }
+    printf("[HUB] Hub mode on, polling %u peers every %u ms\n",
+           (unsigned)_hub->count(), (unsigned)HUB_POLL_MS);
+}
 
-    size_t msgLen = 0;
-    char* msg = bbq_protocol::buildHistoryMessage(
-        _history.data(), _history.size(),
-        _setpoint, _meat1Target, _meat2Target, &msgLen);
+void SimWebServer::pollPeers() {
+    uint32_t now = (uint32_t)mg_millis();
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        const HubPeer* p = _hub->peer(i);
+        if (!p || _hubPolling[i]) continue;
+        if (!_hub->connectDue(i, now) || now - (uint32_t)_hubPollMs[i] < HUB_POLL_MS) continue;
+
+        char url[HUB_HOST_LEN + 32];
+        snprintf(url, sizeof(url), "http://%s:%u/api/state", p->host, (unsigned)p->port);
+        _hubPollMs[i] = now;
+        if (mg_http_connect(_mgr, url, hubClientHandler, (void*)(intptr_t)(i + 1))) {
+            _hubPolling[i] = true;
+        } else {
+            _hub->failed(i, now);
+        }
+    }
+}
 
-    if (msg) {
-        mg_ws_send(c, msg, msgLen, WEBSOCKET_OP_TEXT);
-        free(msg);
+void SimWebServer::hubClientHandler(struct mg_connection* c, int ev, void* ev_data) {
+    SimWebServer* self = g_simWebServer;
+    if (!self || !self->_hub) return;
+    int slot = (int)(intptr_t)c->fn_data - 1;
+    const HubPeer* p = self->_hub->peer(slot);
+    uint32_t now = (uint32_t)mg_millis();
+
+    if (ev == MG_EV_CONNECT && p) {
+        mg_printf(c, "GET /api/state HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", p->host);
+    } else if (ev == MG_EV_HTTP_MSG) {
+        struct mg_http_message* hm = (struct mg_http_message*)ev_data;
+        if (mg_http_status(hm) == 200) {
+            self->_hub->frame(slot, hm->body.buf, hm->body.len, now);
+        } else {
+            self->_hub->failed(slot, now);
+        }
+        self->_hubPolling[slot] = false;
+        c->is_closing = 1;
+    } else if (ev == MG_EV_POLL) {
+        if (now - (uint32_t)self->_hubPollMs[slot] > HUB_CONNECT_TIMEOUT_MS) c->is_closing = 1;
+    } else if (ev == MG_EV_CLOSE) {
+        // Closed without a response: refused, unreachable or timed out
+        if (slot >= 0 && slot < HUB_MAX_PEERS && self->_hubPolling[slot]) {
+            self->_hubPolling[slot] = false;
+            self->_hub->failed(slot, now);
+        }
     }
 }
 
-void SimWebServer::sendCSVDownload(struct mg_connection* c) {
-    // Build CSV from history data
-    // Header
-    std::string csv = "timestamp,pit,meat1,meat2,fan,damper,setpoint,lid\n";
-    char line[256];
+static void appendTo(const char* text, size_t len, void* ctx) {
+    static_cast<std::string*>(ctx)->append(text, len);
+}
 
-    for (size_t i = 0; i < _history.size(); i++) {
-        const bbq_protocol::HistoryPoint& p = _history[i];
-        int pos = snprintf(line, sizeof(line), "%u,", (unsigned)p.ts);
+void SimWebServer::sendHub(struct mg_connection* c, struct mg_http_message* hm) {
+    std::string body;
+    if (mg_match(hm->uri, mg_str("/api/hub/history"), nullptr)) {
+        char id[8] = "", since[16] = "";
+        mg_http_get_var(&hm->query, "id", id, sizeof(id));
+        mg_http_get_var(&hm->query, "since", since, sizeof(since));
+        if (!id[0] || !_hub->writeHistory(appendTo, &body, atoi(id),
+                                          (uint32_t)strtoul(since, nullptr, 10))) {
+            mg_http_reply(c, 404, "Content-Type: text/plain\r\n", "No such peer");
+            return;
+        }
+    } else {
+        _hub->writeState(appendTo, &body, "simulator", _stateJson.data(), _stateJson.size(),
+                         (uint32_t)mg_millis());
+    }
+    mg_http_reply(c, 200, "Content-Type: application/json\r\nCache-Control: no-store\r\n",
+                  "%s", body.c_str());
+}
 
-        if (std::isnan(p.pit))   pos += snprintf(line + pos, sizeof(line) - pos, ",");
-        else                     pos += snprintf(line + pos, sizeof(line) - pos, "%.1f,", p.pit);
+SimWebServer::Replay* SimWebServer::findReplay(unsigned long connId) {
+    for (Replay& r : _replays) {
+        if (r.connId == connId) return &r;
+    }
+    return nullptr;
+}
 
-        if (std::isnan(p.meat1)) pos += snprintf(line + pos, sizeof(line) - pos, ",");
-        else                     pos += snprintf(line + pos, sizeof(line) - pos, "%.1f,", p.meat1);
+void SimWebServer::sendHistory(struct mg_connection* c) {
+    Replay* r = findReplay(c->id);
+    if (!r) r = findReplay(0);
+    if (!r) return;
+
+    r->connId    = c->id;
+    r->maxPoints = WS_HISTORY_MAX_POINTS;
+    r->holdMs    = 0;
+    r->stream.active = false;
+    if (_session.getPointCount() == 0) return;
+
+    // As on the device: the replay holds for the hello, which reports the
+    // client's chart width
+    historyStreamBegin(r->stream, _session, r->maxPoints);
+    r->holdMs = mg_millis() + WS_HELLO_WAIT_MS;
+}
 
-        if (std::isnan(p.meat2)) pos += snprintf(line + pos, sizeof(line) - pos, ",");
-        else                     pos += snprintf(line + pos, sizeof(line) - pos, "%.1f,", p.meat2);
+void SimWebServer::pumpHistory() {
+    uint64_t now = mg_millis();
+    for (struct mg_connection* c = _mgr->conns; c != nullptr; c = c->next) {
+        if (!c->is_websocket) continue;
+        Replay* r = findReplay(c->id);
+        if (!r || !r->stream.active) continue;
+        if (r->holdMs != 0) {
+            if (now < r->holdMs) continue;
+            r->holdMs = 0;
+        }
 
-        pos += snprintf(line + pos, sizeof(line) - pos, "%u,%u,%d,%s\n",
-            (unsigned)p.fan, (unsigned)p.damper, (int)p.sp,
-            p.lid ? "true" : "false");
+        // Back-pressure: one chunk at a time once the previous has gone out
+        if (c->send.len > WS_HISTORY_CHUNK_BYTES / 2) continue;
 
-        csv += line;
+        bool final = false;
+        size_t len = historyStreamNext(r->stream, _session, _scratch,
+                                       _setpoint, _meatTarget, final);
+        if (len == 0) {
+            printf("[WEB] History chunk %u overflow\n", (unsigned)r->stream.chunk);
+            continue;
+        }
+        mg_ws_send(c, _scratch.buf, len, WEBSOCKET_OP_TEXT);
+        if (final) {
+            printf("[WEB] History replay done (%u chunks, level %u)\n",
+                   (unsigned)r->stream.chunk, (unsigned)r->stream.level);
+        }
     }
+}
+
+std::string SimWebServer::buildCSV() const {
+    std::string csv;
+    ExportCursor cursor;
+    _session.beginExport(cursor, ExportFormat::CSV);
+    char chunk[1024];
+    size_t n;
+    while ((n = _session.exportChunk(cursor, chunk, sizeof(chunk))) > 0) {
+        csv.append(chunk, n);
+    }
+    return csv;
+}
 
-    size_t envLen = 0;
-    char* envelope = bbq_protocol::buildCSVDownloadEnvelope(csv.c_str(), csv.length(), &envLen);
-    if (envelope) {
-        mg_ws_send(c, envelope, envLen, WEBSOCKET_OP_TEXT);
-        free(envelope);
+void SimWebServer::sendDownloadPointer(struct mg_connection* c) {
+    // Only /api/session.csv is served here
+    char buf[DOWNLOAD_POINTER_MAX_BYTES];
+    size_t len = bbq_protocol::buildDownloadPointer(buf, sizeof(buf), "csv");
+    if (len > 0) {
+        mg_ws_send(c, buf, len, WEBSOCKET_OP_TEXT);
     }
 }
 
@@ -163,21 +322,19 @@ void SimWebServer::handleMessage(struct mg_connection* c, const char* data, size
 
     switch (cmd.type) {
         case bbq_protocol::CmdType::SET_SP:
+            if (cmd.zone != 0) break;   // The thermal model has one chamber
             if (_onSetpoint) _onSetpoint(cmd.setpoint);
             _setpoint = cmd.setpoint;
             printf("[WEB] Setpoint changed to %.0f via web UI\n", cmd.setpoint);
             break;
 
         case bbq_protocol::CmdType::ALARM:
-            if (cmd.hasMeat1Target) {
-                _meat1Target = cmd.meat1Target;
-                if (_onAlarm) _onAlarm("meat1", cmd.meat1Target);
-                printf("[WEB] Meat1 target set to %.0f\n", cmd.meat1Target);
-            }
-            if (cmd.hasMeat2Target) {
-                _meat2Target = cmd.meat2Target;
-                if (_onAlarm) _onAlarm("meat2", cmd.meat2Target);
-                printf("[WEB] Meat2 target set to %.0f\n", cmd.meat2Target);
+            for (uint8_t m = 0; m < NUM_MEATS; m++) {
+                if (!(cmd.meatTargetMask & (1u << m))) continue;
+                const char* key = kProbeChannels[PROBE_MEAT1 + m].key;
+                _meatTarget[m] = cmd.meatTarget[m];
+                if (_onAlarm) _onAlarm(key, cmd.meatTarget[m]);
+                printf("[WEB] %s target set to %.0f\n", key, cmd.meatTarget[m]);
             }
             if (cmd.hasPitBand && _onAlarm) {
                 _onAlarm("pitBand", cmd.pitBand);
@@ -192,7 +349,7 @@ void SimWebServer::handleMessage(struct mg_connection* c, const char* data, size
 
         case bbq_protocol::CmdType::SESSION_DOWNLOAD:
             printf("[WEB] CSV download requested\n");
-            sendCSVDownload(c);
+            sendDownloadPointer(c);
             break;
 
         case bbq_protocol::CmdType::SET_FAN_MODE:
@@ -200,6 +357,31 @@ void SimWebServer::handleMessage(struct mg_connection* c, const char* data, size
             if (_onFanMode) _onFanMode(cmd.fanMode);
             break;
 
+        case bbq_protocol::CmdType::HELLO:
+            // Frames stay JSON, but the chart width picks the replay's LOD.
+            // A replay still held for the hello restarts at the new level;
+            // the sim's session has no start time to resume against.
+            if (Replay* r = findReplay(c->id)) {
+                bool held = r->holdMs != 0;
+                r->holdMs = 0;
+                if (cmd.historyPoints > 0 && cmd.historyPoints != r->maxPoints) {
+                    r->maxPoints = cmd.historyPoints;
+                    if (held && r->stream.active) historyStreamBegin(r->stream, _session, r->maxPoints);
+                }
+            }
+            break;
+
+        case bbq_protocol::CmdType::PING:
+            {
+                // Same clock as the frames' sampleUs, so the web UI's
+                // latency readout works here; reports aren't kept
+                char pong[PONG_MAX_BYTES];
+                size_t n = bbq_protocol::buildPong(pong, sizeof(pong), cmd.pingT,
+                                                   (uint32_t)metricsNowUs());
+                if (n > 0) mg_ws_send(c, pong, n, WEBSOCKET_OP_TEXT);
+            }
+            break;
+
         default:
             break;
     }
@@ -226,6 +408,39 @@ void SimWebServer::eventHandler(struct mg_connection* c, int ev, void* ev_data)
             return;
         }
 
+        // Current data frame, as on the device
+        if (mg_match(hm->uri, mg_str("/api/state"), nullptr)) {
+            if (self->_stateJson.empty()) {
+                mg_http_reply(c, 503, "Content-Type: text/plain\r\n", "No data yet");
+            } else {
+                mg_http_reply(c, 200, "Content-Type: application/json\r\nCache-Control: no-store\r\n",
+                              "%s", self->_stateJson.c_str());
+            }
+            return;
+        }
+
+        // Hub mode
+        if (mg_match(hm->uri, mg_str("/api/hub"), nullptr)
+            || mg_match(hm->uri, mg_str("/api/hub/history"), nullptr)) {
+            if (!self->_hub) {
+                mg_http_reply(c, 404, "Content-Type: text/plain\r\n", "Hub mode is off");
+            } else {
+                self->sendHub(c, hm);
+            }
+            return;
+        }
+
+        // Session export, built from the session's streaming export
+        if (mg_match(hm->uri, mg_str("/api/session.csv"), nullptr)) {
+            std::string csv = self->buildCSV();
+            mg_printf(c, "HTTP/1.1 200 OK\r\n"
+                         "Content-Type: text/csv\r\n"
+                         "Content-Disposition: attachment; filename=\"cook-session.csv\"\r\n"
+                         "Content-Length: %u\r\n\r\n", (unsigned)csv.size());
+            mg_send(c, csv.data(), csv.size());
+            return;
+        }
+
         // Serve static files from firmware/data/
         struct mg_http_serve_opts opts;
         memset(&opts, 0, sizeof(opts));
@@ -248,6 +463,10 @@ void SimWebServer::eventHandler(struct mg_connection* c, int ev, void* ev_data)
     else if (ev == MG_EV_CLOSE) {
         if (c->is_websocket) {
             printf("[WEB] WebSocket client disconnected\n");
+            if (Replay* r = self->findReplay(c->id)) {
+                r->connId = 0;
+                r->stream.active = false;
+            }
         }
     }
 }
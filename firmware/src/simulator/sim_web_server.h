@@ -2,8 +2,13 @@
 
 #ifdef SIMULATOR_BUILD
 
+#include "sim_string.h"
 #include "../web_protocol.h"
+#include "../hub_peers.h"
+#include "../cook_session.h"
+#include "../history_stream.h"
 #include <vector>
+#include <string>
 #include <cstdint>
 
 // Forward declare mongoose struct
@@ -24,17 +29,21 @@ public:
     // Broadcast a data message to all connected WebSocket clients
     void broadcastData(const bbq_protocol::DataPayload& data);
 
-    // Accumulate a history point (called each sim update)
-    void addHistoryPoint(const bbq_protocol::HistoryPoint& point);
+    // Record the frame into the cook session (called each sim update;
+    // sampled every SESSION_SAMPLE_INTERVAL of sim time, as on the device)
+    void recordSample(const bbq_protocol::DataPayload& data);
 
     // Clear history (new session)
     void clearHistory();
 
+    // The cook session behind history replay and export
+    const CookSession& getSession() const { return _session; }
+
     // Perform a new-session reset: clear history + broadcast to all WS clients
     void resetSession();
 
-    // Current state for history envelope
-    void setState(float setpoint, float meat1Target, float meat2Target);
+    // Current state for history envelope; meatTargets holds NUM_MEATS
+    void setState(float setpoint, const float* meatTargets);
 
     // Callbacks for incoming commands
     void onSetpoint(void (*cb)(float));
@@ -46,19 +55,52 @@ public:
     // Number of connected WebSocket clients
     int getClientCount() const;
 
+    // Hub mode: poll each peer's /api/state (mongoose has no mDNS browser,
+    // so peers are given as host:port) and serve /api/hub and
+    // /api/hub/history. Call after begin().
+    void enableHub(const std::vector<std::string>& peers);
+
     // Static event handler (mongoose callback)
     static void eventHandler(struct mg_connection* c, int ev, void* ev_data);
 
+    // Hub poll connections; fn_data is the peer slot + 1
+    static void hubClientHandler(struct mg_connection* c, int ev, void* ev_data);
+
 private:
     struct mg_mgr* _mgr;
     char _staticDir[256];
     int _port;
 
-    // Session history for replay
-    std::vector<bbq_protocol::HistoryPoint> _history;
+    // Cook history: the firmware's ring, rollup tiers and event journal,
+    // sized as on a board with PSRAM
+    CookSession _session;
+    uint32_t    _lastSampleTs;
+
+    // Chunked replay per WebSocket client (history_stream.h), paced by
+    // what mongoose still has queued for the connection
+    struct Replay {
+        unsigned long  connId;     // mg_connection id, 0 = free
+        HistoryStream  stream;
+        uint16_t       maxPoints;  // Client's LOD budget
+        uint64_t       holdMs;     // Replay waits for hello until then (0 = not held)
+    };
+    Replay         _replays[WS_MAX_CLIENTS];
+    HistoryScratch _scratch;
+    Replay* findReplay(unsigned long connId);
+    void pumpHistory();
+
+    // Last data frame, for /api/state (and hubs polling it)
+    std::string _stateJson;
+
+    // Hub mode (null when off)
+    HubTable* _hub;
+    bool      _hubPolling[HUB_MAX_PEERS];   // Request in flight
+    uint64_t  _hubPollMs[HUB_MAX_PEERS];    // When it was sent
+    void pollPeers();
+    void sendHub(struct mg_connection* c, struct mg_http_message* hm);
+
     float _setpoint;
-    float _meat1Target;
-    float _meat2Target;
+    float _meatTarget[NUM_MEATS];
 
     // Callbacks
     void (*_onSetpoint)(float);
@@ -70,11 +112,15 @@ private:
     // Handle incoming WS message
     void handleMessage(struct mg_connection* c, const char* data, size_t len);
 
-    // Send history to a newly connected client
+    // Start a chunked history replay to a client
     void sendHistory(struct mg_connection* c);
 
-    // Build and send CSV download to a client
-    void sendCSVDownload(struct mg_connection* c);
+    // Session history as CSV via the session's streaming export
+    // (/api/session.csv)
+    std::string buildCSV() const;
+
+    // Answer a WebSocket download request with the HTTP export's URL
+    void sendDownloadPointer(struct mg_connection* c);
 };
 
 // Global pointer for mongoose static callback to access instance
@@ -1,37 +1,55 @@
 #pragma once
 
-#include <cmath>
-#include <cstring>
+#include "fan_mode.h"
 
 struct SplitRangeOutput {
     float fanPercent;
     float damperPercent;
 };
 
-// Compute fan and damper percentages from a PID output using split-range coordination.
-// fanMode: "fan_only", "damper_primary", or "fan_and_damper" (default)
-// fanOnThreshold: PID output threshold above which fan activates (fan_and_damper mode)
-inline SplitRangeOutput splitRange(float pidOutput, const char* fanMode, float fanOnThreshold) {
-    float fanPct = 0.0f;
-    float damperPct = 0.0f;
-
-    if (strcmp(fanMode, "fan_only") == 0) {
-        fanPct = pidOutput;
-        damperPct = 100.0f;
-    } else if (strcmp(fanMode, "damper_primary") == 0) {
-        float dpThreshold = fmaxf(fanOnThreshold, 50.0f);
-        damperPct = pidOutput;
-        if (pidOutput > dpThreshold) {
-            fanPct = (pidOutput - dpThreshold) / (100.0f - dpThreshold) * 100.0f;
-            damperPct = 100.0f;
-        }
-    } else {
-        // fan_and_damper (default)
-        damperPct = pidOutput;
-        if (pidOutput > fanOnThreshold) {
-            fanPct = (pidOutput - fanOnThreshold) / (100.0f - fanOnThreshold) * 100.0f;
-        }
-    }
-
-    return { fanPct, damperPct };
+// Split-range coordination: how one PID output (0-100%) drives both the fan
+// and the damper. One constexpr function per FanMode, picked from a table
+// indexed by the mode, so the control loop does no string compares. A new
+// curve is a new FanMode plus a row here.
+typedef SplitRangeOutput (*SplitRangeFn)(float pidOutput, float fanOnThreshold);
+
+// Fan percentage once the PID output passes threshold, rescaled to 0-100
+constexpr float splitRangeFanAbove(float pidOutput, float threshold) {
+    return pidOutput > threshold ? (pidOutput - threshold) / (100.0f - threshold) * 100.0f : 0.0f;
+}
+
+// fan_only: damper held open, the fan follows the PID output
+constexpr SplitRangeOutput splitRangeFanOnly(float pidOutput, float) {
+    return { pidOutput, 100.0f };
+}
+
+// fan_and_damper: damper follows the output, fan joins above fanOnThreshold
+constexpr SplitRangeOutput splitRangeFanAndDamper(float pidOutput, float fanOnThreshold) {
+    return { splitRangeFanAbove(pidOutput, fanOnThreshold), pidOutput };
+}
+
+constexpr SplitRangeOutput splitRangeDamperPrimaryAt(float pidOutput, float dpThreshold) {
+    return { splitRangeFanAbove(pidOutput, dpThreshold),
+             pidOutput > dpThreshold ? 100.0f : pidOutput };
+}
+
+// damper_primary: damper opens fully before the fan starts, at 50% or
+// fanOnThreshold, whichever is higher
+constexpr SplitRangeOutput splitRangeDamperPrimary(float pidOutput, float fanOnThreshold) {
+    return splitRangeDamperPrimaryAt(pidOutput, fanOnThreshold > 50.0f ? fanOnThreshold : 50.0f);
+}
+
+// In FanMode order
+static constexpr SplitRangeFn kSplitRangeFns[FAN_MODE_COUNT] = {
+    splitRangeFanOnly,
+    splitRangeFanAndDamper,
+    splitRangeDamperPrimary,
+};
+
+// Compute fan and damper percentages from a PID output.
+// fanOnThreshold: PID output above which the fan activates
+inline SplitRangeOutput splitRange(float pidOutput, FanMode fanMode, float fanOnThreshold) {
+    uint8_t i = (uint8_t)fanMode;
+    if (i >= FAN_MODE_COUNT) i = (uint8_t)FAN_MODE_DEFAULT;
+    return kSplitRangeFns[i](pidOutput, fanOnThreshold);
 }
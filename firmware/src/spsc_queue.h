@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Single-producer, single-consumer ring of N plain structs, for handing
+// events from one task to another without a lock.
+//
+// push() and pop() never wait on the other side, so the producer may
+// preempt the consumer on the same core (async_tcp over loop()) or run on
+// another core. The head and tail count up freely and are masked into the
+// ring, so all N slots are usable. N must be a power of two.
+//
+// Pure C++11 — no FreeRTOS or Arduino dependencies. Fully testable on native.
+template <typename T, uint16_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    // Producer only. False (nothing queued) if the ring is full.
+    bool push(const T& item) {
+        uint16_t head = _head.load(std::memory_order_relaxed);
+        if ((uint16_t)(head - _tail.load(std::memory_order_acquire)) >= N) return false;
+        _items[head & (N - 1)] = item;
+        _head.store((uint16_t)(head + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. False if the ring is empty.
+    bool pop(T& out) {
+        uint16_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        out = _items[tail & (N - 1)];
+        _tail.store((uint16_t)(tail + 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::atomic<uint16_t> _head;   // Next slot to fill, written by the producer
+    std::atomic<uint16_t> _tail;   // Next slot to drain, written by the consumer
+    T _items[N];
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "seqlock.h"
+#include "temp_manager.h"
+#include "temp_predictor.h"
+#include "alarm_manager.h"
+#include "error_manager.h"
+#include "cook_session.h"
+
+// A control zone past zone 0 (control_zone.h), as of the tick. Zone 0 is
+// the snapshot's own setpoint/pidOutput/fanPct/damperPct fields.
+struct ZoneReading {
+    uint8_t probe;                      // Probe channel it regulates on
+    float   setpoint;
+    float   pidOutput;
+    float   fanPct;
+    float   damperPct;
+    bool    lidOpen;
+    bool    pitReached;
+};
+
+// Everything the UI, web server and session logger need from the control
+// loop, sampled once per control tick. The control task is the only writer;
+// every other consumer reads a copy through the Seqlock and never touches
+// the control modules directly.
+struct TelemetrySnapshot {
+    uint32_t    tickMs;                 // millis() of the tick that produced it
+    uint32_t    sampleUs;               // Pit probe's TempManager::getSampleUs(): when its reading was taken
+    float       temp[NUM_PROBES];       // Filtered temps in configured units
+    bool        connected[NUM_PROBES];
+    ProbeStatus status[NUM_PROBES];
+    float       setpoint;
+    float       pidOutput;
+    bool        autoTuning;             // Relay auto-tune driving the output
+    float       fanPct;
+    float       damperPct;
+    bool        lidOpen;
+    bool        fireOut;
+    bool        pitReached;
+    AlarmType   alarms[MAX_ACTIVE_ALARMS];
+    uint8_t     alarmCount;
+    float       meatTarget[NUM_MEATS];  // By meat probe (channel - 1), 0 = not set
+    PredictorEstimate estimate;         // Latest of the meat probes
+    uint32_t    meatEst[NUM_MEATS];     // Done-time estimate per meat probe, 0 = none
+    char        fanMode[16];            // "fan_only", "fan_and_damper", "damper_primary"
+    ErrorEntry  errors[MAX_ERRORS];
+    uint8_t     errorCount;
+    ZoneReading zones[CONTROL_ZONES_MAX - 1];
+    uint8_t     zoneCount;              // Zones in use past zone 0
+};
+
+typedef Seqlock<TelemetrySnapshot> TelemetryChannel;
+
+// Active alarms of a snapshot by channel, as dpAlarmMask(): bit 0 = pit
+// high or low, bit c = the done alarm of channel c.
+inline uint16_t telemetryAlarmMask(const TelemetrySnapshot& t) {
+    uint16_t mask = 0;
+    for (uint8_t i = 0; i < t.alarmCount; i++) {
+        AlarmType a = t.alarms[i];
+        uint8_t meat = alarmMeatIndex(a);
+        if (a == AlarmType::PIT_HIGH || a == AlarmType::PIT_LOW) mask |= 1u << PROBE_PIT;
+        else if (meat < NUM_MEATS)                                mask |= 1u << (meat + 1);
+    }
+    return mask;
+}
+
+// DataPoint flags (DP_FLAG_*) for a snapshot, as logged by CookSession.
+// Done alarms past meat2 go in alarmExt (telemetryAlarmMask()).
+inline uint8_t telemetryFlags(const TelemetrySnapshot& t) {
+    uint8_t flags = 0;
+    if (t.lidOpen)                     flags |= DP_FLAG_LID_OPEN;
+    if (!t.connected[PROBE_PIT])       flags |= DP_FLAG_PIT_DISC;
+    if (!t.connected[PROBE_MEAT1])     flags |= DP_FLAG_MEAT1_DISC;
+    if (!t.connected[PROBE_MEAT2])     flags |= DP_FLAG_MEAT2_DISC;
+    if (t.fireOut)                     flags |= DP_FLAG_ERROR_FIREOUT;
+    flags |= (uint8_t)((telemetryAlarmMask(t) & 0x07) << DP_FLAG_ALARM_SHIFT);
+    return flags;
+}
+
+// Per-probe input for ErrorManager::update() from a snapshot's probe fields.
+inline void telemetryProbeStates(const TelemetrySnapshot& t, ProbeState out[NUM_PROBES]) {
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        out[i].connected    = t.connected[i];
+        out[i].openCircuit  = (t.status[i] == ProbeStatus::OPEN_CIRCUIT);
+        out[i].shortCircuit = (t.status[i] == ProbeStatus::SHORT_CIRCUIT);
+        out[i].temperature  = t.temp[i];
+    }
+}
+
+// Copy a fan-mode string into the snapshot's fixed buffer.
+inline void telemetrySetFanMode(TelemetrySnapshot& t, const char* mode) {
+    strncpy(t.fanMode, mode ? mode : "fan_and_damper", sizeof(t.fanMode) - 1);
+    t.fanMode[sizeof(t.fanMode) - 1] = '\0';
+}
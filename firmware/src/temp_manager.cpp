@@ -4,24 +4,48 @@
 #include <Arduino.h>
 #endif
 
-// ADC channel mapping: probe index -> ADS1115 channel
-const uint8_t TempManager::_adcChannels[NUM_PROBES] = {
-    ADC_CHANNEL_PIT,
-    ADC_CHANNEL_MEAT1,
-    ADC_CHANNEL_MEAT2
+#ifndef NATIVE_BUILD
+// Single-ended MUX setting for each ADS1115 channel
+static const uint16_t kMuxByChannel[4] = {
+    ADS1X15_REG_CONFIG_MUX_SINGLE_0,
+    ADS1X15_REG_CONFIG_MUX_SINGLE_1,
+    ADS1X15_REG_CONFIG_MUX_SINGLE_2,
+    ADS1X15_REG_CONFIG_MUX_SINGLE_3
 };
 
+volatile bool TempManager::_alertFlag = false;
+
+void IRAM_ATTR TempManager::onAlertReady() {
+    _alertFlag = true;
+}
+#endif
+
 TempManager::TempManager()
-    : _emaAlpha(TEMP_EMA_ALPHA)
+    : _useLUT(TEMP_LUT_ENABLED)
+    , _emaAlpha(TEMP_EMA_ALPHA)
+    , _oversampleN(TEMP_AVG_SAMPLES)
+    , _sampleFilter(SampleFilter::MEDIAN)
     , _useFahrenheit(true)
     , _lastSampleMs(0)
+    , _convPending(false)
+    , _convProbe(0)
+    , _convStartMs(0)
+    , _convStartUs(0)
+    , _convTimeouts(0)
 {
+#ifndef NATIVE_BUILD
+    for (uint8_t a = 0; a < PROBE_ADC_COUNT; a++) _adsOk[a] = false;
+#endif
     for (uint8_t i = 0; i < NUM_PROBES; i++) {
         _rawADC[i] = 0;
+        _sampleUs[i] = 0;
         _filteredTempC[i] = 0.0f;
         _status[i] = ProbeStatus::OPEN_CIRCUIT;
         _firstReading[i] = true;
+        _ringCount[i] = 0;
+        _ringStartUs[i] = 0;
         // ProbeConfig default-initialized with THERM_A/B/C and offset 0
+        buildLookupTable(i);
     }
 }
 
@@ -29,70 +53,202 @@ bool TempManager::begin() {
 #ifndef NATIVE_BUILD
     Wire.begin(PIN_SDA, PIN_SCL);
 
-    if (!_ads.begin(ADS1115_ADDR, &Wire)) {
-        Serial.println("[TEMP] ADS1115 not found at 0x48!");
-        return false;
+    bool ok = true;
+    for (uint8_t a = 0; a < PROBE_ADC_COUNT; a++) {
+        _adsOk[a] = _ads[a].begin(kProbeAdcAddr[a], &Wire);
+        if (!_adsOk[a]) {
+            Serial.printf("[TEMP] ADS1115 not found at 0x%02X!\n", kProbeAdcAddr[a]);
+            ok = false;
+            continue;
+        }
+        // Set gain to GAIN_ONE (+/- 4.096V range)
+        _ads[a].setGain(GAIN_ONE);
     }
 
-    // Set gain to GAIN_ONE (+/- 4.096V range)
-    _ads.setGain(GAIN_ONE);
+    // ALERT/RDY pulses low when a conversion finishes, so the pipeline can
+    // skip the I2C status poll entirely when the pin is wired.
+    if (ADS1115_ALERT_PIN >= 0) {
+        pinMode(ADS1115_ALERT_PIN, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(ADS1115_ALERT_PIN), onAlertReady, FALLING);
+    }
 
-    Serial.println("[TEMP] ADS1115 initialized OK.");
+    Serial.printf("[TEMP] %u probe channels on %u ADS1115 (%s).\n",
+                  (unsigned)NUM_PROBES, (unsigned)PROBE_ADC_COUNT,
+                  ADS1115_ALERT_PIN >= 0 ? "ALERT/RDY interrupt" : "I2C polling");
+#else
+    bool ok = true;
 #endif
     _lastSampleMs = 0;
-    return true;
+    _convPending = false;
+    _convProbe = 0;
+    return ok;
 }
 
 void TempManager::update() {
 #ifndef NATIVE_BUILD
+    MetricTimer timer(Metric::TEMP_UPDATE);
     unsigned long now = millis();
+
+    // Collect the in-flight conversion, then immediately start the next
+    // one so the ADC converts while the rest of loop() runs.
+    if (_convPending) {
+        bool probeDone;
+        if (!conversionReady()) {
+            if (now - _convStartMs < ADS1115_TIMEOUT_MS) {
+                return;  // Still converting -- check again next loop
+            }
+            // Lost conversion; drop this probe's partial ring and keep
+            // its previous reading until the next interval
+            _convTimeouts++;
+            _ringCount[_convProbe] = 0;
+            probeDone = true;
+        } else {
+            metricObserve(Metric::ADC_CONVERSION, (uint32_t)metricsNowUs() - _convStartUs);
+            pushConversion(_convProbe,
+                           _ads[kProbeChannels[_convProbe].adc].getLastConversionResults());
+            probeDone = (_ringCount[_convProbe] == 0);  // Ring reduced and emptied
+        }
+        _convPending = false;
+
+        if (probeDone) {
+            _convProbe++;
+        }
+        // Channels on a missing ADC are skipped and keep reading open
+        while (_convProbe < NUM_PROBES && !startConversion(_convProbe)) {
+            _convProbe++;
+        }
+        return;
+    }
+
     if (now - _lastSampleMs < TEMP_SAMPLE_INTERVAL_MS) {
         return;  // Not time to sample yet
     }
     _lastSampleMs = now;
 
-    for (uint8_t i = 0; i < NUM_PROBES; i++) {
-        // Read raw ADC value from ADS1115 single-ended
-        int16_t raw = _ads.readADC_SingleEnded(_adcChannels[i]);
-        _rawADC[i] = raw;
-
-        // Check for probe errors
-        if (raw >= ERROR_PROBE_OPEN_THRESHOLD) {
-            _status[i] = ProbeStatus::OPEN_CIRCUIT;
-            _firstReading[i] = true;  // Reset EMA on reconnect
-            continue;
+    _convProbe = 0;
+    while (_convProbe < NUM_PROBES && !startConversion(_convProbe)) {
+        _convProbe++;
+    }
+#endif
+}
+
+#ifndef NATIVE_BUILD
+bool TempManager::startConversion(uint8_t probe) {
+    const ProbeChannel& ch = kProbeChannels[probe];
+    if (!_adsOk[ch.adc]) return false;
+
+    // Both ADCs can share the ALERT/RDY pin: only the converting one pulses it
+    _alertFlag = false;
+    _ads[ch.adc].startADCReading(kMuxByChannel[ch.input], /*continuous=*/false);
+    _convStartMs = millis();
+    _convStartUs = (uint32_t)metricsNowUs();
+    _convPending = true;
+    return true;
+}
+
+bool TempManager::conversionReady() {
+    if (ADS1115_ALERT_PIN >= 0) {
+        return _alertFlag;
+    }
+    return _ads[kProbeChannels[_convProbe].adc].conversionComplete();
+}
+#endif
+
+void TempManager::pushConversion(uint8_t probe, int16_t raw) {
+    if (probe >= NUM_PROBES) return;
+
+    if (_ringCount[probe] == 0) _ringStartUs[probe] = (uint32_t)metricsNowUs();
+    _ring[probe][_ringCount[probe]++] = raw;
+    if (_ringCount[probe] < _oversampleN) {
+        return;
+    }
+
+    int16_t reduced = reduceSamples(_ring[probe], _ringCount[probe], _sampleFilter);
+    _ringCount[probe] = 0;
+    processSample(probe, reduced, _ringStartUs[probe]);
+}
+
+int16_t TempManager::reduceSamples(int16_t* buf, uint8_t n, SampleFilter filter) {
+    if (n == 0) return 0;
+    if (n == 1) return buf[0];
+
+    // Insertion sort -- n is tiny and this keeps it allocation-free
+    for (uint8_t i = 1; i < n; i++) {
+        int16_t v = buf[i];
+        int8_t j = i - 1;
+        while (j >= 0 && buf[j] > v) {
+            buf[j + 1] = buf[j];
+            j--;
         }
-        if (raw <= ERROR_PROBE_SHORT_THRESHOLD) {
-            _status[i] = ProbeStatus::SHORT_CIRCUIT;
-            _firstReading[i] = true;
-            continue;
+        buf[j + 1] = v;
+    }
+
+    if (filter == SampleFilter::TRIMMED_MEAN) {
+        uint8_t trim = TEMP_TRIM_COUNT;
+        if (2 * trim >= n) {
+            trim = (n - 1) / 2;  // Always keep at least one reading
+        }
+        int32_t sum = 0;
+        for (uint8_t i = trim; i < n - trim; i++) {
+            sum += buf[i];
         }
+        uint8_t kept = n - 2 * trim;
+        return (int16_t)((sum + kept / 2) / kept);
+    }
+
+    // Median
+    if (n & 1) {
+        return buf[n / 2];
+    }
+    return (int16_t)(((int32_t)buf[n / 2 - 1] + buf[n / 2] + 1) / 2);
+}
+
+void TempManager::processSample(uint8_t probe, int16_t raw, uint32_t sampleUs) {
+    if (probe >= NUM_PROBES) return;
 
+    _rawADC[probe] = raw;
+    _sampleUs[probe] = sampleUs;
+
+    // Check for probe errors
+    if (raw >= ERROR_PROBE_OPEN_THRESHOLD) {
+        _status[probe] = ProbeStatus::OPEN_CIRCUIT;
+        _firstReading[probe] = true;  // Reset EMA on reconnect
+        return;
+    }
+    if (raw <= ERROR_PROBE_SHORT_THRESHOLD) {
+        _status[probe] = ProbeStatus::SHORT_CIRCUIT;
+        _firstReading[probe] = true;
+        return;
+    }
+
+    float tempC;
+    if (_useLUT) {
+        tempC = lookupTempC(probe, raw);
+    } else {
         // Convert ADC to resistance
         float resistance = adcToResistance(raw);
         if (resistance <= 0.0f) {
-            _status[i] = ProbeStatus::SHORT_CIRCUIT;
-            _firstReading[i] = true;
-            continue;
+            _status[probe] = ProbeStatus::SHORT_CIRCUIT;
+            _firstReading[probe] = true;
+            return;
         }
 
         // Convert resistance to temperature in Celsius
-        float tempC = resistanceToTempC(resistance, _probeConfig[i]);
-
-        // Apply calibration offset
-        tempC += _probeConfig[i].offset;
+        tempC = resistanceToTempC(resistance, _probeConfig[probe]);
+    }
 
-        // Apply EMA filter
-        if (_firstReading[i]) {
-            _filteredTempC[i] = tempC;
-            _firstReading[i] = false;
-        } else {
-            _filteredTempC[i] = _emaAlpha * tempC + (1.0f - _emaAlpha) * _filteredTempC[i];
-        }
+    // Apply calibration offset
+    tempC += _probeConfig[probe].offset;
 
-        _status[i] = ProbeStatus::OK;
+    // Apply EMA filter
+    if (_firstReading[probe]) {
+        _filteredTempC[probe] = tempC;
+        _firstReading[probe] = false;
+    } else {
+        _filteredTempC[probe] = _emaAlpha * tempC + (1.0f - _emaAlpha) * _filteredTempC[probe];
     }
-#endif
+
+    _status[probe] = ProbeStatus::OK;
 }
 
 float TempManager::getTemp(uint8_t probe) const {
@@ -126,12 +282,29 @@ int16_t TempManager::getRawADC(uint8_t probe) const {
     return _rawADC[probe];
 }
 
+uint32_t TempManager::getSampleUs(uint8_t probe) const {
+    if (probe >= NUM_PROBES) return 0;
+    return _sampleUs[probe];
+}
+
 void TempManager::setEMAAlpha(float alpha) {
     if (alpha > 0.0f && alpha <= 1.0f) {
         _emaAlpha = alpha;
     }
 }
 
+void TempManager::setOversampling(uint8_t samples, SampleFilter filter) {
+    if (samples < 1) samples = 1;
+    if (samples > TEMP_OVERSAMPLE_MAX) samples = TEMP_OVERSAMPLE_MAX;
+    _oversampleN = samples;
+    _sampleFilter = filter;
+
+    // Discard partially filled rings so they refill at the new size
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        _ringCount[i] = 0;
+    }
+}
+
 void TempManager::setOffset(uint8_t probe, float offset) {
     if (probe < NUM_PROBES) {
         _probeConfig[probe].offset = offset;
@@ -143,6 +316,7 @@ void TempManager::setCoefficients(uint8_t probe, float a, float b, float c) {
         _probeConfig[probe].a = a;
         _probeConfig[probe].b = b;
         _probeConfig[probe].c = c;
+        buildLookupTable(probe);
     }
 }
 
@@ -150,7 +324,11 @@ void TempManager::setUseFahrenheit(bool useF) {
     _useFahrenheit = useF;
 }
 
-float TempManager::adcToResistance(int16_t raw) const {
+void TempManager::setUseLookupTable(bool useLUT) {
+    _useLUT = useLUT;
+}
+
+float TempManager::adcToResistance(int16_t raw) {
     // Voltage divider: Vout = Vref * R_therm / (R_ref + R_therm)
     // ADC value proportional to voltage: raw / ADC_MAX = Vout / Vref
     // Solving for R_therm:
@@ -163,7 +341,7 @@ float TempManager::adcToResistance(int16_t raw) const {
     return REFERENCE_RESISTANCE * ((float)ADC_MAX_VALUE / (float)raw - 1.0f);
 }
 
-float TempManager::resistanceToTempC(float resistance, const ProbeConfig& cfg) const {
+float TempManager::resistanceToTempC(float resistance, const ProbeConfig& cfg) {
     // Steinhart-Hart equation:
     // 1/T = A + B * ln(R) + C * (ln(R))^3
     // T is in Kelvin
@@ -177,3 +355,25 @@ float TempManager::resistanceToTempC(float resistance, const ProbeConfig& cfg) c
     float tempC = tempK - 273.15f;
     return tempC;
 }
+
+void TempManager::buildLookupTable(uint8_t probe) {
+    for (uint16_t i = 0; i < TEMP_LUT_SIZE; i++) {
+        // Clamp to the range where the divider formula is finite; the ends
+        // are never used in practice since open/short readings are rejected
+        int32_t raw = (int32_t)i << TEMP_LUT_SHIFT;
+        if (raw < 1) raw = 1;
+        if (raw > ADC_MAX_VALUE - 1) raw = ADC_MAX_VALUE - 1;
+
+        _lut[probe][i] = resistanceToTempC(adcToResistance((int16_t)raw), _probeConfig[probe]);
+    }
+}
+
+float TempManager::lookupTempC(uint8_t probe, int16_t raw) const {
+    if (raw < 0) raw = 0;
+    uint16_t idx  = (uint16_t)raw >> TEMP_LUT_SHIFT;
+    uint16_t frac = (uint16_t)raw & ((1u << TEMP_LUT_SHIFT) - 1);
+
+    float lo = _lut[probe][idx];
+    float hi = _lut[probe][idx + 1];
+    return lo + (hi - lo) * ((float)frac / (float)(1u << TEMP_LUT_SHIFT));
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "config.h"
+#include "probe_channels.h"
 #include "units.h"
+#include "metrics.h"
 #include <stdint.h>
 #include <math.h>
 
@@ -10,16 +12,6 @@
 #include <Adafruit_ADS1X15.h>
 #endif
 
-// Number of probe channels
-#define NUM_PROBES 3
-
-// Probe indices
-enum ProbeIndex : uint8_t {
-    PROBE_PIT   = 0,
-    PROBE_MEAT1 = 1,
-    PROBE_MEAT2 = 2
-};
-
 // Probe status
 enum class ProbeStatus : uint8_t {
     OK,
@@ -27,6 +19,21 @@ enum class ProbeStatus : uint8_t {
     SHORT_CIRCUIT    // ADC reads very low (probe shorted)
 };
 
+// Ring capacity for oversampled conversions (upper bound for setOversampling)
+#define TEMP_OVERSAMPLE_MAX 8
+static_assert(TEMP_AVG_SAMPLES >= 1 && TEMP_AVG_SAMPLES <= TEMP_OVERSAMPLE_MAX,
+              "TEMP_AVG_SAMPLES must be 1..TEMP_OVERSAMPLE_MAX");
+
+// Raw ADC -> C lookup table size (one entry per 2^TEMP_LUT_SHIFT counts, plus
+// one past the end so interpolation never reads out of bounds)
+#define TEMP_LUT_SIZE ((ADC_MAX_VALUE >> TEMP_LUT_SHIFT) + 2)
+
+// Spike-rejection stage applied to each probe's oversample ring before the EMA
+enum class SampleFilter : uint8_t {
+    MEDIAN,         // Middle value (mean of the two middle values for even N)
+    TRIMMED_MEAN    // Mean after dropping TEMP_TRIM_COUNT readings from each end
+};
+
 // Per-probe calibration and Steinhart-Hart coefficients
 struct ProbeConfig {
     float a      = THERM_A;
@@ -39,10 +46,14 @@ class TempManager {
 public:
     TempManager();
 
-    // Initialize ADS1115 on I2C bus. Call once from setup().
+    // Initialize the ADS1115s in the channel table on the I2C bus. Call
+    // once from setup(). False if any of them doesn't answer; its channels
+    // then read as disconnected.
     bool begin();
 
-    // Poll probes if the sample interval has elapsed. Call every loop().
+    // Advance the non-blocking acquisition pipeline. Call every loop().
+    // Each call either starts a conversion, collects a finished one, or
+    // returns immediately -- it never waits on the ADC.
     void update();
 
     // Latest smoothed temperature for a given probe (in configured units: F or C)
@@ -65,9 +76,26 @@ public:
     // Raw ADC value (useful for diagnostics)
     int16_t getRawADC(uint8_t probe) const;
 
+    // When the probe's latest reading was taken: metricsNowUs() (low 32
+    // bits, wraps every ~71 min) at the first ADC conversion that went into
+    // it. 0 until the first reading. For end-to-end latency tracing.
+    uint32_t getSampleUs(uint8_t probe) const;
+
+    // Number of conversions abandoned after ADS1115_TIMEOUT_MS (diagnostics)
+    uint32_t getConversionTimeouts() const { return _convTimeouts; }
+
     // Set EMA alpha (smoothing factor, 0-1, higher = less smoothing)
     void setEMAAlpha(float alpha);
 
+    // Set conversions per probe per sample (1..TEMP_OVERSAMPLE_MAX) and the
+    // filter used to reduce them to one reading. 1 disables oversampling.
+    void setOversampling(uint8_t samples, SampleFilter filter);
+    uint8_t getOversampleCount() const { return _oversampleN; }
+    SampleFilter getSampleFilter() const { return _sampleFilter; }
+
+    // Reduce n raw readings to one with the given filter. Sorts buf in place.
+    static int16_t reduceSamples(int16_t* buf, uint8_t n, SampleFilter filter);
+
     // Set calibration offset for a probe (in degrees C)
     void setOffset(uint8_t probe, float offset);
 
@@ -77,29 +105,81 @@ public:
     // Set whether to return temperatures in Fahrenheit
     void setUseFahrenheit(bool useF);
 
+    // Use the precomputed per-probe lookup table instead of evaluating
+    // Steinhart-Hart for every sample. The table is rebuilt by setCoefficients().
+    void setUseLookupTable(bool useLUT);
+    bool getUseLookupTable() const { return _useLUT; }
+
     // Convert Celsius to Fahrenheit (delegates to shared units.h)
     static float cToF(float tempC) { return celsiusToFahrenheit(tempC); }
 
-private:
     // Convert raw ADC value to resistance using voltage divider formula
-    float adcToResistance(int16_t raw) const;
+    static float adcToResistance(int16_t raw);
 
     // Convert resistance to temperature in Celsius using Steinhart-Hart
-    float resistanceToTempC(float resistance, const ProbeConfig& cfg) const;
+    static float resistanceToTempC(float resistance, const ProbeConfig& cfg);
+
+#ifdef NATIVE_BUILD
+    // Test helper: feed a raw ADC reading through the conversion/filter path
+    void injectRawADC(uint8_t probe, int16_t raw) { processSample(probe, raw, (uint32_t)metricsNowUs()); }
+
+    // Test helper: feed one conversion into the probe's oversample ring
+    void injectConversion(uint8_t probe, int16_t raw) { pushConversion(probe, raw); }
+#endif
+
+private:
+    // Add a conversion to the probe's ring; runs processSample() once full
+    void pushConversion(uint8_t probe, int16_t raw);
+
+    // Convert a raw reading into a filtered temperature and update probe
+    // status. sampleUs is when its first conversion was collected.
+    void processSample(uint8_t probe, int16_t raw, uint32_t sampleUs);
+
+#ifndef NATIVE_BUILD
+    // Kick off a single-shot conversion for a probe's ADC channel. False
+    // (nothing started) if that ADC didn't come up.
+    bool startConversion(uint8_t probe);
+
+    // Whether the in-flight conversion has finished (ALERT/RDY or I2C poll)
+    bool conversionReady();
+
+    // ALERT/RDY falling-edge handler
+    static void IRAM_ATTR onAlertReady();
+    static volatile bool _alertFlag;
+#endif
+
+    // Rebuild a probe's lookup table from its current coefficients
+    void buildLookupTable(uint8_t probe);
+
+    // Table lookup with linear interpolation (no offset applied)
+    float lookupTempC(uint8_t probe, int16_t raw) const;
 
 #ifndef NATIVE_BUILD
-    Adafruit_ADS1115 _ads;
+    Adafruit_ADS1115 _ads[PROBE_ADC_COUNT];   // Indexed by ProbeChannel::adc
+    bool             _adsOk[PROBE_ADC_COUNT];
 #endif
 
     // Per-probe state
     int16_t     _rawADC[NUM_PROBES];
+    uint32_t    _sampleUs[NUM_PROBES];
     float       _filteredTempC[NUM_PROBES];
     ProbeStatus _status[NUM_PROBES];
     ProbeConfig _probeConfig[NUM_PROBES];
 
+    // Precomputed raw ADC -> C, indexed by raw >> TEMP_LUT_SHIFT
+    float _lut[NUM_PROBES][TEMP_LUT_SIZE];
+    bool  _useLUT;
+
     // EMA smoothing factor
     float _emaAlpha;
 
+    // Oversample ring feeding the median / trimmed-mean stage
+    int16_t      _ring[NUM_PROBES][TEMP_OVERSAMPLE_MAX];
+    uint8_t      _ringCount[NUM_PROBES];
+    uint32_t     _ringStartUs[NUM_PROBES];  // First conversion in the ring, for _sampleUs
+    uint8_t      _oversampleN;
+    SampleFilter _sampleFilter;
+
     // Whether first reading has been taken (for EMA initialization)
     bool _firstReading[NUM_PROBES];
 
@@ -109,6 +189,12 @@ private:
     // Timing
     unsigned long _lastSampleMs;
 
-    // ADC channel mapping
-    static const uint8_t _adcChannels[NUM_PROBES];
+    // Acquisition pipeline state: one conversion in flight at a time,
+    // taking _oversampleN conversions from each probe channel in turn
+    // once per sample interval
+    bool          _convPending;
+    uint8_t       _convProbe;
+    unsigned long _convStartMs;
+    uint32_t      _convStartUs;     // For the ADC latency metric
+    uint32_t      _convTimeouts;
 };
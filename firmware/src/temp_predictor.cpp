@@ -1,4 +1,5 @@
 #include "temp_predictor.h"
+#include <math.h>
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
@@ -14,14 +15,15 @@ static unsigned long millis() { return _nativeMillis; }
 
 TempPredictor::TempPredictor()
     : _lastSampleMs(0)
+    , _mode(PredictorMode::LINEAR)
+    , _pitTemp(NAN)
 #ifdef NATIVE_BUILD
     , _testEpoch(0)
 #endif
 {
     for (uint8_t i = 0; i < PREDICTOR_NUM_PROBES; i++) {
-        _probes[i].head   = 0;
-        _probes[i].count  = 0;
         _probes[i].target = 0.0f;
+        reset(i);
     }
 }
 
@@ -30,8 +32,7 @@ void TempPredictor::begin() {
     _lastSampleMs = 0;
 }
 
-void TempPredictor::update(float meat1Temp, float meat2Temp,
-                            bool meat1Connected, bool meat2Connected) {
+void TempPredictor::update(const float* meatTemps, const bool* meatConnected) {
 #ifndef NATIVE_BUILD
     unsigned long now = millis();
     if (_lastSampleMs != 0 && (now - _lastSampleMs) < PREDICTOR_SAMPLE_INTERVAL) {
@@ -45,40 +46,49 @@ void TempPredictor::update(float meat1Temp, float meat2Temp,
         return;  // Time not available yet
     }
 
-    if (meat1Connected) {
-        addSampleInternal(PREDICTOR_MEAT1, epoch, meat1Temp);
+    for (uint8_t i = 0; i < PREDICTOR_NUM_PROBES; i++) {
+        if (meatConnected[i]) {
+            addSampleInternal(i, epoch, meatTemps[i], _pitTemp);
+        }
     }
+}
 
-    if (meat2Connected) {
-        addSampleInternal(PREDICTOR_MEAT2, epoch, meat2Temp);
-    }
+void TempPredictor::setPitTemp(float pitTemp, bool connected) {
+    _pitTemp = connected ? pitTemp : NAN;
 }
 
-void TempPredictor::setMeat1Target(float target) {
-    _probes[PREDICTOR_MEAT1].target = target;
+void TempPredictor::setTarget(uint8_t probeIndex, float target) {
+    if (probeIndex >= PREDICTOR_NUM_PROBES) return;
+    _probes[probeIndex].target = target;
 }
 
-void TempPredictor::setMeat2Target(float target) {
-    _probes[PREDICTOR_MEAT2].target = target;
+float TempPredictor::getTarget(uint8_t probeIndex) const {
+    if (probeIndex >= PREDICTOR_NUM_PROBES) return 0.0f;
+    return _probes[probeIndex].target;
 }
 
-uint32_t TempPredictor::getMeat1EstTime() const {
-    return computeEstTime(PREDICTOR_MEAT1);
+uint32_t TempPredictor::getEstTime(uint8_t probeIndex) const {
+    return computeEstimate(probeIndex).est;
 }
 
-uint32_t TempPredictor::getMeat2EstTime() const {
-    return computeEstTime(PREDICTOR_MEAT2);
+uint32_t TempPredictor::getSecondsToTarget(uint8_t probeIndex) const {
+    uint32_t est = computeEstimate(probeIndex).est;
+    uint32_t epoch = getCurrentEpoch();
+    return (est > epoch) ? est - epoch : 0;
 }
 
-float TempPredictor::getMeat1Rate() const {
+float TempPredictor::getRate(uint8_t probeIndex) const {
     // computeSlope returns degrees per second; convert to degrees per minute
-    float slope = computeSlope(PREDICTOR_MEAT1);
-    return slope * 60.0f;
+    return computeSlope(probeIndex) * 60.0f;
+}
+
+PredictorEstimate TempPredictor::getEstimate(uint8_t probeIndex) const {
+    return computeEstimate(probeIndex);
 }
 
-float TempPredictor::getMeat2Rate() const {
-    float slope = computeSlope(PREDICTOR_MEAT2);
-    return slope * 60.0f;
+bool TempPredictor::isStalled(uint8_t probeIndex) const {
+    if (probeIndex >= PREDICTOR_NUM_PROBES) return false;
+    return _probes[probeIndex].stalled;
 }
 
 void TempPredictor::reset() {
@@ -90,11 +100,26 @@ void TempPredictor::reset() {
 void TempPredictor::reset(uint8_t probeIndex) {
     if (probeIndex >= PREDICTOR_NUM_PROBES) return;
 
-    _probes[probeIndex].head  = 0;
-    _probes[probeIndex].count = 0;
+    ProbeWindow& w = _probes[probeIndex];
+    w.head       = 0;
+    w.count      = 0;
+    w.fit.reset(0);
+    w.pairs      = 0;
+    w.sumUU      = 0.0;
+    w.sumUV      = 0.0;
+    w.sumVV      = 0.0;
+    w.kRef       = 0.0f;
+    w.stalled    = false;
+    w.stallStart = 0;
     // Note: target is intentionally preserved across reset
 }
 
+void TempPredictor::prefill(uint8_t probe, uint32_t timestamp,
+                            float temp, float pitTemp) {
+    if (probe >= PREDICTOR_NUM_PROBES) return;
+    addSampleInternal(probe, timestamp, temp, pitTemp);
+}
+
 #ifdef NATIVE_BUILD
 void TempPredictor::setCurrentTime(uint32_t epoch) {
     _testEpoch = epoch;
@@ -102,19 +127,55 @@ void TempPredictor::setCurrentTime(uint32_t epoch) {
 
 void TempPredictor::addSample(uint8_t probe, uint32_t timestamp, float temp) {
     if (probe >= PREDICTOR_NUM_PROBES) return;
-    addSampleInternal(probe, timestamp, temp);
+    addSampleInternal(probe, timestamp, temp, NAN);
+}
+
+void TempPredictor::addSample(uint8_t probe, uint32_t timestamp, float temp, float pitTemp) {
+    if (probe >= PREDICTOR_NUM_PROBES) return;
+    addSampleInternal(probe, timestamp, temp, pitTemp);
 }
 #endif
 
 // --- Private implementation ---
 
-void TempPredictor::addSampleInternal(uint8_t probe, uint32_t timestamp, float temp) {
+void TempPredictor::addSampleInternal(uint8_t probe, uint32_t timestamp,
+                                      float temp, float pitTemp) {
     if (probe >= PREDICTOR_NUM_PROBES) return;
 
     ProbeWindow& w = _probes[probe];
 
-    w.samples[w.head].timestamp = timestamp;
-    w.samples[w.head].temp      = temp;
+    if (w.count == 0) {
+        w.fit.reset(timestamp);
+    }
+
+    // Newton pair against the previous sample (needs pit temp on both)
+    PredictorSample s;
+    s.timestamp = timestamp;
+    s.temp      = temp;
+    s.pit       = pitTemp;
+    s.u         = 0.0f;
+    s.v         = 0.0f;
+    s.hasPair   = false;
+
+    if (w.count > 0 && !isnan(pitTemp)) {
+        uint16_t prevIdx = (w.head == 0) ? (PREDICTOR_WINDOW_SIZE - 1) : (w.head - 1);
+        const PredictorSample& prev = w.samples[prevIdx];
+        int32_t dt = (int32_t)(timestamp - prev.timestamp);
+        if (dt > 0 && !isnan(prev.pit)) {
+            s.v = (temp - prev.temp) / (float)dt;
+            s.u = 0.5f * ((pitTemp - temp) + (prev.pit - prev.temp));
+            s.hasPair = true;
+        }
+    }
+
+    // Window full: the slot at head is the oldest sample, about to be
+    // overwritten -- take it out of the sums first
+    if (w.count == PREDICTOR_WINDOW_SIZE) {
+        accumulate(w, w.samples[w.head], -1);
+    }
+
+    w.samples[w.head] = s;
+    accumulate(w, s, +1);
 
     w.head++;
     if (w.head >= PREDICTOR_WINDOW_SIZE) {
@@ -124,60 +185,109 @@ void TempPredictor::addSampleInternal(uint8_t probe, uint32_t timestamp, float t
     if (w.count < PREDICTOR_WINDOW_SIZE) {
         w.count++;
     }
-}
 
-float TempPredictor::computeSlope(uint8_t probe) const {
-    if (probe >= PREDICTOR_NUM_PROBES) return 0.0f;
+    // Once per trip around a full ring, rebase on the oldest sample
+    if (w.head == 0 && w.count == PREDICTOR_WINDOW_SIZE) {
+        rebuildSums(probe);
+    }
 
-    const ProbeWindow& w = _probes[probe];
+    updateStall(probe);
+}
 
-    if (w.count < PREDICTOR_MIN_SAMPLES) {
-        return 0.0f;
+void TempPredictor::accumulate(ProbeWindow& w, const PredictorSample& s, int sign) {
+    w.fit.add(s.timestamp, s.temp, sign);
+
+    if (s.hasPair) {
+        w.pairs += sign;
+        w.sumUU += sign * (double)s.u * s.u;
+        w.sumUV += sign * (double)s.u * s.v;
+        w.sumVV += sign * (double)s.v * s.v;
     }
+}
 
-    // Least-squares linear regression over the rolling window.
-    // x = timestamp (seconds), y = temperature
-    // slope = (N * sum(x*y) - sum(x) * sum(y)) / (N * sum(x^2) - (sum(x))^2)
-    //
-    // To avoid floating-point precision issues with large epoch values,
-    // we offset x by the oldest sample's timestamp (x_i = timestamp_i - t0).
+void TempPredictor::rebuildSums(uint8_t probe) {
+    ProbeWindow& w = _probes[probe];
 
     uint16_t n = w.count;
+    uint16_t oldest = (n < PREDICTOR_WINDOW_SIZE) ? 0 : w.head;
+
+    w.fit.reset(w.samples[oldest].timestamp);
+    w.pairs = 0;
+    w.sumUU = 0.0;
+    w.sumUV = 0.0;
+    w.sumVV = 0.0;
 
-    // Find the oldest sample index in the circular buffer
-    uint16_t oldest;
-    if (n < PREDICTOR_WINDOW_SIZE) {
-        oldest = 0;  // Buffer hasn't wrapped yet
-    } else {
-        oldest = w.head;  // head points to the next write = oldest entry
+    for (uint16_t i = 0; i < n; i++) {
+        accumulate(w, w.samples[(oldest + i) % PREDICTOR_WINDOW_SIZE], +1);
     }
+}
 
-    uint32_t t0 = w.samples[oldest].timestamp;
+void TempPredictor::updateStall(uint8_t probe) {
+    ProbeWindow& w = _probes[probe];
 
-    double sumX  = 0.0;
-    double sumY  = 0.0;
-    double sumXY = 0.0;
-    double sumX2 = 0.0;
+    float k, sigma;
+    if (!computeK(probe, k, sigma)) {
+        return;  // No pit data or too few pairs -- leave stall state as is
+    }
 
-    for (uint16_t i = 0; i < n; i++) {
-        uint16_t idx = (oldest + i) % PREDICTOR_WINDOW_SIZE;
-        double x = (double)(w.samples[idx].timestamp - t0);
-        double y = (double)w.samples[idx].temp;
+    // Seed kRef from the first good fit, then track it slowly so a stall
+    // (which drags the window k down over tens of minutes) stands out
+    if (w.kRef <= 0.0f) {
+        if (k > 0.0f) w.kRef = k;
+        return;
+    }
 
-        sumX  += x;
-        sumY  += y;
-        sumXY += x * y;
-        sumX2 += x * x;
+    uint16_t latest = (w.head == 0) ? (PREDICTOR_WINDOW_SIZE - 1) : (w.head - 1);
+    const PredictorSample& s = w.samples[latest];
+    float drive = s.pit - s.temp;
+    if (isnan(drive) || drive <= 0.0f) {
+        return;  // Meat at or above pit -- Newton model says nothing here
     }
 
-    double denom = (double)n * sumX2 - sumX * sumX;
-    if (denom == 0.0) {
-        return 0.0f;  // All timestamps identical (shouldn't happen)
+    float expected = w.kRef * drive;             // deg/s if still heating normally
+    float ratio = computeSlope(probe) / expected;
+
+    if (!w.stalled) {
+        bool belowTarget = (w.target <= 0.0f) || (s.temp < w.target);
+        if (ratio < PREDICTOR_STALL_ENTER_RATIO && belowTarget) {
+            w.stalled = true;
+            w.stallStart = s.timestamp;
+        } else if (k > 0.0f) {
+            w.kRef += PREDICTOR_K_ALPHA * (k - w.kRef);
+        }
+    } else if (ratio > PREDICTOR_STALL_EXIT_RATIO) {
+        w.stalled = false;
+    }
+}
+
+bool TempPredictor::computeK(uint8_t probe, float& k, float& sigma) const {
+    const ProbeWindow& w = _probes[probe];
+
+    if (w.pairs < PREDICTOR_MIN_SAMPLES || w.sumUU <= 0.0) {
+        return false;
     }
 
-    double slope = ((double)n * sumXY - sumX * sumY) / denom;
+    // Least squares through the origin: v = k * u
+    double kd = w.sumUV / w.sumUU;
+    double sse = w.sumVV - kd * w.sumUV;
+    if (sse < 0.0) sse = 0.0;  // Rounding on a perfect fit
 
-    return (float)slope;  // degrees per second
+    k = (float)kd;
+    sigma = (float)sqrt(sse / ((double)(w.pairs - 1) * w.sumUU));
+    return true;
+}
+
+float TempPredictor::computeSlope(uint8_t probe) const {
+    if (probe >= PREDICTOR_NUM_PROBES) return 0.0f;
+
+    const ProbeWindow& w = _probes[probe];
+
+    if (w.count < PREDICTOR_MIN_SAMPLES) {
+        return 0.0f;
+    }
+
+    // Least-squares linear regression over the rolling window
+    return w.fit.slope();  // degrees per second
 }
 
 float TempPredictor::getLatestTemp(uint8_t probe) const {
@@ -191,38 +301,122 @@ float TempPredictor::getLatestTemp(uint8_t probe) const {
     return w.samples[latest].temp;
 }
 
-uint32_t TempPredictor::computeEstTime(uint8_t probe) const {
-    if (probe >= PREDICTOR_NUM_PROBES) return 0;
+PredictorEstimate TempPredictor::computeEstimate(uint8_t probe) const {
+    PredictorEstimate none = {0, 0, 0, false};
+    if (probe >= PREDICTOR_NUM_PROBES) return none;
 
     const ProbeWindow& w = _probes[probe];
+    none.stalled = w.stalled;
 
     // No target set
-    if (w.target <= 0.0f) return 0;
+    if (w.target <= 0.0f) return none;
 
     // Not enough samples
-    if (w.count < PREDICTOR_MIN_SAMPLES) return 0;
-
-    float currentTemp = getLatestTemp(probe);
+    if (w.count < PREDICTOR_MIN_SAMPLES) return none;
 
     // Already at or above target
-    if (currentTemp >= w.target) return 0;
+    if (getLatestTemp(probe) >= w.target) return none;
+
+    uint32_t epoch = getCurrentEpoch();
+    if (epoch == 0) return none;
+
+    if (_mode == PredictorMode::NEWTON) {
+        PredictorEstimate e = computeNewtonEstimate(probe, epoch);
+        if (e.est != 0) return e;
+        // Model not usable (no pit data, pit below target, ...) -- fall back
+    }
+
+    PredictorEstimate e = computeLinearEstimate(probe, epoch);
+    e.stalled = w.stalled;
+    return e;
+}
+
+PredictorEstimate TempPredictor::computeLinearEstimate(uint8_t probe, uint32_t epoch) const {
+    PredictorEstimate e = {0, 0, 0, false};
+    const ProbeWindow& w = _probes[probe];
 
     float slope = computeSlope(probe);
 
     // Temperature not rising
-    if (slope <= 0.0f) return 0;
+    if (slope <= 0.0f) return e;
 
     // Time to reach target from current temp (in seconds)
-    float deltaTemp = w.target - currentTemp;
+    float deltaTemp = w.target - getLatestTemp(probe);
     float timeToTarget = deltaTemp / slope;
 
     // Sanity check: reject predictions more than 24 hours out
-    if (timeToTarget > (float)PREDICTOR_MAX_PREDICT_SEC) return 0;
+    if (timeToTarget > (float)PREDICTOR_MAX_PREDICT_SEC) return e;
 
-    uint32_t epoch = getCurrentEpoch();
-    if (epoch == 0) return 0;
+    e.est  = epoch + (uint32_t)timeToTarget;
+    e.low  = e.est;
+    e.high = e.est;
+    return e;
+}
+
+// Seconds for Newton heating T(t) = P - (P - T0) e^(-k t) to reach target
+static float newtonTimeToTarget(float pit, float temp, float target, float k) {
+    if (k <= 0.0f) return (float)PREDICTOR_MAX_PREDICT_SEC;
+    float t = logf((pit - temp) / (pit - target)) / k;
+    if (t < 0.0f) return 0.0f;
+    if (t > (float)PREDICTOR_MAX_PREDICT_SEC) return (float)PREDICTOR_MAX_PREDICT_SEC;
+    return t;
+}
+
+PredictorEstimate TempPredictor::computeNewtonEstimate(uint8_t probe, uint32_t epoch) const {
+    PredictorEstimate e = {0, 0, 0, false};
+    const ProbeWindow& w = _probes[probe];
+
+    uint16_t latest = (w.head == 0) ? (PREDICTOR_WINDOW_SIZE - 1) : (w.head - 1);
+    float pit  = w.samples[latest].pit;
+    float temp = w.samples[latest].temp;
+
+    // Meat can only approach the pit temperature, never pass it
+    if (isnan(pit) || pit <= w.target) return e;
+
+    float k, sigma;
+    bool haveFit = computeK(probe, k, sigma);
+
+    if (w.stalled) {
+        // Piecewise: sit out the rest of a typical stall, then resume
+        // heating at the pre-stall rate constant
+        if (w.kRef <= 0.0f) return e;
+        float tHeat = newtonTimeToTarget(pit, temp, w.target, w.kRef);
+
+        int32_t inStall = (int32_t)(epoch - w.stallStart);
+        if (inStall < 0) inStall = 0;
+        int32_t remain = PREDICTOR_STALL_TYPICAL_SEC - inStall;
+        if (remain < 0) remain = 0;
+        int32_t worst = PREDICTOR_STALL_MAX_SEC - inStall;
+        if (worst < remain) worst = remain;
+
+        float estSec  = (float)remain + tHeat;
+        float highSec = (float)worst + tHeat;
+        if (estSec > (float)PREDICTOR_MAX_PREDICT_SEC) return e;
+        if (highSec > (float)PREDICTOR_MAX_PREDICT_SEC) highSec = (float)PREDICTOR_MAX_PREDICT_SEC;
+
+        e.est     = epoch + (uint32_t)estSec;
+        e.low     = epoch + (uint32_t)tHeat;        // Stall breaks right now
+        e.high    = epoch + (uint32_t)highSec;
+        e.stalled = true;
+        return e;
+    }
+
+    if (!haveFit || k <= 0.0f) {
+        if (w.kRef <= 0.0f) return e;
+        k = w.kRef;
+        sigma = 0.0f;
+    }
+
+    float tEst = newtonTimeToTarget(pit, temp, w.target, k);
+    if (tEst >= (float)PREDICTOR_MAX_PREDICT_SEC) return e;
+
+    float kHi = k + PREDICTOR_BAND_SIGMA * sigma;
+    float kLo = k - PREDICTOR_BAND_SIGMA * sigma;
 
-    return epoch + (uint32_t)timeToTarget;
+    e.est  = epoch + (uint32_t)tEst;
+    e.low  = epoch + (uint32_t)newtonTimeToTarget(pit, temp, w.target, kHi);
+    e.high = epoch + (uint32_t)newtonTimeToTarget(pit, temp, w.target, kLo);
+    return e;
 }
 
 uint32_t TempPredictor::getCurrentEpoch() const {
@@ -1,25 +1,59 @@
 #pragma once
 
 #include "config.h"
+#include "linear_fit.h"
+#include "probe_channels.h"
 #include <stdint.h>
 
 // --- Predictor Constants ---
-#define PREDICTOR_WINDOW_SIZE       60      // 60 samples * 5s = 5 minutes of data
+#ifndef PREDICTOR_WINDOW_SIZE
+#define PREDICTOR_WINDOW_SIZE       (kBuildProfile.predictorWindowSize)  // Build profile; 60 * 5 s = 5 min stock
+#endif
 #define PREDICTOR_MIN_SAMPLES       12      // Need at least 12 samples (1 min) before predicting
 #define PREDICTOR_SAMPLE_INTERVAL   5000    // 5 seconds between samples (matches SESSION_SAMPLE_INTERVAL)
 #define PREDICTOR_MAX_PREDICT_SEC   86400   // 24 hours max prediction horizon
+static_assert(PREDICTOR_MIN_SAMPLES <= PREDICTOR_WINDOW_SIZE,
+              "PREDICTOR_WINDOW_SIZE must hold PREDICTOR_MIN_SAMPLES");
+
+// --- Newton / stall model ---
+#define PREDICTOR_K_ALPHA           0.002f  // Per-sample EMA of the heating constant (~40 min time constant)
+#define PREDICTOR_STALL_ENTER_RATIO 0.25f   // Stalled when rising < 25% of the Newton-expected rate
+#define PREDICTOR_STALL_EXIT_RATIO  0.5f    // Stall over once back above 50%
+#define PREDICTOR_STALL_TYPICAL_SEC 14400   // Assume a stall lasts ~4 hours
+#define PREDICTOR_STALL_MAX_SEC     28800   // Upper band: stall may last up to 8 hours
+#define PREDICTOR_BAND_SIGMA        2.0f    // Confidence band width in std devs of the fitted k
 
-// Number of meat probes tracked by the predictor
-#define PREDICTOR_NUM_PROBES  2
+// Number of meat probes tracked by the predictor: every meat channel
+#define PREDICTOR_NUM_PROBES  NUM_MEATS
 
-// Probe indices for the predictor (meat probes only)
+// Probe indices for the predictor (meat probes only, channel - 1)
 #define PREDICTOR_MEAT1  0
 #define PREDICTOR_MEAT2  1
 
+// Which model computeEstimate() uses
+enum class PredictorMode : uint8_t {
+    LINEAR,   // Least-squares line through the window (original behaviour)
+    NEWTON    // Newton's law of heating toward the pit temp, stall-aware
+};
+
 // A single (timestamp, temperature) sample in the rolling window
 struct PredictorSample {
     uint32_t timestamp;   // Epoch seconds
     float    temp;        // Temperature in current units (F or C)
+    float    pit;         // Pit temperature at the same time (NAN = unknown)
+
+    // Newton fit pair against the previous sample: v = dT/dt, u = pit - T
+    float    u;
+    float    v;
+    bool     hasPair;
+};
+
+// Done-time estimate with confidence band (all epochs, 0 = unavailable)
+struct PredictorEstimate {
+    uint32_t est;
+    uint32_t low;       // Earliest plausible done time
+    uint32_t high;      // Latest plausible done time
+    bool     stalled;   // Probe is in a stall plateau
 };
 
 class TempPredictor {
@@ -29,34 +63,56 @@ public:
     // Initialize / reset all state. Call once from setup().
     void begin();
 
-    // Feed current meat probe temperatures. Call periodically (~every 5 seconds).
-    // Only records samples for connected probes.
-    void update(float meat1Temp, float meat2Temp, bool meat1Connected, bool meat2Connected);
+    // Feed current meat probe temperatures, PREDICTOR_NUM_PROBES of each
+    // (&temp[PROBE_MEAT1] of a channel-indexed array). Call periodically
+    // (~every 5 seconds). Only records samples for connected probes.
+    void update(const float* meatTemps, const bool* meatConnected);
+
+    // Latest pit temperature, used as the heat source by the Newton model.
+    // Call before update(); pass connected=false when the pit probe is out.
+    void setPitTemp(float pitTemp, bool connected);
+
+    // Select the prediction model (default LINEAR)
+    void setMode(PredictorMode mode) { _mode = mode; }
+    PredictorMode getMode() const { return _mode; }
 
-    // Set target temperatures for each meat probe
-    void setMeat1Target(float target);
-    void setMeat2Target(float target);
+    // Target temperature for a meat probe (0 = not set)
+    void setTarget(uint8_t probeIndex, float target);
+    float getTarget(uint8_t probeIndex) const;
 
     // Get predicted epoch (seconds) when the probe will reach its target.
     // Returns 0 if prediction is unavailable.
-    uint32_t getMeat1EstTime() const;
-    uint32_t getMeat2EstTime() const;
+    uint32_t getEstTime(uint8_t probeIndex) const;
+
+    // Seconds from now until a meat probe reaches its target, or 0 if
+    // prediction is unavailable
+    uint32_t getSecondsToTarget(uint8_t probeIndex) const;
 
     // Get rate of temperature change in degrees per minute.
     // Returns 0.0 if insufficient data.
-    float getMeat1Rate() const;
-    float getMeat2Rate() const;
+    float getRate(uint8_t probeIndex) const;
+
+    // Full estimate (ETA, confidence band, stall flag) for a meat probe
+    PredictorEstimate getEstimate(uint8_t probeIndex) const;
+
+    // Whether a meat probe is currently in a stall plateau
+    bool isStalled(uint8_t probeIndex) const;
 
-    // Clear all history for both probes
+    // Replay a recorded sample into a probe's window (warm restart from
+    // the session log). Bypasses the update() rate limit and clock.
+    void prefill(uint8_t probe, uint32_t timestamp, float temp, float pitTemp);
+
+    // Clear all history for every probe
     void reset();
 
-    // Clear history for a single probe (0 = meat1, 1 = meat2)
+    // Clear history for a single probe (0 = meat1, 1 = meat2, ...)
     void reset(uint8_t probeIndex);
 
 #ifdef NATIVE_BUILD
     // Test helpers: inject time and samples directly
     void setCurrentTime(uint32_t epoch);
     void addSample(uint8_t probe, uint32_t timestamp, float temp);
+    void addSample(uint8_t probe, uint32_t timestamp, float temp, float pitTemp);
 #endif
 
 private:
@@ -66,22 +122,53 @@ private:
         uint16_t head;        // Next write position in the circular buffer
         uint16_t count;       // Number of valid samples (up to PREDICTOR_WINDOW_SIZE)
         float    target;      // Target temperature (0 = not set)
+
+        // Running regression of temp on epoch seconds, updated as samples
+        // enter and leave the ring
+        LinearFit fit;
+
+        // Newton fit sums over sample pairs: v = k * u
+        uint16_t pairs;
+        double   sumUU;
+        double   sumUV;
+        double   sumVV;
+
+        // Stall tracking: kRef is a slow average of k, frozen during a stall
+        float    kRef;
+        bool     stalled;
+        uint32_t stallStart;
     };
 
+    // Recompute a probe's running sums from the ring, rebasing x on the
+    // oldest sample. Bounds float drift and keeps x small.
+    void rebuildSums(uint8_t probe);
+
     // Add a sample to a probe's rolling window
-    void addSampleInternal(uint8_t probe, uint32_t timestamp, float temp);
+    void addSampleInternal(uint8_t probe, uint32_t timestamp, float temp, float pitTemp);
 
-    // Compute linear regression slope (degrees per second) for a probe.
-    // Returns 0.0 if insufficient data.
+    // Add/remove a sample's contribution to the running sums
+    void accumulate(ProbeWindow& w, const PredictorSample& s, int sign);
+
+    // Update kRef and the stall state after a new sample
+    void updateStall(uint8_t probe);
+
+    // Newton heating constant (1/s) fitted over the window and its std dev.
+    // Returns false if there are not enough valid pairs.
+    bool computeK(uint8_t probe, float& k, float& sigma) const;
+
+    // Linear regression slope (degrees per second) for a probe, from the
+    // running sums in constant time. Returns 0.0 if insufficient data.
     float computeSlope(uint8_t probe) const;
 
     // Get the current temperature (latest sample) for a probe.
     // Returns 0.0 if no samples.
     float getLatestTemp(uint8_t probe) const;
 
-    // Compute the estimated arrival epoch for a probe.
-    // Returns 0 if prediction is unavailable.
-    uint32_t computeEstTime(uint8_t probe) const;
+    // Compute the estimated arrival epoch and band for a probe.
+    // est is 0 if prediction is unavailable.
+    PredictorEstimate computeEstimate(uint8_t probe) const;
+    PredictorEstimate computeLinearEstimate(uint8_t probe, uint32_t epoch) const;
+    PredictorEstimate computeNewtonEstimate(uint8_t probe, uint32_t epoch) const;
 
     // Get current epoch time in seconds
     uint32_t getCurrentEpoch() const;
@@ -91,6 +178,9 @@ private:
     // Timing for sample interval gating
     unsigned long _lastSampleMs;
 
+    PredictorMode _mode;
+    float         _pitTemp;   // NAN when the pit probe is disconnected
+
 #ifdef NATIVE_BUILD
     // Injected epoch for testing (0 means use real time)
     uint32_t _testEpoch;
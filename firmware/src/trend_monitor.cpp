@@ -0,0 +1,98 @@
+#include "trend_monitor.h"
+#include <math.h>
+#include <string.h>
+
+TrendMonitor::TrendMonitor() {
+    reset();
+}
+
+void TrendMonitor::reset() {
+    clearWindows();
+    memset(&_status, 0, sizeof(_status));
+    _lastSampleMs = 0;
+    _sampled = false;
+    _setpoint = 0.0f;
+    for (uint8_t i = 0; i < TREND_MEAT_PROBES; i++) _doneTarget[i] = 0.0f;
+}
+
+void TrendMonitor::clearWindows() {
+    _pit.clear();
+    _output.clear();
+    _outputLong.clear();
+}
+
+void TrendMonitor::update(uint32_t nowMs, const TrendInput& in) {
+    if (_sampled && nowMs - _lastSampleMs < TREND_SAMPLE_MS) return;
+    _lastSampleMs = nowMs;
+    _sampled = true;
+
+    // A window describes one setpoint with the lid shut and the pit probe
+    // in; anything else starts it over
+    if (in.lidOpen || !in.pitConnected || fabsf(in.setpoint - _setpoint) >= 0.5f) {
+        clearWindows();
+        _setpoint = in.setpoint;
+        _status.fireOut = false;
+        _status.fuelLow = false;
+    }
+    if (!in.lidOpen && in.pitConnected) {
+        uint32_t t = nowMs / 1000;
+        _pit.push(t, in.pitTemp);
+        _output.push(t, in.outputPct);
+        _outputLong.push(t, in.outputPct);
+        checkFireOut(in);
+        checkFuel(in);
+    }
+    checkDoneSoon(in);
+}
+
+// Nothing left to give and still losing heat
+void TrendMonitor::checkFireOut(const TrendInput& in) {
+    if (_pit.count() < TREND_MIN_SAMPLES) return;
+
+    float slope = getPitSlope();
+    float duty = _output.mean();
+    if (!_status.fireOut) {
+        _status.fireOut = duty >= TREND_SATURATED_PCT &&
+                          slope <= -(float)ERROR_FIREOUT_RATE &&
+                          in.pitTemp < in.setpoint;
+    } else if (duty < TREND_SATURATED_EXIT_PCT || slope >= 0.0f) {
+        _status.fireOut = false;
+    }
+}
+
+// Holding temperature, but only by feeding more and more air. Clears once
+// the output turns back down (refuelled).
+void TrendMonitor::checkFuel(const TrendInput& in) {
+    if (!_outputLong.full()) return;
+
+    float rise = getOutputSlope();
+    if (!_status.fuelLow) {
+        _status.fuelLow = fabsf(in.pitTemp - in.setpoint) <= TREND_FUEL_BAND &&
+                          _outputLong.mean() >= TREND_FUEL_DUTY_PCT &&
+                          rise >= TREND_FUEL_RISE_PCT_MIN;
+    } else if (rise < 0.0f) {
+        _status.fuelLow = false;
+    }
+}
+
+// Raised once the predicted done time is within the lead; dropped when the
+// probe reaches target (the done alarm takes over), the target changes or
+// the estimate moves well out again (a stall)
+void TrendMonitor::checkDoneSoon(const TrendInput& in) {
+    for (uint8_t i = 0; i < TREND_MEAT_PROBES; i++) {
+        float target = in.meatTarget[i];
+        uint32_t eta = in.meatEtaSec[i];
+        bool& on = _status.doneSoon[i];
+
+        if (target <= 0.0f || in.meatTemp[i] >= target || target != _doneTarget[i]) {
+            on = false;
+            _doneTarget[i] = target;
+            if (target <= 0.0f || in.meatTemp[i] >= target) continue;
+        }
+        if (!on) {
+            on = eta > 0 && eta <= TREND_DONE_SOON_SEC;
+        } else if (eta == 0 || eta > 2 * TREND_DONE_SOON_SEC) {
+            on = false;
+        }
+    }
+}
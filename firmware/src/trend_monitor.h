@@ -0,0 +1,74 @@
+#pragma once
+
+#include "config.h"
+#include "linear_fit.h"
+#include "probe_channels.h"
+#include <stdint.h>
+
+// Early warnings from the trends of the pit temperature and the PID output,
+// each a rolling least-squares fit (linear_fit.h) updated in O(1) per
+// sample:
+//
+//   fire out   output saturated over the short window (2 min) while the pit
+//              falls at ERROR_FIREOUT_RATE or faster
+//   fuel low   the pit holding near the setpoint only because the output
+//              keeps climbing over the long window (10 min)
+//   done soon  a meat probe's predicted done time is within
+//              TREND_DONE_SOON_SEC (from TempPredictor)
+//
+// The windows restart when the lid opens or the setpoint moves, so lid
+// recovery and a new setpoint aren't read as a trend.
+
+#define TREND_MEAT_PROBES NUM_MEATS   // Every meat channel, as TempPredictor tracks
+
+struct TrendInput {
+    float    pitTemp;
+    bool     pitConnected;
+    float    outputPct;                        // PID output, 0-100 (fan + damper)
+    float    setpoint;
+    bool     lidOpen;
+    float    meatTemp[TREND_MEAT_PROBES];
+    float    meatTarget[TREND_MEAT_PROBES];    // 0 = not set
+    uint32_t meatEtaSec[TREND_MEAT_PROBES];    // Seconds to target, 0 = no estimate
+};
+
+struct TrendStatus {
+    bool fireOut;
+    bool fuelLow;
+    bool doneSoon[TREND_MEAT_PROBES];
+};
+
+class TrendMonitor {
+public:
+    TrendMonitor();
+
+    // Clear the windows and every warning
+    void reset();
+
+    // Call every control tick; samples every TREND_SAMPLE_MS
+    void update(uint32_t nowMs, const TrendInput& in);
+
+    const TrendStatus& status() const { return _status; }
+
+    // Pit slope over the short window, degrees per minute
+    float getPitSlope() const { return _pit.slope() * 60.0f; }
+
+    // Output slope over the long window, percent per minute
+    float getOutputSlope() const { return _outputLong.slope() * 60.0f; }
+
+private:
+    void clearWindows();
+    void checkFireOut(const TrendInput& in);
+    void checkFuel(const TrendInput& in);
+    void checkDoneSoon(const TrendInput& in);
+
+    TrendWindow<TREND_SHORT_WINDOW> _pit;
+    TrendWindow<TREND_SHORT_WINDOW> _output;
+    TrendWindow<TREND_LONG_WINDOW>  _outputLong;
+
+    TrendStatus _status;
+    uint32_t    _lastSampleMs;
+    bool        _sampled;       // A sample has been taken (_lastSampleMs valid)
+    float       _setpoint;      // Setpoint the windows were filled under
+    float       _doneTarget[TREND_MEAT_PROBES];   // Target a done-soon warning was raised for
+};
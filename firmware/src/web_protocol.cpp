@@ -1,190 +1,461 @@
 #include "web_protocol.h"
+#include "fan_mode.h"
 #include <ArduinoJson.h>
+#include <atomic>
+#include <cstdarg>
 #include <cstdio>
-#include <cstdlib>
 #include <cstring>
 #include <cmath>
 
 namespace bbq_protocol {
 
 // ---------------------------------------------------------------------------
-// buildDataMessage — periodic data broadcast
+// Counters and the bounded writer shared by the text builders
 // ---------------------------------------------------------------------------
-// Helper: format float with 1 decimal place into a small buffer
-static void fmtTemp(char* out, size_t sz, float val) {
-    snprintf(out, sz, "%.1f", val);
+static std::atomic<uint32_t> s_frames(0);
+static std::atomic<uint32_t> s_bytes(0);
+static std::atomic<uint32_t> s_overflows(0);
+
+ProtocolStats protocolStats() {
+    ProtocolStats st;
+    st.frames    = s_frames.load(std::memory_order_relaxed);
+    st.bytes     = s_bytes.load(std::memory_order_relaxed);
+    st.overflows = s_overflows.load(std::memory_order_relaxed);
+    return st;
 }
 
-size_t buildDataMessage(char* buf, size_t bufSize, const DataPayload& d) {
-    JsonDocument doc;
-    doc["type"] = "data";
-    doc["ts"] = d.ts;
+// Count a finished build: len bytes, or 0 for an overflow
+static size_t countFrame(size_t len) {
+    if (len == 0) {
+        s_overflows.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        s_frames.fetch_add(1, std::memory_order_relaxed);
+        s_bytes.fetch_add((uint32_t)len, std::memory_order_relaxed);
+    }
+    return len;
+}
 
-    // Temperatures: NAN → null, -1 → -1 (shorted), else value with 1 decimal
-    // Use separate buffers since serialized() stores a pointer until serializeJson
-    char pitStr[16], m1Str[16], m2Str[16];
+// Appends into a fixed buffer. An overflow sticks, so builders check once
+// at the end instead of after every field.
+struct Writer {
+    char*  buf;
+    size_t size;
+    size_t pos;
+    bool   overflow;
+
+    Writer(char* b, size_t n) : buf(b), size(n), pos(0), overflow(n == 0) {}
+
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (overflow) return;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf + pos, size - pos, fmt, ap);
+        va_end(ap);
+        if (n < 0 || (size_t)n >= size - pos) { overflow = true; return; }
+        pos += n;
+    }
 
-    if (std::isnan(d.pit))    doc["pit"] = (const char*)nullptr;
-    else if (d.pit == -1.0f)  doc["pit"] = -1;
-    else { fmtTemp(pitStr, sizeof(pitStr), d.pit); doc["pit"] = serialized(pitStr); }
+    void put(char c) {
+        if (overflow || pos + 1 >= size) { overflow = true; return; }
+        buf[pos++] = c;
+        buf[pos] = '\0';
+    }
 
-    if (std::isnan(d.meat1))   doc["meat1"] = (const char*)nullptr;
-    else if (d.meat1 == -1.0f) doc["meat1"] = -1;
-    else { fmtTemp(m1Str, sizeof(m1Str), d.meat1); doc["meat1"] = serialized(m1Str); }
+    // JSON string body (no quotes): escapes quote, backslash and control chars
+    void escaped(const char* s, size_t len) {
+        for (size_t i = 0; i < len && !overflow; i++) {
+            char c = s[i];
+            switch (c) {
+                case '"':  put('\\'); put('"');  break;
+                case '\\': put('\\'); put('\\'); break;
+                case '\n': put('\\'); put('n');  break;
+                case '\r': put('\\'); put('r');  break;
+                case '\t': put('\\'); put('t');  break;
+                default:
+                    if ((uint8_t)c < 0x20) printf("\\u%04x", (unsigned)(uint8_t)c);
+                    else                   put(c);
+                    break;
+            }
+        }
+    }
 
-    if (std::isnan(d.meat2))   doc["meat2"] = (const char*)nullptr;
-    else if (d.meat2 == -1.0f) doc["meat2"] = -1;
-    else { fmtTemp(m2Str, sizeof(m2Str), d.meat2); doc["meat2"] = serialized(m2Str); }
+    // Finish: bytes written, or 0 (and an empty string) on overflow
+    size_t finish() {
+        if (overflow) {
+            if (size > 0) buf[0] = '\0';
+            return countFrame(0);
+        }
+        return countFrame(pos);
+    }
+};
 
-    doc["fan"] = (int)d.fan;
-    doc["damper"] = (int)d.damper;
-    doc["sp"] = (int)d.sp;
-    doc["lid"] = d.lid;
-    if (d.fanMode) doc["fanMode"] = d.fanMode;
+// ---------------------------------------------------------------------------
+// buildDataMessage — periodic data broadcast
+// ---------------------------------------------------------------------------
+
+// Temperature field: NAN → null, -1 → -1 (shorted), else value with 1 decimal
+static void putTemp(Writer& w, const char* key, float val) {
+    if (std::isnan(val))    w.printf(",\"%s\":null", key);
+    else if (val == -1.0f)  w.printf(",\"%s\":-1", key);
+    else                    w.printf(",\"%s\":%.1f", key, val);
+}
 
-    // Meat targets: 0 → null
-    if (d.meat1Target > 0)  doc["meat1Target"] = (int)d.meat1Target;
-    else                    doc["meat1Target"] = (const char*)nullptr;
+size_t buildDataMessage(char* buf, size_t bufSize, const DataPayload& d) {
+    Writer w(buf, bufSize);
+    w.printf("{\"type\":\"data\",\"ts\":%u,\"seq\":%u", (unsigned)d.ts, (unsigned)d.seq);
+    if (d.sampleUs != 0) w.printf(",\"sampleUs\":%u", (unsigned)d.sampleUs);
+
+    for (uint8_t c = 0; c < NUM_PROBES; c++) putTemp(w, kProbeChannels[c].key, d.temp[c]);
+
+    w.printf(",\"fan\":%d,\"damper\":%d,\"sp\":%d,\"lid\":%s",
+             (int)d.fan, (int)d.damper, (int)d.sp, d.lid ? "true" : "false");
+    if (d.fanMode) {
+        w.printf(",\"fanMode\":\"");
+        w.escaped(d.fanMode, strlen(d.fanMode));
+        w.put('"');
+    }
 
-    if (d.meat2Target > 0)  doc["meat2Target"] = (int)d.meat2Target;
-    else                    doc["meat2Target"] = (const char*)nullptr;
+    // Meat targets, "<key>Target" per meat channel: 0 → null
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        const char* key = kProbeChannels[PROBE_MEAT1 + m].key;
+        if (d.meatTarget[m] > 0) w.printf(",\"%sTarget\":%d", key, (int)d.meatTarget[m]);
+        else                     w.printf(",\"%sTarget\":null", key);
+    }
 
     // Estimated done time
-    if (d.est > 0)  doc["est"] = d.est;
-    else            doc["est"] = (const char*)nullptr;
+    if (d.est > 0) w.printf(",\"est\":%u", (unsigned)d.est);
+    else           w.printf(",\"est\":null");
+
+    if (d.est > 0 && d.estLow > 0 && d.estHigh > 0) {
+        w.printf(",\"estLow\":%u,\"estHigh\":%u", (unsigned)d.estLow, (unsigned)d.estHigh);
+    } else {
+        w.printf(",\"estLow\":null,\"estHigh\":null");
+    }
+    w.printf(",\"stall\":%s,\"tuning\":%s",
+             d.stall ? "true" : "false", d.tuning ? "true" : "false");
 
     // Errors array
-    JsonArray errors = doc["errors"].to<JsonArray>();
+    w.printf(",\"errors\":[");
     for (uint8_t i = 0; i < d.errorCount && i < 8; i++) {
-        errors.add(d.errors[i]);
+        const char* msg = d.errors[i] ? d.errors[i] : "";
+        if (i > 0) w.put(',');
+        w.put('"');
+        w.escaped(msg, strlen(msg));
+        w.put('"');
+    }
+    w.put(']');
+
+    // Control zones past zone 0, only on multi-zone units
+    if (d.zoneCount > 0) {
+        w.printf(",\"zones\":[");
+        for (uint8_t i = 0; i < d.zoneCount && i < CONTROL_ZONES_MAX - 1; i++) {
+            const ZonePayload& z = d.zones[i];
+            w.printf("%s{\"zone\":%u,\"probe\":\"%s\",\"sp\":%d,\"fan\":%d,\"damper\":%d,\"lid\":%s}",
+                     i > 0 ? "," : "", (unsigned)(i + 1),
+                     z.probe < NUM_PROBES ? kProbeChannels[z.probe].key : "",
+                     (int)z.sp, (int)z.fan, (int)z.damper, z.lid ? "true" : "false");
+        }
+        w.put(']');
     }
+    w.put('}');
 
-    return serializeJson(doc, buf, bufSize);
+    return w.finish();
 }
 
 // ---------------------------------------------------------------------------
-// buildSessionReset — server confirms new session
+// buildBinaryDelta — compact per-client data frame (see web_protocol.h)
 // ---------------------------------------------------------------------------
-size_t buildSessionReset(char* buf, size_t bufSize, float setpoint) {
-    JsonDocument doc;
-    doc["type"] = "session";
-    doc["action"] = "reset";
-    doc["sp"] = (int)setpoint;
-    return serializeJson(doc, buf, bufSize);
+static int16_t packTemp(float v) {
+    if (std::isnan(v)) return BIN_TEMP_NONE;
+    float scaled = v * 10.0f;
+    if (scaled > 32767.0f)  return 32767;
+    if (scaled < -32767.0f) return -32767;
+    return (int16_t)lroundf(scaled);
 }
 
-// ---------------------------------------------------------------------------
-// buildHistoryMessage — replay session data on connect
-//
-// Builds JSON incrementally with snprintf to avoid ArduinoJson overhead
-// for potentially hundreds of data points (~110 bytes per point).
-// ---------------------------------------------------------------------------
-char* buildHistoryMessage(const HistoryPoint* points, size_t count,
-                          float sp, float meat1Target, float meat2Target,
-                          size_t* outLen) {
-    // Estimate buffer size: envelope ~128 bytes, ~120 bytes per point
-    size_t estSize = 256 + count * 130;
-    char* buf = (char*)malloc(estSize);
-    if (!buf) {
-        if (outLen) *outLen = 0;
-        return nullptr;
+static uint8_t packFanMode(const char* mode) {
+    FanMode m;
+    return fanModeFromName(mode, m) ? (uint8_t)m : 0xFF;
+}
+
+// FNV-1a over the error strings, so a change in any of them is detected
+// without keeping copies per client
+static uint32_t hashErrors(const DataPayload& d) {
+    uint32_t h = 2166136261u;
+    for (uint8_t i = 0; i < d.errorCount && i < 8; i++) {
+        for (const char* p = d.errors[i]; p && *p; p++) {
+            h = (h ^ (uint8_t)*p) * 16777619u;
+        }
+        h = (h ^ 0xFF) * 16777619u;  // Separator
     }
+    return h;
+}
 
-    size_t pos = 0;
+static void put8(uint8_t* buf, size_t& pos, uint8_t v) { buf[pos++] = v; }
 
-    // Header
-    pos += snprintf(buf + pos, estSize - pos,
-        "{\"type\":\"history\",\"sp\":%d", (int)sp);
+static void put16(uint8_t* buf, size_t& pos, uint16_t v) {
+    buf[pos++] = (uint8_t)(v & 0xFF);
+    buf[pos++] = (uint8_t)(v >> 8);
+}
 
-    if (meat1Target > 0)
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat1Target\":%d", (int)meat1Target);
-    else
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat1Target\":null");
+static void put32(uint8_t* buf, size_t& pos, uint32_t v) {
+    for (uint8_t i = 0; i < 4; i++) buf[pos++] = (uint8_t)(v >> (8 * i));
+}
 
-    if (meat2Target > 0)
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat2Target\":%d", (int)meat2Target);
-    else
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat2Target\":null");
+void resetBinaryState(BinaryDeltaState& state) {
+    memset(&state, 0, sizeof(state));
+    state.valid = false;
+}
 
-    pos += snprintf(buf + pos, estSize - pos, ",\"data\":[");
+size_t buildBinaryDelta(uint8_t* buf, size_t bufSize, const DataPayload& d,
+                        BinaryDeltaState& state, bool keyframe) {
+    if (bufSize < BIN_MAX_FRAME) return countFrame(0);
+
+    BinaryDeltaState cur;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) cur.temp[c] = packTemp(d.temp[c]);
+    cur.fan         = d.fan;
+    cur.damper      = d.damper;
+    cur.sp          = (int16_t)d.sp;
+    cur.flags       = (d.lid ? 0x01 : 0) | (d.stall ? 0x02 : 0) | (d.tuning ? 0x04 : 0);
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        cur.meatTarget[m] = d.meatTarget[m] > 0 ? (int16_t)d.meatTarget[m] : 0;
+    }
+    cur.est         = d.est;
+    cur.estLow      = d.est > 0 ? d.estLow : 0;
+    cur.estHigh     = d.est > 0 ? d.estHigh : 0;
+    cur.fanMode     = packFanMode(d.fanMode);
+    cur.errorHash   = hashErrors(d);
+    cur.zoneCount   = d.zoneCount < CONTROL_ZONES_MAX - 1 ? d.zoneCount : CONTROL_ZONES_MAX - 1;
+    cur.seq         = d.seq;
+    cur.sampleUs    = d.sampleUs;
+    memset(cur.zones, 0, sizeof(cur.zones));
+    for (uint8_t i = 0; i < cur.zoneCount; i++) {
+        const ZonePayload& z = d.zones[i];
+        uint8_t* p = cur.zones + i * BIN_ZONE_BYTES;
+        int16_t sp = (int16_t)z.sp;
+        p[0] = z.probe;
+        p[1] = (uint8_t)(sp & 0xFF);
+        p[2] = (uint8_t)((uint16_t)sp >> 8);
+        p[3] = z.fan;
+        p[4] = z.damper;
+        p[5] = z.lid ? 0x01 : 0;
+    }
 
-    // Data points
-    for (size_t i = 0; i < count; i++) {
-        const HistoryPoint& p = points[i];
-        if (i > 0) buf[pos++] = ',';
+    bool all = keyframe || !state.valid;
+    uint16_t mask = 0;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        if (!all && cur.temp[c] == state.temp[c]) continue;
+        mask |= c < 3 ? (uint16_t)(BF_PIT << c) : (uint16_t)BF_PROBES;
+    }
+    if (all || cur.fan != state.fan)         mask |= BF_FAN;
+    if (all || cur.damper != state.damper)   mask |= BF_DAMPER;
+    if (all || cur.sp != state.sp)           mask |= BF_SP;
+    if (all || cur.flags != state.flags)     mask |= BF_FLAGS;
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        if (!all && cur.meatTarget[m] == state.meatTarget[m]) continue;
+        mask |= m < 2 ? (uint16_t)BF_TARGETS : (uint16_t)BF_PROBES;
+    }
+    if (all || cur.est != state.est)         mask |= BF_EST;
+    if (all || cur.estLow != state.estLow ||
+               cur.estHigh != state.estHigh) mask |= BF_EST_BAND;
+    if (all || cur.fanMode != state.fanMode) mask |= BF_FAN_MODE;
+    if (all || cur.errorHash != state.errorHash) mask |= BF_ERRORS;
+    if (cur.zoneCount != state.zoneCount ||
+        memcmp(cur.zones, state.zones, sizeof(cur.zones)) != 0 ||
+        (all && cur.zoneCount > 0))            mask |= BF_ZONES;
+    if (all || cur.seq != state.seq)         mask |= BF_SEQ;
+    if (cur.sampleUs != 0 &&
+        (all || cur.sampleUs != state.sampleUs)) mask |= BF_SAMPLE;
 
-        // Ensure buffer space (realloc if needed)
-        if (pos + 200 > estSize) {
-            estSize *= 2;
-            char* newBuf = (char*)realloc(buf, estSize);
-            if (!newBuf) { free(buf); if (outLen) *outLen = 0; return nullptr; }
-            buf = newBuf;
+    size_t pos = 0;
+    put8(buf, pos, BIN_FRAME_DATA);
+    put16(buf, pos, mask);
+    put32(buf, pos, d.ts);
+
+    for (uint8_t c = 0; c < 3; c++) {
+        if (mask & (BF_PIT << c)) put16(buf, pos, (uint16_t)cur.temp[c]);
+    }
+    if (mask & BF_FAN)      put8(buf, pos, cur.fan);
+    if (mask & BF_DAMPER)   put8(buf, pos, cur.damper);
+    if (mask & BF_SP)       put16(buf, pos, (uint16_t)cur.sp);
+    if (mask & BF_FLAGS)    put8(buf, pos, cur.flags);
+    if (mask & BF_TARGETS) {
+        put16(buf, pos, (uint16_t)cur.meatTarget[0]);
+        put16(buf, pos, (uint16_t)cur.meatTarget[1]);
+    }
+    if (mask & BF_EST)      put32(buf, pos, cur.est);
+    if (mask & BF_EST_BAND) {
+        put32(buf, pos, cur.estLow);
+        put32(buf, pos, cur.estHigh);
+    }
+    if (mask & BF_FAN_MODE) put8(buf, pos, cur.fanMode);
+    if (mask & BF_ERRORS) {
+        uint8_t count = d.errorCount < 8 ? d.errorCount : 8;
+        put8(buf, pos, count);
+        for (uint8_t i = 0; i < count; i++) {
+            const char* msg = d.errors[i] ? d.errors[i] : "";
+            size_t len = strlen(msg);
+            if (len > 48) len = 48;
+            put8(buf, pos, (uint8_t)len);
+            memcpy(buf + pos, msg, len);
+            pos += len;
         }
+    }
+    if (mask & BF_PROBES) {
+        put8(buf, pos, (uint8_t)(NUM_PROBES - 3));
+        for (uint8_t c = 3; c < NUM_PROBES; c++) put16(buf, pos, (uint16_t)cur.temp[c]);
+        for (uint8_t m = 2; m < NUM_MEATS; m++) put16(buf, pos, (uint16_t)cur.meatTarget[m]);
+    }
+    if (mask & BF_ZONES) {
+        put8(buf, pos, cur.zoneCount);
+        memcpy(buf + pos, cur.zones, cur.zoneCount * BIN_ZONE_BYTES);
+        pos += cur.zoneCount * BIN_ZONE_BYTES;
+    }
+    if (mask & BF_SEQ)      put32(buf, pos, cur.seq);
+    if (mask & BF_SAMPLE)   put32(buf, pos, cur.sampleUs);
 
-        pos += snprintf(buf + pos, estSize - pos, "{\"ts\":%u", (unsigned)p.ts);
+    cur.valid = true;
+    state = cur;
+    return countFrame(pos);
+}
 
-        // Temperatures: NAN → null
-        if (std::isnan(p.pit))   pos += snprintf(buf + pos, estSize - pos, ",\"pit\":null");
-        else                     pos += snprintf(buf + pos, estSize - pos, ",\"pit\":%.1f", p.pit);
+// ---------------------------------------------------------------------------
+// buildSessionReset — server confirms new session
+// ---------------------------------------------------------------------------
+size_t buildSessionReset(char* buf, size_t bufSize, float setpoint) {
+    Writer w(buf, bufSize);
+    w.printf("{\"type\":\"session\",\"action\":\"reset\",\"sp\":%d}", (int)setpoint);
+    return w.finish();
+}
 
-        if (std::isnan(p.meat1)) pos += snprintf(buf + pos, estSize - pos, ",\"meat1\":null");
-        else                     pos += snprintf(buf + pos, estSize - pos, ",\"meat1\":%.1f", p.meat1);
+// ---------------------------------------------------------------------------
+// buildPong — reply to a client's latency ping
+// ---------------------------------------------------------------------------
+size_t buildPong(char* buf, size_t bufSize, uint32_t pingT, uint32_t nowUs) {
+    Writer w(buf, bufSize);
+    w.printf("{\"type\":\"pong\",\"t\":%u,\"us\":%u}", (unsigned)pingT, (unsigned)nowUs);
+    return w.finish();
+}
+
+// ---------------------------------------------------------------------------
+// History helpers — shared by the one-shot and chunked history builders.
+// Both return the new write position, or 0 if the point didn't fit.
+// ---------------------------------------------------------------------------
+static size_t appendTargets(char* buf, size_t size, size_t pos,
+                            float sp, const float* meatTargets) {
+    int n = snprintf(buf + pos, size - pos, ",\"sp\":%d", (int)sp);
+    if (n < 0 || (size_t)n >= size - pos) return 0;
+    pos += n;
+
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        const char* key = kProbeChannels[PROBE_MEAT1 + m].key;
+        float target = meatTargets[m];
+        if (target > 0) n = snprintf(buf + pos, size - pos, ",\"%sTarget\":%d", key, (int)target);
+        else            n = snprintf(buf + pos, size - pos, ",\"%sTarget\":null", key);
+        if (n < 0 || (size_t)n >= size - pos) return 0;
+        pos += n;
+    }
+    return pos;
+}
 
-        if (std::isnan(p.meat2)) pos += snprintf(buf + pos, estSize - pos, ",\"meat2\":null");
-        else                     pos += snprintf(buf + pos, estSize - pos, ",\"meat2\":%.1f", p.meat2);
+static size_t appendHistoryPoint(char* buf, size_t size, size_t pos, const HistoryPoint& p) {
+    if (size - pos < HISTORY_POINT_MAX_BYTES) return 0;
 
-        pos += snprintf(buf + pos, estSize - pos,
-            ",\"fan\":%u,\"damper\":%u,\"sp\":%d,\"lid\":%s}",
-            (unsigned)p.fan, (unsigned)p.damper, (int)p.sp,
-            p.lid ? "true" : "false");
+    pos += snprintf(buf + pos, size - pos, "{\"ts\":%u", (unsigned)p.ts);
+
+    // Temperatures: NAN → null
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        const char* key = kProbeChannels[c].key;
+        if (std::isnan(p.temp[c])) pos += snprintf(buf + pos, size - pos, ",\"%s\":null", key);
+        else                       pos += snprintf(buf + pos, size - pos, ",\"%s\":%.1f", key, p.temp[c]);
     }
 
-    pos += snprintf(buf + pos, estSize - pos, "]}");
+    pos += snprintf(buf + pos, size - pos,
+        ",\"fan\":%u,\"damper\":%u,\"sp\":%d,\"lid\":%s}",
+        (unsigned)p.fan, (unsigned)p.damper, (int)p.sp,
+        p.lid ? "true" : "false");
+    return pos;
+}
+
+// ---------------------------------------------------------------------------
+// buildHistoryMessage — replay session data on connect
+//
+// Builds JSON incrementally with snprintf to avoid ArduinoJson overhead
+// for potentially hundreds of data points (~110 bytes per point).
+// ---------------------------------------------------------------------------
+size_t buildHistoryMessage(char* buf, size_t bufSize,
+                           const HistoryPoint* points, size_t count,
+                           float sp, const float* meatTargets) {
+    int n = snprintf(buf, bufSize, "{\"type\":\"history\"");
+    if (n < 0 || (size_t)n >= bufSize) return countFrame(0);
+    size_t pos = appendTargets(buf, bufSize, n, sp, meatTargets);
+    if (pos == 0 || bufSize - pos < 16) return countFrame(0);
+    pos += snprintf(buf + pos, bufSize - pos, ",\"data\":[");
+
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) buf[pos++] = ',';
+        pos = appendHistoryPoint(buf, bufSize, pos, points[i]);
+        if (pos == 0) return countFrame(0);
+    }
 
-    if (outLen) *outLen = pos;
-    return buf;
+    if (bufSize - pos < 3) return countFrame(0);
+    buf[pos++] = ']';
+    buf[pos++] = '}';
+    buf[pos] = '\0';
+    return countFrame(pos);
 }
 
 // ---------------------------------------------------------------------------
-// buildCSVDownloadEnvelope — wrap CSV data in JSON for WebSocket delivery
+// buildHistoryChunk — one bounded piece of a chunked history replay
 // ---------------------------------------------------------------------------
-char* buildCSVDownloadEnvelope(const char* csvData, size_t csvLen, size_t* outLen) {
-    // Worst case: every char needs escaping (unlikely), plus envelope
-    size_t estSize = 128 + csvLen * 2;
-    char* buf = (char*)malloc(estSize);
-    if (!buf) {
-        if (outLen) *outLen = 0;
-        return nullptr;
+size_t buildHistoryChunk(char* buf, size_t bufSize, uint16_t chunkIndex, bool final,
+                         const HistoryReplay& replay,
+                         float sp, const float* meatTargets,
+                         const HistoryPoint* points, size_t count) {
+    int n = snprintf(buf, bufSize, "{\"type\":\"history\",\"chunk\":%u,\"final\":%s",
+                     (unsigned)chunkIndex, final ? "true" : "false");
+    if (n < 0 || (size_t)n >= bufSize) return countFrame(0);
+    size_t pos = n;
+
+    // Session, setpoint and targets only once, with the first chunk
+    if (chunkIndex == 0) {
+        n = snprintf(buf + pos, bufSize - pos, ",\"session\":%u%s",
+                     (unsigned)replay.session, replay.resume ? ",\"resume\":true" : "");
+        if (n < 0 || (size_t)n >= bufSize - pos) return countFrame(0);
+        pos = appendTargets(buf, bufSize, pos + n, sp, meatTargets);
+        if (pos == 0) return countFrame(0);
+    }
+    if (final) {
+        n = snprintf(buf + pos, bufSize - pos, ",\"next\":%u", (unsigned)replay.next);
+        if (n < 0 || (size_t)n >= bufSize - pos) return countFrame(0);
+        pos += n;
     }
 
-    size_t pos = 0;
-    pos += snprintf(buf + pos, estSize - pos,
-        "{\"type\":\"session\",\"action\":\"download\",\"format\":\"csv\",\"data\":\"");
-
-    // Escape the CSV data for JSON string
-    for (size_t i = 0; i < csvLen; i++) {
-        if (pos + 10 > estSize) {
-            estSize *= 2;
-            char* newBuf = (char*)realloc(buf, estSize);
-            if (!newBuf) { free(buf); if (outLen) *outLen = 0; return nullptr; }
-            buf = newBuf;
-        }
+    if (bufSize - pos < 16) return countFrame(0);
+    pos += snprintf(buf + pos, bufSize - pos, ",\"data\":[");
 
-        char c = csvData[i];
-        switch (c) {
-            case '"':  buf[pos++] = '\\'; buf[pos++] = '"';  break;
-            case '\\': buf[pos++] = '\\'; buf[pos++] = '\\'; break;
-            case '\n': buf[pos++] = '\\'; buf[pos++] = 'n';  break;
-            case '\r': buf[pos++] = '\\'; buf[pos++] = 'r';  break;
-            case '\t': buf[pos++] = '\\'; buf[pos++] = 't';  break;
-            default:   buf[pos++] = c;                        break;
-        }
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) buf[pos++] = ',';
+        pos = appendHistoryPoint(buf, bufSize, pos, points[i]);
+        if (pos == 0) return countFrame(0);
     }
 
-    pos += snprintf(buf + pos, estSize - pos, "\"}");
+    if (bufSize - pos < 3) return countFrame(0);
+    buf[pos++] = ']';
+    buf[pos++] = '}';
+    buf[pos] = '\0';
+    return countFrame(pos);
+}
 
-    if (outLen) *outLen = pos;
-    return buf;
+// ---------------------------------------------------------------------------
+// buildDownloadPointer — point a WebSocket download at the HTTP export
+// ---------------------------------------------------------------------------
+size_t buildDownloadPointer(char* buf, size_t bufSize, const char* format) {
+    const char* fmt = format && strcmp(format, "json") == 0 ? "json" : "csv";
+    Writer w(buf, bufSize);
+    w.printf("{\"type\":\"session\",\"action\":\"download\",\"format\":\"%s\","
+             "\"url\":\"/api/session.%s\"}", fmt, fmt);
+    return w.finish();
 }
 
 // ---------------------------------------------------------------------------
@@ -204,24 +475,24 @@ ParsedCommand parseCommand(const char* data, size_t len) {
     if (strcmp(type, "set") == 0) {
         cmd.type = CmdType::SET_SP;
         cmd.setpoint = doc["sp"].as<float>();
+        cmd.zone = doc["zone"] | 0;
     }
     else if (strcmp(type, "alarm") == 0) {
         cmd.type = CmdType::ALARM;
 
-        if (doc["meat1Target"].is<float>()) {
-            cmd.hasMeat1Target = true;
-            cmd.meat1Target = doc["meat1Target"].as<float>();
-        } else if (doc["meat1Target"].isNull()) {
-            cmd.hasMeat1Target = true;
-            cmd.meat1Target = 0;
-        }
-
-        if (doc["meat2Target"].is<float>()) {
-            cmd.hasMeat2Target = true;
-            cmd.meat2Target = doc["meat2Target"].as<float>();
-        } else if (doc["meat2Target"].isNull()) {
-            cmd.hasMeat2Target = true;
-            cmd.meat2Target = 0;
+        // "<key>Target" per meat channel: a number sets it, null clears
+        // it, and a channel that isn't mentioned keeps its target
+        for (uint8_t m = 0; m < NUM_MEATS; m++) {
+            char key[16];
+            snprintf(key, sizeof(key), "%sTarget", kProbeChannels[PROBE_MEAT1 + m].key);
+            JsonVariantConst v = doc[key];
+            if (v.is<float>()) {
+                cmd.meatTarget[m] = v.as<float>();
+                cmd.meatTargetMask |= (uint8_t)(1u << m);
+            } else if (!v.isUnbound() && v.isNull()) {
+                cmd.meatTarget[m] = 0;
+                cmd.meatTargetMask |= (uint8_t)(1u << m);
+            }
         }
 
         if (doc["pitBand"].is<float>()) {
@@ -237,6 +508,35 @@ ParsedCommand parseCommand(const char* data, size_t len) {
             cmd.fanMode[sizeof(cmd.fanMode) - 1] = '\0';
         }
     }
+    else if (strcmp(type, "hello") == 0) {
+        cmd.type = CmdType::HELLO;
+        cmd.wantsBinary = doc["binary"] | false;
+        cmd.historyPoints = doc["points"] | 0;
+        cmd.historySession = doc["session"] | 0;
+        cmd.historySince = doc["since"] | 0;
+    }
+    else if (strcmp(type, "rate") == 0) {
+        cmd.type = CmdType::SET_RATE;
+        cmd.rateMs = doc["interval"] | 0;
+    }
+    else if (strcmp(type, "ping") == 0) {
+        cmd.type = CmdType::PING;
+        cmd.pingT = doc["t"] | 0;
+        // Latencies arrive in milliseconds; negatives are clock-estimate noise
+        for (JsonVariantConst v : doc["lat"].as<JsonArrayConst>()) {
+            if (cmd.latencyCount >= PING_LATENCY_MAX) break;
+            float ms = v | -1.0f;
+            if (!(ms >= 0.0f) || ms > 4.0e6f) continue;
+            cmd.latencyUs[cmd.latencyCount++] = (uint32_t)(ms * 1000.0f);
+        }
+    }
+    else if (strcmp(type, "autotune") == 0) {
+        const char* action = doc["action"] | "";
+        if (strcmp(action, "start") == 0 || strcmp(action, "cancel") == 0) {
+            cmd.type = CmdType::AUTOTUNE;
+            cmd.autoTuneStart = strcmp(action, "start") == 0;
+        }
+    }
     else if (strcmp(type, "session") == 0) {
         const char* action = doc["action"] | "";
         if (strcmp(action, "new") == 0) {
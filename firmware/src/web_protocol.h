@@ -3,51 +3,221 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "probe_channels.h"
+
 namespace bbq_protocol {
 
+// A control zone past zone 0 (control_zone.h); zone 0 is the payload's own
+// sp/fan/damper/lid
+struct ZonePayload {
+    uint8_t probe;                  // Probe channel; its temperature is in temp[]
+    float sp;
+    uint8_t fan, damper;
+    bool lid;
+};
+
 // Data for building a periodic data message
 struct DataPayload {
     uint32_t ts;
-    float pit, meat1, meat2;       // NAN = disconnected, -1 = shorted
+    uint32_t sampleUs;              // Device clock (metricsNowUs() low 32 bits) when the pit reading was taken; 0 = unknown
+    uint32_t seq;                   // Session points recorded so far: where a history resume starts
+    float temp[NUM_PROBES];        // By probe channel; NAN = disconnected, -1 = shorted
     uint8_t fan, damper;
     float sp;
     bool lid;
-    float meat1Target, meat2Target; // 0 = not set
-    uint32_t est;                   // 0 = not available
+    float meatTarget[NUM_MEATS];    // By meat probe (channel - 1), 0 = not set
+    uint32_t est;                   // Latest of the meat probes, 0 = not available
+    uint32_t estLow, estHigh;       // Confidence band around est (0 = not available)
+    bool stall;                     // A meat probe is in a stall plateau
+    bool tuning;                    // PID auto-tune in progress
     const char* fanMode;            // "fan_only", "fan_and_damper", "damper_primary"
     const char* errors[8];
     uint8_t errorCount;
+    ZonePayload zones[CONTROL_ZONES_MAX - 1];
+    uint8_t zoneCount;              // Zones in use past zone 0
 };
 
 // Single point for history replay
 struct HistoryPoint {
     uint32_t ts;
-    float pit, meat1, meat2;       // NAN = disconnected
+    float temp[NUM_PROBES];        // By probe channel; NAN = disconnected
     uint8_t fan, damper;
     float sp;
     bool lid;
 };
 
+// ---------------------------------------------------------------------------
+// Binary delta frames
+//
+// A client opts in by sending {"type":"hello","binary":true}. From then on
+// its periodic data arrives as little-endian binary frames instead of JSON:
+//
+//   u8  frame type (BIN_FRAME_DATA)
+//   u16 field mask (BinField bits) -- only these fields follow
+//   u32 ts                         -- always present
+//   ...fields in bit order
+//
+// Temperatures use the DataPoint packing (int16, degrees x10) with
+// BIN_TEMP_NONE for disconnected and -10 for shorted. Channels past meat2
+// travel together in BF_PROBES, temperatures and targets, control zones past
+// zone 0 in BF_ZONES. A frame with an empty mask is a heartbeat carrying
+// only ts.
+// ---------------------------------------------------------------------------
+#define BIN_FRAME_DATA   0x01
+#define BIN_TEMP_NONE    INT16_MIN
+#define BIN_ZONE_BYTES   6
+#define BIN_MAX_FRAME    (7 + 6 + 2 + 2 + 1 + 4 + 4 + 8 + 1 + 1 + 8 * 49 + \
+                          1 + 4 * (PROBE_MAX - 3) + \
+                          1 + BIN_ZONE_BYTES * (CONTROL_ZONES_MAX - 1) + 4 + 4)   // Keyframe with 8 max-length errors
+
+enum BinField : uint16_t {
+    BF_PIT      = 1 << 0,    // int16 x10
+    BF_MEAT1    = 1 << 1,    // int16 x10
+    BF_MEAT2    = 1 << 2,    // int16 x10
+    BF_FAN      = 1 << 3,    // u8 %
+    BF_DAMPER   = 1 << 4,    // u8 %
+    BF_SP       = 1 << 5,    // int16 whole degrees
+    BF_FLAGS    = 1 << 6,    // u8: bit0 lid, bit1 stall, bit2 tuning
+    BF_TARGETS  = 1 << 7,    // int16 meat1Target, int16 meat2Target (0 = none)
+    BF_EST      = 1 << 8,    // u32 est (0 = none)
+    BF_EST_BAND = 1 << 9,    // u32 estLow, u32 estHigh
+    BF_FAN_MODE = 1 << 10,   // u8: 0 fan_only, 1 fan_and_damper, 2 damper_primary
+    BF_ERRORS   = 1 << 11,   // u8 count, then per error: u8 len + bytes
+    BF_PROBES   = 1 << 12,   // u8 count, then int16 x10 per channel from 3, then int16 target per channel from 3 (PROBE_CHANNELS > 3)
+    BF_ZONES    = 1 << 13,   // u8 count, then per zone past 0: u8 probe, int16 sp, u8 fan, u8 damper, u8 flags (bit0 lid)
+    BF_SEQ      = 1 << 14,   // u32 session points recorded (DataPayload::seq)
+    BF_SAMPLE   = 1 << 15    // u32 DataPayload::sampleUs
+};
+
+// Last values sent to one client, so the next frame can carry only changes
+struct BinaryDeltaState {
+    bool     valid;          // false = next frame is a full keyframe
+    int16_t  temp[NUM_PROBES];
+    uint8_t  fan, damper;
+    int16_t  sp;
+    uint8_t  flags;
+    int16_t  meatTarget[NUM_MEATS];
+    uint32_t est, estLow, estHigh;
+    uint8_t  fanMode;
+    uint32_t errorHash;
+    uint8_t  zoneCount;
+    uint8_t  zones[BIN_ZONE_BYTES * (CONTROL_ZONES_MAX - 1)];   // Packed as sent
+    uint32_t seq;
+    uint32_t sampleUs;
+};
+
+// Force the next frame built from this state to be a keyframe
+void resetBinaryState(BinaryDeltaState& state);
+
+// Build a delta frame against `state` and update it. keyframe=true sends
+// every field regardless. Returns bytes written, 0 if buf is too small.
+size_t buildBinaryDelta(uint8_t* buf, size_t bufSize, const DataPayload& d,
+                        BinaryDeltaState& state, bool keyframe);
+
 // Parsed incoming command
-enum class CmdType { SET_SP, ALARM, SESSION_NEW, SESSION_DOWNLOAD, SET_FAN_MODE, UNKNOWN };
+enum class CmdType { SET_SP, ALARM, SESSION_NEW, SESSION_DOWNLOAD, SET_FAN_MODE, HELLO, AUTOTUNE, SET_RATE, PING, UNKNOWN };
+
+// Sample-to-paint latencies a client can report in one ping
+#define PING_LATENCY_MAX 16
+
 struct ParsedCommand {
     CmdType type;
     float setpoint;
-    float meat1Target, meat2Target, pitBand;
-    bool hasMeat1Target, hasMeat2Target, hasPitBand;
+    uint8_t zone;           // SET_SP: control zone (0 = the pit)
+    float meatTarget[NUM_MEATS];   // ALARM: by meat probe (channel - 1), 0 = clear
+    uint8_t meatTargetMask;         // ALARM: bit m set when meatTarget[m] was given
+    float pitBand;
+    bool hasPitBand;
     char format[8]; // "csv" or "json"
     char fanMode[20]; // "fan_only", "fan_and_damper", "damper_primary"
+    bool wantsBinary; // HELLO: client accepts binary delta frames
+    uint16_t historyPoints; // HELLO: chart width in points for history LOD (0 = unspecified)
+    uint32_t historySession; // HELLO: session (start time) the client already holds history of, 0 = none
+    uint32_t historySince;   // HELLO: first point it's missing (the last seq it saw)
+    bool autoTuneStart;     // AUTOTUNE: true = start, false = cancel
+    uint32_t rateMs;        // SET_RATE: requested data interval (0 = default)
+    uint32_t pingT;         // PING: client's send time, echoed in the pong
+    uint32_t latencyUs[PING_LATENCY_MAX]; // PING: sample-to-paint latencies since the last ping
+    uint8_t latencyCount;
 };
 
-// Returns bytes written to buf (excluding null terminator)
+// ---------------------------------------------------------------------------
+// Message builders
+//
+// Every builder writes into a caller-owned buffer and returns the bytes
+// written (excluding the null terminator), or 0 if the message didn't fit.
+// None of them touch the heap, so with reusable buffers on the caller's
+// side steady-state broadcasting allocates nothing. The *_MAX_BYTES /
+// *MaxBytes() bounds size those buffers.
+// ---------------------------------------------------------------------------
+
+#define DATA_MESSAGE_MAX_BYTES   (1320 + 40 * (NUM_PROBES - 3) + 80 * (CONTROL_ZONES_MAX - 1))   // Data message with 8 max-length errors
+#define SESSION_RESET_MAX_BYTES  64
+#define PONG_MAX_BYTES           64
+
 size_t buildDataMessage(char* buf, size_t bufSize, const DataPayload& d);
 size_t buildSessionReset(char* buf, size_t bufSize, float setpoint);
 
-// Dynamic allocation — caller must free() returned pointer
-char* buildHistoryMessage(const HistoryPoint* points, size_t count,
-                          float sp, float meat1Target, float meat2Target,
-                          size_t* outLen);
-char* buildCSVDownloadEnvelope(const char* csvData, size_t csvLen, size_t* outLen);
+// Reply to a ping: {"type":"pong","t":<echoed>,"us":<device clock>}. nowUs
+// is on the same clock as DataPayload::sampleUs, so the client can put the
+// two on its own clock (see docs/web-development.md).
+size_t buildPong(char* buf, size_t bufSize, uint32_t pingT, uint32_t nowUs);
+
+// Worst-case bytes for one point in a history message
+#define HISTORY_POINT_MAX_BYTES (92 + 16 * NUM_PROBES)
+
+// Worst-case bytes for a history message around its points
+#define HISTORY_HEADER_MAX_BYTES (192 + 24 * (NUM_MEATS - 2))
+
+// Buffer size that always fits a one-shot history message of count points
+inline size_t historyMessageMaxBytes(size_t count) {
+    return HISTORY_HEADER_MAX_BYTES + count * HISTORY_POINT_MAX_BYTES;
+}
+
+// One-shot history replay: {"type":"history","sp":..,"meat1Target":..,...,"data":[...]}
+// with a "<key>Target" per meat channel. meatTargets holds NUM_MEATS (0 = not set).
+size_t buildHistoryMessage(char* buf, size_t bufSize,
+                           const HistoryPoint* points, size_t count,
+                           float sp, const float* meatTargets);
+
+// Where a chunked replay sits in the cook. session is the session's start
+// time, next the seq a client that got the whole replay resumes from.
+// resume = the replay is only the tail after the client's hello `since`,
+// to be appended to the history it already holds.
+struct HistoryReplay {
+    uint32_t session;
+    uint32_t next;
+    bool     resume;
+};
+
+// Build one chunk of a chunked history replay into a caller-owned buffer:
+//   chunk 0: {"type":"history","chunk":0,"final":..,"session":..,["resume":true,]
+//             "sp":..,"meat1Target":..,...,"data":[...]}   ("<key>Target" per meat channel)
+//   chunk n: {"type":"history","chunk":n,"final":..,"data":[...]}
+// The final chunk also carries "next". Size buf as historyMessageMaxBytes(count).
+// Returns 0 if it doesn't fit.
+size_t buildHistoryChunk(char* buf, size_t bufSize, uint16_t chunkIndex, bool final,
+                         const HistoryReplay& replay,
+                         float sp, const float* meatTargets,
+                         const HistoryPoint* points, size_t count);
+
+// Reply to a WebSocket download request: where to fetch the export, which
+// is streamed over HTTP rather than built in memory. format is "json" or
+// anything else for CSV.
+//   {"type":"session","action":"download","format":"csv","url":"/api/session.csv"}
+#define DOWNLOAD_POINTER_MAX_BYTES 96
+size_t buildDownloadPointer(char* buf, size_t bufSize, const char* format);
+
+// Builder counters since boot. frames/bytes count messages built;
+// overflows count builds that returned 0 because the buffer was too small.
+// Updated from whichever task builds, so they're relaxed atomics.
+struct ProtocolStats {
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t overflows;
+};
+
+ProtocolStats protocolStats();
 
 // Parse an incoming JSON command
 ParsedCommand parseCommand(const char* data, size_t len);
@@ -4,15 +4,103 @@
 #include <Arduino.h>
 #include <time.h>
 #include <cmath>
+#include <memory>
 
-#include "temp_manager.h"
-#include "pid_controller.h"
-#include "fan_controller.h"
-#include "servo_controller.h"
-#include "config_manager.h"
 #include "cook_session.h"
-#include "alarm_manager.h"
-#include "error_manager.h"
+#include "ext_ram.h"
+#if BBQ_FEATURE_HUB
+#include "hub_manager.h"
+#endif
+#include "metrics.h"
+#include "loop_profiler.h"
+#include <WiFi.h>
+#endif
+
+#ifndef NATIVE_BUILD
+// Serves the assets listed in WEB_ASSET_MANIFEST with strong ETags. The
+// image stores them as name.gz, which AsyncFileResponse sends with
+// Content-Encoding: gzip. A request carrying ?v=<etag> (how index.html and
+// sw.js reference them) may be cached as immutable; anything else must
+// revalidate, and a matching If-None-Match gets 304 without touching flash.
+// Files not in the manifest fall through to serveStatic().
+class WebAssetHandler : public AsyncWebHandler {
+public:
+    WebAssetHandler() : _count(0) {}
+
+    // Read the manifest. Returns the number of assets (0 if there is none,
+    // e.g. an image built without web_assets.py).
+    uint8_t load(const char* path) {
+        File f = LittleFS.open(path, "r");
+        if (!f) return 0;
+        while (f.available() && _count < WEB_ASSET_MAX) {
+            String line = f.readStringUntil('\n');
+            int sp = line.indexOf(' ');
+            if (sp <= 0 || sp >= WEB_ASSET_PATH_LEN) continue;
+            String etag = line.substring(sp + 1);
+            etag.trim();
+            if (etag.length() == 0 || etag.length() > WEB_ASSET_ETAG_LEN) continue;
+            Asset& a = _assets[_count++];
+            strlcpy(a.path, line.c_str(), sp + 1);
+            strlcpy(a.etag, etag.c_str(), sizeof(a.etag));
+        }
+        f.close();
+        return _count;
+    }
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (request->method() != HTTP_GET || !find(request->url())) return false;
+        request->addInterestingHeader("If-None-Match");
+        return true;
+    }
+
+    void handleRequest(AsyncWebServerRequest* request) override {
+        const Asset* a = find(request->url());
+        if (!a) {
+            request->send(404);
+            return;
+        }
+
+        char etag[WEB_ASSET_ETAG_LEN + 3];
+        snprintf(etag, sizeof(etag), "\"%s\"", a->etag);
+        AsyncWebParameter* v = request->getParam("v");
+        bool versioned = v && v->value() == a->etag;
+
+        AsyncWebHeader* match = request->getHeader("If-None-Match");
+        AsyncWebServerResponse* response;
+        if (match && match->value().indexOf(etag) >= 0) {
+            response = request->beginResponse(304);
+        } else {
+            response = request->beginResponse(LittleFS, a->path, String());
+        }
+        response->addHeader("ETag", etag);
+        if (versioned) {
+            char cache[48];
+            snprintf(cache, sizeof(cache), "public, max-age=%u, immutable",
+                     (unsigned)WEB_ASSET_MAX_AGE);
+            response->addHeader("Cache-Control", cache);
+        } else {
+            response->addHeader("Cache-Control", "no-cache");
+        }
+        request->send(response);
+    }
+
+private:
+    struct Asset {
+        char path[WEB_ASSET_PATH_LEN];
+        char etag[WEB_ASSET_ETAG_LEN + 1];
+    };
+
+    const Asset* find(const String& url) const {
+        const char* path = url == "/" ? "/index.html" : url.c_str();
+        for (uint8_t i = 0; i < _count; i++) {
+            if (strcmp(_assets[i].path, path) == 0) return &_assets[i];
+        }
+        return nullptr;
+    }
+
+    Asset   _assets[WEB_ASSET_MAX];
+    uint8_t _count;
+};
 #endif
 
 BBQWebServer::BBQWebServer()
@@ -20,24 +108,35 @@ BBQWebServer::BBQWebServer()
 #ifndef NATIVE_BUILD
       _server(nullptr)
     , _ws(nullptr)
+    , _events(nullptr)
     ,
 #endif
-      _temp(nullptr)
-    , _pid(nullptr)
-    , _fan(nullptr)
-    , _servo(nullptr)
-    , _config(nullptr)
-    , _session(nullptr)
-    , _alarm(nullptr)
-    , _error(nullptr)
-    , _setpoint(225.0f)
-    , _estimatedTime(0)
+      _session(nullptr)
+    , _telemetry(nullptr)
+    , _hub(nullptr)
     , _lastBroadcastMs(0)
+    , _broadcastPending(false)
+    , _broadcastAfter(0)
+    , _binaryClients(0)
+    , _deltaSeq(0)
+    , _sinceKeyframe(0)
+    , _inFlight(0)
+    , _framesSkipped(0)
+    , _broadcastUs(0)
+    , _broadcastUsMax(0)
     , _onSetpoint(nullptr)
     , _onAlarm(nullptr)
     , _onSession(nullptr)
     , _onFanMode(nullptr)
+    , _onAutoTune(nullptr)
+    , _onCalibrate(nullptr)
 {
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        _clients[i].id = 0;
+        _clients[i].binary = false;
+        _clients[i].history.active = false;
+    }
+    bbq_protocol::resetBinaryState(_delta);
 }
 
 void BBQWebServer::begin() {
@@ -53,6 +152,23 @@ void BBQWebServer::begin() {
 
     _server->addHandler(_ws);
 
+    // Read-only event stream: the same JSON data frames as the WebSocket,
+    // as "data" events. Viewers past SSE_MAX_CLIENTS skip this handler and
+    // get the 503 route below.
+    _events = new AsyncEventSource(SSE_PATH);
+    _events->setFilter([this](AsyncWebServerRequest* request) {
+        return _events->count() < SSE_MAX_CLIENTS;
+    });
+    _events->onConnect([this](AsyncEventSourceClient* client) {
+        StateFrame f = _state.read();
+        if (f.len > 0) client->send(f.json, "data", f.version, WS_SEND_INTERVAL * 2);
+        Serial.printf("[WEB] Event stream viewer connected (%u)\n", (unsigned)_events->count());
+    });
+    _server->addHandler(_events);
+    _server->on(SSE_PATH, HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(503, "text/plain", "Too many stream viewers");
+    });
+
     // Version API endpoint
     _server->on("/api/version", HTTP_GET, [](AsyncWebServerRequest* request) {
         char json[128];
@@ -61,8 +177,61 @@ void BBQWebServer::begin() {
         request->send(200, "application/json", json);
     });
 
-    // Serve static files from LittleFS (web UI)
+    // Session export, streamed so long cooks never exist as one buffer
+    _server->on("/api/session.csv", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleExport(request, ExportFormat::CSV);
+    });
+    _server->on("/api/session.json", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleExport(request, ExportFormat::JSON);
+    });
+
+    // Past cooks kept in the archive
+    _server->on("/api/sessions", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleSessionList(request);
+    });
+
+    // Current data frame, for pollers that don't want a socket
+    _server->on("/api/state", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleState(request);
+    });
+
+    // Probe calibration: GET for status, POST ?action=start|capture|apply|cancel
+    _server->on("/api/calibrate", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleCalibrate(request, "status");
+    });
+    _server->on("/api/calibrate", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        AsyncWebParameter* p = request->getParam("action");
+        handleCalibrate(request, p ? p->value().c_str() : "");
+    });
+
+    // Prometheus scrape target
+    _server->on("/metrics", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleMetrics(request);
+    });
+
+#if BBQ_FEATURE_HUB
+    // Hub mode: merged state of this unit and its peers, and a peer's trend
+    _server->on("/api/hub/history", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleHubHistory(request);
+    });
+    _server->on("/api/hub", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleHub(request);
+    });
+#endif
+
+    // Builder counters and heap, to confirm broadcasting doesn't allocate
+    _server->on("/api/stats", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleStats(request);
+    });
+
+    // Web UI: gzipped, ETagged assets first, anything else from LittleFS as is
+    WebAssetHandler* assets = new WebAssetHandler();
+    uint8_t assetCount = assets->load(WEB_ASSET_MANIFEST);
+    _server->addHandler(assets);
     _server->serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
+    if (assetCount == 0) {
+        Serial.println("[WEB] No asset manifest, serving web UI without ETags");
+    }
 
     // Fallback 404
     _server->onNotFound([](AsyncWebServerRequest* request) {
@@ -76,22 +245,301 @@ void BBQWebServer::begin() {
 #endif
 }
 
+#ifndef NATIVE_BUILD
+void BBQWebServer::handleExport(AsyncWebServerRequest* request, ExportFormat format) {
+    if (!_session) {
+        request->send(503, "text/plain", "Session unavailable");
+        return;
+    }
+
+    // The cursor lives as long as the response: the filler lambda owns it
+    std::shared_ptr<ExportCursor> cursor = std::make_shared<ExportCursor>();
+    _session->beginExport(*cursor, format);
+
+    CookSession* session = _session;
+    bool csv = format == ExportFormat::CSV;
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        csv ? "text/csv" : "application/json",
+        [session, cursor](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return session->exportChunk(*cursor, (char*)buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition",
+                        csv ? "attachment; filename=\"cook-session.csv\""
+                            : "attachment; filename=\"cook-session.json\"");
+    request->send(response);
+
+    Serial.printf("[WEB] Streaming %s export (%u points)\n",
+                  csv ? "CSV" : "JSON", _session->getTotalPointCount());
+}
+#endif
+
+#ifndef NATIVE_BUILD
+void BBQWebServer::handleStats(AsyncWebServerRequest* request) {
+    bbq_protocol::ProtocolStats st = bbq_protocol::protocolStats();
+    char json[384];
+    snprintf(json, sizeof(json),
+             "{\"protocol\":{\"frames\":%u,\"bytes\":%u,\"overflows\":%u},"
+             "\"ws\":{\"clients\":%u,\"inFlight\":%u,\"skipped\":%u,"
+             "\"broadcastUs\":%u,\"broadcastUsMax\":%u},"
+             "\"heap\":{\"free\":%u,\"minFree\":%u,\"largest\":%u,\"psramFree\":%u}}",
+             (unsigned)st.frames, (unsigned)st.bytes, (unsigned)st.overflows,
+             (unsigned)getClientCount(), (unsigned)_inFlight, (unsigned)_framesSkipped,
+             (unsigned)_broadcastUs, (unsigned)_broadcastUsMax,
+             (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap(),
+             (unsigned)ESP.getMaxAllocHeap(), (unsigned)ESP.getFreePsram());
+    request->send(200, "application/json", json);
+}
+#endif
+
+#ifndef NATIVE_BUILD
+void BBQWebServer::handleCalibrate(AsyncWebServerRequest* request, const char* action) {
+    if (!_onCalibrate) {
+        request->send(503, "text/plain", "Calibration unavailable");
+        return;
+    }
+    AsyncWebParameter* probe = request->getParam("probe");
+    AsyncWebParameter* ref = request->getParam("ref");
+    char json[320];
+    bool ok = _onCalibrate(action,
+                           probe ? (uint8_t)probe->value().toInt() : 0,
+                           ref ? ref->value().toFloat() : NAN,
+                           json, sizeof(json));
+    request->send(ok ? 200 : 409, "application/json", json);
+}
+#endif
+
+#ifndef NATIVE_BUILD
+static void metricsToStream(const char* text, size_t len, void* ctx) {
+    static_cast<AsyncResponseStream*>(ctx)->write((const uint8_t*)text, len);
+}
+
+void BBQWebServer::handleMetrics(AsyncWebServerRequest* request) {
+    AsyncResponseStream* out = request->beginResponseStream("text/plain; version=0.0.4");
+    MetricsOut sink = metricsToStream;
+
+    metricsWrite(sink, out);
+
+    char labels[48];
+    snprintf(labels, sizeof(labels), "version=\"%s\"", FIRMWARE_VERSION);
+    metricsGauge(sink, out, "pitclaw_build_info", "Firmware version", 1, labels);
+    metricsGauge(sink, out, "pitclaw_uptime_seconds", "Seconds since boot", millis() / 1000.0);
+
+    metricsGauge(sink, out, "pitclaw_heap_free_bytes", "Free internal heap", ESP.getFreeHeap());
+    metricsGauge(sink, out, "pitclaw_heap_min_free_bytes", "Lowest free heap since boot",
+                 ESP.getMinFreeHeap());
+    metricsGauge(sink, out, "pitclaw_heap_largest_free_bytes", "Largest allocatable heap block",
+                 ESP.getMaxAllocHeap());
+    metricsGauge(sink, out, "pitclaw_psram_free_bytes", "Free PSRAM", ESP.getFreePsram());
+    metricsGauge(sink, out, "pitclaw_psram_size_bytes", "Total PSRAM", ESP.getPsramSize());
+
+    if (WiFi.status() == WL_CONNECTED) {
+        metricsGauge(sink, out, "pitclaw_wifi_rssi_dbm", "Station RSSI", WiFi.RSSI());
+    }
+
+    bbq_protocol::ProtocolStats st = bbq_protocol::protocolStats();
+    metricsCounter(sink, out, "pitclaw_protocol_frames_total", "Protocol messages built", st.frames);
+    metricsCounter(sink, out, "pitclaw_protocol_bytes_total", "Protocol bytes built", st.bytes);
+    metricsCounter(sink, out, "pitclaw_protocol_overflows_total",
+                   "Protocol messages dropped for not fitting their buffer", st.overflows);
+    metricsCounter(sink, out, "pitclaw_ws_skipped_total",
+                   "Data frames skipped for slow WebSocket clients", _framesSkipped);
+
+    metricsGauge(sink, out, "pitclaw_ws_clients", "Connected WebSocket clients", getClientCount());
+    metricsGauge(sink, out, "pitclaw_sse_clients", "Connected event-stream viewers",
+                 _events ? _events->count() : 0);
+    metricsGauge(sink, out, "pitclaw_ws_in_flight_bytes",
+                 "Unacked bytes across WebSocket clients at the last send pass", _inFlight);
+
+    // Per-client send backlog: TCP data not yet acked, and whether the
+    // socket's own message queue is full
+    bool first = true;
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        const ClientSlot& slot = _clients[i];
+        if (slot.id == 0) continue;
+        AsyncWebSocketClient* client = _ws->client(slot.id);
+        if (!client || !client->client()) continue;
+        size_t space = client->client()->space();
+        snprintf(labels, sizeof(labels), "client=\"%u\"", (unsigned)slot.id);
+        metricsGauge(sink, out, "pitclaw_ws_client_unacked_bytes",
+                     first ? "Bytes sent to the client and not yet acked" : nullptr,
+                     slot.sendWindow > space ? slot.sendWindow - space : 0, labels);
+        first = false;
+    }
+    first = true;
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        const ClientSlot& slot = _clients[i];
+        if (slot.id == 0) continue;
+        AsyncWebSocketClient* client = _ws->client(slot.id);
+        if (!client) continue;
+        snprintf(labels, sizeof(labels), "client=\"%u\"", (unsigned)slot.id);
+        metricsGauge(sink, out, "pitclaw_ws_client_queue_full",
+                     first ? "1 while the client's message queue is full" : nullptr,
+                     client->queueIsFull() ? 1 : 0, labels);
+        first = false;
+    }
+
+    // Loop profiler, one series per field over the phases
+    LoopPhaseStats phases[(uint8_t)LoopPhase::COUNT];
+    for (uint8_t i = 0; i < (uint8_t)LoopPhase::COUNT; i++) {
+        phases[i] = loopProfilerRead((LoopPhase)i);
+    }
+    for (uint8_t field = 0; field < 5; field++) {
+        for (uint8_t i = 0; i < (uint8_t)LoopPhase::COUNT; i++) {
+            const LoopPhaseStats& p = phases[i];
+            snprintf(labels, sizeof(labels), "phase=\"%s\"", loopPhaseName((LoopPhase)i));
+            bool head = i == 0;
+            switch (field) {
+                case 0: metricsGauge(sink, out, "pitclaw_loop_phase_p99_seconds",
+                                     head ? "Phase p99 over the last profiler window" : nullptr,
+                                     p.p99Us / 1e6, labels); break;
+                case 1: metricsGauge(sink, out, "pitclaw_loop_phase_max_seconds",
+                                     head ? "Phase max over the last profiler window" : nullptr,
+                                     p.maxUs / 1e6, labels); break;
+                case 2: metricsGauge(sink, out, "pitclaw_loop_phase_budget_seconds",
+                                     head ? "Phase time budget" : nullptr,
+                                     p.budgetUs / 1e6, labels); break;
+                case 3: metricsGauge(sink, out, "pitclaw_loop_phase_overrun",
+                                     head ? "1 while the phase p99 is over budget" : nullptr,
+                                     p.flagged ? 1 : 0, labels); break;
+                case 4: metricsCounter(sink, out, "pitclaw_loop_phase_over_budget_total",
+                                       head ? "Phase passes over budget" : nullptr,
+                                       p.overBudget, labels); break;
+            }
+        }
+    }
+
+    request->send(out);
+}
+
+#if BBQ_FEATURE_HUB
+void BBQWebServer::handleHub(AsyncWebServerRequest* request) {
+    if (!_hub || !_hub->enabled()) {
+        request->send(404, "text/plain", "Hub mode is off");
+        return;
+    }
+    StateFrame f = _state.read();
+    AsyncResponseStream* out = request->beginResponseStream("application/json");
+    out->addHeader("Cache-Control", "no-store");
+    _hub->writeState(metricsToStream, out, f.json, f.len);
+    request->send(out);
+}
+
+void BBQWebServer::handleHubHistory(AsyncWebServerRequest* request) {
+    if (!_hub || !_hub->enabled()) {
+        request->send(404, "text/plain", "Hub mode is off");
+        return;
+    }
+    AsyncWebParameter* id = request->getParam("id");
+    AsyncWebParameter* since = request->getParam("since");
+    if (!id) {
+        request->send(400, "text/plain", "Missing id");
+        return;
+    }
+    AsyncResponseStream* out = request->beginResponseStream("application/json");
+    out->addHeader("Cache-Control", "no-store");
+    if (!_hub->writeHistory(metricsToStream, out, id->value().toInt(),
+                            since ? (uint32_t)since->value().toInt() : 0)) {
+        delete out;
+        request->send(404, "text/plain", "No such peer");
+        return;
+    }
+    request->send(out);
+}
+#endif
+
+void BBQWebServer::handleState(AsyncWebServerRequest* request) {
+    StateFrame f = _state.read();
+    if (f.len == 0) {
+        request->send(503, "text/plain", "No data yet");
+        return;
+    }
+    // Copied into the response: the frame is on this stack
+    AsyncWebServerResponse* response = request->beginResponse(200, "application/json", f.json);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+#endif
+
+#ifndef NATIVE_BUILD
+// Peak as degrees with one decimal, or null if the probe never reported
+static void printPeak(AsyncResponseStream* out, int16_t peak) {
+    if (peak == SESSION_PEAK_NONE) {
+        out->print("null");
+    } else {
+        out->printf("%.1f", peak / 10.0f);
+    }
+}
+
+void BBQWebServer::handleSessionList(AsyncWebServerRequest* request) {
+    if (!_session) {
+        request->send(503, "text/plain", "Session unavailable");
+        return;
+    }
+
+    // Newest first, which is how the list is shown
+    const SessionArchiveIndex& archive = _session->getArchive();
+    AsyncResponseStream* out = request->beginResponseStream("application/json");
+    out->print("[");
+    for (int i = archive.count() - 1; i >= 0; i--) {
+        const SessionArchiveEntry& e = archive.entry(i);
+        out->printf("%s{\"id\":%u,\"startTime\":%u,\"duration\":%u,\"points\":%u,\"bytes\":%u,",
+                    i == archive.count() - 1 ? "" : ",",
+                    (unsigned)e.id, (unsigned)e.startTime, (unsigned)e.durationSec,
+                    (unsigned)e.points, (unsigned)e.bytes);
+        out->print("\"peakPit\":");   printPeak(out, e.peak[ROLLUP_PIT]);
+        out->print(",\"peakMeat1\":"); printPeak(out, e.peak[ROLLUP_MEAT1]);
+        out->print(",\"peakMeat2\":"); printPeak(out, e.peak[ROLLUP_MEAT2]);
+        for (uint8_t c = 3; c < NUM_PROBES; c++) {
+            out->printf(",\"peakMeat%u\":", (unsigned)c);
+            printPeak(out, e.peak[c]);
+        }
+        out->print("}");
+    }
+    out->print("]");
+    request->send(out);
+}
+#endif
+
 void BBQWebServer::update() {
 #ifndef NATIVE_BUILD
+    MetricTimer timer(Metric::WEB_UPDATE);
     unsigned long now = millis();
 
-    // Periodic broadcast to all connected clients
-    if (now - _lastBroadcastMs >= WS_SEND_INTERVAL) {
+    // Connects, hellos and disconnects since the last pass, before anything
+    // walks the client table
+    drainClientEvents();
+
+    // Periodic broadcast to all connected clients, or an early one once
+    // the snapshot reflects a command that asked for it
+    bool early = _broadcastPending && _telemetry &&
+                 _telemetry->version() != _broadcastAfter;
+    if (early || now - _lastBroadcastMs >= WS_SEND_INTERVAL) {
         _lastBroadcastMs = now;
+        _broadcastPending = false;
+
+        if (_ws && _telemetry) {
+            // Serialised once per tick, whoever is listening: WebSocket
+            // JSON clients, the event stream and /api/state share it
+            uint32_t version = _telemetry->version();
+            TelemetrySnapshot t = _telemetry->read();
+            bbq_protocol::DataPayload payload = buildDataPayload(t);
+            size_t jsonLen = bbq_protocol::buildDataMessage(_loopJson, sizeof(_loopJson), payload);
+            if (jsonLen > 0) publishState(version, jsonLen);
 
-        if (_ws && _ws->count() > 0) {
-            bbq_protocol::DataPayload payload = buildDataPayload();
-            char buf[512];
-            size_t len = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
-            _ws->textAll(buf, len);
+            if (_ws->count() > 0) broadcastPayload(payload, jsonLen, early);
+
+            // The event source queues per viewer; skip a tick rather than
+            // let a stalled viewer's queue grow
+            if (jsonLen > 0 && _events->count() > 0 &&
+                _events->avgPacketsWaiting() < SSE_MAX_BACKLOG) {
+                _events->send(_loopJson, "data", version);
+            }
         }
     }
 
+    // Continue any chunked history replays
+    pumpHistory();
+
     // Clean up disconnected clients
     if (_ws) {
         _ws->cleanupClients(WS_MAX_CLIENTS);
@@ -99,30 +547,327 @@ void BBQWebServer::update() {
 #endif
 }
 
-void BBQWebServer::setModules(TempManager* temp, PidController* pid, FanController* fan,
-                            ServoController* servo, ConfigManager* config, CookSession* session,
-                            AlarmManager* alarm, ErrorManager* error) {
-    _temp   = temp;
-    _pid    = pid;
-    _fan    = fan;
-    _servo  = servo;
-    _config = config;
-    _session = session;
-    _alarm  = alarm;
-    _error  = error;
+void BBQWebServer::publishState(uint32_t version, size_t len) {
+    // Loop task only; static so the 1.3 KB frame isn't on its stack
+    static StateFrame f;
+    f.version = version;
+    f.len = (uint16_t)len;
+    memcpy(f.json, _loopJson, len + 1);
+    _state.write(f);
+}
+
+void BBQWebServer::setModules(CookSession* session, const TelemetryChannel* telemetry) {
+    _session   = session;
+    _telemetry = telemetry;
 }
 
 void BBQWebServer::broadcastNow() {
+    // The command that triggered this was applied under the control lock,
+    // so any snapshot published after now already reflects it. update()
+    // sends from the loop task; broadcasting here would race it.
+    if (!_telemetry) return;
+    _broadcastAfter = _telemetry->version();
+    _broadcastPending = true;
+}
+
+#ifndef NATIVE_BUILD
+// Wrap a built frame in a socket message buffer that any number of clients
+// can queue. The buffer is freed by _cleanBuffers() once unlocked and sent
+// to all of them.
+static AsyncWebSocketMessageBuffer* shareFrame(AsyncWebSocket* ws, AsyncWebSocketMessageBuffer*& msg,
+                                               const void* data, size_t len) {
+    if (!msg) {
+        msg = ws->makeBuffer((uint8_t*)data, len);
+        if (msg && !msg->get()) msg = nullptr;   // Out of heap; left for _cleanBuffers()
+        if (msg) msg->lock();
+    }
+    return msg;
+}
+#endif
+
+void BBQWebServer::broadcastPayload(const bbq_protocol::DataPayload& payload, size_t jsonLen,
+                                    bool early) {
+#ifndef NATIVE_BUILD
+    unsigned long now = millis();
+    uint32_t startUs = micros();
+
+    measureInFlight();
+
+    // At most three frames per pass, each serialised once: JSON, the next
+    // delta of the shared binary stream (for clients that got its previous
+    // frame) and a keyframe (for new clients, ones that missed a frame to
+    // back-pressure and ones on a slower cadence). The shared stream
+    // advances every pass so a delta is always against the last frame.
+    size_t deltaLen = 0, keyLen = 0;   // Keyframe built lazily
+    AsyncWebSocketMessageBuffer* jsonMsg  = nullptr;
+    AsyncWebSocketMessageBuffer* deltaMsg = nullptr;
+    AsyncWebSocketMessageBuffer* keyMsg   = nullptr;
+    uint32_t prevSeq = _deltaSeq;
+    bool deltaIsKey = false;
+    bool sent = false;
+    if (_binaryClients > 0) {
+        deltaIsKey = !_delta.valid || ++_sinceKeyframe >= WS_BINARY_KEYFRAME_EVERY;
+        if (deltaIsKey) _sinceKeyframe = 0;
+        deltaLen = bbq_protocol::buildBinaryDelta(_loopBinary, sizeof(_loopBinary), payload,
+                                                  _delta, deltaIsKey);
+        _deltaSeq++;
+    }
+
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        ClientSlot& slot = _clients[i];
+        if (slot.id == 0) continue;
+        if (slot.history.active) continue;   // Don't interleave data with history chunks
+        AsyncWebSocketClient* client = _ws->client(slot.id);
+        if (!client) continue;
+
+        // Due at the client's own cadence? Half a tick of slack so a 10 s
+        // interval on 1.5 s ticks doesn't slip a whole tick each time.
+        if (!early && now - slot.lastSentMs + WS_SEND_INTERVAL / 2 < slot.intervalMs) continue;
+
+        if (!slot.binary) {
+            if (jsonLen == 0 || !canSendNow(client, jsonLen)) continue;
+            if (!shareFrame(_ws, jsonMsg, _loopJson, jsonLen)) continue;
+            client->text(jsonMsg);
+            _inFlight += jsonLen;
+        } else if (deltaLen > 0 && (deltaIsKey || (prevSeq != 0 && slot.deltaSeq == prevSeq))) {
+            if (!canSendNow(client, deltaLen)) continue;
+            if (!shareFrame(_ws, deltaMsg, _loopBinary, deltaLen)) continue;
+            client->binary(deltaMsg);
+            _inFlight += deltaLen;
+            slot.deltaSeq = _deltaSeq;
+        } else {
+            if (keyLen == 0) {
+                bbq_protocol::BinaryDeltaState fresh;
+                bbq_protocol::resetBinaryState(fresh);
+                keyLen = bbq_protocol::buildBinaryDelta(_loopKey, sizeof(_loopKey), payload,
+                                                        fresh, true);
+            }
+            if (keyLen == 0 || !canSendNow(client, keyLen)) continue;
+            if (!shareFrame(_ws, keyMsg, _loopKey, keyLen)) continue;
+            client->binary(keyMsg);
+            _inFlight += keyLen;
+            slot.deltaSeq = _deltaSeq;
+        }
+        slot.lastSentMs = now;
+        sent = true;
+    }
+
+    // How old the reading was when it went out: the device's share of the
+    // sample-to-paint latency clients report
+    if (sent && payload.sampleUs != 0) {
+        metricObserve(Metric::SAMPLE_TO_SEND, (uint32_t)metricsNowUs() - payload.sampleUs);
+    }
+
+    if (jsonMsg)  jsonMsg->unlock();
+    if (deltaMsg) deltaMsg->unlock();
+    if (keyMsg)   keyMsg->unlock();
+    _ws->_cleanBuffers();   // Frees this pass's unused and earlier passes' sent buffers
+
+    _broadcastUs = micros() - startUs;
+    if (_broadcastUs > _broadcastUsMax) _broadcastUsMax = _broadcastUs;
+#endif
+}
+
+#ifndef NATIVE_BUILD
+void BBQWebServer::measureInFlight() {
+    _inFlight = 0;
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (_clients[i].id == 0) continue;
+        AsyncWebSocketClient* client = _ws->client(_clients[i].id);
+        if (client) _inFlight += unackedBytes(_clients[i], client);
+    }
+}
+
+size_t BBQWebServer::unackedBytes(ClientSlot& slot, AsyncWebSocketClient* client) {
+    AsyncClient* tcp = client->client();
+    if (!tcp) return 0;
+    size_t space = tcp->space();
+    if (space > slot.sendWindow) slot.sendWindow = space;
+    return slot.sendWindow - space;
+}
+
+bool BBQWebServer::canSendNow(AsyncWebSocketClient* client, size_t bytes) {
+    // A frame that fits the TCP window goes straight out, so the socket's
+    // message queue never builds up behind a slow client. One that doesn't
+    // is skipped rather than queued: the next frame carries the latest
+    // values anyway, and a binary client's delta state is left untouched.
+    AsyncClient* tcp = client->client();
+    if (client->queueIsFull() || !tcp || tcp->space() < bytes ||
+        _inFlight + bytes > WS_QUEUE_BUDGET) {
+        _framesSkipped++;
+        return false;
+    }
+    return true;
+}
+#endif
+
+BBQWebServer::ClientSlot* BBQWebServer::findSlot(uint32_t clientId) {
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (_clients[i].id == clientId) return &_clients[i];
+    }
+    return nullptr;
+}
+
+BBQWebServer::ClientSlot* BBQWebServer::allocSlot(uint32_t clientId) {
+    ClientSlot* slot = findSlot(0);
+    if (!slot) {
+        // Table full: cleanupClients() is about to drop the oldest client
+        // (lowest id) to make room, so hand its slot to the newcomer now
+        slot = &_clients[0];
+        for (uint8_t i = 1; i < WS_MAX_CLIENTS; i++) {
+            if (_clients[i].id < slot->id) slot = &_clients[i];
+        }
+        if (slot->binary) _binaryClients--;
+    }
+    slot->id = clientId;
+    slot->binary = false;
+    slot->deltaSeq = 0;
+    slot->history.active = false;
+    slot->history.level = 0;
+    slot->history.resume = false;
+    slot->historyMaxPoints = WS_HISTORY_MAX_POINTS;
+    slot->historyHoldMs = 0;
+    slot->intervalMs = WS_SEND_INTERVAL;
+    slot->sendWindow = 0;
+    slot->lastSentMs = 0;
+    return slot;
+}
+
+void BBQWebServer::freeSlot(ClientSlot& slot) {
+    if (slot.binary) _binaryClients--;
+    slot.id = 0;
+    slot.binary = false;
+    slot.history.active = false;
+}
+
+bool BBQWebServer::postClientEvent(const ClientEvent& e) {
+    if (_clientEvents.push(e)) return true;
 #ifndef NATIVE_BUILD
-    if (_ws && _ws->count() > 0) {
-        bbq_protocol::DataPayload payload = buildDataPayload();
-        char buf[512];
-        size_t len = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
-        _ws->textAll(buf, len);
+    Serial.printf("[WS] Client event queue full, dropped event %u for client %u\n",
+                  (unsigned)e.kind, (unsigned)e.clientId);
+#endif
+    return false;
+}
+
+bool BBQWebServer::postClientEvent(ClientEvent::Kind kind, uint32_t clientId, uint32_t value) {
+    ClientEvent e;
+    memset(&e, 0, sizeof(e));
+    e.kind = kind;
+    e.clientId = clientId;
+    e.value = value;
+    return postClientEvent(e);
+}
+
+void BBQWebServer::drainClientEvents() {
+#ifndef NATIVE_BUILD
+    if (!_ws) return;
+
+    ClientEvent e;
+    while (_clientEvents.pop(e)) {
+        switch (e.kind) {
+            case ClientEvent::CONNECT:
+                applyConnect(e.clientId);
+                break;
+            case ClientEvent::DISCONNECT:
+                if (ClientSlot* slot = findSlot(e.clientId)) freeSlot(*slot);
+                break;
+            case ClientEvent::HELLO:
+                applyHello(e);
+                break;
+            case ClientEvent::SET_RATE:
+                applyRate(e.clientId, e.value);
+                break;
+            case ClientEvent::SESSION_NEW:
+                // Replays in flight belong to the old session
+                for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) _clients[i].history.active = false;
+                break;
+        }
+    }
+
+    // A disconnect dropped on a full queue still frees its slot here
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (_clients[i].id != 0 && !_ws->client(_clients[i].id)) freeSlot(_clients[i]);
     }
 #endif
 }
 
+void BBQWebServer::applyConnect(uint32_t clientId) {
+#ifndef NATIVE_BUILD
+    if (!_ws->client(clientId)) return;   // Gone before update() got to it
+
+    ClientSlot* slot = allocSlot(clientId);
+    // Send history if session has data, otherwise send current snapshot.
+    // The replay holds for the hello, which may ask for just the tail.
+    if (_session && _session->getPointCount() > 0) {
+        sendHistory(clientId);
+        slot->historyHoldMs = (millis() + WS_HELLO_WAIT_MS) | 1;
+    } else if (_telemetry) {
+        TelemetrySnapshot t = _telemetry->read();
+        bbq_protocol::DataPayload payload = buildDataPayload(t);
+        size_t n = bbq_protocol::buildDataMessage(_loopJson, sizeof(_loopJson), payload);
+        if (n > 0) _ws->text(clientId, _loopJson, n);
+    }
+#endif
+}
+
+void BBQWebServer::applyHello(const ClientEvent& e) {
+#ifndef NATIVE_BUILD
+    ClientSlot* slot = findSlot(e.clientId);
+    if (slot && slot->binary != e.wantsBinary) {
+        slot->binary = e.wantsBinary;
+        slot->deltaSeq = 0;   // Next frame is a keyframe
+        if (slot->binary) _binaryClients++;
+        else              _binaryClients--;
+    }
+    Serial.printf("[WS] Client %u negotiated %s frames\n", (unsigned)e.clientId,
+                  slot && slot->binary ? "binary" : "JSON");
+
+    if (!slot) return;
+    bool held = slot->historyHoldMs != 0;
+    slot->historyHoldMs = 0;
+    uint32_t total = _session ? _session->getTotalPointCount() : 0;
+    uint32_t since = e.value;
+
+    // A client that still holds this session from before a reconnect only
+    // needs the points it missed, unless a full replay has already started
+    // resetting its chart
+    if (total > 0 && e.historySession != 0 &&
+        !(slot->history.active && slot->history.chunk > 0) &&
+        e.historySession == _session->getStartTime() &&
+        since <= total && total - since <= WS_RESUME_MAX_POINTS) {
+        if (e.historyPoints > 0) slot->historyMaxPoints = e.historyPoints;
+        resumeHistory(*slot, since);
+        Serial.printf("[WS] Client %u resumes history at %u of %u\n",
+                      (unsigned)e.clientId, (unsigned)since, (unsigned)total);
+        return;
+    }
+
+    // Re-pick the history LOD for the client's chart width. The replay
+    // restarts at chunk 0, which resets the client's chart; one still held
+    // for the hello hasn't sent anything yet.
+    if (e.historyPoints > 0 && e.historyPoints != slot->historyMaxPoints) {
+        slot->historyMaxPoints = e.historyPoints;
+        if (total > 0 && (held || _session->selectLevel(e.historyPoints) != slot->history.level)) {
+            sendHistory(e.clientId);
+        }
+    }
+#endif
+}
+
+void BBQWebServer::applyRate(uint32_t clientId, uint32_t rateMs) {
+#ifndef NATIVE_BUILD
+    ClientSlot* slot = findSlot(clientId);
+    if (!slot) return;
+    uint32_t ms = rateMs == 0 ? WS_SEND_INTERVAL : rateMs;
+    if (ms < WS_SEND_INTERVAL) ms = WS_SEND_INTERVAL;
+    if (ms > WS_RATE_MAX_MS)   ms = WS_RATE_MAX_MS;
+    // Speeding up (tab visible again): send on the next tick
+    if (ms < slot->intervalMs) slot->lastSentMs = millis() - ms;
+    slot->intervalMs = (uint16_t)ms;
+    Serial.printf("[WS] Client %u data interval %u ms\n", (unsigned)clientId, (unsigned)ms);
+#endif
+}
+
 uint8_t BBQWebServer::getClientCount() const {
 #ifndef NATIVE_BUILD
     if (_ws) return _ws->count();
@@ -130,130 +875,176 @@ uint8_t BBQWebServer::getClientCount() const {
     return 0;
 }
 
-bbq_protocol::DataPayload BBQWebServer::buildDataPayload() {
+bbq_protocol::DataPayload BBQWebServer::buildDataPayload(const TelemetrySnapshot& t) const {
     bbq_protocol::DataPayload payload;
     memset(&payload, 0, sizeof(payload));
+    payload.seq = _session ? _session->getTotalPointCount() : 0;
 
 #ifndef NATIVE_BUILD
     // Timestamp
     time_t now;
     time(&now);
     payload.ts = (uint32_t)now;
+    payload.sampleUs = t.sampleUs;
 
     // Temperatures
-    if (_temp) {
-        payload.pit   = _temp->isConnected(PROBE_PIT)   ? _temp->getPitTemp()   : NAN;
-        payload.meat1 = _temp->isConnected(PROBE_MEAT1)  ? _temp->getMeat1Temp() : NAN;
-        payload.meat2 = _temp->isConnected(PROBE_MEAT2)  ? _temp->getMeat2Temp() : NAN;
-    } else {
-        payload.pit = payload.meat1 = payload.meat2 = NAN;
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        payload.temp[c] = t.connected[c] ? t.temp[c] : NAN;
     }
 
     // Fan and damper
-    payload.fan    = _fan    ? (uint8_t)_fan->getCurrentSpeedPct()        : 0;
-    payload.damper = _servo  ? (uint8_t)_servo->getCurrentPositionPct()   : 0;
-
-    // Setpoint
-    payload.sp = _setpoint;
+    payload.fan    = (uint8_t)t.fanPct;
+    payload.damper = (uint8_t)t.damperPct;
 
-    // Lid-open
-    payload.lid = _pid ? _pid->isLidOpen() : false;
+    // Setpoint and lid-open
+    payload.sp  = t.setpoint;
+    payload.lid = t.lidOpen;
 
-    // Meat targets from alarm manager
-    payload.meat1Target = _alarm ? _alarm->getMeat1Target() : 0;
-    payload.meat2Target = _alarm ? _alarm->getMeat2Target() : 0;
+    // Meat targets
+    for (uint8_t m = 0; m < NUM_MEATS; m++) payload.meatTarget[m] = t.meatTarget[m];
 
     // Fan mode
-    payload.fanMode = _config ? _config->getFanMode() : "fan_and_damper";
+    payload.fanMode = t.fanMode[0] ? t.fanMode : "fan_and_damper";
 
     // Estimated done time
-    payload.est = _estimatedTime;
+    payload.est     = t.estimate.est;
+    payload.estLow  = t.estimate.low;
+    payload.estHigh = t.estimate.high;
+    payload.stall   = t.estimate.stalled;
+    payload.tuning  = t.autoTuning;
 
-    // Errors
+    // Errors (messages point into the snapshot copy)
     payload.errorCount = 0;
-    if (_error) {
-        auto activeErrors = _error->getErrors();
-        for (size_t i = 0; i < activeErrors.size() && payload.errorCount < 8; i++) {
-            payload.errors[payload.errorCount++] = activeErrors[i].message;
-        }
+    for (uint8_t i = 0; i < t.errorCount && payload.errorCount < 8; i++) {
+        payload.errors[payload.errorCount++] = t.errors[i].message;
+    }
+
+    // Control zones past zone 0
+    payload.zoneCount = t.zoneCount;
+    for (uint8_t i = 0; i < t.zoneCount; i++) {
+        bbq_protocol::ZonePayload& z = payload.zones[i];
+        z.probe  = t.zones[i].probe;
+        z.sp     = t.zones[i].setpoint;
+        z.fan    = (uint8_t)t.zones[i].fanPct;
+        z.damper = (uint8_t)t.zones[i].damperPct;
+        z.lid    = t.zones[i].lidOpen;
     }
 #endif
 
     return payload;
 }
 
-void BBQWebServer::sendHistory(uint8_t clientId) {
-#ifndef NATIVE_BUILD
-    if (!_session || !_ws) return;
+void BBQWebServer::sendHistory(uint32_t clientId) {
+    if (!_session) return;
 
-    uint32_t count = _session->getPointCount();
-    if (count == 0) return;
+    ClientSlot* slot = findSlot(clientId);
+    if (!slot) return;
 
-    // Build array of HistoryPoints from session data
-    bbq_protocol::HistoryPoint* points =
-        (bbq_protocol::HistoryPoint*)malloc(count * sizeof(bbq_protocol::HistoryPoint));
-    if (!points) return;
+    // Replay the full cook at a resolution the client can actually draw
+    historyStreamBegin(slot->history, *_session, slot->historyMaxPoints);
+}
 
-    for (uint32_t i = 0; i < count; i++) {
-        const DataPoint* dp = _session->getPoint(i);
-        if (!dp) continue;
+void BBQWebServer::resumeHistory(ClientSlot& slot, uint32_t since) {
+    historyStreamResume(slot.history, since);
+}
 
-        points[i].ts = dp->timestamp;
+void BBQWebServer::pumpHistory() {
+#ifndef NATIVE_BUILD
+    if (!_session || !_ws) return;
 
-        // Convert int16 temps (x10) back to float, check disconnect flags
-        if (dp->flags & DP_FLAG_PIT_DISC)   points[i].pit = NAN;
-        else                                 points[i].pit = dp->pitTemp / 10.0f;
+    // Shared scratch: chunks are built and queued one at a time, and
+    // text() copies into the client's queue, so one buffer serves everyone.
+    // Allocated on first replay, in PSRAM when the board has it.
+    static HistoryScratch* scratch = nullptr;
+    if (!scratch) scratch = (HistoryScratch*)extRamAlloc(sizeof(HistoryScratch));
+    if (!scratch) return;
+    static TelemetrySnapshot t;
+    bool haveTelemetry = false;
+    bool measured = false;
 
-        if (dp->flags & DP_FLAG_MEAT1_DISC) points[i].meat1 = NAN;
-        else                                 points[i].meat1 = dp->meat1Temp / 10.0f;
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        ClientSlot& slot = _clients[i];
+        if (slot.id == 0 || !slot.history.active) continue;
 
-        if (dp->flags & DP_FLAG_MEAT2_DISC) points[i].meat2 = NAN;
-        else                                 points[i].meat2 = dp->meat2Temp / 10.0f;
+        AsyncWebSocketClient* client = _ws->client(slot.id);
+        if (!client) {
+            slot.history.active = false;
+            continue;
+        }
 
-        points[i].fan    = dp->fanPct;
-        points[i].damper = dp->damperPct;
-        points[i].sp     = _setpoint; // current setpoint (per-point sp not stored)
-        points[i].lid    = (dp->flags & DP_FLAG_LID_OPEN) != 0;
-    }
+        // Until the hello arrives, it may still ask for just the tail
+        if (slot.historyHoldMs != 0) {
+            if ((int32_t)(millis() - slot.historyHoldMs) < 0) continue;
+            slot.historyHoldMs = 0;
+        }
+
+        // Back-pressure: wait until the client's queue and TCP window drain,
+        // and stay inside the shared budget with the data frames
+        if (!measured) {
+            measureInFlight();
+            measured = true;
+        }
+        if (client->queueIsFull() || !client->client() ||
+            client->client()->space() < WS_HISTORY_CHUNK_BYTES / 2 ||
+            _inFlight + WS_HISTORY_CHUNK_BYTES / 2 > WS_QUEUE_BUDGET) {
+            continue;
+        }
+
+        if (!haveTelemetry) {
+            // Setpoint and targets for the chunks, read once per pump
+            if (_telemetry) t = _telemetry->read();
+            haveTelemetry = true;
+        }
 
-    float m1t = _alarm ? _alarm->getMeat1Target() : 0;
-    float m2t = _alarm ? _alarm->getMeat2Target() : 0;
+        bool final = false;
+        size_t len = historyStreamNext(slot.history, *_session, *scratch,
+                                       t.setpoint, t.meatTarget, final);
+        if (len == 0) {
+            Serial.printf("[WS] History chunk %u overflow, client %u\n",
+                          slot.history.chunk, slot.id);
+            continue;
+        }
 
-    size_t msgLen = 0;
-    char* msg = bbq_protocol::buildHistoryMessage(points, count, _setpoint, m1t, m2t, &msgLen);
-    free(points);
+        _ws->text(slot.id, scratch->buf, len);
+        _inFlight += len;
 
-    if (msg) {
-        _ws->text(clientId, msg, msgLen);
-        free(msg);
+        if (final) {
+            Serial.printf("[WS] History %s to client %u done (%u chunks, level %u)\n",
+                          slot.history.resume ? "resume" : "replay", slot.id,
+                          slot.history.chunk, slot.history.level);
+        }
     }
 #endif
 }
 
-void BBQWebServer::handleWebSocketMessage(uint8_t clientId, const char* data, size_t len) {
+void BBQWebServer::handleWebSocketMessage(uint32_t clientId, const char* data, size_t len) {
 #ifndef NATIVE_BUILD
     bbq_protocol::ParsedCommand cmd = bbq_protocol::parseCommand(data, len);
 
     switch (cmd.type) {
         case bbq_protocol::CmdType::SET_SP:
-            _setpoint = cmd.setpoint;
-            if (_onSetpoint) _onSetpoint(cmd.setpoint);
-            Serial.printf("[WS] Client %u set setpoint to %.0f\n", clientId, cmd.setpoint);
+            if (_onSetpoint) _onSetpoint(cmd.zone, cmd.setpoint);
+            Serial.printf("[WS] Client %u set zone %u setpoint to %.0f\n",
+                          clientId, (unsigned)cmd.zone, cmd.setpoint);
             break;
 
         case bbq_protocol::CmdType::ALARM:
-            if (cmd.hasMeat1Target && _onAlarm) _onAlarm("meat1", cmd.meat1Target);
-            if (cmd.hasMeat2Target && _onAlarm) _onAlarm("meat2", cmd.meat2Target);
+            for (uint8_t m = 0; m < NUM_MEATS; m++) {
+                if ((cmd.meatTargetMask & (1u << m)) && _onAlarm) {
+                    _onAlarm(kProbeChannels[PROBE_MEAT1 + m].key, cmd.meatTarget[m]);
+                }
+            }
             if (cmd.hasPitBand && _onAlarm)     _onAlarm("pitBand", cmd.pitBand);
             break;
 
         case bbq_protocol::CmdType::SESSION_NEW:
             if (_onSession) _onSession("new", "");
+            postClientEvent(ClientEvent::SESSION_NEW, 0);
             // Broadcast session reset to all clients
             {
-                char buf[128];
-                size_t n = bbq_protocol::buildSessionReset(buf, sizeof(buf), _setpoint);
-                _ws->textAll(buf, n);
+                float sp = _telemetry ? _telemetry->read().setpoint : 0.0f;
+                size_t n = bbq_protocol::buildSessionReset(_asyncJson, sizeof(_asyncJson), sp);
+                if (n > 0) _ws->textAll(_asyncJson, n);
             }
             break;
 
@@ -263,19 +1054,56 @@ void BBQWebServer::handleWebSocketMessage(uint8_t clientId, const char* data, si
             broadcastNow();
             break;
 
-        case bbq_protocol::CmdType::SESSION_DOWNLOAD:
-            if (_session) {
-                String csvData = _session->toCSV();
-                size_t envLen = 0;
-                char* envelope = bbq_protocol::buildCSVDownloadEnvelope(
-                    csvData.c_str(), csvData.length(), &envLen);
-                if (envelope) {
-                    _ws->text(clientId, envelope, envLen);
-                    free(envelope);
+        case bbq_protocol::CmdType::AUTOTUNE:
+            if (_onAutoTune) _onAutoTune(cmd.autoTuneStart);
+            Serial.printf("[WS] Client %u %s PID auto-tune\n", clientId,
+                          cmd.autoTuneStart ? "started" : "cancelled");
+            broadcastNow();
+            break;
+
+        case bbq_protocol::CmdType::HELLO:
+            {
+                ClientEvent e;
+                memset(&e, 0, sizeof(e));
+                e.kind           = ClientEvent::HELLO;
+                e.clientId       = clientId;
+                e.wantsBinary    = cmd.wantsBinary;
+                e.historyPoints  = cmd.historyPoints;
+                e.historySession = cmd.historySession;
+                e.value          = cmd.historySince;
+                postClientEvent(e);
+            }
+            break;
+
+        case bbq_protocol::CmdType::SET_RATE:
+            postClientEvent(ClientEvent::SET_RATE, clientId, cmd.rateMs);
+            break;
+
+        case bbq_protocol::CmdType::PING:
+            {
+                // Answer first, so the client's round trip doesn't include
+                // the histogram updates
+                char pong[PONG_MAX_BYTES];
+                size_t n = bbq_protocol::buildPong(pong, sizeof(pong), cmd.pingT,
+                                                   (uint32_t)metricsNowUs());
+                if (n > 0) _ws->text(clientId, pong, n);
+                for (uint8_t i = 0; i < cmd.latencyCount; i++) {
+                    metricObserve(Metric::SAMPLE_TO_PAINT, cmd.latencyUs[i]);
                 }
             }
             break;
 
+        case bbq_protocol::CmdType::SESSION_DOWNLOAD:
+            {
+                // A cook-sized export doesn't fit in a WebSocket message
+                // without holding all of it in RAM; the HTTP endpoints
+                // stream it, so the client is pointed there instead
+                char reply[DOWNLOAD_POINTER_MAX_BYTES];
+                size_t n = bbq_protocol::buildDownloadPointer(reply, sizeof(reply), cmd.format);
+                if (n > 0) _ws->text(clientId, reply, n);
+            }
+            break;
+
         default:
             Serial.printf("[WS] Unknown message type from client %u\n", clientId);
             break;
@@ -290,19 +1118,14 @@ void BBQWebServer::onWsEvent(AsyncWebSocket* server, AsyncWebSocketClient* clien
         case WS_EVT_CONNECT:
             Serial.printf("[WS] Client #%u connected from %s\n",
                           client->id(), client->remoteIP().toString().c_str());
-            // Send history if session has data, otherwise send current snapshot
-            if (_session && _session->getPointCount() > 0) {
-                sendHistory(client->id());
-            } else {
-                bbq_protocol::DataPayload payload = buildDataPayload();
-                char buf[512];
-                size_t n = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
-                _ws->text(client->id(), buf, n);
-            }
+            // Slot and history replay are set up by update(); a client that
+            // can't be queued would never get either
+            if (!postClientEvent(ClientEvent::CONNECT, client->id())) client->close();
             break;
 
         case WS_EVT_DISCONNECT:
             Serial.printf("[WS] Client #%u disconnected.\n", client->id());
+            postClientEvent(ClientEvent::DISCONNECT, client->id());
             break;
 
         case WS_EVT_DATA:
@@ -2,30 +2,38 @@
 
 #include "config.h"
 #include "web_protocol.h"
+#include "telemetry.h"
+#include "history_stream.h"
+#include "seqlock.h"
+#include "spsc_queue.h"
 #include <stdint.h>
 
 #ifndef NATIVE_BUILD
 #include <ESPAsyncWebServer.h>
 #include <AsyncWebSocket.h>
+#include <AsyncEventSource.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 #endif
 
 // Forward declarations for external module references
-class TempManager;
-class PidController;
-class FanController;
-class ServoController;
-class ConfigManager;
 class CookSession;
-class AlarmManager;
-class ErrorManager;
+class HubManager;
+enum class ExportFormat;
 
 // Callback types for commands received from WebSocket clients
-typedef void (*SetpointCallback)(float setpoint);
+typedef void (*SetpointCallback)(uint8_t zone, float setpoint);   // zone 0 = the pit (control_zone.h)
 typedef void (*AlarmCallback)(const char* probe, float target);
 typedef void (*SessionCallback)(const char* action, const char* format);
 typedef void (*FanModeCallback)(const char* mode);
+typedef void (*AutoTuneCallback)(bool start);
+
+// Probe calibration request from /api/calibrate (probe_calibration.h).
+// action is "status", "start", "capture", "apply" or "cancel"; ref is the
+// reference temperature for "capture", in the configured units. Fills json
+// with the calibration status; false if the action was refused.
+typedef bool (*CalibrateCallback)(const char* action, uint8_t probe, float ref,
+                                  char* json, size_t jsonSize);
 
 class BBQWebServer {
 public:
@@ -43,68 +51,199 @@ public:
     // Respects WS_SEND_INTERVAL internally. Call every loop().
     void update();
 
-    // Set references to other modules for building data messages
-    void setModules(TempManager* temp, PidController* pid, FanController* fan,
-                    ServoController* servo, ConfigManager* config, CookSession* session,
-                    AlarmManager* alarm, ErrorManager* error);
+    // Set the session (history, export) and the telemetry channel that
+    // data messages are built from. The server never touches the control
+    // modules, so update() needs no lock.
+    void setModules(CookSession* session, const TelemetryChannel* telemetry);
+
+    // Serve the merged hub view at /api/hub when hub mode is on
+    void setHub(HubManager* hub) { _hub = hub; }
 
     // Set callbacks for incoming WebSocket commands
     void onSetpoint(SetpointCallback cb)  { _onSetpoint = cb; }
     void onAlarm(AlarmCallback cb)        { _onAlarm = cb; }
     void onSession(SessionCallback cb)    { _onSession = cb; }
     void onFanMode(FanModeCallback cb)    { _onFanMode = cb; }
+    void onAutoTune(AutoTuneCallback cb)  { _onAutoTune = cb; }
+    void onCalibrate(CalibrateCallback cb) { _onCalibrate = cb; }
 
-    // Send history replay to a specific client on connect
-    void sendHistory(uint8_t clientId);
+    // Start a chunked history replay to a specific client at the finest
+    // level of detail that fits its chart. Chunks are sent from update()
+    // as the client's send queue drains. Loop task only.
+    void sendHistory(uint32_t clientId);
 
-    // Force-send data to all clients immediately (bypasses interval)
+    // Send data to all clients as soon as the next telemetry snapshot is
+    // published (bypasses interval). Safe to call from the async TCP task.
     void broadcastNow();
 
     // Get number of connected WebSocket clients
     uint8_t getClientCount() const;
 
-    // Set the current setpoint (for inclusion in data messages)
-    void setSetpoint(float sp) { _setpoint = sp; }
-
-    // Set estimated completion time (epoch, or 0 for null)
-    void setEstimatedTime(uint32_t est) { _estimatedTime = est; }
+    // Build the data payload from a telemetry snapshot. String fields point
+    // into t, so it must outlive the payload. Also used by MqttPublisher.
+    bbq_protocol::DataPayload buildDataPayload(const TelemetrySnapshot& t) const;
 
 private:
-    // Build the data payload from current sensor/PID state
-    bbq_protocol::DataPayload buildDataPayload();
+#ifndef NATIVE_BUILD
+    // Stream the full cook as an HTTP chunked download
+    void handleExport(AsyncWebServerRequest* request, ExportFormat format);
+
+    // List the archived past cooks as JSON
+    void handleSessionList(AsyncWebServerRequest* request);
+
+    // Protocol builder counters, WebSocket back-pressure and heap as JSON
+    void handleStats(AsyncWebServerRequest* request);
+
+    // The last data frame, as broadcast
+    void handleState(AsyncWebServerRequest* request);
+
+    // Probe calibration status and actions
+    void handleCalibrate(AsyncWebServerRequest* request, const char* action);
+
+    // Hot-path histograms, heap, Wi-Fi and per-client figures for Prometheus
+    void handleMetrics(AsyncWebServerRequest* request);
+
+    // Hub mode: every unit's latest frame, and one peer's trend
+    void handleHub(AsyncWebServerRequest* request);
+    void handleHubHistory(AsyncWebServerRequest* request);
+#endif
 
     // Handle incoming WebSocket messages
-    void handleWebSocketMessage(uint8_t clientId, const char* data, size_t len);
+    void handleWebSocketMessage(uint32_t clientId, const char* data, size_t len);
+
+    // Per-client protocol state, indexed by slot (not client id)
+    struct ClientSlot {
+        uint32_t id;          // AsyncWebSocketClient id, 0 = free
+        bool     binary;      // Negotiated binary delta frames
+        uint32_t deltaSeq;    // Shared binary frame last received (0 = needs a keyframe)
+        HistoryStream history;    // Chunked history replay (history_stream.h)
+        uint16_t historyMaxPoints; // Client's LOD budget
+        uint32_t historyHoldMs;   // Replay waits for hello until then (0 = not held)
+        uint16_t intervalMs;      // Data cadence the client asked for
+        uint16_t sendWindow;      // Largest TCP send space seen (the idle window)
+        uint32_t lastSentMs;      // When it was last sent a data frame
+    };
+
+    ClientSlot* findSlot(uint32_t clientId);
+    ClientSlot* allocSlot(uint32_t clientId);
+    void freeSlot(ClientSlot& slot);
+
+    // Client lifecycle and per-client settings, as the async TCP task saw
+    // them. Queued for update() so _clients and each slot's history stream
+    // are only ever touched by the loop task.
+    struct ClientEvent {
+        enum Kind : uint8_t { CONNECT, DISCONNECT, HELLO, SET_RATE, SESSION_NEW } kind;
+        bool     wantsBinary;     // HELLO
+        uint16_t historyPoints;   // HELLO
+        uint32_t clientId;        // 0 for SESSION_NEW
+        uint32_t historySession;  // HELLO
+        uint32_t value;           // HELLO: historySince; SET_RATE: rateMs
+    };
+
+    // Queue an event from the async TCP task. False (logged) if the queue
+    // is full.
+    bool postClientEvent(const ClientEvent& e);
+    bool postClientEvent(ClientEvent::Kind kind, uint32_t clientId, uint32_t value = 0);
+
+    // Apply every queued event, then drop slots whose client has gone
+    // without its disconnect getting through
+    void drainClientEvents();
+    void applyConnect(uint32_t clientId);
+    void applyHello(const ClientEvent& e);
+    void applyRate(uint32_t clientId, uint32_t rateMs);
+
+    // Replay only the points from seq `since` on (level 0) to a client
+    // that holds the rest of the session
+    void resumeHistory(ClientSlot& slot, uint32_t since);
+
+    // Send the next history chunk to each replaying client that has room
+    void pumpHistory();
+
+    // Send the current payload in its own format to every client that is
+    // due at its cadence and has drained what it was sent. early = a
+    // command asked for this frame, so cadence is ignored. Each frame is
+    // built once and shared by all of its recipients; the JSON one is
+    // already in _loopJson (jsonLen bytes, 0 if it didn't fit).
+    void broadcastPayload(const bbq_protocol::DataPayload& payload, size_t jsonLen, bool early);
+
+#ifndef NATIVE_BUILD
+    // Publish _loopJson (len bytes) as the current state frame
+    void publishState(uint32_t version, size_t len);
+
+    // Refresh _inFlight from every client's connection
+    void measureInFlight();
+
+    // Bytes handed to the client's TCP connection and not yet acked
+    size_t unackedBytes(ClientSlot& slot, AsyncWebSocketClient* client);
+
+    // Whether a frame of `bytes` can go to the client without queueing
+    // behind data it hasn't acked, within WS_QUEUE_BUDGET overall
+    bool canSendNow(AsyncWebSocketClient* client, size_t bytes);
+#endif
 
     // WebSocket event handler
     void onWsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
                    AwsEventType type, void* arg, uint8_t* data, size_t len);
 
 #ifndef NATIVE_BUILD
-    AsyncWebServer* _server;
-    AsyncWebSocket* _ws;
+    AsyncWebServer*   _server;
+    AsyncWebSocket*   _ws;
+    AsyncEventSource* _events;
 #endif
 
+    // The JSON data frame of the last broadcast tick, for /api/state and
+    // new event-stream viewers. Read on the async TCP task, which can
+    // preempt publishState() mid-write on core 0 (see seqlock.h).
+    struct StateFrame {
+        uint32_t version;     // Telemetry version it was built from
+        uint16_t len;         // 0 = none yet
+        char     json[DATA_MESSAGE_MAX_BYTES];
+    };
+    Seqlock<StateFrame> _state;
+
     // Module references
-    TempManager*    _temp;
-    PidController*  _pid;
-    FanController*  _fan;
-    ServoController* _servo;
-    ConfigManager*  _config;
-    CookSession*    _session;
-    AlarmManager*   _alarm;
-    ErrorManager*   _error;
-
-    // State
-    float    _setpoint;
-    uint32_t _estimatedTime;
+    CookSession*            _session;
+    const TelemetryChannel* _telemetry;
+    HubManager*             _hub;
 
     // Timing
     unsigned long _lastBroadcastMs;
 
+    // broadcastNow() request: send once the version moves past this
+    volatile bool     _broadcastPending;
+    volatile uint32_t _broadcastAfter;
+
+    ClientSlot _clients[WS_MAX_CLIENTS];
+    SpscQueue<ClientEvent, WS_EVENT_QUEUE> _clientEvents;
+    uint8_t    _binaryClients;   // Slots with binary == true
+
+    // The binary stream every binary client follows: deltas against the
+    // last frame, numbered so a client that missed one gets a keyframe
+    bbq_protocol::BinaryDeltaState _delta;
+    uint32_t _deltaSeq;
+    uint8_t  _sinceKeyframe;
+
+    // Back-pressure: unacked bytes summed over clients at the start of a
+    // send pass, and data frames skipped for slow clients since boot
+    size_t   _inFlight;
+    uint32_t _framesSkipped;
+
+    // Duration of the last and slowest broadcast pass, in microseconds
+    uint32_t _broadcastUs;
+    uint32_t _broadcastUsMax;
+
+    // Reusable frame buffers, so building a broadcast never allocates.
+    // One set per task that builds: update() in loop(), handlers on async_tcp.
+    char    _loopJson[DATA_MESSAGE_MAX_BYTES];
+    uint8_t _loopBinary[BIN_MAX_FRAME];
+    uint8_t _loopKey[BIN_MAX_FRAME];
+    char    _asyncJson[DATA_MESSAGE_MAX_BYTES];
+
     // Callbacks
     SetpointCallback _onSetpoint;
     AlarmCallback    _onAlarm;
     SessionCallback  _onSession;
     FanModeCallback  _onFanMode;
+    AutoTuneCallback _onAutoTune;
+    CalibrateCallback _onCalibrate;
 };
@@ -0,0 +1,103 @@
+#include "wifi_link.h"
+
+static void enter(WifiLink& l, WifiLinkState s, uint32_t nowMs) {
+    l.state = s;
+    l.sinceMs = nowMs;
+}
+
+static void connected(WifiLink& l, uint32_t nowMs) {
+    enter(l, WifiLinkState::CONNECTED, nowMs);
+    l.failures = 0;
+    l.backoffMs = WIFI_RECONNECT_BASE_MS;
+    l.everConnected = true;
+}
+
+// An attempt ended without an IP: wait, or give up to the portal
+static WifiLinkAction failed(WifiLink& l, uint32_t nowMs) {
+    if (l.failures < 255) l.failures++;
+    uint8_t limit = l.everConnected ? WIFI_RECONNECT_ATTEMPTS : WIFI_BOOT_ATTEMPTS;
+    if (l.failures >= limit) {
+        enter(l, WifiLinkState::AP, nowMs);
+        return WifiLinkAction::START_AP;
+    }
+    enter(l, WifiLinkState::BACKOFF, nowMs);
+    return WifiLinkAction::NONE;
+}
+
+void wifiLinkBegin(WifiLink& l, uint32_t nowMs) {
+    enter(l, WifiLinkState::CONNECTING, nowMs);
+    l.backoffMs = WIFI_RECONNECT_BASE_MS;
+    l.failures = 0;
+    l.everConnected = false;
+}
+
+WifiLinkAction wifiLinkStep(WifiLink& l, uint32_t nowMs, WifiLinkEvent ev) {
+    switch (l.state) {
+        case WifiLinkState::CONNECTING:
+            if (ev == WifiLinkEvent::GOT_IP) {
+                connected(l, nowMs);
+            } else if (ev == WifiLinkEvent::DISCONNECTED ||
+                       nowMs - l.sinceMs >= WIFI_CONNECT_TIMEOUT_MS) {
+                return failed(l, nowMs);
+            }
+            break;
+
+        case WifiLinkState::CONNECTED:
+            if (ev == WifiLinkEvent::DISCONNECTED) {
+                // First retry after the base delay: a rebooting router
+                // won't be back any sooner
+                l.backoffMs = WIFI_RECONNECT_BASE_MS;
+                enter(l, WifiLinkState::BACKOFF, nowMs);
+            }
+            break;
+
+        case WifiLinkState::BACKOFF:
+            if (ev == WifiLinkEvent::GOT_IP) {
+                connected(l, nowMs);
+            } else if (nowMs - l.sinceMs >= l.backoffMs) {
+                enter(l, WifiLinkState::CONNECTING, nowMs);
+                uint32_t next = l.backoffMs * 2;
+                l.backoffMs = next < WIFI_RECONNECT_MAX_MS ? next : WIFI_RECONNECT_MAX_MS;
+                return WifiLinkAction::CONNECT;
+            }
+            break;
+
+        case WifiLinkState::AP:
+            // The portal connects the station itself
+            if (ev == WifiLinkEvent::GOT_IP) connected(l, nowMs);
+            break;
+
+        case WifiLinkState::OFF:
+            break;
+    }
+    return WifiLinkAction::NONE;
+}
+
+void wifiLinkStop(WifiLink& l, uint32_t nowMs) {
+    enter(l, WifiLinkState::OFF, nowMs);
+}
+
+WifiLinkAction wifiLinkRetry(WifiLink& l, uint32_t nowMs) {
+    if (l.state == WifiLinkState::CONNECTED || l.state == WifiLinkState::CONNECTING) {
+        return WifiLinkAction::NONE;
+    }
+    l.failures = 0;
+    l.backoffMs = WIFI_RECONNECT_BASE_MS;
+    enter(l, WifiLinkState::CONNECTING, nowMs);
+    return WifiLinkAction::CONNECT;
+}
+
+void wifiLinkEnterAP(WifiLink& l, uint32_t nowMs) {
+    enter(l, WifiLinkState::AP, nowMs);
+}
+
+const char* wifiLinkStateName(WifiLinkState s) {
+    switch (s) {
+        case WifiLinkState::OFF:        return "off";
+        case WifiLinkState::CONNECTING: return "connecting";
+        case WifiLinkState::CONNECTED:  return "connected";
+        case WifiLinkState::BACKOFF:    return "backoff";
+        case WifiLinkState::AP:         return "ap";
+    }
+    return "?";
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "config.h"
+#include <stdint.h>
+
+// Wi-Fi connection state machine behind WifiManager.
+//
+// WifiManager feeds it the clock and the radio's events (from the ESP32
+// Wi-Fi event callback) and carries out the action it returns. Nothing
+// here waits: a connect is started and the outcome arrives later as an
+// event or a timeout, so loop() never stalls on the network. Failed
+// attempts back off exponentially from WIFI_RECONNECT_BASE_MS to
+// WIFI_RECONNECT_MAX_MS; too many in a row fall back to the setup AP.
+// Pure C++, testable on native.
+
+enum class WifiLinkState : uint8_t {
+    OFF,          // Stopped by the user (disconnect())
+    CONNECTING,   // Connect issued, waiting for an IP, a failure or the timeout
+    CONNECTED,
+    BACKOFF,      // Waiting out the retry delay
+    AP            // Setup portal
+};
+
+enum class WifiLinkEvent : uint8_t {
+    NONE,
+    GOT_IP,
+    DISCONNECTED  // Attempt failed, or an established link dropped
+};
+
+enum class WifiLinkAction : uint8_t {
+    NONE,
+    CONNECT,      // Start a connection attempt (WiFi.begin())
+    START_AP      // Bring up the setup portal
+};
+
+struct WifiLink {
+    WifiLinkState state;
+    uint32_t      sinceMs;        // When the state was entered
+    uint32_t      backoffMs;      // Delay before the next attempt
+    uint8_t       failures;       // Failed attempts since the last connection
+    bool          everConnected;  // Picks WIFI_BOOT_ATTEMPTS or WIFI_RECONNECT_ATTEMPTS
+};
+
+// Start from boot: CONNECTING. The caller issues the first connect.
+void wifiLinkBegin(WifiLink& l, uint32_t nowMs);
+
+// Advance on an event (or NONE, to run the timers). Call every loop().
+WifiLinkAction wifiLinkStep(WifiLink& l, uint32_t nowMs, WifiLinkEvent ev);
+
+// User actions. stop() parks in OFF; retry() leaves OFF/AP/BACKOFF for an
+// immediate attempt with the backoff reset; enterAP() switches to the portal.
+void wifiLinkStop(WifiLink& l, uint32_t nowMs);
+WifiLinkAction wifiLinkRetry(WifiLink& l, uint32_t nowMs);
+void wifiLinkEnterAP(WifiLink& l, uint32_t nowMs);
+
+const char* wifiLinkStateName(WifiLinkState s);
@@ -5,167 +5,164 @@
 #endif
 
 WifiManager::WifiManager()
-    : _apMode(false)
-    , _connected(false)
-    , _reconnectAttempts(0)
-    , _bootFailCount(0)
-    , _lastReconnectMs(0)
-    , _reconnectIntervalMs(RECONNECT_BASE_MS)
+    : _pendingEvent((uint8_t)WifiLinkEvent::NONE)
+    , _started(false)
     , _mdnsStarted(false)
-    , _lastConnectionCheckMs(0)
+    , _apPending(false)
+    , _portalRunning(false)
+    , _apRequestMs(0)
 {
+    wifiLinkStop(_link, 0);
+    _ssid[0] = '\0';
+    _password[0] = '\0';
 }
 
 void WifiManager::begin(const char* ssid, const char* password) {
 #ifndef NATIVE_BUILD
     Serial.println("[WIFI] Initializing WiFi manager...");
 
+    if (ssid != nullptr) {
+        strlcpy(_ssid, ssid, sizeof(_ssid));
+        strlcpy(_password, password ? password : "", sizeof(_password));
+    }
+
     // Set hostname before connecting
     WiFi.setHostname(WIFI_HOSTNAME);
+    WiFi.mode(WIFI_STA);
+    // Retries are ours (with backoff), not the driver's
+    WiFi.setAutoReconnect(false);
+
+    // Runs on the Wi-Fi event task: only hand the event over
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            _pendingEvent.store((uint8_t)WifiLinkEvent::GOT_IP);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            // Our own disconnect() before a retry or the AP switch isn't a failure
+            if (info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) {
+                _pendingEvent.store((uint8_t)WifiLinkEvent::DISCONNECTED);
+            }
+        }
+    });
 
     // Configure WiFiManager
     _wifiManager.setConfigPortalTimeout(180);  // 3 minute timeout on portal
-    _wifiManager.setConnectTimeout(15);         // 15 second connect timeout
+    _wifiManager.setConfigPortalBlocking(false);
     _wifiManager.setDebugOutput(true);
 
-    // If explicit credentials are provided, try connecting with them first
-    if (ssid != nullptr && ssid[0] != '\0') {
-        Serial.printf("[WIFI] Attempting connection to '%s'...\n", ssid);
-        WiFi.mode(WIFI_STA);
-        WiFi.begin(ssid, password);
-
-        // Wait up to 15 seconds for connection
-        unsigned long startMs = millis();
-        while (WiFi.status() != WL_CONNECTED && millis() - startMs < 15000) {
-            delay(250);
-            Serial.print(".");
-        }
-        Serial.println();
-
-        if (WiFi.status() == WL_CONNECTED) {
-            _connected = true;
-            _apMode = false;
-            Serial.printf("[WIFI] Connected to '%s', IP: %s\n",
-                          ssid, WiFi.localIP().toString().c_str());
-            setupMDNS();
-            return;
-        }
-
-        Serial.printf("[WIFI] Failed to connect to '%s'\n", ssid);
-        _bootFailCount++;
-    }
-
-    // Try WiFiManager autoConnect (uses saved credentials)
-    // Attempt up to MAX_BOOT_FAILURES times before falling back to AP
-    while (_bootFailCount < MAX_BOOT_FAILURES) {
-        Serial.printf("[WIFI] Auto-connect attempt %d/%d...\n",
-                      _bootFailCount + 1, MAX_BOOT_FAILURES);
-
-        // autoConnect returns true if connected, false if portal timed out
-        // It will use saved credentials first, then open portal if they fail
-        WiFi.mode(WIFI_STA);
-
-        // Try a simple reconnect with saved credentials
-        WiFi.begin();
-        unsigned long startMs = millis();
-        while (WiFi.status() != WL_CONNECTED && millis() - startMs < 15000) {
-            delay(250);
-            Serial.print(".");
-        }
-        Serial.println();
-
-        if (WiFi.status() == WL_CONNECTED) {
-            _connected = true;
-            _apMode = false;
-            Serial.printf("[WIFI] Connected! IP: %s\n",
-                          WiFi.localIP().toString().c_str());
-            setupMDNS();
-            return;
-        }
-
-        _bootFailCount++;
-        Serial.printf("[WIFI] Connection attempt failed (%d/%d)\n",
-                      _bootFailCount, MAX_BOOT_FAILURES);
-    }
-
-    // All attempts failed -- fall back to AP captive portal
-    Serial.println("[WIFI] All connection attempts failed, starting AP mode...");
-    startAP();
+    _started = true;
+    wifiLinkBegin(_link, millis());
+    connect();
 #endif
 }
 
 void WifiManager::update() {
 #ifndef NATIVE_BUILD
+    if (!_started) return;
     unsigned long now = millis();
 
-    // If we are in AP mode, let WiFiManager handle portal clients.
-    // WiFiManager's process() services the captive portal in non-blocking mode.
-    if (_apMode) {
+    // Second half of the AP switch, once the station is down
+    if (_apPending && now - _apRequestMs >= WIFI_AP_SETTLE_MS) {
+        _apPending = false;
+        _wifiManager.startConfigPortal(AP_SSID, AP_PASSWORD);
+        _portalRunning = true;
+        Serial.printf("[WIFI] AP started. IP: %s\n",
+                      WiFi.softAPIP().toString().c_str());
+        Serial.printf("[WIFI] QR Code data: %s\n", getAPQRCodeData().c_str());
+    }
+
+    // WiFiManager's process() services the captive portal in non-blocking mode
+    if (_portalRunning) {
         _wifiManager.process();
+    }
 
-        // Check if a client has connected us to a network via the portal
-        if (WiFi.status() == WL_CONNECTED) {
-            _apMode = false;
-            _connected = true;
-            _reconnectAttempts = 0;
-            _reconnectIntervalMs = RECONNECT_BASE_MS;
-            Serial.printf("[WIFI] Connected via portal! IP: %s\n",
-                          WiFi.localIP().toString().c_str());
-            setupMDNS();
+    WifiLinkEvent ev = (WifiLinkEvent)_pendingEvent.exchange((uint8_t)WifiLinkEvent::NONE);
+
+    // Safety net for a missed event: the status is a cached read
+    if (ev == WifiLinkEvent::NONE && !_apPending) {
+        bool up = (WiFi.status() == WL_CONNECTED);
+        if (up && _link.state != WifiLinkState::CONNECTED && _link.state != WifiLinkState::OFF) {
+            ev = WifiLinkEvent::GOT_IP;
+        } else if (!up && _link.state == WifiLinkState::CONNECTED) {
+            ev = WifiLinkEvent::DISCONNECTED;
         }
-        return;
     }
 
-    // Station mode: periodic connection health check
-    if (now - _lastConnectionCheckMs < CONNECTION_CHECK_MS) {
-        return;
-    }
-    _lastConnectionCheckMs = now;
-
-    bool currentlyConnected = (WiFi.status() == WL_CONNECTED);
-
-    if (currentlyConnected && !_connected) {
-        // Just reconnected
-        _connected = true;
-        _reconnectAttempts = 0;
-        _reconnectIntervalMs = RECONNECT_BASE_MS;
-        Serial.printf("[WIFI] Reconnected! IP: %s, RSSI: %d dBm\n",
-                      WiFi.localIP().toString().c_str(), WiFi.RSSI());
-        if (!_mdnsStarted) {
-            setupMDNS();
-        }
+    WifiLinkState from = _link.state;
+    WifiLinkAction action = wifiLinkStep(_link, now, ev);
+    if (_link.state != from) onTransition(from);
+
+    if (action == WifiLinkAction::CONNECT) {
+        connect();
+    } else if (action == WifiLinkAction::START_AP) {
+        Serial.println("[WIFI] All connection attempts failed, starting AP mode...");
+        beginAP();
     }
-    else if (!currentlyConnected && _connected) {
-        // Just lost connection
-        _connected = false;
-        Serial.println("[WIFI] Connection lost, will attempt reconnection...");
+#endif
+}
+
+void WifiManager::connect() {
+#ifndef NATIVE_BUILD
+    if (_link.everConnected) {
+        Serial.printf("[WIFI] Reconnect attempt %u/%u (next backoff: %lu ms)...\n",
+                      _link.failures + 1, WIFI_RECONNECT_ATTEMPTS,
+                      (unsigned long)_link.backoffMs);
+    } else {
+        Serial.printf("[WIFI] Connect attempt %u/%u...\n",
+                      _link.failures + 1, WIFI_BOOT_ATTEMPTS);
     }
 
-    // If disconnected, attempt reconnect with exponential backoff
-    if (!_connected) {
-        attemptReconnect();
+    WiFi.mode(WIFI_STA);
+    if (_ssid[0] != '\0') {
+        WiFi.begin(_ssid, _password);
+    } else {
+        WiFi.begin();  // Saved credentials
     }
 #endif
 }
 
-bool WifiManager::isConnected() const {
+void WifiManager::onTransition(WifiLinkState from) {
 #ifndef NATIVE_BUILD
-    return _connected && (WiFi.status() == WL_CONNECTED);
-#else
-    return false;
+    switch (_link.state) {
+        case WifiLinkState::CONNECTED:
+            if (_portalRunning) {
+                _wifiManager.stopConfigPortal();
+                _portalRunning = false;
+            }
+            Serial.printf("[WIFI] Connected to '%s', IP: %s, RSSI: %d dBm\n",
+                          WiFi.SSID().c_str(), WiFi.localIP().toString().c_str(),
+                          WiFi.RSSI());
+            setupMDNS();
+            break;
+
+        case WifiLinkState::BACKOFF:
+            if (from == WifiLinkState::CONNECTED) {
+                Serial.println("[WIFI] Connection lost, will attempt reconnection...");
+            } else {
+                Serial.printf("[WIFI] Connection attempt failed (%u), retrying in %lu ms\n",
+                              _link.failures, (unsigned long)_link.backoffMs);
+            }
+            break;
+
+        default:
+            break;
+    }
 #endif
 }
 
+bool WifiManager::isConnected() const {
+    return _link.state == WifiLinkState::CONNECTED;
+}
+
 bool WifiManager::isAPMode() const {
-    return _apMode;
+    return _link.state == WifiLinkState::AP;
 }
 
 String WifiManager::getIPAddress() const {
 #ifndef NATIVE_BUILD
-    if (_apMode) {
+    if (isAPMode()) {
         return WiFi.softAPIP().toString();
     }
-    if (_connected) {
+    if (isConnected()) {
         return WiFi.localIP().toString();
     }
 #endif
@@ -174,10 +171,10 @@ String WifiManager::getIPAddress() const {
 
 String WifiManager::getSSID() const {
 #ifndef NATIVE_BUILD
-    if (_apMode) {
+    if (isAPMode()) {
         return String(AP_SSID);
     }
-    if (_connected) {
+    if (isConnected()) {
         return WiFi.SSID();
     }
 #endif
@@ -186,7 +183,7 @@ String WifiManager::getSSID() const {
 
 int WifiManager::getRSSI() const {
 #ifndef NATIVE_BUILD
-    if (_connected && !_apMode) {
+    if (isConnected()) {
         return WiFi.RSSI();
     }
 #endif
@@ -201,9 +198,12 @@ String WifiManager::getAPQRCodeData() const {
 void WifiManager::disconnect() {
 #ifndef NATIVE_BUILD
     Serial.println("[WIFI] Manual disconnect requested.");
-    _connected = false;
-    _apMode = false;
-    _reconnectAttempts = MAX_RECONNECT_ATTEMPTS; // Prevent auto-reconnect
+    wifiLinkStop(_link, millis());  // No auto-reconnect from OFF
+    _apPending = false;
+    if (_portalRunning) {
+        _wifiManager.stopConfigPortal();
+        _portalRunning = false;
+    }
     WiFi.disconnect(true);
 #endif
 }
@@ -211,35 +211,34 @@ void WifiManager::disconnect() {
 void WifiManager::reconnect() {
 #ifndef NATIVE_BUILD
     Serial.println("[WIFI] Manual reconnect requested.");
-    _reconnectAttempts = 0;
-    _reconnectIntervalMs = RECONNECT_BASE_MS;
-    _connected = false;
-
-    WiFi.disconnect();
-    delay(100);
-    WiFi.reconnect();
+    _apPending = false;
+    if (_portalRunning) {
+        _wifiManager.stopConfigPortal();
+        _portalRunning = false;
+    }
+    if (wifiLinkRetry(_link, millis()) == WifiLinkAction::CONNECT) {
+        connect();
+    }
 #endif
 }
 
 void WifiManager::startAP() {
+#ifndef NATIVE_BUILD
+    wifiLinkEnterAP(_link, millis());
+    beginAP();
+#endif
+}
+
+void WifiManager::beginAP() {
 #ifndef NATIVE_BUILD
     Serial.println("[WIFI] Starting AP mode for configuration...");
     Serial.printf("[WIFI] AP SSID: %s, Password: %s\n", AP_SSID, AP_PASSWORD);
 
-    _apMode = true;
-    _connected = false;
-
-    // Stop any existing connection
+    // Stop any existing connection; update() starts the portal once the
+    // radio has settled rather than waiting here
     WiFi.disconnect(true);
-    delay(100);
-
-    // Start WiFiManager in non-blocking AP mode
-    _wifiManager.setConfigPortalBlocking(false);
-    _wifiManager.startConfigPortal(AP_SSID, AP_PASSWORD);
-
-    Serial.printf("[WIFI] AP started. IP: %s\n",
-                  WiFi.softAPIP().toString().c_str());
-    Serial.printf("[WIFI] QR Code data: %s\n", getAPQRCodeData().c_str());
+    _apPending = true;
+    _apRequestMs = millis();
 #endif
 }
 
@@ -251,6 +250,8 @@ void WifiManager::setupMDNS() {
 
     if (MDNS.begin(MDNS_HOSTNAME)) {
         MDNS.addService("http", "tcp", WEB_PORT);
+        // Marks this as a Pit Claw for hubs browsing _http._tcp
+        MDNS.addServiceTxt("http", "tcp", HUB_MDNS_TXT_KEY, FIRMWARE_VERSION);
         _mdnsStarted = true;
         Serial.printf("[WIFI] mDNS started: http://%s.local\n", MDNS_HOSTNAME);
     } else {
@@ -259,30 +260,3 @@ void WifiManager::setupMDNS() {
     }
 #endif
 }
-
-void WifiManager::attemptReconnect() {
-#ifndef NATIVE_BUILD
-    unsigned long now = millis();
-
-    // Respect backoff interval
-    if (now - _lastReconnectMs < _reconnectIntervalMs) {
-        return;
-    }
-    _lastReconnectMs = now;
-
-    if (_reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-        Serial.println("[WIFI] Max reconnect attempts reached, switching to AP mode.");
-        startAP();
-        return;
-    }
-
-    _reconnectAttempts++;
-    Serial.printf("[WIFI] Reconnect attempt %d/%d (backoff: %lu ms)...\n",
-                  _reconnectAttempts, MAX_RECONNECT_ATTEMPTS, _reconnectIntervalMs);
-
-    WiFi.reconnect();
-
-    // Exponential backoff: double the interval, up to the max
-    _reconnectIntervalMs = min(_reconnectIntervalMs * 2, RECONNECT_MAX_MS);
-#endif
-}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "config.h"
+#include "wifi_link.h"
+#include <atomic>
 
 #ifndef NATIVE_BUILD
 #include <WiFi.h>
@@ -11,14 +13,18 @@
 /// Manages Wi-Fi connectivity: attempts STA connection using stored
 /// credentials via WiFiManager captive portal, falls back to AP mode
 /// for initial setup, and handles mDNS registration.
+///
+/// Never blocks: connects are issued and their outcome arrives through the
+/// ESP32 Wi-Fi event callback, which update() hands to the WifiLink state
+/// machine (wifi_link.h) for timeouts, backoff and the fall back to AP.
 class WifiManager {
 public:
     WifiManager();
 
-    /// Attempt STA connection with optional credentials; fall back to AP mode.
-    /// If ssid/password are provided, they are set as WiFiManager defaults.
-    /// If empty, WiFiManager uses its saved credentials or starts AP.
-    /// Call once from setup().
+    /// Start connecting with optional credentials and return at once.
+    /// If ssid/password are provided they are used for every attempt;
+    /// if empty, the saved credentials are. After WIFI_BOOT_ATTEMPTS
+    /// failures update() starts AP mode. Call once.
     void begin(const char* ssid = nullptr, const char* password = nullptr);
 
     /// Monitor connection health and reconnect if needed. Call every loop().
@@ -47,7 +53,7 @@ public:
     /// User must call reconnect() or startAP() to resume.
     void disconnect();
 
-    /// Trigger a reconnection attempt.
+    /// Trigger an immediate reconnection attempt with the backoff reset.
     void reconnect();
 
     /// Switch to AP mode (e.g., user-triggered from the UI).
@@ -57,24 +63,24 @@ private:
     /// Start mDNS responder.
     void setupMDNS();
 
-    /// Internal reconnect logic with backoff.
-    void attemptReconnect();
+    /// Issue a STA connect; the result comes back as an event.
+    void connect();
 
-    bool          _apMode;              // Currently in AP mode?
-    bool          _connected;           // STA connected?
-    uint8_t       _reconnectAttempts;   // Current reconnect attempts
-    uint8_t       _bootFailCount;       // Boot-time connection failures
-    unsigned long _lastReconnectMs;     // Last reconnect attempt timestamp
-    unsigned long _reconnectIntervalMs; // Current backoff interval
-    bool          _mdnsStarted;         // mDNS registered?
+    /// Drop the station and schedule the portal after WIFI_AP_SETTLE_MS.
+    void beginAP();
 
-    static const uint8_t  MAX_BOOT_FAILURES    = 3;
-    static const uint8_t  MAX_RECONNECT_ATTEMPTS = 20;
-    static const unsigned long RECONNECT_BASE_MS = 5000;
-    static const unsigned long RECONNECT_MAX_MS  = 60000;
-    static const unsigned long CONNECTION_CHECK_MS = 10000;
+    /// React to a state change made by the WifiLink.
+    void onTransition(WifiLinkState from);
 
-    unsigned long _lastConnectionCheckMs;
+    WifiLink      _link;
+    std::atomic<uint8_t> _pendingEvent; // WifiLinkEvent from the Wi-Fi event task
+    bool          _started;             // begin() called?
+    bool          _mdnsStarted;         // mDNS registered?
+    bool          _apPending;           // Portal waiting for the radio to settle
+    bool          _portalRunning;       // WiFiManager portal active?
+    unsigned long _apRequestMs;         // When the AP switch was requested
+    char          _ssid[33];            // Explicit credentials from begin(), or empty
+    char          _password[65];
 
 #ifndef NATIVE_BUILD
     WiFiManager   _wifiManager;
@@ -0,0 +1,289 @@
+/**
+ * test_hot_path.cpp
+ *
+ * Benchmarks for the hot-path pure-C++ modules on the native platform.
+ *
+ * Each benchmark runs a call in a loop and prints one line:
+ *
+ *   BENCH <name> <ns>/op <bytes> B/op <allocs> allocs/op
+ *
+ * Allocations are counted by replacing the global operator new, and every
+ * benchmark asserts none, because these paths run every tick and are meant
+ * to be allocation-free. Timings are for comparison between runs on the
+ * same machine (pio test -e bench), not pass/fail.
+ *
+ * Covers the protocol builders (data message, binary delta, one-shot
+ * history over 600/5000/20000 points), GraphHistory::addPoint() with its
+ * condenses, the predictor's slope, splitRange() and the Steinhart-Hart
+ * conversion with and without the lookup table.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#include "web_protocol.h"
+#include "web_protocol.cpp"
+#include "display/graph_history.h"
+#include "display/graph_history.cpp"
+#include "temp_predictor.h"
+#include "temp_predictor.cpp"
+#include "temp_manager.h"
+#include "temp_manager.cpp"
+#include "split_range.h"
+#include "metrics.cpp"
+
+// --------------------------------------------------------------------------
+// Allocation counting
+// --------------------------------------------------------------------------
+
+static std::atomic<uint64_t> g_allocs(0);
+static std::atomic<uint64_t> g_allocBytes(0);
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// --------------------------------------------------------------------------
+// Harness
+// --------------------------------------------------------------------------
+
+struct BenchResult {
+    double nsPerOp;
+    double bytesPerOp;
+    double allocsPerOp;
+};
+
+// Keeps results observable so the calls aren't optimised away
+static volatile size_t g_sink;
+
+template <typename F>
+static BenchResult bench(const char* name, uint32_t iters, F&& op) {
+    for (uint32_t i = 0; i < iters / 10 + 1; i++) op(i);   // Warm up
+
+    // The empty asm is a compiler barrier, so a call whose inputs don't
+    // change is still made once per iteration instead of hoisted
+
+    uint64_t allocs0 = g_allocs.load();
+    uint64_t bytes0 = g_allocBytes.load();
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iters; i++) {
+        op(i);
+        asm volatile("" ::: "memory");
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    BenchResult r;
+    r.nsPerOp = std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+    r.bytesPerOp = (double)(g_allocBytes.load() - bytes0) / iters;
+    r.allocsPerOp = (double)(g_allocs.load() - allocs0) / iters;
+    printf("BENCH %-34s %12.1f ns/op %8.1f B/op %6.2f allocs/op\n",
+           name, r.nsPerOp, r.bytesPerOp, r.allocsPerOp);
+    return r;
+}
+
+#define ASSERT_NO_ALLOC(r) TEST_ASSERT_EQUAL_FLOAT(0.0f, (float)(r).allocsPerOp)
+
+// --------------------------------------------------------------------------
+// Fixtures
+// --------------------------------------------------------------------------
+
+using namespace bbq_protocol;
+
+static DataPayload makePayload(uint32_t i) {
+    DataPayload d = {};
+    d.ts = 1700000000 + i * 5;
+    d.temp[PROBE_PIT] = 225.0f + (float)(i % 7) * 0.1f;
+    d.temp[PROBE_MEAT1] = 150.0f + (float)(i % 50) * 0.1f;
+    d.temp[PROBE_MEAT2] = NAN;
+    d.fan = (uint8_t)(40 + i % 5);
+    d.damper = 60;
+    d.sp = 225.0f;
+    d.meatTarget[0] = 203.0f;
+    d.est = 1700030000;
+    d.estLow = 1700028000;
+    d.estHigh = 1700032000;
+    d.fanMode = "fan_and_damper";
+    d.errors[0] = "Meat 2 probe disconnected";
+    d.errorCount = 1;
+    return d;
+}
+
+static std::vector<HistoryPoint> makeHistory(size_t count) {
+    std::vector<HistoryPoint> points(count);
+    for (size_t i = 0; i < count; i++) {
+        HistoryPoint& p = points[i];
+        p.ts = 1700000000 + (uint32_t)i * 5;
+        p.temp[PROBE_PIT] = 225.0f + sinf((float)i * 0.01f) * 8.0f;
+        p.temp[PROBE_MEAT1] = 40.0f + (float)i * 0.02f;
+        p.temp[PROBE_MEAT2] = NAN;
+        p.fan = (uint8_t)(i % 100);
+        p.damper = (uint8_t)(100 - i % 100);
+        p.sp = 225.0f;
+        p.lid = (i % 500) < 3;
+    }
+    return points;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Protocol builders
+// --------------------------------------------------------------------------
+
+void bench_build_data_message(void) {
+    static char buf[DATA_MESSAGE_MAX_BYTES];
+    BenchResult r = bench("buildDataMessage", 200000, [](uint32_t i) {
+        DataPayload d = makePayload(i);
+        g_sink = buildDataMessage(buf, sizeof(buf), d);
+    });
+    ASSERT_NO_ALLOC(r);
+}
+
+void bench_build_binary_delta(void) {
+    static uint8_t buf[BIN_MAX_FRAME];
+    static BinaryDeltaState state;
+    resetBinaryState(state);
+    BenchResult r = bench("buildBinaryDelta (steady)", 500000, [](uint32_t i) {
+        DataPayload d = makePayload(i);
+        g_sink = buildBinaryDelta(buf, sizeof(buf), d, state, false);
+    });
+    ASSERT_NO_ALLOC(r);
+}
+
+static void benchHistory(const char* name, size_t count, uint32_t iters) {
+    std::vector<HistoryPoint> points = makeHistory(count);
+    std::vector<char> buf(historyMessageMaxBytes(count));
+    const float targets[NUM_MEATS] = { 203.0f };
+    BenchResult r = bench(name, iters, [&](uint32_t) {
+        g_sink = buildHistoryMessage(buf.data(), buf.size(), points.data(), points.size(),
+                                     225.0f, targets);
+    });
+    TEST_ASSERT_TRUE(g_sink > 0);
+    printf("      %-34s %12.1f ns/point\n", "", r.nsPerOp / count);
+    ASSERT_NO_ALLOC(r);
+}
+
+void bench_build_history_600(void)   { benchHistory("buildHistoryMessage (600)", 600, 400); }
+void bench_build_history_5000(void)  { benchHistory("buildHistoryMessage (5000)", 5000, 50); }
+void bench_build_history_20000(void) { benchHistory("buildHistoryMessage (20000)", 20000, 12); }
+
+// --------------------------------------------------------------------------
+// Graph history
+// --------------------------------------------------------------------------
+
+static void benchGraph(const char* name, GraphCondense mode) {
+    static GraphHistory graph;
+    graph = GraphHistory(mode);
+    // Condenses every GRAPH_HISTORY_SIZE / 2 points once full
+    BenchResult r = bench(name, 200000, [](uint32_t i) {
+        float t = (float)(i % 1000);
+        float temps[NUM_PROBES] = { 225.0f + t * 0.01f, 100.0f + t * 0.1f };
+        bool disc[NUM_PROBES] = { false, false, true };
+        g_sink = graph.addPoint(temps, disc, 225.0f);
+    });
+    ASSERT_NO_ALLOC(r);
+}
+
+void bench_graph_add_point_average(void) {
+    benchGraph("GraphHistory::addPoint (average)", GraphCondense::AVERAGE);
+}
+
+void bench_graph_add_point_envelope(void) {
+    benchGraph("GraphHistory::addPoint (envelope)", GraphCondense::ENVELOPE);
+}
+
+// --------------------------------------------------------------------------
+// Predictor, split range, conversion
+// --------------------------------------------------------------------------
+
+void bench_predictor_slope(void) {
+    static TempPredictor predictor;
+    predictor.begin();
+    predictor.setTarget(PREDICTOR_MEAT1, 203.0f);
+    for (uint32_t i = 0; i < 400; i++) {
+        predictor.addSample(0, 1700000000 + i * 5, 100.0f + i * 0.05f, 225.0f);
+    }
+    predictor.setCurrentTime(1700002000);
+
+    // getRate() is computeSlope() scaled to degrees per minute
+    float acc = 0.0f;
+    BenchResult r = bench("TempPredictor::computeSlope", 2000000, [&](uint32_t) {
+        acc += predictor.getRate(PREDICTOR_MEAT1);
+    });
+    TEST_ASSERT_TRUE(acc > 0.0f);
+    ASSERT_NO_ALLOC(r);
+}
+
+void bench_split_range(void) {
+    static const FanMode modes[] = { FanMode::FAN_ONLY, FanMode::FAN_AND_DAMPER, FanMode::DAMPER_PRIMARY };
+    float acc = 0.0f;
+    BenchResult r = bench("splitRange", 5000000, [&](uint32_t i) {
+        SplitRangeOutput o = splitRange((float)(i % 101), modes[i % 3], 30.0f);
+        acc += o.fanPercent + o.damperPercent;
+    });
+    g_sink = (size_t)acc;
+    ASSERT_NO_ALLOC(r);
+}
+
+static void benchConversion(const char* name, bool lut) {
+    static TempManager tm;
+    tm.begin();
+    tm.setUseLookupTable(lut);
+    BenchResult r = bench(name, 1000000, [](uint32_t i) {
+        // Sweep the usable raw range so the table is exercised end to end
+        tm.injectRawADC((uint8_t)(i % NUM_PROBES), (int16_t)(2000 + (i * 37) % 24000));
+    });
+    g_sink = (size_t)tm.getTemp(0);
+    ASSERT_NO_ALLOC(r);
+}
+
+void bench_conversion_steinhart(void) {
+    benchConversion("Steinhart-Hart (direct)", false);
+}
+
+void bench_conversion_lookup(void) {
+    benchConversion("Steinhart-Hart (lookup table)", true);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(bench_build_data_message);
+    RUN_TEST(bench_build_binary_delta);
+    RUN_TEST(bench_build_history_600);
+    RUN_TEST(bench_build_history_5000);
+    RUN_TEST(bench_build_history_20000);
+    RUN_TEST(bench_graph_add_point_average);
+    RUN_TEST(bench_graph_add_point_envelope);
+    RUN_TEST(bench_predictor_slope);
+    RUN_TEST(bench_split_range);
+    RUN_TEST(bench_conversion_steinhart);
+    RUN_TEST(bench_conversion_lookup);
+
+    return UNITY_END();
+}
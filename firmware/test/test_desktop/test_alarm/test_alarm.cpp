@@ -38,6 +38,15 @@ static bool hasAlarm(AlarmManager& mgr, AlarmType type) {
 
 static AlarmManager* alarm;
 
+// Pit, meat1 and meat2 temps; further meat channels read 0 (not connected)
+static void updateAlarms(float pitTemp, float meat1Temp, float meat2Temp,
+                         float setpoint, bool pitReached) {
+    float meats[NUM_MEATS] = {};
+    meats[0] = meat1Temp;
+    meats[1] = meat2Temp;
+    alarm->update(pitTemp, meats, setpoint, pitReached);
+}
+
 void setUp(void) {
     alarm = new AlarmManager();
     alarm->begin();
@@ -65,8 +74,8 @@ void test_initial_pit_band_default(void) {
 }
 
 void test_initial_meat_targets_zero(void) {
-    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, alarm->getMeat1Target());
-    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, alarm->getMeat2Target());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, alarm->getMeatTarget(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, alarm->getMeatTarget(1));
 }
 
 // --------------------------------------------------------------------------
@@ -78,7 +87,7 @@ void test_pit_alarm_not_active_during_rampup(void) {
 
     // During ramp-up, pitReached is false. Even if temp is out of band,
     // pit alarm should not trigger.
-    alarm->update(200.0f, 0.0f, 0.0f, setpoint, false);
+    updateAlarms(200.0f, 0.0f, 0.0f, setpoint, false);
     TEST_ASSERT_FALSE(alarm->isAlarming());
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::PIT_LOW));
@@ -87,7 +96,7 @@ void test_pit_alarm_not_active_during_rampup(void) {
 void test_pit_alarm_not_active_when_temp_way_above_during_rampup(void) {
     float setpoint = 250.0f;
     // Even with pitTemp above setpoint+band, should not alarm if pitReached=false
-    alarm->update(300.0f, 0.0f, 0.0f, setpoint, false);
+    updateAlarms(300.0f, 0.0f, 0.0f, setpoint, false);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 }
 
@@ -100,7 +109,7 @@ void test_pit_alarm_high_triggers(void) {
     float pitBand = ALARM_PIT_BAND_DEFAULT;  // 15F
 
     // Pit has reached setpoint (pitReached=true), temp is above band
-    alarm->update(setpoint + pitBand + 1.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(setpoint + pitBand + 1.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(alarm->isAlarming());
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 }
@@ -110,7 +119,7 @@ void test_pit_alarm_low_triggers(void) {
     float pitBand = ALARM_PIT_BAND_DEFAULT;  // 15F
 
     // Pit has reached setpoint, temp dropped below band
-    alarm->update(setpoint - pitBand - 1.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(setpoint - pitBand - 1.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(alarm->isAlarming());
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_LOW));
 }
@@ -120,10 +129,10 @@ void test_pit_alarm_within_band_no_trigger(void) {
     float pitBand = ALARM_PIT_BAND_DEFAULT;  // 15F
 
     // Temp is within band, should not alarm
-    alarm->update(setpoint + pitBand - 1.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(setpoint + pitBand - 1.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 
-    alarm->update(setpoint - pitBand + 1.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(setpoint - pitBand + 1.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 }
 
@@ -133,7 +142,7 @@ void test_pit_alarm_exactly_at_band_no_trigger(void) {
 
     // Exactly at the band edge: setpoint + pitBand = 265. The condition
     // is pitTemp > setpoint + pitBand, so exactly at the edge should NOT trigger.
-    alarm->update(setpoint + pitBand, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(setpoint + pitBand, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 }
 
@@ -145,11 +154,11 @@ void test_pit_alarm_clears_when_back_in_band(void) {
     float setpoint = 250.0f;
 
     // Trigger pit high alarm
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(alarm->isAlarming());
 
     // Return to within band
-    alarm->update(255.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(255.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 }
@@ -158,15 +167,15 @@ void test_pit_alarm_can_retrigger_after_recovery(void) {
     float setpoint = 250.0f;
 
     // Trigger pit high
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 
     // Return to band (clears _pitTriggered and removes alarm)
-    alarm->update(255.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(255.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 
     // Go out of band again: should re-trigger
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 }
 
@@ -180,7 +189,7 @@ void test_custom_pit_band(void) {
 
     float setpoint = 250.0f;
     // With 5F band, 256F should trigger (> 255)
-    alarm->update(256.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(256.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(alarm->isAlarming());
 }
 
@@ -201,47 +210,47 @@ void test_setPitBand_rejects_negative(void) {
 // --------------------------------------------------------------------------
 
 void test_meat1_alarm_triggers_at_target(void) {
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 200.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 200.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
     TEST_ASSERT_TRUE(alarm->isAlarming());
 }
 
 void test_meat1_alarm_triggers_above_target(void) {
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 205.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 205.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
 }
 
 void test_meat1_alarm_not_triggered_below_target(void) {
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 195.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 195.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
 }
 
 void test_meat2_alarm_triggers_at_target(void) {
-    alarm->setMeat2Target(165.0f);
-    alarm->update(250.0f, 0.0f, 165.0f, 250.0f, true);
+    alarm->setMeatTarget(1, 165.0f);
+    updateAlarms(250.0f, 0.0f, 165.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT2_DONE));
 }
 
 void test_meat2_alarm_not_triggered_below_target(void) {
-    alarm->setMeat2Target(165.0f);
-    alarm->update(250.0f, 0.0f, 160.0f, 250.0f, true);
+    alarm->setMeatTarget(1, 165.0f);
+    updateAlarms(250.0f, 0.0f, 160.0f, 250.0f, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT2_DONE));
 }
 
 void test_meat_alarm_no_trigger_when_target_is_zero(void) {
     // Target 0 means not set; should not trigger
-    alarm->update(250.0f, 300.0f, 300.0f, 250.0f, true);
+    updateAlarms(250.0f, 300.0f, 300.0f, 250.0f, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT2_DONE));
 }
 
 void test_meat_alarm_no_trigger_when_temp_is_zero(void) {
     // Temp 0 means probe disconnected; should not trigger
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 0.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 0.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
 }
 
@@ -250,10 +259,10 @@ void test_meat_alarm_no_trigger_when_temp_is_zero(void) {
 // --------------------------------------------------------------------------
 
 void test_meat1_no_retrigger_after_acknowledge(void) {
-    alarm->setMeat1Target(200.0f);
+    alarm->setMeatTarget(0, 200.0f);
 
     // Trigger
-    alarm->update(250.0f, 200.0f, 0.0f, 250.0f, true);
+    updateAlarms(250.0f, 200.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
 
     // Acknowledge
@@ -261,38 +270,38 @@ void test_meat1_no_retrigger_after_acknowledge(void) {
     TEST_ASSERT_FALSE(alarm->isAlarming());
 
     // Same conditions: should NOT re-trigger because _meat1Triggered is true
-    alarm->update(250.0f, 205.0f, 0.0f, 250.0f, true);
+    updateAlarms(250.0f, 205.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
     TEST_ASSERT_FALSE(alarm->isAlarming());
 }
 
 void test_meat2_no_retrigger_after_acknowledge(void) {
-    alarm->setMeat2Target(165.0f);
+    alarm->setMeatTarget(1, 165.0f);
 
     // Trigger
-    alarm->update(250.0f, 0.0f, 170.0f, 250.0f, true);
+    updateAlarms(250.0f, 0.0f, 170.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT2_DONE));
 
     // Acknowledge
     alarm->acknowledge();
 
     // Should not re-trigger
-    alarm->update(250.0f, 0.0f, 175.0f, 250.0f, true);
+    updateAlarms(250.0f, 0.0f, 175.0f, 250.0f, true);
     TEST_ASSERT_FALSE(hasAlarm(*alarm, AlarmType::MEAT2_DONE));
 }
 
 void test_meat_alarm_retriggers_after_new_target_set(void) {
-    alarm->setMeat1Target(200.0f);
+    alarm->setMeatTarget(0, 200.0f);
 
     // Trigger and acknowledge
-    alarm->update(250.0f, 200.0f, 0.0f, 250.0f, true);
+    updateAlarms(250.0f, 200.0f, 0.0f, 250.0f, true);
     alarm->acknowledge();
 
     // Set a new target -- this should reset _meat1Triggered
-    alarm->setMeat1Target(210.0f);
+    alarm->setMeatTarget(0, 210.0f);
 
     // Now reaching the new target should trigger again
-    alarm->update(250.0f, 210.0f, 0.0f, 250.0f, true);
+    updateAlarms(250.0f, 210.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
 }
 
@@ -301,8 +310,8 @@ void test_meat_alarm_retriggers_after_new_target_set(void) {
 // --------------------------------------------------------------------------
 
 void test_acknowledge_silences(void) {
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 200.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 200.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_TRUE(alarm->isAlarming());
 
     alarm->acknowledge();
@@ -310,10 +319,10 @@ void test_acknowledge_silences(void) {
 }
 
 void test_acknowledge_clears_active_alarms(void) {
-    alarm->setMeat1Target(200.0f);
-    alarm->setMeat2Target(165.0f);
+    alarm->setMeatTarget(0, 200.0f);
+    alarm->setMeatTarget(1, 165.0f);
 
-    alarm->update(250.0f, 200.0f, 170.0f, 250.0f, true);
+    updateAlarms(250.0f, 200.0f, 170.0f, 250.0f, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT2_DONE));
 
@@ -332,7 +341,7 @@ void test_pit_alarm_no_retrigger_after_acknowledge_while_still_out(void) {
     float setpoint = 250.0f;
 
     // Trigger pit high
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 
     // Acknowledge
@@ -340,7 +349,7 @@ void test_pit_alarm_no_retrigger_after_acknowledge_while_still_out(void) {
     TEST_ASSERT_FALSE(alarm->isAlarming());
 
     // Still out of band -- should NOT re-trigger because _pitTriggered is true
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 }
 
@@ -348,18 +357,18 @@ void test_pit_alarm_retriggers_after_return_and_deviate_again(void) {
     float setpoint = 250.0f;
 
     // Trigger pit high
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
 
     // Acknowledge
     alarm->acknowledge();
 
     // Return to band -- this clears _pitTriggered
-    alarm->update(255.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(255.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 
     // Go out of band again -- should re-trigger
-    alarm->update(270.0f, 0.0f, 0.0f, setpoint, true);
+    updateAlarms(270.0f, 0.0f, 0.0f, setpoint, true);
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
     TEST_ASSERT_TRUE(alarm->isAlarming());
 }
@@ -370,8 +379,8 @@ void test_pit_alarm_retriggers_after_return_and_deviate_again(void) {
 
 void test_disabled_no_alarms(void) {
     alarm->setEnabled(false);
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 200.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 200.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_FALSE(alarm->isAlarming());
 }
 
@@ -380,8 +389,8 @@ void test_reenable_allows_alarms(void) {
     alarm->setEnabled(true);
     TEST_ASSERT_TRUE(alarm->isEnabled());
 
-    alarm->setMeat1Target(200.0f);
-    alarm->update(250.0f, 200.0f, 0.0f, 250.0f, true);
+    alarm->setMeatTarget(0, 200.0f);
+    updateAlarms(250.0f, 200.0f, 0.0f, 250.0f, true);
     TEST_ASSERT_TRUE(alarm->isAlarming());
 }
 
@@ -390,11 +399,11 @@ void test_reenable_allows_alarms(void) {
 // --------------------------------------------------------------------------
 
 void test_multiple_alarms_simultaneously(void) {
-    alarm->setMeat1Target(200.0f);
-    alarm->setMeat2Target(165.0f);
+    alarm->setMeatTarget(0, 200.0f);
+    alarm->setMeatTarget(1, 165.0f);
 
     // Trigger both meat alarms and a pit alarm
-    alarm->update(270.0f, 200.0f, 170.0f, 250.0f, true);
+    updateAlarms(270.0f, 200.0f, 170.0f, 250.0f, true);
 
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::PIT_HIGH));
     TEST_ASSERT_TRUE(hasAlarm(*alarm, AlarmType::MEAT1_DONE));
@@ -405,6 +414,24 @@ void test_multiple_alarms_simultaneously(void) {
     TEST_ASSERT_EQUAL_UINT8(3, count);
 }
 
+void test_every_meat_channel_has_a_done_alarm(void) {
+    float meats[NUM_MEATS];
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        alarm->setMeatTarget(m, 160.0f + m);
+        meats[m] = 170.0f;
+    }
+    alarm->update(250.0f, meats, 250.0f, true);
+
+    AlarmType alarms[MAX_ACTIVE_ALARMS];
+    TEST_ASSERT_EQUAL_UINT8(NUM_MEATS, alarm->getActiveAlarms(alarms, MAX_ACTIVE_ALARMS));
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        TEST_ASSERT_TRUE(hasAlarm(*alarm, alarmMeatDone(m)));
+        TEST_ASSERT_EQUAL_UINT8(m, alarmMeatIndex(alarmMeatDone(m)));
+    }
+    TEST_ASSERT_EQUAL(AlarmType::MEAT2_DONE, alarmMeatDone(1));
+    TEST_ASSERT_EQUAL_UINT8(NUM_MEATS, alarmMeatIndex(AlarmType::PIT_HIGH));
+}
+
 // --------------------------------------------------------------------------
 // Main
 // --------------------------------------------------------------------------
@@ -465,6 +492,7 @@ int main(int argc, char** argv) {
 
     // Multiple simultaneous
     RUN_TEST(test_multiple_alarms_simultaneously);
+    RUN_TEST(test_every_meat_channel_has_a_done_alarm);
 
     return UNITY_END();
 }
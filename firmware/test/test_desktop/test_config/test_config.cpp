@@ -0,0 +1,148 @@
+/**
+ * test_config.cpp
+ *
+ * Tests for the ConfigManager deferred save on the native platform.
+ *
+ * Covers when saveDue() fires (debounce after the last change, cap after
+ * the first), skipping a write when the config is back to what's on
+ * flash, and the backoff after a failed write: the config stays dirty and
+ * the retry waits out another CONFIG_SAVE_DEBOUNCE_MS.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+
+#include "config_manager.h"
+#include "config_manager.cpp"
+
+static ConfigManager* config;
+
+void setUp(void) {
+    config = new ConfigManager();
+}
+
+void tearDown(void) {
+    delete config;
+    config = nullptr;
+}
+
+// Change a value at ms, as a setter from the web UI would
+static void changeAt(unsigned long ms, float band) {
+    config->setNowMs(ms);
+    config->setAlarmPitBand(band);
+}
+
+static bool saveAt(unsigned long ms) {
+    config->setNowMs(ms);
+    return config->saveSnapshot(config->getConfig(), config->changeSeq());
+}
+
+// --------------------------------------------------------------------------
+// Debounce
+// --------------------------------------------------------------------------
+
+void test_clean_config_is_never_due(void) {
+    TEST_ASSERT_FALSE(config->isDirty());
+    TEST_ASSERT_FALSE(config->saveDue(CONFIG_SAVE_MAX_DELAY_MS * 2));
+}
+
+void test_unchanged_value_does_not_dirty(void) {
+    changeAt(1000, config->getAlarmPitBand());
+    TEST_ASSERT_FALSE(config->isDirty());
+}
+
+void test_due_after_debounce(void) {
+    changeAt(1000, 20.0f);
+    TEST_ASSERT_TRUE(config->isDirty());
+    TEST_ASSERT_FALSE(config->saveDue(1000 + CONFIG_SAVE_DEBOUNCE_MS - 1));
+    TEST_ASSERT_TRUE(config->saveDue(1000 + CONFIG_SAVE_DEBOUNCE_MS));
+}
+
+void test_changes_push_debounce_out_up_to_cap(void) {
+    // A change every half debounce never goes quiet; the cap forces a save
+    unsigned long t = 1000;
+    float band = 20.0f;
+    for (; t < 1000 + CONFIG_SAVE_MAX_DELAY_MS; t += CONFIG_SAVE_DEBOUNCE_MS / 2) {
+        changeAt(t, band += 1.0f);
+        TEST_ASSERT_FALSE(config->saveDue(t + CONFIG_SAVE_DEBOUNCE_MS / 2 - 1));
+    }
+    TEST_ASSERT_TRUE(config->saveDue(1000 + CONFIG_SAVE_MAX_DELAY_MS));
+}
+
+void test_save_clears_dirty(void) {
+    changeAt(1000, 20.0f);
+    TEST_ASSERT_TRUE(saveAt(1000 + CONFIG_SAVE_DEBOUNCE_MS));
+    TEST_ASSERT_FALSE(config->isDirty());
+    TEST_ASSERT_FALSE(config->saveDue(1000 + CONFIG_SAVE_MAX_DELAY_MS * 2));
+}
+
+void test_changed_back_skips_write(void) {
+    float band = config->getAlarmPitBand();
+    changeAt(1000, band + 5.0f);
+    changeAt(1100, band);
+    TEST_ASSERT_TRUE(config->isDirty());
+
+    // Matches flash, so there's nothing to write even with writes failing
+    config->setWriteFails(true);
+    TEST_ASSERT_TRUE(saveAt(1100 + CONFIG_SAVE_DEBOUNCE_MS));
+    TEST_ASSERT_FALSE(config->isDirty());
+}
+
+// --------------------------------------------------------------------------
+// Failed writes
+// --------------------------------------------------------------------------
+
+void test_failed_write_stays_dirty(void) {
+    changeAt(1000, 20.0f);
+    config->setWriteFails(true);
+    TEST_ASSERT_FALSE(saveAt(1000 + CONFIG_SAVE_DEBOUNCE_MS));
+    TEST_ASSERT_TRUE(config->isDirty());
+}
+
+void test_failed_write_backs_off_one_debounce(void) {
+    changeAt(1000, 20.0f);
+    config->setWriteFails(true);
+
+    // Failed on the save forced by the cap, which would otherwise stay due
+    unsigned long failedAt = 1000 + CONFIG_SAVE_MAX_DELAY_MS;
+    TEST_ASSERT_FALSE(saveAt(failedAt));
+
+    TEST_ASSERT_FALSE(config->saveDue(failedAt));
+    TEST_ASSERT_FALSE(config->saveDue(failedAt + CONFIG_SAVE_DEBOUNCE_MS - 1));
+    TEST_ASSERT_TRUE(config->saveDue(failedAt + CONFIG_SAVE_DEBOUNCE_MS));
+}
+
+void test_retry_after_backoff_saves(void) {
+    changeAt(1000, 20.0f);
+    config->setWriteFails(true);
+    unsigned long failedAt = 1000 + CONFIG_SAVE_DEBOUNCE_MS;
+    TEST_ASSERT_FALSE(saveAt(failedAt));
+
+    config->setWriteFails(false);
+    unsigned long retryAt = failedAt + CONFIG_SAVE_DEBOUNCE_MS;
+    TEST_ASSERT_TRUE(config->saveDue(retryAt));
+    TEST_ASSERT_TRUE(saveAt(retryAt));
+    TEST_ASSERT_FALSE(config->isDirty());
+    TEST_ASSERT_FALSE(config->saveDue(retryAt + CONFIG_SAVE_MAX_DELAY_MS));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_clean_config_is_never_due);
+    RUN_TEST(test_unchanged_value_does_not_dirty);
+    RUN_TEST(test_due_after_debounce);
+    RUN_TEST(test_changes_push_debounce_out_up_to_cap);
+    RUN_TEST(test_save_clears_dirty);
+    RUN_TEST(test_changed_back_skips_write);
+
+    RUN_TEST(test_failed_write_stays_dirty);
+    RUN_TEST(test_failed_write_backs_off_one_debounce);
+    RUN_TEST(test_retry_after_backoff_saves);
+
+    return UNITY_END();
+}
@@ -0,0 +1,270 @@
+/**
+ * test_control_zone.cpp
+ *
+ * Tests for ControlZone on the native platform.
+ *
+ * The fan and servo hardware writes are compiled out under NATIVE_BUILD,
+ * so a zone runs its PID, split-range and actuator state on host. Covers:
+ *   - PID sample gating
+ *   - Setpoint change: feed-forward step, pit-reached reset, restore
+ *   - Disconnected probe: output holds, auto-tune cancelled
+ *   - Split-range table per fan mode, and fan-mode names
+ *   - Split-range onto the zone's own fan and damper
+ *   - Two zones stepping independently
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <math.h>
+
+// Include the actual module under test
+#include "control_zone.h"
+#include "control_zone.cpp"
+#include "pid_controller.cpp"
+#include "pid_autotune.cpp"
+#include "fan_controller.cpp"
+#include "servo_controller.cpp"
+#include "metrics.cpp"
+
+static ControlZone* zone;
+
+void setUp(void) {
+    zone = new ControlZone();
+    zone->pid().begin(4.0f, 0.02f, 5.0f);
+    zone->begin(PROBE_PIT, -1, FAN_PWM_CHANNEL, -1);
+    zone->startClock(0);
+}
+
+void tearDown(void) {
+    delete zone;
+    zone = nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Sample gating
+// --------------------------------------------------------------------------
+
+void test_compute_waits_for_sample_period(void) {
+    uint32_t ms = zone->pid().getSampleMs();
+    TEST_ASSERT_FALSE(zone->computeDue(ms - 1, 200.0f, true, FanMode::FAN_AND_DAMPER));
+    TEST_ASSERT_TRUE(zone->computeDue(ms, 200.0f, true, FanMode::FAN_AND_DAMPER));
+    TEST_ASSERT_FALSE(zone->computeDue(ms + 1, 200.0f, true, FanMode::FAN_AND_DAMPER));
+    TEST_ASSERT_TRUE(zone->computeDue(2 * ms, 200.0f, true, FanMode::FAN_AND_DAMPER));
+}
+
+void test_compute_drives_output_toward_setpoint(void) {
+    zone->setSetpoint(225.0f);
+    zone->restoreSetpoint(225.0f, false);
+    zone->computeDue(zone->pid().getSampleMs(), 150.0f, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_TRUE(zone->pid().getOutput() > 0.0f);
+}
+
+// --------------------------------------------------------------------------
+// Setpoint changes
+// --------------------------------------------------------------------------
+
+void test_default_setpoint(void) {
+    TEST_ASSERT_EQUAL_FLOAT(ZONE_DEFAULT_SETPOINT, zone->getSetpoint());
+    TEST_ASSERT_FALSE(zone->isPitReached());
+}
+
+void test_reaching_band_sets_pit_reached(void) {
+    uint32_t ms = zone->pid().getSampleMs();
+    zone->computeDue(ms, ZONE_DEFAULT_SETPOINT - ZONE_REACHED_BAND - 1.0f, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_FALSE(zone->isPitReached());
+    zone->computeDue(2 * ms, ZONE_DEFAULT_SETPOINT - 1.0f, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_TRUE(zone->isPitReached());
+}
+
+void test_setpoint_change_clears_pit_reached(void) {
+    uint32_t ms = zone->pid().getSampleMs();
+    zone->computeDue(ms, ZONE_DEFAULT_SETPOINT, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_TRUE(zone->isPitReached());
+
+    zone->setSetpoint(275.0f);
+    zone->computeDue(2 * ms, ZONE_DEFAULT_SETPOINT, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_FALSE(zone->isPitReached());
+}
+
+void test_setpoint_step_feeds_forward(void) {
+    uint32_t ms = zone->pid().getSampleMs();
+    zone->pid().setFeedForward(0.2f);
+    zone->computeDue(ms, ZONE_DEFAULT_SETPOINT - 2.0f, true, FanMode::FAN_AND_DAMPER);
+    float before = zone->pid().getOutput();
+
+    ControlZone steady;
+    steady.pid().begin(4.0f, 0.02f, 5.0f);
+    steady.pid().setFeedForward(0.2f);
+    steady.begin(PROBE_PIT, -1, FAN_PWM_CHANNEL, -1);
+    steady.restoreSetpoint(275.0f, false);
+    steady.computeDue(ms, ZONE_DEFAULT_SETPOINT - 2.0f, true, FanMode::FAN_AND_DAMPER);
+
+    zone->setSetpoint(275.0f);
+    zone->computeDue(2 * ms, ZONE_DEFAULT_SETPOINT - 2.0f, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_TRUE(zone->pid().getOutput() > before);
+    TEST_ASSERT_TRUE(zone->pid().getOutput() > steady.pid().getOutput());
+}
+
+void test_restore_setpoint_skips_step(void) {
+    zone->restoreSetpoint(250.0f, true);
+    TEST_ASSERT_EQUAL_FLOAT(250.0f, zone->getSetpoint());
+    zone->computeDue(zone->pid().getSampleMs(), 250.0f, true, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_TRUE(zone->isPitReached());
+}
+
+// --------------------------------------------------------------------------
+// Disconnected probe
+// --------------------------------------------------------------------------
+
+void test_disconnected_holds_output(void) {
+    uint32_t ms = zone->pid().getSampleMs();
+    zone->computeDue(ms, 150.0f, true, FanMode::FAN_AND_DAMPER);
+    float held = zone->pid().getOutput();
+    TEST_ASSERT_TRUE(zone->computeDue(2 * ms, 0.0f, false, FanMode::FAN_AND_DAMPER));
+    TEST_ASSERT_EQUAL_FLOAT(held, zone->pid().getOutput());
+    TEST_ASSERT_FALSE(zone->isPitReached());
+}
+
+void test_disconnected_cancels_autotune(void) {
+    zone->pid().startAutoTune(ZONE_DEFAULT_SETPOINT);
+    TEST_ASSERT_TRUE(zone->pid().isAutoTuning());
+    zone->computeDue(zone->pid().getSampleMs(), 0.0f, false, FanMode::FAN_AND_DAMPER);
+    TEST_ASSERT_FALSE(zone->pid().isAutoTuning());
+}
+
+// --------------------------------------------------------------------------
+// Split range
+// --------------------------------------------------------------------------
+
+// The per-mode curves are constexpr
+static_assert(splitRangeFanOnly(40.0f, 30.0f).damperPercent == 100.0f, "fan_only holds the damper open");
+static_assert(splitRangeFanAndDamper(20.0f, 30.0f).fanPercent == 0.0f, "fan off below threshold");
+
+void test_split_fan_only(void) {
+    SplitRangeOutput sr = splitRange(40.0f, FanMode::FAN_ONLY, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 40.0f, sr.fanPercent);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, sr.damperPercent);
+}
+
+void test_split_fan_and_damper(void) {
+    SplitRangeOutput sr = splitRange(20.0f, FanMode::FAN_AND_DAMPER, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, sr.fanPercent);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, sr.damperPercent);
+
+    sr = splitRange(65.0f, FanMode::FAN_AND_DAMPER, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f, sr.fanPercent);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 65.0f, sr.damperPercent);
+}
+
+void test_split_damper_primary(void) {
+    // Threshold floors at 50%
+    SplitRangeOutput sr = splitRange(45.0f, FanMode::DAMPER_PRIMARY, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, sr.fanPercent);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 45.0f, sr.damperPercent);
+
+    sr = splitRange(75.0f, FanMode::DAMPER_PRIMARY, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f, sr.fanPercent);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, sr.damperPercent);
+
+    sr = splitRange(70.0f, FanMode::DAMPER_PRIMARY, 60.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 25.0f, sr.fanPercent);
+}
+
+void test_split_out_of_range_mode_uses_default(void) {
+    SplitRangeOutput sr = splitRange(65.0f, (FanMode)7, 30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f, sr.fanPercent);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 65.0f, sr.damperPercent);
+}
+
+void test_fan_mode_names(void) {
+    for (uint8_t i = 0; i < FAN_MODE_COUNT; i++) {
+        FanMode m = FanMode::COUNT;
+        TEST_ASSERT_TRUE(fanModeFromName(fanModeName((FanMode)i), m));
+        TEST_ASSERT_EQUAL_UINT8(i, (uint8_t)m);
+    }
+    TEST_ASSERT_TRUE(FanMode::DAMPER_PRIMARY == fanModeParse("damper_primary"));
+    TEST_ASSERT_TRUE(FanMode::FAN_AND_DAMPER == fanModeParse("turbo"));
+    TEST_ASSERT_TRUE(FanMode::FAN_AND_DAMPER == fanModeParse(nullptr));
+    TEST_ASSERT_EQUAL_STRING("fan_and_damper", fanModeName(FanMode::COUNT));
+}
+
+// --------------------------------------------------------------------------
+// Actuation
+// --------------------------------------------------------------------------
+
+void test_actuate_damper_primary_opens_damper_first(void) {
+    zone->servo().setSlewRate(0.0f);   // Jump, so the position is the split-range's
+    zone->computeDue(zone->pid().getSampleMs(), 150.0f, true, FanMode::DAMPER_PRIMARY);
+    float out = zone->pid().getOutput();
+    zone->actuate(FanMode::DAMPER_PRIMARY, (float)FAN_ON_THRESHOLD);
+
+    SplitRangeOutput sr = splitRange(out, FanMode::DAMPER_PRIMARY, (float)FAN_ON_THRESHOLD);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, sr.damperPercent, zone->servo().getCurrentPositionPct());
+    TEST_ASSERT_TRUE(zone->servo().getCurrentPositionPct() > 0.0f);
+}
+
+void test_actuate_zero_output_closes_everything(void) {
+    zone->actuate(FanMode::FAN_AND_DAMPER, (float)FAN_ON_THRESHOLD);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, zone->fan().getCurrentSpeedPct());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, zone->servo().getCurrentPositionPct());
+}
+
+// --------------------------------------------------------------------------
+// Independent zones
+// --------------------------------------------------------------------------
+
+void test_zones_run_independently(void) {
+    ControlZone other;
+    other.pid().begin(4.0f, 0.02f, 5.0f);
+    other.begin(PROBE_MEAT1, -1, FAN_PWM_CHANNEL + 1, -1);
+    other.startClock(0);
+    other.setSetpoint(160.0f);
+
+    uint32_t ms = zone->pid().getSampleMs();
+    zone->computeDue(ms, 150.0f, true, FanMode::FAN_AND_DAMPER);
+    other.computeDue(ms, 160.0f, true, FanMode::FAN_AND_DAMPER);
+
+    TEST_ASSERT_EQUAL_UINT8(PROBE_MEAT1, other.getProbe());
+    TEST_ASSERT_TRUE(zone->pid().getOutput() > other.pid().getOutput());
+    TEST_ASSERT_TRUE(other.isPitReached());
+    TEST_ASSERT_FALSE(zone->isPitReached());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Sample gating
+    RUN_TEST(test_compute_waits_for_sample_period);
+    RUN_TEST(test_compute_drives_output_toward_setpoint);
+
+    // Setpoint changes
+    RUN_TEST(test_default_setpoint);
+    RUN_TEST(test_reaching_band_sets_pit_reached);
+    RUN_TEST(test_setpoint_change_clears_pit_reached);
+    RUN_TEST(test_setpoint_step_feeds_forward);
+    RUN_TEST(test_restore_setpoint_skips_step);
+
+    // Disconnected probe
+    RUN_TEST(test_disconnected_holds_output);
+    RUN_TEST(test_disconnected_cancels_autotune);
+
+    // Split range
+    RUN_TEST(test_split_fan_only);
+    RUN_TEST(test_split_fan_and_damper);
+    RUN_TEST(test_split_damper_primary);
+    RUN_TEST(test_split_out_of_range_mode_uses_default);
+    RUN_TEST(test_fan_mode_names);
+
+    // Actuation
+    RUN_TEST(test_actuate_damper_primary_opens_damper_first);
+    RUN_TEST(test_actuate_zero_output_closes_everything);
+
+    // Independent zones
+    RUN_TEST(test_zones_run_independently);
+
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+/**
+ * test_controller_state.cpp
+ *
+ * Tests for the warm-restart controller checkpoint on the native platform.
+ *
+ * Covers sealing and validation (CRC, framing, version), and choosing the
+ * image to resume from between the RTC and flash copies.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "controller_state.h"
+#include "controller_state.cpp"
+#include "session_log.cpp"
+
+static ControllerState state;
+
+static void makeState(ControllerState& s, uint32_t sessionStart, float setpoint) {
+    memset(&s, 0, sizeof(s));
+    s.sessionStart = sessionStart;
+    s.setpoint     = setpoint;
+    s.meatTarget[0] = 203.0f;
+    s.fahrenheit   = 1;
+    s.pid.outputSum = 42.0f;
+    controllerStateSeal(s);
+}
+
+void setUp(void) {
+    makeState(state, 1700000000, 250.0f);
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Seal / validate
+// --------------------------------------------------------------------------
+
+void test_sealed_state_is_valid(void) {
+    TEST_ASSERT_TRUE(controllerStateValid(state));
+    TEST_ASSERT_EQUAL_UINT32(CONTROLLER_STATE_MAGIC, state.magic);
+    TEST_ASSERT_EQUAL_UINT32(1, state.seq);
+}
+
+void test_uninitialised_memory_is_invalid(void) {
+    ControllerState s;
+    memset(&s, 0xA5, sizeof(s));
+    TEST_ASSERT_FALSE(controllerStateValid(s));
+    memset(&s, 0, sizeof(s));
+    TEST_ASSERT_FALSE(controllerStateValid(s));
+}
+
+void test_corruption_is_detected(void) {
+    state.pid.outputSum = 43.0f;
+    TEST_ASSERT_FALSE(controllerStateValid(state));
+}
+
+void test_other_version_is_rejected(void) {
+    state.version = CONTROLLER_STATE_VERSION + 1;
+    state.crc = sessionCrc32(&state, offsetof(ControllerState, crc));
+    TEST_ASSERT_FALSE(controllerStateValid(state));
+}
+
+void test_seal_bumps_seq(void) {
+    controllerStateSeal(state);
+    controllerStateSeal(state);
+    TEST_ASSERT_EQUAL_UINT32(3, state.seq);
+    TEST_ASSERT_TRUE(controllerStateValid(state));
+}
+
+// --------------------------------------------------------------------------
+// Picking the image to resume from
+// --------------------------------------------------------------------------
+
+void test_pick_requires_matching_session(void) {
+    TEST_ASSERT_EQUAL_PTR(&state, controllerStatePick(&state, nullptr, 1700000000, true));
+    TEST_ASSERT_NULL(controllerStatePick(&state, nullptr, 1700000005, true));
+    TEST_ASSERT_NULL(controllerStatePick(&state, nullptr, 0, true));
+}
+
+void test_pick_requires_same_units(void) {
+    TEST_ASSERT_NULL(controllerStatePick(&state, nullptr, 1700000000, false));
+}
+
+void test_pick_prefers_newer_image(void) {
+    ControllerState flash = state;       // Mirrored at seq 1
+    controllerStateSeal(state);          // RTC moved on to seq 2
+    TEST_ASSERT_EQUAL_PTR(&state, controllerStatePick(&state, &flash, 1700000000, true));
+    TEST_ASSERT_EQUAL_PTR(&state, controllerStatePick(&flash, &state, 1700000000, true));
+}
+
+void test_pick_falls_back_to_valid_copy(void) {
+    ControllerState rtc;
+    memset(&rtc, 0xFF, sizeof(rtc));     // Lost with power
+    TEST_ASSERT_EQUAL_PTR(&state, controllerStatePick(&rtc, &state, 1700000000, true));
+    TEST_ASSERT_NULL(controllerStatePick(nullptr, nullptr, 1700000000, true));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_sealed_state_is_valid);
+    RUN_TEST(test_uninitialised_memory_is_invalid);
+    RUN_TEST(test_corruption_is_detected);
+    RUN_TEST(test_other_version_is_rejected);
+    RUN_TEST(test_seal_bumps_seq);
+    RUN_TEST(test_pick_requires_matching_session);
+    RUN_TEST(test_pick_requires_same_units);
+    RUN_TEST(test_pick_prefers_newer_image);
+    RUN_TEST(test_pick_falls_back_to_valid_copy);
+
+    return UNITY_END();
+}
@@ -0,0 +1,234 @@
+/**
+ * test_error_manager.cpp
+ *
+ * Tests for ErrorManager probe-fault tracking on the native platform.
+ *
+ * Covers open/short detection and recovery from ProbeState input, and the
+ * allocation-free accessors: getErrors() filling a caller buffer (with
+ * truncation) and getError() by index, the trend warnings mapped from
+ * TrendStatus, and the loop-overrun warning.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "error_manager.h"
+#include "error_manager.cpp"
+
+static ErrorManager* em;
+static ProbeState probes[NUM_PROBES];
+
+void setUp(void) {
+    em = new ErrorManager();
+    for (uint8_t i = 0; i < 3; i++) {
+        probes[i].connected    = true;
+        probes[i].openCircuit  = false;
+        probes[i].shortCircuit = false;
+        probes[i].temperature  = 150.0f;
+    }
+}
+
+void tearDown(void) {
+    delete em;
+    em = nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Probe faults
+// --------------------------------------------------------------------------
+
+void test_no_errors_when_probes_ok(void) {
+    em->update(probes);
+    TEST_ASSERT_EQUAL_UINT8(0, em->getErrorCount());
+    TEST_ASSERT_NULL(em->getError(0));
+}
+
+void test_open_probe_adds_error(void) {
+    probes[1].connected = false;
+    probes[1].openCircuit = true;
+    em->update(probes);
+
+    TEST_ASSERT_EQUAL_UINT8(1, em->getErrorCount());
+    const ErrorEntry* e = em->getError(0);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_INT((int)ErrorCode::PROBE_OPEN, (int)e->code);
+    TEST_ASSERT_EQUAL_UINT8(1, e->probeIndex);
+    TEST_ASSERT_EQUAL_STRING("Meat 1 probe disconnected", e->message);
+}
+
+void test_short_replaces_open_and_recovers(void) {
+    probes[2].openCircuit = true;
+    em->update(probes);
+    probes[2].openCircuit = false;
+    probes[2].shortCircuit = true;
+    em->update(probes);
+
+    TEST_ASSERT_EQUAL_UINT8(1, em->getErrorCount());
+    TEST_ASSERT_EQUAL_INT((int)ErrorCode::PROBE_SHORT, (int)em->getError(0)->code);
+
+    probes[2].shortCircuit = false;
+    em->update(probes);
+    TEST_ASSERT_EQUAL_UINT8(0, em->getErrorCount());
+}
+
+// --------------------------------------------------------------------------
+// getErrors() fill-buffer API
+// --------------------------------------------------------------------------
+
+void test_get_errors_fills_buffer_in_order(void) {
+    probes[0].openCircuit = true;
+    probes[2].shortCircuit = true;
+    em->update(probes);
+
+    ErrorEntry out[MAX_ERRORS];
+    uint8_t n = em->getErrors(out, MAX_ERRORS);
+    TEST_ASSERT_EQUAL_UINT8(2, n);
+    TEST_ASSERT_EQUAL_STRING("Pit probe disconnected", out[0].message);
+    TEST_ASSERT_EQUAL_STRING("Meat 2 probe shorted", out[1].message);
+}
+
+void test_get_errors_truncates_to_max(void) {
+    for (uint8_t i = 0; i < 3; i++) probes[i].openCircuit = true;
+    em->update(probes);
+
+    ErrorEntry out[2];
+    memset(out, 0, sizeof(out));
+    uint8_t n = em->getErrors(out, 2);
+    TEST_ASSERT_EQUAL_UINT8(2, n);
+    TEST_ASSERT_EQUAL_UINT8(0, out[0].probeIndex);
+    TEST_ASSERT_EQUAL_UINT8(1, out[1].probeIndex);
+    TEST_ASSERT_EQUAL_UINT8(3, em->getErrorCount());
+}
+
+void test_get_errors_after_removal_compacts(void) {
+    for (uint8_t i = 0; i < 3; i++) probes[i].openCircuit = true;
+    em->update(probes);
+    probes[0].openCircuit = false;
+    em->update(probes);
+
+    ErrorEntry out[MAX_ERRORS];
+    uint8_t n = em->getErrors(out, MAX_ERRORS);
+    TEST_ASSERT_EQUAL_UINT8(2, n);
+    TEST_ASSERT_EQUAL_UINT8(1, out[0].probeIndex);
+    TEST_ASSERT_EQUAL_UINT8(2, out[1].probeIndex);
+    TEST_ASSERT_NULL(em->getError(2));
+}
+
+void test_get_errors_zero_max_copies_nothing(void) {
+    probes[0].openCircuit = true;
+    em->update(probes);
+    TEST_ASSERT_EQUAL_UINT8(0, em->getErrors(nullptr, 0));
+}
+
+// --------------------------------------------------------------------------
+// Trend warnings
+// --------------------------------------------------------------------------
+
+void test_trend_fire_out_adds_and_clears(void) {
+    TrendStatus trend = {};
+    trend.fireOut = true;
+    em->setTrend(trend);
+    em->update(probes);
+    TEST_ASSERT_TRUE(em->isFireOut());
+    TEST_ASSERT_EQUAL_STRING("Fire may be out", em->getError(0)->message);
+
+    trend.fireOut = false;
+    em->setTrend(trend);
+    em->update(probes);
+    TEST_ASSERT_FALSE(em->isFireOut());
+}
+
+void test_trend_fuel_and_done_soon_entries(void) {
+    TrendStatus trend = {};
+    trend.fuelLow = true;
+    trend.doneSoon[1] = true;
+    em->setTrend(trend);
+    em->update(probes);
+    TEST_ASSERT_EQUAL_UINT8(2, em->getErrorCount());
+    TEST_ASSERT_TRUE(em->hasError(ErrorCode::FUEL_LOW));
+    const ErrorEntry* e = em->getError(1);
+    TEST_ASSERT_EQUAL(ErrorCode::MEAT_DONE_SOON, e->code);
+    TEST_ASSERT_EQUAL_UINT8(PROBE_MEAT2, e->probeIndex);
+    TEST_ASSERT_EQUAL_STRING("Meat 2 done in ~15 min", e->message);
+
+    trend.doneSoon[1] = false;
+    em->setTrend(trend);
+    em->update(probes);
+    TEST_ASSERT_FALSE(em->hasError(ErrorCode::MEAT_DONE_SOON));
+    TEST_ASSERT_TRUE(em->hasError(ErrorCode::FUEL_LOW));
+}
+
+// --------------------------------------------------------------------------
+// Loop overrun
+// --------------------------------------------------------------------------
+
+void test_loop_overrun_names_phase_and_clears(void) {
+    em->setLoopOverrun("web");
+    em->update(probes);
+    TEST_ASSERT_TRUE(em->hasError(ErrorCode::LOOP_OVERRUN));
+    TEST_ASSERT_EQUAL_STRING("Loop slow: web over budget", em->getError(0)->message);
+
+    // A different phase replaces the entry instead of adding one
+    uint32_t rev = em->getRevision();
+    em->setLoopOverrun("lvgl");
+    em->update(probes);
+    TEST_ASSERT_EQUAL_UINT8(1, em->getErrorCount());
+    TEST_ASSERT_EQUAL_STRING("Loop slow: lvgl over budget", em->getError(0)->message);
+    TEST_ASSERT_TRUE(em->getRevision() != rev);
+
+    // Unchanged input leaves the list (and revision) alone
+    rev = em->getRevision();
+    em->update(probes);
+    TEST_ASSERT_EQUAL_UINT32(rev, em->getRevision());
+
+    em->setLoopOverrun(nullptr);
+    em->update(probes);
+    TEST_ASSERT_FALSE(em->hasError(ErrorCode::LOOP_OVERRUN));
+}
+
+void test_loop_overrun_returns_after_clear_all(void) {
+    em->setLoopOverrun("session");
+    em->update(probes);
+    em->clearAll();
+    em->update(probes);
+    TEST_ASSERT_TRUE(em->hasError(ErrorCode::LOOP_OVERRUN));
+}
+
+// --------------------------------------------------------------------------
+// Fan stall
+// --------------------------------------------------------------------------
+
+void test_fan_stall_adds_and_clears(void) {
+    em->setFanStalled(true);
+    em->update(probes);
+    TEST_ASSERT_TRUE(em->hasError(ErrorCode::FAN_STALL));
+    TEST_ASSERT_EQUAL_STRING("Fan stalled", em->getError(0)->message);
+
+    em->setFanStalled(false);
+    em->update(probes);
+    TEST_ASSERT_FALSE(em->hasError(ErrorCode::FAN_STALL));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_no_errors_when_probes_ok);
+    RUN_TEST(test_open_probe_adds_error);
+    RUN_TEST(test_short_replaces_open_and_recovers);
+    RUN_TEST(test_get_errors_fills_buffer_in_order);
+    RUN_TEST(test_get_errors_truncates_to_max);
+    RUN_TEST(test_get_errors_after_removal_compacts);
+    RUN_TEST(test_get_errors_zero_max_copies_nothing);
+    RUN_TEST(test_trend_fire_out_adds_and_clears);
+    RUN_TEST(test_trend_fuel_and_done_soon_entries);
+    RUN_TEST(test_loop_overrun_names_phase_and_clears);
+    RUN_TEST(test_loop_overrun_returns_after_clear_all);
+    RUN_TEST(test_fan_stall_adds_and_clears);
+
+    return UNITY_END();
+}
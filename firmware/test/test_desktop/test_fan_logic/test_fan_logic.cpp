@@ -3,11 +3,11 @@
  *
  * Tests for FanController logic on the native platform.
  *
- * The LEDC PWM hardware functions (ledcSetup, ledcAttachPin, ledcWrite)
- * are guarded by #ifndef NATIVE_BUILD in fan_controller.cpp, so they are
- * already compiled out. The writePWM() method becomes a no-op on native,
- * which is fine -- we are testing the state machine logic, not the hardware
- * output.
+ * The LEDC, esp_timer and PCNT hardware calls are guarded by
+ * #ifndef NATIVE_BUILD in fan_controller.cpp, so they are already compiled
+ * out. applyOutput() only records the FanOutput on native, which the tests
+ * read back through getOutput() -- we are testing the state machine logic
+ * and the profile handed to the hardware, not the hardware itself.
  *
  * On native build, millis() is not available, so the kick-start timer
  * completes immediately (now=0 is always >= _kickStartEndMs=0+500 only
@@ -249,6 +249,178 @@ void test_off_during_kickstart(void) {
     TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, fan->getCurrentSpeedPct());
 }
 
+// --------------------------------------------------------------------------
+// Tests: Output handed to the hardware (kick-start, long-pulse, steady)
+// --------------------------------------------------------------------------
+
+void test_kick_output_carries_follow_up(void) {
+    fan->setSpeed(60.0f);
+    fan->update();
+    const FanOutput& out = fan->getOutput();
+    TEST_ASSERT_TRUE(out.kick);
+    TEST_ASSERT_EQUAL_UINT8(191, out.kickDuty);   // FAN_KICKSTART_PCT
+    TEST_ASSERT_EQUAL_UINT32(FAN_KICKSTART_MS, out.kickEndMs);
+    TEST_ASSERT_EQUAL_UINT8(153, out.duty);       // 60% once the kick ends
+    TEST_ASSERT_EQUAL_UINT32(0, out.onMs);
+}
+
+void test_kick_into_long_pulse_starts_cycle_at_kick_end(void) {
+    fan->setSpeed(5.0f);
+    fan->update();
+    const FanOutput& out = fan->getOutput();
+    TEST_ASSERT_TRUE(out.kick);
+    TEST_ASSERT_EQUAL_UINT32(FAN_LONGPULSE_CYCLE_MS / 2, out.onMs);
+    TEST_ASSERT_EQUAL_UINT32(FAN_KICKSTART_MS, out.cycleStartMs);
+
+    // Software follows the same origin once the kick is over
+    fan->setNowMs(FAN_KICKSTART_MS + 20);
+    fan->update();
+    TEST_ASSERT_FALSE(fan->getOutput().kick);
+    TEST_ASSERT_EQUAL_UINT32(FAN_KICKSTART_MS, fan->getOutput().cycleStartMs);
+}
+
+void test_long_pulse_output_keeps_origin_on_target_change(void) {
+    fan->setSpeed(5.0f);
+    fan->update();
+    fan->setNowMs(FAN_KICKSTART_MS);
+    fan->update();
+
+    fan->setSpeed(8.0f);
+    fan->setNowMs(4000);
+    fan->update();
+    const FanOutput& out = fan->getOutput();
+    TEST_ASSERT_EQUAL_UINT32(FAN_LONGPULSE_CYCLE_MS * 8 / 10, out.onMs);
+    TEST_ASSERT_EQUAL_UINT32(FAN_KICKSTART_MS, out.cycleStartMs);
+    TEST_ASSERT_EQUAL_UINT8(38, out.duty);         // FAN_MIN_SPEED
+}
+
+void test_steady_output_after_kick(void) {
+    fan->setSpeed(40.0f);
+    fan->update();
+    fan->setNowMs(FAN_KICKSTART_MS);
+    fan->update();
+    const FanOutput& out = fan->getOutput();
+    TEST_ASSERT_FALSE(out.kick);
+    TEST_ASSERT_EQUAL_UINT32(0, out.onMs);
+    TEST_ASSERT_EQUAL_UINT8(102, out.duty);
+    TEST_ASSERT_EQUAL_UINT8(102, fan->getCurrentDuty());
+}
+
+void test_off_output_is_zero(void) {
+    fan->setSpeed(40.0f);
+    fan->update();
+    fan->off();
+    TEST_ASSERT_FALSE(fan->getOutput().kick);
+    TEST_ASSERT_EQUAL_UINT8(0, fan->getOutput().duty);
+}
+
+// --------------------------------------------------------------------------
+// Tests: Tachometer (closed RPM loop, adaptive kick-start, stall)
+// --------------------------------------------------------------------------
+
+// A 2-pulse fan that turns fullRpm at 100% duty, stepped at the control
+// tick. Pulses are carried between steps so the fraction isn't lost.
+static float g_pulseCarry;
+static unsigned long g_nowMs;
+
+static void runTachFan(unsigned long ms, float fullRpm) {
+    for (unsigned long t = 0; t < ms; t += CONTROL_TICK_MS) {
+        g_nowMs += CONTROL_TICK_MS;
+        float rpm = fan->getCurrentDuty() / 255.0f * fullRpm;
+        g_pulseCarry += rpm * 2.0f / 60000.0f * CONTROL_TICK_MS;
+        uint16_t n = (uint16_t)g_pulseCarry;
+        g_pulseCarry -= n;
+        fan->addTachPulses(n);
+        fan->setNowMs(g_nowMs);
+        fan->update();
+    }
+}
+
+static void beginTachFan(void) {
+    g_pulseCarry = 0.0f;
+    g_nowMs = 0;
+    fan->setNowMs(0);
+    fan->beginTach(PIN_SPARE, FAN_TACH_PCNT_UNIT, 2, 3000.0f);
+}
+
+void test_no_tach_by_default(void) {
+    TEST_ASSERT_FALSE(fan->hasTach());
+    fan->beginTach(PIN_SPARE, FAN_TACH_PCNT_UNIT, 0, 3000.0f);
+    TEST_ASSERT_FALSE(fan->hasTach());
+}
+
+void test_tach_measures_rpm(void) {
+    beginTachFan();
+    fan->setSpeed(100.0f);
+    runTachFan(3000, 4500.0f);   // Full duty on a 4500 RPM fan
+    TEST_ASSERT_TRUE(fan->hasTach());
+    TEST_ASSERT_FLOAT_WITHIN(100.0f, 4500.0f, fan->getRpm());
+}
+
+void test_kickstart_ends_when_fan_spins(void) {
+    beginTachFan();
+    fan->setSpeed(40.0f);
+    fan->update();
+    TEST_ASSERT_TRUE(fan->isKickStarting());
+
+    fan->addTachPulses(FAN_TACH_SPIN_PULSES);
+    fan->setNowMs(50);
+    fan->update();
+    TEST_ASSERT_FALSE(fan->isKickStarting());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 40.0f, fan->getCurrentSpeedPct());
+}
+
+void test_kickstart_runs_full_time_without_pulses(void) {
+    beginTachFan();
+    fan->setSpeed(40.0f);
+    fan->update();
+    fan->setNowMs(FAN_KICKSTART_MS - 10);
+    fan->update();
+    TEST_ASSERT_TRUE(fan->isKickStarting());
+}
+
+void test_closed_loop_fast_fan_trims_duty_down(void) {
+    beginTachFan();
+    fan->setSpeed(50.0f);
+    runTachFan(30000, 4500.0f);   // Half of 4500 would be 2250, wanted 1500
+    TEST_ASSERT_FLOAT_WITHIN(150.0f, 1500.0f, fan->getRpm());
+    TEST_ASSERT_TRUE(fan->getCurrentDuty() < 128);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f, fan->getCurrentSpeedPct());
+}
+
+void test_closed_loop_slow_fan_trims_duty_up(void) {
+    beginTachFan();
+    fan->setSpeed(50.0f);
+    runTachFan(30000, 2400.0f);   // Half of 2400 would be 1200, wanted 1500
+    TEST_ASSERT_FLOAT_WITHIN(150.0f, 1500.0f, fan->getRpm());
+    TEST_ASSERT_TRUE(fan->getCurrentDuty() > 128);
+}
+
+void test_full_speed_is_not_trimmed(void) {
+    beginTachFan();
+    fan->setSpeed(100.0f);
+    runTachFan(10000, 4500.0f);
+    TEST_ASSERT_EQUAL_UINT8(255, fan->getCurrentDuty());
+}
+
+void test_stall_flagged_and_rekicked(void) {
+    beginTachFan();
+    fan->setSpeed(50.0f);
+    runTachFan(FAN_STALL_MS + 100, 0.0f);   // Seized fan
+    TEST_ASSERT_TRUE(fan->isStalled());
+    TEST_ASSERT_TRUE(fan->isKickStarting());
+
+    runTachFan(2000, 3000.0f);               // Frees up
+    TEST_ASSERT_FALSE(fan->isStalled());
+}
+
+void test_no_stall_while_off(void) {
+    beginTachFan();
+    fan->setSpeed(0.0f);
+    runTachFan(FAN_STALL_MS * 2, 0.0f);
+    TEST_ASSERT_FALSE(fan->isStalled());
+}
+
 // --------------------------------------------------------------------------
 // Main
 // --------------------------------------------------------------------------
@@ -288,5 +460,23 @@ int main(int argc, char** argv) {
     RUN_TEST(test_multiple_updates_at_zero_stay_zero);
     RUN_TEST(test_off_during_kickstart);
 
+    // Hardware output
+    RUN_TEST(test_kick_output_carries_follow_up);
+    RUN_TEST(test_kick_into_long_pulse_starts_cycle_at_kick_end);
+    RUN_TEST(test_long_pulse_output_keeps_origin_on_target_change);
+    RUN_TEST(test_steady_output_after_kick);
+    RUN_TEST(test_off_output_is_zero);
+
+    // Tachometer
+    RUN_TEST(test_no_tach_by_default);
+    RUN_TEST(test_tach_measures_rpm);
+    RUN_TEST(test_kickstart_ends_when_fan_spins);
+    RUN_TEST(test_kickstart_runs_full_time_without_pulses);
+    RUN_TEST(test_closed_loop_fast_fan_trims_duty_down);
+    RUN_TEST(test_closed_loop_slow_fan_trims_duty_up);
+    RUN_TEST(test_full_speed_is_not_trimmed);
+    RUN_TEST(test_stall_flagged_and_rekicked);
+    RUN_TEST(test_no_stall_while_off);
+
     return UNITY_END();
 }
@@ -0,0 +1,313 @@
+/**
+ * test_graph_history.cpp
+ *
+ * Tests for the on-device graph's GraphHistory buffer on the native platform.
+ *
+ * Covers appending, the 240 -> 120 condense when full, validity-aware
+ * merging of disconnected probes, the min/max envelope condense mode, the
+ * addPoint() return value the UI uses to choose between an incremental
+ * append and a full chart re-sync, and the one-pass bulk load used on
+ * session recovery.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+
+#include "display/graph_history.h"
+#include "display/graph_history.cpp"
+
+static GraphHistory* gh;
+
+// Pit, meat1 and meat2; any further channels are unplugged
+static void channels(float pit, float meat1, float meat2, bool pitDisc, bool meat1Disc, bool meat2Disc,
+                     float* temps, bool* disc) {
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        temps[c] = 0.0f;
+        disc[c] = true;
+    }
+    temps[PROBE_PIT] = pit;     disc[PROBE_PIT] = pitDisc;
+    temps[PROBE_MEAT1] = meat1; disc[PROBE_MEAT1] = meat1Disc;
+    temps[PROBE_MEAT2] = meat2; disc[PROBE_MEAT2] = meat2Disc;
+}
+
+static bool addPoint(GraphHistory& h, float pit, float meat1, float meat2, float setpoint,
+                     bool pitDisc, bool meat1Disc, bool meat2Disc) {
+    float temps[NUM_PROBES];
+    bool disc[NUM_PROBES];
+    channels(pit, meat1, meat2, pitDisc, meat1Disc, meat2Disc, temps, disc);
+    return h.addPoint(temps, disc, setpoint);
+}
+
+static void loadPoint(GraphHistory& h, float pit, float meat1, float meat2, float setpoint,
+                      bool pitDisc, bool meat1Disc, bool meat2Disc) {
+    float temps[NUM_PROBES];
+    bool disc[NUM_PROBES];
+    channels(pit, meat1, meat2, pitDisc, meat1Disc, meat2Disc, temps, disc);
+    h.loadPoint(temps, disc, setpoint);
+}
+
+void setUp(void) {
+    gh = new GraphHistory();
+}
+
+void tearDown(void) {
+    delete gh;
+    gh = nullptr;
+}
+
+static void fill(uint16_t n) {
+    for (uint16_t i = 0; i < n; i++) {
+        addPoint(*gh, (float)i, 100.0f, 100.0f, 225.0f, false, false, false);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Append
+// --------------------------------------------------------------------------
+
+void test_starts_empty(void) {
+    TEST_ASSERT_EQUAL_UINT16(0, gh->getCount());
+    TEST_ASSERT_FALSE(gh->getSlot(0).valid[PROBE_PIT]);
+}
+
+void test_append_returns_false_until_full(void) {
+    for (uint16_t i = 0; i < GRAPH_HISTORY_SIZE; i++) {
+        TEST_ASSERT_FALSE(addPoint(*gh, (float)i, 0, 0, 225.0f, false, true, true));
+        TEST_ASSERT_EQUAL_UINT16(i + 1, gh->getCount());
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, (float)i, gh->getSlot(i).temp[PROBE_PIT]);
+    }
+}
+
+void test_disconnected_probes_marked_invalid(void) {
+    addPoint(*gh, 225.0f, 150.0f, 0.0f, 225.0f, false, false, true);
+    const GraphSlot& s = gh->getSlot(0);
+    TEST_ASSERT_TRUE(s.valid[PROBE_PIT]);
+    TEST_ASSERT_TRUE(s.valid[PROBE_MEAT1]);
+    TEST_ASSERT_FALSE(s.valid[PROBE_MEAT2]);
+}
+
+// --------------------------------------------------------------------------
+// Condense
+// --------------------------------------------------------------------------
+
+void test_full_buffer_condenses_on_next_point(void) {
+    fill(GRAPH_HISTORY_SIZE);
+    TEST_ASSERT_TRUE(addPoint(*gh, 999.0f, 100.0f, 100.0f, 225.0f, false, false, false));
+    TEST_ASSERT_EQUAL_UINT16(GRAPH_HISTORY_SIZE / 2 + 1, gh->getCount());
+
+    // Pairwise averages, then the new point
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, gh->getSlot(0).temp[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 238.5f, gh->getSlot(GRAPH_HISTORY_SIZE / 2 - 1).temp[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 999.0f, gh->getSlot(GRAPH_HISTORY_SIZE / 2).temp[PROBE_PIT]);
+
+    // Back to plain appends
+    TEST_ASSERT_FALSE(addPoint(*gh, 1.0f, 1.0f, 1.0f, 225.0f, false, false, false));
+}
+
+void test_condense_keeps_valid_half_of_pair(void) {
+    addPoint(*gh, 200.0f, 0.0f, 0.0f, 225.0f, true, true, true);    // Pit disconnected
+    addPoint(*gh, 210.0f, 0.0f, 0.0f, 225.0f, false, true, true);
+    fill(GRAPH_HISTORY_SIZE - 2);
+    addPoint(*gh, 0.0f, 0.0f, 0.0f, 225.0f, false, false, false);
+
+    const GraphSlot& s = gh->getSlot(0);
+    TEST_ASSERT_TRUE(s.valid[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 210.0f, s.temp[PROBE_PIT]);
+    TEST_ASSERT_FALSE(s.valid[PROBE_MEAT1]);   // Both halves invalid
+}
+
+void test_clear_resets(void) {
+    fill(10);
+    gh->clear();
+    TEST_ASSERT_EQUAL_UINT16(0, gh->getCount());
+    TEST_ASSERT_FALSE(addPoint(*gh, 1.0f, 1.0f, 1.0f, 225.0f, false, false, false));
+}
+
+// --------------------------------------------------------------------------
+// Envelope condense
+// --------------------------------------------------------------------------
+
+// 12 h at 5 s with a 3-sample lid dip to 150 and a 1-sample spike to 300.
+// Returns the lowest and highest pit value left on the graph.
+static void runLongCook(GraphCondense mode, float& lo, float& hi) {
+    gh->setMode(mode);
+    for (uint32_t i = 0; i < 8640; i++) {
+        float pit = 225.0f;
+        if (i >= 2000 && i < 2003) pit = 150.0f;
+        if (i == 5000) pit = 300.0f;
+        addPoint(*gh, pit, 100.0f, 0.0f, 225.0f, false, false, true);
+    }
+    lo = 1000.0f;
+    hi = -1000.0f;
+    for (uint16_t i = 0; i < gh->getCount(); i++) {
+        const GraphSlot& s = gh->getSlot(i);
+        if (s.temp[PROBE_PIT] < lo) lo = s.temp[PROBE_PIT];
+        if (s.temp[PROBE_PIT] > hi) hi = s.temp[PROBE_PIT];
+    }
+}
+
+void test_envelope_keeps_spikes_through_long_cook(void) {
+    float lo, hi;
+    runLongCook(GraphCondense::ENVELOPE, lo, hi);
+    TEST_ASSERT_TRUE(gh->getCount() <= GRAPH_HISTORY_SIZE);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 150.0f, lo);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 300.0f, hi);
+}
+
+void test_average_flattens_spikes_through_long_cook(void) {
+    float lo, hi;
+    runLongCook(GraphCondense::AVERAGE, lo, hi);
+    TEST_ASSERT_TRUE(lo > 200.0f);
+    TEST_ASSERT_TRUE(hi < 240.0f);
+}
+
+void test_envelope_condense_halves_in_time_order(void) {
+    gh->setMode(GraphCondense::ENVELOPE);
+    // Bucket 0: max before min. Bucket 1: min before max.
+    const float pits[8] = { 220.0f, 230.0f, 210.0f, 225.0f,
+                            205.0f, 215.0f, 240.0f, 225.0f };
+    for (uint8_t i = 0; i < 8; i++) {
+        addPoint(*gh, pits[i], 0.0f, 0.0f, i < 2 ? 200.0f : 225.0f, false, true, true);
+    }
+    fill(GRAPH_HISTORY_SIZE - 8);
+    TEST_ASSERT_TRUE(addPoint(*gh, 0.0f, 0.0f, 0.0f, 225.0f, false, false, false));
+    TEST_ASSERT_EQUAL_UINT16(GRAPH_HISTORY_SIZE / 2 + 1, gh->getCount());
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 230.0f, gh->getSlot(0).temp[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 210.0f, gh->getSlot(1).temp[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 205.0f, gh->getSlot(2).temp[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 240.0f, gh->getSlot(3).temp[PROBE_PIT]);
+
+    // Setpoint keeps the bucket's first and last value
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 200.0f, gh->getSlot(0).setpoint);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 225.0f, gh->getSlot(1).setpoint);
+
+    // Meat probes were disconnected for the whole bucket
+    TEST_ASSERT_FALSE(gh->getSlot(0).valid[PROBE_MEAT1]);
+    TEST_ASSERT_FALSE(gh->getSlot(1).valid[PROBE_MEAT1]);
+    TEST_ASSERT_TRUE(gh->getSlot(2).valid[PROBE_PIT]);
+}
+
+void test_envelope_ignores_invalid_samples(void) {
+    gh->setMode(GraphCondense::ENVELOPE);
+    addPoint(*gh, 0.0f, 0.0f, 0.0f, 225.0f, true, true, true);     // Pit disconnected
+    addPoint(*gh, 212.0f, 0.0f, 0.0f, 225.0f, false, true, true);
+    addPoint(*gh, 0.0f, 0.0f, 0.0f, 225.0f, true, true, true);
+    addPoint(*gh, 0.0f, 0.0f, 0.0f, 225.0f, true, true, true);
+    fill(GRAPH_HISTORY_SIZE - 4);
+    addPoint(*gh, 0.0f, 0.0f, 0.0f, 225.0f, false, false, false);
+
+    // A single valid sample fills both halves of the bucket
+    TEST_ASSERT_TRUE(gh->getSlot(0).valid[PROBE_PIT]);
+    TEST_ASSERT_TRUE(gh->getSlot(1).valid[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 212.0f, gh->getSlot(0).temp[PROBE_PIT]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 212.0f, gh->getSlot(1).temp[PROBE_PIT]);
+}
+
+// --------------------------------------------------------------------------
+// Bulk load
+// --------------------------------------------------------------------------
+
+static void load(GraphHistory& h, uint32_t n, uint32_t spikeAt) {
+    h.beginLoad(n);
+    for (uint32_t i = 0; i < n; i++) {
+        float pit = (i == spikeAt) ? 400.0f : 225.0f;
+        loadPoint(h, pit, (float)i, 0.0f, i < n / 2 ? 225.0f : 275.0f, false, false, true);
+    }
+    h.endLoad();
+}
+
+void test_bulk_load_short_range_is_stored_as_is(void) {
+    load(*gh, 100, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, gh->getLoadRun());
+    TEST_ASSERT_EQUAL_UINT16(100, gh->getCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 42.0f, gh->getSlot(42).temp[PROBE_MEAT1]);
+}
+
+void test_bulk_load_12h_cook_fits_in_one_pass(void) {
+    // 12 h at 5 s
+    load(*gh, 8640, 5000);
+    TEST_ASSERT_EQUAL_UINT32(64, gh->getLoadRun());
+    TEST_ASSERT_TRUE(gh->getCount() > GRAPH_HISTORY_SIZE / 2);
+    TEST_ASSERT_TRUE(gh->getCount() <= GRAPH_HISTORY_SIZE);
+
+    // Averages of each 64-point run; the spike is smoothed
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 31.5f, gh->getSlot(0).temp[PROBE_MEAT1]);
+    TEST_ASSERT_FALSE(gh->getSlot(0).valid[PROBE_MEAT2]);
+    float maxPit = 0.0f;
+    for (uint16_t i = 0; i < gh->getCount(); i++) {
+        if (gh->getSlot(i).temp[PROBE_PIT] > maxPit) maxPit = gh->getSlot(i).temp[PROBE_PIT];
+    }
+    TEST_ASSERT_TRUE(maxPit < 300.0f);
+
+    // And the buffer keeps working afterwards
+    addPoint(*gh, 225.0f, 0, 0, 275.0f, false, true, true);
+    TEST_ASSERT_TRUE(gh->getCount() <= GRAPH_HISTORY_SIZE);
+}
+
+void test_bulk_load_envelope_keeps_extremes(void) {
+    GraphHistory env(GraphCondense::ENVELOPE);
+    load(env, 8640, 5000);
+    TEST_ASSERT_TRUE(env.getCount() <= GRAPH_HISTORY_SIZE);
+
+    float maxPit = 0.0f;
+    for (uint16_t i = 0; i < env.getCount(); i++) {
+        if (env.getSlot(i).temp[PROBE_PIT] > maxPit) maxPit = env.getSlot(i).temp[PROBE_PIT];
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 400.0f, maxPit);
+
+    // Each pair runs min then max of a rising meat line; setpoint steps stay sharp
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, env.getSlot(0).temp[PROBE_MEAT1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 127.0f, env.getSlot(1).temp[PROBE_MEAT1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 225.0f, env.getSlot(0).setpoint);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 275.0f, env.getSlot(env.getCount() - 1).setpoint);
+}
+
+void test_every_channel_is_condensed(void) {
+    // Channel c reads 100 * (c + 1) + i at point i, every channel plugged in
+    float temps[NUM_PROBES];
+    bool disc[NUM_PROBES] = {};
+    for (uint16_t i = 0; i <= GRAPH_HISTORY_SIZE; i++) {
+        for (uint8_t c = 0; c < NUM_PROBES; c++) temps[c] = 100.0f * (c + 1) + i;
+        gh->addPoint(temps, disc, 225.0f);
+    }
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        TEST_ASSERT_TRUE(gh->getSlot(0).valid[c]);
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f * (c + 1) + 0.5f, gh->getSlot(0).temp[c]);
+    }
+}
+
+void test_bulk_load_overfeed_stops_at_full(void) {
+    gh->beginLoad(10);
+    for (uint32_t i = 0; i < 1000; i++) {
+        loadPoint(*gh, 225.0f, 0, 0, 225.0f, false, true, true);
+    }
+    gh->endLoad();
+    TEST_ASSERT_EQUAL_UINT16(GRAPH_HISTORY_SIZE, gh->getCount());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_starts_empty);
+    RUN_TEST(test_append_returns_false_until_full);
+    RUN_TEST(test_disconnected_probes_marked_invalid);
+    RUN_TEST(test_full_buffer_condenses_on_next_point);
+    RUN_TEST(test_condense_keeps_valid_half_of_pair);
+    RUN_TEST(test_clear_resets);
+    RUN_TEST(test_envelope_keeps_spikes_through_long_cook);
+    RUN_TEST(test_average_flattens_spikes_through_long_cook);
+    RUN_TEST(test_envelope_condense_halves_in_time_order);
+    RUN_TEST(test_envelope_ignores_invalid_samples);
+    RUN_TEST(test_bulk_load_short_range_is_stored_as_is);
+    RUN_TEST(test_bulk_load_12h_cook_fits_in_one_pass);
+    RUN_TEST(test_bulk_load_envelope_keeps_extremes);
+    RUN_TEST(test_every_channel_is_condensed);
+    RUN_TEST(test_bulk_load_overfeed_stops_at_full);
+
+    return UNITY_END();
+}
@@ -0,0 +1,228 @@
+/**
+ * test_history_stream.cpp
+ *
+ * Tests for the chunked history replay shared by the device web server and
+ * the simulator, on the native platform.
+ *
+ * Tests cover:
+ *   - Chunking a short cook at level 0, with the final flag and "next"
+ *   - Picking a rollup level for a small LOD budget
+ *   - Per-point setpoints from the event journal, fallback before it
+ *   - Resuming from a seq, and skipping ahead past points no longer in RAM
+ *   - A session cleared mid-replay ending the stream
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+// Minimal Arduino String stub (CookSession's exports)
+class String {
+public:
+    String() {}
+    String(const char* s) : _data(s ? s : "") {}
+    String& operator+=(const char* s) { if (s) _data += s; return *this; }
+    void reserve(size_t n) { _data.reserve(n); }
+    const char* c_str() const { return _data.c_str(); }
+    size_t length() const { return _data.length(); }
+private:
+    std::string _data;
+};
+
+#include "history_stream.h"
+#include "history_stream.cpp"
+#include "cook_session.cpp"
+#include "session_archive.cpp"
+#include "session_events.cpp"
+#include "session_log.cpp"
+#include "ext_ram.cpp"
+#include "web_protocol.cpp"
+
+#define T0 1700000000UL
+
+static CookSession*    session;
+static HistoryScratch  scratch;
+static HistoryStream   stream;
+static const float kTargets[NUM_MEATS]   = { 203.0f };   // meat1 only
+static const float kNoTargets[NUM_MEATS] = {};
+
+void setUp(void) {
+    session = new CookSession();
+    session->startSession();
+    memset(&stream, 0, sizeof(stream));
+}
+
+void tearDown(void) {
+    delete session;
+    session = nullptr;
+}
+
+static void addPoints(uint32_t count) {
+    uint32_t base = session->getTotalPointCount();
+    for (uint32_t i = 0; i < count; i++) {
+        DataPoint dp;
+        memset(&dp, 0, sizeof(dp));
+        dp.timestamp = T0 + (base + i) * 5;
+        dp.temp[PROBE_PIT] = 2250;
+        dp.temp[PROBE_MEAT1] = 1500;
+        dp.fanPct = 40;
+        dpSetDiscMask(dp, 1u << PROBE_MEAT2);
+        session->addPoint(dp);
+    }
+}
+
+static uint32_t countOf(const char* buf, size_t len, const char* needle) {
+    std::string s(buf, len);
+    uint32_t n = 0;
+    for (size_t pos = s.find(needle); pos != std::string::npos; pos = s.find(needle, pos + 1)) n++;
+    return n;
+}
+
+// Pump the stream to the end. Returns the points sent; chunks and the
+// last chunk's text come back through the pointers.
+static uint32_t drain(uint16_t* chunks, std::string* last = nullptr) {
+    uint32_t points = 0;
+    *chunks = 0;
+    bool final = false;
+    while (!final) {
+        size_t len = historyStreamNext(stream, *session, scratch, 225.0f, kTargets, final);
+        TEST_ASSERT_TRUE(len > 0);
+        points += countOf(scratch.buf, len, "\"ts\":");
+        (*chunks)++;
+        if (last) last->assign(scratch.buf, len);
+        TEST_ASSERT_TRUE(*chunks < 1000);
+    }
+    TEST_ASSERT_FALSE(stream.active);
+    return points;
+}
+
+// --------------------------------------------------------------------------
+// Full replay
+// --------------------------------------------------------------------------
+
+void test_short_cook_in_chunks_at_level_0(void) {
+    addPoints(100);
+    historyStreamBegin(stream, *session, WS_HISTORY_MAX_POINTS);
+    TEST_ASSERT_EQUAL_UINT8(0, stream.level);
+
+    bool final = false;
+    size_t len = historyStreamNext(stream, *session, scratch, 225.0f, kTargets, final);
+    TEST_ASSERT_FALSE(final);
+    std::string first(scratch.buf, len);
+    TEST_ASSERT_TRUE(first.find("\"chunk\":0") != std::string::npos);
+    TEST_ASSERT_TRUE(first.find("\"meat1Target\":203") != std::string::npos);
+    TEST_ASSERT_EQUAL_UINT32(WS_HISTORY_CHUNK_POINTS, countOf(scratch.buf, len, "\"ts\":"));
+
+    uint16_t chunks;
+    std::string last;
+    uint32_t rest = drain(&chunks, &last);
+    TEST_ASSERT_EQUAL_UINT32(100 - WS_HISTORY_CHUNK_POINTS, rest);
+    TEST_ASSERT_EQUAL_UINT16((100 + WS_HISTORY_CHUNK_POINTS - 1) / WS_HISTORY_CHUNK_POINTS,
+                             stream.chunk);
+    TEST_ASSERT_TRUE(last.find("\"next\":100") != std::string::npos);
+    TEST_ASSERT_TRUE(last.find("\"meat2\":null") != std::string::npos);
+}
+
+void test_empty_session_sends_one_final_chunk(void) {
+    historyStreamBegin(stream, *session, WS_HISTORY_MAX_POINTS);
+    uint16_t chunks;
+    TEST_ASSERT_EQUAL_UINT32(0, drain(&chunks));
+    TEST_ASSERT_EQUAL_UINT16(1, chunks);
+}
+
+void test_small_budget_replays_a_rollup_level(void) {
+    addPoints(2000);
+    historyStreamBegin(stream, *session, 200);
+    TEST_ASSERT_EQUAL_UINT8(1, stream.level);
+
+    uint16_t chunks;
+    uint32_t points = drain(&chunks);
+    TEST_ASSERT_EQUAL_UINT32(session->getLevelCount(1), points);
+    TEST_ASSERT_TRUE(points <= 200);
+}
+
+// --------------------------------------------------------------------------
+// Setpoints from the journal
+// --------------------------------------------------------------------------
+
+void test_points_carry_journalled_setpoint(void) {
+    addPoints(10);
+    session->logEvent(SessionEventType::SETPOINT, 2500, T0 + 10 * 5);
+    addPoints(10);
+
+    historyStreamBegin(stream, *session, WS_HISTORY_MAX_POINTS);
+    bool final = false;
+    size_t len = historyStreamNext(stream, *session, scratch, 225.0f, kNoTargets, final);
+    TEST_ASSERT_TRUE(final);
+
+    // Ten points predate the journal and take the fallback; ten follow the change
+    TEST_ASSERT_EQUAL_UINT32(10, countOf(scratch.buf, len, "\"sp\":250"));
+    TEST_ASSERT_EQUAL_UINT32(10 + 1, countOf(scratch.buf, len, "\"sp\":225"));   // + chunk 0 header
+}
+
+// --------------------------------------------------------------------------
+// Resume and edge cases
+// --------------------------------------------------------------------------
+
+void test_resume_sends_only_the_tail(void) {
+    addPoints(100);
+    historyStreamResume(stream, 90);
+
+    bool final = false;
+    size_t len = historyStreamNext(stream, *session, scratch, 225.0f, kNoTargets, final);
+    TEST_ASSERT_TRUE(final);
+    TEST_ASSERT_EQUAL_UINT32(10, countOf(scratch.buf, len, "\"ts\":"));
+    TEST_ASSERT_EQUAL_UINT32(1, countOf(scratch.buf, len, "\"resume\":true"));
+}
+
+void test_skips_ahead_past_points_no_longer_in_ram(void) {
+    delete session;
+    session = new CookSession(50, 16);
+    session->startSession();
+    addPoints(120);
+
+    // Off the device there's no log behind the ring
+    historyStreamResume(stream, 0);
+    uint16_t chunks;
+    TEST_ASSERT_EQUAL_UINT32(50, drain(&chunks));
+}
+
+void test_session_cleared_mid_replay_ends_stream(void) {
+    addPoints(100);
+    historyStreamBegin(stream, *session, WS_HISTORY_MAX_POINTS);
+    bool final = false;
+    TEST_ASSERT_TRUE(historyStreamNext(stream, *session, scratch, 225.0f, kNoTargets, final) > 0);
+
+    session->startSession();
+    TEST_ASSERT_TRUE(historyStreamNext(stream, *session, scratch, 225.0f, kNoTargets, final) > 0);
+    TEST_ASSERT_TRUE(final);
+    TEST_ASSERT_FALSE(stream.active);
+}
+
+void test_inactive_stream_builds_nothing(void) {
+    addPoints(10);
+    bool final = true;
+    TEST_ASSERT_EQUAL_UINT32(0, historyStreamNext(stream, *session, scratch, 225.0f, kNoTargets, final));
+    TEST_ASSERT_FALSE(final);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_short_cook_in_chunks_at_level_0);
+    RUN_TEST(test_empty_session_sends_one_final_chunk);
+    RUN_TEST(test_small_budget_replays_a_rollup_level);
+    RUN_TEST(test_points_carry_journalled_setpoint);
+    RUN_TEST(test_resume_sends_only_the_tail);
+    RUN_TEST(test_skips_ahead_past_points_no_longer_in_ram);
+    RUN_TEST(test_session_cleared_mid_replay_ends_stream);
+    RUN_TEST(test_inactive_stream_builds_nothing);
+
+    return UNITY_END();
+}
@@ -0,0 +1,294 @@
+/**
+ * test_hub_peers.cpp
+ *
+ * Tests for the hub-mode peer table and event-stream parser on the native
+ * platform.
+ *
+ * Covers peer discovery (add/refresh/expire, pinned peers), reconnect
+ * backoff, frame storage and history sampling, the merged state and
+ * history JSON, and parsing an /api/stream response split at arbitrary
+ * points.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#include "hub_peers.h"
+#include "hub_peers.cpp"
+
+static HubTable table;
+
+static void toString(const char* text, size_t len, void* ctx) {
+    static_cast<std::string*>(ctx)->append(text, len);
+}
+
+static std::string frameAt(uint32_t ts, float pit) {
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             "{\"type\":\"data\",\"ts\":%u,\"pit\":%.1f,\"meat1\":150.0,\"meat2\":null,"
+             "\"fan\":40,\"damper\":60,\"sp\":225,\"lid\":false,\"errors\":[]}",
+             (unsigned)ts, pit);
+    return buf;
+}
+
+void setUp(void) {
+    table = HubTable();
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Peers
+// --------------------------------------------------------------------------
+
+void test_add_refreshes_known_peer(void) {
+    int a = table.add("bbq", "192.168.1.20", 80, 1000);
+    int b = table.add("bbq-2", "192.168.1.21", 80, 1000);
+    TEST_ASSERT_EQUAL_INT(0, a);
+    TEST_ASSERT_EQUAL_INT(1, b);
+    TEST_ASSERT_EQUAL_INT(a, table.add("smoker", "192.168.1.20", 80, 5000));
+    TEST_ASSERT_EQUAL_UINT8(2, table.count());
+    TEST_ASSERT_EQUAL_STRING("smoker", table.peer(a)->name);
+    TEST_ASSERT_EQUAL_UINT32(5000, table.peer(a)->seenMs);
+}
+
+void test_table_full_and_empty_host(void) {
+    char host[16];
+    for (int i = 0; i < HUB_MAX_PEERS; i++) {
+        snprintf(host, sizeof(host), "10.0.0.%d", i + 1);
+        TEST_ASSERT_EQUAL_INT(i, table.add(nullptr, host, 80, 0));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, table.add(nullptr, "10.0.0.99", 80, 0));
+    TEST_ASSERT_EQUAL_INT(-1, table.add("x", "", 80, 0));
+    TEST_ASSERT_EQUAL_STRING("10.0.0.1", table.peer(0)->name);   // Host stands in for a name
+}
+
+void test_expire_keeps_pinned_and_fresh(void) {
+    int gone = table.add("a", "10.0.0.1", 80, 0);
+    int pinned = table.add("b", "10.0.0.2", 80, 0, true);
+    int fresh = table.add("c", "10.0.0.3", 80, 0);
+    std::string f = frameAt(100, 225.0f);
+    table.frame(fresh, f.c_str(), f.size(), HUB_PEER_EXPIRE_MS - 1);
+
+    TEST_ASSERT_EQUAL_UINT8(1, table.expire(HUB_PEER_EXPIRE_MS));
+    TEST_ASSERT_NULL(table.peer(gone));
+    TEST_ASSERT_NOT_NULL(table.peer(pinned));
+    TEST_ASSERT_NOT_NULL(table.peer(fresh));
+}
+
+void test_failures_back_off(void) {
+    int s = table.add("a", "10.0.0.1", 80, 0);
+    TEST_ASSERT_TRUE(table.connectDue(s, 0));
+    table.failed(s, 1000);
+    TEST_ASSERT_FALSE(table.connectDue(s, 1000 + HUB_RETRY_BASE_MS - 1));
+    TEST_ASSERT_TRUE(table.connectDue(s, 1000 + HUB_RETRY_BASE_MS));
+    table.failed(s, 10000);
+    TEST_ASSERT_FALSE(table.connectDue(s, 10000 + HUB_RETRY_BASE_MS * 2 - 1));
+    for (int i = 0; i < 10; i++) table.failed(s, 20000);
+    TEST_ASSERT_EQUAL_UINT32(20000 + HUB_RETRY_MAX_MS, table.peer(s)->retryAtMs);
+
+    // A frame clears the failure count
+    std::string f = frameAt(100, 225.0f);
+    table.frame(s, f.c_str(), f.size(), 30000);
+    table.failed(s, 40000);
+    TEST_ASSERT_EQUAL_UINT32(40000 + HUB_RETRY_BASE_MS, table.peer(s)->retryAtMs);
+}
+
+// --------------------------------------------------------------------------
+// Frames and history
+// --------------------------------------------------------------------------
+
+void test_json_number(void) {
+    std::string f = frameAt(1700000000, 231.5f);
+    TEST_ASSERT_EQUAL_FLOAT(231.5f, hubJsonNumber(f.c_str(), f.size(), "pit"));
+    TEST_ASSERT_EQUAL_FLOAT(1700000000.0f, hubJsonNumber(f.c_str(), f.size(), "ts"));
+    TEST_ASSERT_TRUE(isnan(hubJsonNumber(f.c_str(), f.size(), "meat2")));   // null
+    TEST_ASSERT_TRUE(isnan(hubJsonNumber(f.c_str(), f.size(), "est")));     // missing
+    TEST_ASSERT_TRUE(isnan(hubJsonNumber(f.c_str(), f.size(), "pi")));      // prefix only
+}
+
+void test_frame_online_and_stale(void) {
+    int s = table.add("a", "10.0.0.1", 80, 0);
+    TEST_ASSERT_FALSE(table.online(s, 0));
+    const char* other = "{\"type\":\"history\",\"points\":[]}";
+    TEST_ASSERT_FALSE(table.frame(s, other, strlen(other), 100));
+
+    std::string f = frameAt(100, 225.0f);
+    TEST_ASSERT_TRUE(table.frame(s, f.c_str(), f.size(), 1000));
+    TEST_ASSERT_TRUE(table.online(s, 1000 + HUB_PEER_STALE_MS - 1));
+    TEST_ASSERT_FALSE(table.online(s, 1000 + HUB_PEER_STALE_MS));
+    TEST_ASSERT_EQUAL_STRING(f.c_str(), table.peer(s)->frame);
+}
+
+void test_history_one_point_per_interval(void) {
+    int s = table.add("a", "10.0.0.1", 80, 0);
+    uint32_t ts = 1000;
+    for (int i = 0; i < 10; i++, ts += HUB_HISTORY_INTERVAL_S / 4) {
+        std::string f = frameAt(ts, 200.0f + i);
+        table.frame(s, f.c_str(), f.size(), i * 1000);
+    }
+    // 10 frames over 2.25 intervals: points at 0, 1 and 2 intervals
+    TEST_ASSERT_EQUAL_UINT16(3, table.peer(s)->historyCount);
+    TEST_ASSERT_EQUAL_INT16(2040, table.peer(s)->history[1].temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_INT16(BIN_TEMP_NONE, table.peer(s)->history[1].temp[PROBE_MEAT2]);
+    TEST_ASSERT_EQUAL_UINT8(40, table.peer(s)->history[1].fan);
+
+    // Clock moved back (new cook): history restarts
+    std::string f = frameAt(10, 100.0f);
+    table.frame(s, f.c_str(), f.size(), 20000);
+    TEST_ASSERT_EQUAL_UINT16(1, table.peer(s)->historyCount);
+}
+
+void test_history_ring_wraps(void) {
+    int s = table.add("a", "10.0.0.1", 80, 0);
+    for (uint32_t i = 0; i < HUB_HISTORY_POINTS + 5; i++) {
+        std::string f = frameAt(1000 + i * HUB_HISTORY_INTERVAL_S, 225.0f);
+        table.frame(s, f.c_str(), f.size(), i);
+    }
+    TEST_ASSERT_EQUAL_UINT16(HUB_HISTORY_POINTS, table.peer(s)->historyCount);
+
+    std::string out;
+    TEST_ASSERT_TRUE(table.writeHistory(toString, &out, s, 0));
+    char first[32];
+    snprintf(first, sizeof(first), "\"points\":[[%u,", (unsigned)(1000 + 5 * HUB_HISTORY_INTERVAL_S));
+    TEST_ASSERT_NOT_NULL(strstr(out.c_str(), first));
+}
+
+void test_history_since(void) {
+    int s = table.add("a", "10.0.0.1", 80, 0);
+    for (uint32_t i = 0; i < 3; i++) {
+        std::string f = frameAt(1000 + i * HUB_HISTORY_INTERVAL_S, 225.0f);
+        table.frame(s, f.c_str(), f.size(), i);
+    }
+    std::string out;
+    table.writeHistory(toString, &out, s, 1000);
+    char expect[128];
+    snprintf(expect, sizeof(expect),
+             "{\"id\":%d,\"name\":\"a\",\"points\":[[%u,225.0,150.0,null,40],[%u,225.0,150.0,null,40]]}",
+             s, 1000 + HUB_HISTORY_INTERVAL_S, 1000 + 2 * HUB_HISTORY_INTERVAL_S);
+    TEST_ASSERT_EQUAL_STRING(expect, out.c_str());
+    TEST_ASSERT_FALSE(table.writeHistory(toString, &out, 5, 0));
+}
+
+void test_state_lists_local_then_peers(void) {
+    int a = table.add("smoker", "10.0.0.1", 80, 0);
+    table.add("kettle\"", "10.0.0.2", 8080, 0);        // Quote is dropped, not escaped
+    std::string f = frameAt(100, 225.0f);
+    table.frame(a, f.c_str(), f.size(), 1000);
+
+    const char* local = "{\"type\":\"data\",\"ts\":5}";
+    std::string out;
+    table.writeState(toString, &out, "bbq", local, strlen(local), 3500);
+
+    std::string expect = std::string("{\"type\":\"hub\",\"units\":[")
+        + "{\"id\":-1,\"name\":\"bbq\",\"local\":true,\"online\":true,\"data\":" + local + "}"
+        + ",{\"id\":0,\"name\":\"smoker\",\"host\":\"10.0.0.1\",\"port\":80,\"online\":true,\"age\":2,\"data\":" + f + "}"
+        + ",{\"id\":1,\"name\":\"kettle\",\"host\":\"10.0.0.2\",\"port\":8080,\"online\":false,\"age\":null,\"data\":null}"
+        + "]}";
+    TEST_ASSERT_EQUAL_STRING(expect.c_str(), out.c_str());
+}
+
+// --------------------------------------------------------------------------
+// Event stream
+// --------------------------------------------------------------------------
+
+static const char kStream[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "\r\n"
+    "retry: 3000\r\n"
+    "id: 7\r\n"
+    "event: data\r\n"
+    "data: {\"type\":\"data\",\"ts\":1}\r\n"
+    "\r\n"
+    "event: ping\r\n"
+    "data: x\r\n"
+    "\r\n"
+    ": comment\n"
+    "data: {\"type\":\"data\",\n"
+    "data: \"ts\":2}\n"
+    "\n";
+
+void test_sse_frames_and_skips(void) {
+    static HubSseParser sse;
+    sse.reset();
+    const char* p = kStream;
+    size_t left = sizeof(kStream) - 1;
+    size_t used = 0;
+
+    TEST_ASSERT_EQUAL(HubSseResult::FRAME, sse.feed(p, left, &used));
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"data\",\"ts\":1}", sse.data());
+    p += used; left -= used;
+
+    TEST_ASSERT_EQUAL(HubSseResult::FRAME, sse.feed(p, left, &used));
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"data\",\n\"ts\":2}", sse.data());
+    p += used; left -= used;
+
+    TEST_ASSERT_EQUAL(HubSseResult::NONE, sse.feed(p, left, &used));
+    TEST_ASSERT_EQUAL_UINT32(0, left - used);
+}
+
+void test_sse_byte_at_a_time(void) {
+    static HubSseParser sse;
+    sse.reset();
+    int frames = 0;
+    for (size_t i = 0; i < sizeof(kStream) - 1; i++) {
+        size_t used;
+        if (sse.feed(kStream + i, 1, &used) == HubSseResult::FRAME) frames++;
+        TEST_ASSERT_EQUAL_UINT32(1, used);
+    }
+    TEST_ASSERT_EQUAL_INT(2, frames);
+}
+
+void test_sse_rejected_status(void) {
+    static HubSseParser sse;
+    sse.reset();
+    const char* busy = "HTTP/1.1 503 Service Unavailable\r\n\r\nToo many stream viewers";
+    size_t used;
+    TEST_ASSERT_EQUAL(HubSseResult::REJECTED, sse.feed(busy, strlen(busy), &used));
+}
+
+void test_sse_drops_oversized_event(void) {
+    static HubSseParser sse;
+    sse.reset();
+    std::string s = "HTTP/1.1 200 OK\r\n\r\ndata: ";
+    s.append(DATA_MESSAGE_MAX_BYTES + 20, 'x');
+    s += "\r\n\r\ndata: ok\r\n\r\n";
+    size_t used;
+    TEST_ASSERT_EQUAL(HubSseResult::FRAME, sse.feed(s.c_str(), s.size(), &used));
+    TEST_ASSERT_EQUAL_STRING("ok", sse.data());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Peers
+    RUN_TEST(test_add_refreshes_known_peer);
+    RUN_TEST(test_table_full_and_empty_host);
+    RUN_TEST(test_expire_keeps_pinned_and_fresh);
+    RUN_TEST(test_failures_back_off);
+
+    // Frames and history
+    RUN_TEST(test_json_number);
+    RUN_TEST(test_frame_online_and_stale);
+    RUN_TEST(test_history_one_point_per_interval);
+    RUN_TEST(test_history_ring_wraps);
+    RUN_TEST(test_history_since);
+    RUN_TEST(test_state_lists_local_then_peers);
+
+    // Event stream
+    RUN_TEST(test_sse_frames_and_skips);
+    RUN_TEST(test_sse_byte_at_a_time);
+    RUN_TEST(test_sse_rejected_status);
+    RUN_TEST(test_sse_drops_oversized_event);
+
+    return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/**
+ * test_loop_profiler.cpp
+ *
+ * Tests for the per-phase loop profiler on the native platform.
+ *
+ * Covers window publication (p99 from the log2 histogram, max, sample
+ * count), the overrun flag (more than 1% over budget, minimum samples,
+ * clearing on a good window), the since-boot peak and over-budget count,
+ * PhaseLap timing and the phase names.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <thread>
+#include <chrono>
+
+#include "loop_profiler.h"
+#include "loop_profiler.cpp"
+#include "metrics.cpp"
+
+static const uint64_t WINDOW_US = (uint64_t)PROFILE_WINDOW_MS * 1000ULL;
+
+// Record n passes of us each, spread over the window starting at startUs
+static void fill(LoopPhase p, uint32_t n, uint32_t us, uint64_t startUs) {
+    for (uint32_t i = 0; i < n; i++) {
+        loopProfilerRecord(p, us, startUs + i * 1000ULL);
+    }
+}
+
+// Close the window that started at startUs
+static void closeAt(LoopPhase p, uint64_t startUs) {
+    loopProfilerRecord(p, 1, startUs + WINDOW_US);
+}
+
+void setUp(void) {
+    loopProfilerReset();
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Windows
+// --------------------------------------------------------------------------
+
+void test_nothing_published_before_window_closes(void) {
+    fill(LoopPhase::WEB, 100, 9000, 0);
+    LoopPhaseStats s = loopProfilerRead(LoopPhase::WEB);
+    TEST_ASSERT_EQUAL_UINT32(0, s.samples);
+    TEST_ASSERT_FALSE(s.flagged);
+    TEST_ASSERT_EQUAL_UINT32(PROFILE_BUDGET_WEB_US, s.budgetUs);
+    TEST_ASSERT_EQUAL_UINT32(0, loopProfilerOverruns());
+}
+
+void test_window_publishes_p99_and_max(void) {
+    fill(LoopPhase::TEMP, 99, 50, 0);        // <= 64 us bucket
+    fill(LoopPhase::TEMP, 1, 3000, 500000);  // One outlier is the top 1%
+    closeAt(LoopPhase::TEMP, 0);
+
+    LoopPhaseStats s = loopProfilerRead(LoopPhase::TEMP);
+    TEST_ASSERT_EQUAL_UINT32(100, s.samples);
+    TEST_ASSERT_EQUAL_UINT32(64, s.p99Us);
+    TEST_ASSERT_EQUAL_UINT32(3000, s.maxUs);
+}
+
+void test_p99_capped_at_max(void) {
+    fill(LoopPhase::FAN, 100, 100, 0);       // Bucket bound 128
+    closeAt(LoopPhase::FAN, 0);
+    TEST_ASSERT_EQUAL_UINT32(100, loopProfilerRead(LoopPhase::FAN).p99Us);
+}
+
+void test_closing_sample_opens_next_window(void) {
+    fill(LoopPhase::OTA, 60, 10, 0);
+    loopProfilerRecord(LoopPhase::OTA, 700, WINDOW_US);
+    // Second window holds only the closing sample
+    loopProfilerRecord(LoopPhase::OTA, 1, 2 * WINDOW_US);
+    LoopPhaseStats s = loopProfilerRead(LoopPhase::OTA);
+    TEST_ASSERT_EQUAL_UINT32(1, s.samples);
+    TEST_ASSERT_EQUAL_UINT32(700, s.maxUs);
+}
+
+// --------------------------------------------------------------------------
+// Overrun flag
+// --------------------------------------------------------------------------
+
+void test_flagged_when_p99_over_budget(void) {
+    fill(LoopPhase::PID, 98, 100, 0);
+    fill(LoopPhase::PID, 2, PROFILE_BUDGET_PID_US + 1, 200000);
+    closeAt(LoopPhase::PID, 0);
+
+    TEST_ASSERT_TRUE(loopProfilerRead(LoopPhase::PID).flagged);
+    TEST_ASSERT_EQUAL_UINT32(1u << (uint8_t)LoopPhase::PID, loopProfilerOverruns());
+}
+
+void test_one_percent_over_is_not_flagged(void) {
+    fill(LoopPhase::PID, 99, 100, 0);
+    fill(LoopPhase::PID, 1, PROFILE_BUDGET_PID_US * 10, 200000);
+    closeAt(LoopPhase::PID, 0);
+
+    LoopPhaseStats s = loopProfilerRead(LoopPhase::PID);
+    TEST_ASSERT_FALSE(s.flagged);
+    TEST_ASSERT_TRUE(s.p99Us <= PROFILE_BUDGET_PID_US);
+    TEST_ASSERT_EQUAL_UINT32(0, loopProfilerOverruns());
+}
+
+void test_too_few_samples_never_flag(void) {
+    fill(LoopPhase::SESSION, PROFILE_MIN_SAMPLES - 1, PROFILE_BUDGET_SESSION_US * 2, 0);
+    closeAt(LoopPhase::SESSION, 0);
+    TEST_ASSERT_FALSE(loopProfilerRead(LoopPhase::SESSION).flagged);
+}
+
+void test_flag_clears_after_good_window(void) {
+    fill(LoopPhase::LVGL, 100, PROFILE_BUDGET_LVGL_US * 2, 0);
+    fill(LoopPhase::WEB, 100, PROFILE_BUDGET_WEB_US * 2, 0);
+    closeAt(LoopPhase::LVGL, 0);
+    closeAt(LoopPhase::WEB, 0);
+    TEST_ASSERT_EQUAL_UINT32((1u << (uint8_t)LoopPhase::LVGL) | (1u << (uint8_t)LoopPhase::WEB),
+                             loopProfilerOverruns());
+
+    fill(LoopPhase::LVGL, 100, 1000, WINDOW_US + 1000);
+    closeAt(LoopPhase::LVGL, WINDOW_US);
+    TEST_ASSERT_FALSE(loopProfilerRead(LoopPhase::LVGL).flagged);
+    TEST_ASSERT_EQUAL_UINT32(1u << (uint8_t)LoopPhase::WEB, loopProfilerOverruns());
+}
+
+void test_peak_and_over_budget_span_windows(void) {
+    fill(LoopPhase::ALARMS, 60, 5000, 0);
+    closeAt(LoopPhase::ALARMS, 0);
+    fill(LoopPhase::ALARMS, 60, 10, WINDOW_US + 1000);
+    closeAt(LoopPhase::ALARMS, WINDOW_US);
+
+    LoopPhaseStats s = loopProfilerRead(LoopPhase::ALARMS);
+    TEST_ASSERT_EQUAL_UINT32(10, s.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(5000, s.peakUs);
+    TEST_ASSERT_EQUAL_UINT32(60, s.overBudget);
+}
+
+// --------------------------------------------------------------------------
+// PhaseLap and names
+// --------------------------------------------------------------------------
+
+void test_lap_records_time_since_previous_end(void) {
+    PhaseLap lap;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    lap.end(LoopPhase::DISPLAY);
+    lap.end(LoopPhase::LVGL);   // Back to back: near zero
+    loopProfilerRecord(LoopPhase::DISPLAY, 0, metricsNowUs() + WINDOW_US);
+    loopProfilerRecord(LoopPhase::LVGL, 0, metricsNowUs() + WINDOW_US);
+
+    TEST_ASSERT_TRUE(loopProfilerRead(LoopPhase::DISPLAY).maxUs >= 2000);
+    TEST_ASSERT_TRUE(loopProfilerRead(LoopPhase::LVGL).maxUs < 2000);
+}
+
+void test_phase_names(void) {
+    TEST_ASSERT_EQUAL_STRING("temp", loopPhaseName(LoopPhase::TEMP));
+    TEST_ASSERT_EQUAL_STRING("split_range", loopPhaseName(LoopPhase::SPLIT_RANGE));
+    TEST_ASSERT_EQUAL_STRING("lvgl", loopPhaseName(LoopPhase::LVGL));
+    TEST_ASSERT_EQUAL_STRING("?", loopPhaseName(LoopPhase::COUNT));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_nothing_published_before_window_closes);
+    RUN_TEST(test_window_publishes_p99_and_max);
+    RUN_TEST(test_p99_capped_at_max);
+    RUN_TEST(test_closing_sample_opens_next_window);
+    RUN_TEST(test_flagged_when_p99_over_budget);
+    RUN_TEST(test_one_percent_over_is_not_flagged);
+    RUN_TEST(test_too_few_samples_never_flag);
+    RUN_TEST(test_flag_clears_after_good_window);
+    RUN_TEST(test_peak_and_over_budget_span_windows);
+    RUN_TEST(test_lap_records_time_since_previous_end);
+    RUN_TEST(test_phase_names);
+
+    return UNITY_END();
+}
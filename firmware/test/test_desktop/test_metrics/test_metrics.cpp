@@ -0,0 +1,168 @@
+/**
+ * test_metrics.cpp
+ *
+ * Tests for the hot-path metrics on the native platform.
+ *
+ * Covers bucket placement (bounds are inclusive), counts and sums, the
+ * scoped timer, reads racing a writer, counters, and the Prometheus text
+ * output: cumulative buckets in seconds, +Inf equal to _count, and gauge
+ * lines with and without labels.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "metrics.h"
+#include "metrics.cpp"
+
+static std::string text;
+
+static void collect(const char* s, size_t len, void* ctx) {
+    static_cast<std::string*>(ctx)->append(s, len);
+}
+
+static bool contains(const char* needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+void setUp(void) {
+    metricsReset();
+    text.clear();
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+
+void test_observe_places_value_in_bucket(void) {
+    metricObserve(Metric::PID_COMPUTE, 80);      // <= 100 us
+    metricObserve(Metric::PID_COMPUTE, 100);     // Bound is inclusive
+    metricObserve(Metric::PID_COMPUTE, 101);     // <= 250 us
+    metricObserve(Metric::PID_COMPUTE, 5000000); // Past the last bound: +Inf only
+
+    MetricSnapshot s = metricRead(Metric::PID_COMPUTE);
+    TEST_ASSERT_EQUAL_UINT32(2, s.buckets[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, s.buckets[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, s.buckets[METRIC_BUCKETS]);
+    TEST_ASSERT_EQUAL_UINT32(4, s.count);
+    TEST_ASSERT_TRUE(s.sumUs == 80 + 100 + 101 + 5000000ULL);
+}
+
+void test_metrics_are_independent(void) {
+    metricObserve(Metric::LOOP_PERIOD, 10000);
+    TEST_ASSERT_EQUAL_UINT32(1, metricRead(Metric::LOOP_PERIOD).count);
+    TEST_ASSERT_EQUAL_UINT32(0, metricRead(Metric::UI_HANDLER).count);
+}
+
+void test_timer_records_scope(void) {
+    {
+        MetricTimer t(Metric::SESSION_FLUSH);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    MetricSnapshot s = metricRead(Metric::SESSION_FLUSH);
+    TEST_ASSERT_EQUAL_UINT32(1, s.count);
+    TEST_ASSERT_TRUE(s.sumUs >= 2000);
+}
+
+void test_read_during_observe_is_monotonic(void) {
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (uint32_t i = 0; i < 100000; i++) metricObserve(Metric::WEB_UPDATE, i % 3000);
+        done = true;
+    });
+    uint32_t last = 0;
+    bool monotonic = true;
+    while (!done) {
+        uint32_t n = metricRead(Metric::WEB_UPDATE).count;
+        if (n < last) monotonic = false;
+        last = n;
+    }
+    writer.join();
+
+    TEST_ASSERT_TRUE(monotonic);
+    TEST_ASSERT_EQUAL_UINT32(100000, metricRead(Metric::WEB_UPDATE).count);
+}
+
+void test_counter_accumulates(void) {
+    counterAdd(Counter::SESSION_FLUSH_BYTES, 256);
+    counterAdd(Counter::SESSION_FLUSH_BYTES, 512);
+    TEST_ASSERT_EQUAL_UINT32(768, counterRead(Counter::SESSION_FLUSH_BYTES));
+}
+
+void test_reset_clears_everything(void) {
+    metricObserve(Metric::TEMP_UPDATE, 300);
+    counterAdd(Counter::SESSION_FLUSH_BYTES, 1);
+    metricsReset();
+    TEST_ASSERT_EQUAL_UINT32(0, metricRead(Metric::TEMP_UPDATE).count);
+    TEST_ASSERT_EQUAL_UINT32(0, counterRead(Counter::SESSION_FLUSH_BYTES));
+}
+
+void test_write_cumulative_buckets_in_seconds(void) {
+    metricObserve(Metric::UI_HANDLER, 90);
+    metricObserve(Metric::UI_HANDLER, 2000);
+    metricObserve(Metric::UI_HANDLER, 2000000);
+    metricsWrite(collect, &text);
+
+    TEST_ASSERT_TRUE(contains("# TYPE pitclaw_ui_handler_seconds histogram\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_bucket{le=\"0.0001\"} 1\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_bucket{le=\"0.001\"} 1\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_bucket{le=\"0.0025\"} 2\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_bucket{le=\"1\"} 2\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_bucket{le=\"+Inf\"} 3\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_sum 2.002090\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ui_handler_seconds_count 3\n"));
+}
+
+void test_write_lists_every_metric_and_counter(void) {
+    counterAdd(Counter::SESSION_FLUSH_BYTES, 4096);
+    metricsWrite(collect, &text);
+
+    TEST_ASSERT_TRUE(contains("pitclaw_loop_period_seconds_count 0\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_session_flush_seconds_count 0\n"));
+    TEST_ASSERT_TRUE(contains("# TYPE pitclaw_session_flush_bytes_total counter\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_session_flush_bytes_total 4096\n"));
+}
+
+void test_gauge_lines(void) {
+    metricsGauge(collect, &text, "pitclaw_heap_free_bytes", "Free heap", 143000);
+    metricsGauge(collect, &text, "pitclaw_ws_client_unacked_bytes", "Unacked bytes", 512, "client=\"3\"");
+    metricsGauge(collect, &text, "pitclaw_ws_client_unacked_bytes", nullptr, 0, "client=\"4\"");
+
+    TEST_ASSERT_TRUE(contains("# TYPE pitclaw_heap_free_bytes gauge\npitclaw_heap_free_bytes 143000\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ws_client_unacked_bytes{client=\"3\"} 512\n"));
+    TEST_ASSERT_TRUE(contains("pitclaw_ws_client_unacked_bytes{client=\"4\"} 0\n"));
+    // The unlabelled-help sample adds no second TYPE line
+    TEST_ASSERT_EQUAL(text.find("# TYPE pitclaw_ws_client_unacked_bytes"),
+                      text.rfind("# TYPE pitclaw_ws_client_unacked_bytes"));
+}
+
+void test_external_counter_lines(void) {
+    metricsCounter(collect, &text, "pitclaw_ws_frames_total", "Frames built", 51234);
+    TEST_ASSERT_TRUE(contains("# TYPE pitclaw_ws_frames_total counter\npitclaw_ws_frames_total 51234\n"));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_observe_places_value_in_bucket);
+    RUN_TEST(test_metrics_are_independent);
+    RUN_TEST(test_timer_records_scope);
+    RUN_TEST(test_read_during_observe_is_monotonic);
+    RUN_TEST(test_counter_accumulates);
+    RUN_TEST(test_reset_clears_everything);
+    RUN_TEST(test_write_cumulative_buckets_in_seconds);
+    RUN_TEST(test_write_lists_every_metric_and_counter);
+    RUN_TEST(test_gauge_lines);
+    RUN_TEST(test_external_counter_lines);
+
+    return UNITY_END();
+}
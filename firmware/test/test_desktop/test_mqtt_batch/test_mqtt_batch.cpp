@@ -0,0 +1,249 @@
+/**
+ * test_mqtt_batch.cpp
+ *
+ * Tests for MQTT telemetry batching and delivery tracking on the native
+ * platform.
+ *
+ * Covers the batch frame layout (keyframe first, deltas after, each
+ * length-prefixed), batching while a QoS 1 publish is unacknowledged or
+ * the client refuses one, and the gap that an outage, a lost publish or
+ * an overflowing batch opens for replay from the session log.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "mqtt_batch.h"
+#include "mqtt_batch.cpp"
+#include "web_protocol.cpp"
+
+using bbq_protocol::DataPayload;
+
+static DataPayload sample(uint32_t ts, float pit = 225.0f) {
+    DataPayload d;
+    memset(&d, 0, sizeof(d));
+    d.ts = ts;
+    d.temp[PROBE_PIT] = pit;
+    d.temp[PROBE_MEAT1] = 150.0f;
+    d.temp[PROBE_MEAT2] = NAN;
+    d.fan = 40;
+    d.sp = 225.0f;
+    d.fanMode = "fan_and_damper";
+    return d;
+}
+
+static uint16_t frameLen(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// MqttBatcher
+// --------------------------------------------------------------------------
+
+void test_batch_header_and_frames(void) {
+    static MqttBatcher b;
+    b.reset();
+    TEST_ASSERT_TRUE(b.add(sample(100)));
+    TEST_ASSERT_TRUE(b.add(sample(105, 226.0f)));
+
+    const uint8_t* p = b.data();
+    TEST_ASSERT_EQUAL_HEX8(BIN_FRAME_BATCH, p[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, p[1]);
+
+    // First frame is a keyframe, the second carries only what changed
+    uint16_t first = frameLen(p + 2);
+    const uint8_t* f1 = p + 4;
+    TEST_ASSERT_EQUAL_HEX8(BIN_FRAME_DATA, f1[0]);
+    const uint8_t* f2len = f1 + first;
+    uint16_t second = frameLen(f2len);
+    const uint8_t* f2 = f2len + 2;
+    uint16_t mask = (uint16_t)(f2[1] | (f2[2] << 8));
+    TEST_ASSERT_EQUAL_HEX16(bbq_protocol::BF_PIT, mask);
+    TEST_ASSERT_TRUE(second < first);
+    TEST_ASSERT_EQUAL_UINT32(2 + 2 + first + 2 + second, b.size());
+    TEST_ASSERT_EQUAL_UINT32(100, b.firstTs());
+    TEST_ASSERT_EQUAL_UINT32(105, b.lastTs());
+}
+
+void test_batch_caps_sample_count(void) {
+    static MqttBatcher b;
+    b.reset();
+    for (uint32_t i = 0; i < MQTT_BATCH_MAX; i++) TEST_ASSERT_TRUE(b.add(sample(i)));
+    TEST_ASSERT_TRUE(b.full());
+    TEST_ASSERT_FALSE(b.add(sample(999)));
+    TEST_ASSERT_EQUAL_UINT8(MQTT_BATCH_MAX, b.count());
+}
+
+void test_reset_starts_with_keyframe(void) {
+    static MqttBatcher b;
+    b.reset();
+    b.add(sample(1));
+    size_t keyLen = frameLen(b.data() + 2);
+    b.reset();
+    b.add(sample(2));
+    TEST_ASSERT_EQUAL_UINT32(keyLen, frameLen(b.data() + 2));
+}
+
+// --------------------------------------------------------------------------
+// MqttFlow
+// --------------------------------------------------------------------------
+
+void test_fast_link_publishes_each_sample(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(1);
+    f.linkUp();
+    f.addSample(sample(100));
+    TEST_ASSERT_TRUE(f.liveReady(0));
+    f.livePublished(7, 0);
+    TEST_ASSERT_EQUAL_UINT16(7, f.inflightId());
+    TEST_ASSERT_FALSE(f.liveReady(0));
+    f.acked(7);
+    TEST_ASSERT_EQUAL_UINT32(100, f.deliveredTs());
+    TEST_ASSERT_FALSE(f.gapOpen());
+}
+
+void test_slow_ack_batches_samples(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(1);
+    f.linkUp();
+    f.addSample(sample(100));
+    f.livePublished(1, 0);
+    for (uint32_t ts = 105; ts <= 120; ts += 5) f.addSample(sample(ts));
+    TEST_ASSERT_FALSE(f.liveReady(1000));
+    f.acked(1);
+    TEST_ASSERT_TRUE(f.liveReady(1000));
+    TEST_ASSERT_EQUAL_UINT8(4, f.live().count());
+    TEST_ASSERT_EQUAL_UINT32(105, f.live().firstTs());
+}
+
+void test_refused_publish_keeps_batch_and_waits(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(0);
+    f.linkUp();
+    f.addSample(sample(100));
+    f.livePublished(0, 1000);
+    TEST_ASSERT_FALSE(f.liveReady(1000 + MQTT_RETRY_MS - 1));
+    f.addSample(sample(105));
+    TEST_ASSERT_TRUE(f.liveReady(1000 + MQTT_RETRY_MS));
+    TEST_ASSERT_EQUAL_UINT8(2, f.live().count());
+    f.livePublished(1, 1000 + MQTT_RETRY_MS);       // QoS 0: delivered at once
+    TEST_ASSERT_EQUAL_UINT32(105, f.deliveredTs());
+    TEST_ASSERT_EQUAL_UINT16(0, f.inflightId());
+}
+
+void test_outage_opens_gap_replayed_after_resume(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(1);
+    f.linkUp();
+    f.addSample(sample(100));
+    f.livePublished(1, 0);
+    f.acked(1);
+
+    f.linkDown();
+    f.addSample(sample(105));        // Left to the session log
+    f.addSample(sample(110));
+    TEST_ASSERT_TRUE(f.gapOpen());
+
+    uint32_t from, to;
+    f.linkUp();
+    TEST_ASSERT_FALSE(f.backfillDue(0, from, to));   // Live resumes first
+    f.addSample(sample(115));
+    f.livePublished(2, 0);
+    f.acked(2);
+
+    TEST_ASSERT_TRUE(f.backfillDue(0, from, to));
+    TEST_ASSERT_EQUAL_UINT32(100, from);
+    TEST_ASSERT_EQUAL_UINT32(115, to);
+
+    f.historyPublished(3, 110, 0);
+    TEST_ASSERT_FALSE(f.backfillDue(0, from, to));   // One publish in flight at a time
+    f.acked(3);
+    TEST_ASSERT_TRUE(f.backfillDue(0, from, to));
+    TEST_ASSERT_EQUAL_UINT32(110, from);
+    f.backfillDone();
+    TEST_ASSERT_FALSE(f.gapOpen());
+    TEST_ASSERT_EQUAL_UINT32(1, f.gapsOpened());
+}
+
+void test_lost_ack_opens_gap(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(1);
+    f.linkUp();
+    f.addSample(sample(100));
+    f.livePublished(1, 0);
+    f.acked(1);
+    f.addSample(sample(105));
+    f.livePublished(2, 1000);
+    f.tick(1000 + MQTT_ACK_TIMEOUT_MS - 1);
+    TEST_ASSERT_FALSE(f.gapOpen());
+    f.tick(1000 + MQTT_ACK_TIMEOUT_MS);
+    TEST_ASSERT_TRUE(f.gapOpen());
+    TEST_ASSERT_EQUAL_UINT16(0, f.inflightId());
+
+    // A late PUBACK for the expired id changes nothing
+    f.acked(2);
+    TEST_ASSERT_EQUAL_UINT32(100, f.deliveredTs());
+}
+
+void test_full_batch_spills_into_gap(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(1);
+    f.linkUp();
+    f.addSample(sample(1));
+    f.livePublished(1, 0);                       // Never acked
+    for (uint32_t i = 0; i < MQTT_BATCH_MAX; i++) f.addSample(sample(10 + i));
+    TEST_ASSERT_FALSE(f.gapOpen());
+    f.addSample(sample(500));
+    TEST_ASSERT_TRUE(f.gapOpen());
+    TEST_ASSERT_EQUAL_UINT8(1, f.live().count());
+    TEST_ASSERT_EQUAL_UINT32(500, f.live().firstTs());
+}
+
+void test_backfill_window_is_capped(void) {
+    static MqttFlow f;
+    f = MqttFlow();
+    f.begin(0);
+    f.addSample(sample(10));                     // Never connected: gap from 0
+    f.linkUp();
+    f.addSample(sample(10 + MQTT_BACKFILL_MAX_S * 2));
+    f.livePublished(1, 0);
+    uint32_t from, to;
+    TEST_ASSERT_TRUE(f.backfillDue(0, from, to));
+    TEST_ASSERT_EQUAL_UINT32(10 + MQTT_BACKFILL_MAX_S * 2, to);
+    TEST_ASSERT_EQUAL_UINT32(to - MQTT_BACKFILL_MAX_S, from);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // MqttBatcher
+    RUN_TEST(test_batch_header_and_frames);
+    RUN_TEST(test_batch_caps_sample_count);
+    RUN_TEST(test_reset_starts_with_keyframe);
+
+    // MqttFlow
+    RUN_TEST(test_fast_link_publishes_each_sample);
+    RUN_TEST(test_slow_ack_batches_samples);
+    RUN_TEST(test_refused_publish_keeps_batch_and_waits);
+    RUN_TEST(test_outage_opens_gap_replayed_after_resume);
+    RUN_TEST(test_lost_ack_opens_gap);
+    RUN_TEST(test_full_batch_spills_into_gap);
+    RUN_TEST(test_backfill_window_is_capped);
+
+    return UNITY_END();
+}
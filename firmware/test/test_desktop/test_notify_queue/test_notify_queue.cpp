@@ -0,0 +1,304 @@
+/**
+ * test_notify_queue.cpp
+ *
+ * Tests for the notification queue on the native platform.
+ *
+ * Covers onset detection from telemetry snapshots (each alarm or error is
+ * reported once, again only after it clears), the bounded queue, and the
+ * dispatcher's delivery rules: every enabled sink, retry with backoff,
+ * permanent rejection, staleness, the rate limit and offline hold. Sends
+ * go to a scripted fake instead of the network.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "notify_queue.h"
+#include "notify_queue.cpp"
+
+static TelemetrySnapshot snap;
+static NotifyTracker tracker;
+static Notification out[8];
+
+// Fake sender: records calls and answers from a script per sink
+struct FakeSink {
+    uint32_t     calls;
+    NotifyResult answer;
+    char         lastTitle[32];
+};
+static FakeSink fake[NOTIFY_SINKS];
+
+static NotifyResult fakeSend(NotifySink sink, const Notification& n, void*) {
+    FakeSink& f = fake[(uint8_t)sink];
+    f.calls++;
+    strncpy(f.lastTitle, n.title, sizeof(f.lastTitle) - 1);
+    return f.answer;
+}
+
+void setUp(void) {
+    memset(&snap, 0, sizeof(snap));
+    memset(fake, 0, sizeof(fake));
+    for (uint8_t s = 0; s < NOTIFY_SINKS; s++) fake[s].answer = NotifyResult::SENT;
+    notifyTrackerReset(tracker);
+    snap.setpoint = 225.0f;
+    snap.temp[PROBE_PIT] = 262.0f;
+    snap.temp[PROBE_MEAT1] = 203.0f;
+    snap.meatTarget[0] = 203.0f;
+}
+
+void tearDown(void) {}
+
+static Notification make(const char* title, uint32_t createdMs) {
+    Notification n;
+    memset(&n, 0, sizeof(n));
+    n.createdMs = createdMs;
+    strncpy(n.title, title, sizeof(n.title) - 1);
+    return n;
+}
+
+static const uint8_t BOTH = (1u << (uint8_t)NotifySink::PUSHOVER)
+                          | (1u << (uint8_t)NotifySink::WEBHOOK);
+
+// --------------------------------------------------------------------------
+// Onset detection
+// --------------------------------------------------------------------------
+
+void test_alarm_onset_reported_once(void) {
+    snap.alarms[0] = AlarmType::PIT_HIGH;
+    snap.alarmCount = 1;
+    TEST_ASSERT_EQUAL_UINT8(1, notifyCollect(tracker, snap, true, out, 8));
+    TEST_ASSERT_EQUAL_STRING("Pit high", out[0].title);
+    TEST_ASSERT_EQUAL_STRING("Pit at 262F, setpoint 225F", out[0].message);
+    TEST_ASSERT_EQUAL_STRING("pit_high", notifyTypeName(out[0]));
+    TEST_ASSERT_EQUAL_UINT8(0, notifyCollect(tracker, snap, true, out, 8));
+}
+
+void test_alarm_reported_again_after_clearing(void) {
+    snap.alarms[0] = AlarmType::MEAT1_DONE;
+    snap.alarmCount = 1;
+    notifyCollect(tracker, snap, true, out, 8);
+    snap.alarmCount = 0;
+    TEST_ASSERT_EQUAL_UINT8(0, notifyCollect(tracker, snap, true, out, 8));
+    snap.alarmCount = 1;
+    TEST_ASSERT_EQUAL_UINT8(1, notifyCollect(tracker, snap, true, out, 8));
+    TEST_ASSERT_EQUAL_STRING("Meat 1 done", out[0].title);
+    TEST_ASSERT_EQUAL_INT8(1, out[0].priority);
+}
+
+void test_error_onsets_skip_wifi_and_overrun(void) {
+    snap.errors[0].code = ErrorCode::WIFI_LOST;
+    snap.errors[0].probeIndex = 0xFF;
+    snap.errors[1].code = ErrorCode::LOOP_OVERRUN;
+    snap.errors[1].probeIndex = 0xFF;
+    snap.errors[2].code = ErrorCode::FIRE_OUT;
+    snap.errors[2].probeIndex = 0xFF;
+    strcpy(snap.errors[2].message, "Fire may be out");
+    snap.errorCount = 3;
+    TEST_ASSERT_EQUAL_UINT8(1, notifyCollect(tracker, snap, true, out, 8));
+    TEST_ASSERT_EQUAL_STRING("Fire out", out[0].title);
+    TEST_ASSERT_EQUAL_STRING("Fire may be out", out[0].message);
+    TEST_ASSERT_EQUAL_UINT8(0, notifyCollect(tracker, snap, true, out, 8));
+}
+
+void test_same_error_on_another_probe_is_new(void) {
+    snap.errors[0].code = ErrorCode::PROBE_OPEN;
+    snap.errors[0].probeIndex = 1;
+    snap.errorCount = 1;
+    notifyCollect(tracker, snap, true, out, 8);
+    snap.errors[1].code = ErrorCode::PROBE_OPEN;
+    snap.errors[1].probeIndex = 2;
+    snap.errorCount = 2;
+    TEST_ASSERT_EQUAL_UINT8(1, notifyCollect(tracker, snap, true, out, 8));
+    TEST_ASSERT_EQUAL_UINT8(2, out[0].probe);
+}
+
+// --------------------------------------------------------------------------
+// Queue
+// --------------------------------------------------------------------------
+
+void test_queue_drops_newest_when_full(void) {
+    static NotifyQueue q;
+    for (int i = 0; i < NOTIFY_QUEUE_LEN; i++) {
+        TEST_ASSERT_TRUE(q.post(make("x", i)));
+    }
+    TEST_ASSERT_FALSE(q.post(make("late", 99)));
+    TEST_ASSERT_EQUAL_UINT32(1, q.dropped());
+
+    Notification n;
+    TEST_ASSERT_TRUE(q.take(n));
+    TEST_ASSERT_EQUAL_UINT32(0, n.createdMs);
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_QUEUE_LEN - 1, q.size());
+}
+
+// --------------------------------------------------------------------------
+// Dispatcher
+// --------------------------------------------------------------------------
+
+void test_delivers_to_every_enabled_sink(void) {
+    static NotifyQueue q;
+    NotifyDispatcher d(q);
+    d.setSender(fakeSend, nullptr);
+    d.setSinks(BOTH);
+    q.post(make("a", 0));
+    q.post(make("b", 0));
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_IDLE_MS, d.service(10, true));
+    TEST_ASSERT_EQUAL_UINT32(2, fake[0].calls);
+    TEST_ASSERT_EQUAL_UINT32(2, fake[1].calls);
+    TEST_ASSERT_EQUAL_UINT32(4, d.sent());
+    TEST_ASSERT_FALSE(d.busy());
+}
+
+void test_retry_backs_off_then_succeeds(void) {
+    static NotifyQueue q;
+    NotifyDispatcher d(q);
+    d.setSender(fakeSend, nullptr);
+    d.setSinks(1u << (uint8_t)NotifySink::WEBHOOK);
+    fake[1].answer = NotifyResult::RETRY;
+    q.post(make("a", 0));
+
+    d.service(0, true);
+    d.service(NOTIFY_RETRY_BASE_MS - 1, true);
+    TEST_ASSERT_EQUAL_UINT32(1, fake[1].calls);
+    d.service(NOTIFY_RETRY_BASE_MS, true);
+    TEST_ASSERT_EQUAL_UINT32(2, fake[1].calls);
+    d.service(NOTIFY_RETRY_BASE_MS * 3 - 1, true);              // Second wait is twice the first
+    TEST_ASSERT_EQUAL_UINT32(2, fake[1].calls);
+
+    fake[1].answer = NotifyResult::SENT;
+    d.service(NOTIFY_RETRY_BASE_MS * 3, true);
+    TEST_ASSERT_EQUAL_UINT32(3, fake[1].calls);
+    TEST_ASSERT_EQUAL_UINT32(1, d.sent());
+    TEST_ASSERT_FALSE(d.busy());
+}
+
+void test_failing_sink_gives_up_others_unaffected(void) {
+    static NotifyQueue q;
+    NotifyDispatcher d(q);
+    d.setSender(fakeSend, nullptr);
+    d.setSinks(BOTH);
+    fake[1].answer = NotifyResult::RETRY;
+    q.post(make("a", 0));
+
+    // The sleep service() asks for is never longer than the next retry
+    uint32_t t = 0;
+    do {
+        t += d.service(t, true);
+    } while (d.busy() && t < NOTIFY_MAX_AGE_MS);
+    TEST_ASSERT_EQUAL_UINT32(1, fake[0].calls);
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_MAX_ATTEMPTS, fake[1].calls);
+    TEST_ASSERT_EQUAL_UINT32(1, d.failed());
+    TEST_ASSERT_FALSE(d.busy());
+}
+
+void test_rejected_is_not_retried(void) {
+    static NotifyQueue q;
+    NotifyDispatcher d(q);
+    d.setSender(fakeSend, nullptr);
+    d.setSinks(1u << (uint8_t)NotifySink::PUSHOVER);
+    fake[0].answer = NotifyResult::REJECTED;
+    q.post(make("a", 0));
+    d.service(0, true);
+    d.service(100000, true);
+    TEST_ASSERT_EQUAL_UINT32(1, fake[0].calls);
+    TEST_ASSERT_EQUAL_UINT32(1, d.failed());
+}
+
+void test_offline_holds_then_expires(void) {
+    static NotifyQueue q;
+    NotifyDispatcher d(q);
+    d.setSender(fakeSend, nullptr);
+    d.setSinks(BOTH);
+    q.post(make("a", 0));
+    d.service(1000, false);
+    TEST_ASSERT_TRUE(d.busy());
+    TEST_ASSERT_EQUAL_UINT32(0, fake[0].calls);
+
+    d.service(NOTIFY_MAX_AGE_MS, true);
+    TEST_ASSERT_EQUAL_UINT32(0, fake[0].calls);
+    TEST_ASSERT_EQUAL_UINT32(1, d.expired());
+    TEST_ASSERT_FALSE(d.busy());
+}
+
+void test_rate_limit_spaces_a_burst(void) {
+    static NotifyQueue q;
+    NotifyDispatcher d(q);
+    d.setSender(fakeSend, nullptr);
+    d.setSinks(1u << (uint8_t)NotifySink::PUSHOVER);
+    for (int i = 0; i < NOTIFY_RATE_BURST + 2; i++) q.post(make("a", 0));
+
+    uint32_t wait = d.service(0, true);
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_RATE_BURST, fake[0].calls);
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_IDLE_MS, wait);     // Capped at the idle wake
+    d.service(NOTIFY_RATE_REFILL_MS - 1, true);
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_RATE_BURST, fake[0].calls);
+    d.service(NOTIFY_RATE_REFILL_MS, true);
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_RATE_BURST + 1, fake[0].calls);
+}
+
+void test_backoff_doubles_and_caps(void) {
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_RETRY_BASE_MS, notifyBackoffMs(1));
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_RETRY_BASE_MS * 2, notifyBackoffMs(2));
+    TEST_ASSERT_EQUAL_UINT32(NOTIFY_RETRY_MAX_MS, notifyBackoffMs(20));
+}
+
+// --------------------------------------------------------------------------
+// Payloads
+// --------------------------------------------------------------------------
+
+void test_pushover_body_is_url_encoded(void) {
+    Notification n = make("Meat 1 done", 0);
+    strcpy(n.message, "Meat 1 at 203F & resting");
+    n.priority = 1;
+    char buf[256];
+    size_t len = notifyFormatPushover(n, "tok", "usr", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("token=tok&user=usr&title=Meat%201%20done"
+                             "&message=Meat%201%20at%20203F%20%26%20resting&priority=1", buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), len);
+    TEST_ASSERT_EQUAL_UINT32(0, notifyFormatPushover(n, "tok", "usr", buf, 20));
+}
+
+void test_webhook_body_is_escaped_json(void) {
+    Notification n = make("Probe \"pit\"", 1000);
+    n.kind = NotifyKind::ERROR;
+    n.code = (uint8_t)ErrorCode::PROBE_OPEN;
+    n.probe = 0;
+    strcpy(n.message, "Pit probe disconnected");
+    char buf[256];
+    TEST_ASSERT_TRUE(notifyFormatWebhook(n, "bbq", 3500, buf, sizeof(buf)) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"device\":\"bbq\",\"kind\":\"error\",\"type\":\"probe_open\","
+                             "\"title\":\"Probe \\\"pit\\\"\",\"message\":\"Pit probe disconnected\","
+                             "\"priority\":0,\"value\":0.0,\"probe\":0,\"ageMs\":2500}", buf);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Onset detection
+    RUN_TEST(test_alarm_onset_reported_once);
+    RUN_TEST(test_alarm_reported_again_after_clearing);
+    RUN_TEST(test_error_onsets_skip_wifi_and_overrun);
+    RUN_TEST(test_same_error_on_another_probe_is_new);
+
+    // Queue
+    RUN_TEST(test_queue_drops_newest_when_full);
+
+    // Dispatcher
+    RUN_TEST(test_delivers_to_every_enabled_sink);
+    RUN_TEST(test_retry_backs_off_then_succeeds);
+    RUN_TEST(test_failing_sink_gives_up_others_unaffected);
+    RUN_TEST(test_rejected_is_not_retried);
+    RUN_TEST(test_offline_holds_then_expires);
+    RUN_TEST(test_rate_limit_spaces_a_burst);
+    RUN_TEST(test_backoff_doubles_and_caps);
+
+    // Payloads
+    RUN_TEST(test_pushover_body_is_url_encoded);
+    RUN_TEST(test_webhook_body_is_escaped_json);
+
+    return UNITY_END();
+}
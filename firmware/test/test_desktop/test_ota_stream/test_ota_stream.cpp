@@ -0,0 +1,329 @@
+/**
+ * test_ota_stream.cpp
+ *
+ * Tests for the OTA image decoder on the native platform: raw images pass
+ * through, gzipped ones inflate (stored, fixed and dynamic blocks) with the
+ * trailer checked, and truncated or corrupt input fails cleanly.
+ *
+ * The gzip vectors were made with Python's zlib/gzip modules.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Include the actual module under test
+#include "ota_stream.h"
+#include "ota_stream.cpp"
+
+// --------------------------------------------------------------------------
+// Test vectors
+// --------------------------------------------------------------------------
+
+// gzip -9 of squaresPayload(), named fw.bin (dynamic Huffman blocks)
+static const uint8_t kSquaresGz[] = {
+    0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x66, 0x77,
+    0x2e, 0x62, 0x69, 0x6e, 0x00, 0xed, 0xcf, 0xb1, 0xaa, 0x82, 0x00, 0x00,
+    0x05, 0xd0, 0x44, 0x17, 0xc1, 0xc1, 0x2d, 0xcc, 0xc1, 0xc5, 0x5d, 0x9d,
+    0x02, 0x5d, 0x5c, 0xca, 0x21, 0x0a, 0x74, 0xce, 0xcd, 0xc1, 0x21, 0x5a,
+    0x1a, 0x24, 0x70, 0x75, 0x14, 0xc4, 0xb6, 0xd6, 0x68, 0xb0, 0x21, 0x88,
+    0xa6, 0x48, 0xc4, 0xc1, 0xc9, 0x25, 0x12, 0xdc, 0x82, 0x68, 0x4a, 0xc4,
+    0xa9, 0xa0, 0xf9, 0xfd, 0xc7, 0xe3, 0x9e, 0x3f, 0x38, 0x3d, 0x82, 0xa2,
+    0x59, 0x4e, 0x54, 0x74, 0xd3, 0x59, 0x47, 0x49, 0xf1, 0x22, 0x45, 0x63,
+    0xb1, 0x49, 0xdf, 0xfd, 0xb1, 0x77, 0x78, 0x72, 0x56, 0x58, 0x32, 0xd3,
+    0xa8, 0x16, 0xdc, 0x33, 0x69, 0xed, 0x7e, 0xb3, 0x3d, 0x31, 0xbf, 0xf0,
+    0xfe, 0xd3, 0x38, 0x0e, 0x82, 0x8f, 0x53, 0x4f, 0x72, 0xf5, 0xac, 0x1c,
+    0xe5, 0xd3, 0x30, 0x1d, 0xdf, 0xec, 0xd6, 0x67, 0x77, 0x5a, 0xb5, 0x64,
+    0x92, 0x49, 0x17, 0xab, 0xaf, 0x50, 0x6b, 0xb6, 0x33, 0xea, 0xb2, 0x92,
+    0xda, 0xc3, 0x42, 0xfe, 0x5e, 0x03, 0x53, 0xe8, 0xb2, 0xd8, 0xd5, 0x07,
+    0xdf, 0xfb, 0x69, 0xe3, 0xd9, 0x23, 0x89, 0xa7, 0x7f, 0xcd, 0xa3, 0x2a,
+    0x8b, 0x3c, 0xcb, 0xf2, 0xa2, 0xac, 0x1e, 0xcd, 0x8f, 0xe6, 0xa5, 0x91,
+    0xed, 0x6d, 0x4e, 0xf7, 0xef, 0x40, 0x77, 0xe3, 0xac, 0x13, 0xcc, 0xe0,
+    0xfa, 0x95, 0x17, 0x87, 0x56, 0x5a, 0x5d, 0xa8, 0xd9, 0xb6, 0xd1, 0xc2,
+    0x97, 0x1a, 0x77, 0x93, 0x84, 0x59, 0x56, 0xda, 0x8e, 0xf5, 0x5b, 0xfb,
+    0x36, 0x4e, 0x87, 0x27, 0xf9, 0xa8, 0x9c, 0xd5, 0x7c, 0x52, 0x3b, 0x9f,
+    0x60, 0x70, 0x34, 0x9e, 0x3e, 0x7f, 0x99, 0x13, 0xfb, 0xd9, 0x6f, 0x67,
+    0x91, 0x67, 0x57, 0xa8, 0xa3, 0x29, 0x53, 0x86, 0x16, 0xf7, 0x3c, 0x78,
+    0xe3, 0xfe, 0x3b, 0xdd, 0x2c, 0x0c, 0x91, 0x7c, 0x15, 0x49, 0xb4, 0x76,
+    0x4c, 0x5d, 0x11, 0x39, 0x96, 0xa6, 0x88, 0x1e, 0xf2, 0xc8, 0x23, 0x8f,
+    0x3c, 0xf2, 0xc8, 0x23, 0x8f, 0x3c, 0xf2, 0xc8, 0x23, 0x8f, 0x3c, 0xf2,
+    0xc8, 0x23, 0x8f, 0x3c, 0xf2, 0xc8, 0x23, 0x8f, 0x3c, 0xf2, 0xc8, 0x23,
+    0x8f, 0x3c, 0xf2, 0xc8, 0x23, 0x8f, 0x3c, 0xf2, 0xc8, 0x23, 0x8f, 0x3c,
+    0xf2, 0xc8, 0x23, 0x8f, 0x3c, 0xf2, 0xff, 0x25, 0xff, 0x07, 0x6e, 0x06,
+    0x6a, 0x5b, 0x10, 0x27, 0x00, 0x00,
+};
+
+// textPayload(), fixed Huffman codes
+static const uint8_t kTextFixedGz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x2b, 0x28,
+    0xca, 0x4f, 0x4a, 0x55, 0x30, 0x50, 0x28, 0xc8, 0x2c, 0x51, 0x30, 0x32,
+    0x32, 0xe5, 0x2a, 0x00, 0xf3, 0x0d, 0xa1, 0x7c, 0x33, 0x28, 0xdf, 0x08,
+    0xca, 0x37, 0x87, 0xf2, 0x8d, 0xa1, 0x7c, 0x0b, 0x28, 0xdf, 0x04, 0xca,
+    0xb7, 0x84, 0xf2, 0x4d, 0x21, 0x7c, 0x63, 0x03, 0x28, 0xdf, 0x0c, 0xca,
+    0x37, 0x84, 0xf2, 0xcd, 0xd1, 0xec, 0xb3, 0x40, 0xb3, 0xcf, 0x12, 0xcd,
+    0x3e, 0x43, 0x03, 0x34, 0x0b, 0x0d, 0x0d, 0xd1, 0x6c, 0x34, 0x34, 0x42,
+    0xb3, 0xd2, 0xd0, 0x18, 0xcd, 0x4e, 0x43, 0x13, 0x74, 0x4f, 0x9a, 0xa2,
+    0xd9, 0x6a, 0x68, 0x86, 0x6e, 0xad, 0x39, 0xba, 0xb5, 0x16, 0xe8, 0xd6,
+    0x5a, 0xc2, 0xad, 0x05, 0x00, 0x2b, 0xd1, 0x56, 0xfb, 0x4a, 0x01, 0x00,
+    0x00,
+};
+
+// First 40 bytes of textPayload(), stored (level 0)
+static const uint8_t kStoredGz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x03, 0x01, 0x28,
+    0x00, 0xd7, 0xff, 0x70, 0x72, 0x6f, 0x62, 0x65, 0x20, 0x30, 0x20, 0x70,
+    0x69, 0x74, 0x20, 0x32, 0x32, 0x35, 0x0a, 0x70, 0x72, 0x6f, 0x62, 0x65,
+    0x20, 0x31, 0x20, 0x70, 0x69, 0x74, 0x20, 0x32, 0x32, 0x36, 0x0a, 0x70,
+    0x72, 0x6f, 0x62, 0x65, 0x20, 0x32, 0x20, 0x16, 0xc3, 0x0f, 0x45, 0x28,
+    0x00, 0x00, 0x00,
+};
+
+static std::vector<uint8_t> squaresPayload() {
+    std::vector<uint8_t> out;
+    for (uint32_t i = 0; i < 10000; i++) out.push_back((uint8_t)((i * i) % 253));
+    return out;
+}
+
+static std::vector<uint8_t> textPayload() {
+    std::vector<uint8_t> out;
+    char line[32];
+    for (int i = 0; i < 20; i++) {
+        int n = snprintf(line, sizeof(line), "probe %d pit %d\n", i, 225 + i % 7);
+        out.insert(out.end(), line, line + n);
+    }
+    return out;
+}
+
+// Raw app image: 0xE9 magic, then a pattern
+static std::vector<uint8_t> rawImage(size_t len) {
+    std::vector<uint8_t> out(len);
+    for (size_t i = 0; i < len; i++) out[i] = (uint8_t)(i * 31 + (i >> 8));
+    out[0] = 0xE9;
+    return out;
+}
+
+// --------------------------------------------------------------------------
+// Harness: input from memory, output collected
+// --------------------------------------------------------------------------
+
+struct Harness {
+    const uint8_t* in;
+    size_t inLen;
+    size_t pos;
+    std::vector<uint8_t> out;
+    std::vector<size_t> writes;   // Size of each write callback
+    size_t failAfter;             // Writes allowed before one fails
+};
+
+static int readMem(void* ctx) {
+    Harness* h = static_cast<Harness*>(ctx);
+    return h->pos < h->inLen ? h->in[h->pos++] : -1;
+}
+
+static bool writeMem(void* ctx, const uint8_t* data, size_t len) {
+    Harness* h = static_cast<Harness*>(ctx);
+    if (h->writes.size() >= h->failAfter) return false;
+    h->out.insert(h->out.end(), data, data + len);
+    h->writes.push_back(len);
+    return true;
+}
+
+static uint8_t g_window[OTA_WINDOW_SIZE];
+static OtaStream* stream;
+static Harness h;
+
+static OtaStreamResult runOn(const uint8_t* data, size_t len) {
+    h.in = data;
+    h.inLen = len;
+    h.pos = 0;
+    h.out.clear();
+    h.writes.clear();
+    return stream->run((uint32_t)len, readMem, writeMem, &h);
+}
+
+static void assertOutput(const std::vector<uint8_t>& expected) {
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), h.out.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), h.out.data(), expected.size());
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), stream->outputBytes());
+}
+
+// --------------------------------------------------------------------------
+// setUp / tearDown
+// --------------------------------------------------------------------------
+
+void setUp(void) {
+    memset(g_window, 0, sizeof(g_window));
+    stream = new OtaStream(g_window);
+    h = Harness();
+    h.failAfter = (size_t)-1;
+}
+
+void tearDown(void) {
+    delete stream;
+    stream = nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Tests: Raw images
+// --------------------------------------------------------------------------
+
+void test_raw_image_passes_through(void) {
+    std::vector<uint8_t> img = rawImage(10000);
+    TEST_ASSERT_EQUAL(OtaStreamResult::OK, runOn(img.data(), img.size()));
+    assertOutput(img);
+    TEST_ASSERT_FALSE(stream->compressed());
+}
+
+void test_raw_image_written_in_sectors(void) {
+    std::vector<uint8_t> img = rawImage(10000);
+    runOn(img.data(), img.size());
+    TEST_ASSERT_EQUAL_UINT32(3, h.writes.size());
+    TEST_ASSERT_EQUAL_UINT32(OTA_WRITE_CHUNK, h.writes[0]);
+    TEST_ASSERT_EQUAL_UINT32(OTA_WRITE_CHUNK, h.writes[1]);
+    TEST_ASSERT_EQUAL_UINT32(10000 - 2 * OTA_WRITE_CHUNK, h.writes[2]);
+}
+
+void test_raw_image_truncated(void) {
+    std::vector<uint8_t> img = rawImage(5000);
+    h.in = img.data();
+    h.inLen = 3000;
+    h.pos = 0;
+    TEST_ASSERT_EQUAL(OtaStreamResult::INPUT_ENDED,
+                      stream->run(5000, readMem, writeMem, &h));
+}
+
+void test_unknown_magic_rejected(void) {
+    const uint8_t junk[] = {'<', 'h', 't', 'm', 'l', '>'};
+    TEST_ASSERT_EQUAL(OtaStreamResult::BAD_HEADER, runOn(junk, sizeof(junk)));
+    TEST_ASSERT_EQUAL_UINT32(0, h.out.size());
+}
+
+// --------------------------------------------------------------------------
+// Tests: Gzip
+// --------------------------------------------------------------------------
+
+void test_gzip_dynamic_blocks(void) {
+    TEST_ASSERT_EQUAL(OtaStreamResult::OK, runOn(kSquaresGz, sizeof(kSquaresGz)));
+    assertOutput(squaresPayload());
+    TEST_ASSERT_TRUE(stream->compressed());
+}
+
+void test_gzip_writes_whole_sectors(void) {
+    runOn(kSquaresGz, sizeof(kSquaresGz));
+    for (size_t i = 0; i + 1 < h.writes.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(OTA_WRITE_CHUNK, h.writes[i]);
+    }
+}
+
+void test_gzip_fixed_codes(void) {
+    TEST_ASSERT_EQUAL(OtaStreamResult::OK, runOn(kTextFixedGz, sizeof(kTextFixedGz)));
+    assertOutput(textPayload());
+}
+
+void test_gzip_stored_block(void) {
+    TEST_ASSERT_EQUAL(OtaStreamResult::OK, runOn(kStoredGz, sizeof(kStoredGz)));
+    std::vector<uint8_t> text = textPayload();
+    text.resize(40);
+    assertOutput(text);
+}
+
+void test_gzip_stops_at_trailer(void) {
+    std::vector<uint8_t> in(kTextFixedGz, kTextFixedGz + sizeof(kTextFixedGz));
+    in.push_back(0xAA);
+    in.push_back(0x55);
+    TEST_ASSERT_EQUAL(OtaStreamResult::OK, runOn(in.data(), in.size()));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(kTextFixedGz), h.pos);
+}
+
+void test_gzip_truncated(void) {
+    TEST_ASSERT_EQUAL(OtaStreamResult::INPUT_ENDED, runOn(kSquaresGz, sizeof(kSquaresGz) - 6));
+}
+
+void test_gzip_bad_crc(void) {
+    std::vector<uint8_t> in(kSquaresGz, kSquaresGz + sizeof(kSquaresGz));
+    in[in.size() - 8] ^= 0x01;   // CRC-32 starts 8 bytes from the end
+    TEST_ASSERT_EQUAL(OtaStreamResult::BAD_CHECKSUM, runOn(in.data(), in.size()));
+}
+
+void test_gzip_bad_length(void) {
+    std::vector<uint8_t> in(kTextFixedGz, kTextFixedGz + sizeof(kTextFixedGz));
+    in[in.size() - 4] ^= 0x01;
+    TEST_ASSERT_EQUAL(OtaStreamResult::BAD_CHECKSUM, runOn(in.data(), in.size()));
+}
+
+void test_gzip_corrupt_data_fails(void) {
+    std::vector<uint8_t> in(kSquaresGz, kSquaresGz + sizeof(kSquaresGz));
+    in[in.size() / 2] ^= 0x5A;
+    TEST_ASSERT_NOT_EQUAL(OtaStreamResult::OK, runOn(in.data(), in.size()));
+}
+
+void test_gzip_bad_block_type(void) {
+    std::vector<uint8_t> in(kStoredGz, kStoredGz + sizeof(kStoredGz));
+    in[10] |= 0x06;   // BTYPE 3 is reserved
+    TEST_ASSERT_EQUAL(OtaStreamResult::BAD_DATA, runOn(in.data(), in.size()));
+}
+
+void test_gzip_reserved_flags_rejected(void) {
+    std::vector<uint8_t> in(kStoredGz, kStoredGz + sizeof(kStoredGz));
+    in[3] |= 0x20;
+    TEST_ASSERT_EQUAL(OtaStreamResult::BAD_HEADER, runOn(in.data(), in.size()));
+}
+
+// --------------------------------------------------------------------------
+// Tests: Write failures and reuse
+// --------------------------------------------------------------------------
+
+void test_write_failure_stops_decode(void) {
+    h.failAfter = 1;
+    TEST_ASSERT_EQUAL(OtaStreamResult::WRITE_FAILED, runOn(kSquaresGz, sizeof(kSquaresGz)));
+    TEST_ASSERT_EQUAL_UINT32(OTA_WRITE_CHUNK, stream->outputBytes());
+    TEST_ASSERT_TRUE(h.pos < sizeof(kSquaresGz));
+}
+
+void test_decoder_reusable(void) {
+    TEST_ASSERT_EQUAL(OtaStreamResult::INPUT_ENDED, runOn(kSquaresGz, 100));
+    TEST_ASSERT_EQUAL(OtaStreamResult::OK, runOn(kSquaresGz, sizeof(kSquaresGz)));
+    assertOutput(squaresPayload());
+}
+
+void test_result_names(void) {
+    TEST_ASSERT_EQUAL_STRING("ok", OtaStream::resultName(OtaStreamResult::OK));
+    TEST_ASSERT_EQUAL_STRING("gzip checksum mismatch",
+                             OtaStream::resultName(OtaStreamResult::BAD_CHECKSUM));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Raw images
+    RUN_TEST(test_raw_image_passes_through);
+    RUN_TEST(test_raw_image_written_in_sectors);
+    RUN_TEST(test_raw_image_truncated);
+    RUN_TEST(test_unknown_magic_rejected);
+
+    // Gzip
+    RUN_TEST(test_gzip_dynamic_blocks);
+    RUN_TEST(test_gzip_writes_whole_sectors);
+    RUN_TEST(test_gzip_fixed_codes);
+    RUN_TEST(test_gzip_stored_block);
+    RUN_TEST(test_gzip_stops_at_trailer);
+    RUN_TEST(test_gzip_truncated);
+    RUN_TEST(test_gzip_bad_crc);
+    RUN_TEST(test_gzip_bad_length);
+    RUN_TEST(test_gzip_corrupt_data_fails);
+    RUN_TEST(test_gzip_bad_block_type);
+    RUN_TEST(test_gzip_reserved_flags_rejected);
+
+    // Write failures and reuse
+    RUN_TEST(test_write_failure_stops_decode);
+    RUN_TEST(test_decoder_reusable);
+    RUN_TEST(test_result_names);
+
+    return UNITY_END();
+}
@@ -3,22 +3,36 @@
  *
  * Tests for PidController logic on the native platform.
  *
- * On native build, QuickPID is not available (guarded by #ifndef NATIVE_BUILD).
- * The PID compute() path that calls QuickPID::Compute() is compiled out, so
- * _pidOutput stays at 0 on native. However, we CAN test:
- *   - Lid-open detection state machine (updateLidState is fully compiled)
+ * The PID math is plain C++ and runs on native, so alongside the unit
+ * tests the controller is run closed-loop against SimThermalModel. Covers:
+ *   - Proportional/derivative-on-measurement, anti-windup, D-term filter
+ *   - Sample rate: overshoot and settling of a setpoint step at 4 s, 2 s
+ *     and 1 s, and output chatter with and without the derivative filter
+ *   - Lid-open detection state machine
  *   - Enabled/disabled logic
  *   - Tuning parameter storage
  *   - Output clamping behavior when disabled
  *   - Constructor defaults
+ *   - Relay auto-tune: PidAutoTune against a synthetic oscillation, and the
+ *     full PidController auto-tune run closed-loop against SimThermalModel
+ *   - Setpoint feed-forward preload and the band / fan-mode gain schedule
+ *   - Lid events: fast-fall detection, held output, learned recovery curve
  */
 
 #include <unity.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
 
 // Include the actual module under test
 #include "pid_controller.h"
 #include "pid_controller.cpp"
+#include "pid_autotune.cpp"
+
+// Desktop thermal model, driven by the controller's output
+#include "simulator/sim_thermal.h"
+#include "simulator/sim_thermal.cpp"
+#include "split_range.h"
 
 // --------------------------------------------------------------------------
 // setUp / tearDown
@@ -118,6 +132,9 @@ void test_begin_with_custom_tunings(void) {
 // For setpoint 250F:
 //   Drop threshold  = 250 * (1 - 0.06) = 235.0
 //   Recover threshold = 250 * (1 - 0.02) = 245.0
+//
+// The threshold only arms once the pit has reached the recover threshold,
+// so a cold start or a raised setpoint isn't mistaken for the lid.
 // --------------------------------------------------------------------------
 
 void test_lid_open_detection_temp_drop(void) {
@@ -139,11 +156,12 @@ void test_lid_open_detection_temp_drop(void) {
 void test_lid_open_output_is_zero(void) {
     float setpoint = 250.0f;
 
-    // Trigger lid-open
+    // Pit up to temperature (arms the threshold backstop), then trigger lid-open
+    pid->compute(setpoint, setpoint);
     pid->compute(230.0f, setpoint);
     TEST_ASSERT_TRUE(pid->isLidOpen());
 
-    // Output should be 0 when lid is open
+    // The pre-event output (0 here, nothing has run yet) is held while open
     float output = pid->compute(230.0f, setpoint);
     TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, output);
 }
@@ -151,7 +169,8 @@ void test_lid_open_output_is_zero(void) {
 void test_lid_open_recovery(void) {
     float setpoint = 250.0f;
 
-    // Trigger lid-open
+    // Pit up to temperature (arms the threshold backstop), then trigger lid-open
+    pid->compute(setpoint, setpoint);
     pid->compute(230.0f, setpoint);
     TEST_ASSERT_TRUE(pid->isLidOpen());
 
@@ -168,7 +187,8 @@ void test_lid_open_recovery_exact_threshold(void) {
     float setpoint = 250.0f;
     float recoverThreshold = setpoint * (1.0f - LID_OPEN_RECOVER_PCT / 100.0f);  // 245.0
 
-    // Trigger lid-open
+    // Pit up to temperature (arms the threshold backstop), then trigger lid-open
+    pid->compute(setpoint, setpoint);
     pid->compute(230.0f, setpoint);
     TEST_ASSERT_TRUE(pid->isLidOpen());
 
@@ -193,6 +213,7 @@ void test_lid_open_with_different_setpoint(void) {
     // Recover threshold = 400 * 0.98 = 392
     float setpoint = 400.0f;
 
+    pid->compute(setpoint, setpoint);
     pid->compute(375.0f, setpoint);
     TEST_ASSERT_TRUE(pid->isLidOpen());
 
@@ -207,6 +228,7 @@ void test_lid_open_repeated_cycles(void) {
     float setpoint = 250.0f;
 
     // First lid-open cycle
+    pid->compute(setpoint, setpoint);
     pid->compute(230.0f, setpoint);
     TEST_ASSERT_TRUE(pid->isLidOpen());
     pid->compute(246.0f, setpoint);
@@ -220,13 +242,289 @@ void test_lid_open_repeated_cycles(void) {
 }
 
 // --------------------------------------------------------------------------
-// Tests: Compute returns zero on native (QuickPID not available)
+// Tests: lid events (derivative detection, hold, predicted recovery)
 // --------------------------------------------------------------------------
 
-void test_compute_returns_zero_on_native(void) {
-    // On native build, the QuickPID section is compiled out, so output stays 0
+// Drop from 250 to a 210 trough over three samples with the lid open
+static void openLidTo210(void) {
+    pid->compute(250.0f, 250.0f);
+    pid->compute(235.0f, 250.0f);
+    pid->compute(220.0f, 250.0f);
+    pid->compute(210.0f, 250.0f);
+}
+
+void test_lid_fast_fall_detected_before_threshold(void) {
+    // 400 setpoint: the fixed 6% threshold would wait for 376
+    pid->compute(400.0f, 400.0f);
+    pid->compute(400.0f, 400.0f);
+    pid->compute(390.0f, 400.0f);
+    TEST_ASSERT_FALSE(pid->isLidOpen());   // One fast sample is not enough
+    pid->compute(380.0f, 400.0f);
+    TEST_ASSERT_TRUE(pid->isLidOpen());
+    TEST_ASSERT_EQUAL_INT((int)LidState::OPEN, (int)pid->getLidState());
+}
+
+void test_lid_slow_fall_not_detected(void) {
+    // 15 deg/min is a dying fire, not a lid
+    for (int i = 0; i <= 20; i++) {
+        pid->compute(400.0f - i, 400.0f);
+    }
+    TEST_ASSERT_FALSE(pid->isLidOpen());
+}
+
+void test_lid_holds_pre_event_output(void) {
+    pid->setFeedForward(0.3f);
+    pid->stepSetpoint(200.0f, 250.0f);   // Output 15% before the event
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 15.0f, pid->getOutput());
+
+    openLidTo210();
+    TEST_ASSERT_TRUE(pid->isLidOpen());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 15.0f, pid->compute(205.0f, 250.0f));
+}
+
+void test_lid_natural_recovery_learns_tau(void) {
+    openLidTo210();
+    TEST_ASSERT_TRUE(pid->isLidOpen());
+
+    // Recover from the 210 trough with a 120 s time constant
+    const float tauSec = 120.0f;
+    int k = 1;
+    for (; k < 200; k++) {
+        float t = k * (PID_SAMPLE_MS / 1000.0f);
+        pid->compute(250.0f - 40.0f * expf(-t / tauSec), 250.0f);
+        if (!pid->isLidOpen()) break;
+        TEST_ASSERT_EQUAL_INT((int)LidState::RECOVERING, (int)pid->getLidState());
+    }
+
+    TEST_ASSERT_FALSE(pid->isLidOpen());
+    TEST_ASSERT_EQUAL_UINT8(1, pid->getLidEventsLearned());
+    TEST_ASSERT_FLOAT_WITHIN(3.0f, tauSec, pid->getLidRecoveryTau());
+}
+
+void test_lid_recovery_behind_prediction_hands_back(void) {
+    openLidTo210();
+
+    // Barely recovering: well behind the default LID_RECOVERY_TAU_S curve
+    int k = 1;
+    for (; k < 200 && pid->isLidOpen(); k++) {
+        pid->compute(210.0f + 0.1f * k, 250.0f);
+    }
+
+    TEST_ASSERT_FALSE(pid->isLidOpen());
+    TEST_ASSERT_TRUE(k < 60);                      // Long before the 245 threshold
+    TEST_ASSERT_EQUAL_UINT8(0, pid->getLidEventsLearned());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, LID_RECOVERY_TAU_S, pid->getLidRecoveryTau());
+}
+
+void test_lid_reopen_during_recovery(void) {
+    openLidTo210();
+    pid->compute(215.0f, 250.0f);
+    TEST_ASSERT_EQUAL_INT((int)LidState::RECOVERING, (int)pid->getLidState());
+
+    pid->compute(205.0f, 250.0f);
+    pid->compute(195.0f, 250.0f);
+    TEST_ASSERT_EQUAL_INT((int)LidState::OPEN, (int)pid->getLidState());
+}
+
+void test_lid_event_times_out(void) {
+    openLidTo210();
+    uint32_t samples = LID_EVENT_TIMEOUT_MS / PID_SAMPLE_MS + 1;
+    for (uint32_t i = 0; i < samples && pid->isLidOpen(); i++) {
+        pid->compute(210.0f, 250.0f);
+    }
+    TEST_ASSERT_FALSE(pid->isLidOpen());
+}
+
+void test_reset_lid_model(void) {
+    openLidTo210();
+    for (int k = 1; k < 200 && pid->isLidOpen(); k++) {
+        pid->compute(250.0f - 40.0f * expf(-k * 4.0f / 90.0f), 250.0f);
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, pid->getLidEventsLearned());
+
+    pid->resetLidModel();
+    TEST_ASSERT_EQUAL_UINT8(0, pid->getLidEventsLearned());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, LID_RECOVERY_TAU_S, pid->getLidRecoveryTau());
+}
+
+// --------------------------------------------------------------------------
+// Tests: PID math
+// --------------------------------------------------------------------------
+
+void test_compute_integrates_error(void) {
+    // First sample: no derivative history, P-on-measurement contributes
+    // nothing, so the output is one step of integral
     float output = pid->compute(200.0f, 250.0f);
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, output);
+    float dt = PID_SAMPLE_MS / 1000.0f;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_KI * 50.0f * dt, output);
+}
+
+void test_setpoint_change_has_no_proportional_kick(void) {
+    pid->setTunings(4.0f, 0.0f, 0.0f);
+    pid->compute(200.0f, 210.0f);
+    float before = pid->compute(200.0f, 210.0f);
+    float after  = pid->compute(200.0f, 300.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, before, after);
+}
+
+void test_proportional_on_measurement_opposes_rise(void) {
+    pid->setTunings(4.0f, 0.0f, 0.0f);
+    pid->setFeedForward(0.5f);
+    pid->stepSetpoint(150.0f, 250.0f);             // Preload 50%
+    pid->compute(200.0f, 250.0f);
+    float out = pid->compute(210.0f, 250.0f);      // Rose 10 degrees
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f - 4.0f * 10.0f, out);
+}
+
+void test_integral_anti_windup(void) {
+    pid->setTunings(0.0f, 1.0f, 0.0f);
+    for (int i = 0; i < 50; i++) pid->compute(200.0f, 250.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_OUTPUT_MAX, pid->getOutput());
+
+    // Over setpoint: the output comes off the rail at once instead of
+    // first unwinding 50 samples of accumulated error
+    float out = pid->compute(251.0f, 250.0f);
+    TEST_ASSERT_TRUE(out < PID_OUTPUT_MAX);
+}
+
+void test_derivative_filter_softens_input_step(void) {
+    PidController raw;
+    raw.begin(1.0f, 0.0f, 40.0f);
+    raw.setDerivativeFilter(0.0f);
+    pid->begin(1.0f, 0.0f, 40.0f);
+    pid->setFeedForward(0.5f);
+    raw.setFeedForward(0.5f);
+    pid->stepSetpoint(150.0f, 250.0f);
+    raw.stepSetpoint(150.0f, 250.0f);
+
+    pid->compute(240.0f, 250.0f);
+    raw.compute(240.0f, 250.0f);
+    float fOut = pid->compute(241.0f, 250.0f);     // One-degree noise spike
+    float rOut = raw.compute(241.0f, 250.0f);
+
+    // Unfiltered D slams the output by Kd * 1 / dt; filtered takes a fraction
+    float dt = PID_SAMPLE_MS / 1000.0f;
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f - 1.0f - 40.0f / dt, rOut);
+    TEST_ASSERT_TRUE(fOut > rOut + 5.0f);
+}
+
+void test_sample_ms_clamped(void) {
+    pid->setSampleMs(1000);
+    TEST_ASSERT_EQUAL_UINT32(1000, pid->getSampleMs());
+    pid->setSampleMs(100);
+    TEST_ASSERT_EQUAL_UINT32(PID_SAMPLE_MS_MIN, pid->getSampleMs());
+    pid->setSampleMs(60000);
+    TEST_ASSERT_EQUAL_UINT32(PID_SAMPLE_MS_MAX, pid->getSampleMs());
+}
+
+// --------------------------------------------------------------------------
+// Tests: closed-loop harness against SimThermalModel
+//
+// The controller runs at its sample rate against the model stepped at 1 s,
+// reading the pit through the same EMA as TempManager. The pit comes up
+// from ambient to 225, holds for 3 hours, then steps to 275. Overshoot is
+// the peak above the active setpoint; settling time is when the pit last
+// left a +/-5 degree band around it.
+// --------------------------------------------------------------------------
+
+struct StepResponse {
+    float overshoot;       // Degrees
+    float settleSec;       // After the measured transition
+    float outputTravel;    // Sum of |output change| after the step (chatter)
+};
+
+static StepResponse runStepResponse(uint32_t sampleMs, float kp, float ki, float kd,
+                                    float dFilterN, float ff, bool measureColdStart) {
+    srand(1);
+    SimThermalModel model;
+    model.init(sim_profile_normal);
+    model.externalControl = true;
+
+    PidController ctl;
+    ctl.begin(kp, ki, kd);
+    ctl.setSampleMs(sampleMs);
+    ctl.setDerivativeFilter(dFilterN);
+    ctl.setFeedForward(ff);
+
+    const uint32_t stepAtMs = 3UL * 3600UL * 1000UL;
+    const uint32_t endMs    = 5UL * 3600UL * 1000UL;
+    float sp = 225.0f, prevSp = sp;
+    SimResult r = model.update(0.0f);
+    float pit = r.pitTemp;
+    float lastOut = -1.0f;
+    uint32_t sinceCompute = sampleMs;
+    StepResponse res = { 0.0f, 0.0f, 0.0f };
+
+    for (uint32_t t = 0; t < endMs; t += 1000) {
+        if (t == stepAtMs) sp = 275.0f;
+        if (sinceCompute >= sampleMs) {
+            sinceCompute = 0;
+            if (sp != prevSp) {
+                ctl.stepSetpoint(prevSp, sp);
+                prevSp = sp;
+            }
+            float out = ctl.compute(pit, sp);
+            model.controlOutput = out;
+            if (t > stepAtMs && lastOut >= 0.0f) res.outputTravel += fabsf(out - lastOut);
+            lastOut = out;
+        }
+        r = model.update(1.0f);
+        sinceCompute += 1000;
+        pit += TEMP_EMA_ALPHA * (r.pitTemp - pit);
+
+        bool measuring = measureColdStart ? (t < stepAtMs) : (t > stepAtMs);
+        if (measuring) {
+            float err = model.pitTemp - sp;
+            if (err > res.overshoot) res.overshoot = err;
+            if (fabsf(err) > 5.0f) {
+                res.settleSec = (measureColdStart ? t : t - stepAtMs) / 1000.0f;
+            }
+        }
+    }
+    return res;
+}
+
+void test_harness_setpoint_step_across_rates(void) {
+    const uint32_t rates[] = { 4000, 2000, 1000 };
+    StepResponse slow = runStepResponse(4000, PID_KP, PID_KI, PID_KD,
+                                        PID_D_FILTER_N, PID_FEEDFORWARD, false);
+    for (uint8_t i = 0; i < 3; i++) {
+        StepResponse r = runStepResponse(rates[i], PID_KP, PID_KI, PID_KD,
+                                         PID_D_FILTER_N, PID_FEEDFORWARD, false);
+        TEST_ASSERT_TRUE(r.overshoot < 5.0f);
+        TEST_ASSERT_TRUE(r.settleSec < 15.0f * 60.0f);
+        TEST_ASSERT_TRUE(r.settleSec <= slow.settleSec + 60.0f);  // Faster never settles worse
+    }
+}
+
+void test_harness_cold_start_across_rates(void) {
+    const uint32_t rates[] = { 4000, 2000, 1000 };
+    for (uint8_t i = 0; i < 3; i++) {
+        StepResponse r = runStepResponse(rates[i], PID_KP, PID_KI, PID_KD,
+                                         PID_D_FILTER_N, PID_FEEDFORWARD, true);
+        TEST_ASSERT_TRUE(r.overshoot < 5.0f);
+        TEST_ASSERT_TRUE(r.settleSec < 30.0f * 60.0f);
+    }
+}
+
+void test_harness_feed_forward_shortens_settling(void) {
+    StepResponse withFf = runStepResponse(2000, PID_KP, PID_KI, PID_KD,
+                                          PID_D_FILTER_N, PID_FEEDFORWARD, false);
+    StepResponse noFf   = runStepResponse(2000, PID_KP, PID_KI, PID_KD,
+                                          PID_D_FILTER_N, 0.0f, false);
+    TEST_ASSERT_TRUE(withFf.settleSec < noFf.settleSec * 0.9f);
+}
+
+void test_harness_derivative_filter_quiets_output_at_1s(void) {
+    // Derivative-heavy tunings (as the relay auto-tune produces on this
+    // model) show the D-term noise the filter is there for
+    const float kp = 3.7f, ki = 0.0067f, kd = 150.0f;
+    StepResponse filtered = runStepResponse(1000, kp, ki, kd, PID_D_FILTER_N,
+                                            PID_FEEDFORWARD, false);
+    StepResponse raw      = runStepResponse(1000, kp, ki, kd, 0.0f,
+                                            PID_FEEDFORWARD, false);
+    TEST_ASSERT_TRUE(filtered.outputTravel < raw.outputTravel * 0.5f);
+    TEST_ASSERT_TRUE(filtered.overshoot < 5.0f);
 }
 
 // --------------------------------------------------------------------------
@@ -236,7 +534,8 @@ void test_compute_returns_zero_on_native(void) {
 void test_begin_resets_lid_state(void) {
     float setpoint = 250.0f;
 
-    // Trigger lid-open
+    // Pit up to temperature (arms the threshold backstop), then trigger lid-open
+    pid->compute(setpoint, setpoint);
     pid->compute(230.0f, setpoint);
     TEST_ASSERT_TRUE(pid->isLidOpen());
 
@@ -251,6 +550,246 @@ void test_begin_resets_enabled(void) {
     TEST_ASSERT_TRUE(pid->isEnabled());
 }
 
+// --------------------------------------------------------------------------
+// Tests: snapshot / restore (warm restart)
+// --------------------------------------------------------------------------
+
+void test_restore_continues_like_the_original(void) {
+    float setpoint = 250.0f;
+    for (int i = 0; i < 20; i++) pid->compute(200.0f + i, setpoint);
+
+    PidController resumed;
+    resumed.begin();
+    resumed.restore(pid->snapshot());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, pid->getOutput(), resumed.getOutput());
+
+    // The integrator and derivative history carry over, so the next samples match
+    for (int i = 0; i < 5; i++) {
+        float a = pid->compute(221.0f + i, setpoint);
+        float b = resumed.compute(221.0f + i, setpoint);
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, a, b);
+    }
+}
+
+void test_restore_resumes_lid_event(void) {
+    float setpoint = 250.0f;
+    pid->compute(setpoint, setpoint);
+    pid->compute(230.0f, setpoint);
+    TEST_ASSERT_TRUE(pid->isLidOpen());
+
+    PidController resumed;
+    resumed.begin();
+    resumed.restore(pid->snapshot());
+    TEST_ASSERT_TRUE(resumed.isLidOpen());
+
+    resumed.compute(245.0f, setpoint);
+    TEST_ASSERT_FALSE(resumed.isLidOpen());
+}
+
+void test_restore_clamps_output(void) {
+    PidSnapshot s = pid->snapshot();
+    s.outputSum = 500.0f;
+    s.pidOutput = -20.0f;
+    pid->restore(s);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_OUTPUT_MIN, pid->getOutput());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_OUTPUT_MAX, pid->snapshot().outputSum);
+}
+
+// --------------------------------------------------------------------------
+// Tests: PidAutoTune relay measurement
+// --------------------------------------------------------------------------
+
+// Feed a clean sine of known amplitude and period, sampled at PID_SAMPLE_MS
+static void feedSine(PidAutoTune& tune, float sp, float amp, float periodSec, uint32_t samples) {
+    for (uint32_t i = 0; i < samples && tune.isRunning(); i++) {
+        float t = i * (PID_SAMPLE_MS / 1000.0f);
+        tune.update(sp - amp * sinf(2.0f * (float)M_PI * t / periodSec));
+    }
+}
+
+void test_autotune_relay_output_levels(void) {
+    PidAutoTune tune;
+    tune.start(225.0f, 50.0f, 30.0f, 2.0f, PID_SAMPLE_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 80.0f, tune.update(200.0f));   // Below band: high
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 80.0f, tune.update(226.0f));   // Inside band: hold
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, tune.update(228.0f));   // Above band: low
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, tune.update(224.0f));   // Inside band: hold
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 80.0f, tune.update(222.0f));
+}
+
+void test_autotune_measures_sine_period_and_gain(void) {
+    PidAutoTune tune;
+    const float amp = 10.0f, period = 600.0f, step = 30.0f, hyst = 2.0f;
+    tune.start(225.0f, 50.0f, step, hyst, PID_SAMPLE_MS);
+    feedSine(tune, 225.0f, amp, period, 10000);
+
+    TEST_ASSERT_EQUAL_INT((int)AutoTuneState::DONE, (int)tune.getState());
+    TEST_ASSERT_FLOAT_WITHIN(period * 0.02f, period, tune.getUltimatePeriodSec());
+
+    float expectKu = 4.0f * step / ((float)M_PI * sqrtf(amp * amp - hyst * hyst));
+    TEST_ASSERT_FLOAT_WITHIN(expectKu * 0.05f, expectKu, tune.getUltimateGain());
+
+    // Tyreus-Luyben from Ku/Pu
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, tune.getUltimateGain() / 2.2f, tune.getKp());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, tune.getKp() / (2.2f * tune.getUltimatePeriodSec()), tune.getKi());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, tune.getKp() * tune.getUltimatePeriodSec() / 6.3f, tune.getKd());
+}
+
+void test_autotune_times_out_without_oscillation(void) {
+    PidAutoTune tune;
+    tune.start(225.0f, 50.0f, 30.0f, 2.0f, PID_SAMPLE_MS);
+    uint32_t samples = AUTOTUNE_TIMEOUT_MS / PID_SAMPLE_MS + 1;
+    for (uint32_t i = 0; i < samples && tune.isRunning(); i++) tune.update(150.0f);
+    TEST_ASSERT_EQUAL_INT((int)AutoTuneState::FAILED, (int)tune.getState());
+}
+
+void test_autotune_cancel_returns_to_idle(void) {
+    PidAutoTune tune;
+    tune.start(225.0f, 50.0f, 30.0f, 2.0f, PID_SAMPLE_MS);
+    tune.cancel();
+    TEST_ASSERT_EQUAL_INT((int)AutoTuneState::IDLE, (int)tune.getState());
+}
+
+// --------------------------------------------------------------------------
+// Tests: PidController auto-tune mode
+// --------------------------------------------------------------------------
+
+void test_controller_autotune_overrides_output(void) {
+    pid->startAutoTune(225.0f);
+    TEST_ASSERT_TRUE(pid->isAutoTuning());
+    float out = pid->compute(150.0f, 225.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, AUTOTUNE_OUTPUT_BIAS + AUTOTUNE_OUTPUT_STEP, out);
+    TEST_ASSERT_FALSE(pid->isLidOpen());   // Lid detection is suspended while tuning
+}
+
+void test_controller_autotune_cancelled_by_setpoint_change(void) {
+    pid->startAutoTune(225.0f);
+    pid->compute(220.0f, 250.0f);
+    TEST_ASSERT_FALSE(pid->isAutoTuning());
+    float kp, ki, kd;
+    TEST_ASSERT_FALSE(pid->takeAutoTuneResult(kp, ki, kd));
+}
+
+void test_controller_autotune_cancelled_by_disable(void) {
+    pid->startAutoTune(225.0f);
+    pid->setEnabled(false);
+    TEST_ASSERT_FALSE(pid->isAutoTuning());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, pid->getOutput());
+}
+
+// Close the loop: controller output -> split-range -> thermal model -> controller
+void test_controller_autotune_against_sim_model(void) {
+    srand(1);
+    SimThermalModel model;
+    model.init(sim_profile_normal);
+    model.externalControl = true;
+
+    const float sp = 225.0f;
+    pid->startAutoTune(sp);
+
+    const uint32_t stepMs = 1000;
+    uint32_t elapsedMs = 0, sinceCompute = PID_SAMPLE_MS;
+    SimResult r = model.update(0.0f);
+    while (pid->isAutoTuning() && elapsedMs < AUTOTUNE_TIMEOUT_MS) {
+        if (sinceCompute >= PID_SAMPLE_MS) {
+            sinceCompute = 0;
+            model.controlOutput = pid->compute(r.pitTemp, sp);
+        }
+        r = model.update(stepMs / 1000.0f);
+        elapsedMs += stepMs;
+        sinceCompute += stepMs;
+    }
+
+    TEST_ASSERT_EQUAL_INT((int)AutoTuneState::DONE, (int)pid->getAutoTuneState());
+
+    float kp, ki, kd;
+    TEST_ASSERT_TRUE(pid->takeAutoTuneResult(kp, ki, kd));
+    TEST_ASSERT_FALSE(pid->takeAutoTuneResult(kp, ki, kd));   // One-shot
+    TEST_ASSERT_TRUE(kp > 0.0f && ki > 0.0f && kd > 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, kp, pid->getKp());      // Applied to the controller
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, ki, pid->getKi());
+}
+
+// --------------------------------------------------------------------------
+// Tests: feed-forward and gain schedule
+// --------------------------------------------------------------------------
+
+void test_schedule_band_selection(void) {
+    PidSchedule s = pidScheduleDefaults();
+    TEST_ASSERT_EQUAL_UINT8(0, pidScheduleBand(s, 225.0f));
+    TEST_ASSERT_EQUAL_UINT8(0, pidScheduleBand(s, PID_BAND1_MAX_SP));
+    TEST_ASSERT_EQUAL_UINT8(1, pidScheduleBand(s, 275.0f));
+    TEST_ASSERT_EQUAL_UINT8(2, pidScheduleBand(s, 450.0f));
+    TEST_ASSERT_EQUAL_UINT8(2, pidScheduleBand(s, 5000.0f));  // Last band catches all
+}
+
+void test_schedule_scale_combines_band_and_mode(void) {
+    PidSchedule s = pidScheduleDefaults();
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND1_SCALE * PID_SCALE_FAN_AND_DAMPER,
+                             pidScheduleScale(s, 225.0f, FanMode::FAN_AND_DAMPER));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND2_SCALE * PID_SCALE_FAN_ONLY,
+                             pidScheduleScale(s, 275.0f, FanMode::FAN_ONLY));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND3_SCALE * PID_SCALE_DAMPER_PRIMARY,
+                             pidScheduleScale(s, 400.0f, FanMode::DAMPER_PRIMARY));
+}
+
+void test_schedule_disabled_is_unity(void) {
+    PidSchedule s = pidScheduleDefaults();
+    s.enabled = false;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, pidScheduleScale(s, 400.0f, FanMode::FAN_ONLY));
+}
+
+void test_controller_gain_scale_follows_setpoint_and_mode(void) {
+    pid->compute(225.0f, 225.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND1_SCALE, pid->getGainScale());
+
+    pid->compute(275.0f, 275.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND2_SCALE, pid->getGainScale());
+
+    pid->setFanMode(FanMode::DAMPER_PRIMARY);
+    pid->compute(275.0f, 275.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND2_SCALE * PID_SCALE_DAMPER_PRIMARY,
+                             pid->getGainScale());
+
+    // Base tunings are untouched by the schedule
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_KP, pid->getKp());
+}
+
+void test_step_setpoint_preloads_feed_forward(void) {
+    pid->setFeedForward(0.3f);
+    pid->stepSetpoint(225.0f, 275.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 15.0f, pid->getOutput());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, PID_BAND2_SCALE, pid->getGainScale());
+
+    // Stepping back down removes it again
+    pid->stepSetpoint(275.0f, 225.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, pid->getOutput());
+}
+
+void test_step_setpoint_clamps_output(void) {
+    pid->setFeedForward(0.5f);
+    pid->stepSetpoint(100.0f, 500.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, PID_OUTPUT_MAX, pid->getOutput());
+    pid->stepSetpoint(500.0f, 100.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, PID_OUTPUT_MIN, pid->getOutput());
+}
+
+void test_step_setpoint_without_feed_forward(void) {
+    pid->setFeedForward(0.0f);
+    pid->stepSetpoint(225.0f, 275.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, pid->getOutput());
+
+    pid->setFeedForward(-1.0f);   // Negative slopes are rejected
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, pid->getFeedForward());
+}
+
+void test_step_setpoint_ignored_while_tuning(void) {
+    pid->startAutoTune(225.0f);
+    float out = pid->compute(150.0f, 225.0f);
+    pid->stepSetpoint(225.0f, 275.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, out, pid->getOutput());
+}
+
 // --------------------------------------------------------------------------
 // Main
 // --------------------------------------------------------------------------
@@ -282,13 +821,55 @@ int main(int argc, char** argv) {
     RUN_TEST(test_lid_open_no_detection_at_zero_setpoint);
     RUN_TEST(test_lid_open_with_different_setpoint);
     RUN_TEST(test_lid_open_repeated_cycles);
-
-    // Native-specific behavior
-    RUN_TEST(test_compute_returns_zero_on_native);
+    RUN_TEST(test_lid_fast_fall_detected_before_threshold);
+    RUN_TEST(test_lid_slow_fall_not_detected);
+    RUN_TEST(test_lid_holds_pre_event_output);
+    RUN_TEST(test_lid_natural_recovery_learns_tau);
+    RUN_TEST(test_lid_recovery_behind_prediction_hands_back);
+    RUN_TEST(test_lid_reopen_during_recovery);
+    RUN_TEST(test_lid_event_times_out);
+    RUN_TEST(test_reset_lid_model);
+
+    // PID math
+    RUN_TEST(test_compute_integrates_error);
+    RUN_TEST(test_setpoint_change_has_no_proportional_kick);
+    RUN_TEST(test_proportional_on_measurement_opposes_rise);
+    RUN_TEST(test_integral_anti_windup);
+    RUN_TEST(test_derivative_filter_softens_input_step);
+    RUN_TEST(test_sample_ms_clamped);
 
     // begin() resets
     RUN_TEST(test_begin_resets_lid_state);
     RUN_TEST(test_begin_resets_enabled);
+    RUN_TEST(test_restore_continues_like_the_original);
+    RUN_TEST(test_restore_resumes_lid_event);
+    RUN_TEST(test_restore_clamps_output);
+
+    // Relay auto-tune
+    RUN_TEST(test_autotune_relay_output_levels);
+    RUN_TEST(test_autotune_measures_sine_period_and_gain);
+    RUN_TEST(test_autotune_times_out_without_oscillation);
+    RUN_TEST(test_autotune_cancel_returns_to_idle);
+    RUN_TEST(test_controller_autotune_overrides_output);
+    RUN_TEST(test_controller_autotune_cancelled_by_setpoint_change);
+    RUN_TEST(test_controller_autotune_cancelled_by_disable);
+    RUN_TEST(test_controller_autotune_against_sim_model);
+
+    // Feed-forward and gain schedule
+    RUN_TEST(test_schedule_band_selection);
+    RUN_TEST(test_schedule_scale_combines_band_and_mode);
+    RUN_TEST(test_schedule_disabled_is_unity);
+    RUN_TEST(test_controller_gain_scale_follows_setpoint_and_mode);
+    RUN_TEST(test_step_setpoint_preloads_feed_forward);
+    RUN_TEST(test_step_setpoint_clamps_output);
+    RUN_TEST(test_step_setpoint_without_feed_forward);
+    RUN_TEST(test_step_setpoint_ignored_while_tuning);
+
+    // Closed-loop harness
+    RUN_TEST(test_harness_setpoint_step_across_rates);
+    RUN_TEST(test_harness_cold_start_across_rates);
+    RUN_TEST(test_harness_feed_forward_shortens_settling);
+    RUN_TEST(test_harness_derivative_filter_quiets_output_at_1s);
 
     return UNITY_END();
 }
@@ -0,0 +1,281 @@
+/**
+ * test_probe_calibration.cpp
+ *
+ * Tests for the Steinhart-Hart calibration solver and ProbeCalibrator on
+ * the native platform.
+ *
+ * Tests cover:
+ *   - 1-, 2- and 3-point solves recovering a known probe curve
+ *   - Rejection of degenerate and non-physical point sets
+ *   - Capture only after a full stable window, timeout on a drifting probe
+ *   - Point spacing, point limit and solve() applying with offset 0
+ *   - Status JSON
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "temp_manager.h"
+#include "temp_manager.cpp"
+#include "metrics.cpp"
+#include "probe_calibration.h"
+#include "probe_calibration.cpp"
+
+// A probe whose real curve is off from the stock coefficients
+static ProbeConfig stockCfg() {
+    ProbeConfig c;
+    return c;
+}
+
+static ProbeConfig trueCfg() {
+    ProbeConfig c;
+    c.a = 7.10e-04f;
+    c.b = 2.20e-04f;
+    c.c = 8.0e-08f;
+    return c;
+}
+
+// Resistance at which cfg reads tempC (bisection on ln R)
+static float resistanceFor(float tempC, const ProbeConfig& cfg) {
+    double lo = log(10.0), hi = log(1.0e7);
+    for (int i = 0; i < 100; i++) {
+        double mid = 0.5 * (lo + hi);
+        float t = TempManager::resistanceToTempC((float)exp(mid), cfg);
+        if (t > tempC) lo = mid; else hi = mid;
+    }
+    return (float)exp(0.5 * (lo + hi));
+}
+
+// Raw ADC reading for a resistance (inverse of adcToResistance)
+static int16_t rawFor(float resistance) {
+    return (int16_t)lroundf((float)ADC_MAX_VALUE / (resistance / (float)REFERENCE_RESISTANCE + 1.0f));
+}
+
+static ProbeCalibrator* cal;
+static uint32_t nowMs;
+
+void setUp(void) {
+    cal = new ProbeCalibrator();
+    nowMs = 0;
+}
+
+void tearDown(void) {
+    delete cal;
+    cal = nullptr;
+}
+
+static void feed(uint16_t samples, int16_t raw, int16_t jitter = 0) {
+    for (uint16_t i = 0; i < samples; i++) {
+        cal->update(nowMs, (int16_t)(raw + ((i & 1) ? jitter : -jitter)), true);
+        nowMs += TEMP_SAMPLE_INTERVAL_MS;
+    }
+}
+
+// --------------------------------------------------------------------------
+// Solver
+// --------------------------------------------------------------------------
+
+void test_three_points_recover_curve(void) {
+    ProbeConfig t = trueCfg();
+    CalPoint pts[3] = {
+        { resistanceFor(0.0f, t),   0.0f },
+        { resistanceFor(60.0f, t),  60.0f },
+        { resistanceFor(100.0f, t), 100.0f },
+    };
+    ProbeConfig s = stockCfg();
+    TEST_ASSERT_TRUE(solveSteinhartHart(pts, 3, s.a, s.b, s.c));
+
+    // Matches the real curve well outside the points, too
+    const float checks[] = { -10.0f, 30.0f, 80.0f, 150.0f, 250.0f };
+    for (float c : checks) {
+        float r = resistanceFor(c, t);
+        TEST_ASSERT_FLOAT_WITHIN(0.2f, c, TempManager::resistanceToTempC(r, s));
+    }
+}
+
+void test_two_points_fit_a_and_b(void) {
+    ProbeConfig t = stockCfg();
+    t.a = 7.20e-04f;
+    t.b = 2.18e-04f;       // C left at the stock value
+    CalPoint pts[2] = {
+        { resistanceFor(0.0f, t),   0.0f },
+        { resistanceFor(100.0f, t), 100.0f },
+    };
+    ProbeConfig s = stockCfg();
+    TEST_ASSERT_TRUE(solveSteinhartHart(pts, 2, s.a, s.b, s.c));
+    TEST_ASSERT_EQUAL_FLOAT(THERM_C, s.c);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 200.0f,
+                             TempManager::resistanceToTempC(resistanceFor(200.0f, t), s));
+}
+
+void test_one_point_moves_a_only(void) {
+    ProbeConfig s = stockCfg();
+    CalPoint p = { resistanceFor(1.5f, s), 0.0f };   // Probe reads 1.5C high in ice
+    TEST_ASSERT_TRUE(solveSteinhartHart(&p, 1, s.a, s.b, s.c));
+    TEST_ASSERT_EQUAL_FLOAT(THERM_B, s.b);
+    TEST_ASSERT_EQUAL_FLOAT(THERM_C, s.c);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, TempManager::resistanceToTempC(p.resistance, s));
+}
+
+void test_rejects_degenerate_points(void) {
+    ProbeConfig s = stockCfg();
+    float r = resistanceFor(50.0f, s);
+    CalPoint same[2] = { { r, 0.0f }, { r, 100.0f } };
+    TEST_ASSERT_FALSE(solveSteinhartHart(same, 2, s.a, s.b, s.c));
+    TEST_ASSERT_EQUAL_FLOAT(THERM_A, s.a);   // Untouched on failure
+
+    CalPoint bad = { 0.0f, 20.0f };
+    TEST_ASSERT_FALSE(solveSteinhartHart(&bad, 1, s.a, s.b, s.c));
+    TEST_ASSERT_FALSE(solveSteinhartHart(same, 0, s.a, s.b, s.c));
+}
+
+void test_rejects_non_physical_curve(void) {
+    // Hotter reference on the higher resistance: not an NTC
+    ProbeConfig s = stockCfg();
+    CalPoint pts[2] = {
+        { resistanceFor(100.0f, s), 0.0f },
+        { resistanceFor(0.0f, s),   100.0f },
+    };
+    TEST_ASSERT_FALSE(solveSteinhartHart(pts, 2, s.a, s.b, s.c));
+}
+
+// --------------------------------------------------------------------------
+// Calibrator
+// --------------------------------------------------------------------------
+
+void test_capture_waits_for_full_stable_window(void) {
+    ProbeConfig t = trueCfg();
+    int16_t iceRaw = rawFor(resistanceFor(0.0f, t));
+
+    TEST_ASSERT_TRUE(cal->start(PROBE_MEAT1, stockCfg()));
+    feed(CAL_STABLE_SAMPLES, iceRaw);
+    TEST_ASSERT_TRUE(cal->isStable());
+
+    // Readings from before the capture don't count
+    TEST_ASSERT_TRUE(cal->capture(0.0f));
+    TEST_ASSERT_EQUAL(CalState::CAPTURING, cal->getState());
+    feed(CAL_STABLE_SAMPLES - 1, iceRaw, 2);
+    TEST_ASSERT_EQUAL_UINT8(0, cal->getPointCount());
+    feed(1, iceRaw, 2);
+    TEST_ASSERT_EQUAL_UINT8(1, cal->getPointCount());
+    TEST_ASSERT_EQUAL(CalState::SAMPLING, cal->getState());
+    TEST_ASSERT_FLOAT_WITHIN(resistanceFor(0.0f, t) * 0.002f,
+                             resistanceFor(0.0f, t), cal->getPoint(0).resistance);
+}
+
+void test_drifting_probe_times_out(void) {
+    TEST_ASSERT_TRUE(cal->start(PROBE_MEAT1, stockCfg()));
+    TEST_ASSERT_TRUE(cal->capture(100.0f));
+    int16_t raw = 12000;
+    for (uint32_t i = 0; i <= CAL_CAPTURE_TIMEOUT_MS / TEMP_SAMPLE_INTERVAL_MS; i++) {
+        feed(1, raw);
+        raw += 20;   // Still heating
+    }
+    TEST_ASSERT_EQUAL(CalState::SAMPLING, cal->getState());
+    TEST_ASSERT_EQUAL_UINT8(0, cal->getPointCount());
+    TEST_ASSERT_EQUAL_STRING("Reading never settled", cal->getError());
+}
+
+void test_disconnect_restarts_window(void) {
+    TEST_ASSERT_TRUE(cal->start(PROBE_MEAT1, stockCfg()));
+    TEST_ASSERT_TRUE(cal->capture(0.0f));
+    feed(CAL_STABLE_SAMPLES - 1, 26000);
+    cal->update(nowMs, 0, false);
+    nowMs += TEMP_SAMPLE_INTERVAL_MS;
+    feed(CAL_STABLE_SAMPLES - 1, 26000);
+    TEST_ASSERT_EQUAL_UINT8(0, cal->getPointCount());
+    feed(1, 26000);
+    TEST_ASSERT_EQUAL_UINT8(1, cal->getPointCount());
+}
+
+void test_capture_rules(void) {
+    TEST_ASSERT_FALSE(cal->capture(0.0f));
+    TEST_ASSERT_EQUAL_STRING("Not calibrating", cal->getError());
+    TEST_ASSERT_FALSE(cal->start(NUM_PROBES, stockCfg()));
+
+    ProbeConfig t = trueCfg();
+    TEST_ASSERT_TRUE(cal->start(PROBE_PIT, stockCfg()));
+    TEST_ASSERT_TRUE(cal->capture(0.0f));
+    TEST_ASSERT_FALSE(cal->capture(50.0f));
+    TEST_ASSERT_EQUAL_STRING("Capture in progress", cal->getError());
+    feed(CAL_STABLE_SAMPLES, rawFor(resistanceFor(0.0f, t)));
+
+    TEST_ASSERT_FALSE(cal->capture(CAL_MIN_SPREAD_C / 2));
+    TEST_ASSERT_EQUAL_STRING("Too close to an earlier point", cal->getError());
+
+    const float refs[] = { 60.0f, 100.0f };
+    for (float r : refs) {
+        TEST_ASSERT_TRUE(cal->capture(r));
+        feed(CAL_STABLE_SAMPLES, rawFor(resistanceFor(r, t)));
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, cal->getPointCount());
+    TEST_ASSERT_FALSE(cal->capture(150.0f));
+    TEST_ASSERT_EQUAL_STRING("All points taken", cal->getError());
+}
+
+void test_solve_applies_and_zeroes_offset(void) {
+    ProbeConfig t = trueCfg();
+    ProbeConfig cur = stockCfg();
+    cur.offset = 1.5f;
+    TEST_ASSERT_TRUE(cal->start(PROBE_MEAT2, cur));
+
+    ProbeConfig out;
+    TEST_ASSERT_FALSE(cal->solve(out));
+    TEST_ASSERT_EQUAL_STRING("No points taken", cal->getError());
+
+    const float refs[] = { 0.0f, 100.0f };
+    for (float r : refs) {
+        TEST_ASSERT_TRUE(cal->capture(r));
+        feed(CAL_STABLE_SAMPLES, rawFor(resistanceFor(r, t)));
+    }
+    TEST_ASSERT_TRUE(cal->solve(out));
+    TEST_ASSERT_EQUAL(CalState::IDLE, cal->getState());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, out.offset);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 50.0f,
+                             TempManager::resistanceToTempC(resistanceFor(50.0f, t), out));
+}
+
+void test_status_json(void) {
+    char buf[256];
+    cal->writeStatus(buf, sizeof(buf), true);
+    TEST_ASSERT_EQUAL_STRING("{\"state\":\"idle\",\"probe\":0,\"points\":[],\"reading\":null,"
+                             "\"samples\":0,\"stable\":false,\"error\":\"\"}", buf);
+
+    ProbeConfig s = stockCfg();
+    TEST_ASSERT_TRUE(cal->start(PROBE_MEAT1, s));
+    TEST_ASSERT_TRUE(cal->capture(0.0f));
+    feed(CAL_STABLE_SAMPLES, rawFor(resistanceFor(0.0f, s)));
+    size_t n = cal->writeStatus(buf, sizeof(buf), true);
+    TEST_ASSERT_EQUAL(strlen(buf), n);
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\"state\":\"sampling\",\"probe\":1,\"points\":[{\"ref\":32.0,"));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\"reading\":32.0,\"samples\":30,\"stable\":true"));
+
+    // Truncates instead of overrunning
+    n = cal->writeStatus(buf, 16, true);
+    TEST_ASSERT_EQUAL(15, n);
+    TEST_ASSERT_EQUAL(15, strlen(buf));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_three_points_recover_curve);
+    RUN_TEST(test_two_points_fit_a_and_b);
+    RUN_TEST(test_one_point_moves_a_only);
+    RUN_TEST(test_rejects_degenerate_points);
+    RUN_TEST(test_rejects_non_physical_curve);
+    RUN_TEST(test_capture_waits_for_full_stable_window);
+    RUN_TEST(test_drifting_probe_times_out);
+    RUN_TEST(test_disconnect_restarts_window);
+    RUN_TEST(test_capture_rules);
+    RUN_TEST(test_solve_applies_and_zeroes_offset);
+    RUN_TEST(test_status_json);
+
+    return UNITY_END();
+}
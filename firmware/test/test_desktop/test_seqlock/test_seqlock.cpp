@@ -0,0 +1,152 @@
+/**
+ * test_seqlock.cpp
+ *
+ * Tests for the Seqlock single-writer snapshot on the native platform.
+ *
+ * Covers the single-threaded contract (read returns the last write, version
+ * counts writes, update edits in place) plus a two-thread stress run: the
+ * writer publishes structs whose fields must always agree, and the reader
+ * must never see a torn mix. A reader facing a writer parked mid-write has
+ * to wait it out rather than take the half-written value.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "seqlock.h"
+
+struct Sample {
+    uint32_t a;
+    uint32_t b;
+    float    c;
+    uint8_t  pad[20];
+};
+
+static Seqlock<Sample>* box;
+
+void setUp(void) {
+    box = new Seqlock<Sample>();
+}
+
+void tearDown(void) {
+    delete box;
+    box = nullptr;
+}
+
+static Sample makeSample(uint32_t n) {
+    Sample s;
+    s.a = n;
+    s.b = ~n;
+    s.c = (float)n;
+    for (uint8_t i = 0; i < sizeof(s.pad); i++) s.pad[i] = (uint8_t)n;
+    return s;
+}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+
+void test_initial_value_is_zeroed(void) {
+    Sample s = box->read();
+    TEST_ASSERT_EQUAL_UINT32(0, s.a);
+    TEST_ASSERT_EQUAL_UINT32(0, s.b);
+    TEST_ASSERT_EQUAL_UINT32(0, box->version());
+}
+
+void test_read_returns_last_write(void) {
+    box->write(makeSample(7));
+    box->write(makeSample(42));
+    Sample s = box->read();
+    TEST_ASSERT_EQUAL_UINT32(42, s.a);
+    TEST_ASSERT_EQUAL_UINT32(~42u, s.b);
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, s.c);
+}
+
+void test_version_counts_writes(void) {
+    for (uint32_t i = 0; i < 5; i++) box->write(makeSample(i));
+    TEST_ASSERT_EQUAL_UINT32(5, box->version());
+    box->read();
+    TEST_ASSERT_EQUAL_UINT32(5, box->version());
+}
+
+void test_update_changes_value_in_place(void) {
+    box->write(makeSample(3));
+    box->update([](Sample& s) { s.a += 1; s.b = ~s.a; });
+    Sample s = box->read();
+    TEST_ASSERT_EQUAL_UINT32(4, s.a);
+    TEST_ASSERT_EQUAL_UINT32(~4u, s.b);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, s.c);
+    TEST_ASSERT_EQUAL_UINT32(2, box->version());
+}
+
+void test_concurrent_reads_never_torn(void) {
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (uint32_t i = 1; i <= 200000; i++) box->write(makeSample(i));
+        done = true;
+    });
+
+    uint32_t torn = 0, last = 0;
+    bool monotonic = true;
+    while (!done) {
+        Sample s = box->read();
+        if (s.a == 0) continue;   // Writer hasn't published yet
+        if (s.b != ~s.a || s.c != (float)s.a || s.pad[19] != (uint8_t)s.a) torn++;
+        if (s.a < last) monotonic = false;
+        last = s.a;
+    }
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_TRUE(monotonic);
+    TEST_ASSERT_EQUAL_UINT32(200000, box->read().a);
+}
+
+// A reader that found the writer parked mid-write (as async_tcp preempting
+// loop() on one core) can't spin forever: it must give the writer a turn and
+// return the value once the write lands.
+void test_read_waits_out_parked_writer(void) {
+    box->write(makeSample(1));
+    std::atomic<bool> inWrite(false), release(false), readDone(false);
+    std::thread writer([&]() {
+        box->update([&](Sample& s) {
+            s = makeSample(2);
+            inWrite = true;
+            while (!release) std::this_thread::yield();
+        });
+    });
+    while (!inWrite) std::this_thread::yield();
+
+    Sample got;
+    std::thread reader([&]() {
+        got = box->read();
+        readDone = true;
+    });
+    for (int i = 0; i < 1000; i++) std::this_thread::yield();
+    TEST_ASSERT_FALSE(readDone);        // Still waiting on the write
+    release = true;
+    reader.join();
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(2, got.a);
+    TEST_ASSERT_EQUAL_UINT32(~2u, got.b);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_initial_value_is_zeroed);
+    RUN_TEST(test_read_returns_last_write);
+    RUN_TEST(test_version_counts_writes);
+    RUN_TEST(test_update_changes_value_in_place);
+    RUN_TEST(test_concurrent_reads_never_torn);
+    RUN_TEST(test_read_waits_out_parked_writer);
+
+    return UNITY_END();
+}
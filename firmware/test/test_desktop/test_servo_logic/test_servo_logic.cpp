@@ -0,0 +1,212 @@
+/**
+ * test_servo_logic.cpp
+ *
+ * Tests for ServoController logic on the native platform.
+ *
+ * The ESP32Servo calls are guarded by #ifndef NATIVE_BUILD in
+ * servo_controller.cpp, so only the position, slew, deadband and
+ * attach/detach state run here. The clock comes from setNowMs().
+ */
+
+#include <unity.h>
+#include <stdint.h>
+
+// Include the actual module under test
+#include "servo_controller.h"
+#include "servo_controller.cpp"
+
+// --------------------------------------------------------------------------
+// setUp / tearDown
+// --------------------------------------------------------------------------
+
+static ServoController* servo;
+static unsigned long g_nowMs;
+
+static void runServo(unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += CONTROL_TICK_MS) {
+        g_nowMs += CONTROL_TICK_MS;
+        servo->setNowMs(g_nowMs);
+        servo->update();
+    }
+}
+
+void setUp(void) {
+    g_nowMs = 0;
+    servo = new ServoController();
+    servo->setNowMs(0);
+    servo->begin(PIN_SERVO);
+}
+
+void tearDown(void) {
+    delete servo;
+    servo = nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Tests: Initial state
+// --------------------------------------------------------------------------
+
+void test_starts_closed_and_attached(void) {
+    TEST_ASSERT_EQUAL_UINT8(DAMPER_CLOSED, servo->getCurrentAngle());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, servo->getCurrentPositionPct());
+    TEST_ASSERT_TRUE(servo->isAttached());
+    TEST_ASSERT_FALSE(servo->isMoving());
+}
+
+void test_no_pin_never_attaches(void) {
+    ServoController none;
+    none.begin(-1);
+    none.setPosition(100.0f);
+    none.setNowMs(5000);
+    none.update();
+    TEST_ASSERT_FALSE(none.isAttached());
+    TEST_ASSERT_TRUE(none.getCurrentPositionPct() > 0.0f);
+}
+
+// --------------------------------------------------------------------------
+// Tests: Slew rate
+// --------------------------------------------------------------------------
+
+void test_set_position_only_sets_target(void) {
+    servo->setPosition(100.0f);
+    TEST_ASSERT_EQUAL_UINT8(DAMPER_CLOSED, servo->getCurrentAngle());
+    TEST_ASSERT_TRUE(servo->isMoving());
+}
+
+void test_slews_at_configured_rate(void) {
+    servo->setSlewRate(60.0f);
+    servo->setPosition(100.0f);
+    runServo(500);   // 30 degrees of 90
+    TEST_ASSERT_UINT32_WITHIN(1, DAMPER_CLOSED + 30, servo->getCurrentAngle());
+    TEST_ASSERT_TRUE(servo->isMoving());
+
+    runServo(1100);
+    TEST_ASSERT_EQUAL_UINT8(DAMPER_OPEN, servo->getCurrentAngle());
+    TEST_ASSERT_FALSE(servo->isMoving());
+}
+
+void test_zero_slew_rate_jumps(void) {
+    servo->setSlewRate(0.0f);
+    servo->setPosition(50.0f);
+    runServo(CONTROL_TICK_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 50.0f, servo->getCurrentPositionPct());
+}
+
+void test_slews_back_down(void) {
+    servo->setSlewRate(0.0f);
+    servo->setPosition(100.0f);
+    runServo(CONTROL_TICK_MS);
+    servo->setSlewRate(90.0f);
+    servo->setPosition(0.0f);
+    runServo(500);
+    TEST_ASSERT_UINT32_WITHIN(1, DAMPER_OPEN - 45, servo->getCurrentAngle());
+}
+
+// --------------------------------------------------------------------------
+// Tests: Deadband
+// --------------------------------------------------------------------------
+
+void test_small_move_ignored(void) {
+    servo->setSlewRate(0.0f);
+    servo->setPosition(50.0f);
+    runServo(CONTROL_TICK_MS);
+    float pct = servo->getCurrentPositionPct();
+
+    // Less than SERVO_DEADBAND_DEG of travel
+    servo->setPosition(50.0f + SERVO_DEADBAND_DEG * 0.5f / (DAMPER_OPEN - DAMPER_CLOSED) * 100.0f);
+    TEST_ASSERT_FALSE(servo->isMoving());
+    runServo(CONTROL_TICK_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, pct, servo->getCurrentPositionPct());
+}
+
+void test_end_stop_always_reached(void) {
+    servo->setSlewRate(0.0f);
+    servo->setPosition(0.5f);   // Inside the deadband of closed
+    TEST_ASSERT_FALSE(servo->isMoving());
+    servo->setPosition(100.0f);
+    runServo(CONTROL_TICK_MS);
+    servo->setPosition(99.5f);
+    servo->setPosition(100.0f);
+    runServo(CONTROL_TICK_MS);
+    TEST_ASSERT_EQUAL_UINT8(DAMPER_OPEN, servo->getCurrentAngle());
+}
+
+// --------------------------------------------------------------------------
+// Tests: Auto-detach
+// --------------------------------------------------------------------------
+
+void test_detaches_after_settling(void) {
+    runServo(SERVO_DETACH_MS - 100);
+    TEST_ASSERT_TRUE(servo->isAttached());
+    runServo(200);
+    TEST_ASSERT_FALSE(servo->isAttached());
+}
+
+void test_reattaches_on_motion(void) {
+    runServo(SERVO_DETACH_MS + 100);
+    TEST_ASSERT_FALSE(servo->isAttached());
+
+    servo->setPosition(50.0f);
+    runServo(CONTROL_TICK_MS);
+    TEST_ASSERT_TRUE(servo->isAttached());
+}
+
+void test_stays_attached_while_moving(void) {
+    servo->setSlewRate(30.0f);   // 3 s for the full travel
+    servo->setPosition(100.0f);
+    runServo(SERVO_DETACH_MS + 500);
+    TEST_ASSERT_TRUE(servo->isAttached());
+    TEST_ASSERT_TRUE(servo->isMoving());
+}
+
+void test_unchanged_target_stays_detached(void) {
+    servo->setPosition(0.0f);
+    runServo(SERVO_DETACH_MS + 100);
+    servo->setPosition(0.0f);
+    runServo(SERVO_DETACH_MS);
+    TEST_ASSERT_FALSE(servo->isAttached());
+}
+
+// --------------------------------------------------------------------------
+// Tests: setAngle
+// --------------------------------------------------------------------------
+
+void test_set_angle_moves_now(void) {
+    servo->setAngle(45);
+    TEST_ASSERT_EQUAL_UINT8(45, servo->getCurrentAngle());
+    TEST_ASSERT_FALSE(servo->isMoving());
+    TEST_ASSERT_TRUE(servo->isAttached());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Initial state
+    RUN_TEST(test_starts_closed_and_attached);
+    RUN_TEST(test_no_pin_never_attaches);
+
+    // Slew rate
+    RUN_TEST(test_set_position_only_sets_target);
+    RUN_TEST(test_slews_at_configured_rate);
+    RUN_TEST(test_zero_slew_rate_jumps);
+    RUN_TEST(test_slews_back_down);
+
+    // Deadband
+    RUN_TEST(test_small_move_ignored);
+    RUN_TEST(test_end_stop_always_reached);
+
+    // Auto-detach
+    RUN_TEST(test_detaches_after_settling);
+    RUN_TEST(test_reattaches_on_motion);
+    RUN_TEST(test_stays_attached_while_moving);
+    RUN_TEST(test_unchanged_target_stays_detached);
+
+    // setAngle
+    RUN_TEST(test_set_angle_moves_now);
+
+    return UNITY_END();
+}
@@ -12,9 +12,9 @@
  *   - CSV generation format
  *   - Session active state management
  *
- * The String class is used by toCSV() and toJSON(). On native builds with
- * PlatformIO, the Arduino String class is not available. We provide a minimal
- * String implementation to allow compilation.
+ * The String class collects whole exports for the format checks. On native
+ * builds with PlatformIO, the Arduino String class is not available. We
+ * provide a minimal String implementation to allow compilation.
  */
 
 #include <unity.h>
@@ -84,6 +84,10 @@ private:
 // Now include the module under test
 #include "cook_session.h"
 #include "cook_session.cpp"
+#include "session_archive.cpp"
+#include "session_events.cpp"
+#include "session_log.cpp"
+#include "ext_ram.cpp"
 
 // --------------------------------------------------------------------------
 // setUp / tearDown
@@ -110,15 +114,29 @@ static DataPoint makePoint(uint32_t ts, float pitF, float meat1F, float meat2F,
                             uint8_t fan, uint8_t damper, uint8_t flags) {
     DataPoint dp;
     dp.timestamp = ts;
-    dp.pitTemp   = (int16_t)(pitF * 10.0f);
-    dp.meat1Temp = (int16_t)(meat1F * 10.0f);
-    dp.meat2Temp = (int16_t)(meat2F * 10.0f);
+    dp.temp[PROBE_PIT]   = (int16_t)(pitF * 10.0f);
+    dp.temp[PROBE_MEAT1] = (int16_t)(meat1F * 10.0f);
+    dp.temp[PROBE_MEAT2] = (int16_t)(meat2F * 10.0f);
     dp.fanPct    = fan;
     dp.damperPct = damper;
     dp.flags     = flags;
     return dp;
 }
 
+// Helper: the whole export in one string, through 256-byte chunks
+static String exportAll(ExportFormat fmt) {
+    String out;
+    ExportCursor cursor;
+    session->beginExport(cursor, fmt);
+    char chunk[256];
+    size_t n;
+    while ((n = session->exportChunk(cursor, chunk, sizeof(chunk) - 1)) > 0) {
+        chunk[n] = '\0';
+        out += chunk;
+    }
+    return out;
+}
+
 // --------------------------------------------------------------------------
 // Tests: DataPoint encoding
 // --------------------------------------------------------------------------
@@ -126,26 +144,26 @@ static DataPoint makePoint(uint32_t ts, float pitF, float meat1F, float meat2F,
 void test_datapoint_encoding_positive_temp(void) {
     // 225.5F should be stored as 2255
     DataPoint dp = makePoint(1000, 225.5f, 0.0f, 0.0f, 0, 0, 0);
-    TEST_ASSERT_EQUAL_INT16(2255, dp.pitTemp);
+    TEST_ASSERT_EQUAL_INT16(2255, dp.temp[PROBE_PIT]);
 }
 
 void test_datapoint_encoding_zero_temp(void) {
     DataPoint dp = makePoint(1000, 0.0f, 0.0f, 0.0f, 0, 0, 0);
-    TEST_ASSERT_EQUAL_INT16(0, dp.pitTemp);
+    TEST_ASSERT_EQUAL_INT16(0, dp.temp[PROBE_PIT]);
 }
 
 void test_datapoint_encoding_negative_temp(void) {
     // -10.5F should be stored as -105
     DataPoint dp = makePoint(1000, -10.5f, 0.0f, 0.0f, 0, 0, 0);
-    TEST_ASSERT_EQUAL_INT16(-105, dp.pitTemp);
+    TEST_ASSERT_EQUAL_INT16(-105, dp.temp[PROBE_PIT]);
 }
 
 void test_datapoint_encoding_all_fields(void) {
     DataPoint dp = makePoint(1700000000, 250.0f, 165.3f, 0.0f, 45, 60, DP_FLAG_LID_OPEN);
     TEST_ASSERT_EQUAL_UINT32(1700000000, dp.timestamp);
-    TEST_ASSERT_EQUAL_INT16(2500, dp.pitTemp);
-    TEST_ASSERT_EQUAL_INT16(1653, dp.meat1Temp);
-    TEST_ASSERT_EQUAL_INT16(0, dp.meat2Temp);
+    TEST_ASSERT_EQUAL_INT16(2500, dp.temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_INT16(1653, dp.temp[PROBE_MEAT1]);
+    TEST_ASSERT_EQUAL_INT16(0, dp.temp[PROBE_MEAT2]);
     TEST_ASSERT_EQUAL_UINT8(45, dp.fanPct);
     TEST_ASSERT_EQUAL_UINT8(60, dp.damperPct);
     TEST_ASSERT_EQUAL_UINT8(DP_FLAG_LID_OPEN, dp.flags);
@@ -160,6 +178,21 @@ void test_datapoint_flags_bitmask(void) {
     TEST_ASSERT_FALSE(flags & DP_FLAG_ALARM_MEAT1);
 }
 
+void test_datapoint_alarm_mask_split(void) {
+    // Pit, meat1 and meat2 in flags, channels 3+ in alarmExt
+    DataPoint dp = makePoint(1000, 225.0f, 0.0f, 0.0f, 0, 0, DP_FLAG_LID_OPEN | DP_FLAG_MEAT2_DISC);
+    dpSetAlarmMask(dp, (1u << PROBE_PIT) | (1u << PROBE_MEAT2) | (1u << 3) | (1u << 7));
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_LID_OPEN | DP_FLAG_MEAT2_DISC | DP_FLAG_ALARM_PIT |
+                            DP_FLAG_ALARM_MEAT2, dp.flags);
+    TEST_ASSERT_EQUAL_UINT8(0x11, dp.alarmExt);
+    TEST_ASSERT_EQUAL_UINT16((1u << PROBE_PIT) | (1u << PROBE_MEAT2) | (1u << 3) | (1u << 7),
+                             dpAlarmMask(dp));
+
+    dpSetAlarmMask(dp, 0);
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_LID_OPEN | DP_FLAG_MEAT2_DISC, dp.flags);
+    TEST_ASSERT_EQUAL_UINT8(0, dp.alarmExt);
+}
+
 // --------------------------------------------------------------------------
 // Tests: Initial state
 // --------------------------------------------------------------------------
@@ -194,7 +227,7 @@ void test_add_single_point(void) {
     const DataPoint* retrieved = session->getPoint(0);
     TEST_ASSERT_NOT_NULL(retrieved);
     TEST_ASSERT_EQUAL_UINT32(1000, retrieved->timestamp);
-    TEST_ASSERT_EQUAL_INT16(2250, retrieved->pitTemp);
+    TEST_ASSERT_EQUAL_INT16(2250, retrieved->temp[PROBE_PIT]);
     TEST_ASSERT_EQUAL_UINT8(50, retrieved->fanPct);
 }
 
@@ -210,13 +243,13 @@ void test_add_multiple_points(void) {
     const DataPoint* first = session->getPoint(0);
     TEST_ASSERT_NOT_NULL(first);
     TEST_ASSERT_EQUAL_UINT32(1000, first->timestamp);
-    TEST_ASSERT_EQUAL_INT16(2000, first->pitTemp);
+    TEST_ASSERT_EQUAL_INT16(2000, first->temp[PROBE_PIT]);
 
     // Verify last point
     const DataPoint* last = session->getPoint(9);
     TEST_ASSERT_NOT_NULL(last);
     TEST_ASSERT_EQUAL_UINT32(1045, last->timestamp);
-    TEST_ASSERT_EQUAL_INT16(2090, last->pitTemp);
+    TEST_ASSERT_EQUAL_INT16(2090, last->temp[PROBE_PIT]);
 }
 
 void test_getPoint_out_of_range_returns_null(void) {
@@ -242,7 +275,7 @@ void test_circular_buffer_wrapping(void) {
 
     for (uint32_t i = 0; i < totalToAdd; i++) {
         DataPoint dp = makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0);
-        dp.pitTemp = (int16_t)(i & 0x7FFF);  // Use index as marker
+        dp.temp[PROBE_PIT] = (int16_t)(i & 0x7FFF);  // Use index as marker
         session->addPoint(dp);
     }
 
@@ -285,13 +318,247 @@ void test_circular_buffer_exact_fill(void) {
     TEST_ASSERT_EQUAL_UINT32(SESSION_BUFFER_SIZE - 1, last->timestamp);
 }
 
+void test_default_capacity_without_psram(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, session->getBufferCapacity());   // Allocated on first use
+    session->addPoint(makePoint(1000, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(SESSION_BUFFER_SIZE, session->getBufferCapacity());
+    TEST_ASSERT_EQUAL_UINT32(SESSION_ROLLUP_CAPACITY, session->getRollupCapacity());
+}
+
+void test_larger_ring_and_tiers(void) {
+    CookSession big(SESSION_BUFFER_SIZE * 4, SESSION_ROLLUP_CAPACITY * 2);
+    uint32_t totalToAdd = SESSION_BUFFER_SIZE * 3;   // More than the default ring
+    for (uint32_t i = 0; i < totalToAdd; i++) {
+        big.addPoint(makePoint(1000 + i * 5, 200.0f, 150.0f, 0.0f, 50, 20, 0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(totalToAdd, big.getPointCount());
+    TEST_ASSERT_EQUAL_UINT32(1000, big.getPoint(0)->timestamp);
+    TEST_ASSERT_EQUAL_UINT32(totalToAdd / 12, big.getLevelCount(1));
+}
+
+// --------------------------------------------------------------------------
+// Tests: readPoints (absolute indices over the whole cook)
+// --------------------------------------------------------------------------
+
+void test_readPoints_from_ram(void) {
+    for (uint32_t i = 0; i < 10; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    DataPoint out[4];
+    TEST_ASSERT_EQUAL_UINT32(4, session->readPoints(3, out, 4));
+    TEST_ASSERT_EQUAL_UINT32(1003, out[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(1006, out[3].timestamp);
+}
+
+void test_readPoints_clamps_at_end(void) {
+    for (uint32_t i = 0; i < 5; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    DataPoint out[8];
+    TEST_ASSERT_EQUAL_UINT32(2, session->readPoints(3, out, 8));
+    TEST_ASSERT_EQUAL_UINT32(1004, out[1].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(0, session->readPoints(5, out, 8));
+}
+
+void test_readPoints_absolute_after_wrap(void) {
+    uint32_t totalToAdd = SESSION_BUFFER_SIZE + 50;
+    for (uint32_t i = 0; i < totalToAdd; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(50, session->getFirstRamIndex());
+
+    // Absolute index 100 is the point added 100th, wherever it sits in the ring
+    DataPoint out[3];
+    TEST_ASSERT_EQUAL_UINT32(3, session->readPoints(100, out, 3));
+    TEST_ASSERT_EQUAL_UINT32(1100, out[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(1102, out[2].timestamp);
+}
+
+void test_readPoints_below_ram_without_flash(void) {
+    // Native build has no session file, so the flash-resident range reads empty
+    for (uint32_t i = 0; i < SESSION_BUFFER_SIZE + 10; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    DataPoint out[4];
+    TEST_ASSERT_EQUAL_UINT32(0, session->readPoints(0, out, 4));
+}
+
+void test_csv_after_wrap_has_ram_points(void) {
+    for (uint32_t i = 0; i < SESSION_BUFFER_SIZE + 10; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    // Without flash, export falls back to the ring: oldest RAM point onward
+    String csv = exportAll(ExportFormat::CSV);
+    TEST_ASSERT_TRUE(csv.indexOf("1009,") < 0);
+    TEST_ASSERT_TRUE(csv.indexOf("1010,") >= 0);
+    TEST_ASSERT_TRUE(csv.indexOf("1609,") >= 0);
+}
+
+// --------------------------------------------------------------------------
+// Tests: rollup tiers (level of detail)
+// --------------------------------------------------------------------------
+
+void test_rollup_level1_min_max_avg(void) {
+    // One full 12-sample bucket: pit 200..211, fan 0..55
+    for (uint32_t i = 0; i < 12; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 200.0f + i, 150.0f, 0.0f,
+                                    (uint8_t)(i * 5), 40, 0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1, session->getLevelCount(1));
+    RollupPoint r;
+    TEST_ASSERT_EQUAL_UINT32(1, session->readLevel(1, 0, &r, 1));
+    TEST_ASSERT_EQUAL_UINT32(1000, r.timestamp);
+    TEST_ASSERT_EQUAL_INT16(2000, r.tMin[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_INT16(2110, r.tMax[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_INT16(2055, r.tAvg[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_INT16(1500, r.tAvg[ROLLUP_MEAT1]);
+    TEST_ASSERT_EQUAL_UINT8(27, r.fanPct);
+    TEST_ASSERT_EQUAL_UINT8(40, r.damperPct);
+}
+
+void test_rollup_partial_bucket_read_as_last_point(void) {
+    // One full bucket, then 3 samples of the next
+    for (uint32_t i = 0; i < 15; i++) {
+        session->addPoint(makePoint(1000 + i * 5, i < 12 ? 200.0f : 210.0f + i, 0.0f, 0.0f,
+                                    0, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, session->getLevelCount(1));
+
+    RollupPoint r[3];
+    TEST_ASSERT_EQUAL_UINT32(2, session->readLevel(1, 0, r, 3));
+    TEST_ASSERT_EQUAL_INT16(2000, r[0].tAvg[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_UINT32(1000 + 12 * 5, r[1].timestamp);
+    TEST_ASSERT_EQUAL_INT16(2220, r[1].tMin[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_INT16(2240, r[1].tMax[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_INT16(2230, r[1].tAvg[ROLLUP_PIT]);
+
+    // Reading from the partial bucket alone
+    TEST_ASSERT_EQUAL_UINT32(1, session->readLevel(1, 1, r, 3));
+    TEST_ASSERT_EQUAL_INT16(2230, r[0].tAvg[ROLLUP_PIT]);
+    TEST_ASSERT_EQUAL_UINT32(0, session->readLevel(1, 2, r, 3));
+}
+
+void test_rollup_disconnect_excluded_from_stats(void) {
+    // Meat2 disconnected for the whole bucket, meat1 for half of it
+    for (uint32_t i = 0; i < 12; i++) {
+        uint8_t flags = DP_FLAG_MEAT2_DISC | (i < 6 ? DP_FLAG_MEAT1_DISC : 0) |
+                        (i == 3 ? DP_FLAG_LID_OPEN : 0);
+        session->addPoint(makePoint(1000 + i, 225.0f, i < 6 ? 0.0f : 160.0f, 0.0f,
+                                    0, 0, flags));
+    }
+
+    RollupPoint r;
+    session->readLevel(1, 0, &r, 1);
+    TEST_ASSERT_EQUAL_INT16(1600, r.tMin[ROLLUP_MEAT1]);
+    TEST_ASSERT_EQUAL_INT16(1600, r.tAvg[ROLLUP_MEAT1]);
+    TEST_ASSERT_FALSE(r.flags & DP_FLAG_MEAT1_DISC);
+    TEST_ASSERT_TRUE(r.flags & DP_FLAG_MEAT2_DISC);
+    TEST_ASSERT_TRUE(r.flags & DP_FLAG_LID_OPEN);
+}
+
+void test_rollup_keeps_alarms_of_any_sample(void) {
+    // A done alarm past meat2 in one sample of the bucket
+    for (uint32_t i = 0; i < 12; i++) {
+        DataPoint dp = makePoint(1000 + i * 5, 225.0f, 150.0f, 0.0f, 0, 0, 0);
+        if (i == 4) dpSetAlarmMask(dp, (1u << PROBE_MEAT1) | (1u << 3));
+        session->addPoint(dp);
+    }
+
+    RollupPoint r;
+    TEST_ASSERT_EQUAL_UINT32(1, session->readLevel(1, 0, &r, 1));
+    TEST_ASSERT_EQUAL_UINT16((1u << PROBE_MEAT1) | (1u << 3), dpAlarmMask(r));
+}
+
+void test_rollup_tiers_count_long_cook(void) {
+    // 14 hours at 5 s = 10080 samples
+    for (uint32_t i = 0; i < 10080; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 150.0f, 0.0f, 30, 30, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(10080, session->getLevelCount(0));
+    TEST_ASSERT_EQUAL_UINT32(SESSION_ROLLUP_CAPACITY, session->getLevelCount(1));  // 840 buckets, capped
+    TEST_ASSERT_EQUAL_UINT32(168, session->getLevelCount(2));
+    TEST_ASSERT_EQUAL_UINT32(28, session->getLevelCount(3));
+}
+
+void test_rollup_file_header_checks_layout(void) {
+    RollupFileHeader hdr;
+    rollupFileHeaderInit(hdr, 2);
+    TEST_ASSERT_TRUE(rollupFileHeaderValid(hdr, 2));
+    TEST_ASSERT_FALSE(rollupFileHeaderValid(hdr, 1));     // Another tier's file
+
+    RollupFileHeader other = hdr;
+    other.channels = NUM_PROBES + 1;                      // Another build profile
+    TEST_ASSERT_FALSE(rollupFileHeaderValid(other, 2));
+    other = hdr;
+    other.pointSize = sizeof(RollupPoint) - 2;
+    TEST_ASSERT_FALSE(rollupFileHeaderValid(other, 2));
+
+    // A headerless file from older firmware starts with a bucket timestamp
+    RollupPoint legacy;
+    memset(&legacy, 0, sizeof(legacy));
+    legacy.timestamp = 1707590000;
+    memcpy(&other, &legacy, sizeof(other));
+    TEST_ASSERT_FALSE(rollupFileHeaderValid(other, 2));
+}
+
+void test_selectLevel_picks_finest_that_fits(void) {
+    for (uint32_t i = 0; i < 10080; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 150.0f, 0.0f, 30, 30, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, session->selectLevel(20000));
+    // Level 1 has room for only 6 h of the 14 h cook, so it's skipped
+    TEST_ASSERT_EQUAL_UINT8(2, session->selectLevel(1000));
+    TEST_ASSERT_EQUAL_UINT8(2, session->selectLevel(240));
+    TEST_ASSERT_EQUAL_UINT8(3, session->selectLevel(100));
+    TEST_ASSERT_EQUAL_UINT8(3, session->selectLevel(5));   // Coarsest as a last resort
+}
+
+void test_readLevel_raw_matches_points(void) {
+    for (uint32_t i = 0; i < 5; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f + i, 150.0f, 0.0f, 10, 20, 0));
+    }
+
+    RollupPoint out[5];
+    TEST_ASSERT_EQUAL_UINT32(5, session->readLevel(0, 0, out, 5));
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1000 + i, out[i].timestamp);
+        TEST_ASSERT_EQUAL_INT16((int16_t)(2000 + i * 10), out[i].tAvg[ROLLUP_PIT]);
+        TEST_ASSERT_EQUAL_INT16(out[i].tAvg[ROLLUP_PIT], out[i].tMin[ROLLUP_PIT]);
+        TEST_ASSERT_EQUAL_UINT8(20, out[i].damperPct);
+    }
+}
+
+void test_clear_resets_rollups(void) {
+    for (uint32_t i = 0; i < 24; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    session->clear();
+    TEST_ASSERT_EQUAL_UINT32(0, session->getLevelCount(1));
+
+    // A fresh bucket starts from the next point, not a leftover partial
+    for (uint32_t i = 0; i < 12; i++) {
+        session->addPoint(makePoint(5000 + i, 250.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    RollupPoint r;
+    TEST_ASSERT_EQUAL_UINT32(1, session->readLevel(1, 0, &r, 1));
+    TEST_ASSERT_EQUAL_UINT32(5000, r.timestamp);
+    TEST_ASSERT_EQUAL_INT16(2500, r.tAvg[ROLLUP_PIT]);
+}
+
 // --------------------------------------------------------------------------
 // Tests: CSV generation
 // --------------------------------------------------------------------------
 
 void test_csv_header(void) {
-    // Even with no data, toCSV should produce a header line
-    String csv = session->toCSV();
+    // Even with no data, the CSV export has a header line
+    String csv = exportAll(ExportFormat::CSV);
     TEST_ASSERT_TRUE(csv.indexOf("timestamp,pit,meat1,meat2,fan,damper,flags") >= 0);
 }
 
@@ -299,7 +566,7 @@ void test_csv_single_point(void) {
     DataPoint dp = makePoint(1700000000, 225.5f, 165.0f, 0.0f, 45, 60, 0x01);
     session->addPoint(dp);
 
-    String csv = session->toCSV();
+    String csv = exportAll(ExportFormat::CSV);
 
     // Check header exists
     TEST_ASSERT_TRUE(csv.indexOf("timestamp,pit,meat1,meat2,fan,damper,flags") >= 0);
@@ -320,7 +587,7 @@ void test_csv_multiple_points(void) {
     session->addPoint(dp1);
     session->addPoint(dp2);
 
-    String csv = session->toCSV();
+    String csv = exportAll(ExportFormat::CSV);
 
     // Both timestamps should appear
     TEST_ASSERT_TRUE(csv.indexOf("1000") >= 0);
@@ -368,6 +635,37 @@ void test_clear_resets_everything(void) {
     TEST_ASSERT_EQUAL_UINT32(0, session->getStartTime());
 }
 
+void test_peaks_skip_disconnected_probes(void) {
+    TEST_ASSERT_EQUAL_INT16(SESSION_PEAK_NONE, session->getPeak(ROLLUP_PIT));
+
+    session->addPoint(makePoint(1000, 225.0f, 150.0f, 0.0f, 0, 0, DP_FLAG_MEAT2_DISC));
+    session->addPoint(makePoint(1005, 260.5f, 140.0f, 0.0f, 0, 0, DP_FLAG_MEAT2_DISC));
+    session->addPoint(makePoint(1010, 240.0f, 999.0f, 0.0f, 0, 0,
+                                DP_FLAG_MEAT1_DISC | DP_FLAG_MEAT2_DISC));
+
+    TEST_ASSERT_EQUAL_INT16(2605, session->getPeak(ROLLUP_PIT));
+    TEST_ASSERT_EQUAL_INT16(1500, session->getPeak(ROLLUP_MEAT1));
+    TEST_ASSERT_EQUAL_INT16(SESSION_PEAK_NONE, session->getPeak(ROLLUP_MEAT2));
+
+    session->clear();
+    TEST_ASSERT_EQUAL_INT16(SESSION_PEAK_NONE, session->getPeak(ROLLUP_PIT));
+}
+
+void test_events_only_journalled_while_recording(void) {
+    session->logEvent(SessionEventType::SETPOINT, 2250, 1000);
+    TEST_ASSERT_EQUAL_UINT16(0, session->getEvents().count());
+
+    session->startSession();
+    session->logEvent(SessionEventType::SETPOINT, 2250, 1000);
+    session->logEvent(SessionEventType::SETPOINT, 2250, 1005);
+    session->logEvent(SessionEventType::SETPOINT, 2500, 1010);
+    TEST_ASSERT_EQUAL_UINT16(2, session->getEvents().count());
+    TEST_ASSERT_EQUAL_INT16(2500, session->getEvents().latest(SessionEventType::SETPOINT));
+
+    session->clear();
+    TEST_ASSERT_EQUAL_UINT16(0, session->getEvents().count());
+}
+
 // --------------------------------------------------------------------------
 // Tests: loadFromFlash returns false on native
 // --------------------------------------------------------------------------
@@ -389,20 +687,75 @@ void test_getElapsedSec_zero_on_native(void) {
 // Tests: setDataSources (just verify it doesn't crash)
 // --------------------------------------------------------------------------
 
-static float stubPitTemp()   { return 225.0f; }
-static float stubMeat1Temp() { return 165.0f; }
-static float stubMeat2Temp() { return 0.0f; }
+static float stubTemp(uint8_t probe) { return probe == PROBE_PIT ? 225.0f : 165.0f; }
+static bool stubConnected(uint8_t probe) { return probe != PROBE_MEAT2; }
 static uint8_t stubFanPct()  { return 50; }
 static uint8_t stubDamper()  { return 30; }
 static uint8_t stubFlags()   { return 0; }
 
 void test_setDataSources_no_crash(void) {
-    session->setDataSources(stubPitTemp, stubMeat1Temp, stubMeat2Temp,
-                             stubFanPct, stubDamper, stubFlags);
+    session->setDataSources(stubTemp, stubConnected, stubFanPct, stubDamper, stubFlags);
     // Just verifying no crash
     TEST_ASSERT_TRUE(true);
 }
 
+// --------------------------------------------------------------------------
+// Tests: streaming export
+// --------------------------------------------------------------------------
+
+static std::string streamExport(CookSession* s, ExportFormat fmt, size_t chunkSize) {
+    ExportCursor cursor;
+    s->beginExport(cursor, fmt);
+    std::string out;
+    char chunk[512];
+    size_t n;
+    while ((n = s->exportChunk(cursor, chunk, chunkSize)) > 0) {
+        out.append(chunk, n);
+    }
+    return out;
+}
+
+void test_export_csv_same_for_any_chunk_size(void) {
+    for (uint32_t i = 0; i < 100; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f + i, 150.0f, 0.0f, 50, 30, 0));
+    }
+    std::string expected = exportAll(ExportFormat::CSV).c_str();
+
+    const size_t sizes[] = { 1, 7, 64, 500 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(),
+                                 streamExport(session, ExportFormat::CSV, sizes[i]).c_str());
+    }
+}
+
+void test_export_json_is_well_formed(void) {
+    for (uint32_t i = 0; i < 3; i++) {
+        session->addPoint(makePoint(1000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    std::string json = streamExport(session, ExportFormat::JSON, 13);
+    TEST_ASSERT_EQUAL_INT('[', json.front());
+    TEST_ASSERT_EQUAL_INT(']', json.back());
+    TEST_ASSERT_TRUE(json.find("},{") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find(",]") == std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ts\":1002") != std::string::npos);
+}
+
+void test_export_empty_session(void) {
+    TEST_ASSERT_EQUAL_STRING("[]", streamExport(session, ExportFormat::JSON, 64).c_str());
+    TEST_ASSERT_EQUAL_STRING("timestamp,pit,meat1,meat2,fan,damper,flags\n",
+                             streamExport(session, ExportFormat::CSV, 64).c_str());
+}
+
+void test_export_finished_cursor_returns_zero(void) {
+    session->addPoint(makePoint(1000, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    ExportCursor cursor;
+    session->beginExport(cursor, ExportFormat::CSV);
+    char chunk[512];
+    TEST_ASSERT_TRUE(session->exportChunk(cursor, chunk, sizeof(chunk)) > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, session->exportChunk(cursor, chunk, sizeof(chunk)));
+    TEST_ASSERT_EQUAL_UINT32(0, session->exportChunk(cursor, chunk, sizeof(chunk)));
+}
+
 // --------------------------------------------------------------------------
 // Tests: DataPoint struct size
 // --------------------------------------------------------------------------
@@ -421,7 +774,7 @@ void test_datapoint_struct_size(void) {
 // --------------------------------------------------------------------------
 
 void test_json_empty_is_array(void) {
-    String json = session->toJSON();
+    String json = exportAll(ExportFormat::JSON);
     TEST_ASSERT_TRUE(json.indexOf("[") >= 0);
     TEST_ASSERT_TRUE(json.indexOf("]") >= 0);
 }
@@ -430,7 +783,7 @@ void test_json_single_point(void) {
     DataPoint dp = makePoint(1700000000, 225.5f, 0.0f, 0.0f, 50, 30, 0);
     session->addPoint(dp);
 
-    String json = session->toJSON();
+    String json = exportAll(ExportFormat::JSON);
     TEST_ASSERT_TRUE(json.indexOf("\"ts\":1700000000") >= 0);
     TEST_ASSERT_TRUE(json.indexOf("\"pit\":225.5") >= 0);
     TEST_ASSERT_TRUE(json.indexOf("\"fan\":50") >= 0);
@@ -449,6 +802,7 @@ int main(int argc, char** argv) {
     RUN_TEST(test_datapoint_encoding_negative_temp);
     RUN_TEST(test_datapoint_encoding_all_fields);
     RUN_TEST(test_datapoint_flags_bitmask);
+    RUN_TEST(test_datapoint_alarm_mask_split);
 
     // Initial state
     RUN_TEST(test_initial_point_count_zero);
@@ -465,6 +819,32 @@ int main(int argc, char** argv) {
     // Circular buffer
     RUN_TEST(test_circular_buffer_wrapping);
     RUN_TEST(test_circular_buffer_exact_fill);
+    RUN_TEST(test_default_capacity_without_psram);
+    RUN_TEST(test_larger_ring_and_tiers);
+
+    // readPoints
+    RUN_TEST(test_readPoints_from_ram);
+    RUN_TEST(test_readPoints_clamps_at_end);
+    RUN_TEST(test_readPoints_absolute_after_wrap);
+    RUN_TEST(test_readPoints_below_ram_without_flash);
+    RUN_TEST(test_csv_after_wrap_has_ram_points);
+
+    // Rollup tiers
+    RUN_TEST(test_rollup_level1_min_max_avg);
+    RUN_TEST(test_rollup_partial_bucket_read_as_last_point);
+    RUN_TEST(test_rollup_disconnect_excluded_from_stats);
+    RUN_TEST(test_rollup_keeps_alarms_of_any_sample);
+    RUN_TEST(test_rollup_tiers_count_long_cook);
+    RUN_TEST(test_rollup_file_header_checks_layout);
+    RUN_TEST(test_selectLevel_picks_finest_that_fits);
+    RUN_TEST(test_readLevel_raw_matches_points);
+    RUN_TEST(test_clear_resets_rollups);
+
+    // Streaming export
+    RUN_TEST(test_export_csv_same_for_any_chunk_size);
+    RUN_TEST(test_export_json_is_well_formed);
+    RUN_TEST(test_export_empty_session);
+    RUN_TEST(test_export_finished_cursor_returns_zero);
 
     // CSV
     RUN_TEST(test_csv_header);
@@ -476,6 +856,8 @@ int main(int argc, char** argv) {
     RUN_TEST(test_endSession_clears_active);
     RUN_TEST(test_startSession_clears_previous_data);
     RUN_TEST(test_clear_resets_everything);
+    RUN_TEST(test_peaks_skip_disconnected_probes);
+    RUN_TEST(test_events_only_journalled_while_recording);
 
     // Native-specific behavior
     RUN_TEST(test_loadFromFlash_returns_false_on_native);
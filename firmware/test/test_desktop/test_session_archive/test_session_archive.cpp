@@ -0,0 +1,233 @@
+/**
+ * test_session_archive.cpp
+ *
+ * Tests for the past-cook archive index on the native platform.
+ *
+ * Covers id assignment, rotation by count and by byte budget, and the
+ * CRC-checked index file image, including version 1 images and images
+ * from a build with another channel count. Moving and deleting the archived files is
+ * LittleFS work in CookSession and isn't exercised here.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "session_archive.h"
+#include "session_archive.cpp"
+#include "session_log.cpp"
+
+static SessionArchiveIndex* idx;
+
+void setUp(void) {
+    idx = new SessionArchiveIndex();
+}
+
+void tearDown(void) {
+    delete idx;
+    idx = nullptr;
+}
+
+static SessionArchiveEntry makeEntry(uint32_t start, uint32_t bytes) {
+    SessionArchiveEntry e;
+    memset(&e, 0, sizeof(e));
+    e.startTime   = start;
+    e.durationSec = 12 * 3600;
+    e.points      = 8640;
+    e.bytes       = bytes;
+    e.peak[0]     = 2750;
+    e.peak[1]     = 2030;
+    e.peak[2]     = SESSION_PEAK_NONE;
+    for (uint8_t c = 3; c < NUM_PROBES; c++) e.peak[c] = (int16_t)(1000 + c);
+    e.segments    = 1;
+    return e;
+}
+
+// Hand-built index image with `channels` peaks per entry, as another
+// build (or version 1, with 3) writes it
+static size_t buildImage(uint8_t* buf, uint8_t version, uint8_t channels, uint8_t count) {
+    size_t stride = SESSION_ARCHIVE_ENTRY_BYTES(channels);
+    size_t body = 12 + SESSION_ARCHIVE_MAX * stride;
+    memset(buf, 0, body + 4);
+
+    uint32_t magic = SESSION_ARCHIVE_MAGIC, nextId = count + 1;
+    memcpy(buf, &magic, 4);
+    buf[4] = version;
+    buf[5] = count;
+    buf[6] = version >= 2 ? channels : 0;
+    memcpy(buf + 8, &nextId, 4);
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t* p = buf + 12 + i * stride;
+        uint32_t fields[5] = { (uint32_t)i + 1, 1000u * (i + 1), 3600, 720, 4096 };
+        memcpy(p, fields, sizeof(fields));
+        for (uint8_t c = 0; c < channels; c++) {
+            int16_t peak = (int16_t)(2000 + 10 * c);
+            memcpy(p + 20 + 2 * c, &peak, 2);
+        }
+        p[20 + 2 * channels] = 2;   // segments
+    }
+    uint32_t crc = sessionCrc32(buf, body);
+    memcpy(buf + body, &crc, 4);
+    return body + 4;
+}
+
+// --------------------------------------------------------------------------
+// Add / rotate
+// --------------------------------------------------------------------------
+
+void test_starts_empty(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, idx->count());
+    TEST_ASSERT_EQUAL_UINT32(1, idx->nextId());
+    TEST_ASSERT_EQUAL_UINT32(0, idx->totalBytes());
+    TEST_ASSERT_NULL(idx->find(1));
+}
+
+void test_add_assigns_increasing_ids(void) {
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    TEST_ASSERT_EQUAL_UINT8(0, idx->add(makeEntry(1000, 100), evicted, SESSION_ARCHIVE_MAX));
+    TEST_ASSERT_EQUAL_UINT8(0, idx->add(makeEntry(2000, 200), evicted, SESSION_ARCHIVE_MAX));
+
+    TEST_ASSERT_EQUAL_UINT8(2, idx->count());
+    TEST_ASSERT_EQUAL_UINT32(1, idx->entry(0).id);
+    TEST_ASSERT_EQUAL_UINT32(2, idx->entry(1).id);
+    TEST_ASSERT_EQUAL_UINT32(2000, idx->find(2)->startTime);
+    TEST_ASSERT_EQUAL_UINT32(300, idx->totalBytes());
+    TEST_ASSERT_EQUAL_UINT32(3, idx->nextId());
+}
+
+void test_rotates_oldest_past_max_count(void) {
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    for (uint32_t i = 0; i < SESSION_ARCHIVE_MAX; i++) {
+        TEST_ASSERT_EQUAL_UINT8(0, idx->add(makeEntry(i, 1000), evicted, SESSION_ARCHIVE_MAX));
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(1, idx->add(makeEntry(999, 1000), evicted, SESSION_ARCHIVE_MAX));
+    TEST_ASSERT_EQUAL_UINT32(1, evicted[0]);
+    TEST_ASSERT_EQUAL_UINT8(SESSION_ARCHIVE_MAX, idx->count());
+    TEST_ASSERT_EQUAL_UINT32(2, idx->entry(0).id);
+    TEST_ASSERT_EQUAL_UINT32(999, idx->entry(SESSION_ARCHIVE_MAX - 1).startTime);
+    TEST_ASSERT_NULL(idx->find(1));
+}
+
+void test_rotates_by_byte_budget(void) {
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    uint32_t third = SESSION_ARCHIVE_BUDGET / 3;
+    idx->add(makeEntry(1, third), evicted, SESSION_ARCHIVE_MAX);
+    idx->add(makeEntry(2, third), evicted, SESSION_ARCHIVE_MAX);
+    idx->add(makeEntry(3, third), evicted, SESSION_ARCHIVE_MAX);
+
+    // Needs the space of two old cooks
+    TEST_ASSERT_EQUAL_UINT8(2, idx->add(makeEntry(4, third + third / 2), evicted, SESSION_ARCHIVE_MAX));
+    TEST_ASSERT_EQUAL_UINT32(1, evicted[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, evicted[1]);
+    TEST_ASSERT_EQUAL_UINT8(2, idx->count());
+    TEST_ASSERT_TRUE(idx->totalBytes() <= SESSION_ARCHIVE_BUDGET);
+}
+
+void test_oversized_cook_is_still_kept(void) {
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    idx->add(makeEntry(1, 1000), evicted, SESSION_ARCHIVE_MAX);
+    TEST_ASSERT_EQUAL_UINT8(1, idx->add(makeEntry(2, SESSION_ARCHIVE_BUDGET + 1), evicted,
+                                        SESSION_ARCHIVE_MAX));
+    TEST_ASSERT_EQUAL_UINT8(1, idx->count());
+    TEST_ASSERT_EQUAL_UINT32(2, idx->entry(0).startTime);
+}
+
+// --------------------------------------------------------------------------
+// Index file image
+// --------------------------------------------------------------------------
+
+void test_image_round_trip(void) {
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    idx->add(makeEntry(1000, 100), evicted, SESSION_ARCHIVE_MAX);
+    idx->add(makeEntry(2000, 200), evicted, SESSION_ARCHIVE_MAX);
+
+    static uint8_t image[2048];
+    size_t len = idx->serialize(image, sizeof(image));
+    TEST_ASSERT_EQUAL_UINT32(SessionArchiveIndex::imageSize(), len);
+
+    SessionArchiveIndex back;
+    TEST_ASSERT_TRUE(back.deserialize(image, len));
+    TEST_ASSERT_EQUAL_UINT8(2, back.count());
+    TEST_ASSERT_EQUAL_UINT32(3, back.nextId());
+    TEST_ASSERT_EQUAL_UINT32(2000, back.entry(1).startTime);
+    TEST_ASSERT_EQUAL_INT16(2750, back.entry(1).peak[0]);
+    TEST_ASSERT_EQUAL_INT16(SESSION_PEAK_NONE, back.entry(1).peak[2]);
+    for (uint8_t c = 3; c < NUM_PROBES; c++) {
+        TEST_ASSERT_EQUAL_INT16(1000 + c, back.entry(1).peak[c]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, back.entry(1).segments);
+}
+
+void test_image_reads_version1(void) {
+    // Peaks for pit, meat1 and meat2 only; further channels never reported
+    static uint8_t image[SESSION_ARCHIVE_IMAGE_MAX];
+    size_t len = buildImage(image, 1, 3, 2);
+
+    SessionArchiveIndex back;
+    TEST_ASSERT_TRUE(back.deserialize(image, len));
+    TEST_ASSERT_EQUAL_UINT8(2, back.count());
+    TEST_ASSERT_EQUAL_UINT32(3, back.nextId());
+    TEST_ASSERT_EQUAL_UINT32(2000, back.entry(1).startTime);
+    TEST_ASSERT_EQUAL_UINT32(4096, back.entry(1).bytes);
+    TEST_ASSERT_EQUAL_INT16(2000, back.entry(1).peak[0]);
+    TEST_ASSERT_EQUAL_INT16(2020, back.entry(1).peak[2]);
+    for (uint8_t c = 3; c < NUM_PROBES; c++) {
+        TEST_ASSERT_EQUAL_INT16(SESSION_PEAK_NONE, back.entry(1).peak[c]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(2, back.entry(1).segments);
+}
+
+void test_image_reads_other_channel_count(void) {
+    // An index from an eight-channel build keeps the peaks this one has
+    static uint8_t image[SESSION_ARCHIVE_IMAGE_MAX];
+    size_t len = buildImage(image, SESSION_ARCHIVE_VERSION, PROBE_MAX, 1);
+
+    SessionArchiveIndex back;
+    TEST_ASSERT_TRUE(back.deserialize(image, len));
+    TEST_ASSERT_EQUAL_UINT8(1, back.count());
+    for (uint8_t c = 0; c < NUM_PROBES; c++) {
+        TEST_ASSERT_EQUAL_INT16(2000 + 10 * c, back.entry(0).peak[c]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(2, back.entry(0).segments);
+
+    // Cut short of its own length
+    TEST_ASSERT_FALSE(back.deserialize(image, len - 1));
+}
+
+void test_image_rejects_corruption_and_short_reads(void) {
+    uint32_t evicted[SESSION_ARCHIVE_MAX];
+    idx->add(makeEntry(1000, 100), evicted, SESSION_ARCHIVE_MAX);
+
+    static uint8_t image[2048];
+    size_t len = idx->serialize(image, sizeof(image));
+    SessionArchiveIndex back;
+
+    TEST_ASSERT_FALSE(back.deserialize(image, len - 1));
+    image[20] ^= 0x01;
+    TEST_ASSERT_FALSE(back.deserialize(image, len));
+    TEST_ASSERT_EQUAL_UINT8(0, back.count());
+
+    // Buffer too small to serialize into
+    TEST_ASSERT_EQUAL_UINT32(0, idx->serialize(image, 16));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_starts_empty);
+    RUN_TEST(test_add_assigns_increasing_ids);
+    RUN_TEST(test_rotates_oldest_past_max_count);
+    RUN_TEST(test_rotates_by_byte_budget);
+    RUN_TEST(test_oversized_cook_is_still_kept);
+    RUN_TEST(test_image_round_trip);
+    RUN_TEST(test_image_rejects_corruption_and_short_reads);
+    RUN_TEST(test_image_reads_version1);
+    RUN_TEST(test_image_reads_other_channel_count);
+
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+/**
+ * test_session_events.cpp
+ *
+ * Tests for the session event journal on the native platform.
+ *
+ * Covers change-only recording, timestamp ordering, capacity, the record
+ * checksum used to stop at a torn write, and the replay cursor that merges
+ * the journal into a point stream.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "session_events.h"
+#include "session_events.cpp"
+#include "session_log.cpp"
+
+static SessionEventJournal* journal;
+
+void setUp(void) {
+    journal = new SessionEventJournal();
+}
+
+void tearDown(void) {
+    delete journal;
+    journal = nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Recording
+// --------------------------------------------------------------------------
+
+void test_starts_empty(void) {
+    TEST_ASSERT_EQUAL_UINT16(0, journal->count());
+    TEST_ASSERT_EQUAL_INT16(SESSION_EVENT_NONE, journal->latest(SessionEventType::SETPOINT));
+}
+
+void test_unchanged_state_is_dropped(void) {
+    TEST_ASSERT_TRUE(journal->record(100, SessionEventType::SETPOINT, 2250));
+    TEST_ASSERT_FALSE(journal->record(105, SessionEventType::SETPOINT, 2250));
+    TEST_ASSERT_TRUE(journal->record(110, SessionEventType::LID, 1));
+    TEST_ASSERT_TRUE(journal->record(115, SessionEventType::SETPOINT, 2750));
+
+    TEST_ASSERT_EQUAL_UINT16(3, journal->count());
+    TEST_ASSERT_EQUAL_INT16(2750, journal->latest(SessionEventType::SETPOINT));
+    TEST_ASSERT_EQUAL_INT16(1, journal->latest(SessionEventType::LID));
+}
+
+void test_alarm_acks_always_recorded(void) {
+    TEST_ASSERT_TRUE(journal->record(100, SessionEventType::ALARM_ACK, 3));
+    TEST_ASSERT_TRUE(journal->record(200, SessionEventType::ALARM_ACK, 3));
+    TEST_ASSERT_EQUAL_UINT16(2, journal->count());
+}
+
+void test_timestamps_never_go_backwards(void) {
+    journal->record(500, SessionEventType::SETPOINT, 2250);
+    journal->record(400, SessionEventType::MEAT1_TARGET, 2030);
+    TEST_ASSERT_EQUAL_UINT32(500, journal->event(1).timestamp);
+}
+
+void test_full_journal_drops_new_events(void) {
+    for (uint16_t i = 0; i < SESSION_EVENT_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(journal->record(i, SessionEventType::ALARM_ACK, 1));
+    }
+    TEST_ASSERT_TRUE(journal->full());
+    TEST_ASSERT_FALSE(journal->record(9999, SessionEventType::SETPOINT, 2250));
+    TEST_ASSERT_EQUAL_UINT16(SESSION_EVENT_CAPACITY, journal->count());
+}
+
+// --------------------------------------------------------------------------
+// Persisted records
+// --------------------------------------------------------------------------
+
+void test_load_round_trip(void) {
+    journal->record(100, SessionEventType::SETPOINT, 2250);
+    journal->record(200, SessionEventType::FAN_MODE, 2);
+
+    SessionEvent records[2] = { journal->event(0), journal->event(1) };
+    SessionEventJournal back;
+    TEST_ASSERT_EQUAL_UINT16(2, back.load(records, 2));
+    TEST_ASSERT_EQUAL_INT16(2250, back.latest(SessionEventType::SETPOINT));
+    TEST_ASSERT_EQUAL_INT16(2, back.latest(SessionEventType::FAN_MODE));
+
+    // Unchanged values stay deduplicated after a reload
+    TEST_ASSERT_FALSE(back.record(300, SessionEventType::SETPOINT, 2250));
+}
+
+void test_load_stops_at_torn_record(void) {
+    journal->record(100, SessionEventType::SETPOINT, 2250);
+    journal->record(200, SessionEventType::SETPOINT, 2500);
+    journal->record(300, SessionEventType::SETPOINT, 2750);
+
+    SessionEvent records[3] = { journal->event(0), journal->event(1), journal->event(2) };
+    records[1].value ^= 0x10;
+
+    SessionEventJournal back;
+    TEST_ASSERT_EQUAL_UINT16(1, back.load(records, 3));
+    TEST_ASSERT_EQUAL_INT16(2250, back.latest(SessionEventType::SETPOINT));
+
+    // Erased flash is never a valid record
+    SessionEvent erased;
+    memset(&erased, 0xFF, sizeof(erased));
+    TEST_ASSERT_FALSE(SessionEventJournal::isValid(erased));
+}
+
+// --------------------------------------------------------------------------
+// Replay merge
+// --------------------------------------------------------------------------
+
+void test_cursor_follows_point_timestamps(void) {
+    journal->record(100, SessionEventType::SETPOINT, 2250);
+    journal->record(160, SessionEventType::SETPOINT, 2750);
+    journal->record(170, SessionEventType::LID, 1);
+
+    SessionEventCursor c;
+    sessionEventsBegin(c);
+
+    sessionEventsSeek(*journal, c, 95);
+    TEST_ASSERT_EQUAL_INT16(SESSION_EVENT_NONE, c.value[(uint8_t)SessionEventType::SETPOINT]);
+
+    sessionEventsSeek(*journal, c, 100);
+    TEST_ASSERT_EQUAL_INT16(2250, c.value[(uint8_t)SessionEventType::SETPOINT]);
+
+    sessionEventsSeek(*journal, c, 155);
+    TEST_ASSERT_EQUAL_INT16(2250, c.value[(uint8_t)SessionEventType::SETPOINT]);
+
+    sessionEventsSeek(*journal, c, 400);
+    TEST_ASSERT_EQUAL_INT16(2750, c.value[(uint8_t)SessionEventType::SETPOINT]);
+    TEST_ASSERT_EQUAL_INT16(1, c.value[(uint8_t)SessionEventType::LID]);
+    TEST_ASSERT_EQUAL_UINT16(3, c.next);
+}
+
+void test_fan_mode_names(void) {
+    TEST_ASSERT_EQUAL_INT16(0, sessionFanModeIndex("fan_only"));
+    TEST_ASSERT_EQUAL_INT16(2, sessionFanModeIndex("damper_primary"));
+    TEST_ASSERT_EQUAL_INT16(-1, sessionFanModeIndex("turbo"));
+    TEST_ASSERT_EQUAL_STRING("fan_and_damper", sessionFanModeName(1));
+    TEST_ASSERT_NULL(sessionFanModeName(3));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_starts_empty);
+    RUN_TEST(test_unchanged_state_is_dropped);
+    RUN_TEST(test_alarm_acks_always_recorded);
+    RUN_TEST(test_timestamps_never_go_backwards);
+    RUN_TEST(test_full_journal_drops_new_events);
+    RUN_TEST(test_load_round_trip);
+    RUN_TEST(test_load_stops_at_torn_record);
+    RUN_TEST(test_cursor_follows_point_timestamps);
+    RUN_TEST(test_fan_mode_names);
+
+    return UNITY_END();
+}
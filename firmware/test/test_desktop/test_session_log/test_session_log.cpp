@@ -0,0 +1,500 @@
+/**
+ * test_session_log.cpp
+ *
+ * Tests for the session log block framing on the native platform.
+ *
+ * The log is exercised against an in-memory "flash" of whole blocks, which
+ * stands in for the LittleFS segment files CookSession reads on device:
+ *   - CRC-32 and block encode/decode
+ *   - Packed keyframe + delta records, and reading version 0 raw blocks
+ *   - Version 1 and 2 blocks, and blocks with another probe channel count
+ *   - Rejection of torn, corrupt and erased blocks
+ *   - Recovery scan stopping at the last intact, contiguous block
+ *   - Locating the block that holds a point index
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "session_log.h"
+#include "session_log.cpp"
+
+// --------------------------------------------------------------------------
+// In-memory flash
+// --------------------------------------------------------------------------
+
+#define FLASH_BLOCKS 32
+
+alignas(4) static uint8_t flash[FLASH_BLOCKS][SESSION_BLOCK_BYTES];
+static uint32_t flashBlocks;    // Blocks written so far
+static uint32_t readCount;
+
+static bool readFlash(uint32_t block, uint8_t* out, void* ctx) {
+    (void)ctx;
+    if (block >= flashBlocks) return false;
+    memcpy(out, flash[block], SESSION_BLOCK_BYTES);
+    readCount++;
+    return true;
+}
+
+static DataPoint makePoint(uint32_t index) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = 1700000000 + index * 5;
+    dp.temp[PROBE_PIT]   = (int16_t)(2250 + index % 7);
+    dp.temp[PROBE_MEAT1] = (int16_t)(1000 + index);
+    dp.fanPct    = (uint8_t)(index % 100);
+    return dp;
+}
+
+// Append a block of n consecutive points starting at firstIndex
+static void appendBlock(uint32_t startTime, uint32_t firstIndex, uint16_t n) {
+    SessionBlockWriter w;
+    sessionBlockBegin(w, flash[flashBlocks++], startTime, firstIndex);
+    for (uint16_t i = 0; i < n; i++) {
+        TEST_ASSERT_TRUE(sessionBlockAdd(w, makePoint(firstIndex + i)));
+    }
+    sessionBlockEnd(w);
+}
+
+// Decode every point of a block into out. Returns the count read.
+static uint16_t unpack(const uint8_t* block, DataPoint* out, uint16_t max) {
+    SessionBlockHeader hdr;
+    if (!sessionDecodeBlock(block, hdr)) return 0;
+    SessionBlockPoints it;
+    sessionPointsBegin(it, block, hdr);
+    uint16_t n = 0;
+    while (n < max && sessionPointsNext(it, out[n])) n++;
+    return n;
+}
+
+static void assertSamePoint(const DataPoint& e, const DataPoint& a) {
+    TEST_ASSERT_EQUAL_UINT32(e.timestamp, a.timestamp);
+    for (uint8_t c = 0; c < NUM_PROBES; c++) TEST_ASSERT_EQUAL_INT16(e.temp[c], a.temp[c]);
+    TEST_ASSERT_EQUAL_UINT8(e.fanPct, a.fanPct);
+    TEST_ASSERT_EQUAL_UINT8(e.damperPct, a.damperPct);
+    TEST_ASSERT_EQUAL_UINT8(e.flags, a.flags);
+    TEST_ASSERT_EQUAL_UINT8(e.discExt, a.discExt);
+    TEST_ASSERT_EQUAL_UINT8(e.alarmExt, a.alarmExt);
+}
+
+// Blocks of the given sizes, back to back from index 0. Returns points.
+static uint32_t buildLog(const uint16_t* sizes, uint32_t blocks) {
+    uint32_t idx = 0;
+    for (uint32_t b = 0; b < blocks; b++) {
+        appendBlock(1700000000, idx, sizes[b]);
+        idx += sizes[b];
+    }
+    return idx;
+}
+
+void setUp(void) {
+    memset(flash, 0xFF, sizeof(flash));
+    flashBlocks = 0;
+    readCount = 0;
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Framing
+// --------------------------------------------------------------------------
+
+void test_crc32_check_value(void) {
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, sessionCrc32("123456789", 9));
+    // Running CRC over two halves matches one pass
+    uint32_t part = sessionCrc32("1234", 4);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, sessionCrc32("56789", 5, part));
+}
+
+void test_encode_decode_round_trip(void) {
+    appendBlock(1234, 40, 5);
+
+    SessionBlockHeader hdr;
+    TEST_ASSERT_TRUE(sessionDecodeBlock(flash[0], hdr));
+    TEST_ASSERT_EQUAL_UINT32(1234, hdr.startTime);
+    TEST_ASSERT_EQUAL_UINT32(40, hdr.firstIndex);
+    TEST_ASSERT_EQUAL_UINT16(5, hdr.count);
+    TEST_ASSERT_EQUAL_UINT8(SESSION_LOG_VERSION, hdr.version);
+
+    DataPoint pts[8];
+    TEST_ASSERT_EQUAL_UINT16(5, unpack(flash[0], pts, 8));
+    for (uint16_t i = 0; i < 5; i++) assertSamePoint(makePoint(40 + i), pts[i]);
+
+    // Unused space is left erased
+    TEST_ASSERT_EQUAL_HEX8(0xFF, flash[0][SESSION_BLOCK_BYTES - 1]);
+}
+
+void test_packed_round_trip_with_big_changes(void) {
+    // Disconnects, negative steps, a clock jump back, a long gap, flag flips
+    DataPoint pts[8];
+    memset(pts, 0, sizeof(pts));
+    pts[0].timestamp = 1700000000; pts[0].temp[PROBE_PIT] = 2250; pts[0].temp[PROBE_MEAT1] = 1500;
+    pts[1] = pts[0]; pts[1].timestamp += 5;
+    pts[2] = pts[1]; pts[2].timestamp += 5;   pts[2].temp[PROBE_MEAT1] = 0; pts[2].flags = DP_FLAG_MEAT1_DISC;
+    pts[3] = pts[2]; pts[3].timestamp += 3600; pts[3].temp[PROBE_PIT] = -400; pts[3].fanPct = 100;
+    pts[4] = pts[3]; pts[4].timestamp -= 20;   pts[4].temp[PROBE_PIT] = 32767; pts[4].fanPct = 0;
+    pts[5] = pts[4]; pts[5].timestamp += 5;    pts[5].temp[PROBE_PIT] = -32768; pts[5].damperPct = 255;
+    pts[6] = pts[5]; pts[6].timestamp += 5;    pts[6].flags = 0xFF; pts[6].temp[PROBE_MEAT2] = 2000;
+    pts[7] = pts[6]; pts[7].timestamp += 5;    pts[7].damperPct = 0;
+
+    TEST_ASSERT_EQUAL_UINT16(8, sessionEncodeBlock(flash[0], 1, 0, pts, 8));
+    DataPoint back[8];
+    TEST_ASSERT_EQUAL_UINT16(8, unpack(flash[0], back, 8));
+    for (uint16_t i = 0; i < 8; i++) assertSamePoint(pts[i], back[i]);
+}
+
+void test_alarm_ext_round_trip(void) {
+    // Done alarms past meat2: set in the keyframe, then cleared and raised
+    DataPoint pts[4];
+    for (uint16_t i = 0; i < 4; i++) pts[i] = makePoint(i);
+    pts[0].alarmExt = 0x01;
+    pts[2].alarmExt = 0x1F;
+    pts[3].alarmExt = 0x1F;
+
+    TEST_ASSERT_EQUAL_UINT16(4, sessionEncodeBlock(flash[0], 1, 0, pts, 4));
+    DataPoint back[4];
+    TEST_ASSERT_EQUAL_UINT16(4, unpack(flash[0], back, 4));
+    for (uint16_t i = 0; i < 4; i++) assertSamePoint(pts[i], back[i]);
+}
+
+void test_steady_samples_pack_small(void) {
+    // Steady cook: pit wobbles a tenth or two, meats creep, fan/damper still
+    static DataPoint pts[400];
+    for (uint16_t i = 0; i < 400; i++) {
+        memset(&pts[i], 0, sizeof(DataPoint));
+        pts[i].timestamp = 1700000000 + i * 5;
+        pts[i].temp[PROBE_PIT]   = (int16_t)(2250 + (i % 3) - 1);
+        pts[i].temp[PROBE_MEAT1] = (int16_t)(1200 + i / 4);
+        pts[i].temp[PROBE_MEAT2] = 0;
+        pts[i].fanPct    = 35;
+        pts[i].damperPct = 40;
+        pts[i].flags     = DP_FLAG_MEAT2_DISC;
+    }
+
+    uint16_t n = sessionEncodeBlock(flash[0], 1, 0, pts, 400);
+    // Raw format fits (256 - 20) / 16 = 14 points per block
+    TEST_ASSERT_TRUE(n >= 5 * (SESSION_BLOCK_PAYLOAD / sizeof(DataPoint)));
+
+    DataPoint back[400];
+    TEST_ASSERT_EQUAL_UINT16(n, unpack(flash[0], back, 400));
+    for (uint16_t i = 0; i < n; i++) assertSamePoint(pts[i], back[i]);
+}
+
+void test_writer_stops_when_full(void) {
+    SessionBlockWriter w;
+    sessionBlockBegin(w, flash[0], 1, 0);
+    DataPoint dp = makePoint(0);
+    uint16_t added = 0;
+    // Every field changes every sample: worst-case records
+    while (sessionBlockAdd(w, dp)) {
+        added++;
+        dp.timestamp += 100000;
+        dp.temp[PROBE_PIT]   = (int16_t)(dp.temp[PROBE_PIT] ^ 0x7FFF);
+        dp.temp[PROBE_MEAT1] = (int16_t)(dp.temp[PROBE_MEAT1] ^ 0x7FFF);
+        dp.temp[PROBE_MEAT2] = (int16_t)(dp.temp[PROBE_MEAT2] ^ 0x7FFF);
+        dp.fanPct    = (uint8_t)(dp.fanPct ^ 0xFF);
+        dp.damperPct = (uint8_t)(dp.damperPct ^ 0xFF);
+        dp.flags     = (uint8_t)(dp.flags ^ 0xFF);
+        dp.discExt   = (uint8_t)(dp.discExt ^ 0xFF);
+        dp.alarmExt  = (uint8_t)(dp.alarmExt ^ 0xFF);
+    }
+    TEST_ASSERT_TRUE(w.pos <= SESSION_BLOCK_PAYLOAD);
+    TEST_ASSERT_TRUE(added >= (SESSION_BLOCK_PAYLOAD - SESSION_KEYFRAME_BYTES) / SESSION_RECORD_MAX);
+    sessionBlockEnd(w);
+
+    DataPoint back[64];
+    TEST_ASSERT_EQUAL_UINT16(added, unpack(flash[0], back, 64));
+}
+
+void test_reads_version0_raw_blocks(void) {
+    // Raw layout: header, then count DataPoint structs; CRC over those only
+    DataPoint pts[3] = { makePoint(0), makePoint(1), makePoint(2) };
+    SessionBlockHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SESSION_BLOCK_MAGIC;
+    hdr.startTime = 1700000000;
+    hdr.count = 3;
+    hdr.version = 0;
+    uint32_t crc = sessionCrc32(&hdr, sizeof(hdr));
+    hdr.crc = sessionCrc32(pts, sizeof(pts), crc);
+    memcpy(flash[0], &hdr, sizeof(hdr));
+    memcpy(flash[0] + sizeof(hdr), pts, sizeof(pts));
+
+    DataPoint back[4];
+    TEST_ASSERT_EQUAL_UINT16(3, unpack(flash[0], back, 4));
+    for (uint16_t i = 0; i < 3; i++) assertSamePoint(pts[i], back[i]);
+}
+
+// Seal a hand-built block: header fields, then payload bytes, rest erased
+static void sealBlock(uint8_t* block, uint8_t version, uint8_t channels, uint16_t count,
+                      const uint8_t* payload, size_t len) {
+    memset(block, 0xFF, SESSION_BLOCK_BYTES);
+    SessionBlockHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SESSION_BLOCK_MAGIC;
+    hdr.startTime = 1700000000;
+    hdr.count = count;
+    hdr.version = version;
+    hdr.channels = channels;
+    memcpy(block + sizeof(hdr), payload, len);
+    uint32_t crc = sessionCrc32(&hdr, sizeof(hdr));
+    hdr.crc = sessionCrc32(block + sizeof(hdr), SESSION_BLOCK_PAYLOAD, crc);
+    memcpy(block, &hdr, sizeof(hdr));
+}
+
+void test_reads_version1_blocks(void) {
+    // 13-byte keyframe (pit 225.0, meat1 150.0, meat2 unplugged), then
+    // pit +0.3, then meat1 -1.0 with meat1 unplugging
+    const uint8_t payload[] = {
+        0x00, 0xF1, 0x53, 0x65,  0xCA, 0x08,  0xDC, 0x05,  0x00, 0x00,  30, 40, DP_FLAG_MEAT2_DISC,
+        0x01, 0x06,
+        0x22, 0x13, DP_FLAG_MEAT1_DISC | DP_FLAG_MEAT2_DISC
+    };
+    sealBlock(flash[0], 1, 0, 3, payload, sizeof(payload));
+
+    DataPoint back[4];
+    TEST_ASSERT_EQUAL_UINT16(3, unpack(flash[0], back, 4));
+    TEST_ASSERT_EQUAL_UINT32(1700000000, back[0].timestamp);
+    TEST_ASSERT_EQUAL_INT16(2250, back[0].temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_INT16(1500, back[0].temp[PROBE_MEAT1]);
+    TEST_ASSERT_EQUAL_UINT8(30, back[0].fanPct);
+    TEST_ASSERT_EQUAL_INT16(2253, back[1].temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_UINT32(1700000000 + SESSION_SAMPLE_INTERVAL / 1000, back[1].timestamp);
+    TEST_ASSERT_EQUAL_INT16(1490, back[2].temp[PROBE_MEAT1]);
+    TEST_ASSERT_TRUE(dpDisconnected(back[2], PROBE_MEAT1));
+    TEST_ASSERT_FALSE(dpDisconnected(back[2], PROBE_PIT));
+
+    // A build with more channels sees the ones v1 didn't have as unplugged
+    for (uint8_t c = 3; c < NUM_PROBES; c++) TEST_ASSERT_TRUE(dpDisconnected(back[0], c));
+}
+
+void test_reads_blocks_with_other_channel_counts(void) {
+    // Five channels: keyframe, then pit +0.5 with channel 4 -2.0 and a
+    // discExt change (channel 3 unplugged), then a steady sample
+    const uint8_t payload[] = {
+        0x00, 0xF1, 0x53, 0x65,
+        0xCA, 0x08,  0xDC, 0x05,  0xD0, 0x07,  0x20, 0x03,  0x84, 0x03,
+        30, 40, 0, 0,
+        0x81, 0x02 | 0x80, 0x0A, 0x27, 0x01,
+        0x00
+    };
+    sealBlock(flash[0], 2, 5, 3, payload, sizeof(payload));
+
+    DataPoint back[4];
+    TEST_ASSERT_EQUAL_UINT16(3, unpack(flash[0], back, 4));
+    TEST_ASSERT_EQUAL_INT16(2250, back[0].temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_INT16(2000, back[0].temp[PROBE_MEAT2]);
+    TEST_ASSERT_EQUAL_INT16(2255, back[1].temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_INT16(2255, back[2].temp[PROBE_PIT]);
+    TEST_ASSERT_EQUAL_UINT8(40, back[2].damperPct);
+
+    // Channels the build shares with the block decode; the rest are unplugged
+    const int16_t ch4[3] = { 900, 880, 880 };
+    for (uint8_t c = 3; c < NUM_PROBES; c++) {
+        if (c == 3) {
+            TEST_ASSERT_EQUAL_INT16(800, back[0].temp[3]);
+            TEST_ASSERT_FALSE(dpDisconnected(back[0], 3));
+            TEST_ASSERT_TRUE(dpDisconnected(back[1], 3));
+        } else if (c == 4) {
+            for (uint8_t i = 0; i < 3; i++) TEST_ASSERT_EQUAL_INT16(ch4[i], back[i].temp[4]);
+        } else {
+            TEST_ASSERT_TRUE(dpDisconnected(back[2], c));
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, dpDiscMask(back[2]) >> NUM_PROBES);
+
+    // Version 2 has no alarmExt
+    for (uint8_t i = 0; i < 3; i++) TEST_ASSERT_EQUAL_UINT8(0, back[i].alarmExt);
+}
+
+void test_decode_rejects_unknown_version(void) {
+    appendBlock(1234, 0, 3);
+    SessionBlockHeader hdr;
+    memcpy(&hdr, flash[0], sizeof(hdr));
+    hdr.version = SESSION_LOG_VERSION + 1;
+    hdr.crc = 0;
+    uint32_t crc = sessionCrc32(&hdr, sizeof(hdr));
+    hdr.crc = sessionCrc32(flash[0] + sizeof(hdr), SESSION_BLOCK_PAYLOAD, crc);
+    memcpy(flash[0], &hdr, sizeof(hdr));
+    TEST_ASSERT_FALSE(sessionDecodeBlock(flash[0], hdr));
+}
+
+void test_decode_rejects_corruption(void) {
+    appendBlock(1234, 0, 8);
+    SessionBlockHeader hdr;
+
+    // Flipped bit in a point
+    flash[0][sizeof(SessionBlockHeader) + 3] ^= 0x10;
+    TEST_ASSERT_FALSE(sessionDecodeBlock(flash[0], hdr));
+    flash[0][sizeof(SessionBlockHeader) + 3] ^= 0x10;
+    TEST_ASSERT_TRUE(sessionDecodeBlock(flash[0], hdr));
+
+    // Flipped bit in the header's index
+    flash[0][8] ^= 0x01;
+    TEST_ASSERT_FALSE(sessionDecodeBlock(flash[0], hdr));
+}
+
+void test_decode_rejects_erased_block(void) {
+    SessionBlockHeader hdr;
+    TEST_ASSERT_FALSE(sessionDecodeBlock(flash[5], hdr));
+}
+
+// --------------------------------------------------------------------------
+// Recovery scan
+// --------------------------------------------------------------------------
+
+void test_scan_empty_log(void) {
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(0, scan.blocks);
+    TEST_ASSERT_EQUAL_UINT32(0, scan.points);
+    TEST_ASSERT_FALSE(scan.torn);
+}
+
+void test_scan_counts_partial_blocks(void) {
+    const uint16_t sizes[] = { 12, 12, 40, 3, 12 };
+    uint32_t total = buildLog(sizes, 5);
+
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(5, scan.blocks);
+    TEST_ASSERT_EQUAL_UINT32(total, scan.points);
+    TEST_ASSERT_EQUAL_UINT32(1700000000, scan.startTime);
+    TEST_ASSERT_FALSE(scan.torn);
+}
+
+void test_scan_stops_at_torn_last_block(void) {
+    const uint16_t sizes[] = { 12, 12, 12 };
+    buildLog(sizes, 3);
+
+    // Power cut halfway through writing block 3
+    appendBlock(1700000000, 36, 12);
+    memset(flash[3] + SESSION_BLOCK_BYTES / 4, 0xFF, SESSION_BLOCK_BYTES * 3 / 4);
+
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(3, scan.blocks);
+    TEST_ASSERT_EQUAL_UINT32(36, scan.points);
+    TEST_ASSERT_TRUE(scan.torn);
+}
+
+void test_scan_stops_at_corrupt_middle_block(void) {
+    const uint16_t sizes[] = { 12, 12, 12, 12 };
+    buildLog(sizes, 4);
+    flash[1][sizeof(SessionBlockHeader)] ^= 0xFF;
+
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.blocks);
+    TEST_ASSERT_EQUAL_UINT32(12, scan.points);
+    TEST_ASSERT_TRUE(scan.torn);
+}
+
+void test_scan_rejects_other_session_and_gaps(void) {
+    appendBlock(1700000000, 0, 12);
+    appendBlock(1800000000, 12, 12);   // Different cook
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.blocks);
+
+    setUp();
+    appendBlock(1700000000, 0, 12);
+    appendBlock(1700000000, 20, 12);   // Index gap
+    scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.blocks);
+    TEST_ASSERT_TRUE(scan.torn);
+}
+
+void test_scan_rejects_stale_block_after_rewrite(void) {
+    // Block 1 was torn and rewritten after reboot with later samples; the
+    // old block 2 still lines up on index but predates the rewrite
+    appendBlock(1700000000, 0, 12);
+    DataPoint pts[12];
+    for (uint16_t i = 0; i < 12; i++) {
+        pts[i] = makePoint(12 + i);
+        pts[i].timestamp += 3600;
+    }
+    TEST_ASSERT_EQUAL_UINT16(12, sessionEncodeBlock(flash[flashBlocks++], 1700000000, 12, pts, 12));
+    appendBlock(1700000000, 24, 12);
+
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, FLASH_BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(2, scan.blocks);
+    TEST_ASSERT_EQUAL_UINT32(24, scan.points);
+}
+
+void test_scan_respects_max_blocks(void) {
+    const uint16_t sizes[] = { 12, 12, 12, 12 };
+    buildLog(sizes, 4);
+    SessionLogScan scan = sessionLogScan(readFlash, nullptr, 2);
+    TEST_ASSERT_EQUAL_UINT32(2, scan.blocks);
+    TEST_ASSERT_FALSE(scan.torn);
+}
+
+// --------------------------------------------------------------------------
+// Find
+// --------------------------------------------------------------------------
+
+void test_find_every_index_across_partial_blocks(void) {
+    const uint16_t sizes[] = { 12, 3, 40, 12, 1, 12, 7 };
+    uint32_t total = buildLog(sizes, 7);
+
+    alignas(4) uint8_t block[SESSION_BLOCK_BYTES];
+    for (uint32_t i = 0; i < total; i++) {
+        int32_t b = sessionLogFind(readFlash, nullptr, 7, i, 0, block);
+        TEST_ASSERT_TRUE(b >= 0);
+
+        SessionBlockHeader hdr;
+        TEST_ASSERT_TRUE(sessionDecodeBlock(block, hdr));
+        TEST_ASSERT_TRUE(i >= hdr.firstIndex && i < hdr.firstIndex + hdr.count);
+        DataPoint pts[64];
+        unpack(block, pts, 64);
+        assertSamePoint(makePoint(i), pts[i - hdr.firstIndex]);
+    }
+
+    TEST_ASSERT_EQUAL_INT32(-1, sessionLogFind(readFlash, nullptr, 7, total, 0, block));
+    TEST_ASSERT_EQUAL_INT32(-1, sessionLogFind(readFlash, nullptr, 0, 0, 0, block));
+}
+
+void test_find_uses_hint(void) {
+    const uint16_t sizes[] = { 12, 12, 12, 12, 12, 12, 12, 12 };
+    buildLog(sizes, 8);
+
+    alignas(4) uint8_t block[SESSION_BLOCK_BYTES];
+    readCount = 0;
+    TEST_ASSERT_EQUAL_INT32(5, sessionLogFind(readFlash, nullptr, 8, 61, 5, block));
+    TEST_ASSERT_EQUAL_UINT32(1, readCount);
+
+    // A wrong hint still finds the block
+    TEST_ASSERT_EQUAL_INT32(2, sessionLogFind(readFlash, nullptr, 8, 30, 6, block));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_encode_decode_round_trip);
+    RUN_TEST(test_packed_round_trip_with_big_changes);
+    RUN_TEST(test_alarm_ext_round_trip);
+    RUN_TEST(test_steady_samples_pack_small);
+    RUN_TEST(test_writer_stops_when_full);
+#if NUM_PROBES == 3
+    RUN_TEST(test_reads_version0_raw_blocks);
+#endif
+    RUN_TEST(test_reads_version1_blocks);
+    RUN_TEST(test_reads_blocks_with_other_channel_counts);
+    RUN_TEST(test_decode_rejects_unknown_version);
+    RUN_TEST(test_decode_rejects_corruption);
+    RUN_TEST(test_decode_rejects_erased_block);
+    RUN_TEST(test_scan_empty_log);
+    RUN_TEST(test_scan_counts_partial_blocks);
+    RUN_TEST(test_scan_stops_at_torn_last_block);
+    RUN_TEST(test_scan_stops_at_corrupt_middle_block);
+    RUN_TEST(test_scan_rejects_other_session_and_gaps);
+    RUN_TEST(test_scan_rejects_stale_block_after_rewrite);
+    RUN_TEST(test_scan_respects_max_blocks);
+    RUN_TEST(test_find_every_index_across_partial_blocks);
+    RUN_TEST(test_find_uses_hint);
+
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+/**
+ * test_spsc_queue.cpp
+ *
+ * Tests for the SpscQueue single-producer, single-consumer ring on the
+ * native platform.
+ *
+ * Covers FIFO order, the full and empty edges, wrap-around of the free
+ * running indices, and a two-thread run in which every pushed item must
+ * come out once, in order.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "spsc_queue.h"
+
+struct Item {
+    uint32_t n;
+    uint32_t check;   // ~n, to catch a torn copy
+};
+
+static SpscQueue<Item, 8>* queue;
+
+void setUp(void) {
+    queue = new SpscQueue<Item, 8>();
+}
+
+void tearDown(void) {
+    delete queue;
+    queue = nullptr;
+}
+
+static Item makeItem(uint32_t n) {
+    Item it;
+    it.n = n;
+    it.check = ~n;
+    return it;
+}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+
+void test_empty_queue_pops_nothing(void) {
+    Item it;
+    TEST_ASSERT_FALSE(queue->pop(it));
+}
+
+void test_pops_in_push_order(void) {
+    for (uint32_t i = 1; i <= 3; i++) TEST_ASSERT_TRUE(queue->push(makeItem(i)));
+    Item it;
+    for (uint32_t i = 1; i <= 3; i++) {
+        TEST_ASSERT_TRUE(queue->pop(it));
+        TEST_ASSERT_EQUAL_UINT32(i, it.n);
+    }
+    TEST_ASSERT_FALSE(queue->pop(it));
+}
+
+void test_full_queue_refuses_push(void) {
+    for (uint32_t i = 0; i < 8; i++) TEST_ASSERT_TRUE(queue->push(makeItem(i)));
+    TEST_ASSERT_FALSE(queue->push(makeItem(99)));
+
+    // Draining one makes room for one
+    Item it;
+    TEST_ASSERT_TRUE(queue->pop(it));
+    TEST_ASSERT_EQUAL_UINT32(0, it.n);
+    TEST_ASSERT_TRUE(queue->push(makeItem(8)));
+    TEST_ASSERT_FALSE(queue->push(makeItem(9)));
+}
+
+void test_indices_wrap(void) {
+    // Well past the 16-bit head and tail
+    Item it;
+    for (uint32_t i = 0; i < 70000; i++) {
+        TEST_ASSERT_TRUE(queue->push(makeItem(i)));
+        TEST_ASSERT_TRUE(queue->pop(it));
+        TEST_ASSERT_EQUAL_UINT32(i, it.n);
+    }
+    TEST_ASSERT_FALSE(queue->pop(it));
+}
+
+void test_concurrent_producer_consumer(void) {
+    const uint32_t kItems = 200000;
+    std::thread producer([&]() {
+        for (uint32_t i = 1; i <= kItems; i++) {
+            while (!queue->push(makeItem(i))) std::this_thread::yield();
+        }
+    });
+
+    uint32_t expected = 1, bad = 0;
+    Item it;
+    while (expected <= kItems) {
+        if (!queue->pop(it)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (it.n != expected || it.check != ~it.n) bad++;
+        expected++;
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, bad);
+    TEST_ASSERT_FALSE(queue->pop(it));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_empty_queue_pops_nothing);
+    RUN_TEST(test_pops_in_push_order);
+    RUN_TEST(test_full_queue_refuses_push);
+    RUN_TEST(test_indices_wrap);
+    RUN_TEST(test_concurrent_producer_consumer);
+
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+/**
+ * test_telemetry.cpp
+ *
+ * Tests for the TelemetrySnapshot helpers on the native platform.
+ *
+ * Covers the DataPoint flags and alarm mask derived from a snapshot, the ProbeState
+ * array handed to ErrorManager, the fixed fan-mode buffer, and the
+ * ErrorManager revision counter that tells the control tick when the
+ * snapshot's error list needs re-copying.
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "telemetry.h"
+#include "error_manager.h"
+#include "error_manager.cpp"
+
+static TelemetrySnapshot snap;
+
+void setUp(void) {
+    memset(&snap, 0, sizeof(snap));
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        snap.connected[i] = true;
+        snap.status[i] = ProbeStatus::OK;
+        snap.temp[i] = 100.0f + i;
+    }
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// telemetryFlags
+// --------------------------------------------------------------------------
+
+void test_flags_clear_when_all_ok(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, telemetryFlags(snap));
+}
+
+void test_flags_disconnects_and_lid(void) {
+    snap.connected[PROBE_MEAT2] = false;
+    snap.lidOpen = true;
+    snap.fireOut = true;
+    uint8_t f = telemetryFlags(snap);
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_MEAT2_DISC | DP_FLAG_LID_OPEN | DP_FLAG_ERROR_FIREOUT, f);
+}
+
+void test_flags_alarms(void) {
+    snap.alarms[0] = AlarmType::PIT_LOW;
+    snap.alarms[1] = AlarmType::MEAT1_DONE;
+    snap.alarmCount = 2;
+    uint8_t f = telemetryFlags(snap);
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_ALARM_PIT | DP_FLAG_ALARM_MEAT1, f);
+}
+
+void test_alarm_mask_by_channel(void) {
+    snap.alarms[0] = AlarmType::PIT_HIGH;
+    snap.alarms[1] = AlarmType::MEAT2_DONE;
+    snap.alarmCount = 2;
+    TEST_ASSERT_EQUAL_UINT16((1u << PROBE_PIT) | (1u << PROBE_MEAT2), telemetryAlarmMask(snap));
+
+    // Every meat channel's done alarm has its bit, past meat2 as well
+    for (uint8_t m = 0; m < NUM_MEATS; m++) {
+        snap.alarms[0] = alarmMeatDone(m);
+        snap.alarmCount = 1;
+        TEST_ASSERT_EQUAL_UINT16(1u << (m + 1), telemetryAlarmMask(snap));
+    }
+}
+
+void test_flags_ignore_alarms_past_count(void) {
+    snap.alarms[0] = AlarmType::MEAT2_DONE;
+    snap.alarmCount = 0;
+    TEST_ASSERT_EQUAL_UINT8(0, telemetryFlags(snap));
+}
+
+// --------------------------------------------------------------------------
+// telemetryProbeStates / telemetrySetFanMode
+// --------------------------------------------------------------------------
+
+void test_probe_states_follow_status(void) {
+    snap.connected[PROBE_MEAT1] = false;
+    snap.status[PROBE_MEAT1] = ProbeStatus::OPEN_CIRCUIT;
+    snap.status[PROBE_MEAT2] = ProbeStatus::SHORT_CIRCUIT;
+
+    ProbeState ps[NUM_PROBES];
+    telemetryProbeStates(snap, ps);
+
+    TEST_ASSERT_TRUE(ps[PROBE_PIT].connected);
+    TEST_ASSERT_FALSE(ps[PROBE_PIT].openCircuit);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, ps[PROBE_PIT].temperature);
+    TEST_ASSERT_FALSE(ps[PROBE_MEAT1].connected);
+    TEST_ASSERT_TRUE(ps[PROBE_MEAT1].openCircuit);
+    TEST_ASSERT_TRUE(ps[PROBE_MEAT2].shortCircuit);
+}
+
+void test_fan_mode_copied_and_terminated(void) {
+    telemetrySetFanMode(snap, "damper_primary");
+    TEST_ASSERT_EQUAL_STRING("damper_primary", snap.fanMode);
+
+    telemetrySetFanMode(snap, "a_mode_name_longer_than_the_buffer");
+    TEST_ASSERT_EQUAL_INT(sizeof(snap.fanMode) - 1, strlen(snap.fanMode));
+
+    telemetrySetFanMode(snap, nullptr);
+    TEST_ASSERT_EQUAL_STRING("fan_and_damper", snap.fanMode);
+}
+
+// --------------------------------------------------------------------------
+// ErrorManager revision
+// --------------------------------------------------------------------------
+
+void test_error_revision_moves_only_on_change(void) {
+    ErrorManager em;
+    ProbeState ps[NUM_PROBES];
+    telemetryProbeStates(snap, ps);
+
+    em.update(ps);
+    uint32_t rev = em.getRevision();
+
+    // Same inputs: no add or remove, revision unchanged
+    em.update(ps);
+    TEST_ASSERT_EQUAL_UINT32(rev, em.getRevision());
+
+    snap.status[PROBE_MEAT1] = ProbeStatus::OPEN_CIRCUIT;
+    telemetryProbeStates(snap, ps);
+    em.update(ps);
+    TEST_ASSERT_TRUE(em.getRevision() != rev);
+    rev = em.getRevision();
+
+    em.update(ps);
+    TEST_ASSERT_EQUAL_UINT32(rev, em.getRevision());
+
+    em.clearAll();
+    TEST_ASSERT_TRUE(em.getRevision() != rev);
+}
+
+void test_snapshot_round_trips_through_channel(void) {
+    TelemetryChannel channel;
+    snap.setpoint = 250.0f;
+    snap.errorCount = 1;
+    strcpy(snap.errors[0].message, "Meat 1 probe disconnected");
+    channel.write(snap);
+
+    TelemetrySnapshot out = channel.read();
+    TEST_ASSERT_EQUAL_UINT32(1, channel.version());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 250.0f, out.setpoint);
+    TEST_ASSERT_EQUAL_STRING("Meat 1 probe disconnected", out.errors[0].message);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_flags_clear_when_all_ok);
+    RUN_TEST(test_flags_disconnects_and_lid);
+    RUN_TEST(test_flags_alarms);
+    RUN_TEST(test_alarm_mask_by_channel);
+    RUN_TEST(test_flags_ignore_alarms_past_count);
+    RUN_TEST(test_probe_states_follow_status);
+    RUN_TEST(test_fan_mode_copied_and_terminated);
+    RUN_TEST(test_error_revision_moves_only_on_change);
+    RUN_TEST(test_snapshot_round_trips_through_channel);
+
+    return UNITY_END();
+}
@@ -0,0 +1,330 @@
+/**
+ * test_temp_manager.cpp
+ *
+ * Tests for TempManager's per-sample processing on the native platform.
+ * Raw ADC readings are fed through injectRawADC(), which exercises the same
+ * path the non-blocking ADS1115 pipeline uses when a conversion completes.
+ *
+ * Tests cover:
+ *   - Open / short circuit detection
+ *   - ADC -> resistance -> Steinhart-Hart conversion and calibration offset
+ *   - EMA seeding, smoothing, and reset after a fault
+ *   - Oversample ring with median / trimmed-mean spike rejection
+ *   - Lookup-table conversion accuracy and rebuild on coefficient change
+ *   - Sample timestamps for latency tracing
+ *   - Per-probe independence
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+// Include the actual module under test
+#include "temp_manager.h"
+#include "temp_manager.cpp"
+#include "metrics.cpp"
+
+// Raw reading with the thermistor equal to the reference resistor
+static const int16_t RAW_MIDSCALE = ADC_MAX_VALUE / 2;
+
+// Higher raw value = lower thermistor resistance = hotter
+static const int16_t RAW_HOT = RAW_MIDSCALE + RAW_MIDSCALE / 2;
+
+// --------------------------------------------------------------------------
+// setUp / tearDown
+// --------------------------------------------------------------------------
+
+static TempManager* tm;
+
+void setUp(void) {
+    tm = new TempManager();
+    tm->begin();
+    tm->setUseFahrenheit(false);
+}
+
+void tearDown(void) {
+    delete tm;
+    tm = nullptr;
+}
+
+// --------------------------------------------------------------------------
+// Tests: Probe status
+// --------------------------------------------------------------------------
+
+void test_open_circuit_detected(void) {
+    tm->injectRawADC(PROBE_PIT, ERROR_PROBE_OPEN_THRESHOLD);
+    TEST_ASSERT_EQUAL(ProbeStatus::OPEN_CIRCUIT, tm->getStatus(PROBE_PIT));
+    TEST_ASSERT_FALSE(tm->isConnected(PROBE_PIT));
+    TEST_ASSERT_EQUAL_INT16(ERROR_PROBE_OPEN_THRESHOLD, tm->getRawADC(PROBE_PIT));
+}
+
+void test_short_circuit_detected(void) {
+    tm->injectRawADC(PROBE_MEAT1, ERROR_PROBE_SHORT_THRESHOLD);
+    TEST_ASSERT_EQUAL(ProbeStatus::SHORT_CIRCUIT, tm->getStatus(PROBE_MEAT1));
+    TEST_ASSERT_FALSE(tm->isConnected(PROBE_MEAT1));
+}
+
+void test_valid_reading_is_ok(void) {
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+    TEST_ASSERT_EQUAL(ProbeStatus::OK, tm->getStatus(PROBE_PIT));
+    TEST_ASSERT_TRUE(tm->isConnected(PROBE_PIT));
+}
+
+void test_out_of_range_probe_ignored(void) {
+    tm->injectRawADC(NUM_PROBES, RAW_MIDSCALE);
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        TEST_ASSERT_EQUAL_INT16(0, tm->getRawADC(i));
+    }
+}
+
+// --------------------------------------------------------------------------
+// Tests: Conversion and filtering
+// --------------------------------------------------------------------------
+
+void test_midscale_matches_steinhart_hart(void) {
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+
+    float r = REFERENCE_RESISTANCE * ((float)ADC_MAX_VALUE / (float)RAW_MIDSCALE - 1.0f);
+    float lnR = logf(r);
+    float expectedC = 1.0f / (THERM_A + THERM_B * lnR + THERM_C * lnR * lnR * lnR) - 273.15f;
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, expectedC, tm->getTempC(PROBE_PIT));
+}
+
+void test_first_reading_seeds_ema(void) {
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+    float seeded = tm->getTempC(PROBE_PIT);
+
+    // A repeat of the same reading must not move the filtered value
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, seeded, tm->getTempC(PROBE_PIT));
+}
+
+void test_ema_smooths_step(void) {
+    tm->setEMAAlpha(0.5f);
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+    float before = tm->getTempC(PROBE_PIT);
+
+    TempManager ref;
+    ref.injectRawADC(PROBE_PIT, RAW_HOT);
+    float target = ref.getTempC(PROBE_PIT);
+
+    tm->injectRawADC(PROBE_PIT, RAW_HOT);
+    float after = tm->getTempC(PROBE_PIT);
+
+    TEST_ASSERT_TRUE(target > before);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (before + target) / 2.0f, after);
+}
+
+void test_fault_resets_ema(void) {
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+    tm->injectRawADC(PROBE_PIT, ERROR_PROBE_OPEN_THRESHOLD);
+
+    // On reconnect the first reading should be taken as-is, not blended
+    TempManager ref;
+    ref.injectRawADC(PROBE_PIT, RAW_HOT);
+
+    tm->injectRawADC(PROBE_PIT, RAW_HOT);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, ref.getTempC(PROBE_PIT), tm->getTempC(PROBE_PIT));
+}
+
+void test_offset_applied(void) {
+    tm->injectRawADC(PROBE_MEAT2, RAW_MIDSCALE);
+    float base = tm->getTempC(PROBE_MEAT2);
+
+    TempManager shifted;
+    shifted.setOffset(PROBE_MEAT2, 3.0f);
+    shifted.injectRawADC(PROBE_MEAT2, RAW_MIDSCALE);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, base + 3.0f, shifted.getTempC(PROBE_MEAT2));
+}
+
+void test_probes_independent(void) {
+    tm->injectRawADC(PROBE_PIT, RAW_MIDSCALE);
+    tm->injectRawADC(PROBE_MEAT1, ERROR_PROBE_OPEN_THRESHOLD);
+
+    TEST_ASSERT_EQUAL(ProbeStatus::OK, tm->getStatus(PROBE_PIT));
+    TEST_ASSERT_EQUAL(ProbeStatus::OPEN_CIRCUIT, tm->getStatus(PROBE_MEAT1));
+    TEST_ASSERT_EQUAL_INT16(0, tm->getRawADC(PROBE_MEAT2));
+}
+
+// --------------------------------------------------------------------------
+// Tests: Oversampling
+// --------------------------------------------------------------------------
+
+void test_reduce_median_odd(void) {
+    int16_t buf[] = {500, 100, 32767, 300, 200};
+    TEST_ASSERT_EQUAL_INT16(300, TempManager::reduceSamples(buf, 5, SampleFilter::MEDIAN));
+}
+
+void test_reduce_median_even(void) {
+    int16_t buf[] = {400, 100, 300, 200};
+    TEST_ASSERT_EQUAL_INT16(250, TempManager::reduceSamples(buf, 4, SampleFilter::MEDIAN));
+}
+
+void test_reduce_trimmed_mean_drops_extremes(void) {
+    int16_t buf[] = {1000, 0, 1010, 30000, 990};
+    // Drops 0 and 30000, averages the rest
+    TEST_ASSERT_EQUAL_INT16(1000, TempManager::reduceSamples(buf, 5, SampleFilter::TRIMMED_MEAN));
+}
+
+void test_reduce_trimmed_mean_small_n_keeps_one(void) {
+    int16_t buf[] = {700, 900};
+    TEST_ASSERT_EQUAL_INT16(800, TempManager::reduceSamples(buf, 2, SampleFilter::TRIMMED_MEAN));
+}
+
+void test_ring_waits_until_full(void) {
+    for (uint8_t i = 0; i < TEMP_AVG_SAMPLES - 1; i++) {
+        tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    }
+    TEST_ASSERT_EQUAL(ProbeStatus::OPEN_CIRCUIT, tm->getStatus(PROBE_PIT));  // Untouched default
+
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    TEST_ASSERT_EQUAL(ProbeStatus::OK, tm->getStatus(PROBE_PIT));
+    TEST_ASSERT_EQUAL_INT16(RAW_MIDSCALE, tm->getRawADC(PROBE_PIT));
+}
+
+void test_median_rejects_open_spike(void) {
+    tm->setOversampling(5, SampleFilter::MEDIAN);
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    tm->injectConversion(PROBE_PIT, 32767);  // Single glitch reads as open
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+
+    TEST_ASSERT_EQUAL(ProbeStatus::OK, tm->getStatus(PROBE_PIT));
+    TEST_ASSERT_EQUAL_INT16(RAW_MIDSCALE, tm->getRawADC(PROBE_PIT));
+}
+
+void test_oversampling_of_one_is_passthrough(void) {
+    tm->setOversampling(1, SampleFilter::MEDIAN);
+    tm->injectConversion(PROBE_MEAT1, RAW_HOT);
+    TEST_ASSERT_EQUAL_INT16(RAW_HOT, tm->getRawADC(PROBE_MEAT1));
+}
+
+void test_set_oversampling_clamps(void) {
+    tm->setOversampling(0, SampleFilter::TRIMMED_MEAN);
+    TEST_ASSERT_EQUAL_UINT8(1, tm->getOversampleCount());
+    tm->setOversampling(200, SampleFilter::TRIMMED_MEAN);
+    TEST_ASSERT_EQUAL_UINT8(TEMP_OVERSAMPLE_MAX, tm->getOversampleCount());
+    TEST_ASSERT_EQUAL(SampleFilter::TRIMMED_MEAN, tm->getSampleFilter());
+}
+
+// --------------------------------------------------------------------------
+// Tests: Lookup table
+// --------------------------------------------------------------------------
+
+void test_lut_enabled_by_default(void) {
+    TEST_ASSERT_EQUAL(TEMP_LUT_ENABLED, tm->getUseLookupTable());
+}
+
+void test_lut_matches_direct_conversion(void) {
+    // Sweep the whole valid range, including off-grid values
+    for (int32_t raw = ERROR_PROBE_SHORT_THRESHOLD + 1; raw < ERROR_PROBE_OPEN_THRESHOLD; raw += 37) {
+        TempManager direct;
+        direct.setUseLookupTable(false);
+        direct.injectRawADC(PROBE_PIT, (int16_t)raw);
+
+        TempManager table;
+        table.setUseLookupTable(true);
+        table.injectRawADC(PROBE_PIT, (int16_t)raw);
+
+        float expected = direct.getTempC(PROBE_PIT);
+        if (expected < -20.0f || expected > 400.0f) continue;  // Outside any real cook
+        TEST_ASSERT_FLOAT_WITHIN(0.1f, expected, table.getTempC(PROBE_PIT));
+    }
+}
+
+void test_lut_rebuilt_on_set_coefficients(void) {
+    // Shift A so every temperature changes noticeably
+    const float newA = THERM_A * 1.05f;
+
+    TempManager direct;
+    direct.setUseLookupTable(false);
+    direct.setCoefficients(PROBE_MEAT1, newA, THERM_B, THERM_C);
+    direct.injectRawADC(PROBE_MEAT1, RAW_HOT);
+
+    tm->setEMAAlpha(1.0f);  // No smoothing, so each reading stands alone
+    tm->injectRawADC(PROBE_MEAT1, RAW_HOT);
+    float before = tm->getTempC(PROBE_MEAT1);
+
+    tm->setCoefficients(PROBE_MEAT1, newA, THERM_B, THERM_C);
+    tm->injectRawADC(PROBE_MEAT1, RAW_HOT);
+    float after = tm->getTempC(PROBE_MEAT1);
+
+    TEST_ASSERT_TRUE(fabsf(after - before) > 1.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, direct.getTempC(PROBE_MEAT1), after);
+}
+
+// --------------------------------------------------------------------------
+// Tests: Sample timestamps
+// --------------------------------------------------------------------------
+
+void test_sample_stamped_when_taken(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, tm->getSampleUs(PROBE_PIT));
+    uint32_t before = (uint32_t)metricsNowUs();
+    tm->injectRawADC(PROBE_PIT, 32767);   // Faults are readings too
+    uint32_t after = (uint32_t)metricsNowUs();
+
+    TEST_ASSERT_TRUE(tm->getSampleUs(PROBE_PIT) - before <= after - before);
+    TEST_ASSERT_EQUAL_UINT32(0, tm->getSampleUs(PROBE_MEAT1));
+    TEST_ASSERT_EQUAL_UINT32(0, tm->getSampleUs(NUM_PROBES));
+}
+
+void test_oversampled_reading_stamped_at_first_conversion(void) {
+    tm->setOversampling(3, SampleFilter::MEDIAN);
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    uint32_t first = (uint32_t)metricsNowUs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+    tm->injectConversion(PROBE_PIT, RAW_MIDSCALE);
+
+    // The reading is as old as the oldest conversion in it
+    TEST_ASSERT_TRUE((int32_t)(first - tm->getSampleUs(PROBE_PIT)) >= 0);
+    TEST_ASSERT_TRUE(first - tm->getSampleUs(PROBE_PIT) < 2000);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Probe status
+    RUN_TEST(test_open_circuit_detected);
+    RUN_TEST(test_short_circuit_detected);
+    RUN_TEST(test_valid_reading_is_ok);
+    RUN_TEST(test_out_of_range_probe_ignored);
+
+    // Conversion and filtering
+    RUN_TEST(test_midscale_matches_steinhart_hart);
+    RUN_TEST(test_first_reading_seeds_ema);
+    RUN_TEST(test_ema_smooths_step);
+    RUN_TEST(test_fault_resets_ema);
+    RUN_TEST(test_offset_applied);
+
+    // Per-probe independence
+    RUN_TEST(test_probes_independent);
+
+    // Oversampling
+    RUN_TEST(test_reduce_median_odd);
+    RUN_TEST(test_reduce_median_even);
+    RUN_TEST(test_reduce_trimmed_mean_drops_extremes);
+    RUN_TEST(test_reduce_trimmed_mean_small_n_keeps_one);
+    RUN_TEST(test_ring_waits_until_full);
+    RUN_TEST(test_median_rejects_open_spike);
+    RUN_TEST(test_oversampling_of_one_is_passthrough);
+    RUN_TEST(test_set_oversampling_clamps);
+
+    // Lookup table
+    RUN_TEST(test_lut_enabled_by_default);
+    RUN_TEST(test_lut_matches_direct_conversion);
+    RUN_TEST(test_lut_rebuilt_on_set_coefficients);
+
+    // Sample timestamps
+    RUN_TEST(test_sample_stamped_when_taken);
+    RUN_TEST(test_oversampled_reading_stamped_at_first_conversion);
+
+    return UNITY_END();
+}
@@ -7,13 +7,15 @@
  *   - Initialization defaults
  *   - Linear regression accuracy with known slopes
  *   - Edge cases (insufficient samples, decreasing temp, no target, etc.)
- *   - Rolling window behavior
+ *   - Rolling window behavior (incremental sums across ring wraps)
  *   - Reset functionality
  *   - Two-probe independence
+ *   - Newton heating model, stall detection, and confidence band
  */
 
 #include <unity.h>
 #include <stdint.h>
+#include <math.h>
 
 // Include the actual module under test
 #include "temp_predictor.h"
@@ -47,16 +49,37 @@ static void feedLinearRise(uint8_t probe, uint32_t startTime, float startTemp,
     }
 }
 
+// --------------------------------------------------------------------------
+// Helper: feed Newton heating T(t) = pit - (pit - start) * e^(-k t)
+// Returns the timestamp of the last sample.
+// --------------------------------------------------------------------------
+static const float NEWTON_PIT = 250.0f;
+static const float NEWTON_K   = 1.0f / 5400.0f;  // 1.5 h time constant
+
+static float newtonTemp(float start, uint32_t t) {
+    return NEWTON_PIT - (NEWTON_PIT - start) * expf(-NEWTON_K * (float)t);
+}
+
+static uint32_t feedNewton(uint8_t probe, uint32_t startTime, float startTemp,
+                           uint16_t numSamples) {
+    uint32_t ts = startTime;
+    for (uint16_t i = 0; i < numSamples; i++) {
+        ts = startTime + i * 5;
+        predictor->addSample(probe, ts, newtonTemp(startTemp, i * 5), NEWTON_PIT);
+    }
+    return ts;
+}
+
 // --------------------------------------------------------------------------
 // Tests: Initialization
 // --------------------------------------------------------------------------
 
 void test_initial_state(void) {
     // After begin(), all predictions should be unavailable
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat2EstTime());
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getMeat1Rate());
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getMeat2Rate());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT2));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getRate(PREDICTOR_MEAT1));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getRate(PREDICTOR_MEAT2));
 }
 
 // --------------------------------------------------------------------------
@@ -70,32 +93,34 @@ void test_linear_rise_prediction(void) {
 
     uint32_t baseTime = 1700000000;
     predictor->setCurrentTime(baseTime + 20 * 5);  // "now" is after all samples
-    predictor->setMeat1Target(200.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 1.0f, 20);
 
     // Rate should be ~12 degrees per minute (1 deg per 5s * 60s/min)
-    float rate = predictor->getMeat1Rate();
+    float rate = predictor->getRate(PREDICTOR_MEAT1);
     TEST_ASSERT_FLOAT_WITHIN(0.5f, 12.0f, rate);
 
     // Est time: current temp = 100 + 19 = 119F, target 200F, delta = 81F
     // At 0.2 deg/sec, time = 81 / 0.2 = 405 seconds
-    uint32_t est = predictor->getMeat1EstTime();
+    uint32_t est = predictor->getEstTime(PREDICTOR_MEAT1);
     TEST_ASSERT_NOT_EQUAL(0, est);
     uint32_t expectedEst = (baseTime + 20 * 5) + 405;
     // Allow 10 seconds tolerance for floating point
     TEST_ASSERT_UINT32_WITHIN(10, expectedEst, est);
+    TEST_ASSERT_UINT32_WITHIN(10, 405, predictor->getSecondsToTarget(PREDICTOR_MEAT1));
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getSecondsToTarget(PREDICTOR_MEAT2));
 }
 
 void test_prediction_with_known_slope(void) {
     // Feed exactly: 0.5 degrees every 5 seconds = 6 degrees/minute
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(250.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 250.0f);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 150.0f, 0.5f, 20);
     predictor->setCurrentTime(baseTime + 19 * 5);
 
-    float rate = predictor->getMeat1Rate();
+    float rate = predictor->getRate(PREDICTOR_MEAT1);
     TEST_ASSERT_FLOAT_WITHIN(0.3f, 6.0f, rate);
 }
 
@@ -105,15 +130,15 @@ void test_prediction_accuracy_slow_rise(void) {
     uint32_t baseTime = 1700000000;
     float degreesPerSample = 0.5f / 60.0f * 5.0f;  // 0.0417 deg per 5s
 
-    predictor->setMeat1Target(203.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 203.0f);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 150.0f, degreesPerSample, 30);
     predictor->setCurrentTime(baseTime + 29 * 5);
 
-    float rate = predictor->getMeat1Rate();
+    float rate = predictor->getRate(PREDICTOR_MEAT1);
     TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.5f, rate);
 
-    uint32_t est = predictor->getMeat1EstTime();
+    uint32_t est = predictor->getEstTime(PREDICTOR_MEAT1);
     TEST_ASSERT_NOT_EQUAL(0, est);
 
     // Current temp ~ 150 + 29 * 0.0417 = ~151.2F, target 203, delta ~51.8
@@ -131,25 +156,25 @@ void test_prediction_accuracy_slow_rise(void) {
 void test_no_prediction_insufficient_samples(void) {
     // Feed only 5 samples (need at least PREDICTOR_MIN_SAMPLES = 12)
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
     predictor->setCurrentTime(baseTime + 4 * 5);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 1.0f, 5);
 
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getMeat1Rate());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getRate(PREDICTOR_MEAT1));
 }
 
 void test_no_prediction_temp_decreasing(void) {
     // Feed decreasing temperatures
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
     predictor->setCurrentTime(baseTime + 19 * 5);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 180.0f, -0.5f, 20);
 
     // Rate should be negative (or zero from the getter)
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
 }
 
 void test_no_prediction_no_target(void) {
@@ -160,29 +185,50 @@ void test_no_prediction_no_target(void) {
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 1.0f, 20);
 
     // Target defaults to 0 (not set)
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
 }
 
 void test_no_prediction_already_at_target(void) {
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
     predictor->setCurrentTime(baseTime + 19 * 5);
 
     // Temperature already at target
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 200.0f, 0.5f, 20);
 
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+}
+
+void test_update_samples_only_connected_channels(void) {
+    uint32_t baseTime = 1700000000;
+    float temps[PREDICTOR_NUM_PROBES];
+    bool connected[PREDICTOR_NUM_PROBES];
+    for (uint8_t i = 0; i < PREDICTOR_NUM_PROBES; i++) {
+        predictor->setTarget(i, 200.0f);
+        connected[i] = (i != PREDICTOR_MEAT1);
+    }
+    for (uint32_t n = 0; n < PREDICTOR_MIN_SAMPLES + 4; n++) {
+        predictor->setCurrentTime(baseTime + n * 5);
+        for (uint8_t i = 0; i < PREDICTOR_NUM_PROBES; i++) temps[i] = 150.0f + n;
+        predictor->update(temps, connected);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+    for (uint8_t i = PREDICTOR_MEAT2; i < PREDICTOR_NUM_PROBES; i++) {
+        TEST_ASSERT_NOT_EQUAL(0, predictor->getEstTime(i));
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 12.0f, predictor->getRate(i));
+    }
 }
 
 void test_no_prediction_probe_disconnected(void) {
     // The update() method skips disconnected probes, so if we only call
     // update with meat1Connected=false, no samples get added
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
     predictor->setCurrentTime(baseTime);
 
     // No samples added for meat1 = no prediction
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
 }
 
 // --------------------------------------------------------------------------
@@ -192,29 +238,45 @@ void test_no_prediction_probe_disconnected(void) {
 void test_window_slides(void) {
     // Fill beyond PREDICTOR_WINDOW_SIZE to test circular buffer wrapping
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(300.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 300.0f);
 
     // Feed 80 samples (window is 60) with a known slope
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 0.5f, 80);
     predictor->setCurrentTime(baseTime + 79 * 5);
 
     // Rate should still reflect the consistent slope
-    float rate = predictor->getMeat1Rate();
+    float rate = predictor->getRate(PREDICTOR_MEAT1);
     TEST_ASSERT_FLOAT_WITHIN(0.3f, 6.0f, rate);  // 0.5 deg/5s = 6 deg/min
 
     // Should have a valid prediction
-    TEST_ASSERT_NOT_EQUAL(0, predictor->getMeat1EstTime());
+    TEST_ASSERT_NOT_EQUAL(0, predictor->getEstTime(PREDICTOR_MEAT1));
+}
+
+void test_running_sums_after_many_wraps(void) {
+    // Twelve hours of samples wraps the ring ~144 times; the incremental
+    // sums must still match the true slope of the current window
+    uint32_t baseTime = 1700000000;
+    uint16_t n = 12 * 720;
+    for (uint16_t i = 0; i < n; i++) {
+        // Alternate slope every 500 samples so stale sums would show up
+        float temp = (i / 500) % 2 ? 150.0f : 100.0f + 0.1f * (i % 500);
+        predictor->addSample(PREDICTOR_MEAT1, baseTime + i * 5, temp);
+    }
+
+    // Finish with a clean window of known slope
+    feedLinearRise(PREDICTOR_MEAT1, baseTime + n * 5, 160.0f, 0.25f, PREDICTOR_WINDOW_SIZE);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 3.0f, predictor->getRate(PREDICTOR_MEAT1));  // 0.25 deg/5s
 }
 
 void test_rate_changes_with_stall(void) {
     // First phase: rising at 1 deg per sample
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(250.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 250.0f);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 140.0f, 1.0f, 30);
 
     predictor->setCurrentTime(baseTime + 29 * 5);
-    float risingRate = predictor->getMeat1Rate();
+    float risingRate = predictor->getRate(PREDICTOR_MEAT1);
     TEST_ASSERT_TRUE(risingRate > 5.0f);  // Should be ~12 deg/min
 
     // Second phase: stall (flat temperature) — enough to fill window
@@ -223,7 +285,7 @@ void test_rate_changes_with_stall(void) {
     }
     predictor->setCurrentTime(baseTime + 99 * 5);
 
-    float stallRate = predictor->getMeat1Rate();
+    float stallRate = predictor->getRate(PREDICTOR_MEAT1);
     // Rate should be near zero during stall (window now filled with flat data)
     TEST_ASSERT_FLOAT_WITHIN(1.0f, 0.0f, stallRate);
 }
@@ -234,30 +296,30 @@ void test_rate_changes_with_stall(void) {
 
 void test_reset_clears_all(void) {
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
-    predictor->setMeat2Target(210.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
+    predictor->setTarget(PREDICTOR_MEAT2, 210.0f);
     predictor->setCurrentTime(baseTime + 19 * 5);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 1.0f, 20);
     feedLinearRise(PREDICTOR_MEAT2, baseTime, 110.0f, 0.8f, 20);
 
     // Verify we have predictions
-    TEST_ASSERT_NOT_EQUAL(0, predictor->getMeat1EstTime());
-    TEST_ASSERT_NOT_EQUAL(0, predictor->getMeat2EstTime());
+    TEST_ASSERT_NOT_EQUAL(0, predictor->getEstTime(PREDICTOR_MEAT1));
+    TEST_ASSERT_NOT_EQUAL(0, predictor->getEstTime(PREDICTOR_MEAT2));
 
     // Reset everything
     predictor->reset();
 
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat2EstTime());
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getMeat1Rate());
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getMeat2Rate());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT2));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getRate(PREDICTOR_MEAT1));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getRate(PREDICTOR_MEAT2));
 }
 
 void test_reset_single_probe(void) {
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
-    predictor->setMeat2Target(210.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
+    predictor->setTarget(PREDICTOR_MEAT2, 210.0f);
     predictor->setCurrentTime(baseTime + 19 * 5);
 
     feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 1.0f, 20);
@@ -267,12 +329,12 @@ void test_reset_single_probe(void) {
     predictor->reset(PREDICTOR_MEAT1);
 
     // Meat1 should be cleared
-    TEST_ASSERT_EQUAL_UINT32(0, predictor->getMeat1EstTime());
-    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getMeat1Rate());
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, predictor->getRate(PREDICTOR_MEAT1));
 
     // Meat2 should still have data
-    TEST_ASSERT_NOT_EQUAL(0, predictor->getMeat2EstTime());
-    TEST_ASSERT_TRUE(predictor->getMeat2Rate() > 0.0f);
+    TEST_ASSERT_NOT_EQUAL(0, predictor->getEstTime(PREDICTOR_MEAT2));
+    TEST_ASSERT_TRUE(predictor->getRate(PREDICTOR_MEAT2) > 0.0f);
 }
 
 // --------------------------------------------------------------------------
@@ -281,8 +343,8 @@ void test_reset_single_probe(void) {
 
 void test_probes_independent(void) {
     uint32_t baseTime = 1700000000;
-    predictor->setMeat1Target(200.0f);
-    predictor->setMeat2Target(185.0f);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
+    predictor->setTarget(PREDICTOR_MEAT2, 185.0f);
     predictor->setCurrentTime(baseTime + 19 * 5);
 
     // Meat1: fast rise (1 deg per sample = 12 deg/min)
@@ -291,16 +353,16 @@ void test_probes_independent(void) {
     // Meat2: slow rise (0.2 deg per sample = 2.4 deg/min)
     feedLinearRise(PREDICTOR_MEAT2, baseTime, 160.0f, 0.2f, 20);
 
-    float rate1 = predictor->getMeat1Rate();
-    float rate2 = predictor->getMeat2Rate();
+    float rate1 = predictor->getRate(PREDICTOR_MEAT1);
+    float rate2 = predictor->getRate(PREDICTOR_MEAT2);
 
     // Rates should be different
     TEST_ASSERT_FLOAT_WITHIN(0.5f, 12.0f, rate1);
     TEST_ASSERT_FLOAT_WITHIN(0.3f, 2.4f, rate2);
 
     // Both should have valid predictions
-    uint32_t est1 = predictor->getMeat1EstTime();
-    uint32_t est2 = predictor->getMeat2EstTime();
+    uint32_t est1 = predictor->getEstTime(PREDICTOR_MEAT1);
+    uint32_t est2 = predictor->getEstTime(PREDICTOR_MEAT2);
     TEST_ASSERT_NOT_EQUAL(0, est1);
     TEST_ASSERT_NOT_EQUAL(0, est2);
 
@@ -310,6 +372,129 @@ void test_probes_independent(void) {
     TEST_ASSERT_TRUE(est1 < est2);
 }
 
+// --------------------------------------------------------------------------
+// Tests: Newton / stall model
+// --------------------------------------------------------------------------
+
+void test_newton_matches_heating_curve(void) {
+    uint32_t baseTime = 1700000000;
+    predictor->setMode(PredictorMode::NEWTON);
+    predictor->setTarget(PREDICTOR_MEAT1, 203.0f);
+
+    uint32_t last = feedNewton(PREDICTOR_MEAT1, baseTime, 40.0f, PREDICTOR_WINDOW_SIZE);
+    predictor->setCurrentTime(last);
+
+    // Analytic arrival: t = ln((P - T0) / (P - target)) / k
+    float tReach = logf((NEWTON_PIT - 40.0f) / (NEWTON_PIT - 203.0f)) / NEWTON_K;
+    uint32_t expected = baseTime + (uint32_t)tReach;
+
+    PredictorEstimate e = predictor->getEstimate(PREDICTOR_MEAT1);
+    TEST_ASSERT_FALSE(e.stalled);
+    TEST_ASSERT_UINT32_WITHIN(120, expected, e.est);
+    TEST_ASSERT_TRUE(e.low <= e.est);
+    TEST_ASSERT_TRUE(e.high >= e.est);
+    TEST_ASSERT_EQUAL_UINT32(e.est, predictor->getEstTime(PREDICTOR_MEAT1));
+}
+
+void test_newton_beats_linear_early(void) {
+    // Early in the cook the curve is steep, so a straight line badly
+    // underestimates the time remaining
+    uint32_t baseTime = 1700000000;
+    predictor->setTarget(PREDICTOR_MEAT1, 203.0f);
+    uint32_t last = feedNewton(PREDICTOR_MEAT1, baseTime, 40.0f, PREDICTOR_WINDOW_SIZE);
+    predictor->setCurrentTime(last);
+
+    float tReach = logf((NEWTON_PIT - 40.0f) / (NEWTON_PIT - 203.0f)) / NEWTON_K;
+    uint32_t truth = baseTime + (uint32_t)tReach;
+
+    uint32_t linear = predictor->getEstTime(PREDICTOR_MEAT1);
+    predictor->setMode(PredictorMode::NEWTON);
+    uint32_t newton = predictor->getEstTime(PREDICTOR_MEAT1);
+
+    TEST_ASSERT_TRUE(linear < truth);
+    TEST_ASSERT_TRUE((truth - linear) > 10 * (uint32_t)abs((int32_t)(truth - newton)));
+}
+
+void test_newton_falls_back_without_pit(void) {
+    // No pit data at all: Newton mode behaves like the linear model
+    uint32_t baseTime = 1700000000;
+    predictor->setMode(PredictorMode::NEWTON);
+    predictor->setTarget(PREDICTOR_MEAT1, 200.0f);
+    feedLinearRise(PREDICTOR_MEAT1, baseTime, 100.0f, 1.0f, 20);
+    predictor->setCurrentTime(baseTime + 20 * 5);
+
+    uint32_t newton = predictor->getEstTime(PREDICTOR_MEAT1);
+    predictor->setMode(PredictorMode::LINEAR);
+    TEST_ASSERT_NOT_EQUAL(0, newton);
+    TEST_ASSERT_EQUAL_UINT32(predictor->getEstTime(PREDICTOR_MEAT1), newton);
+}
+
+void test_stall_detected_and_eta_kept(void) {
+    uint32_t baseTime = 1700000000;
+    predictor->setMode(PredictorMode::NEWTON);
+    predictor->setTarget(PREDICTOR_MEAT1, 203.0f);
+
+    // Heat from 40 up to ~160, then sit flat for an hour
+    uint16_t rise = 915;
+    uint32_t ts = feedNewton(PREDICTOR_MEAT1, baseTime, 40.0f, rise);
+    float plateau = newtonTemp(40.0f, (rise - 1) * 5);
+    TEST_ASSERT_FALSE(predictor->isStalled(PREDICTOR_MEAT1));
+
+    for (uint16_t i = 1; i <= 720; i++) {
+        predictor->addSample(PREDICTOR_MEAT1, ts + i * 5, plateau, NEWTON_PIT);
+    }
+    uint32_t now = ts + 720 * 5;
+    predictor->setCurrentTime(now);
+
+    TEST_ASSERT_TRUE(predictor->isStalled(PREDICTOR_MEAT1));
+
+    // Linear model gives up on a flat line...
+    predictor->setMode(PredictorMode::LINEAR);
+    TEST_ASSERT_EQUAL_UINT32(0, predictor->getEstTime(PREDICTOR_MEAT1));
+
+    // ...the stall-aware model still reports an ETA with a wide band
+    predictor->setMode(PredictorMode::NEWTON);
+    PredictorEstimate e = predictor->getEstimate(PREDICTOR_MEAT1);
+    TEST_ASSERT_TRUE(e.stalled);
+    TEST_ASSERT_NOT_EQUAL(0, e.est);
+
+    float tHeat = logf((NEWTON_PIT - plateau) / (NEWTON_PIT - 203.0f)) / NEWTON_K;
+    TEST_ASSERT_UINT32_WITHIN(600, now + (uint32_t)tHeat, e.low);
+    TEST_ASSERT_TRUE(e.est > e.low);
+    TEST_ASSERT_TRUE(e.high > e.est);
+    TEST_ASSERT_TRUE(e.est - now < PREDICTOR_STALL_TYPICAL_SEC + (uint32_t)tHeat);
+}
+
+void test_stall_clears_when_rise_resumes(void) {
+    uint32_t baseTime = 1700000000;
+    predictor->setMode(PredictorMode::NEWTON);
+    predictor->setTarget(PREDICTOR_MEAT1, 203.0f);
+
+    uint16_t rise = 915;
+    uint32_t ts = feedNewton(PREDICTOR_MEAT1, baseTime, 40.0f, rise);
+    float plateau = newtonTemp(40.0f, (rise - 1) * 5);
+    for (uint16_t i = 1; i <= 360; i++) {
+        predictor->addSample(PREDICTOR_MEAT1, ts + i * 5, plateau, NEWTON_PIT);
+    }
+    TEST_ASSERT_TRUE(predictor->isStalled(PREDICTOR_MEAT1));
+
+    // Resume heating along the same curve from the plateau
+    feedNewton(PREDICTOR_MEAT1, ts + 361 * 5, plateau, PREDICTOR_WINDOW_SIZE * 2);
+    TEST_ASSERT_FALSE(predictor->isStalled(PREDICTOR_MEAT1));
+}
+
+void test_reset_clears_stall(void) {
+    uint32_t baseTime = 1700000000;
+    uint32_t ts = feedNewton(PREDICTOR_MEAT1, baseTime, 40.0f, 915);
+    for (uint16_t i = 1; i <= 360; i++) {
+        predictor->addSample(PREDICTOR_MEAT1, ts + i * 5, 160.0f, NEWTON_PIT);
+    }
+    TEST_ASSERT_TRUE(predictor->isStalled(PREDICTOR_MEAT1));
+
+    predictor->reset(PREDICTOR_MEAT1);
+    TEST_ASSERT_FALSE(predictor->isStalled(PREDICTOR_MEAT1));
+}
+
 // --------------------------------------------------------------------------
 // Main
 // --------------------------------------------------------------------------
@@ -331,9 +516,11 @@ int main(int argc, char** argv) {
     RUN_TEST(test_no_prediction_no_target);
     RUN_TEST(test_no_prediction_already_at_target);
     RUN_TEST(test_no_prediction_probe_disconnected);
+    RUN_TEST(test_update_samples_only_connected_channels);
 
     // Rolling window
     RUN_TEST(test_window_slides);
+    RUN_TEST(test_running_sums_after_many_wraps);
     RUN_TEST(test_rate_changes_with_stall);
 
     // Reset
@@ -343,5 +530,13 @@ int main(int argc, char** argv) {
     // Two-probe independence
     RUN_TEST(test_probes_independent);
 
+    // Newton / stall model
+    RUN_TEST(test_newton_matches_heating_curve);
+    RUN_TEST(test_newton_beats_linear_early);
+    RUN_TEST(test_newton_falls_back_without_pit);
+    RUN_TEST(test_stall_detected_and_eta_kept);
+    RUN_TEST(test_stall_clears_when_rise_resumes);
+    RUN_TEST(test_reset_clears_stall);
+
     return UNITY_END();
 }
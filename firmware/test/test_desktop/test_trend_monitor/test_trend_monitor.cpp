@@ -0,0 +1,263 @@
+/**
+ * test_trend_monitor.cpp
+ *
+ * Tests for TrendMonitor and the rolling fit behind it on the native
+ * platform.
+ *
+ * Tests cover:
+ *   - TrendWindow slope and mean across ring wraps and rebases
+ *   - Fire out: saturated output with a falling pit, within the short window
+ *   - No fire out with output headroom, lid open, or a recovering pit
+ *   - Fuel low from a climbing output at temperature, cleared on refuel
+ *   - Done-soon latching per meat probe
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "trend_monitor.h"
+#include "trend_monitor.cpp"
+
+static TrendMonitor* tm;
+static TrendInput    in;
+static uint32_t      nowMs;
+
+void setUp(void) {
+    tm = new TrendMonitor();
+    in = TrendInput();
+    in.pitTemp      = 225.0f;
+    in.pitConnected = true;
+    in.outputPct    = 40.0f;
+    in.setpoint     = 225.0f;
+    nowMs = 0;
+}
+
+void tearDown(void) {
+    delete tm;
+    tm = nullptr;
+}
+
+// One update per sample period, pit and output moving by the given amounts
+// per minute
+static void run(uint16_t samples, float pitPerMin, float outPerMin) {
+    float perSample = TREND_SAMPLE_MS / 60000.0f;
+    for (uint16_t i = 0; i < samples; i++) {
+        tm->update(nowMs, in);
+        nowMs += TREND_SAMPLE_MS;
+        in.pitTemp   += pitPerMin * perSample;
+        in.outputPct += outPerMin * perSample;
+    }
+}
+
+// --------------------------------------------------------------------------
+// Rolling fit
+// --------------------------------------------------------------------------
+
+void test_window_slope_exact_across_wraps(void) {
+    TrendWindow<8> w;
+    for (uint32_t i = 0; i < 100; i++) {
+        w.push(1700000000UL + i * 10, 300.0f - 0.5f * i);
+    }
+    TEST_ASSERT_TRUE(w.full());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.05f, w.slope());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 300.0f - 0.5f * 95.5f, w.mean());
+    TEST_ASSERT_EQUAL_UINT32(70, w.span());
+}
+
+void test_window_slope_zero_until_two_samples(void) {
+    TrendWindow<4> w;
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, w.slope());
+    w.push(100, 50.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, w.slope());
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, w.mean());
+}
+
+// --------------------------------------------------------------------------
+// Fire out
+// --------------------------------------------------------------------------
+
+void test_fire_out_within_short_window(void) {
+    in.outputPct = 100.0f;
+    run(TREND_MIN_SAMPLES - 1, -3.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+    run(1, -3.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().fireOut);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, -3.0f, tm->getPitSlope());
+}
+
+void test_no_fire_out_with_output_headroom(void) {
+    in.outputPct = 60.0f;
+    run(TREND_LONG_WINDOW, -3.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+}
+
+void test_no_fire_out_on_slow_decline(void) {
+    in.outputPct = 100.0f;
+    run(TREND_LONG_WINDOW, -1.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+}
+
+void test_fire_out_clears_when_pit_recovers(void) {
+    in.outputPct = 100.0f;
+    run(TREND_SHORT_WINDOW, -3.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().fireOut);
+    run(TREND_SHORT_WINDOW, 4.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+}
+
+void test_lid_open_clears_and_restarts_window(void) {
+    in.outputPct = 100.0f;
+    run(TREND_SHORT_WINDOW, -3.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().fireOut);
+
+    in.lidOpen = true;
+    run(3, -20.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+
+    // Needs a fresh window after the lid closes
+    in.lidOpen = false;
+    run(TREND_MIN_SAMPLES - 1, -3.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+    run(1, -3.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().fireOut);
+}
+
+void test_setpoint_change_restarts_window(void) {
+    in.outputPct = 100.0f;
+    run(TREND_MIN_SAMPLES - 1, -3.0f, 0.0f);
+    in.setpoint = 250.0f;
+    run(1, -3.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+}
+
+void test_updates_between_samples_are_ignored(void) {
+    in.outputPct = 100.0f;
+    for (uint16_t i = 0; i < TREND_MIN_SAMPLES * 10; i++) {
+        tm->update(nowMs, in);
+        nowMs += TREND_SAMPLE_MS / 10;
+        in.pitTemp -= 3.0f * TREND_SAMPLE_MS / 600000.0f;
+    }
+    TEST_ASSERT_TRUE(tm->status().fireOut);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, -3.0f, tm->getPitSlope());
+}
+
+// --------------------------------------------------------------------------
+// Fuel low
+// --------------------------------------------------------------------------
+
+void test_fuel_low_from_climbing_output(void) {
+    in.outputPct = 60.0f;
+    run(TREND_LONG_WINDOW - 1, 0.0f, 1.5f);
+    TEST_ASSERT_FALSE(tm->status().fuelLow);
+    run(1, 0.0f, 1.5f);
+    TEST_ASSERT_TRUE(tm->status().fuelLow);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.5f, tm->getOutputSlope());
+
+    // Refuelled: output backs off
+    run(TREND_LONG_WINDOW / 2, 0.0f, -4.0f);
+    TEST_ASSERT_FALSE(tm->status().fuelLow);
+}
+
+void test_no_fuel_low_on_steady_output(void) {
+    in.outputPct = 80.0f;
+    run(TREND_LONG_WINDOW * 2, 0.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().fuelLow);
+}
+
+void test_no_fuel_low_while_climbing_to_setpoint(void) {
+    in.pitTemp = 150.0f;
+    in.outputPct = 60.0f;
+    run(TREND_LONG_WINDOW, 1.0f, 1.5f);
+    TEST_ASSERT_FALSE(tm->status().fuelLow);
+}
+
+// --------------------------------------------------------------------------
+// Done soon
+// --------------------------------------------------------------------------
+
+void test_done_soon_raises_within_lead(void) {
+    in.meatTemp[0] = 190.0f;
+    in.meatTarget[0] = 203.0f;
+    in.meatEtaSec[0] = TREND_DONE_SOON_SEC + 60;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().doneSoon[0]);
+
+    in.meatEtaSec[0] = TREND_DONE_SOON_SEC - 60;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().doneSoon[0]);
+    TEST_ASSERT_FALSE(tm->status().doneSoon[1]);
+
+    // Estimate wobbling just past the lead keeps it up
+    in.meatEtaSec[0] = TREND_DONE_SOON_SEC + 120;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().doneSoon[0]);
+
+    // Reaching target hands over to the done alarm
+    in.meatTemp[0] = 203.0f;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().doneSoon[0]);
+}
+
+void test_done_soon_clears_on_stall_and_target_change(void) {
+    in.meatTemp[1] = 165.0f;
+    in.meatTarget[1] = 203.0f;
+    in.meatEtaSec[1] = 600;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().doneSoon[1]);
+
+    in.meatEtaSec[1] = 3 * TREND_DONE_SOON_SEC;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().doneSoon[1]);
+
+    in.meatEtaSec[1] = 600;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().doneSoon[1]);
+
+    // A new target is judged afresh
+    in.meatTarget[1] = 210.0f;
+    in.meatEtaSec[1] = 2 * TREND_DONE_SOON_SEC;
+    run(1, 0.0f, 0.0f);
+    TEST_ASSERT_FALSE(tm->status().doneSoon[1]);
+}
+
+void test_reset_clears_everything(void) {
+    in.outputPct = 100.0f;
+    in.meatTemp[0] = 190.0f;
+    in.meatTarget[0] = 203.0f;
+    in.meatEtaSec[0] = 300;
+    run(TREND_SHORT_WINDOW, -3.0f, 0.0f);
+    TEST_ASSERT_TRUE(tm->status().fireOut);
+    TEST_ASSERT_TRUE(tm->status().doneSoon[0]);
+
+    tm->reset();
+    TEST_ASSERT_FALSE(tm->status().fireOut);
+    TEST_ASSERT_FALSE(tm->status().doneSoon[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, tm->getPitSlope());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_window_slope_exact_across_wraps);
+    RUN_TEST(test_window_slope_zero_until_two_samples);
+    RUN_TEST(test_fire_out_within_short_window);
+    RUN_TEST(test_no_fire_out_with_output_headroom);
+    RUN_TEST(test_no_fire_out_on_slow_decline);
+    RUN_TEST(test_fire_out_clears_when_pit_recovers);
+    RUN_TEST(test_lid_open_clears_and_restarts_window);
+    RUN_TEST(test_setpoint_change_restarts_window);
+    RUN_TEST(test_updates_between_samples_are_ignored);
+    RUN_TEST(test_fuel_low_from_climbing_output);
+    RUN_TEST(test_no_fuel_low_on_steady_output);
+    RUN_TEST(test_no_fuel_low_while_climbing_to_setpoint);
+    RUN_TEST(test_done_soon_raises_within_lead);
+    RUN_TEST(test_done_soon_clears_on_stall_and_target_change);
+    RUN_TEST(test_reset_clears_everything);
+
+    return UNITY_END();
+}
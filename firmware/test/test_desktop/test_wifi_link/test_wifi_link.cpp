@@ -0,0 +1,189 @@
+/**
+ * test_wifi_link.cpp
+ *
+ * Tests for the WifiLink connection state machine on the native platform.
+ *
+ * WifiManager drives it with the radio's events and carries out the
+ * returned actions; here the events and the clock are supplied directly.
+ * Covers boot failures falling back to AP, the connect timeout, the
+ * exponential backoff and its cap, recovery after a dropped link, and the
+ * user actions (stop, retry, AP).
+ */
+
+#include <unity.h>
+#include <stdint.h>
+
+#include "wifi_link.h"
+#include "wifi_link.cpp"
+
+static WifiLink wl;
+
+void setUp(void) {
+    wifiLinkBegin(wl, 0);
+}
+
+void tearDown(void) {}
+
+// Connect once from boot and return the time it came up
+static uint32_t connectAt(uint32_t t) {
+    wifiLinkStep(wl, t, WifiLinkEvent::GOT_IP);
+    return t;
+}
+
+// Run BACKOFF out: returns the time the retry was issued
+static uint32_t waitOutBackoff(uint32_t t) {
+    uint32_t due = t + wl.backoffMs;
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE, wifiLinkStep(wl, due - 1, WifiLinkEvent::NONE));
+    TEST_ASSERT_EQUAL(WifiLinkAction::CONNECT, wifiLinkStep(wl, due, WifiLinkEvent::NONE));
+    return due;
+}
+
+// --------------------------------------------------------------------------
+// Boot
+// --------------------------------------------------------------------------
+
+void test_begin_is_connecting(void) {
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTING, wl.state);
+    TEST_ASSERT_FALSE(wl.everConnected);
+}
+
+void test_got_ip_connects(void) {
+    connectAt(3000);
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTED, wl.state);
+    TEST_ASSERT_TRUE(wl.everConnected);
+    TEST_ASSERT_EQUAL_UINT8(0, wl.failures);
+}
+
+void test_timeout_counts_as_failure(void) {
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE,
+                      wifiLinkStep(wl, WIFI_CONNECT_TIMEOUT_MS - 1, WifiLinkEvent::NONE));
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTING, wl.state);
+    wifiLinkStep(wl, WIFI_CONNECT_TIMEOUT_MS, WifiLinkEvent::NONE);
+    TEST_ASSERT_EQUAL(WifiLinkState::BACKOFF, wl.state);
+    TEST_ASSERT_EQUAL_UINT8(1, wl.failures);
+}
+
+void test_boot_failures_fall_back_to_ap(void) {
+    uint32_t t = 0;
+    WifiLinkAction a = WifiLinkAction::NONE;
+    for (int i = 0; i < WIFI_BOOT_ATTEMPTS; i++) {
+        t += 1000;
+        a = wifiLinkStep(wl, t, WifiLinkEvent::DISCONNECTED);
+        if (i < WIFI_BOOT_ATTEMPTS - 1) {
+            TEST_ASSERT_EQUAL(WifiLinkAction::NONE, a);
+            t = waitOutBackoff(t);
+        }
+    }
+    TEST_ASSERT_EQUAL(WifiLinkAction::START_AP, a);
+    TEST_ASSERT_EQUAL(WifiLinkState::AP, wl.state);
+}
+
+// --------------------------------------------------------------------------
+// Backoff
+// --------------------------------------------------------------------------
+
+void test_backoff_doubles_and_caps(void) {
+    uint32_t t = connectAt(1000);
+    t += 1000;
+    wifiLinkStep(wl, t, WifiLinkEvent::DISCONNECTED);
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RECONNECT_BASE_MS, wl.backoffMs);
+
+    uint32_t expect = WIFI_RECONNECT_BASE_MS;
+    for (int i = 0; i < 8; i++) {
+        t = waitOutBackoff(t);
+        expect = expect * 2 < WIFI_RECONNECT_MAX_MS ? expect * 2 : WIFI_RECONNECT_MAX_MS;
+        TEST_ASSERT_EQUAL_UINT32(expect, wl.backoffMs);
+        wifiLinkStep(wl, t + 500, WifiLinkEvent::DISCONNECTED);
+        t += 500;
+    }
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RECONNECT_MAX_MS, wl.backoffMs);
+}
+
+void test_lost_link_uses_reconnect_limit(void) {
+    uint32_t t = connectAt(1000);
+    t += 1000;
+    wifiLinkStep(wl, t, WifiLinkEvent::DISCONNECTED);
+    // Well past the boot limit, still retrying
+    for (int i = 0; i < WIFI_RECONNECT_ATTEMPTS - 1; i++) {
+        t = waitOutBackoff(t);
+        TEST_ASSERT_EQUAL(WifiLinkAction::NONE,
+                          wifiLinkStep(wl, t + 100, WifiLinkEvent::DISCONNECTED));
+        t += 100;
+    }
+    TEST_ASSERT_EQUAL(WifiLinkState::BACKOFF, wl.state);
+    t = waitOutBackoff(t);
+    TEST_ASSERT_EQUAL(WifiLinkAction::START_AP,
+                      wifiLinkStep(wl, t + 100, WifiLinkEvent::DISCONNECTED));
+}
+
+void test_reconnect_resets_backoff(void) {
+    uint32_t t = connectAt(1000);
+    wifiLinkStep(wl, t + 1000, WifiLinkEvent::DISCONNECTED);
+    t = waitOutBackoff(t + 1000);
+    wifiLinkStep(wl, t + 100, WifiLinkEvent::GOT_IP);
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTED, wl.state);
+    TEST_ASSERT_EQUAL_UINT8(0, wl.failures);
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RECONNECT_BASE_MS, wl.backoffMs);
+}
+
+// --------------------------------------------------------------------------
+// User actions
+// --------------------------------------------------------------------------
+
+void test_off_ignores_events_and_timers(void) {
+    connectAt(1000);
+    wifiLinkStop(wl, 2000);
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE, wifiLinkStep(wl, 3000, WifiLinkEvent::GOT_IP));
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE, wifiLinkStep(wl, 999999, WifiLinkEvent::NONE));
+    TEST_ASSERT_EQUAL(WifiLinkState::OFF, wl.state);
+}
+
+void test_retry_connects_immediately(void) {
+    wifiLinkStop(wl, 1000);
+    TEST_ASSERT_EQUAL(WifiLinkAction::CONNECT, wifiLinkRetry(wl, 1000));
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTING, wl.state);
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE, wifiLinkRetry(wl, 1001));
+}
+
+void test_ap_connects_via_portal(void) {
+    wifiLinkEnterAP(wl, 1000);
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE, wifiLinkStep(wl, 900000, WifiLinkEvent::DISCONNECTED));
+    TEST_ASSERT_EQUAL(WifiLinkState::AP, wl.state);
+    wifiLinkStep(wl, 900001, WifiLinkEvent::GOT_IP);
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTED, wl.state);
+}
+
+void test_timer_survives_millis_wrap(void) {
+    wifiLinkBegin(wl, 0xFFFFF000u);
+    TEST_ASSERT_EQUAL(WifiLinkAction::NONE, wifiLinkStep(wl, 0x00000100u, WifiLinkEvent::NONE));
+    TEST_ASSERT_EQUAL(WifiLinkState::CONNECTING, wl.state);
+    wifiLinkStep(wl, 0xFFFFF000u + WIFI_CONNECT_TIMEOUT_MS, WifiLinkEvent::NONE);
+    TEST_ASSERT_EQUAL(WifiLinkState::BACKOFF, wl.state);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Boot
+    RUN_TEST(test_begin_is_connecting);
+    RUN_TEST(test_got_ip_connects);
+    RUN_TEST(test_timeout_counts_as_failure);
+    RUN_TEST(test_boot_failures_fall_back_to_ap);
+
+    // Backoff
+    RUN_TEST(test_backoff_doubles_and_caps);
+    RUN_TEST(test_lost_link_uses_reconnect_limit);
+    RUN_TEST(test_reconnect_resets_backoff);
+
+    // User actions
+    RUN_TEST(test_off_ignores_events_and_timers);
+    RUN_TEST(test_retry_connects_immediately);
+    RUN_TEST(test_ap_connects_via_portal);
+    RUN_TEST(test_timer_survives_millis_wrap);
+
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+"""
+PlatformIO extra script that stages the web UI for the LittleFS image.
+
+On buildfs/uploadfs the files in data/ are copied to $BUILD_DIR/data and
+the image is built from there instead:
+
+  - app.js, decoder.js, style.css, favicon.svg and manifest.json are
+    referenced from index.html and sw.js as /name?v=<hash>, so the browser
+    can cache them as immutable and a new build changes the URL
+  - sw.js gets CACHE_VERSION = 'pitclaw-<hash>' over the whole UI, so a
+    new build replaces the offline cache instead of needing a manual bump
+  - text assets are stored gzipped only (name.gz, mtime 0 so the image is
+    reproducible); the server sends them with Content-Encoding: gzip
+  - assets.etag lists "<path> <etag>" per asset for strong ETags and 304s
+
+data/ itself is left untouched, so the simulator keeps serving it as is.
+"""
+import gzip
+import hashlib
+import os
+import re
+import shutil
+
+Import("env")
+
+# Assets that get a ?v=<hash> URL (must not reference each other's URLs)
+VERSIONED = ["app.js", "decoder.js", "style.css", "favicon.svg", "manifest.json"]
+
+# Stored gzipped; everything else is copied as is
+GZIP_EXT = (".html", ".js", ".css", ".json", ".svg")
+
+MANIFEST = "assets.etag"
+
+FS_TARGETS = ("buildfs", "uploadfs", "uploadfsota")
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def stamp_urls(text, hashes):
+    """Replace '/name' and "/name" references with their versioned URL."""
+    for name, h in hashes.items():
+        text = re.sub(r"(['\"])/" + re.escape(name) + r"\1",
+                      lambda m: "%s/%s?v=%s%s" % (m.group(1), name, h, m.group(1)),
+                      text)
+    return text
+
+
+def stage_web_assets(src, dst):
+    if os.path.isdir(dst):
+        shutil.rmtree(dst)
+    os.makedirs(dst)
+
+    files = {}
+    for name in sorted(os.listdir(src)):
+        path = os.path.join(src, name)
+        if os.path.isfile(path):
+            with open(path, "rb") as f:
+                files[name] = f.read()
+
+    hashes = {n: content_hash(files[n]) for n in VERSIONED if n in files}
+
+    for name in ("index.html", "sw.js"):
+        if name in files:
+            files[name] = stamp_urls(files[name].decode("utf-8"), hashes).encode("utf-8")
+
+    if "sw.js" in files:
+        whole = hashlib.sha256()
+        for name in sorted(files):
+            if name != "sw.js":
+                whole.update(files[name])
+        text = files["sw.js"].decode("utf-8")
+        text, n = re.subn(r"CACHE_VERSION = '[^']*'",
+                          "CACHE_VERSION = 'pitclaw-%s'" % whole.hexdigest()[:12], text)
+        if n != 1:
+            print("[web_assets] warning: CACHE_VERSION not found in sw.js")
+        files["sw.js"] = text.encode("utf-8")
+
+    lines = []
+    raw = packed = 0
+    for name in sorted(files):
+        data = files[name]
+        out = name
+        if name.endswith(GZIP_EXT):
+            data = gzip.compress(data, compresslevel=9, mtime=0)
+            out = name + ".gz"
+        with open(os.path.join(dst, out), "wb") as f:
+            f.write(data)
+        lines.append("/%s %s\n" % (name, content_hash(files[name])))
+        raw += len(files[name])
+        packed += len(data)
+
+    with open(os.path.join(dst, MANIFEST), "w") as f:
+        f.writelines(lines)
+
+    print("[web_assets] %d files, %d -> %d bytes" % (len(files), raw, packed))
+
+
+if any(t in FS_TARGETS for t in COMMAND_LINE_TARGETS):
+    staged = os.path.join(env.subst("$BUILD_DIR"), "data")
+    stage_web_assets(env.subst("$PROJECT_DATA_DIR"), staged)
+    env.Replace(PROJECT_DATA_DIR=staged)
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+WebSocket fan-out benchmark for the Pit Claw controller.
+
+Opens viewers against a running device in steps and, after each step has
+settled, samples GET /api/stats for heap and broadcast-pass time:
+
+  python3 scripts/ws_fanout_bench.py 192.168.1.50 --max 12 --step 2
+
+Viewers behave like the web UI (hello with binary frames, then read every
+frame). --json keeps them on JSON frames; --slow makes every other viewer
+stop reading so back-pressure shows up in the skipped column. Standard
+library only.
+"""
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import threading
+import time
+import urllib.request
+
+
+def ws_frame(payload):
+    """Masked client text frame."""
+    data = payload.encode("utf-8")
+    mask = os.urandom(4)
+    header = bytes([0x81])
+    if len(data) < 126:
+        header += bytes([0x80 | len(data)])
+    else:
+        header += bytes([0x80 | 126]) + struct.pack(">H", len(data))
+    return header + mask + bytes(b ^ mask[i % 4] for i, b in enumerate(data))
+
+
+class Viewer(threading.Thread):
+    def __init__(self, host, port, binary, reads):
+        super().__init__(daemon=True)
+        self.host, self.port, self.binary, self.reads = host, port, binary, reads
+        self.bytes = 0
+        self.error = None
+        self.sock = None
+
+    def run(self):
+        try:
+            s = socket.create_connection((self.host, self.port), timeout=10)
+            key = base64.b64encode(os.urandom(16)).decode()
+            s.sendall(("GET /ws HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\n"
+                       "Connection: Upgrade\r\nSec-WebSocket-Key: %s\r\n"
+                       "Sec-WebSocket-Version: 13\r\n\r\n" % (self.host, key)).encode())
+            if b" 101 " not in s.recv(1024):
+                raise RuntimeError("upgrade refused")
+            s.sendall(ws_frame(json.dumps({"type": "hello", "binary": self.binary})))
+            self.sock = s
+            s.settimeout(None)
+            while True:
+                if not self.reads:
+                    time.sleep(1)
+                    continue
+                chunk = s.recv(4096)
+                if not chunk:
+                    break
+                self.bytes += len(chunk)
+        except Exception as e:  # noqa: BLE001 - report and let the run continue
+            self.error = e
+
+    def close(self):
+        if self.sock:
+            try:
+                self.sock.close()
+            except OSError:
+                pass
+
+
+def stats(host, port):
+    with urllib.request.urlopen("http://%s:%d/api/stats" % (host, port), timeout=5) as r:
+        return json.load(r)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--max", type=int, default=12, help="viewers at the last step")
+    ap.add_argument("--step", type=int, default=2)
+    ap.add_argument("--settle", type=float, default=10.0, help="seconds before sampling")
+    ap.add_argument("--samples", type=int, default=5, help="stats samples per step, 1.5 s apart")
+    ap.add_argument("--json", action="store_true", help="viewers stay on JSON frames")
+    ap.add_argument("--slow", action="store_true", help="every other viewer stops reading")
+    args = ap.parse_args()
+
+    viewers = []
+    print("viewers  server  heapFree  minFree  largest  passUs(avg/max)  skipped  rx kB/s")
+    try:
+        base = stats(args.host, args.port)
+        for target in range(args.step, args.max + 1, args.step):
+            while len(viewers) < target:
+                reads = not (args.slow and len(viewers) % 2 == 1)
+                v = Viewer(args.host, args.port, not args.json, reads)
+                v.start()
+                viewers.append(v)
+            time.sleep(args.settle)
+
+            rx0 = sum(v.bytes for v in viewers)
+            t0 = time.time()
+            rows = []
+            for _ in range(args.samples):
+                rows.append(stats(args.host, args.port))
+                time.sleep(1.5)
+            rate = (sum(v.bytes for v in viewers) - rx0) / (time.time() - t0) / 1024
+
+            last = rows[-1]
+            pass_us = [r["ws"]["broadcastUs"] for r in rows]
+            print("%7d  %6d  %8d  %7d  %7d  %7d/%-7d  %7d  %7.1f" % (
+                len(viewers), last["ws"]["clients"],
+                last["heap"]["free"], last["heap"]["minFree"], last["heap"]["largest"],
+                sum(pass_us) // len(pass_us), last["ws"]["broadcastUsMax"],
+                last["ws"]["skipped"] - base["ws"]["skipped"], rate))
+
+            failed = [v for v in viewers if v.error]
+            if failed:
+                print("  %d viewer(s) failed: %s" % (len(failed), failed[0].error))
+    finally:
+        for v in viewers:
+            v.close()
+
+
+if __name__ == "__main__":
+    main()